@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_ASYNCREPLY_H
+#define CXXTOOLS_ASYNCREPLY_H
+
+#include <cxxtools/remoteexception.h>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace cxxtools
+{
+//! @cond internal
+// The state of a call shared by the procedure and the copies of a
+// AsyncReply. It holds the result, so that a reply, which comes late, does
+// not write to a procedure, which serves another call already. The
+// procedure is done, when the handler has returned and the reply is set,
+// whatever comes last.
+class AsyncReplyState
+{
+        AsyncReplyState(const AsyncReplyState&) = delete;
+        AsyncReplyState& operator=(const AsyncReplyState&) = delete;
+
+        std::atomic<unsigned> _pending;
+        std::atomic<bool> _replied;
+        std::function<void()> _done;
+
+    public:
+        explicit AsyncReplyState(const std::function<void()>& done)
+            : _pending(2),
+              _replied(false),
+              _done(done)
+            { }
+
+        std::exception_ptr error;
+
+        // Returns true for the first reply; later replies are ignored.
+        bool beginReply()           { return !_replied.exchange(true); }
+        bool replied() const        { return _replied; }
+
+        void fail(std::exception_ptr e)
+        {
+            if (beginReply())
+            {
+                error = e;
+                release();
+            }
+        }
+
+        void release()
+        {
+            if (--_pending == 0)
+                _done();
+        }
+};
+//! @endcond internal
+
+/**
+ The reply of a procedure registered with ServiceRegistry::registerAsyncFunction
+ or registerAsyncMethod.
+
+ The handler receives it as first parameter and may keep it after returning,
+ so that the result is passed later, possibly from another thread. The
+ server sends the reply, when reply or fail is called. Further calls are
+ ignored. When all copies are destroyed without a reply, the caller gets
+ an error.
+
+ Parameters passed to the handler by reference are valid until the reply is
+ set.
+ */
+template <typename R>
+class AsyncReply
+{
+    public:
+        typedef typename std::remove_cv_t<std::remove_reference_t<R>> value_type;
+
+        //! @cond internal
+        struct State : public AsyncReplyState
+        {
+            explicit State(const std::function<void()>& done)
+                : AsyncReplyState(done),
+                  value()
+                { }
+
+            value_type value;
+        };
+
+        // The copies share a handle to the state, which fails the call,
+        // when the last copy is dropped without a reply.
+        explicit AsyncReply(const std::shared_ptr<State>& state)
+            : _state(state.get(), [state] (State*) {
+                  state->fail(std::make_exception_ptr(std::runtime_error("procedure did not reply")));
+              })
+            { }
+        //! @endcond internal
+
+        /// Sends the result to the caller.
+        void reply(const value_type& value)
+        {
+            if (_state->beginReply())
+            {
+                _state->value = value;
+                _state->release();
+            }
+        }
+
+        void reply(value_type&& value)
+        {
+            if (_state->beginReply())
+            {
+                _state->value = std::move(value);
+                _state->release();
+            }
+        }
+
+        /// Sends the exception to the caller like a exception thrown by a procedure.
+        void fail(std::exception_ptr e)
+        { _state->fail(e); }
+
+        /// Sends a RemoteException with the message and error code to the caller.
+        void fail(const std::string& msg, int rc = 0)
+        { _state->fail(std::make_exception_ptr(RemoteException(msg, rc))); }
+
+        /// Returns true, when reply or fail was called.
+        bool replied() const
+        { return _state->replied(); }
+
+    private:
+        std::shared_ptr<State> _state;
+};
+
+}
+
+#endif // CXXTOOLS_ASYNCREPLY_H
@@ -64,6 +64,11 @@ namespace bin
             /// Initialize the binary deserializer to receive data.
             void begin(bool resetDictionary = true);
 
+            /// Initialize the binary deserializer to pass the data to the
+            /// composer without building a SerializationInfo.
+            void begin(IDirectComposer& composer, bool resetDictionary = true)
+            { _parser.begin(composer, resetDictionary); }
+
             /// Process available characters in input stream buf.
             /// Only characters available in input buffer are processed. No
             /// underflow is triggered.
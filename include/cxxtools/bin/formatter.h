@@ -61,6 +61,9 @@ public:
     void addValueStdString(const std::string& name, const std::string& type,
                           std::string&& value);
 
+    void addValueStdString(const std::string& name, const std::string& type,
+                          const std::string& value);
+
     void addValueChar(const std::string& name, const std::string& type,
                           char value);
 
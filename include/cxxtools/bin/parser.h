@@ -36,6 +36,8 @@
 namespace cxxtools
 {
 
+class IDirectComposer;
+
 namespace bin
 {
 
@@ -89,6 +91,7 @@ class Parser
 
         explicit Parser(std::vector<std::string>* dictionary)
             : _deserializer(0),
+              _direct(0),
               _next(0),
               _dictionary(dictionary)
         { }
@@ -96,6 +99,7 @@ class Parser
     public:
         Parser()
             : _deserializer(0),
+              _direct(0),
               _next(0),
               _dictionary(&_mydictionary)
         { }
@@ -107,10 +111,16 @@ class Parser
 
         void begin(Deserializer& handler, bool resetDictionary = true);
 
+        // Passes the value to the composer without a SerializationInfo.
+        void begin(IDirectComposer& composer, bool resetDictionary = true);
+
         void finish();
 
         void skip();
 
+        // Reads the rest of the running value without passing it on.
+        void discard();
+
         bool advance(std::streambuf& in, bool atLeastOne = false); // returns true, if value is complete
 
     private:
@@ -169,6 +179,7 @@ class Parser
         bool _isNeg;
         unsigned _dictidx;
         Deserializer* _deserializer;
+        IDirectComposer* _direct;
         Parser* _next;
         std::vector<std::string> _mydictionary;
         std::vector<std::string>* _dictionary;
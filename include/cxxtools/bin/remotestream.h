@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CXXTOOLS_BIN_REMOTESTREAM_H
+#define CXXTOOLS_BIN_REMOTESTREAM_H
+
+#include <cxxtools/bin/rpcclient.h>
+#include <cxxtools/remoteprocedure.h>
+#include <cxxtools/composer.h>
+#include <cxxtools/decomposer.h>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+namespace cxxtools
+{
+namespace bin
+{
+
+/** Calls a streaming procedure of a binary rpc server.
+
+    The server sends the elements of the result one by one, while the
+    procedure produces them. They are read with `next` or `forEach`, when
+    the caller asks for them, so that neither side needs to hold the whole
+    result. A slow reader slows down the server.
+
+    The call is synchronous and occupies the connection until the end of the
+    stream is read. Destroying the object or calling `cancel` before drops
+    the connection. A connection, which was multiplexed for concurrent
+    calls, is replaced by a new one, since streams are not sent on
+    multiplexed connections.
+
+    Example:
+    \code
+      cxxtools::bin::RpcClient client("localhost", 7002);
+      cxxtools::bin::RemoteStream<Row, std::string> rows(client, "rows");
+
+      rows.begin("select * from big_table");
+      Row row;
+      while (rows.next(row))
+        process(row);
+    \endcode
+ */
+template <typename T, typename... A>
+class RemoteStream : public IRemoteProcedure
+{
+    public:
+        RemoteStream(RpcClient& client, const String& name)
+            : IRemoteProcedure(client, name),
+              _client(client)
+            { }
+
+        RemoteStream(RpcClient& client, const char* name)
+            : IRemoteProcedure(client, String(name)),
+              _client(client)
+            { }
+
+        /// Sends the request; a running stream of this object is cancelled.
+        void begin(const A&... args)
+        {
+            if (running())
+                cancel();
+
+            beginArgs(std::index_sequence_for<A...>(), args...);
+
+            IDecomposer* argv[sizeof...(A) + 1];
+            initArgv(std::index_sequence_for<A...>(), argv);
+
+            _client.beginStream(*this, argv, sizeof...(A));
+        }
+
+        /** Reads the next element to `value`.
+
+            Returns false at the end of the stream. A error of the procedure
+            is thrown as RemoteException, when the elements before are read.
+         */
+        bool next(T& value)
+        {
+            if (!running())
+                return false;
+
+            _r.begin(value);
+            return _client.readStream(_r);
+        }
+
+        /// Reads all remaining elements and passes them to `fn`; returns their number.
+        template <typename F>
+        std::size_t forEach(F fn)
+        {
+            std::size_t count = 0;
+            T value;
+            while (next(value))
+            {
+                fn(value);
+                ++count;
+            }
+            return count;
+        }
+
+        /// Returns true, while elements are left to read.
+        bool running() const
+            { return _client.activeProcedure() == this; }
+
+        void setFault(int, const std::string&) override
+            { }
+
+        bool failed() const override
+            { return false; }
+
+    protected:
+        void onFinished() override
+            { }
+
+    private:
+        template <std::size_t... I>
+        void beginArgs(std::index_sequence<I...>, const A&... args)
+        {
+            int unused[] = { 0, (std::get<I>(_args).begin(args), 0)... };
+            (void)unused;
+        }
+
+        template <std::size_t... I>
+        void initArgv(std::index_sequence<I...>, IDecomposer** argv)
+        {
+            int unused[] = { 0, (argv[I] = &std::get<I>(_args), 0)... };
+            (void)unused;
+        }
+
+        RpcClient& _client;
+        std::tuple<Decomposer<A>...> _args;
+        Composer<T> _r;
+};
+
+}
+}
+
+#endif // CXXTOOLS_BIN_REMOTESTREAM_H
@@ -151,6 +151,12 @@ class RpcClient : public RemoteClient
 
         void call(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc);
 
+        /// Sends the request of a streaming procedure; see RemoteStream.
+        void beginStream(IRemoteProcedure& method, IDecomposer** argv, unsigned argc);
+
+        /// Reads the next element of the stream to `r`; returns false at the end.
+        bool readStream(IComposer& r);
+
         Milliseconds timeout() const;
         void timeout(Milliseconds t);
 
@@ -161,6 +167,8 @@ class RpcClient : public RemoteClient
 
         void cancel();
 
+        void cancelCall(const IRemoteProcedure& proc);
+
         void wait(Milliseconds msecs = WaitInfinite);
 
         const std::string& domain() const;
@@ -102,6 +102,16 @@ class RpcServer : public ServiceRegistry
         unsigned maxThreads() const;
         void maxThreads(unsigned m);
 
+        /** Maximum number of calls running for one multiplexed connection.
+         *
+         *  When a client has this many calls running or does not read its
+         *  replies, the server stops reading further requests from the
+         *  connection until calls are finished and replies are sent. The
+         *  default is 64.
+         */
+        unsigned maxCallsPerConnection() const;
+        void maxCallsPerConnection(unsigned m);
+
         enum Runmode {
           Stopped,
           Starting,
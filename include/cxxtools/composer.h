@@ -29,10 +29,50 @@
 #define cxxtools_Composer_h
 
 #include <cxxtools/serializationinfo.h>
+#include <cxxtools/string.h>
+#include <exception>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 namespace cxxtools
 {
 
+/** Receives a value from a parser, which does not build a SerializationInfo.
+
+    The members of arrays and objects are passed between beginElement and
+    finishElement. The parser calls finish, when the value is complete.
+ */
+class IDirectComposer
+{
+    public:
+        typedef SerializationInfo::int_type int_type;
+        typedef SerializationInfo::unsigned_type unsigned_type;
+
+        virtual ~IDirectComposer() = default;
+
+        virtual void setCategory(SerializationInfo::Category category) = 0;
+        virtual void setNull() = 0;
+        virtual void setValue(int_type value) = 0;
+        virtual void setValue(unsigned_type value) = 0;
+        virtual void setValue(long double value) = 0;
+        virtual void setValue(bool value) = 0;
+        virtual void setValue(char value) = 0;
+
+        // 8 bit text or binary data
+        virtual void setValue(std::string&& value) = 0;
+
+        // UTF-8 encoded text
+        virtual void setUtf8(std::string&& value) = 0;
+
+        virtual void beginElement() = 0;
+        virtual void finishElement() = 0;
+
+        // throws the first error found in the value
+        virtual void finish() = 0;
+};
+
+
 class IComposer
 {
     public:
@@ -40,14 +80,22 @@ class IComposer
         virtual ~IComposer() = default;
 
         virtual void fixup(SerializationInfo& si) = 0;
+
+        // Returns the receiver for a parser, which passes the value directly,
+        // or null, when the value is read through a SerializationInfo. The
+        // parser asks for it right before it reads the value.
+        virtual IDirectComposer* direct()
+        { return nullptr; }
 };
 
 
+// Reads a value through a SerializationInfo. This works for all types,
+// which define operator >>= for SerializationInfo.
 template <typename T>
-class Composer : public IComposer
+class BasicComposer : public IComposer
 {
     public:
-        Composer()
+        BasicComposer()
         : _type(0)
         {}
 
@@ -65,6 +113,209 @@ class Composer : public IComposer
         T* _type;
 };
 
+
+/** DirectCompose<T>::value is true for types, which a parser may pass
+    without a SerializationInfo: integers, bool, floating point types and
+    strings. Arrays of them in std::vector are passed directly as well.
+    The choice is made at compile time; other types use BasicComposer.
+ */
+template <typename T> struct DirectCompose : std::false_type { };
+
+template <> struct DirectCompose<short> : std::true_type { };
+template <> struct DirectCompose<int> : std::true_type { };
+template <> struct DirectCompose<long> : std::true_type { };
+template <> struct DirectCompose<long long> : std::true_type { };
+template <> struct DirectCompose<unsigned short> : std::true_type { };
+template <> struct DirectCompose<unsigned int> : std::true_type { };
+template <> struct DirectCompose<unsigned long> : std::true_type { };
+template <> struct DirectCompose<unsigned long long> : std::true_type { };
+template <> struct DirectCompose<bool> : std::true_type { };
+template <> struct DirectCompose<float> : std::true_type { };
+template <> struct DirectCompose<double> : std::true_type { };
+template <> struct DirectCompose<long double> : std::true_type { };
+template <> struct DirectCompose<std::string> : std::true_type { };
+template <> struct DirectCompose<String> : std::true_type { };
+
+
+//! @cond internal
+// Converts the values passed by a parser with a SerializationInfo, which
+// holds just the single value, so that the result is the same as with
+// operator >>=. Errors are kept until finish, so that the parser reads the
+// value to its end.
+class BasicDirectComposer : public IDirectComposer
+{
+    public:
+        void setCategory(SerializationInfo::Category category) override;
+        void setNull() override;
+        void setValue(int_type value) override;
+        void setValue(unsigned_type value) override;
+        void setValue(long double value) override;
+        void setValue(bool value) override;
+        void setValue(char value) override;
+        void setValue(std::string&& value) override;
+        void setUtf8(std::string&& value) override;
+        void beginElement() override;
+        void finishElement() override;
+        void finish() override;
+
+    protected:
+        explicit BasicDirectComposer(bool array)
+            : _array(array),
+              _depth(0),
+              _count(0)
+            { }
+
+        void reset();
+
+        // converts _si to the current value
+        virtual void assign() = 0;
+        virtual void assign(std::string&& value) = 0;
+
+        // begins and finishes an element of the array
+        virtual void beginValue()   { }
+        virtual void finishValue()  { }
+
+        template <typename V>
+        void assignString(V& target, std::string&& value)
+        {
+            _si.setValue(std::move(value));
+            _si >>= target;
+        }
+
+        void assignString(std::string& target, std::string&& value)
+        {
+            target = std::move(value);
+        }
+
+        SerializationInfo _si;
+
+    private:
+        bool accept() const
+        { return !_error && _depth == (_array ? 1u : 0u); }
+
+        void convert();
+        void fail(const SerializationError& e);
+
+        bool _array;
+        unsigned _depth;
+        unsigned _count;
+        std::exception_ptr _error;
+};
+
+
+template <typename T>
+class ValueComposer : public IComposer, private BasicDirectComposer
+{
+    public:
+        ValueComposer()
+        : BasicDirectComposer(false),
+          _type(0)
+        {}
+
+        void begin(T& type)
+        {
+            _type = &type;
+        }
+
+        void fixup(SerializationInfo& si) override
+        {
+            si >>= *_type;
+        }
+
+        IDirectComposer* direct() override
+        {
+            reset();
+            return this;
+        }
+
+    private:
+        void assign() override
+        {
+            _si >>= *_type;
+        }
+
+        void assign(std::string&& value) override
+        {
+            assignString(*_type, std::move(value));
+        }
+
+        T* _type;
+};
+
+
+template <typename C>
+class ArrayComposer : public IComposer, private BasicDirectComposer
+{
+        typedef typename C::value_type value_type;
+
+    public:
+        ArrayComposer()
+        : BasicDirectComposer(true),
+          _values(0),
+          _value()
+        {}
+
+        void begin(C& values)
+        {
+            _values = &values;
+        }
+
+        void fixup(SerializationInfo& si) override
+        {
+            si >>= *_values;
+        }
+
+        IDirectComposer* direct() override
+        {
+            reset();
+            _values->clear();
+            return this;
+        }
+
+    private:
+        void beginValue() override
+        {
+            _value = value_type();
+        }
+
+        void finishValue() override
+        {
+            _values->push_back(std::move(_value));
+        }
+
+        void assign() override
+        {
+            _si >>= _value;
+        }
+
+        void assign(std::string&& value) override
+        {
+            assignString(_value, std::move(value));
+        }
+
+        C* _values;
+        value_type _value;
+};
+//! @endcond internal
+
+
+template <typename T>
+class Composer : public std::conditional<DirectCompose<T>::value,
+                                         ValueComposer<T>,
+                                         BasicComposer<T>>::type
+{
+};
+
+
+template <typename T, typename A>
+class Composer<std::vector<T, A>>
+    : public std::conditional<DirectCompose<T>::value,
+                              ArrayComposer<std::vector<T, A>>,
+                              BasicComposer<std::vector<T, A>>>::type
+{
+};
+
+
 class IComposers
 {
     public:
@@ -86,6 +337,7 @@ class Composers : public IComposers
               _current(0)
         { }
 
+        void begin()                    { _current = 0; }
         bool needMore() override        { return _current < _count; }
         IComposer* get() override       { return _current < _count ? _composers[_current++] : nullptr; }
 };
@@ -29,13 +29,15 @@
 #define cxxtools_Decomposer_h
 
 #include <cxxtools/serializationinfo.h>
+#include <cxxtools/formatter.h>
+#include <cxxtools/string.h>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 namespace cxxtools
 {
 
-class Formatter;
-
 class IDecomposer
 {
     public:
@@ -54,11 +56,13 @@ class IDecomposer
 };
 
 
+// Formats a value through a SerializationInfo. This works for all types,
+// which define operator <<= for SerializationInfo.
 template <typename T>
-class Decomposer : public IDecomposer
+class BasicDecomposer : public IDecomposer
 {
     public:
-        Decomposer()
+        BasicDecomposer()
         : _current(&_si)
         { }
 
@@ -84,6 +88,165 @@ class Decomposer : public IDecomposer
 };
 
 
+/** Types, which are passed to the formatter directly.
+
+    For these types the Decomposer skips the SerializationInfo and formats
+    the value like formatEach would do it with the SerializationInfo of the
+    value. Arrays of them in std::vector are formatted directly as well.
+    The choice is made at compile time; other types use BasicDecomposer.
+ */
+template <typename T>
+struct DirectFormat
+{
+    static const bool value = false;
+};
+
+struct DirectFormatInt
+{
+    static const bool value = true;
+    static void format(Formatter& formatter, const std::string& name, IDecomposer::int_type v)
+    { formatter.addValueInt(name, "int", v); }
+};
+
+struct DirectFormatUnsigned
+{
+    static const bool value = true;
+    static void format(Formatter& formatter, const std::string& name, IDecomposer::unsigned_type v)
+    { formatter.addValueUnsigned(name, "int", v); }
+};
+
+template <> struct DirectFormat<short> : DirectFormatInt { };
+template <> struct DirectFormat<int> : DirectFormatInt { };
+template <> struct DirectFormat<long> : DirectFormatInt { };
+template <> struct DirectFormat<long long> : DirectFormatInt { };
+template <> struct DirectFormat<unsigned short> : DirectFormatUnsigned { };
+template <> struct DirectFormat<unsigned int> : DirectFormatUnsigned { };
+template <> struct DirectFormat<unsigned long> : DirectFormatUnsigned { };
+template <> struct DirectFormat<unsigned long long> : DirectFormatUnsigned { };
+
+template <> struct DirectFormat<bool>
+{
+    static const bool value = true;
+    static void format(Formatter& formatter, const std::string& name, bool v)
+    { formatter.addValueBool(name, "bool", v); }
+};
+
+template <> struct DirectFormat<float>
+{
+    static const bool value = true;
+    static void format(Formatter& formatter, const std::string& name, float v)
+    { formatter.addValueFloat(name, "float", v); }
+};
+
+template <> struct DirectFormat<double>
+{
+    static const bool value = true;
+    static void format(Formatter& formatter, const std::string& name, double v)
+    { formatter.addValueDouble(name, "double", v); }
+};
+
+template <> struct DirectFormat<long double>
+{
+    static const bool value = true;
+    static void format(Formatter& formatter, const std::string& name, long double v)
+    { formatter.addValueLongDouble(name, "double", v); }
+};
+
+template <> struct DirectFormat<std::string>
+{
+    static const bool value = true;
+    static void format(Formatter& formatter, const std::string& name, const std::string& v)
+    { formatter.addValueStdString(name, "string", v); }
+};
+
+template <> struct DirectFormat<String>
+{
+    static const bool value = true;
+    static void format(Formatter& formatter, const std::string& name, const String& v)
+    { formatter.addValueString(name, "string", String(v)); }
+};
+
+
+// Keeps a copy of the value, since remote procedures may format their
+// arguments after `begin` returned.
+template <typename T>
+class ValueDecomposer : public IDecomposer
+{
+    public:
+        ValueDecomposer()
+        : _value()
+        { }
+
+        void begin(const T& value)
+        {
+            _value = value;
+        }
+
+        virtual void setName(const std::string& name)
+        {
+            _name = name;
+        }
+
+        virtual void format(Formatter& formatter)
+        {
+            DirectFormat<T>::format(formatter, _name, _value);
+        }
+
+    private:
+        T _value;
+        std::string _name;
+};
+
+
+template <typename C>
+class ArrayDecomposer : public IDecomposer
+{
+        typedef typename C::value_type value_type;
+
+    public:
+        void begin(const C& values)
+        {
+            _values = values;
+        }
+
+        virtual void setName(const std::string& name)
+        {
+            _name = name;
+        }
+
+        virtual void format(Formatter& formatter)
+        {
+            const std::string noName;
+
+            formatter.beginArray(_name, "array");
+            for (const value_type& v: _values)
+                DirectFormat<value_type>::format(formatter, noName, v);
+            formatter.finishArray();
+        }
+
+    private:
+        C _values;
+        std::string _name;
+};
+
+
+template <typename T>
+class Decomposer : public std::conditional<DirectFormat<T>::value,
+                                           ValueDecomposer<T>,
+                                           BasicDecomposer<T>>::type
+{
+};
+
+
+template <typename T, typename A>
+class Decomposer<std::vector<T, A>>
+    : public std::conditional<DirectFormat<T>::value,
+                              ArrayDecomposer<std::vector<T, A>>,
+                              BasicDecomposer<std::vector<T, A>>>::type
+{
+};
+
+
 template <>
 class Decomposer<SerializationInfo> : public IDecomposer
 {
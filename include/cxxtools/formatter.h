@@ -49,6 +49,13 @@ class Formatter
         virtual void addValueStdString(const std::string& name, const std::string& type,
                               std::string&& value);
 
+        // Formats a string, which the caller keeps. The default passes a
+        // copy to the variant above, so formatters, which override just that
+        // one, see every string. Formatters, which write the value without
+        // taking it, override this one to skip the copy.
+        virtual void addValueStdString(const std::string& name, const std::string& type,
+                              const std::string& value);
+
         virtual void addValueChar(const std::string& name, const std::string& type,
                               char value);
 
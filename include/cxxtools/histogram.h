@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_HISTOGRAM_H
+#define CXXTOOLS_HISTOGRAM_H
+
+#include <cxxtools/timespan.h>
+#include <cxxtools/shardedcounters.h>
+#include <vector>
+
+namespace cxxtools
+{
+
+class SerializationInfo;
+
+/**
+ Thread safe histogram of durations.
+
+ The values are counted in buckets with fixed upper bounds. Adding a value
+ takes no lock and updates only counters of the calling thread's shard (see
+ ShardedCounters), so that it can be used to record latencies in hot paths.
+ Reading merges the shards. Quantiles are estimated by interpolating inside
+ the bucket.
+
+ The default bounds range from 100 microseconds to 10 seconds.
+ */
+class Histogram
+{
+        Histogram(const Histogram&) = delete;
+        Histogram& operator=(const Histogram&) = delete;
+
+    public:
+        Histogram();
+
+        /// Creates a histogram with the given ascending upper bounds.
+        /// Values above the last bound are counted in an extra bucket.
+        explicit Histogram(const std::vector<Timespan>& bounds);
+
+        void add(Timespan value);
+
+        /// Returns the number of values added.
+        uint64_t count() const
+            { return _counters.sum(Count); }
+
+        /// Returns the sum of all values.
+        Timespan sum() const
+            { return Microseconds(_counters.sum(Sum)); }
+
+        /// Returns the largest value added.
+        Timespan max() const
+            { return Microseconds(_counters.max(Max)); }
+
+        /// Returns the number of buckets including the one for values above the last bound.
+        unsigned buckets() const
+            { return _bounds.size() + 1; }
+
+        /// Returns the upper bound of a bucket; the last bucket has no bound.
+        const Timespan& bound(unsigned n) const
+            { return _bounds[n]; }
+
+        /// Returns the number of values counted in a bucket.
+        uint64_t bucketCount(unsigned n) const
+            { return _counters.sum(Buckets + n); }
+
+        /// Estimates the q-quantile (0 <= q <= 1) of the values, e.g. 0.99 for p99.
+        Timespan quantile(double q) const;
+
+        void clear();
+
+        static const std::vector<Timespan>& defaultBounds();
+
+    private:
+        // counters per shard; the buckets follow
+        enum { Count, Sum, Max, Buckets };
+
+        std::vector<Timespan> _bounds;
+        ShardedCounters _counters;
+};
+
+/// Serializes count, sum, max, quantiles and cumulative buckets with times in milliseconds.
+void operator<<= (SerializationInfo& si, const Histogram& histogram);
+
+}
+
+#endif // CXXTOOLS_HISTOGRAM_H
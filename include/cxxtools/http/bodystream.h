@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef cxxtools_Http_BodyStream_h
+#define cxxtools_Http_BodyStream_h
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+/**
+ Stream buffer for message bodies.
+
+ The data is kept in a contiguous buffer, which is kept, when the buffer
+ is reset for the next message. Buffers larger than maxKeptCapacity are
+ released on reset, so that a single large message does not hold its
+ memory for the lifetime of the connection.
+ */
+class BodyStreamBuf : public std::streambuf
+{
+        std::vector<char> _data;
+
+        void reserve(std::size_t size);
+
+    protected:
+        int_type overflow(int_type ch);
+        int_type underflow();
+        std::streamsize showmanyc();
+        std::streamsize xsputn(const char* s, std::streamsize n);
+        pos_type seekoff(off_type off, std::ios::seekdir dir, std::ios::openmode which);
+        pos_type seekpos(pos_type pos, std::ios::openmode which);
+
+    public:
+        static const std::size_t maxKeptCapacity = 65536;
+
+        BodyStreamBuf()
+            { }
+
+        BodyStreamBuf(BodyStreamBuf&& other);
+        BodyStreamBuf& operator=(BodyStreamBuf&& other);
+
+        /// Returns the data written so far.
+        const char* data() const    { return pbase() ? pbase() : ""; }
+        /// Returns the number of bytes written so far.
+        std::size_t size() const    { return pptr() - pbase(); }
+
+        void assign(const char* data, std::size_t size);
+
+        /// Discards the data.
+        void reset();
+};
+
+/**
+ The stream used for request and reply bodies.
+
+ It is used like a std::stringstream, but the body can be accessed
+ without copying it and the buffer is reused for further messages.
+ */
+class BodyStream : public std::iostream
+{
+        BodyStreamBuf _streambuf;
+
+    public:
+        BodyStream()
+            : std::iostream(0)
+            { init(&_streambuf); }
+
+        BodyStream(BodyStream&& other)
+            : std::iostream(std::move(other)),
+              _streambuf(std::move(other._streambuf))
+            { set_rdbuf(&_streambuf); }
+
+        BodyStream& operator=(BodyStream&& other)
+        {
+            std::iostream::operator=(std::move(other));
+            _streambuf = std::move(other._streambuf);
+            return *this;
+        }
+
+        BodyStreamBuf* rdbuf()
+            { return &_streambuf; }
+
+        const char* data() const        { return _streambuf.data(); }
+        std::size_t size() const        { return _streambuf.size(); }
+
+        /// Returns a copy of the data.
+        std::string str() const
+            { return std::string(data(), size()); }
+
+        /// Replaces the data.
+        void str(const std::string& s)
+            { _streambuf.assign(s.data(), s.size()); }
+
+        /// Discards the data and resets the state of the stream.
+        void reset()
+        {
+            _streambuf.reset();
+            clear();
+        }
+};
+
+} // namespace http
+
+} // namespace cxxtools
+
+#endif
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef cxxtools_Http_CachingService_h
+#define cxxtools_Http_CachingService_h
+
+#include <cxxtools/http/service.h>
+#include <cxxtools/timespan.h>
+#include <string>
+#include <stdint.h>
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+class CachingServiceImpl;
+
+/**
+ A service, which caches the replies of another service in memory.
+
+ GET and HEAD requests are answered from the cache, when a fresh reply
+ for the method, the url with query and the selected request headers is
+ found. Otherwise the request is passed to the wrapped service and its
+ reply is stored, when it may be cached.
+
+ The time to live of a reply is taken from the max-age or s-maxage
+ directive of its Cache-Control header. Replies without these directives
+ are kept for the default time to live, which is 0 by default, so that
+ only replies with explicit freshness are stored. Replies with no-store,
+ no-cache or private, with a Set-Cookie header or with a Vary header on
+ request headers not selected are never stored.
+
+ Concurrent requests for the same missing entry are computed once: the
+ first request is passed to the wrapped service while the others wait for
+ its reply.
+
+ The cache is limited by the number of bytes used by the entries; the
+ least recently used entries are dropped when the limit is exceeded.
+
+ Authenticators must be added to the caching service, since the wrapped
+ service is not consulted for cache hits.
+
+ Example:
+ \code
+   ExpensiveService expensive;
+   cxxtools::http::CachingService cached(expensive, 64 * 1024 * 1024);
+   cached.addKeyHeader("Accept-Language");
+   server.addService("/report", cached);
+ \endcode
+ */
+class CachingService : public Service
+{
+        CachingServiceImpl* _impl;
+
+        CachingService(const CachingService&) = delete;
+        CachingService& operator=(const CachingService&) = delete;
+
+    public:
+        explicit CachingService(Service& service, std::size_t maxBytes = 16 * 1024 * 1024);
+        ~CachingService();
+
+        /// Adds a request header, which is part of the cache key.
+        void addKeyHeader(const std::string& header);
+
+        /// Returns the maximum number of bytes used by the cached replies.
+        std::size_t maxBytes() const;
+        void maxBytes(std::size_t bytes);
+
+        /// Returns the time to live of replies without explicit freshness.
+        Milliseconds defaultTtl() const;
+        void defaultTtl(Milliseconds ttl);
+
+        /// Drops all cached replies.
+        void clear();
+
+        /// Returns the number of cached replies.
+        std::size_t entries() const;
+        /// Returns the number of bytes used by the cached replies.
+        std::size_t bytes() const;
+
+        /// Returns the number of requests answered from the cache.
+        uint64_t hits() const;
+        /// Returns the number of cacheable requests passed to the wrapped service.
+        uint64_t misses() const;
+
+    protected:
+        Responder* createResponder(const Request& request);
+        void releaseResponder(Responder* responder);
+};
+
+} // namespace http
+
+} // namespace cxxtools
+
+#endif
@@ -215,6 +215,14 @@ class Client
          */
         const Reply& readBody();
 
+        /** Reads the http body after header read with execute and writes it to the passed stream.
+
+            The body is written while it arrives and is not kept in the reply,
+            so that large bodies need not fit into memory. Chunked transfer
+            encoding is decoded. This method blocks until the body is received.
+         */
+        void readBody(std::ostream& out);
+
         /** Returns the reply of the last executed request.
          */
         const Reply& reply() const;
@@ -295,6 +303,14 @@ class Client
          */
         void endExecute();
 
+        /** Continues reading the body of an asynchronous request.
+
+            When the delegate bodyAvailable returns 0, the client stops reading
+            from the network until this method is called. The data already
+            received is passed to bodyAvailable again.
+         */
+        void resumeBody();
+
         /// Sets the selector for asynchronous event processing.
         void setSelector(SelectorBase* selector);
         void setSelector(SelectorBase& selector);
@@ -308,6 +324,10 @@ class Client
         bool wait(Milliseconds msecs);
 
         /** Returns the underlying stream, where the reply is to be read from.
+
+            After execute the body can be read from this stream instead of
+            calling readBody. Chunked transfer encoding is decoded and the
+            stream signals end of file at the end of the body.
          */
         std::istream& in();
 
@@ -335,6 +355,7 @@ class Client
 
         /// This delegate is called, when data is arrived while reading the
         /// body. The connected functor must return the number of bytes read.
+        /// When it returns 0, reading is paused until resumeBody is called.
         cxxtools::Delegate<std::size_t, Client&> bodyAvailable;
 
         /// Signals that the reply is completely processed.
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef cxxtools_Http_ClientPool_h
+#define cxxtools_Http_ClientPool_h
+
+#include <cxxtools/http/reply.h>
+#include <cxxtools/selectable.h>
+#include <cxxtools/signal.h>
+#include <cxxtools/timespan.h>
+#include <string>
+#include <stdint.h>
+
+namespace cxxtools
+{
+
+class SelectorBase;
+class SslCtx;
+
+namespace net
+{
+class AddrInfo;
+}
+
+namespace http
+{
+
+class ClientPoolImpl;
+class Request;
+
+/**
+ This class implements a http client with a pool of connections.
+
+ The pool keeps keep alive connections per host. Requests are started with
+ beginExecute and run concurrently on the connections of the host. When all
+ connections of a host are busy and the limit of connections per host is
+ reached, the request waits for the next free connection. Connections,
+ which are idle longer than the idle timeout, are closed.
+
+ All connections are processed by one selector, which is either passed to
+ the constructor or owned by the pool.
+
+ Example:
+ \code
+   cxxtools::http::ClientPool pool;
+   cxxtools::net::AddrInfo backend("localhost", 8000);
+   unsigned a = pool.beginExecute(backend, cxxtools::http::Request("a"));
+   unsigned b = pool.beginExecute(backend, cxxtools::http::Request("b"));
+   std::string ra = pool.endExecute(a);   // waits for the reply
+   std::string rb = pool.endExecute(b);
+ \endcode
+ */
+class ClientPool
+{
+        ClientPoolImpl* _impl;
+
+        ClientPool(const ClientPool&) = delete;
+        ClientPool& operator=(const ClientPool&) = delete;
+
+    public:
+        /// Creates a pool, which processes the connections with its own selector.
+        ClientPool();
+
+        /// Creates a pool, which processes the connections with the passed selector.
+        explicit ClientPool(SelectorBase& selector);
+
+        ~ClientPool();
+
+        /// Maximum number of connections to one host; default 8.
+        unsigned maxConnectionsPerHost() const;
+        void maxConnectionsPerHost(unsigned n);
+
+        /// Time after which an idle connection is closed; default 10 seconds.
+        Milliseconds idleTimeout() const;
+        void idleTimeout(Milliseconds ms);
+
+        /** Starts a request to the passed host and returns its id.
+
+            The request is copied, so it need not be kept. The request is
+            processed while wait() or the selector runs. When the reply is
+            complete, the signal replyFinished is sent.
+         */
+        unsigned beginExecute(const net::AddrInfo& addr, const Request& request);
+        unsigned beginExecute(const net::AddrInfo& addr, const SslCtx& sslCtx, const Request& request);
+        unsigned beginExecute(const std::string& host, unsigned short port, const Request& request);
+
+        /** Returns the reply of a request started with beginExecute.
+
+            When the reply is not complete yet, the method waits for it.
+            When the request failed, an exception is thrown.
+            The returned reply is valid until the next call of execute or endExecute.
+         */
+        const Reply& endExecute(unsigned id,
+            Milliseconds timeout = Selectable::WaitInfinite);
+
+        /// Returns true, when the reply of the request is complete or the request failed.
+        bool finished(unsigned id) const;
+
+        /** Executes a request and waits for the reply.
+
+            Other requests started with beginExecute continue meanwhile.
+         */
+        const Reply& execute(const net::AddrInfo& addr, const Request& request,
+            Milliseconds timeout = Selectable::WaitInfinite);
+
+        /// Executes a GET request.
+        const Reply& get(const std::string& host, unsigned short port, const std::string& url,
+            Milliseconds timeout = Selectable::WaitInfinite);
+
+        /// Closes all idle connections.
+        void closeIdle();
+
+        /// Returns the selector, which processes the connections.
+        SelectorBase& selector();
+
+        /** Processes the network events until a event occurs or the
+            specified timeout is reached.
+         */
+        bool wait(Milliseconds msecs);
+
+        /// Returns the number of network connections opened by the pool.
+        uint64_t connectionsOpened() const;
+
+        /// Returns the number of requests sent on a connection kept alive.
+        uint64_t connectionsReused() const;
+
+        /// Returns the number of connections running a request.
+        unsigned activeConnections() const;
+
+        /// Returns the number of open connections waiting for a request.
+        unsigned idleConnections() const;
+
+        /// Signals that the reply of the request with the passed id is finished.
+        Signal<ClientPool&, unsigned> replyFinished;
+};
+
+} // namespace http
+
+} // namespace cxxtools
+
+#endif
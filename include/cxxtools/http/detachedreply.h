@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef cxxtools_Http_DetachedReply_h
+#define cxxtools_Http_DetachedReply_h
+
+#include <cxxtools/signal.h>
+#include <string>
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+class Request;
+class DetachedReplyImpl;
+
+/**
+ A reply, which is sent after the responder returned.
+
+ A responder calls Responder::detach() in its reply method to get this
+ object. The header and the body written so far are sent, when reply
+ returns. After that the connection is passed to the event loop of the
+ server, so that an open reply holds no worker thread; an idle reply costs
+ just the socket and its buffer. This is suitable for server-sent events
+ and long polling.
+
+ The body is sent with chunked transfer encoding to HTTP/1.1 clients. For
+ HTTP/1.0 clients the connection is closed at the end of the reply.
+
+ The write methods queue the data and return immediately. They may be
+ called from any thread; when called outside of the event loop, the loop
+ is woken to send the data.
+
+ The object is destroyed by the server after the signal closed was sent
+ and must not be used after that.
+
+ Example:
+ \code
+   void EventResponder::reply(std::ostream& out, cxxtools::http::Request& request, cxxtools::http::Reply& reply)
+   {
+       reply.setHeader("Content-Type", "text/event-stream");
+       reply.setHeader("Cache-Control", "no-cache");
+       cxxtools::http::DetachedReply& events = detach();
+       subscribers.add(events);   // sends events with events.sendEvent later
+       cxxtools::connect(events.closed, subscribers, &Subscribers::remove);
+   }
+ \endcode
+ */
+class DetachedReply
+{
+        friend class DetachedReplyImpl;
+
+        DetachedReplyImpl* _impl;
+
+        explicit DetachedReply(DetachedReplyImpl* impl)
+            : _impl(impl)
+            { }
+
+        DetachedReply(const DetachedReply&) = delete;
+        DetachedReply& operator=(const DetachedReply&) = delete;
+
+    public:
+        /// Returns the request, which is answered.
+        const Request& request() const;
+
+        std::string peerAddr() const;
+
+        /// Sends data as part of the reply body.
+        void write(const char* data, std::size_t size);
+        void write(const std::string& data)
+            { write(data.data(), data.size()); }
+
+        /** Sends a server-sent event.
+
+            The data is sent in data lines; an empty event name sends an
+            event of the default type "message".
+         */
+        void sendEvent(const std::string& data,
+                       const std::string& event = std::string(),
+                       const std::string& id = std::string());
+
+        /** Ends the reply.
+
+            The connection is kept for further requests of the client when
+            possible. The signal closed is sent, when the reply is sent.
+         */
+        void finish();
+
+        /// Returns false, when the reply is finished or the client is gone.
+        bool isOpen() const;
+
+        /// Returns the number of bytes queued and not sent yet.
+        std::size_t outputPending() const;
+
+        /// Signals the end of the reply, either finished or lost by the client.
+        Signal<DetachedReply&> closed;
+};
+
+} // namespace http
+
+} // namespace cxxtools
+
+#endif
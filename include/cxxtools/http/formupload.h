@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef cxxtools_Http_FormUpload_h
+#define cxxtools_Http_FormUpload_h
+
+#include <cxxtools/http/uploadresponder.h>
+#include <cxxtools/mime.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+/**
+ A body sink for html form uploads with content type multipart/form-data.
+
+ Fields without a file name are kept in memory up to maxFieldSize bytes.
+ The content of files is written to temporary files in the directory
+ given by the environment variable TMPDIR or /tmp while it arrives, so
+ that files of any size can be received.
+
+ The temporary files are removed, when the object is destroyed. To keep a
+ file, it must be renamed or linked before that.
+ */
+class FormUpload : private MimeMultipartParser::Handler, public MultipartSink
+{
+    public:
+        struct Part
+        {
+            std::string name;
+            std::string filename;
+            std::string contentType;
+            MimeHeader header;
+
+            /// The value of a field without file name.
+            std::string value;
+
+            /// The path of the temporary file, when the part is a file.
+            std::string path;
+
+            std::uint64_t size;
+
+            Part()
+                : size(0)
+                { }
+
+            bool isFile() const
+                { return !path.empty(); }
+        };
+
+        typedef std::vector<Part> Parts;
+
+    private:
+        Parts _parts;
+        std::string _tmpdir;
+        std::size_t _maxFieldSize;
+        int _fd;
+
+        void onPartBegin(const MimeHeader& header);
+        void onPartData(const char* data, std::size_t size);
+        void onPartEnd();
+
+        void closeFile();
+
+        FormUpload(const FormUpload&) = delete;
+        FormUpload& operator=(const FormUpload&) = delete;
+
+    public:
+        explicit FormUpload(const Request& request, std::size_t maxFieldSize = 65536);
+        ~FormUpload();
+
+        const Parts& parts() const
+            { return _parts; }
+
+        /// Returns the first part with the passed name or a null pointer.
+        const Part* part(const std::string& name) const;
+
+        /// Returns the value of a field or a default value.
+        std::string value(const std::string& name, const std::string& def = std::string()) const;
+
+        const std::string& tmpdir() const            { return _tmpdir; }
+        void tmpdir(const std::string& dir)          { _tmpdir = dir; }
+
+        std::size_t maxFieldSize() const             { return _maxFieldSize; }
+};
+
+} // namespace http
+
+} // namespace cxxtools
+
+#endif
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef cxxtools_Http_Http2Client_h
+#define cxxtools_Http_Http2Client_h
+
+#include <cxxtools/http/reply.h>
+#include <cxxtools/selectable.h>
+#include <cxxtools/signal.h>
+#include <cxxtools/timespan.h>
+#include <string>
+
+namespace cxxtools
+{
+
+class SelectorBase;
+
+namespace net
+{
+class AddrInfo;
+}
+
+namespace http
+{
+
+class Http2ClientImpl;
+class Request;
+
+/**
+ This class implements a http/2 client over cleartext tcp (h2c).
+
+ All requests are sent as streams of a single connection, so that multiple
+ requests run concurrently without waiting for each other. Requests, which
+ exceed the number of concurrent streams allowed by the server are queued.
+
+ By default the connection is started with prior knowledge, i.e. the client
+ expects the server to speak http/2. With upgrade(true) the first request
+ is sent as HTTP/1.1 with `Upgrade: h2c`.
+
+ Example:
+ \code
+   cxxtools::http::Http2Client client("localhost", 8000);
+   unsigned a = client.beginExecute(cxxtools::http::Request("a"));
+   unsigned b = client.beginExecute(cxxtools::http::Request("b"));
+   std::string ra = client.endExecute(a);   // waits for the reply
+   std::string rb = client.endExecute(b);
+ \endcode
+ */
+class Http2Client
+{
+        Http2ClientImpl* _impl;
+
+        Http2Client(const Http2Client&) = delete;
+        Http2Client& operator=(const Http2Client&) = delete;
+
+    public:
+        Http2Client();
+        explicit Http2Client(SelectorBase& selector);
+        Http2Client(const std::string& host, unsigned short port);
+        Http2Client(SelectorBase& selector, const std::string& host, unsigned short port);
+
+        ~Http2Client();
+
+        /** Sets the host and port of the server. No actual network connect is done.
+         */
+        void prepareConnect(const net::AddrInfo& addr);
+        void prepareConnect(const std::string& host, unsigned short port);
+
+        /** Connects to the server and starts the http/2 connection.
+            This happens automatically with the first request.
+         */
+        void connect();
+
+        /** Closes the network connection.
+            Requests, which are not finished yet, fail.
+         */
+        void close();
+
+        /// Uses a HTTP/1.1 upgrade instead of prior knowledge when set.
+        void upgrade(bool sw);
+        bool upgrade() const;
+
+        /** Executes a request and waits for the reply.
+            Other requests started with beginExecute continue meanwhile.
+            The returned reply is valid until the next call of execute or endExecute.
+         */
+        const Reply& execute(const Request& request,
+            Milliseconds timeout = Selectable::WaitInfinite);
+
+        /// Executes a GET request.
+        const Reply& get(const std::string& url,
+            Milliseconds timeout = Selectable::WaitInfinite);
+
+        /** Starts a request and returns its id.
+            The request is copied, so it need not be kept. The request is
+            processed while wait() or the selector runs. When the reply is
+            complete, the signal replyFinished is sent.
+         */
+        unsigned beginExecute(const Request& request);
+
+        /** Returns the reply of a request started with beginExecute.
+            When the reply is not complete yet, the method waits for it.
+            When the request failed, an exception is thrown.
+            The returned reply is valid until the next call of execute or endExecute.
+         */
+        const Reply& endExecute(unsigned id,
+            Milliseconds timeout = Selectable::WaitInfinite);
+
+        /// Returns true, when the reply of the request is complete or the request failed.
+        bool finished(unsigned id) const;
+
+        /// Sets the selector for asynchronous event processing.
+        void setSelector(SelectorBase* selector);
+        void setSelector(SelectorBase& selector)
+            { setSelector(&selector); }
+
+        /// Returns the selector for asynchronous event processing.
+        SelectorBase* selector();
+
+        /** Processes the network events until a event occurs or the
+            specified timeout is reached.
+         */
+        bool wait(Milliseconds msecs);
+
+        /// Signals that the reply of the request with the passed id is finished.
+        Signal<Http2Client&, unsigned> replyFinished;
+};
+
+} // namespace http
+
+} // namespace cxxtools
+
+#endif
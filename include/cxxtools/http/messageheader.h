@@ -33,6 +33,8 @@
 #include <cstring>
 #include <utility>
 #include <iterator>
+#include <algorithm>
+#include <vector>
 
 namespace cxxtools
 {
@@ -40,18 +42,70 @@ namespace cxxtools
 namespace http
 {
 
+/**
+ Storage for http message headers.
+
+ The headers are kept in a growable buffer as `key\0value\0` pairs. A compact
+ table holds the offsets, a case insensitive hash of the key and a id for well
+ known headers. Well known headers are indexed by id, so that getHeader(HeaderId)
+ and lookups of their names do not scan the table. Other names are found by
+ scanning the table, comparing the hashes before the names.
+
+ The buffer grows up to maxSize(), which defaults to defaultMaxSize(). It is
+ allocated on first use and keeps its capacity on clear().
+ */
 class MessageHeader
 {
     public:
+        /// The fixed size of the header buffer in earlier versions. The size
+        /// is no longer limited by this constant but by maxSize().
         static const unsigned MAXHEADERSIZE = 4096;
 
+        /// Ids of well known headers.
+        enum HeaderId
+        {
+            Unknown = 0,
+            Accept,
+            AcceptEncoding,
+            Authorization,
+            CacheControl,
+            Connection,
+            ContentEncoding,
+            ContentLength,
+            ContentType,
+            Cookie,
+            Date,
+            Host,
+            Server,
+            TransferEncoding,
+            Upgrade,
+            UserAgent,
+            numWellKnownHeaders
+        };
+
     private:
-        char _rawdata[MAXHEADERSIZE];  // key_1\0value_1\0key_2\0value_2\0...key_n\0value_n\0\0
-        unsigned _endOffset;
-        char* eptr() { return _rawdata + _endOffset; }
+        struct Entry
+        {
+            unsigned key;     // offset of key in _rawdata
+            unsigned value;   // offset of value in _rawdata
+            unsigned hash;
+            HeaderId id;
+        };
+
+        typedef std::vector<Entry> Entries;
+
+        std::vector<char> _rawdata;  // key_1\0value_1\0key_2\0value_2\0...key_n\0value_n\0
+        Entries _entries;
+        unsigned _wellKnown[numWellKnownHeaders];  // index + 1 of first entry with id or 0
+        unsigned _maxSize;
         unsigned _httpVersionMajor;
         unsigned _httpVersionMinor;
 
+        static unsigned _defaultMaxSize;
+
+        const Entry* findEntry(const char* key) const;
+        void reindex();
+
     public:
         using value_type = std::pair<const char*, const char*>;
 
@@ -59,9 +113,17 @@ class MessageHeader
         {
             friend class MessageHeader;
 
-            value_type current_value;
+            const Entry* _entry;  // 0 when walking raw data
+            const char* _data;
+            mutable value_type current_value;
 
-            void fixup()
+            void fixup() const
+            {
+                current_value.first = _data + _entry->key;
+                current_value.second = _data + _entry->value;
+            }
+
+            void fixupRaw()
             {
                 if (*current_value.first)
                     current_value.second = current_value.first + std::strlen(current_value.first) + 1;
@@ -69,11 +131,11 @@ class MessageHeader
                     current_value.first = current_value.second = 0;
             }
 
-            void moveForward()
-            {
-                current_value.first = current_value.second + std::strlen(current_value.second) + 1;
-                fixup();
-            }
+            const_iterator(const Entry* entry, const char* data)
+                : _entry(entry),
+                  _data(data),
+                  current_value(0, 0)
+            { }
 
           public:
             using iterator_category = std::forward_iterator_tag;
@@ -83,45 +145,72 @@ class MessageHeader
             using const_reference = const value_type&;
 
             const_iterator()
-                : current_value(0, 0)
+                : _entry(0),
+                  _data(0),
+                  current_value(0, 0)
             { }
 
+            /// Iterates over raw header data in the format
+            /// `key_1\0value_1\0...key_n\0value_n\0\0`.
             explicit const_iterator(const char* p)
-                : current_value(p, p)
+                : _entry(0),
+                  _data(0),
+                  current_value(p, p)
             {
-                fixup();
+                fixupRaw();
             }
 
             bool operator== (const const_iterator& it) const
-            { return current_value.first == it.current_value.first; }
+            {
+                return _entry || it._entry ? _entry == it._entry
+                                           : current_value.first == it.current_value.first;
+            }
 
             bool operator!= (const const_iterator& it) const
-            { return current_value.first != it.current_value.first; }
+            { return !operator==(it); }
 
             const_iterator& operator++()
             {
-                moveForward();
+                if (_entry)
+                    ++_entry;
+                else
+                {
+                    current_value.first = current_value.second + std::strlen(current_value.second) + 1;
+                    fixupRaw();
+                }
+
                 return *this;
             }
 
             const_iterator operator++(int)
             {
                 const_iterator ret = *this;
-                moveForward();
+                operator++();
                 return ret;
             }
 
-            const value_type& operator* () const   { return current_value; }
-            const value_type* operator-> () const  { return &current_value; }
+            const value_type& operator* () const
+            {
+                if (_entry)
+                    fixup();
+                return current_value;
+            }
+
+            const value_type* operator-> () const
+            { return &operator*(); }
+
+            /// Returns the well known id of the current header.
+            HeaderId id() const
+            { return _entry ? _entry->id : headerId(current_value.first); }
         };
 
 
         MessageHeader()
-            : _endOffset(0),
+            : _maxSize(_defaultMaxSize),
               _httpVersionMajor(1),
               _httpVersionMinor(1)
         {
-            _rawdata[0] = _rawdata[1] = '\0';
+            std::fill(_wellKnown, _wellKnown + numWellKnownHeaders, 0u);
         }
 
         virtual ~MessageHeader()  {}
@@ -133,20 +222,57 @@ class MessageHeader
         void addHeader(const char* key, const char* value)
         { setHeader(key, value, false); }
 
+        /// Adds a header from buffers, which need not be zero terminated.
+        void addHeader(const char* key, std::size_t keySize, const char* value, std::size_t valueSize);
+
         void removeHeader(const char* key);
 
         const char* getHeader(const char* key) const;
 
+        /// Returns the first value of a well known header or 0 if not set.
+        const char* getHeader(HeaderId id) const;
+
         bool hasHeader(const char* key) const
         { return getHeader(key) != 0; }
 
+        bool hasHeader(HeaderId id) const
+        { return getHeader(id) != 0; }
+
         bool isHeaderValue(const char* key, const char* value) const;
+        bool isHeaderValue(HeaderId id, const char* value) const;
 
         const_iterator begin() const
-        { return const_iterator(_rawdata); }
+        { return const_iterator(_entries.data(), _rawdata.data()); }
 
         const_iterator end() const
-        { return const_iterator(); }
+        { return const_iterator(_entries.data() + _entries.size(), _rawdata.data()); }
+
+        /// Returns the number of header fields.
+        unsigned size() const
+        { return _entries.size(); }
+
+        /// Returns the number of bytes used by keys and values.
+        unsigned bytesUsed() const
+        { return _rawdata.size(); }
+
+        /// Returns the maximum number of bytes keys and values may occupy.
+        unsigned maxSize() const
+        { return _maxSize; }
+
+        /// Sets the maximum number of bytes keys and values may occupy.
+        void maxSize(unsigned m)
+        { _maxSize = m; }
+
+        /// Returns the size limit used for newly created headers.
+        static unsigned defaultMaxSize()
+        { return _defaultMaxSize; }
+
+        /// Sets the size limit used for newly created headers.
+        static void defaultMaxSize(unsigned m)
+        { _defaultMaxSize = m; }
+
+        /// Returns the id of a header name or `Unknown` if it is not well known.
+        static HeaderId headerId(const char* key);
 
         unsigned httpVersionMajor() const
         { return _httpVersionMajor; }
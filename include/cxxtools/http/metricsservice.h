@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef cxxtools_Http_MetricsService_h
+#define cxxtools_Http_MetricsService_h
+
+#include <cxxtools/http/service.h>
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+class Server;
+
+/**
+ A service, which renders the request metrics of a http::Server.
+
+ The reply contains the number of requests per route and return code, the
+ requests in flight, the latency histograms of the routes, the time
+ requests waited for a worker thread and the number of rejected requests.
+
+ The metrics are rendered in the Prometheus text format. When the query
+ parameter `format=json` is passed or the Accept header asks for
+ application/json, they are rendered as json.
+
+ Example:
+ \code
+   cxxtools::http::Server server(loop, 8000);
+   cxxtools::http::MetricsService metricsService(server);
+   server.addService("/metrics", metricsService);
+ \endcode
+ */
+class MetricsService : public Service
+{
+        const Server& _server;
+
+    public:
+        explicit MetricsService(const Server& server)
+            : _server(server)
+            { }
+
+    protected:
+        Responder* createResponder(const Request&);
+        void releaseResponder(Responder*);
+};
+
+}
+}
+
+#endif // cxxtools_Http_MetricsService_h
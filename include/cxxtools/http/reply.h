@@ -30,6 +30,7 @@
 #define cxxtools_Http_Reply_h
 
 #include <cxxtools/http/replyheader.h>
+#include <cxxtools/http/bodystream.h>
 #include <string>
 #include <sstream>
 
@@ -42,7 +43,7 @@ class Request;
 class Reply
 {
         ReplyHeader _header;
-        std::stringstream _body;
+        BodyStream _body;
 
     public:
         Reply()
@@ -82,8 +83,7 @@ class Reply
         void clear()
         {
             _header.clear();
-            _body.clear();
-            _body.str(std::string());
+            _body.reset();
         }
 
         unsigned httpReturnCode() const
@@ -98,14 +98,18 @@ class Reply
         std::string body() const
         { return _body.str(); }
 
-        std::stringstream& bodyStream()
+        BodyStream& bodyStream()
         { return _body; }
 
+        /// Returns the body without copying it. The data is not zero terminated.
+        const char* bodyData() const
+        { return _body.data(); }
+
         std::size_t bodySize() const
-        { return _body.str().size(); }
+        { return _body.size(); }
 
         void sendBody(std::ostream& out) const
-        { out << _body.str(); }
+        { out.write(_body.data(), _body.size()); }
 
         operator std::string() const
         { return _body.str(); }
@@ -30,17 +30,33 @@
 #define cxxtools_Http_Request_h
 
 #include <cxxtools/http/requestheader.h>
+#include <cxxtools/http/bodystream.h>
 #include <string>
 #include <sstream>
+#include <vector>
+#include <utility>
 
 namespace cxxtools {
 
 namespace http {
 
+class Mapper;
+class DetachedReplyImpl;
+class WebSocketImpl;
+
 class Request
 {
+        friend class Mapper;
+        friend class DetachedReplyImpl;
+        friend class WebSocketImpl;
+
+    public:
+        typedef std::vector<std::pair<std::string, std::string> > PathParams;
+
+    private:
         RequestHeader _header;
-        std::ostringstream _body;
+        BodyStream _body;
+        PathParams _pathParams;
 
     public:
         struct Auth
@@ -87,8 +103,8 @@ class Request
         void clear()
         {
             _header.clear();
-            _body.clear();
-            _body.str(std::string());
+            _body.reset();
+            _pathParams.clear();
         }
 
         const std::string& url() const
@@ -115,14 +131,25 @@ class Request
         std::ostream& body()
         { return _body; }
 
+        /// Returns the body without copying it. The data is not zero terminated.
+        const char* bodyData() const
+        { return _body.data(); }
+
         std::size_t bodySize() const
-        { return _body.str().size(); }
+        { return _body.size(); }
 
         void sendBody(std::ostream& out) const
-        { out << _body.str(); }
+        { out.write(_body.data(), _body.size()); }
 
         Auth auth() const;
 
+        /// Returns the parameters extracted from the url by a pattern service.
+        const PathParams& pathParams() const
+        { return _pathParams; }
+
+        /// Returns the value of a path parameter or an empty string if not set.
+        const std::string& pathParam(const std::string& name) const;
+
 };
 
 } // namespace http
@@ -63,18 +63,27 @@ class RequestHeader : public MessageHeader
         void url(const std::string& u)
         { _url = u; }
 
+        void url(const char* u, std::size_t n)
+        { _url.assign(u, n); }
+
         const std::string& method() const
         { return _method; }
 
         void method(const std::string& m)
         { _method = m; }
 
+        void method(const char* m, std::size_t n)
+        { _method.assign(m, n); }
+
         const std::string& qparams() const
         { return _qparams; }
 
         void qparams(const std::string& q)
         { _qparams = q; }
 
+        void qparams(const char* q, std::size_t n)
+        { _qparams.assign(q, n); }
+
         std::string query() const
         { return _qparams.empty() ? _url : _url + '?' + _qparams; }
 };
@@ -32,6 +32,7 @@
 #include <cxxtools/http/service.h>
 #include <iosfwd>
 #include <exception>
+#include <functional>
 
 namespace cxxtools
 {
@@ -46,12 +47,15 @@ namespace http
 
 class Request;
 class Reply;
+class DetachedReply;
 
 class Responder
 {
     public:
         explicit Responder(Service& service)
-            : _service(service)
+            : _service(service),
+              _socket(0),
+              _request(0)
         { }
 
         virtual ~Responder() { }
@@ -63,8 +67,30 @@ class Responder
 
         void release()     { _service.doReleaseResponder(this); }
 
+    protected:
+        /** Continues the reply after reply() returned.
+
+            The header and the body written so far are sent, when reply()
+            returns. Further data is sent with the returned object, which
+            may be used from any thread. The worker thread is released while
+            the reply is open. Must be called in reply(). Not supported on
+            http/2 connections.
+         */
+        DetachedReply& detach();
+
+        /** Lets idle worker threads of the server help with the request.
+
+            The job is queued for up to count threads, but not for more than
+            the minimum number of threads of the server. Returns the number
+            of threads, which got the job; outside of http::Server none. A
+            job may run late, even after the reply finished, so it must hold
+            what it needs and the responder must not wait for it.
+         */
+        unsigned queueJob(const std::function<void()>& job, unsigned count);
+
     private:
         Service& _service;
+        net::TcpSocket* _socket;
         Request* _request;
 };
 
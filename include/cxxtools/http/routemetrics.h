@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef cxxtools_Http_RouteMetrics_h
+#define cxxtools_Http_RouteMetrics_h
+
+#include <cxxtools/histogram.h>
+#include <cxxtools/shardedcounters.h>
+#include <cxxtools/timespan.h>
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+namespace cxxtools
+{
+
+class SerializationInfo;
+
+namespace http
+{
+
+/**
+ Request statistics of a route of http::Server.
+
+ A route is a url, prefix, pattern or regular expression passed to one of
+ the addService methods. The server records each request from the time
+ the responder is requested until the reply is ready. Requests, which
+ match no service, are counted in a route with an empty name.
+
+ The values are updated without locks. The request count, the requests in
+ flight, the latency histogram and the counts of common return codes are
+ kept per thread shard (see ShardedCounters), so that workers recording
+ requests of the same route do not contend for cache lines. The metrics of
+ a route are kept, when the service is removed.
+ */
+class RouteMetrics
+{
+        RouteMetrics(const RouteMetrics&) = delete;
+        RouteMetrics& operator=(const RouteMetrics&) = delete;
+
+    public:
+        /// Http return codes from 100 to 599 are counted separately.
+        enum { MinReturnCode = 100, MaxReturnCode = 599 };
+
+        explicit RouteMetrics(const std::string& route);
+
+        /// Returns the route name, i.e. the url as passed to addService.
+        const std::string& route() const
+            { return _route; }
+
+        void requestStarted()
+            { _counters.add(InFlight, 1); }
+
+        void requestFinished(unsigned httpReturnCode, Timespan duration);
+
+        /// A started request ended without a reply, e.g. since the client disconnected.
+        void requestAborted()
+            { _counters.add(InFlight, -1); }
+
+        /// Returns the number of finished requests.
+        uint64_t requests() const
+            { return _latency.count(); }
+
+        /// Returns the number of requests currently processed.
+        int64_t inFlight() const
+            { return _counters.sum(InFlight); }
+
+        /// Returns the number of replies with the passed http return code.
+        uint64_t returnCodeCount(unsigned httpReturnCode) const;
+
+        const Histogram& latency() const
+            { return _latency; }
+
+    private:
+        // sharded counters; the counts of common return codes follow
+        enum { InFlight, ReturnCodes };
+
+        std::string _route;
+        ShardedCounters _counters;
+        // other return codes are rare and counted without shards
+        std::atomic<uint64_t> _returnCodes[MaxReturnCode - MinReturnCode + 1];
+        Histogram _latency;
+};
+
+/// Serializes route, requests, in flight requests, counts per return code and latencies.
+void operator<<= (SerializationInfo& si, const RouteMetrics& metrics);
+
+}
+}
+
+#endif // cxxtools_Http_RouteMetrics_h
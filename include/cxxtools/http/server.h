@@ -33,11 +33,14 @@
 #include <cxxtools/delegate.h>
 #include <cxxtools/timespan.h>
 #include <string>
+#include <vector>
+#include <stdint.h>
 
 namespace cxxtools
 {
 
 class EventLoopBase;
+class Histogram;
 class SslCertificate;
 class SslCtx;
 class Regex;
@@ -46,6 +49,7 @@ namespace http
 {
 
 class Request;
+class RouteMetrics;
 class Service;
 class ServerImplBase;
 
@@ -90,8 +94,31 @@ class Server
         void listen(unsigned short int port)                       { listen(std::string(), port); }
         void listen(unsigned short int port, const SslCtx& sslCtx) { listen(std::string(), port, sslCtx); }
 
+        /** Adds a service for requests, which match the url exactly.
+         *
+         *  Services are tried in the order they were added. The first service,
+         *  which matches the url and returns a responder, handles the request.
+         */
         void addService(const std::string& url, Service& service);
+
+        /// Adds a service for urls matching the regular expression.
         void addService(Regex&& url, Service& service);
+
+        /// Adds a service for all urls starting with prefix.
+        void addPrefixService(const std::string& prefix, Service& service);
+
+        /** Adds a service for urls matching a pattern with path parameters.
+         *
+         *  Parameters are written in braces and are passed in
+         *  Request::pathParams(). `{name}` matches a path segment,
+         *  `{name:int}` a segment of decimal digits and `{name:path}` the rest
+         *  of the url. Example: `/users/{id:int}/orders/{order}`.
+         *
+         *  Exact urls, prefixes and patterns are looked up in a radix tree;
+         *  only regular expressions are matched one by one.
+         */
+        void addPatternService(const std::string& pattern, Service& service);
+
         void removeService(Service& service);
 
         Milliseconds readTimeout() const;
@@ -108,6 +135,78 @@ class Server
         unsigned maxThreads() const;
         void maxThreads(unsigned m);
 
+        /** Maximum number of pipelined requests answered in one go.
+         *
+         *  When a client sends further requests without waiting for the
+         *  replies, the server processes the requests already received and
+         *  collects the replies in the output buffer. After this number of
+         *  replies the output is flushed before the next request is parsed.
+         */
+        unsigned maxPipelinedRequests() const;
+        void maxPipelinedRequests(unsigned n);
+
+        /** Enables or disables http/2 over cleartext tcp (h2c).
+         *
+         *  When enabled, clients may start with the http/2 connection preface
+         *  ("prior knowledge") or upgrade a HTTP/1.1 connection with
+         *  `Upgrade: h2c`. The requests of the streams are passed to the same
+         *  services as http/1 requests. It is enabled by default; ssl
+         *  connections always use HTTP/1.1.
+         *
+         *  A http/2 connection is read by the event loop of the server.
+         *  Each complete request is passed to an idle worker thread, so the
+         *  streams of one connection are answered concurrently and a slow
+         *  responder does not delay the other streams. Detached replies and
+         *  websockets are not available on http/2 connections.
+         */
+        bool http2() const;
+        void http2(bool sw);
+
+        /** Maximum number of requests waiting for a worker thread.
+
+            When all threads are busy, requests of open connections wait in a
+            queue. A request, which exceeds the limit, is answered at once
+            with 503 Service Unavailable and a Retry-After header and the
+            connection is closed. 0 means no limit, which is the default.
+         */
+        unsigned maxQueueSize() const;
+        void maxQueueSize(unsigned n);
+
+        /** Maximum time a request waits for a worker thread.
+
+            Requests, which waited longer, are rejected like requests
+            exceeding maxQueueSize. 0 means no limit, which is the default.
+         */
+        Milliseconds queueTimeout() const;
+        void queueTimeout(Milliseconds ms);
+
+        /** Target queue time of controlled delay (CoDel) dequeueing.
+
+            When the queue did not run empty within 100 ms, the server is
+            considered overloaded. Then the newest request is processed first
+            and requests waiting longer than the target are rejected, so that
+            the latency stays bounded. 0 disables it, which is the default.
+         */
+        Milliseconds queueTarget() const;
+        void queueTarget(Milliseconds ms);
+
+        /// The value of the Retry-After header of rejected requests; default 1 second.
+        Seconds retryAfter() const;
+        void retryAfter(Seconds s);
+
+        /// Returns the times requests waited for a worker thread.
+        const Histogram& queueTimes() const;
+
+        /// Returns the number of requests rejected because of overload.
+        uint64_t rejectedRequests() const;
+
+        /** Returns request counts and latencies per route.
+
+            The metrics are collected for every request, so that no responder
+            needs to record them. See also MetricsService.
+         */
+        std::vector<const RouteMetrics*> routeMetrics() const;
+
         enum Runmode {
           Stopped,
           Starting,
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef cxxtools_Http_UploadResponder_h
+#define cxxtools_Http_UploadResponder_h
+
+#include <cxxtools/http/responder.h>
+#include <cxxtools/mime.h>
+#include <cstdint>
+#include <string>
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+class Request;
+
+/**
+ Receives the body of a request while it arrives.
+
+ The data is passed in pieces as read from the connection. An exception
+ thrown in write or finish rejects the request with "400 Bad Request".
+ */
+class BodySink
+{
+    public:
+        virtual ~BodySink() { }
+
+        /// Receives the next piece of the body.
+        virtual void write(const char* data, std::size_t size) = 0;
+
+        /// Called after the last piece of the body.
+        virtual void finish() { }
+};
+
+/**
+ A body sink, which parses a mime multipart body.
+
+ The parts are passed to a handler as they arrive. The boundary is taken
+ from the content type of the request; requests without a multipart
+ content type are rejected.
+ */
+class MultipartSink : public BodySink
+{
+        MimeMultipartParser _parser;
+
+    public:
+        MultipartSink(const Request& request, MimeMultipartParser::Handler& handler);
+
+        void write(const char* data, std::size_t size)
+            { _parser.parse(data, size); }
+
+        void finish()
+            { _parser.finish(); }
+};
+
+/**
+ A responder, which streams the request body into a sink.
+
+ The default responder collects the body in the request object. This
+ responder passes it to the sink returned by createSink instead, so that
+ large uploads are not held in memory. The size of the body may be
+ limited; larger bodies are rejected with "413 Payload Too Large" as soon
+ as the size is known to exceed the limit.
+
+ The method uploaded is called after the body is passed completely to
+ the sink. The sink is destroyed after the reply.
+
+ Example:
+ \code
+   class FileResponder : public cxxtools::http::UploadResponder
+   {
+     public:
+       explicit FileResponder(cxxtools::http::Service& service)
+         : UploadResponder(service, 1024 * 1024 * 1024)
+         { }
+
+     protected:
+       cxxtools::http::BodySink* createSink(cxxtools::http::Request& request)
+         { return new cxxtools::http::FormUpload(request); }
+
+       void uploaded(std::ostream& out, cxxtools::http::Request& request,
+                     cxxtools::http::Reply& reply, cxxtools::http::BodySink& sink)
+       {
+         cxxtools::http::FormUpload& form = static_cast<cxxtools::http::FormUpload&>(sink);
+         ...
+       }
+   };
+ \endcode
+ */
+class UploadResponder : public Responder
+{
+        std::uint64_t _maxBodySize;
+        std::uint64_t _received;
+        BodySink* _sink;
+        bool _sinkFailed;
+
+        void releaseSink();
+
+    public:
+        /// Creates a responder; a maxBodySize of 0 means no limit.
+        explicit UploadResponder(Service& service, std::uint64_t maxBodySize = 0);
+        ~UploadResponder();
+
+        void beginRequest(net::TcpSocket& socket, std::istream& in, Request& request);
+        std::size_t readBody(std::istream& in);
+        void reply(std::ostream& out, Request& request, Reply& reply);
+        void replyError(std::ostream& out, Request& request, Reply& reply, const std::exception& ex);
+
+        std::uint64_t maxBodySize() const           { return _maxBodySize; }
+        void maxBodySize(std::uint64_t size)        { _maxBodySize = size; }
+
+        /// Returns the number of bytes of the body received so far.
+        std::uint64_t received() const              { return _received; }
+
+    protected:
+        /// Returns a new sink for the body of the request. The responder takes ownership.
+        virtual BodySink* createSink(Request& request) = 0;
+
+        /// Creates the reply after the body was passed to the sink.
+        virtual void uploaded(std::ostream& out, Request& request, Reply& reply, BodySink& sink) = 0;
+};
+
+} // namespace http
+
+} // namespace cxxtools
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef cxxtools_Http_WebSocket_h
+#define cxxtools_Http_WebSocket_h
+
+#include <cxxtools/signal.h>
+#include <string>
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+class Request;
+class WebSocketImpl;
+
+/**
+ A websocket connection accepted by a WebSocketService.
+
+ The connection is driven by the event loop of the server: the signals are
+ sent in the thread running the event loop and no worker thread is held
+ while the connection is open.
+
+ The send methods queue the message and return immediately. They may be
+ called from any thread; when called outside of the event loop, the loop
+ is woken to send the data.
+
+ The object is destroyed by the server after the signal closed was sent
+ and must not be used after that.
+
+ Example:
+ \code
+   void onConnected(cxxtools::http::WebSocket& ws)
+   {
+       cxxtools::connect(ws.textReceived, onText);
+   }
+
+   void onText(cxxtools::http::WebSocket& ws, const std::string& msg)
+   {
+       ws.sendText("echo: " + msg);
+   }
+ \endcode
+ */
+class WebSocket
+{
+        friend class WebSocketImpl;
+
+        WebSocketImpl* _impl;
+
+        explicit WebSocket(WebSocketImpl* impl)
+            : _impl(impl)
+            { }
+
+        WebSocket(const WebSocket&) = delete;
+        WebSocket& operator=(const WebSocket&) = delete;
+
+    public:
+        /// Returns the request, which opened the connection.
+        const Request& request() const;
+
+        /// Returns the subprotocol selected in the handshake or an empty string.
+        const std::string& protocol() const;
+
+        std::string peerAddr() const;
+
+        /// Returns true, when permessage-deflate was negotiated.
+        bool compressed() const;
+
+        void sendText(const std::string& message);
+        void sendBinary(const std::string& data);
+        void sendBinary(const char* data, std::size_t size);
+
+        /// Sends a ping; the answer is reported with pongReceived.
+        void ping(const std::string& payload = std::string());
+
+        /** Starts the closing handshake.
+            The connection is closed when the peer acknowledges or after the
+            write timeout of the server.
+         */
+        void close(unsigned short code = 1000, const std::string& reason = std::string());
+
+        /// Returns false, when the connection is closing or closed.
+        bool isOpen() const;
+
+        /// Returns the number of bytes queued and not sent yet.
+        std::size_t outputPending() const;
+
+        Signal<WebSocket&, const std::string&> textReceived;
+        Signal<WebSocket&, const std::string&> binaryReceived;
+        Signal<WebSocket&, const std::string&> pongReceived;
+
+        /// Signals the end of the connection with the status code of the peer.
+        /// When the connection was lost without closing handshake, the code is 1006.
+        Signal<WebSocket&, unsigned short> closed;
+};
+
+} // namespace http
+
+} // namespace cxxtools
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef cxxtools_Http_WebSocketService_h
+#define cxxtools_Http_WebSocketService_h
+
+#include <cxxtools/http/service.h>
+#include <cxxtools/http/websocket.h>
+#include <cxxtools/signal.h>
+#include <string>
+#include <vector>
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+/**
+ A service, which upgrades requests to websocket connections (RFC 6455).
+
+ The service answers the opening handshake. After the handshake is sent,
+ the connection is passed to the event loop of the server and the signal
+ connected is sent there. Requests without a valid handshake are answered
+ with an error.
+
+ When the library is built with zlib, the permessage-deflate extension
+ (RFC 7692) is negotiated when the client offers it.
+
+ Example:
+ \code
+   cxxtools::http::WebSocketService ws;
+   cxxtools::connect(ws.connected, onConnected);
+   server.addService("/events", ws);
+ \endcode
+ */
+class WebSocketService : public Service
+{
+        std::vector<std::string> _protocols;
+        std::size_t _maxMessageSize;
+        bool _deflate;
+
+    public:
+        WebSocketService()
+            : _maxMessageSize(1024 * 1024),
+              _deflate(true)
+            { }
+
+        /** Adds a supported subprotocol.
+            The first protocol offered by the client in Sec-WebSocket-Protocol,
+            which is supported, is selected.
+         */
+        void addProtocol(const std::string& protocol)
+            { _protocols.push_back(protocol); }
+        const std::vector<std::string>& protocols() const
+            { return _protocols; }
+
+        /// Messages exceeding this size close the connection with status 1009.
+        std::size_t maxMessageSize() const      { return _maxMessageSize; }
+        void maxMessageSize(std::size_t s)      { _maxMessageSize = s; }
+
+        /// Enables or disables the negotiation of permessage-deflate.
+        bool deflate() const                    { return _deflate; }
+        void deflate(bool sw)                   { _deflate = sw; }
+
+        /// Signals a new connection in the thread of the event loop.
+        Signal<WebSocket&> connected;
+
+    protected:
+        Responder* createResponder(const Request&);
+        void releaseResponder(Responder*);
+};
+
+} // namespace http
+
+} // namespace cxxtools
+
+#endif
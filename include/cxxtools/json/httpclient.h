@@ -156,6 +156,15 @@ namespace json
 
             void cancel();
 
+            void cancelCall(const IRemoteProcedure& proc);
+
+            /// Starts collecting calls into a JSON-RPC 2.0 batch request, which
+            /// is posted in one http request by endBatch().
+            /// See RpcClient::beginBatch() for details.
+            void beginBatch();
+
+            void endBatch();
+
             void wait(Milliseconds msecs = WaitInfinite);
 
         private:
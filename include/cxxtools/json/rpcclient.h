@@ -161,6 +161,27 @@ class RpcClient : public RemoteClient
 
         void cancel();
 
+        void cancelCall(const IRemoteProcedure& proc);
+
+        /** Starts collecting calls into a JSON-RPC 2.0 batch request.
+
+            The procedures started with begin() up to endBatch() are sent
+            together in one request. The server executes them in parallel
+            and each procedure is finished individually when the reply
+            arrives. Like other asynchronous calls this needs a selector.
+
+            \code
+              client.beginBatch();
+              for (unsigned n = 0; n < keys.size(); ++n)
+                  lookups[n]->begin(keys[n]);
+              client.endBatch();
+            \endcode
+         */
+        void beginBatch();
+
+        /// Sends the batch started with beginBatch().
+        void endBatch();
+
         void wait(Milliseconds msecs = WaitInfinite);
 
         const std::string& prefix() const;
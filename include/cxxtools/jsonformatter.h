@@ -66,6 +66,9 @@ namespace cxxtools
             virtual void addValueStdString(const std::string& name, const std::string& type,
                                   std::string&& value);
 
+            virtual void addValueStdString(const std::string& name, const std::string& type,
+                                  const std::string& value);
+
             virtual void addValueBool(const std::string& name, const std::string& type,
                                   bool value);
 
@@ -262,6 +262,71 @@ class MimeMultipart : public MimeHeader
 
 };
 
+/** Parses a mime multipart body incrementally.
+
+    The body is passed in pieces of any size as it arrives, e.g. while an
+    upload is read from a socket. The parts are not collected but passed to
+    a handler, so that large bodies are never held in memory completely.
+
+    The content transfer encoding of the parts is not decoded.
+ */
+class MimeMultipartParser
+{
+    public:
+        /// Receives the parts found by the parser.
+        class Handler
+        {
+            public:
+                virtual ~Handler() { }
+
+                /// A part starts. The header is valid until the next part starts.
+                virtual void onPartBegin(const MimeHeader& header) = 0;
+                /// Body data of the current part. May be called multiple times per part.
+                virtual void onPartData(const char* data, std::size_t size) = 0;
+                /// The current part is complete.
+                virtual void onPartEnd() = 0;
+        };
+
+    private:
+        enum State {
+            state_preamble,
+            state_boundary,
+            state_header,
+            state_body,
+            state_epilogue
+        };
+
+        Handler& _handler;
+        std::string _delimiter;
+        std::string _buffer;
+        State _state;
+        MimeHeader _header;
+
+        bool process();
+
+    public:
+        /// Maximum size of the header of a single part.
+        static const std::size_t maxHeaderSize = 16384;
+
+        /// Creates a parser for a body with the content type passed.
+        /// If the content type has no boundary, an exception is thrown.
+        MimeMultipartParser(Handler& handler, const std::string& contentType);
+
+        /// Parses the next piece of the body.
+        void parse(const char* data, std::size_t size);
+
+        /// Signals the end of the body. Throws an exception when the
+        /// closing boundary was not found.
+        void finish();
+
+        /// Returns true, when the closing boundary was found.
+        bool end() const
+            { return _state == state_epilogue; }
+
+        /// Returns the boundary of a multipart content type or an empty string.
+        static std::string boundary(const std::string& contentType);
+};
+
 std::ostream& operator<< (std::ostream& out, const MimeHeader& mimeHeader);
 std::ostream& operator<< (std::ostream& out, const MimeEntity& mimeEntity);
 std::ostream& operator<< (std::ostream& out, const MimeMultipart& mime);
@@ -37,6 +37,10 @@
 #include <iostream>
 #include <iterator>
 
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
 namespace cxxtools
 {
 
@@ -52,6 +56,11 @@ class SerializationInfo;
 
  The class has a parser to extract parameters from a std::string or from a
  input-stream.
+
+ Long query strings, where only a few parameters are read, are better
+ parsed with parse_url_lazy. It just indexes the query string and decodes
+ a parameter, when it is accessed. Parameters are found by a hash of their
+ name. All parameters are decoded, when the parameters are modified.
  */
 class QueryParams
 {
@@ -179,8 +188,44 @@ class QueryParams
     };
 
   private:
+    // A parameter of a lazily parsed query string. The name is decoded when
+    // the query string is indexed, the value when it is accessed.
+    struct Span
+    {
+      std::string name;
+      std::size_t hash;
+      std::string::size_type value;
+      std::string::size_type valueSize;
+      size_type next;           // next parameter in the same hash bucket + 1
+      bool escaped;             // value needs decoding
+      mutable bool decoded;
+      mutable std::string decodedValue;
+    };
+
     values_type _values;
 
+    std::string _query;
+    std::vector<Span> _spans;
+    std::vector<size_type> _buckets;    // first parameter in the bucket + 1
+
+    size_type count() const
+    { return _spans.empty() ? _values.size() : _spans.size(); }
+
+    const std::string& nameAt(size_type n) const
+    { return _spans.empty() ? _values[n].name : _spans[n].name; }
+
+    const std::string& valueAt(size_type n) const;
+
+    // finds the nth parameter with the name; returns its index or count()
+    size_type find(const char* name, std::string::size_type nameSize, size_type n) const;
+
+    void valueAt(size_type n, const char*& value, std::string::size_type& valueSize) const;
+
+    void materialize()
+    { if (!_spans.empty()) decodeAll(); }
+
+    void decodeAll();
+
   public:
     /// default constructor
     QueryParams()
@@ -203,6 +248,11 @@ class QueryParams
     /// read parameters from stream
     void parse_url(std::istream& url_stream);
 
+    /// Reads parameters from url without decoding them. The url is kept
+    /// and the parameters are decoded, when they are accessed. Since
+    /// reading decodes, concurrent readers need to be synchronized.
+    void parse_url_lazy(std::string url);
+
     //
     // unnamed parameter
     //
@@ -222,6 +272,7 @@ class QueryParams
     /// add unnamed parameter
     QueryParams& add(const std::string& value)
     {
+      materialize();
       _values.push_back(value_type(std::string(), value));
       return *this;
     }
@@ -254,6 +305,23 @@ class QueryParams
     std::string param(const std::string& name, const std::string& def) const
     { return param(name, 0, def); }
 
+#if __cplusplus >= 201703L
+    /// Returns the nth named parameter or an empty view. The view is valid
+    /// until the parameters are modified. Values of a lazily parsed url
+    /// point into the url, when they need no decoding.
+    std::string_view param_view(std::string_view name, size_type n = 0) const
+    {
+      size_type idx = find(name.data(), name.size(), n);
+      if (idx >= count())
+        return std::string_view();
+
+      const char* value;
+      std::string::size_type valueSize;
+      valueAt(idx, value, valueSize);
+      return std::string_view(value, valueSize);
+    }
+#endif
+
     /// get number of parameters with the given name
     size_type paramcount(const std::string& name) const;
 
@@ -267,6 +335,7 @@ class QueryParams
     /// add named parameter
     QueryParams& add(const std::string& name, const std::string& value)
     {
+      materialize();
       _values.push_back(value_type(name, value));
       return *this;
     }
@@ -284,7 +353,9 @@ class QueryParams
 
     QueryParams& add(const QueryParams& other)
     {
-      _values.insert(_values.end(), other._values.begin(), other._values.end());
+      materialize();
+      for (size_type n = 0; n < other.count(); ++n)
+        _values.push_back(value_type(other.nameAt(n), other.valueAt(n)));
       return *this;
     }
 
@@ -292,17 +363,22 @@ class QueryParams
     template <typename output_iterator>
     void getNames(output_iterator o) const
     {
-      for (values_type::const_iterator i = _values.begin(); i != _values.end(); ++i)
-        *o++ = (*i).name;
+      for (size_type n = 0; n < count(); ++n)
+        *o++ = nameAt(n);
     }
 
     /// removes all data
     void clear()
-    { _values.clear(); }
+    {
+      _values.clear();
+      _query.clear();
+      _spans.clear();
+      _buckets.clear();
+    }
 
     /// returns true, when no parameters exist (named and unnamed)
     bool empty() const
-    { return _values.empty(); }
+    { return _values.empty() && _spans.empty(); }
 
     //
     // iterator-methods
@@ -43,6 +43,7 @@ namespace cxxtools
   class Regex
   {
       std::unique_ptr<regex_t, decltype(&regfree)> expr;
+      std::string _pattern;
 
       void checkerr(int ret) const;
 
@@ -60,6 +61,7 @@ namespace cxxtools
         {
           expr.reset(new regex_t());
           checkerr(::regcomp(expr.get(), ex, cflags));
+          _pattern = ex;
         }
       }
 
@@ -71,6 +73,7 @@ namespace cxxtools
         {
           expr.reset(new regex_t());
           checkerr(::regcomp(expr.get(), ex.c_str(), cflags));
+          _pattern = ex;
         }
       }
 
@@ -93,10 +96,13 @@ namespace cxxtools
       std::string subst(const std::string& str, const std::string& expr, bool all = true);
 
       /// Destroys the regular expression. This is normally done by the destructor.
-      void free()  { expr = 0; }
+      void free()  { expr = 0; _pattern.clear(); }
 
       /// Returns true, if the object does not have a valid regular expression.
       bool empty() const    { return !expr; }
+
+      /// Returns the regular expression as passed to the constructor.
+      const std::string& pattern() const  { return _pattern; }
   };
 
   /// collects matches in a regex
@@ -58,6 +58,15 @@ namespace cxxtools
 
             virtual void cancel() = 0;
 
+            /// Cancels the call of the procedure, if it is still running.
+            /// Clients, which run more than one call at a time, cancel just this
+            /// call; the default cancels the active call.
+            virtual void cancelCall(const IRemoteProcedure& proc)
+            {
+                if (activeProcedure() == &proc)
+                    cancel();
+            }
+
             virtual void wait(Milliseconds msecs = WaitInfinite) = 0;
 
             virtual Milliseconds timeout() const = 0;
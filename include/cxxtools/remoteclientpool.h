@@ -0,0 +1,543 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_REMOTECLIENTPOOL_H
+#define CXXTOOLS_REMOTECLIENTPOOL_H
+
+#include <cxxtools/net/uri.h>
+#include <cxxtools/ioerror.h>
+#include <cxxtools/timespan.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace cxxtools
+{
+/// Creates rpc clients for a endpoint, which is passed as a uri like "bin://host:7002/".
+template <typename ClientType>
+class DefaultRemoteClientCreator
+{
+public:
+    ClientType* operator() (const std::string& endpoint)
+    { return new ClientType(net::Uri(endpoint)); }
+};
+
+/**
+ A thread safe pool of connected rpc clients.
+
+ The rpc clients (`bin::RpcClient`, `json::RpcClient`, `json::HttpClient`,
+ `xmlrpc::HttpClient`) run one call at a time and are not thread safe. The
+ pool lends a connected client to one thread per call and takes it back,
+ when the returned `Ptr` is destroyed.
+
+ Idle clients are reused, most recently used first. Clients idle longer
+ than the idle timeout are closed. The number of connections to one
+ endpoint is limited; when all are lent, `get` waits for the next one.
+
+ Clients, which were idle for longer than the health check interval, are
+ checked with the health check function before they are lent. When a
+ connect fails, the endpoint is not tried again before a backoff time,
+ which starts with `minBackoff` and doubles with each failure up to
+ `maxBackoff`. Meanwhile `get` fails right away.
+
+ A client, on which a call failed, should be passed back with
+ `Ptr::invalidate`, so that it is closed instead of reused.
+
+ The pool must outlive the clients lent from it.
+
+ Example:
+ \code
+   cxxtools::RemoteClientPool<cxxtools::bin::RpcClient> pool;
+
+   // in any thread:
+   auto client = pool.get("bin://localhost:7002/");
+   cxxtools::RemoteProcedure<int, int, int> add(*client, "add");
+   try
+   {
+     int sum = add(1, 2);
+   }
+   catch (const cxxtools::IOError&)
+   {
+     client.invalidate();
+     throw;
+   }
+ \endcode
+ */
+template <typename ClientType,
+          typename CreatorType = DefaultRemoteClientCreator<ClientType>>
+class RemoteClientPool
+{
+    typedef std::chrono::steady_clock SteadyClock;
+
+    struct Idle
+    {
+        Idle(ClientType* client_, SteadyClock::time_point since_)
+            : client(client_),
+              since(since_)
+            { }
+
+        std::unique_ptr<ClientType> client;
+        SteadyClock::time_point since;
+    };
+
+    struct Endpoint
+    {
+        Endpoint()
+            : connections(0),
+              failures(0)
+            { }
+
+        std::vector<Idle> idle;         // most recently used last
+        unsigned connections;           // lent, idle and connecting clients
+        unsigned failures;              // connect failures in a row
+        SteadyClock::time_point retryAt;
+        std::string lastError;
+    };
+
+    typedef std::vector<std::unique_ptr<ClientType>> Clients;
+
+    RemoteClientPool(const RemoteClientPool&) = delete;
+    RemoteClientPool& operator=(const RemoteClientPool&) = delete;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _released;
+    std::map<std::string, Endpoint> _endpoints;
+    CreatorType _creator;
+    std::function<bool (ClientType&)> _healthCheck;
+
+    unsigned _maxConnectionsPerEndpoint;
+    Milliseconds _idleTimeout;
+    Milliseconds _healthCheckInterval;
+    Milliseconds _minBackoff;
+    Milliseconds _maxBackoff;
+
+    uint64_t _requests;
+    uint64_t _hits;
+    uint64_t _connectionsOpened;
+    uint64_t _connectFailures;
+    uint64_t _healthCheckFailures;
+    SteadyClock::duration _waitTime;
+
+    static SteadyClock::duration toDuration(const Timespan& ts)
+    { return std::chrono::microseconds(ts.totalUSecs()); }
+
+    // Moves the clients idle longer than the idle timeout to `evicted`.
+    void evictIdle(SteadyClock::time_point now, Clients& evicted)
+    {
+        auto limit = now - toDuration(_idleTimeout);
+        for (auto& ep : _endpoints)
+        {
+            std::vector<Idle>& idle = ep.second.idle;
+            auto it = idle.begin();
+            while (it != idle.end() && it->since < limit)
+                ++it;
+
+            for (auto i = idle.begin(); i != it; ++i)
+                evicted.emplace_back(std::move(i->client));
+
+            ep.second.connections -= static_cast<unsigned>(it - idle.begin());
+            idle.erase(idle.begin(), it);
+        }
+    }
+
+    SteadyClock::duration backoff(unsigned failures) const
+    {
+        int64_t us = _minBackoff.totalUSecs();
+        while (--failures > 0 && us < _maxBackoff.totalUSecs())
+            us *= 2;
+        return std::chrono::microseconds(std::min(us, _maxBackoff.totalUSecs()));
+    }
+
+    void release(Endpoint* endpoint, ClientType* client, bool invalid)
+    {
+        std::unique_ptr<ClientType> discard;
+        Clients evicted;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto now = SteadyClock::now();
+
+            if (invalid)
+            {
+                discard.reset(client);
+                --endpoint->connections;
+            }
+            else
+                endpoint->idle.emplace_back(client, now);
+
+            evictIdle(now, evicted);
+        }
+
+        _released.notify_all();
+    }
+
+public:
+    /// A client lent from the pool; it is given back, when the Ptr is destroyed.
+    class Ptr
+    {
+        friend class RemoteClientPool;
+
+        RemoteClientPool* _pool;
+        Endpoint* _endpoint;
+        ClientType* _client;
+        bool _invalid;
+
+        Ptr(RemoteClientPool* pool, Endpoint* endpoint, ClientType* client)
+            : _pool(pool),
+              _endpoint(endpoint),
+              _client(client),
+              _invalid(false)
+            { }
+
+    public:
+        Ptr()
+            : _pool(0),
+              _endpoint(0),
+              _client(0),
+              _invalid(false)
+            { }
+
+        Ptr(Ptr&& p)
+            : _pool(p._pool),
+              _endpoint(p._endpoint),
+              _client(p._client),
+              _invalid(p._invalid)
+            { p._client = 0; }
+
+        Ptr& operator=(Ptr&& p)
+        {
+            if (this != &p)
+            {
+                release();
+                _pool = p._pool;
+                _endpoint = p._endpoint;
+                _client = p._client;
+                _invalid = p._invalid;
+                p._client = 0;
+            }
+            return *this;
+        }
+
+        ~Ptr()
+        { release(); }
+
+        ClientType& operator* () const      { return *_client; }
+        ClientType* operator-> () const     { return _client; }
+        ClientType* get() const             { return _client; }
+        explicit operator bool() const      { return _client != 0; }
+
+        /// Marks the client as broken; it is closed instead of given back to the pool.
+        void invalidate()                   { _invalid = true; }
+
+        /// Gives the client back to the pool.
+        void release()
+        {
+            if (_client)
+            {
+                ClientType* client = _client;
+                _client = 0;
+                _pool->release(_endpoint, client, _invalid);
+            }
+        }
+    };
+
+    explicit RemoteClientPool(const CreatorType& creator = CreatorType())
+        : _creator(creator),
+          _maxConnectionsPerEndpoint(8),
+          _idleTimeout(10000),
+          _healthCheckInterval(1000),
+          _minBackoff(100),
+          _maxBackoff(10000),
+          _requests(0),
+          _hits(0),
+          _connectionsOpened(0),
+          _connectFailures(0),
+          _healthCheckFailures(0),
+          _waitTime(0)
+        { }
+
+    /** Lends a connected client for the endpoint.
+
+        When the limit of connections to the endpoint is reached, the method
+        waits until another thread gives a client back. When the endpoint
+        is in backoff after a failed connect, a IOError is thrown.
+     */
+    Ptr get(const std::string& endpoint)
+    { return lend(endpoint, 0); }
+
+    /// Like get(endpoint) but throws IOTimeout, when no client gets free within the timeout.
+    Ptr get(const std::string& endpoint, Milliseconds timeout)
+    {
+        SteadyClock::time_point deadline = SteadyClock::now() + toDuration(timeout);
+        return lend(endpoint, &deadline);
+    }
+
+    /// Maximum number of connections to one endpoint; default 8.
+    unsigned maxConnectionsPerEndpoint() const
+    { std::lock_guard<std::mutex> lock(_mutex); return _maxConnectionsPerEndpoint; }
+
+    void maxConnectionsPerEndpoint(unsigned n)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _maxConnectionsPerEndpoint = n > 0 ? n : 1;
+        }
+        _released.notify_all();
+    }
+
+    /// Time after which an idle client is closed; default 10 seconds.
+    Milliseconds idleTimeout() const
+    { std::lock_guard<std::mutex> lock(_mutex); return _idleTimeout; }
+
+    void idleTimeout(Milliseconds ms)
+    { std::lock_guard<std::mutex> lock(_mutex); _idleTimeout = ms; }
+
+    /** Sets a function, which checks a idle client before it is lent.
+
+        The function typically calls a cheap procedure on the server and
+        returns false or throws, when the client is not usable any more.
+     */
+    void healthCheck(const std::function<bool (ClientType&)>& fn)
+    { std::lock_guard<std::mutex> lock(_mutex); _healthCheck = fn; }
+
+    /// Clients used within this time are lent without health check; default 1 second.
+    Milliseconds healthCheckInterval() const
+    { std::lock_guard<std::mutex> lock(_mutex); return _healthCheckInterval; }
+
+    void healthCheckInterval(Milliseconds ms)
+    { std::lock_guard<std::mutex> lock(_mutex); _healthCheckInterval = ms; }
+
+    /// Time to wait after the first failed connect to a endpoint; default 100 ms.
+    Milliseconds minBackoff() const
+    { std::lock_guard<std::mutex> lock(_mutex); return _minBackoff; }
+
+    void minBackoff(Milliseconds ms)
+    { std::lock_guard<std::mutex> lock(_mutex); _minBackoff = ms; }
+
+    /// Maximum time to wait before the next connect to a failing endpoint; default 10 seconds.
+    Milliseconds maxBackoff() const
+    { std::lock_guard<std::mutex> lock(_mutex); return _maxBackoff; }
+
+    void maxBackoff(Milliseconds ms)
+    { std::lock_guard<std::mutex> lock(_mutex); _maxBackoff = ms; }
+
+    /// Closes all idle clients.
+    void closeIdle()
+    {
+        Clients evicted;
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto& ep : _endpoints)
+        {
+            for (auto& idle : ep.second.idle)
+                evicted.emplace_back(std::move(idle.client));
+            ep.second.connections -= static_cast<unsigned>(ep.second.idle.size());
+            ep.second.idle.clear();
+        }
+    }
+
+    /// Returns the number of calls to get.
+    uint64_t requests() const
+    { std::lock_guard<std::mutex> lock(_mutex); return _requests; }
+
+    /// Returns the number of calls to get, which got a idle client.
+    uint64_t hits() const
+    { std::lock_guard<std::mutex> lock(_mutex); return _hits; }
+
+    /// Returns the ratio of hits to requests.
+    double hitRate() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _requests == 0 ? 0.0 : static_cast<double>(_hits) / static_cast<double>(_requests);
+    }
+
+    /// Returns the number of clients connected by the pool.
+    uint64_t connectionsOpened() const
+    { std::lock_guard<std::mutex> lock(_mutex); return _connectionsOpened; }
+
+    /// Returns the number of failed connects.
+    uint64_t connectFailures() const
+    { std::lock_guard<std::mutex> lock(_mutex); return _connectFailures; }
+
+    /// Returns the number of idle clients, which failed the health check.
+    uint64_t healthCheckFailures() const
+    { std::lock_guard<std::mutex> lock(_mutex); return _healthCheckFailures; }
+
+    /// Returns the total time, which callers of get waited for a client.
+    Milliseconds waitTime() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return Microseconds(std::chrono::duration_cast<std::chrono::microseconds>(_waitTime).count());
+    }
+
+    /// Returns the number of clients lent out.
+    unsigned activeConnections() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        unsigned n = 0;
+        for (auto& ep : _endpoints)
+            n += ep.second.connections - static_cast<unsigned>(ep.second.idle.size());
+        return n;
+    }
+
+    /// Returns the number of connected clients waiting in the pool.
+    unsigned idleConnections() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        unsigned n = 0;
+        for (auto& ep : _endpoints)
+            n += static_cast<unsigned>(ep.second.idle.size());
+        return n;
+    }
+
+    CreatorType& getCreator()
+    { return _creator; }
+
+    const CreatorType& getCreator() const
+    { return _creator; }
+
+private:
+    // Lends a client; without a deadline it waits as long as needed.
+    Ptr lend(const std::string& endpoint, const SteadyClock::time_point* deadline)
+    {
+        Clients evicted;
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        auto start = SteadyClock::now();
+        Endpoint& ep = _endpoints[endpoint];
+        ++_requests;
+
+        while (true)
+        {
+            auto now = SteadyClock::now();
+            evictIdle(now, evicted);
+
+            if (!ep.idle.empty())
+            {
+                Idle idle = std::move(ep.idle.back());
+                ep.idle.pop_back();
+                _waitTime += now - start;
+
+                if (!_healthCheck
+                    || now - idle.since < toDuration(_healthCheckInterval))
+                {
+                    ++_hits;
+                    return Ptr(this, &ep, idle.client.release());
+                }
+
+                // run the health check without holding the lock
+                lock.unlock();
+                evicted.clear();
+
+                bool healthy;
+                try
+                {
+                    healthy = _healthCheck(*idle.client);
+                }
+                catch (const std::exception&)
+                {
+                    healthy = false;
+                }
+
+                if (healthy)
+                {
+                    lock.lock();
+                    ++_hits;
+                    return Ptr(this, &ep, idle.client.release());
+                }
+
+                idle.client.reset();
+                lock.lock();
+                --ep.connections;
+                ++_healthCheckFailures;
+                start = SteadyClock::now();
+                continue;
+            }
+
+            if (ep.connections < _maxConnectionsPerEndpoint)
+            {
+                if (ep.failures > 0 && now < ep.retryAt)
+                    throw IOError("rpc endpoint " + endpoint + " not available: " + ep.lastError);
+
+                _waitTime += now - start;
+                ++ep.connections;
+
+                // connect without holding the lock; the connection is
+                // counted already, so that the limit is kept
+                lock.unlock();
+                evicted.clear();
+
+                std::unique_ptr<ClientType> client;
+                try
+                {
+                    client.reset(_creator(endpoint));
+                    client->connect();
+                }
+                catch (const std::exception& e)
+                {
+                    client.reset();
+                    lock.lock();
+                    --ep.connections;
+                    ++ep.failures;
+                    ++_connectFailures;
+                    ep.retryAt = SteadyClock::now() + backoff(ep.failures);
+                    ep.lastError = e.what();
+                    lock.unlock();
+                    _released.notify_all();
+                    throw;
+                }
+
+                lock.lock();
+                ep.failures = 0;
+                ++_connectionsOpened;
+                return Ptr(this, &ep, client.release());
+            }
+
+            if (deadline == 0)
+                _released.wait(lock);
+            else if (_released.wait_until(lock, *deadline) == std::cv_status::timeout
+                && ep.idle.empty() && ep.connections >= _maxConnectionsPerEndpoint)
+            {
+                _waitTime += SteadyClock::now() - start;
+                throw IOTimeout();
+            }
+        }
+    }
+};
+
+}
+
+#endif // CXXTOOLS_REMOTECLIENTPOOL_H
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CXXTOOLS_RPCCONTEXT_H
+#define CXXTOOLS_RPCCONTEXT_H
+
+#include <cxxtools/remoteclient.h>
+#include <cxxtools/timespan.h>
+#include <atomic>
+#include <chrono>
+
+namespace cxxtools
+{
+
+/** Deadline and cancellation state of a remote procedure call.
+
+    The binary and json rpc servers run each procedure with a context, which
+    is returned by `RpcContext::current()` in the procedure. When the client
+    sent a deadline, the server does not start calls, which have expired in
+    the queue, and the procedure may check `cancelled()` to stop early. The
+    context of a multiplexed binary rpc call is also cancelled, when the
+    client disconnects.
+
+    Rpc clients send the remaining time of the current context with their
+    requests, so that a nested call inherits the deadline of the call, which
+    it runs in. A client, which is not called in a procedure, sets a deadline
+    with a Scope:
+
+    \code
+      cxxtools::RpcContext context(cxxtools::Milliseconds(500));
+      cxxtools::RpcContext::Scope scope(context);
+      int result = proc(1, 2);    // the server gives up after 500 ms
+    \endcode
+
+    Requests are sent as before, when there is no deadline. The binary rpc
+    client asks the server with the request "cxxtools.deadline" first, so
+    that servers, which do not know deadlines, get the requests without.
+ */
+class RpcContext
+{
+        RpcContext(const RpcContext&) = delete;
+        RpcContext& operator=(const RpcContext&) = delete;
+
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        /// Creates a context without deadline.
+        RpcContext()
+            : _deadline(Clock::time_point::max()),
+              _cancelled(false)
+            { }
+
+        explicit RpcContext(Clock::time_point deadline)
+            : _deadline(deadline),
+              _cancelled(false)
+            { }
+
+        /// Creates a context with a deadline `timeout` from now; negative means none.
+        explicit RpcContext(Milliseconds timeout);
+
+        bool hasDeadline() const
+            { return _deadline != Clock::time_point::max(); }
+
+        Clock::time_point deadline() const
+            { return _deadline; }
+
+        /// Returns the time left until the deadline or RemoteClient::WaitInfinite without one.
+        Milliseconds remaining() const;
+
+        bool expired() const
+            { return hasDeadline() && Clock::now() >= _deadline; }
+
+        /// Marks the call as cancelled; may be called from any thread.
+        void cancel()
+            { _cancelled = true; }
+
+        /// Returns true, when the call was cancelled or the deadline has passed.
+        bool cancelled() const
+            { return _cancelled || expired(); }
+
+        /// Throws a RemoteException, when the call is cancelled.
+        void check() const;
+
+        /// Returns the context of the call running in this thread or 0.
+        static RpcContext* current();
+
+        /// Makes a context current for the lifetime of the scope.
+        class Scope
+        {
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+
+                RpcContext* _previous;
+
+            public:
+                explicit Scope(RpcContext& context);
+                ~Scope();
+        };
+
+        /// Error code of the RemoteException thrown for cancelled calls.
+        static const int Cancelled = -32001;
+
+    private:
+        Clock::time_point _deadline;
+        std::atomic<bool> _cancelled;
+};
+
+}
+
+#endif // CXXTOOLS_RPCCONTEXT_H
@@ -31,17 +31,31 @@
 
 #include <cxxtools/composer.h>
 #include <cxxtools/decomposer.h>
+#include <cxxtools/asyncreply.h>
+#include <cxxtools/streamwriter.h>
 #include <cxxtools/void.h>
+#include <condition_variable>
+#include <exception>
 #include <functional>
+#include <mutex>
+#include <tuple>
 #include <utility>
 #include <type_traits>
+#include <vector>
 
 
 namespace cxxtools
 {
 
+class ServiceProcedurePool;
+
 class ServiceProcedure
 {
+        friend class ServiceProcedurePool;
+
+        // the pool, which the procedure is released to after a call
+        ServiceProcedurePool* _pool = nullptr;
+
     public:
         ServiceProcedure() = default;
         virtual ~ServiceProcedure() = default;
@@ -55,10 +69,281 @@ class ServiceProcedure
         virtual IComposers* beginCall(const std::string& function) = 0;
 
         virtual IDecomposer* endCall() = 0;
+
+        /// Returns true, when the procedure replies asynchronously; see executeAsync.
+        virtual bool async() const
+            { return false; }
+
+        /** Runs the procedure after beginCall without waiting for the result.
+
+            The callback `done` is called, possibly from another thread, when
+            the result is there. endCall returns it then or throws the error.
+            The default runs nothing and calls `done` right away, so that
+            endCall runs the procedure.
+         */
+        virtual void executeAsync(const std::function<void()>& done)
+            { done(); }
+
+        /// Returns true, when the procedure produces its result as a stream; see executeStream.
+        virtual bool streaming() const
+            { return false; }
+
+        /** Runs the procedure after beginCall and passes the result to `sink`.
+
+            A streaming procedure writes each element to the sink, when it is
+            produced. The default passes the result of endCall as a single
+            element.
+         */
+        virtual void executeStream(IStreamSink& sink)
+            { sink.write(*endCall()); }
 };
 
 #include <cxxtools/serviceprocedure.tpp>
 
+// A procedure, which gets a AsyncReply as first parameter and returns the
+// result through it. Servers, which run procedures asynchronously, release
+// the thread meanwhile; other servers wait in endCall.
+template <typename R, typename... A>
+class AsyncServiceProcedure : public ServiceProcedure
+{
+        template <typename T>
+        using Value = typename std::remove_cv_t<std::remove_reference_t<T>>;
+
+        typedef typename AsyncReply<R>::value_type RV;
+        typedef typename AsyncReply<R>::State State;
+
+    public:
+        typedef std::function<void (AsyncReply<R>, A...)> Callback;
+
+        explicit AsyncServiceProcedure(const Callback& cb)
+        : ServiceProcedure(),
+          _cb(cb),
+          _composers(_args, sizeof...(A)),
+          _started(false)
+        {
+            initArgs(std::index_sequence_for<A...>());
+        }
+
+        ServiceProcedure* clone() const override
+        {
+            return new AsyncServiceProcedure(_cb);
+        }
+
+        IComposers* beginCall(const std::string&) override
+        {
+            _state.reset();
+            beginArgs(std::index_sequence_for<A...>());
+            _composers.begin();
+            return &_composers;
+        }
+
+        bool async() const override
+        {
+            return true;
+        }
+
+        void executeAsync(const std::function<void()>& done) override
+        {
+            _started = true;
+
+            // done may pass the procedure to another call, which replaces
+            // _state, so the state of this call is kept here
+            auto state = std::make_shared<State>(done);
+            _state = state;
+
+            try
+            {
+                invoke(AsyncReply<R>(state), std::index_sequence_for<A...>());
+            }
+            catch (...)
+            {
+                state->fail(std::current_exception());
+            }
+
+            // done is called here at the earliest, so that the caller need
+            // not care about a reply set while the handler runs
+            state->release();
+        }
+
+        IDecomposer* endCall() override
+        {
+            if (!_started)
+            {
+                // the server does not run the procedure asynchronously
+                std::mutex mutex;
+                std::condition_variable finished;
+                bool ready = false;
+
+                executeAsync([&] () {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ready = true;
+                    finished.notify_one();
+                });
+
+                std::unique_lock<std::mutex> lock(mutex);
+                while (!ready)
+                    finished.wait(lock);
+            }
+
+            _started = false;
+
+            if (_state->error)
+                std::rethrow_exception(_state->error);
+
+            _r.begin(_state->value);
+            return &_r;
+        }
+
+    private:
+        template <std::size_t... I>
+        void initArgs(std::index_sequence<I...>)
+        {
+            int unused[] = { 0, (_args[I] = &std::get<I>(_argComposers), 0)... };
+            (void)unused;
+        }
+
+        template <std::size_t... I>
+        void beginArgs(std::index_sequence<I...>)
+        {
+            // a pooled procedure starts each call with fresh values
+            _values = std::tuple<Value<A>...>();
+            int unused[] = { 0, (std::get<I>(_argComposers).begin(std::get<I>(_values)), 0)... };
+            (void)unused;
+        }
+
+        template <std::size_t... I>
+        void invoke(AsyncReply<R>&& reply, std::index_sequence<I...>)
+        {
+            _cb(std::move(reply), std::forward<A>(std::get<I>(_values))...);
+        }
+
+        Callback _cb;
+        std::shared_ptr<State> _state;
+
+        std::tuple<Value<A>...> _values;
+        std::tuple<Composer<Value<A>>...> _argComposers;
+        IComposer* _args[sizeof...(A) + 1];
+        Composers _composers;
+        Decomposer<RV> _r;
+        bool _started;
+};
+
+// A procedure, which gets a StreamWriter as first parameter and writes the
+// elements of the result to it. The binary rpc server sends them, while they
+// are produced; endCall collects them to a vector for other servers.
+template <typename T, typename... A>
+class StreamServiceProcedure : public ServiceProcedure
+{
+        template <typename V>
+        using Value = typename std::remove_cv_t<std::remove_reference_t<V>>;
+
+        // formats the elements to the sink of the server
+        class SinkWriter : public StreamWriter<T>
+        {
+                IStreamSink& _sink;
+                Decomposer<T> _element;
+
+            public:
+                explicit SinkWriter(IStreamSink& sink)
+                    : _sink(sink)
+                    { }
+
+                void write(const T& value) override
+                {
+                    _element.begin(value);
+                    _sink.write(_element);
+                }
+        };
+
+        class CollectWriter : public StreamWriter<T>
+        {
+                std::vector<T>& _values;
+
+            public:
+                explicit CollectWriter(std::vector<T>& values)
+                    : _values(values)
+                    { }
+
+                void write(const T& value) override
+                    { _values.push_back(value); }
+        };
+
+    public:
+        typedef std::function<void (StreamWriter<T>&, A...)> Callback;
+
+        explicit StreamServiceProcedure(const Callback& cb)
+        : ServiceProcedure(),
+          _cb(cb),
+          _composers(_args, sizeof...(A))
+        {
+            initArgs(std::index_sequence_for<A...>());
+        }
+
+        ServiceProcedure* clone() const override
+        {
+            return new StreamServiceProcedure(_cb);
+        }
+
+        IComposers* beginCall(const std::string&) override
+        {
+            beginArgs(std::index_sequence_for<A...>());
+            _composers.begin();
+            return &_composers;
+        }
+
+        bool streaming() const override
+        {
+            return true;
+        }
+
+        void executeStream(IStreamSink& sink) override
+        {
+            SinkWriter writer(sink);
+            invoke(writer, std::index_sequence_for<A...>());
+        }
+
+        IDecomposer* endCall() override
+        {
+            _collected.clear();
+            CollectWriter writer(_collected);
+            invoke(writer, std::index_sequence_for<A...>());
+            _r.begin(_collected);
+            return &_r;
+        }
+
+    private:
+        template <std::size_t... I>
+        void initArgs(std::index_sequence<I...>)
+        {
+            int unused[] = { 0, (_args[I] = &std::get<I>(_argComposers), 0)... };
+            (void)unused;
+        }
+
+        template <std::size_t... I>
+        void beginArgs(std::index_sequence<I...>)
+        {
+            // a pooled procedure starts each call with fresh values
+            _values = std::tuple<Value<A>...>();
+            int unused[] = { 0, (std::get<I>(_argComposers).begin(std::get<I>(_values)), 0)... };
+            (void)unused;
+        }
+
+        template <std::size_t... I>
+        void invoke(StreamWriter<T>& writer, std::index_sequence<I...>)
+        {
+            _cb(writer, std::forward<A>(std::get<I>(_values))...);
+        }
+
+        Callback _cb;
+
+        std::tuple<Value<A>...> _values;
+        std::tuple<Composer<Value<A>>...> _argComposers;
+        IComposer* _args[sizeof...(A) + 1];
+        Composers _composers;
+        std::vector<T> _collected;
+        Decomposer<std::vector<T>> _r;
+};
+
 }
 
 #endif // CXXTOOLS_SERVICEPROCEDURE_H
@@ -39,17 +39,30 @@ class BasicServiceProcedure : public ServiceProcedure
 
         IComposers* beginCall(const std::string&) override
         {
+            // a pooled procedure starts each call with fresh values
+            _rv = RV();
+            _v1 = V1();
             _a1.begin(_v1);
+            _v2 = V2();
             _a2.begin(_v2);
+            _v3 = V3();
             _a3.begin(_v3);
+            _v4 = V4();
             _a4.begin(_v4);
+            _v5 = V5();
             _a5.begin(_v5);
+            _v6 = V6();
             _a6.begin(_v6);
+            _v7 = V7();
             _a7.begin(_v7);
+            _v8 = V8();
             _a8.begin(_v8);
+            _v9 = V9();
             _a9.begin(_v9);
+            _v10 = V10();
             _a10.begin(_v10);
 
+            _composers.begin();
             return &_composers;
         }
 
@@ -140,16 +153,28 @@ class BasicServiceProcedure<R, A1, A2, A3, A4, A5, A6, A7, A8, A9,
 
         IComposers* beginCall(const std::string&) override
         {
+            // a pooled procedure starts each call with fresh values
+            _rv = RV();
+            _v1 = V1();
             _a1.begin(_v1);
+            _v2 = V2();
             _a2.begin(_v2);
+            _v3 = V3();
             _a3.begin(_v3);
+            _v4 = V4();
             _a4.begin(_v4);
+            _v5 = V5();
             _a5.begin(_v5);
+            _v6 = V6();
             _a6.begin(_v6);
+            _v7 = V7();
             _a7.begin(_v7);
+            _v8 = V8();
             _a8.begin(_v8);
+            _v9 = V9();
             _a9.begin(_v9);
 
+            _composers.begin();
             return &_composers;
         }
 
@@ -235,15 +260,26 @@ class BasicServiceProcedure<R, A1, A2, A3, A4, A5, A6, A7, A8,
 
         IComposers* beginCall(const std::string&) override
         {
+            // a pooled procedure starts each call with fresh values
+            _rv = RV();
+            _v1 = V1();
             _a1.begin(_v1);
+            _v2 = V2();
             _a2.begin(_v2);
+            _v3 = V3();
             _a3.begin(_v3);
+            _v4 = V4();
             _a4.begin(_v4);
+            _v5 = V5();
             _a5.begin(_v5);
+            _v6 = V6();
             _a6.begin(_v6);
+            _v7 = V7();
             _a7.begin(_v7);
+            _v8 = V8();
             _a8.begin(_v8);
 
+            _composers.begin();
             return &_composers;
         }
 
@@ -324,14 +360,24 @@ class BasicServiceProcedure<R, A1, A2, A3, A4, A5, A6, A7,
 
         IComposers* beginCall(const std::string&) override
         {
+            // a pooled procedure starts each call with fresh values
+            _rv = RV();
+            _v1 = V1();
             _a1.begin(_v1);
+            _v2 = V2();
             _a2.begin(_v2);
+            _v3 = V3();
             _a3.begin(_v3);
+            _v4 = V4();
             _a4.begin(_v4);
+            _v5 = V5();
             _a5.begin(_v5);
+            _v6 = V6();
             _a6.begin(_v6);
+            _v7 = V7();
             _a7.begin(_v7);
 
+            _composers.begin();
             return &_composers;
         }
 
@@ -407,13 +453,22 @@ class BasicServiceProcedure<R, A1, A2, A3, A4, A5, A6,
 
         IComposers* beginCall(const std::string&) override
         {
+            // a pooled procedure starts each call with fresh values
+            _rv = RV();
+            _v1 = V1();
             _a1.begin(_v1);
+            _v2 = V2();
             _a2.begin(_v2);
+            _v3 = V3();
             _a3.begin(_v3);
+            _v4 = V4();
             _a4.begin(_v4);
+            _v5 = V5();
             _a5.begin(_v5);
+            _v6 = V6();
             _a6.begin(_v6);
 
+            _composers.begin();
             return &_composers;
         }
 
@@ -484,12 +539,20 @@ class BasicServiceProcedure<R, A1, A2, A3, A4, A5,
 
         IComposers* beginCall(const std::string&) override
         {
+            // a pooled procedure starts each call with fresh values
+            _rv = RV();
+            _v1 = V1();
             _a1.begin(_v1);
+            _v2 = V2();
             _a2.begin(_v2);
+            _v3 = V3();
             _a3.begin(_v3);
+            _v4 = V4();
             _a4.begin(_v4);
+            _v5 = V5();
             _a5.begin(_v5);
 
+            _composers.begin();
             return &_composers;
         }
 
@@ -555,11 +618,18 @@ class BasicServiceProcedure<R, A1, A2, A3, A4,
 
         IComposers* beginCall(const std::string&) override
         {
+            // a pooled procedure starts each call with fresh values
+            _rv = RV();
+            _v1 = V1();
             _a1.begin(_v1);
+            _v2 = V2();
             _a2.begin(_v2);
+            _v3 = V3();
             _a3.begin(_v3);
+            _v4 = V4();
             _a4.begin(_v4);
 
+            _composers.begin();
             return &_composers;
         }
 
@@ -620,10 +690,16 @@ class BasicServiceProcedure<R, A1, A2, A3,
 
         IComposers* beginCall(const std::string&) override
         {
+            // a pooled procedure starts each call with fresh values
+            _rv = RV();
+            _v1 = V1();
             _a1.begin(_v1);
+            _v2 = V2();
             _a2.begin(_v2);
+            _v3 = V3();
             _a3.begin(_v3);
 
+            _composers.begin();
             return &_composers;
         }
 
@@ -679,9 +755,14 @@ class BasicServiceProcedure<R, A1, A2,
 
         IComposers* beginCall(const std::string&) override
         {
+            // a pooled procedure starts each call with fresh values
+            _rv = RV();
+            _v1 = V1();
             _a1.begin(_v1);
+            _v2 = V2();
             _a2.begin(_v2);
 
+            _composers.begin();
             return &_composers;
         }
 
@@ -732,8 +813,12 @@ class BasicServiceProcedure<R, A1,
 
         IComposers* beginCall(const std::string&) override
         {
+            // a pooled procedure starts each call with fresh values
+            _rv = RV();
+            _v1 = V1();
             _a1.begin(_v1);
 
+            _composers.begin();
             return &_composers;
         }
 
@@ -779,6 +864,7 @@ class BasicServiceProcedure<R,
 
         IComposers* beginCall(const std::string&) override
         {
+            _rv = RV();
             return &_composers;
         }
 
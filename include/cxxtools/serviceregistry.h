@@ -32,11 +32,36 @@
 #include <cxxtools/serviceprocedure.h>
 #include <string>
 #include <vector>
-#include <map>
+#include <unordered_map>
 #include <memory>
+#include <mutex>
 
 namespace cxxtools
 {
+    //! @cond internal
+    // The procedures of one registered name. Procedures released after a
+    // call are kept for reuse, so that a call does not need to clone the
+    // registered procedure.
+    class ServiceProcedurePool
+    {
+            std::unique_ptr<ServiceProcedure> _procedure;
+            std::mutex _mutex;
+            std::vector<std::unique_ptr<ServiceProcedure>> _free;
+
+        public:
+            explicit ServiceProcedurePool(const ServiceProcedure& proc)
+                : _procedure(proc.clone())
+                { }
+
+            std::unique_ptr<ServiceProcedure> get();
+
+            bool async() const
+                { return _procedure->async(); }
+
+            static void release(std::unique_ptr<ServiceProcedure>&& proc);
+    };
+    //! @endcond internal
+
     class ServiceRegistry
     {
         public:
@@ -240,17 +265,87 @@ namespace cxxtools
                 this->registerProcedure(name, BasicServiceProcedure<R, A1, A2, A3, A4, A5, A6, A7, A8, A9, A10>(std::bind(method, &obj, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, std::placeholders::_7, std::placeholders::_8, std::placeholders::_9, std::placeholders::_10)));
             }
 
+            /** Registers a function, which replies asynchronously.
+
+                The function gets a AsyncReply as first parameter, which
+                takes the result, when it is ready. The function may return
+                before and pass the reply to another thread. The binary and
+                json rpc servers release the worker thread meanwhile.
+             */
+            template <typename R, typename... A>
+            void registerAsyncFunction(const std::string& name, void (*fn)(AsyncReply<R>, A...))
+            {
+                this->registerProcedure(name, AsyncServiceProcedure<R, A...>(fn));
+            }
+
+            template <typename R, typename... A>
+            void registerAsyncFunction(const std::string& name, const std::function<void (AsyncReply<R>, A...)>& fn)
+            {
+                this->registerProcedure(name, AsyncServiceProcedure<R, A...>(fn));
+            }
+
+            template <typename R, class C, typename... A>
+            void registerAsyncMethod(const std::string& name, C& obj, void (C::*method)(AsyncReply<R>, A...))
+            {
+                C* o = &obj;
+                this->registerProcedure(name, AsyncServiceProcedure<R, A...>(
+                    [o, method] (AsyncReply<R> reply, A... args) {
+                        (o->*method)(std::move(reply), std::forward<A>(args)...);
+                    }));
+            }
+
+            /** Registers a function, which returns its result as a stream.
+
+                The function gets a StreamWriter as first parameter and writes
+                the elements of the result to it. The binary rpc server sends
+                each element, when it is written; other servers reply with an
+                array of all elements.
+             */
+            template <typename T, typename... A>
+            void registerStreamFunction(const std::string& name, void (*fn)(StreamWriter<T>&, A...))
+            {
+                this->registerProcedure(name, StreamServiceProcedure<T, A...>(fn));
+            }
+
+            template <typename T, typename... A>
+            void registerStreamFunction(const std::string& name, const std::function<void (StreamWriter<T>&, A...)>& fn)
+            {
+                this->registerProcedure(name, StreamServiceProcedure<T, A...>(fn));
+            }
+
+            template <typename T, class C, typename... A>
+            void registerStreamMethod(const std::string& name, C& obj, void (C::*method)(StreamWriter<T>&, A...))
+            {
+                C* o = &obj;
+                this->registerProcedure(name, StreamServiceProcedure<T, A...>(
+                    [o, method] (StreamWriter<T>& out, A... args) {
+                        (o->*method)(out, std::forward<A>(args)...);
+                    }));
+            }
+
             std::unique_ptr<ServiceProcedure> getProcedure(const std::string& name) const;
 
+            /// Returns true, when the procedure registered for the name replies asynchronously.
+            bool isAsync(const std::string& name) const;
+
+            /** Gives a procedure back after the call.
+
+                The procedure must come from getProcedure of a registry,
+                which still exists. It is reused by later calls of the same
+                name, so that a call does not allocate a new procedure.
+             */
+            void releaseProcedure(std::unique_ptr<ServiceProcedure>&& proc) const
+                { ServiceProcedurePool::release(std::move(proc)); }
+
             std::vector<std::string> getProcedureNames() const;
 
             void registerProcedure(const std::string& name, const ServiceProcedure& proc);
             void registerDefaultProcedure(const ServiceProcedure& proc)
-                { _defaultProcedure = std::unique_ptr<ServiceProcedure>(proc.clone()); }
+                { _defaultProcedure.reset(new ServiceProcedurePool(proc)); }
 
         private:
-            typedef std::map<std::string, std::unique_ptr<ServiceProcedure>> ProcedureMap;
-            std::unique_ptr<ServiceProcedure> _defaultProcedure;
+            typedef std::unordered_map<std::string, std::unique_ptr<ServiceProcedurePool>> ProcedureMap;
+            std::unique_ptr<ServiceProcedurePool> _defaultProcedure;
             ProcedureMap _procedures;
     };
 
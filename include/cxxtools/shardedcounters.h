@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_SHARDEDCOUNTERS_H
+#define CXXTOOLS_SHARDEDCOUNTERS_H
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+
+namespace cxxtools
+{
+
+/**
+ A set of counters, which many threads update concurrently.
+
+ The counters are kept in a number of shards. Each thread updates the
+ counters of its own shard and the shards are placed in separate cache
+ lines, so that updates from different cores do not contend for the same
+ cache line. Reading a counter merges the values of all shards.
+
+ Threads are assigned to shards round robin on first use. When there are
+ more threads than shards, threads share a shard; the counters are atomic,
+ so the values stay exact.
+ */
+class ShardedCounters
+{
+        ShardedCounters(const ShardedCounters&) = delete;
+        ShardedCounters& operator=(const ShardedCounters&) = delete;
+
+    public:
+        static const unsigned Shards = 16;
+
+        explicit ShardedCounters(unsigned counters);
+
+        /// Returns the number of counters per shard.
+        unsigned size() const
+            { return _size; }
+
+        /// Returns a counter in the shard of the calling thread.
+        std::atomic<int64_t>& local(unsigned counter)
+            { return cell(shard(), counter); }
+
+        void add(unsigned counter, int64_t value)
+            { local(counter).fetch_add(value, std::memory_order_relaxed); }
+
+        /// Raises a counter of the shard of the calling thread to value.
+        void max(unsigned counter, int64_t value);
+
+        /// Returns the sum of a counter over all shards.
+        int64_t sum(unsigned counter) const;
+
+        /// Returns the maximum of a counter over all shards.
+        int64_t max(unsigned counter) const;
+
+        /// Sets all counters to 0.
+        void clear();
+
+        /// Returns the shard of the calling thread.
+        static unsigned shard();
+
+    private:
+        std::atomic<int64_t>& cell(unsigned shard, unsigned counter) const
+            { return _cells[_first + shard * _stride + counter]; }
+
+        unsigned _size;
+        unsigned _stride;   // cells per shard; a multiple of a cache line
+        unsigned _first;    // first cell aligned to a cache line
+        std::unique_ptr<std::atomic<int64_t>[]> _cells;
+};
+
+}
+
+#endif // CXXTOOLS_SHARDEDCOUNTERS_H
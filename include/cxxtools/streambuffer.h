@@ -143,6 +143,22 @@ class StreamBuffer : public BasicStreamBuffer<char>,
          */
         void discard();
 
+        /** Returns a pointer to the data available in the input buffer.
+         *
+         *  The buffer holds in_avail() bytes. Together with inputConsume it
+         *  allows parsers to work directly on the received data.
+         */
+        const char* inputBegin() const
+            { return gptr(); }
+
+        /// Removes n bytes from the start of the input buffer.
+        void inputConsume(std::size_t n)
+            { gbump(static_cast<int>(n)); }
+
+        /// Returns the maximum number of bytes the input buffer can hold.
+        std::size_t inputCapacity() const
+            { return _ibufferSize - _pbmax; }
+
         /** Signals, that the underlying I/O device has data to read.
          */
         Signal<StreamBuffer&> inputReady;
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_STREAMWRITER_H
+#define CXXTOOLS_STREAMWRITER_H
+
+#include <cxxtools/decomposer.h>
+
+namespace cxxtools
+{
+
+/// Receives the elements of a streaming procedure; implemented by the server.
+class IStreamSink
+{
+    public:
+        virtual ~IStreamSink() { }
+
+        /// Sends one element; blocks, when the receiver does not keep up.
+        virtual void write(IDecomposer& element) = 0;
+};
+
+/** Output of a streaming procedure.
+
+    A procedure registered with ServiceRegistry::registerStreamFunction or
+    registerStreamMethod gets a StreamWriter as first parameter and writes
+    the elements of its result one by one. The binary rpc server sends each
+    element, when it is written, so that the whole result is never held in
+    memory. Other servers collect the elements and reply with an array.
+ */
+template <typename T>
+class StreamWriter
+{
+    public:
+        typedef T value_type;
+
+        virtual ~StreamWriter() { }
+
+        virtual void write(const T& value) = 0;
+
+        StreamWriter& operator<< (const T& value)
+        {
+            write(value);
+            return *this;
+        }
+};
+
+}
+
+#endif // CXXTOOLS_STREAMWRITER_H
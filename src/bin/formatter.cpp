@@ -223,6 +223,11 @@ void Formatter::addValueString(const std::string& name, const std::string& type,
 }
 
 void Formatter::addValueStdString(const std::string& name, const std::string& type, std::string&& value)
+{
+    addValueStdString(name, type, static_cast<const std::string&>(value));
+}
+
+void Formatter::addValueStdString(const std::string& name, const std::string& type, const std::string& value)
 {
     log_trace("addValueStdString(\"" << name << "\", \"" << type << "\", \"" << value << "\")");
 
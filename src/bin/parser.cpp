@@ -29,6 +29,7 @@
 #include <cxxtools/bin/parser.h>
 #include <cxxtools/bin/serializer.h>
 #include <cxxtools/bin/deserializer.h>
+#include <cxxtools/composer.h>
 #include <cxxtools/serializationerror.h>
 #include <cxxtools/utf8codec.h>
 #include <cxxtools/log.h>
@@ -119,6 +120,23 @@ namespace
 void Parser::begin(Deserializer& handler, bool resetDictionary)
 {
     _deserializer = &handler;
+    _direct = 0;
+    _state = state_type;
+    _nextstate = state_type;
+    _int = 0;
+    _exp = 0;
+    _token.clear();
+    delete _next;
+    _next = 0;
+
+    if (resetDictionary)
+        _mydictionary.clear();
+}
+
+void Parser::begin(IDirectComposer& composer, bool resetDictionary)
+{
+    _deserializer = 0;
+    _direct = &composer;
     _state = state_type;
     _nextstate = state_type;
     _int = 0;
@@ -134,6 +152,7 @@ void Parser::begin(Deserializer& handler, bool resetDictionary)
 void Parser::finish()
 {
     _deserializer = 0;
+    _direct = 0;
     _token.clear();
     delete _next;
     _next = 0;
@@ -143,11 +162,20 @@ void Parser::skip()
 {
     _state = state_type;
     _deserializer = 0;
+    _direct = 0;
     _int = 0;
     _exp = 0;
     _token.clear();
 }
 
+void Parser::discard()
+{
+    _deserializer = 0;
+    _direct = 0;
+    if (_next)
+        _next->discard();
+}
+
 
 bool Parser::advance(std::streambuf& in, bool atLeastOne)
 {
@@ -172,6 +200,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                         _state = state_name;
                         if (_deserializer)
                             _deserializer->setCategory(SerializationInfo::Object);
+                        else if (_direct)
+                            _direct->setCategory(SerializationInfo::Object);
                     }
                     else if (tc == Serializer::Type::CategoryArray)
                     {
@@ -179,6 +209,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                         _state = state_name;
                         if (_deserializer)
                             _deserializer->setCategory(SerializationInfo::Array);
+                        else if (_direct)
+                            _direct->setCategory(SerializationInfo::Array);
                     }
                     else if (tc == Serializer::Type::Other)
                     {
@@ -218,6 +250,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                             case Serializer::Type::Empty:
                                 if (_deserializer)
                                     _deserializer->setNull();
+                                else if (_direct)
+                                    _direct->setNull();
                                 _nextstate = state_end;
                                 _state = state_name;
                                 break;
@@ -331,6 +365,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                                 _nextstate = state_array_member;
                                 if (_deserializer)
                                     _deserializer->setCategory(SerializationInfo::Array);
+                                else if (_direct)
+                                    _direct->setCategory(SerializationInfo::Array);
                                 break;
 
                             case Serializer::Type::Pair:
@@ -340,11 +376,15 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                                 _state = state_name;
                                 if (_deserializer)
                                     _deserializer->setCategory(SerializationInfo::Object);
+                                else if (_direct)
+                                    _direct->setCategory(SerializationInfo::Object);
                                 break;
 
                             case Serializer::Type::PlainEmpty:
                                 if (_deserializer)
                                     _deserializer->setNull();
+                                else if (_direct)
+                                    _direct->setNull();
                                 _state = state_end;
                                 break;
 
@@ -439,6 +479,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                                 _state = state_array_type;
                                 if (_deserializer)
                                     _deserializer->setCategory(SerializationInfo::Array);
+                                else if (_direct)
+                                    _direct->setCategory(SerializationInfo::Array);
                                 break;
 
                             case Serializer::Type::PlainPair:
@@ -447,6 +489,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                                 _state = state_object_type;
                                 if (_deserializer)
                                     _deserializer->setCategory(SerializationInfo::Object);
+                                else if (_direct)
+                                    _direct->setCategory(SerializationInfo::Object);
                                 break;
 
                             default:
@@ -593,6 +637,13 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                                 _deserializer->setValue(value);
                             }
                         }
+                        else if (_direct)
+                        {
+                            if (_state == state_value_int)
+                                _direct->setValue(IDirectComposer::int_type(_int));
+                            else
+                                _direct->setValue(IDirectComposer::unsigned_type(_int));
+                        }
 
                         _int = 0;
                         return true;
@@ -603,6 +654,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
             case state_value_bool:
                 if (_deserializer)
                     _deserializer->setValue(ch != '\0');
+                else if (_direct)
+                    _direct->setValue(ch != '\0');
 
                 in.sbumpc();
                 return true;
@@ -612,6 +665,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                 {
                     if (_deserializer)
                         _deserializer->setValue("nan");
+                    else if (_direct)
+                        _direct->setValue(std::string("nan"));
                     _state = state_end;
                     in.sbumpc();
                     break;
@@ -620,6 +675,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                 {
                     if (_deserializer)
                         _deserializer->setValue("inf");
+                    else if (_direct)
+                        _direct->setValue(std::string("inf"));
                     _state = state_end;
                     in.sbumpc();
                     break;
@@ -628,6 +685,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                 {
                     if (_deserializer)
                         _deserializer->setValue("-inf");
+                    else if (_direct)
+                        _direct->setValue(std::string("-inf"));
                     _state = state_end;
                     in.sbumpc();
                     break;
@@ -642,6 +701,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                 {
                     if (_deserializer)
                         _deserializer->setValue(_token);
+                    else if (_direct)
+                        _direct->setValue(_token);
                     _token.clear();
                     in.sbumpc();
                     return true;
@@ -653,6 +714,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                     {
                         if (_deserializer)
                             _deserializer->setValue(_token);
+                        else if (_direct)
+                            _direct->setValue(_token);
                         _token.clear();
                         _state = state_end;
                     }
@@ -676,6 +739,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                     {
                         if (_deserializer)
                             _deserializer->setValue(std::string());
+                        else if (_direct)
+                            _direct->setValue(std::string());
                         _state = state_end;
                     }
                     else
@@ -692,13 +757,15 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                     atLeastOne = false;
                     ch = std::streambuf::traits_type::to_char_type(in.sbumpc());
 
-                    if (_deserializer)
+                    if (_deserializer || _direct)
                         _token += ch;
 
                     if (--_count == 0)
                     {
                         if (_deserializer)
                             _deserializer->setValue(_token);
+                        else if (_direct)
+                            _direct->setValue(_token);
                         return true;
                     }
                 }
@@ -714,6 +781,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                     {
                         if (_deserializer)
                             _deserializer->setValue(Utf8Codec::decode(_token));
+                        else if (_direct)
+                            _direct->setUtf8(_token);
                         _token.clear();
                         _state = state_end;
                         break;
@@ -728,6 +797,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                 ch = std::streambuf::traits_type::to_char_type(in.sbumpc());
                 if (_deserializer)
                     _deserializer->setValue(ch);
+                else if (_direct)
+                    _direct->setValue(ch);
                 return true;
 
             case state_sfloat_exp:
@@ -859,6 +930,11 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                     _deserializer->beginMember(_token, "", SerializationInfo::Void);
                     _next->begin(*_deserializer);
                 }
+                else if (_direct)
+                {
+                    _direct->beginElement();
+                    _next->begin(*_direct);
+                }
                 else
                     _next->skip();
 
@@ -870,6 +946,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                 {
                     if (_deserializer)
                         _deserializer->leaveMember();
+                    else if (_direct)
+                        _direct->finishElement();
                     _state = state_object_member;
                 }
                 break;
@@ -952,6 +1030,11 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                     _deserializer->beginMember("", "", SerializationInfo::Void);
                     _next->begin(*_deserializer);
                 }
+                else if (_direct)
+                {
+                    _direct->beginElement();
+                    _next->begin(*_direct);
+                }
                 else
                 {
                     _next->skip();
@@ -965,6 +1048,8 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                 {
                     if (_deserializer)
                         _deserializer->leaveMember();
+                    else if (_direct)
+                        _direct->finishElement();
                     _state = state_array_member_value_next;
                 }
                 break;
@@ -982,6 +1067,11 @@ bool Parser::advance(std::streambuf& in, bool atLeastOne)
                         _deserializer->beginMember("", "", SerializationInfo::Void);
                         _next->begin(*_deserializer);
                     }
+                    else if (_direct)
+                    {
+                        _direct->beginElement();
+                        _next->begin(*_direct);
+                    }
                     else
                     {
                         _next->skip();
@@ -1044,6 +1134,8 @@ bool Parser::processFloatBase(char ch, unsigned shift, unsigned expOffset)
 
         if (_deserializer)
             _deserializer->setValue(v);
+        else if (_direct)
+            _direct->setValue(v);
 
         _int = 0;
         return true;
@@ -1110,10 +1202,9 @@ void Parser::StringBuffer::extend()
 
 bool RequestHeaderParser::advance(std::streambuf& in)
 {
-    std::streambuf::int_type chi;
-    while ((chi = in.sgetc()) != std::streambuf::traits_type::eof())
+    while (in.in_avail() > 0)
     {
-        char ch = std::streambuf::traits_type::to_char_type(chi);
+        char ch = std::streambuf::traits_type::to_char_type(in.sgetc());
         switch (_state)
         {
             case State::null:
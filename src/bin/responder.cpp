@@ -28,10 +28,16 @@
 
 #include "responder.h"
 #include "rpcserverimpl.h"
+#include <cxxtools/asyncdone.h>
 #include <cxxtools/bin/parser.h>
 #include <cxxtools/serviceprocedure.h>
 #include <cxxtools/remoteexception.h>
+#include <cxxtools/streamwriter.h>
+#include <cxxtools/ioerror.h>
 #include <cxxtools/log.h>
+#include <cxxtools/decomposer.h>
+
+#include <sstream>
 
 log_define("cxxtools.bin.responder")
 
@@ -39,18 +45,55 @@ namespace cxxtools
 {
 namespace bin
 {
-void Responder::reply(IOStream& out)
+namespace
+{
+    void writeTag(std::ostream& out, uint32_t id)
+    {
+        out << '\xc4'
+            << static_cast<char>(id >> 24)
+            << static_cast<char>(id >> 16)
+            << static_cast<char>(id >> 8)
+            << static_cast<char>(id);
+    }
+
+    class StreamSink : public IStreamSink
+    {
+            std::ostream& _out;
+            Formatter& _formatter;
+
+        public:
+            StreamSink(std::ostream& out, Formatter& formatter)
+                : _out(out),
+                  _formatter(formatter)
+                { }
+
+            void write(IDecomposer& element) override
+            {
+                _out << '\xc5';
+                _formatter.begin(*_out.rdbuf());
+                element.format(_formatter);
+                _formatter.finish();
+                _out << '\xff';
+
+                // stops the procedure, when the client is gone
+                if (!_out)
+                    throw IOError("failed to send stream element");
+            }
+    };
+}
+
+void Responder::reply(std::ostream& out, Formatter& formatter, IDecomposer& result)
 {
     log_info("send reply");
 
     out << '\xc1';
-    _formatter.begin(out.buffer());
-    _result->format(_formatter);
-    _formatter.finish();
+    formatter.begin(*out.rdbuf());
+    result.format(formatter);
+    formatter.finish();
     out << '\xff';
 }
 
-void Responder::replyError(IOStream& out, const char* msg, int rc)
+void Responder::replyError(std::ostream& out, const char* msg, int rc)
 {
     log_info("send error \"" << msg << '"');
 
@@ -63,43 +106,85 @@ void Responder::replyError(IOStream& out, const char* msg, int rc)
         << '\0' << '\xff';
 }
 
+void Responder::replyStream(std::ostream& out, Formatter& formatter, ServiceProcedure& proc)
+{
+    log_info("send stream");
+
+    // The stream buffer of the socket sends the elements, when it is full,
+    // so that a slow client slows down the procedure.
+    StreamSink sink(out, formatter);
+
+    try
+    {
+        proc.executeStream(sink);
+        out << '\xc6' << '\xff';
+    }
+    catch (const IOError&)
+    {
+        throw;
+    }
+    catch (const RemoteException& e)
+    {
+        replyError(out, e.what(), e.rc());
+    }
+    catch (const std::exception& e)
+    {
+        replyError(out, e.what(), 0);
+    }
+}
+
 bool Responder::onInput(IOStream& ios)
 {
     while (ios.buffer().in_avail() > 0)
     {
         if (advance(ios.buffer()))
         {
-            if (_failed)
+            if (_negotiate)
+            {
+                // reply with the version of the protocol extension
+                int version = 1;
+                Decomposer<int> result;
+                result.begin(version);
+                reply(ios, _formatter, result);
+
+                if (_headerParser.method() == "multiplex")
+                {
+                    log_info("client uses tagged requests");
+                    _multiplexed = true;
+                }
+                else
+                    log_info("client sends deadlines");
+            }
+            else if (_failed)
             {
                 replyError(ios, _errorMessage.c_str(), 0);
             }
             else
             {
-                try
+                RpcContext context(_deadline);
+
+                if (context.expired())
                 {
-                    _result = _proc->endCall();
-                    reply(ios);
+                    log_info("deadline of " << RpcServer::function(_headerParser.domain(), _headerParser.method(), true) << " exceeded before start");
+                    replyError(ios, "deadline exceeded", RpcContext::Cancelled);
                 }
-                catch (const RemoteException& e)
+                else if (_proc->async())
                 {
-                    ios.buffer().discard();
-                    replyError(ios, e.what(), e.rc());
+                    _deferred = true;
+                    return false;
                 }
-                catch (const std::exception& e)
+                else
                 {
-                    ios.buffer().discard();
-                    replyError(ios, e.what(), 0);
+                    RpcContext::Scope scope(context);
+
+                    if (_proc->streaming())
+                        replyStream(ios, _formatter, *_proc);
+                    else
+                        replyResult(ios);
                 }
             }
 
-            _proc = 0;
-            _args = 0;
-            _result = 0;
-            _state = State::header;
-            _failed = false;
-            _errorMessage.clear();
-            _deserializer.begin();
-            _headerParser.reset();
+            reset();
 
             return true;
         }
@@ -108,23 +193,141 @@ bool Responder::onInput(IOStream& ios)
     return false;
 }
 
+void Responder::replyResult(IOStream& ios)
+{
+    try
+    {
+        _result = _proc->endCall();
+        reply(ios, _formatter, *_result);
+    }
+    catch (const RemoteException& e)
+    {
+        ios.buffer().discard();
+        replyError(ios, e.what(), e.rc());
+    }
+    catch (const std::exception& e)
+    {
+        ios.buffer().discard();
+        replyError(ios, e.what(), 0);
+    }
+}
+
+void Responder::beginAsync(const std::function<void()>& done)
+{
+    log_debug("run asynchronous procedure " << _headerParser.method());
+
+    RpcContext context(_deadline);
+    RpcContext::Scope scope(context);
+    _proc->executeAsync(done);
+}
+
+void Responder::finishAsync(IOStream& ios)
+{
+    replyResult(ios);
+    reset();
+}
+
+Call* Responder::detachCall(Socket& socket)
+{
+    Call* call = new Call(socket, _serviceRegistry, _tagged, _id, _deadline, std::move(_proc), _failed, _errorMessage);
+    reset();
+    return call;
+}
+
+void Responder::reset()
+{
+    _serviceRegistry.releaseProcedure(std::move(_proc));
+    _args = 0;
+    _result = 0;
+    _state = State::begin;
+    _failed = false;
+    _errorMessage.clear();
+    _tagged = false;
+    _negotiate = false;
+    _deferred = false;
+    _deadline = RpcContext::Clock::time_point::max();
+    _deserializer.begin();
+    _headerParser.reset();
+}
+
 bool Responder::advance(std::streambuf& in)
 {
-    std::streambuf::int_type chi;
-    while ((chi = in.sgetc()) != std::streambuf::traits_type::eof())
+    while (in.in_avail() > 0)
     {
-        char ch = std::streambuf::traits_type::to_char_type(chi);
+        char ch = std::streambuf::traits_type::to_char_type(in.sgetc());
         switch (_state)
         {
+            case State::begin:
+                // a tagged request starts with '\xc4' and a 4 byte call id
+                if (ch == '\xc4')
+                {
+                    if (!_multiplexed)
+                        throw std::runtime_error("tagged request without negotiation");
+
+                    _tagged = true;
+                    _id = 0;
+                    _count = 4;
+                    _state = State::id;
+                    in.sbumpc();
+                }
+                // '\xc7' and 4 bytes give the time left for the call in ms
+                else if (ch == '\xc7')
+                {
+                    _timeout = 0;
+                    _count = 4;
+                    _state = State::deadline;
+                    in.sbumpc();
+                }
+                else
+                    _state = State::header;
+                break;
+
+            case State::id:
+                _id = (_id << 8) | static_cast<unsigned char>(ch);
+                in.sbumpc();
+                if (--_count == 0)
+                    _state = State::begin;  // a deadline may follow
+                break;
+
+            case State::deadline:
+                _timeout = (_timeout << 8) | static_cast<unsigned char>(ch);
+                in.sbumpc();
+                if (--_count == 0)
+                {
+                    _deadline = RpcContext::Clock::now() + std::chrono::milliseconds(_timeout);
+                    _state = State::header;
+                }
+                break;
+
             case State::header:
                 if (_headerParser.advance(in))
                 {
-                    auto procName = RpcServer::function(_headerParser.domain(), _headerParser.method());
-                    _proc = _serviceRegistry.getProcedure(procName);
+                    // deadlines ('\xc7') are read always; the client asks
+                    // for them, since older servers do not know them
+                    if (!_multiplexed
+                        && _headerParser.domain() == "cxxtools"
+                        && (_headerParser.method() == "multiplex"
+                            || _headerParser.method() == "deadline"))
+                    {
+                        _negotiate = true;
+                        _state = State::params_skip;
+                        break;
+                    }
+
+                    // see RpcServer::function; the name is built in a member,
+                    // so that it does not allocate once it has its capacity
+                    _procName = _headerParser.method();
+                    if (!_headerParser.domain().empty())
+                    {
+                        _procName += '\0';
+                        _procName += _headerParser.domain();
+                    }
+
+                    _proc = _serviceRegistry.getProcedure(_procName);
 
                     if (_proc)
                     {
-                        _args = _proc->beginCall(procName);
+                        _args = _proc->beginCall(_procName);
                         _state = State::params;
                     }
                     else
@@ -159,7 +362,11 @@ bool Responder::advance(std::streambuf& in)
                     }
                     else
                     {
-                        _deserializer.begin(false);
+                        _direct = _arg->direct();
+                        if (_direct)
+                            _deserializer.begin(*_direct, false);
+                        else
+                            _deserializer.begin(false);
                         _state = State::param;
                     }
                 }
@@ -184,7 +391,10 @@ bool Responder::advance(std::streambuf& in)
                 {
                     try
                     {
-                        _arg->fixup(_deserializer.si());
+                        if (_direct)
+                            _direct->finish();
+                        else
+                            _arg->fixup(_deserializer.si());
                         _state = State::params;
                     }
                     catch (const std::exception& e)
@@ -207,5 +417,101 @@ bool Responder::advance(std::streambuf& in)
     return false;
 }
 
+Call::Call(Socket& socket, ServiceRegistry& serviceRegistry, bool tagged, uint32_t id,
+           RpcContext::Clock::time_point deadline,
+           std::unique_ptr<ServiceProcedure> proc, bool failed, const std::string& errorMessage)
+    : _socket(socket),
+      _serviceRegistry(serviceRegistry),
+      _tagged(tagged),
+      _id(id),
+      _context(deadline),
+      _proc(std::move(proc)),
+      _failed(failed),
+      _errorCode(0),
+      _errorMessage(errorMessage)
+{
+}
+
+Call::~Call()
+{
+}
+
+void Call::execute(RpcServerImpl& server)
+{
+    // skip calls, which waited in the queue too long or which client is gone
+    if (!_failed && _context.cancelled())
+    {
+        log_info("call cancelled before start");
+        _failed = true;
+        _errorCode = RpcContext::Cancelled;
+        _errorMessage = _context.expired() ? "deadline exceeded" : "call cancelled";
+    }
+
+    RpcContext::Scope scope(_context);
+
+    if (!_failed && _proc->async())
+    {
+        // the call is known to the server before the procedure may reply
+        auto done = std::make_shared<AsyncDone>([this, &server] () {
+            finish();
+            server.asyncCallFinished(this);
+        });
+        server.addAsync(this, done);
+        _proc->executeAsync([done] () { (*done)(); });
+    }
+    else
+    {
+        finish();
+        server.callFinished(this);
+    }
+}
+
+void Call::finish()
+{
+    std::ostringstream out;
+
+    if (_failed)
+    {
+        Responder::replyError(out, _errorMessage.c_str(), _errorCode);
+    }
+    else if (_proc->streaming())
+    {
+        // The elements would be collected here, since the replies of a
+        // multiplexed connection are sent as a whole. Streams are passed
+        // with backpressure on plain connections only.
+        Responder::replyError(out, "streaming procedure called on multiplexed connection", 0);
+    }
+    else
+    {
+        try
+        {
+            Formatter formatter;
+            Responder::reply(out, formatter, *_proc->endCall());
+        }
+        catch (const RemoteException& e)
+        {
+            out.str(std::string());
+            Responder::replyError(out, e.what(), e.rc());
+        }
+        catch (const std::exception& e)
+        {
+            out.str(std::string());
+            Responder::replyError(out, e.what(), 0);
+        }
+    }
+
+    _serviceRegistry.releaseProcedure(std::move(_proc));
+
+    if (_tagged)
+    {
+        std::ostringstream tag;
+        writeTag(tag, _id);
+        _reply = tag.str();
+        _reply += out.str();
+    }
+    else
+        _reply = out.str();
+}
+
 }
 }
@@ -33,21 +33,27 @@
 #include <cxxtools/iostream.h>
 #include <cxxtools/bin/formatter.h>
 #include <cxxtools/serviceregistry.h>
+#include <cxxtools/rpccontext.h>
 
+#include <functional>
 #include <iosfwd>
 #include <memory>
+#include <string>
+#include <stdint.h>
 
 namespace cxxtools
 {
 
 class ServiceProcedure;
 class IComposer;
+class IDirectComposer;
 class IDecomposer;
 
 namespace bin
 {
 class RpcServerImpl;
 class Socket;
+class Call;
 
 class Responder
 {
@@ -55,6 +61,9 @@ class Responder
 
         enum class State
         {
+            begin,
+            id,
+            deadline,
             header,
             params,
             params_skip,
@@ -65,32 +74,114 @@ class Responder
     public:
         explicit Responder(ServiceRegistry& serviceRegistry)
             : _serviceRegistry(serviceRegistry),
-              _state(State::header),
+              _state(State::begin),
               _args(0),
+              _direct(0),
               _result(0),
-              _failed(false)
+              _failed(false),
+              _tagged(false),
+              _id(0),
+              _timeout(0),
+              _deadline(RpcContext::Clock::time_point::max()),
+              _count(0),
+              _negotiate(false),
+              _multiplexed(false),
+              _deferred(false)
         { }
 
         // returns true, if request is ready and reply is put to the socket
         bool onInput(IOStream& ios);
         bool advance(std::streambuf& in);
-        void reply(IOStream& out);
-        void replyError(IOStream& out, const char* msg, int rc);
+
+        // Returns the request read by advance to be executed by a worker.
+        // Used, when the connection is multiplexed.
+        Call* detachCall(Socket& socket);
+
+        // Set, when the client asked for tagged requests ("cxxtools.multiplex").
+        bool multiplexed() const   { return _multiplexed; }
+
+        // Set, when onInput stopped at a request of a asynchronous procedure.
+        // It is started with beginAsync and the reply written with finishAsync,
+        // when the procedure calls done.
+        bool deferred() const      { return _deferred; }
+        void beginAsync(const std::function<void()>& done);
+        void finishAsync(IOStream& ios);
+
+        static void reply(std::ostream& out, Formatter& formatter, IDecomposer& result);
+        static void replyError(std::ostream& out, const char* msg, int rc);
+
+        // Writes the elements of a streaming procedure as they are produced,
+        // each as '\xc5' <value> '\xff', and the end of the stream as
+        // '\xc6' '\xff' or a error reply.
+        static void replyStream(std::ostream& out, Formatter& formatter, ServiceProcedure& proc);
 
     private:
+        void replyResult(IOStream& ios);
+        void reset();
+
         ServiceRegistry& _serviceRegistry;
         State _state;
         RequestHeaderParser _headerParser;
+        std::string _procName;
         Deserializer _deserializer;
 
         std::unique_ptr<ServiceProcedure> _proc;
         IComposers* _args;
         IComposer* _arg;
+        IDirectComposer* _direct;
         IDecomposer* _result;
         Formatter _formatter;
 
         bool _failed;
         std::string _errorMessage;
+
+        bool _tagged;
+        uint32_t _id;
+        uint32_t _timeout;
+        RpcContext::Clock::time_point _deadline;
+        unsigned _count;
+        bool _negotiate;
+        bool _multiplexed;
+        bool _deferred;
+};
+
+// A request of a multiplexed connection. It is read in the event loop,
+// executed by a worker and the reply is sent in the event loop again.
+class Call
+{
+        Call(const Call&) = delete;
+        Call& operator=(const Call&) = delete;
+
+    public:
+        Call(Socket& socket, ServiceRegistry& serviceRegistry, bool tagged, uint32_t id,
+             RpcContext::Clock::time_point deadline,
+             std::unique_ptr<ServiceProcedure> proc, bool failed, const std::string& errorMessage);
+        ~Call();
+
+        // Runs the procedure and passes the call to server.callFinished with
+        // the reply. Asynchronous procedures finish later in another thread.
+        // Calls, which are cancelled before, are not run.
+        void execute(RpcServerImpl& server);
+
+        // called by the event loop, when the client disconnects
+        void cancel()                       { _context.cancel(); }
+
+        Socket& socket() const              { return _socket; }
+        const std::string& reply() const    { return _reply; }
+
+    private:
+        void finish();
+
+        Socket& _socket;
+        ServiceRegistry& _serviceRegistry;
+        bool _tagged;
+        uint32_t _id;
+        RpcContext _context;
+        std::unique_ptr<ServiceProcedure> _proc;
+        bool _failed;
+        int _errorCode;
+        std::string _errorMessage;
+        std::string _reply;
 };
 }
 }
@@ -143,6 +143,16 @@ void RpcClient::call(IComposer& r, IRemoteProcedure& method, IDecomposer** argv,
     _impl->call(r, method, argv, argc);
 }
 
+void RpcClient::beginStream(IRemoteProcedure& method, IDecomposer** argv, unsigned argc)
+{
+    getImpl()->beginStream(method, argv, argc);
+}
+
+bool RpcClient::readStream(IComposer& r)
+{
+    return getImpl()->readStream(r);
+}
+
 Milliseconds RpcClient::timeout() const
 {
     return getImpl()->timeout();
@@ -174,6 +184,12 @@ void RpcClient::cancel()
         _impl->cancel();
 }
 
+void RpcClient::cancelCall(const IRemoteProcedure& proc)
+{
+    if (_impl)
+        _impl->cancelCall(proc);
+}
+
 void RpcClient::wait(Milliseconds msecs)
 {
     _impl->wait(msecs);
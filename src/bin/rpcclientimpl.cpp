@@ -30,12 +30,18 @@
 #include <cxxtools/log.h>
 #include <cxxtools/utf8.h>
 #include <cxxtools/remoteprocedure.h>
+#include <cxxtools/remoteexception.h>
 #include <cxxtools/bin/rpcclient.h>
 #include <cxxtools/bin/rpcserver.h>
 #include <cxxtools/selector.h>
 #include <cxxtools/clock.h>
 #include <cxxtools/resetter.h>
+#include <cxxtools/rpccontext.h>
+#include <algorithm>
+#include <exception>
+#include <sstream>
 #include <stdexcept>
+#include <vector>
 
 log_define("cxxtools.bin.rpcclient.impl")
 log_define_instance(rpc, "cxxtools.bin.rpcclient")
@@ -45,10 +51,35 @@ namespace cxxtools
 namespace bin
 {
 
+namespace
+{
+    void writeTag(std::ostream& out, uint32_t id)
+    {
+        out << '\xc4'
+            << static_cast<char>(id >> 24)
+            << static_cast<char>(id >> 16)
+            << static_cast<char>(id >> 8)
+            << static_cast<char>(id);
+    }
+
+    // a call made in a procedure passes on the deadline of its context
+    RpcContext::Clock::time_point currentDeadline()
+    {
+        RpcContext* context = RpcContext::current();
+        return context ? context->deadline() : RpcContext::Clock::time_point::max();
+    }
+}
+
 RpcClientImpl::RpcClientImpl()
     : _stream(_socket, 8192, true),
       _exceptionPending(false),
       _proc(0),
+      _protocol(Protocol::plain),
+      _deadlines(Deadlines::unknown),
+      _nextId(0),
+      _current(0),
+      _tagCount(0),
+      _tagId(0),
       _timeout(Selectable::WaitInfinite),
       _connectTimeoutSet(false),
       _connectTimeout(Selectable::WaitInfinite)
@@ -63,6 +94,7 @@ void RpcClientImpl::connect()
 {
     _socket.setTimeout(_connectTimeout);
     _socket.close();
+    clearCalls();
     _socket.connect(_addrInfo);
     if (_sslCtx.enabled())
         _socket.sslConnect(_sslCtx);
@@ -71,6 +103,7 @@ void RpcClientImpl::connect()
 void RpcClientImpl::close()
 {
     _socket.close();
+    clearCalls();
 }
 
 void RpcClientImpl::beginCall(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc)
@@ -78,14 +111,85 @@ void RpcClientImpl::beginCall(IComposer& r, IRemoteProcedure& method, IDecompose
     if (_socket.selector() == 0)
         throw std::logic_error("cannot run async rpc request without a selector");
 
-    if (_proc)
-        throw std::logic_error("asynchronous request already running");
+    log_info_to(rpc, static_cast<void*>(&_scanner) << " call <" << RpcServer::function(_domain, Utf8(method.name()).str(), true) << "> with " << argc << (argc == 1 ? " parameter" : " parameters") << " on " << _addrInfo.host() << ':' << _addrInfo.port());
 
-    _proc = &method;
+    if (callsRunning() > 0)
+    {
+        // The connection is in use; the request is queued behind the running calls.
+        Call call(&method, &r);
 
-    log_info_to(rpc, static_cast<void*>(&_scanner) << " call <" << RpcServer::function(_domain, Utf8(method.name()).str(), true) << "> with " << argc << (argc == 1 ? " parameter" : " parameters") << " on " << _addrInfo.host() << ':' << _addrInfo.port());
+        switch (_protocol)
+        {
+            case Protocol::plain:
+                // deadlines are asked for first, while the server reads plain requests
+                if (_deadlines == Deadlines::unknown)
+                    askDeadlines();
+
+                log_debug("ask server for tagged requests");
+                _stream << '\xc3' << "cxxtools" << '\0' << "multiplex" << '\0' << '\xff';
+                _inOrder.push_back(Call(0, &_discard, Negotiation::multiplex));
+                _protocol = Protocol::negotiating;
+                // fall through
+
+            case Protocol::negotiating:
+                {
+                    std::ostringstream request;
+                    prepareRequest(request, method.name(), argv, argc);
+                    call.request = request.str();
+                    call.deadline = currentDeadline();
+                    _waiting.push_back(std::move(call));
+                }
+                break;
 
-    prepareRequest(method.name(), argv, argc);
+            case Protocol::multiplexed:
+                {
+                    uint32_t id = nextId();
+                    writeTag(_stream, id);
+                    writeDeadline(_stream, currentDeadline());
+                    prepareRequest(_stream, method.name(), argv, argc);
+                    _tagged.emplace(id, std::move(call));
+                }
+                break;
+
+            case Protocol::sequential:
+                writeDeadline(_stream, currentDeadline());
+                prepareRequest(_stream, method.name(), argv, argc);
+                _inOrder.push_back(std::move(call));
+                break;
+        }
+
+        // when still connecting, the output is sent after connect
+        if (established())
+            _stream.buffer().beginWrite();
+
+        return;
+    }
+
+    if (!_socket.isConnected())
+    {
+        _protocol = Protocol::plain;
+        _deadlines = Deadlines::unknown;
+    }
+
+    RpcContext::Clock::time_point deadline = currentDeadline();
+    if (_deadlines == Deadlines::unknown && deadline != RpcContext::Clock::time_point::max())
+    {
+        // the call waits for the server to tell, whether it reads deadlines
+        askDeadlines();
+
+        Call call(&method, &r);
+        std::ostringstream request;
+        prepareRequest(request, method.name(), argv, argc);
+        call.request = request.str();
+        call.deadline = deadline;
+        _waiting.push_back(std::move(call));
+    }
+    else
+    {
+        _inOrder.push_back(Call(&method, &r));
+        writeDeadline(_stream, deadline);
+        prepareRequest(_stream, method.name(), argv, argc);
+    }
 
     try
     {
@@ -98,6 +202,7 @@ void RpcClientImpl::beginCall(IComposer& r, IRemoteProcedure& method, IDecompose
             catch (const IOError&)
             {
                 log_debug("write failed, connection is not active any more");
+                _protocol = Protocol::plain;
                 _socket.beginConnect(_addrInfo);
             }
         }
@@ -109,19 +214,8 @@ void RpcClientImpl::beginCall(IComposer& r, IRemoteProcedure& method, IDecompose
     }
     catch (const std::exception& )
     {
-        IRemoteProcedure* proc = _proc;
-        cancel();
-
-        _exceptionPending = true;
-        Resetter<bool> exceptionPending(_exceptionPending, false);
-
-        proc->onFinished();
-
-        if (_exceptionPending)
-            throw;
+        failCalls();
     }
-
-    _scanner.begin(_deserializer, r);
 }
 
 void RpcClientImpl::endCall()
@@ -138,83 +232,258 @@ void RpcClientImpl::endCall()
 
 void RpcClientImpl::call(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc)
 {
+    if (callsRunning() > 0)
+        throw std::logic_error("asynchronous request already running");
+
     log_info_to(rpc, static_cast<void*>(&_scanner) << " call <" << RpcServer::function(_domain, Utf8(method.name()).str(), true) << "> with " << argc << (argc == 1 ? " parameter" : " parameters") << " on " << _addrInfo.host() << ':' << _addrInfo.port());
 
+    // a stream, which is not read to the end, leaves its elements on the connection
+    if (_proc)
+        cancel();
+
     try
     {
         _proc = &method;
+        sendRequest(argv, argc);
+
         StreamBuffer& sb = _stream.buffer();
+        _scanner.begin(_deserializer, r);
 
-        if (_socket.isConnected())
+        while (true)
         {
-            log_debug("socket is connected");
-
-            try
+            if (sb.sgetc() == std::streambuf::traits_type::eof())
             {
-                prepareRequest(_proc->name(), argv, argc);
-                _socket.setTimeout(timeout());
-                sb.pubsync();
-
-                // try to read from socket to check if still connected
-                // sgetc fills the input buffer but do not consume the character
-                int ch = sb.sgetc();
-                if (ch == StreamBuffer::traits_type::eof())
-                {
-                    log_debug("reading failed");
-                    _socket.close();
-                }
+                cancel();
+                throw std::runtime_error("reading result failed");
             }
-            catch (const IOTimeout& e)
+
+            if (_scanner.advance(sb))
             {
-                log_debug("request timed out");
-                _socket.close();
-                throw;
+                _proc = 0;
+                _scanner.finish();
+                break;
             }
         }
+    }
+    catch (const RemoteException&)
+    {
+        _proc = 0;
+        throw;
+    }
+    catch (const std::exception& e)
+    {
+        cancel();
+        throw;
+    }
+}
 
-        if (!_socket.isConnected())
-        {
-            log_debug("socket is not connected");
-            _socket.setTimeout(_connectTimeout);
-            _socket.connect(_addrInfo);
-            if (_sslCtx.enabled())
-                _socket.sslConnect(_sslCtx);
-
-            prepareRequest(_proc->name(), argv, argc);
-            _socket.setTimeout(timeout());
-            sb.pubsync();
-        }
+void RpcClientImpl::beginStream(IRemoteProcedure& method, IDecomposer** argv, unsigned argc)
+{
+    if (callsRunning() > 0)
+        throw std::logic_error("asynchronous request already running");
 
-        _scanner.begin(_deserializer, r);
+    log_info_to(rpc, static_cast<void*>(&_scanner) << " stream <" << RpcServer::function(_domain, Utf8(method.name()).str(), true) << "> with " << argc << (argc == 1 ? " parameter" : " parameters") << " on " << _addrInfo.host() << ':' << _addrInfo.port());
+
+    // a stream, which is not read to the end, leaves its elements on the connection
+    if (_proc)
+        cancel();
+
+    // the server sends streams on plain connections only
+    if (_protocol == Protocol::multiplexed)
+    {
+        log_debug("reconnect for stream");
+        _socket.close();
+    }
+
+    try
+    {
+        _proc = &method;
+        sendRequest(argv, argc);
+    }
+    catch (const std::exception&)
+    {
+        cancel();
+        throw;
+    }
+}
+
+bool RpcClientImpl::readStream(IComposer& r)
+{
+    if (_proc == 0)
+        throw std::logic_error("no stream running");
+
+    try
+    {
+        StreamBuffer& sb = _stream.buffer();
+
+        // The elements are read, when the caller asks for them. The server
+        // stops sending, when the socket buffers are full.
+        _scanner.begin(_deserializer, r, true);
 
         while (true)
         {
             if (sb.sgetc() == std::streambuf::traits_type::eof())
             {
                 cancel();
-                throw std::runtime_error("reading result failed");
+                throw std::runtime_error("reading stream failed");
             }
 
             if (_scanner.advance(sb))
-            {
-                _proc = 0;
-                _scanner.finish();
                 break;
-            }
         }
+
+        if (_scanner.element())
+            return true;
+
+        _proc = 0;
+        _scanner.finish();
+        return false;
     }
     catch (const RemoteException&)
     {
         _proc = 0;
         throw;
     }
-    catch (const std::exception& e)
+    catch (const std::exception&)
     {
         cancel();
         throw;
     }
 }
 
+// Returns the timeout of a synchronous call, which is shortened to the
+// deadline of the current context.
+Timespan RpcClientImpl::callTimeout() const
+{
+    RpcContext* context = RpcContext::current();
+    if (context == 0 || !context->hasDeadline())
+        return _timeout;
+
+    Timespan remaining = context->remaining();
+    return _timeout < Timespan(0) || remaining < _timeout ? remaining : _timeout;
+}
+
+// Sends the request of the synchronous call _proc and connects, when needed.
+void RpcClientImpl::sendRequest(IDecomposer** argv, unsigned argc)
+{
+    StreamBuffer& sb = _stream.buffer();
+
+    if (_socket.isConnected())
+    {
+        log_debug("socket is connected");
+
+        try
+        {
+            // a connection closed by the server is noticed at the reply of
+            // the negotiation or of the request
+            if (negotiateDeadlines())
+            {
+                writeDeadline(_stream, currentDeadline());
+                prepareRequest(_stream, _proc->name(), argv, argc);
+                _socket.setTimeout(callTimeout());
+                sb.pubsync();
+
+                // try to read from socket to check if still connected
+                // sgetc fills the input buffer but do not consume the character
+                if (sb.sgetc() == StreamBuffer::traits_type::eof())
+                {
+                    log_debug("reading failed");
+                    _socket.close();
+                }
+            }
+            else
+            {
+                log_debug("reading failed");
+                _socket.close();
+            }
+        }
+        catch (const IOTimeout& e)
+        {
+            log_debug("request timed out");
+            _socket.close();
+            throw;
+        }
+    }
+
+    if (!_socket.isConnected())
+    {
+        log_debug("socket is not connected");
+        _protocol = Protocol::plain;
+        _deadlines = Deadlines::unknown;
+        _socket.setTimeout(_connectTimeout);
+        _socket.connect(_addrInfo);
+        if (_sslCtx.enabled())
+            _socket.sslConnect(_sslCtx);
+
+        if (!negotiateDeadlines())
+            throw std::runtime_error("reading result failed");
+
+        writeDeadline(_stream, currentDeadline());
+        prepareRequest(_stream, _proc->name(), argv, argc);
+        _socket.setTimeout(callTimeout());
+        sb.pubsync();
+    }
+}
+
+// Asks the server synchronously, whether it reads deadlines, when the call
+// has one and the connection does not know it yet. Returns false, when the
+// connection was closed.
+bool RpcClientImpl::negotiateDeadlines()
+{
+    if (_deadlines != Deadlines::unknown || currentDeadline() == RpcContext::Clock::time_point::max())
+        return true;
+
+    log_debug("ask server for deadlines");
+    _stream << '\xc3' << "cxxtools" << '\0' << "deadline" << '\0' << '\xff';
+    _socket.setTimeout(callTimeout());
+
+    StreamBuffer& sb = _stream.buffer();
+    sb.pubsync();
+
+    _scanner.begin(_deserializer, _discard);
+    while (true)
+    {
+        if (sb.sgetc() == StreamBuffer::traits_type::eof())
+            return false;
+
+        if (_scanner.advance(sb))
+            break;
+    }
+
+    try
+    {
+        _scanner.finish();
+        _deadlines = Deadlines::accepted;
+    }
+    catch (const RemoteException&)
+    {
+        _deadlines = Deadlines::refused;
+    }
+
+    log_debug("server " << (_deadlines == Deadlines::accepted ? "accepts" : "does not accept") << " deadlines");
+    return true;
+}
+
+const IRemoteProcedure* RpcClientImpl::activeProcedure() const
+{
+    if (_proc)
+        return _proc;
+
+    for (const auto& call: _inOrder)
+        if (call.proc)
+            return call.proc;
+
+    for (const auto& it: _tagged)
+        if (it.second.proc)
+            return it.second.proc;
+
+    for (const auto& call: _waiting)
+        if (call.proc)
+            return call.proc;
+
+    return 0;
+}
+
 void RpcClientImpl::cancel()
 {
     _socket.close();
@@ -222,6 +491,53 @@ void RpcClientImpl::cancel()
     _stream.buffer().discard();
     _proc = 0;
     _exceptionPending = false;
+    clearCalls();
+}
+
+void RpcClientImpl::cancelCall(const IRemoteProcedure& proc)
+{
+    if (_proc == &proc)
+    {
+        cancel();
+        return;
+    }
+
+    for (auto it = _waiting.begin(); it != _waiting.end(); ++it)
+    {
+        if (it->proc == &proc)
+        {
+            log_debug("remove waiting call");
+            _waiting.erase(it);
+            return;
+        }
+    }
+
+    Call* call = 0;
+    for (auto& c: _inOrder)
+        if (c.proc == &proc)
+            call = &c;
+
+    for (auto& it: _tagged)
+        if (it.second.proc == &proc)
+            call = &it.second;
+
+    if (call == 0)
+        return;
+
+    if (callsRunning() == 1)
+    {
+        // the only call - as before just drop the connection
+        cancel();
+        return;
+    }
+
+    // A sent request can't be taken back. Other calls share the connection,
+    // so the reply is read and discarded.
+    log_debug("discard reply of cancelled call");
+    call->proc = 0;
+    call->result = &_discard;
+    if (call == _current)
+        _scanner.composer(_discard);
 }
 
 void RpcClientImpl::wait(Timespan timeout)
@@ -249,20 +565,196 @@ void RpcClientImpl::wait(Timespan timeout)
     }
 }
 
-void RpcClientImpl::prepareRequest(const String& name, IDecomposer** argv, unsigned argc)
+// Writes the time left until the deadline in ms, when the server accepted
+// deadlines. Servers, which do not know the prefix, would fail the request.
+void RpcClientImpl::writeDeadline(std::ostream& out, RpcContext::Clock::time_point deadline)
+{
+    if (_deadlines != Deadlines::accepted || deadline == RpcContext::Clock::time_point::max())
+        return;
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - RpcContext::Clock::now()).count();
+    uint32_t ms = remaining <= 0 ? 0
+                : static_cast<uint32_t>(std::min<int64_t>(remaining, 4294967295LL));
+    out << '\xc7'
+        << static_cast<char>(ms >> 24)
+        << static_cast<char>(ms >> 16)
+        << static_cast<char>(ms >> 8)
+        << static_cast<char>(ms);
+}
+
+void RpcClientImpl::prepareRequest(std::ostream& out, const String& name, IDecomposer** argv, unsigned argc)
 {
-    _formatter.begin(_stream.buffer());
+    _formatter.begin(*out.rdbuf());
     if (_domain.empty())
-        _stream << '\xc0' << name << '\0';
+        out << '\xc0' << name << '\0';
     else
-        _stream << '\xc3' << _domain << '\0' << name << '\0';
+        out << '\xc3' << _domain << '\0' << name << '\0';
 
     for(unsigned n = 0; n < argc; ++n)
     {
         argv[n]->format(_formatter);
     }
 
-    _stream << '\xff';
+    out << '\xff';
+}
+
+// Sends the request "cxxtools.deadline". Servers, which know it, reply with
+// the version of the extension, others with an error.
+void RpcClientImpl::askDeadlines()
+{
+    log_debug("ask server for deadlines");
+    _stream << '\xc3' << "cxxtools" << '\0' << "deadline" << '\0' << '\xff';
+    _inOrder.push_back(Call(0, &_discard, Negotiation::deadline));
+    _deadlines = Deadlines::negotiating;
+}
+
+void RpcClientImpl::sendCall(Call&& call)
+{
+    if (_protocol == Protocol::multiplexed)
+    {
+        uint32_t id = nextId();
+        writeTag(_stream, id);
+        writeDeadline(_stream, call.deadline);
+        _stream.write(call.request.data(), call.request.size());
+        call.request.clear();
+        _tagged.emplace(id, std::move(call));
+    }
+    else
+    {
+        writeDeadline(_stream, call.deadline);
+        _stream.write(call.request.data(), call.request.size());
+        call.request.clear();
+        _inOrder.push_back(std::move(call));
+    }
+}
+
+uint32_t RpcClientImpl::nextId()
+{
+    while (_tagged.find(_nextId) != _tagged.end())
+        ++_nextId;
+    return _nextId++;
+}
+
+void RpcClientImpl::negotiated(Negotiation negotiation, bool accepted)
+{
+    if (negotiation == Negotiation::multiplex)
+    {
+        log_debug("server " << (accepted ? "accepts" : "does not accept") << " tagged requests");
+        _protocol = accepted ? Protocol::multiplexed : Protocol::sequential;
+    }
+    else
+    {
+        log_debug("server " << (accepted ? "accepts" : "does not accept") << " deadlines");
+        _deadlines = accepted ? Deadlines::accepted : Deadlines::refused;
+    }
+
+    if (negotiating())
+        return;
+
+    log_debug("send " << _waiting.size() << " waiting calls");
+
+    while (!_waiting.empty())
+    {
+        sendCall(std::move(_waiting.front()));
+        _waiting.pop_front();
+    }
+
+    _stream.buffer().beginWrite();
+}
+
+bool RpcClientImpl::established() const
+{
+    return _sslCtx.enabled() ? _socket.isSslConnected() : _socket.isConnected();
+}
+
+void RpcClientImpl::clearCalls()
+{
+    _inOrder.clear();
+    _tagged.clear();
+    _waiting.clear();
+    _current = 0;
+    _tagCount = 0;
+    _protocol = Protocol::plain;
+    _deadlines = Deadlines::unknown;
+}
+
+// Removes the call, which reply is read completely and notifies the caller.
+// A remote error, which is not taken by the callback is returned in fault.
+void RpcClientImpl::finishCall(Call& call, std::exception_ptr& fault)
+{
+    IRemoteProcedure* proc = call.proc;
+    Negotiation negotiation = call.negotiation;
+
+    if (!_inOrder.empty() && &_inOrder.front() == &call)
+        _inOrder.pop_front();
+    else
+        _tagged.erase(_tagId);
+
+    _current = 0;
+
+    try
+    {
+        _scanner.finish();
+    }
+    catch (const RemoteException& e)
+    {
+        if (negotiation != Negotiation::none)
+            negotiated(negotiation, false);
+        else if (proc)
+        {
+            proc->setFault(e.rc(), e.what());
+
+            _exceptionPending = true;
+            proc->onFinished();
+            if (_exceptionPending)
+            {
+                _exceptionPending = false;
+                fault = std::current_exception();
+            }
+        }
+
+        return;
+    }
+
+    if (negotiation != Negotiation::none)
+        negotiated(negotiation, true);
+    else if (proc)
+        proc->onFinished();
+}
+
+// Called in a exception handler, when the connection failed. All running
+// calls are finished with the exception.
+void RpcClientImpl::failCalls()
+{
+    std::vector<IRemoteProcedure*> procs;
+    for (const auto& call: _inOrder)
+        if (call.proc)
+            procs.push_back(call.proc);
+    for (const auto& it: _tagged)
+        if (it.second.proc)
+            procs.push_back(it.second.proc);
+    for (const auto& call: _waiting)
+        if (call.proc)
+            procs.push_back(call.proc);
+
+    cancel();
+
+    if (procs.empty())
+        throw;
+
+    bool unhandled = false;
+    for (auto proc: procs)
+    {
+        _exceptionPending = true;
+        proc->onFinished();
+        if (_exceptionPending)
+            unhandled = true;
+    }
+
+    _exceptionPending = false;
+
+    if (unhandled)
+        throw;
 }
 
 void RpcClientImpl::onConnect(net::TcpSocket& socket)
@@ -284,19 +776,7 @@ void RpcClientImpl::onConnect(net::TcpSocket& socket)
     }
     catch (const std::exception& )
     {
-        IRemoteProcedure* proc = _proc;
-        cancel();
-
-        if (!proc)
-            throw;
-
-        _exceptionPending = true;
-        Resetter<bool> exceptionPending(_exceptionPending, false);
-
-        proc->onFinished();
-
-        if (_exceptionPending)
-            throw;
+        failCalls();
     }
 }
 
@@ -313,19 +793,7 @@ void RpcClientImpl::onSslConnect(net::TcpSocket& socket)
     }
     catch (const std::exception& )
     {
-        IRemoteProcedure* proc = _proc;
-        cancel();
-
-        if (!proc)
-            throw;
-
-        _exceptionPending = true;
-        Resetter<bool> exceptionPending(_exceptionPending, false);
-
-        proc->onFinished();
-
-        if (_exceptionPending)
-            throw;
+        failCalls();
     }
 }
 
@@ -337,29 +805,21 @@ void RpcClientImpl::onOutput(StreamBuffer& sb)
         sb.endWrite();
         if (sb.out_avail() > 0)
             sb.beginWrite();
-        else
+
+        // replies are read while further requests are sent
+        if (!sb.reading())
             sb.beginRead();
     }
     catch (const std::exception&)
     {
-        IRemoteProcedure* proc = _proc;
-        cancel();
-
-        if (!proc)
-            throw;
-
-        _exceptionPending = true;
-        Resetter<bool> exceptionPending(_exceptionPending, false);
-
-        proc->onFinished();
-
-        if (_exceptionPending)
-            throw;
+        failCalls();
     }
 }
 
 void RpcClientImpl::onInput(StreamBuffer& sb)
 {
+    std::exception_ptr fault;
+
     try
     {
         _exceptionPending = false;
@@ -368,13 +828,43 @@ void RpcClientImpl::onInput(StreamBuffer& sb)
         if (sb.device()->eof())
             throw IOError("end of input");
 
-        if (_scanner.advance(sb))
+        while (sb.in_avail() > 0)
         {
-            _scanner.finish();
-            IRemoteProcedure* proc = _proc;
-            _proc = 0;
-            proc->onFinished();
-            return;
+            if (_current == 0)
+            {
+                // a tagged reply starts with '\xc4' and the id of the call
+                if (_tagCount == 0
+                    && sb.sgetc() == StreamBuffer::traits_type::to_int_type('\xc4'))
+                {
+                    sb.sbumpc();
+                    _tagCount = 4;
+                    _tagId = 0;
+                    continue;
+                }
+
+                if (_tagCount > 0)
+                {
+                    _tagId = (_tagId << 8) | static_cast<unsigned char>(sb.sbumpc());
+                    if (--_tagCount > 0)
+                        continue;
+
+                    auto it = _tagged.find(_tagId);
+                    if (it == _tagged.end())
+                        throw std::runtime_error("reply to unknown call received");
+                    _current = &it->second;
+                }
+                else
+                {
+                    if (_inOrder.empty())
+                        throw std::runtime_error("unexpected reply received");
+                    _current = &_inOrder.front();
+                }
+
+                _scanner.begin(_deserializer, *_current->result);
+            }
+
+            if (_scanner.advance(sb))
+                finishCall(*_current, fault);
         }
 
         if (!_stream)
@@ -383,24 +873,18 @@ void RpcClientImpl::onInput(StreamBuffer& sb)
             throw std::runtime_error("reading result failed");
         }
 
-        sb.beginRead();
+        if ((!_inOrder.empty() || !_tagged.empty()) && _socket.isConnected() && !sb.reading())
+            sb.beginRead();
     }
     catch (const std::exception&)
     {
-        IRemoteProcedure* proc = _proc;
-        cancel();
-
-        if (!proc)
-            throw;
-
-        _exceptionPending = true;
-        Resetter<bool> exceptionPending(_exceptionPending, false);
-
-        proc->onFinished();
-
-        if (_exceptionPending)
-            throw;
+        failCalls();
     }
+
+    // remote errors not taken by the callback are thrown to the caller of
+    // the event loop after the other replies are processed
+    if (fault)
+        std::rethrow_exception(fault);
 }
 
 }
@@ -39,7 +39,12 @@
 #include <cxxtools/refcounted.h>
 #include <cxxtools/timespan.h>
 #include <cxxtools/sslctx.h>
+#include <cxxtools/rpccontext.h>
 #include <string>
+#include <deque>
+#include <exception>
+#include <unordered_map>
+#include <stdint.h>
 #include "scanner.h"
 
 namespace cxxtools
@@ -82,17 +87,23 @@ class RpcClientImpl : public RefCounted, public Connectable
 
         void call(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc);
 
+        // Sends the request of a streaming procedure; the elements are read
+        // with readStream, which returns false at the end of the stream.
+        void beginStream(IRemoteProcedure& method, IDecomposer** argv, unsigned argc);
+        bool readStream(IComposer& r);
+
         Timespan timeout() const  { return _timeout; }
         void timeout(Timespan t)  { _timeout = t; if (!_connectTimeoutSet) _connectTimeout = t; }
 
         Timespan connectTimeout() const  { return _connectTimeout; }
         void connectTimeout(Timespan t)  { _connectTimeout = t; _connectTimeoutSet = true; }
 
-        const IRemoteProcedure* activeProcedure() const
-        { return _proc; }
+        const IRemoteProcedure* activeProcedure() const;
 
         void cancel();
 
+        void cancelCall(const IRemoteProcedure& proc);
+
         void wait(Timespan msecs);
 
         const std::string& domain() const
@@ -102,7 +113,87 @@ class RpcClientImpl : public RefCounted, public Connectable
         { _domain = p; }
 
     private:
-        void prepareRequest(const String& name, IDecomposer** argv, unsigned argc);
+        // requests, which ask the server for an extension of the protocol
+        enum class Negotiation
+        {
+            none,
+            multiplex,      // "cxxtools.multiplex"
+            deadline        // "cxxtools.deadline"
+        };
+
+        // An asynchronous call, which is sent or waits to be sent.
+        //
+        // Calls are sent untagged as long as no other call is running, so that
+        // a single call looks exactly as before. When a second call is started,
+        // the client asks the server with the request "cxxtools.multiplex"
+        // whether it understands tagged requests. A tagged request or reply is
+        // prefixed with '\xc4' and a 4 byte call id, so that the replies may
+        // arrive in any order. Servers, which do not know the request, reply
+        // with an error and get the following calls pipelined and untagged.
+        //
+        // The deadline of a call is passed with the prefix '\xc7' and the time
+        // left in ms. It is sent only, when the server accepted the request
+        // "cxxtools.deadline", which is sent before the first call with a
+        // deadline or together with "cxxtools.multiplex".
+        struct Call
+        {
+            IRemoteProcedure* proc;     // null, when cancelled or negotiating
+            IComposer* result;
+            Negotiation negotiation;
+            std::string request;        // formatted request, while waiting for negotiation
+            RpcContext::Clock::time_point deadline;  // of a waiting request
+
+            Call(IRemoteProcedure* proc_, IComposer* result_, Negotiation negotiation_ = Negotiation::none)
+                : proc(proc_),
+                  result(result_),
+                  negotiation(negotiation_),
+                  deadline(RpcContext::Clock::time_point::max())
+                { }
+        };
+
+        // state of the connection regarding tagged requests
+        enum class Protocol
+        {
+            plain,          // not negotiated yet
+            negotiating,    // negotiation request sent
+            multiplexed,    // server accepts tagged requests
+            sequential      // server accepts only untagged requests
+        };
+
+        // state of the connection regarding deadlines
+        enum class Deadlines
+        {
+            unknown,        // not negotiated yet
+            negotiating,    // negotiation request sent
+            accepted,       // server reads the prefix '\xc7'
+            refused         // requests are sent without deadline
+        };
+
+        // receives replies of cancelled calls
+        class DiscardComposer : public IComposer
+        {
+            public:
+                void fixup(SerializationInfo&) override { }
+        };
+
+        void prepareRequest(std::ostream& out, const String& name, IDecomposer** argv, unsigned argc);
+        void writeDeadline(std::ostream& out, RpcContext::Clock::time_point deadline);
+        void sendRequest(IDecomposer** argv, unsigned argc);
+        bool negotiateDeadlines();
+        Timespan callTimeout() const;
+        void askDeadlines();
+        void sendCall(Call&& call);
+        uint32_t nextId();
+        void negotiated(Negotiation negotiation, bool accepted);
+        bool negotiating() const
+            { return _protocol == Protocol::negotiating || _deadlines == Deadlines::negotiating; }
+        bool established() const;
+        void clearCalls();
+        std::size_t callsRunning() const
+            { return _inOrder.size() + _tagged.size() + _waiting.size(); }
+        void finishCall(Call& call, std::exception_ptr& fault);
+        void failCalls();
+
         void onConnect(net::TcpSocket& socket);
         void onSslConnect(net::TcpSocket& socket);
         void onOutput(StreamBuffer& sb);
@@ -122,7 +213,19 @@ class RpcClientImpl : public RefCounted, public Connectable
         Formatter _formatter;
 
         bool _exceptionPending;
-        IRemoteProcedure* _proc;
+        IRemoteProcedure* _proc;    // running synchronous call
+
+        // asynchronous calls
+        Protocol _protocol;
+        Deadlines _deadlines;
+        std::deque<Call> _inOrder;  // sent untagged; replied in order
+        std::unordered_map<uint32_t, Call> _tagged;
+        std::deque<Call> _waiting;  // waiting for the negotiation
+        uint32_t _nextId;
+        Call* _current;             // call, which reply is read
+        unsigned _tagCount;         // bytes of the call id left to read
+        uint32_t _tagId;
+        DiscardComposer _discard;
 
         Timespan _timeout;
         bool _connectTimeoutSet;  // indicates if connectTimeout is explicitely set
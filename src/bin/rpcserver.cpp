@@ -109,6 +109,16 @@ void RpcServer::maxThreads(unsigned m)
     _impl->maxThreads(m);
 }
 
+unsigned RpcServer::maxCallsPerConnection() const
+{
+    return _impl->maxCallsPerConnection();
+}
+
+void RpcServer::maxCallsPerConnection(unsigned m)
+{
+    _impl->maxCallsPerConnection(m);
+}
+
 Delegate<bool, const SslCertificate&>& RpcServer::acceptSslCertificate()
 {
     return _impl->acceptSslCertificate;
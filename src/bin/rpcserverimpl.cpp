@@ -30,6 +30,7 @@
 #include "socket.h"
 #include "worker.h"
 
+#include <cxxtools/asyncdone.h>
 #include <cxxtools/eventloop.h>
 #include <cxxtools/net/tcpserver.h>
 #include <cxxtools/log.h>
@@ -56,6 +57,39 @@ class IdleSocketEvent : public BasicEvent<IdleSocketEvent>
 
 };
 
+// Sent from the worker thread when a client asked for tagged requests.
+// The event loop runs the connection from now on.
+class MultiplexedSocketEvent : public BasicEvent<MultiplexedSocketEvent>
+{
+        Socket* _socket;
+
+    public:
+        explicit MultiplexedSocketEvent(Socket* socket)
+            : _socket(socket)
+            { }
+
+        Socket* socket() const   { return _socket; }
+};
+
+// Sent when a multiplexed connection is closed. The socket is deleted,
+// when no calls are running any more.
+class MultiplexedReleasedEvent : public BasicEvent<MultiplexedReleasedEvent>
+{
+        Socket* _socket;
+
+    public:
+        explicit MultiplexedReleasedEvent(Socket* socket)
+            : _socket(socket)
+            { }
+
+        Socket* socket() const   { return _socket; }
+};
+
+// Sent from a worker, when calls of multiplexed connections are finished.
+class CallsFinishedEvent : public BasicEvent<CallsFinishedEvent>
+{
+};
+
 // Sent from the server when constructed, so that the server
 // knows, when the event loop is running.
 class ServerStartEvent : public BasicEvent<ServerStartEvent>
@@ -99,9 +133,13 @@ RpcServerImpl::RpcServerImpl(EventLoopBase& eventLoop, Signal<RpcServer::Runmode
       inputSlot(slot(*this, &RpcServerImpl::onInput)),
       _serviceRegistry(serviceRegistry),
       _minThreads(5),
-      _maxThreads(200)
+      _maxThreads(200),
+      _maxCallsPerConnection(64)
 {
     _eventLoop.event.subscribe(slot(*this, &RpcServerImpl::onIdleSocket));
+    _eventLoop.event.subscribe(slot(*this, &RpcServerImpl::onMultiplexedSocket));
+    _eventLoop.event.subscribe(slot(*this, &RpcServerImpl::onMultiplexedReleased));
+    _eventLoop.event.subscribe(slot(*this, &RpcServerImpl::onCallsFinished));
     _eventLoop.event.subscribe(slot(*this, &RpcServerImpl::onNoWaitingThreads));
     _eventLoop.event.subscribe(slot(*this, &RpcServerImpl::onThreadTerminated));
     _eventLoop.event.subscribe(slot(*this, &RpcServerImpl::onServerStart));
@@ -113,6 +151,9 @@ RpcServerImpl::RpcServerImpl(EventLoopBase& eventLoop, Signal<RpcServer::Runmode
 
 RpcServerImpl::~RpcServerImpl()
 {
+    // calls of asynchronous procedures, which finished after terminate
+    for (auto call: _finishedCalls)
+        delete call;
 }
 
 void RpcServerImpl::listen(const std::string& ip, unsigned short int port, const SslCtx& sslCtx)
@@ -195,14 +236,30 @@ void RpcServerImpl::terminate()
 
         _listener.clear();
 
+        cancelAsync();
+
         while (!_queue.empty())
-            delete _queue.get();
+        {
+            Job job = _queue.get();
+            delete job.call;
+            delete job.socket;
+        }
+
+        for (auto call: _finishedCalls)
+            delete call;
+
+        _finishedCalls.clear();
 
         for (IdleSocket::iterator it = _idleSocket.begin(); it != _idleSocket.end(); ++it)
             delete *it;
 
         _idleSocket.clear();
 
+        for (auto socket: _multiplexedSockets)
+            delete socket;
+
+        _multiplexedSockets.clear();
+
         runmode(RpcServer::Stopped);
     }
     catch (const std::exception& e)
@@ -213,7 +270,7 @@ void RpcServerImpl::terminate()
 
 void RpcServerImpl::noWaitingThreads()
 {
-    if (runmode() == RpcServer::Running)
+    if (isRunning())
         _eventLoop.commitEvent(NoWaitingThreadsEvent());
 }
 
@@ -238,7 +295,7 @@ void RpcServerImpl::addIdleSocket(Socket* socket)
 {
     log_debug("add idle socket " << static_cast<void*>(socket));
 
-    if (runmode() == RpcServer::Running)
+    if (isRunning())
     {
         _eventLoop.commitEvent(IdleSocketEvent(socket));
     }
@@ -249,6 +306,79 @@ void RpcServerImpl::addIdleSocket(Socket* socket)
     }
 }
 
+void RpcServerImpl::addAsync(Socket* socket, const std::shared_ptr<AsyncDone>& done)
+{
+    std::lock_guard<std::mutex> lock(_asyncMutex);
+    _asyncSockets[socket] = done;
+}
+
+void RpcServerImpl::addAsync(Call* call, const std::shared_ptr<AsyncDone>& done)
+{
+    std::lock_guard<std::mutex> lock(_asyncMutex);
+    _asyncCalls[call] = done;
+}
+
+// Deletes the connections and calls, which wait for a asynchronous procedure.
+// A procedure, which replies meanwhile, finishes before cancel returns and
+// does not find its connection or call in the server any more.
+void RpcServerImpl::cancelAsync()
+{
+    std::map<Socket*, std::shared_ptr<AsyncDone>> sockets;
+    std::map<Call*, std::shared_ptr<AsyncDone>> calls;
+
+    {
+        std::lock_guard<std::mutex> lock(_asyncMutex);
+        sockets.swap(_asyncSockets);
+        calls.swap(_asyncCalls);
+    }
+
+    log_debug("cancel " << sockets.size() + calls.size() << " asynchronous procedures");
+
+    for (auto& it: sockets)
+    {
+        it.second->cancel();
+        delete it.first;
+    }
+
+    for (auto& it: calls)
+    {
+        it.second->cancel();
+        delete it.first;
+    }
+}
+
+void RpcServerImpl::resume(Socket* socket)
+{
+    std::lock_guard<std::mutex> lock(_asyncMutex);
+
+    // terminate deletes the socket, when it is not found
+    if (_asyncSockets.erase(socket) == 0)
+        return;
+
+    if (isRunning())
+    {
+        _queue.put(socket);
+    }
+    else
+    {
+        log_debug("server not running; delete " << static_cast<void*>(socket));
+        delete socket;
+    }
+}
+
+void RpcServerImpl::asyncCallFinished(Call* call)
+{
+    {
+        std::lock_guard<std::mutex> lock(_asyncMutex);
+
+        // terminate deletes the call, when it is not found
+        if (_asyncCalls.erase(call) == 0)
+            return;
+    }
+
+    callFinished(call);
+}
+
 void RpcServerImpl::onIdleSocket(const IdleSocketEvent& event)
 {
     Socket* socket = event.socket();
@@ -260,6 +390,98 @@ void RpcServerImpl::onIdleSocket(const IdleSocketEvent& event)
     socket->inputConnection = socket->inputReady.connect(inputSlot);
 }
 
+void RpcServerImpl::addMultiplexedSocket(Socket* socket)
+{
+    log_debug("add multiplexed socket " << static_cast<void*>(socket));
+
+    if (isRunning())
+    {
+        _eventLoop.commitEvent(MultiplexedSocketEvent(socket));
+    }
+    else
+    {
+        log_debug("server not running; delete " << static_cast<void*>(socket));
+        delete socket;
+    }
+}
+
+void RpcServerImpl::onMultiplexedSocket(const MultiplexedSocketEvent& event)
+{
+    Socket* socket = event.socket();
+
+    log_debug("add multiplexed socket " << static_cast<void*>(socket) << " to selector");
+
+    _multiplexedSockets.insert(socket);
+    socket->setSelector(&_eventLoop);
+    socket->inputConnection = socket->buffer().inputReady.connect(socket->inputSlot);
+    socket->startMultiplexed();
+}
+
+void RpcServerImpl::releaseMultiplexedSocket(Socket* socket)
+{
+    socket->cancelCalls();
+
+    // the socket is deleted later, since it may be in use by the caller
+    _eventLoop.commitEvent(MultiplexedReleasedEvent(socket));
+}
+
+void RpcServerImpl::onMultiplexedReleased(const MultiplexedReleasedEvent& event)
+{
+    Socket* socket = event.socket();
+
+    if (_multiplexedSockets.find(socket) != _multiplexedSockets.end()
+        && !socket->isConnected() && socket->callsRunning() == 0)
+    {
+        deleteMultiplexedSocket(socket);
+    }
+}
+
+void RpcServerImpl::deleteMultiplexedSocket(Socket* socket)
+{
+    log_debug("multiplexed connection closed; delete " << static_cast<void*>(socket));
+    log_info("client " << socket->getPeerAddr() << " closed connection");
+    _multiplexedSockets.erase(socket);
+    socket->removeSelector();
+    delete socket;
+}
+
+void RpcServerImpl::dispatch(Call* call)
+{
+    _queue.put(Job(call));
+}
+
+void RpcServerImpl::callFinished(Call* call)
+{
+    std::lock_guard<std::mutex> lock(_callMutex);
+
+    // the event loop is woken once for all calls finished meanwhile
+    _finishedCalls.push_back(call);
+    if (_finishedCalls.size() == 1 && isRunning())
+        _eventLoop.commitEvent(CallsFinishedEvent());
+}
+
+void RpcServerImpl::onCallsFinished(const CallsFinishedEvent& /*event*/)
+{
+    std::vector<Call*> calls;
+
+    {
+        std::lock_guard<std::mutex> lock(_callMutex);
+        calls.swap(_finishedCalls);
+    }
+
+    log_debug(calls.size() << " calls finished");
+
+    for (auto call: calls)
+    {
+        Socket* socket = &call->socket();
+        socket->finishCall(*call);
+        delete call;
+
+        if (!socket->isConnected() && socket->callsRunning() == 0)
+            deleteMultiplexedSocket(socket);
+    }
+}
+
 void RpcServerImpl::onNoWaitingThreads(const NoWaitingThreadsEvent& /*event*/)
 {
     std::lock_guard<std::mutex> lock(_threadMutex);
@@ -38,6 +38,7 @@
 
 #include <mutex>
 #include <condition_variable>
+#include <map>
 #include <set>
 #include <vector>
 #include <memory>
@@ -45,6 +46,7 @@
 namespace cxxtools
 {
 
+class AsyncDone;
 class EventLoopBase;
 class ServiceProcedure;
 class SslCtx;
@@ -59,12 +61,34 @@ namespace bin
     class RpcServerImpl;
     class Worker;
     class Socket;
+    class Call;
     class IdleSocketEvent;
+    class MultiplexedSocketEvent;
+    class MultiplexedReleasedEvent;
+    class CallsFinishedEvent;
     class ServerStartEvent;
     class NoWaitingThreadsEvent;
     class ThreadTerminatedEvent;
     class ActiveSocketEvent;
 
+    // Entry of the worker queue: a socket with input or a call of a
+    // multiplexed connection.
+    struct Job
+    {
+        Job(Socket* socket_ = 0)
+            : socket(socket_),
+              call(0)
+            { }
+
+        explicit Job(Call* call_)
+            : socket(0),
+              call(call_)
+            { }
+
+        Socket* socket;
+        Call* call;
+    };
+
     class RpcServerImpl : public Connectable
     {
             RpcServerImpl(const RpcServerImpl&) = delete;
@@ -88,6 +112,12 @@ namespace bin
             void maxThreads(unsigned m)
             { _maxThreads = m; }
 
+            unsigned maxCallsPerConnection() const
+            { return _maxCallsPerConnection; }
+
+            void maxCallsPerConnection(unsigned m)
+            { _maxCallsPerConnection = m > 0 ? m : 1; }
+
             void terminate();
 
             RpcServer::Runmode runmode() const
@@ -112,6 +142,27 @@ namespace bin
 
             void addIdleSocket(Socket* socket);
             void onIdleSocket(const IdleSocketEvent& event);
+
+            // Asynchronous procedures, which did not reply yet, are tracked,
+            // so that terminate cancels them.
+            void addAsync(Socket* socket, const std::shared_ptr<AsyncDone>& done);
+            void addAsync(Call* call, const std::shared_ptr<AsyncDone>& done);
+            void cancelAsync();
+
+            // passes a socket to the workers, when its asynchronous procedure finished
+            void resume(Socket* socket);
+            void asyncCallFinished(Call* call);
+
+            // multiplexed connections
+            void addMultiplexedSocket(Socket* socket);
+            void releaseMultiplexedSocket(Socket* socket);
+            void dispatch(Call* call);
+            void callFinished(Call* call);
+            void onMultiplexedSocket(const MultiplexedSocketEvent& event);
+            void onMultiplexedReleased(const MultiplexedReleasedEvent& event);
+            void onCallsFinished(const CallsFinishedEvent& event);
+            void deleteMultiplexedSocket(Socket* socket);
+
             void onActiveSocket(const ActiveSocketEvent& event);
             void onNoWaitingThreads(const NoWaitingThreadsEvent& event);
             void onThreadTerminated(const ThreadTerminatedEvent& event);
@@ -120,6 +171,7 @@ namespace bin
 
             friend class Worker;
             friend class Socket;
+            friend class Call;
 
             ////////////////////////////////////////////////////
 
@@ -128,13 +180,22 @@ namespace bin
             ServiceRegistry& _serviceRegistry;
             unsigned _minThreads;
             unsigned _maxThreads;
+            unsigned _maxCallsPerConnection;
 
             std::vector<std::unique_ptr<net::TcpServer>> _listener;
-            Queue<Socket*> _queue;
+            Queue<Job> _queue;
 
             typedef std::set<Socket*> IdleSocket;
             IdleSocket _idleSocket;
 
+            std::set<Socket*> _multiplexedSockets;  // owned by the event loop
+            std::mutex _callMutex;
+            std::vector<Call*> _finishedCalls;
+
+            std::mutex _asyncMutex;
+            std::map<Socket*, std::shared_ptr<AsyncDone>> _asyncSockets;
+            std::map<Call*, std::shared_ptr<AsyncDone>> _asyncCalls;
+
             std::mutex _threadMutex;
             std::condition_variable _threadTerminated;
             typedef std::set<Worker*> Threads;
@@ -144,6 +205,10 @@ namespace bin
 
             bool isTerminating() const
             { return runmode() == RpcServer::Terminating; }
+
+            // the workers run already, while the server is starting
+            bool isRunning() const
+            { return runmode() == RpcServer::Starting || runmode() == RpcServer::Running; }
     };
 }
 }
@@ -41,9 +41,13 @@ namespace cxxtools
 namespace bin
 {
 
-void Scanner::begin(Deserializer& handler, IComposer& composer)
+void Scanner::begin(Deserializer& handler, IComposer& composer, bool stream)
 {
-    _vp.begin(handler);
+    _direct = composer.direct();
+    if (_direct)
+        _vp.begin(*_direct);
+    else
+        _vp.begin(handler);
     _deserializer = &handler;
     _composer = &composer;
     _deserializer->begin();
@@ -51,6 +55,20 @@ void Scanner::begin(Deserializer& handler, IComposer& composer)
     _failed = false;
     _errorCode = 0;
     _errorMessage.clear();
+    _stream = stream;
+    _element = false;
+}
+
+void Scanner::composer(IComposer& composer)
+{
+    // the value read so far belongs to the replaced composer
+    if (_direct)
+    {
+        _vp.discard();
+        _direct = 0;
+    }
+
+    _composer = &composer;
 }
 
 bool Scanner::advance(std::streambuf& in)
@@ -73,6 +91,16 @@ bool Scanner::advance(std::streambuf& in)
                     _state = state_errorcode;
                     _count = 4;
                 }
+                else if (ch == '\xc5' && _stream)
+                {
+                    _element = true;
+                    _state = state_value;
+                }
+                else if (ch == '\xc6' && _stream)
+                {
+                    log_info_to(rpc, static_cast<void*>(this) << " stream finished successfully");
+                    _state = state_end;
+                }
                 else
                     throw std::runtime_error("response expected");
 
@@ -82,16 +110,30 @@ bool Scanner::advance(std::streambuf& in)
             case state_value:
                 if (_vp.advance(in))
                 {
-                    log_info_to(rpc, static_cast<void*>(this) << " call finished successfully");
-                    log_debug(_deserializer->si());
-                    _composer->fixup(_deserializer->si());
-                    _deserializer->clear();
+                    if (_element)
+                    {
+                        log_debug("stream element received");
+                    }
+                    else
+                    {
+                        log_info_to(rpc, static_cast<void*>(this) << " call finished successfully");
+                    }
+                    if (_direct)
+                    {
+                        _direct->finish();
+                    }
+                    else
+                    {
+                        log_debug(_deserializer->si());
+                        _composer->fixup(_deserializer->si());
+                        _deserializer->clear();
+                    }
                     _state = state_end;
                 }
                 break;
 
             case state_errorcode:
-                _errorCode = (_errorCode << 8) | ch;
+                _errorCode = (_errorCode << 8) | static_cast<unsigned char>(ch);
                 if (--_count == 0)
                     _state = state_errormessage;
                 in.sbumpc();
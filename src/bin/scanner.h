@@ -48,17 +48,29 @@ namespace cxxtools
                     : _state(state_0),
                       _deserializer(0),
                       _composer(0),
+                      _direct(0),
                       _count(0),
                       _failed(false),
-                      _errorCode(0)
+                      _errorCode(0),
+                      _stream(false),
+                      _element(false)
                 { }
 
-                void begin(Deserializer& handler, IComposer& composer);
+                // With `stream` set, the reply may also be a element of a
+                // stream ('\xc5') or the end of it ('\xc6').
+                void begin(Deserializer& handler, IComposer& composer, bool stream = false);
+
+                // replaces the composer of the running reply
+                void composer(IComposer& composer);
 
                 bool advance(std::streambuf& in);
 
                 void finish();
 
+                // true, when the reply read was a element of a stream
+                bool element() const
+                { return _element; }
+
             private:
                 enum
                 {
@@ -72,12 +84,16 @@ namespace cxxtools
                 Parser _vp;
                 Deserializer* _deserializer;
                 IComposer* _composer;
+                IDirectComposer* _direct;
 
                 unsigned short _count;
 
                 bool _failed;
                 int _errorCode;
                 std::string _errorMessage;
+
+                bool _stream;
+                bool _element;
         };
     }
 }
@@ -28,7 +28,9 @@
 
 #include "socket.h"
 #include "rpcserverimpl.h"
+#include <cxxtools/asyncdone.h>
 #include <cxxtools/log.h>
+#include <algorithm>
 
 log_define("cxxtools.bin.socket")
 
@@ -37,13 +39,27 @@ namespace cxxtools
 namespace bin
 {
 
+namespace
+{
+    // the stream buffer of the socket holds 8k; larger pieces would flush blocking
+    const std::size_t outputChunkSize = 8192;
+
+    // no further requests are read from a multiplexed connection, while
+    // more replies than this are waiting for the client
+    const std::size_t outputHighWater = 1024 * 1024;
+}
+
 Socket::Socket(RpcServerImpl& rpcServerImpl, net::TcpServer& tcpServer, const SslCtx& sslCtx)
     : inputSlot(slot(*this, &Socket::onInput)),
       _rpcServerImpl(rpcServerImpl),
       _tcpServer(tcpServer),
       _sslCtx(sslCtx),
       _responder(rpcServerImpl._serviceRegistry),
-      _accepted(false)
+      _accepted(false),
+      _inLoop(false),
+      _throttled(false),
+      _outputPos(0),
+      _asyncPending(0)
 {
     _stream.attachDevice(*this);
     cxxtools::connect(IODevice::inputReady, *this, &Socket::onIODeviceInput);
@@ -59,7 +75,11 @@ Socket::Socket(Socket& socket)
       _tcpServer(socket._tcpServer),
       _sslCtx(socket._sslCtx),
       _responder(_rpcServerImpl._serviceRegistry),
-      _accepted(false)
+      _accepted(false),
+      _inLoop(false),
+      _throttled(false),
+      _outputPos(0),
+      _asyncPending(0)
 {
     _stream.attachDevice(*this);
     cxxtools::connect(IODevice::inputReady, *this, &Socket::onIODeviceInput);
@@ -114,6 +134,12 @@ void Socket::onInput(StreamBuffer& sb)
 {
     log_debug("onInput");
 
+    if (multiplexed())
+    {
+        onMultiplexedInput(sb);
+        return;
+    }
+
     sb.endRead();
 
     if (sb.in_avail() == 0 || sb.device()->eof())
@@ -127,12 +153,40 @@ void Socket::onInput(StreamBuffer& sb)
         sb.beginWrite();
         onOutput(sb);
     }
+    else if (_responder.deferred())
+    {
+        beginAsync();
+    }
     else
     {
         sb.beginRead();
     }
 }
 
+void Socket::beginAsync()
+{
+    _asyncPending = 2;
+
+    // The socket comes back with the last release, which is the one of the
+    // worker at the earliest, so the server knows the procedure in time.
+    auto done = std::make_shared<AsyncDone>([this] () { releaseAsync(); });
+    _responder.beginAsync([done] () { (*done)(); });
+    _rpcServerImpl.addAsync(this, done);
+}
+
+void Socket::releaseAsync()
+{
+    if (--_asyncPending == 0)
+        _rpcServerImpl.resume(this);
+}
+
+void Socket::finishAsync()
+{
+    _responder.finishAsync(_stream);
+    buffer().beginWrite();
+    onOutput(buffer());
+}
+
 bool Socket::onOutput(StreamBuffer& sb)
 {
     log_trace("onOutput");
@@ -147,6 +201,11 @@ bool Socket::onOutput(StreamBuffer& sb)
         {
             sb.beginWrite();
         }
+        else if (multiplexed())
+        {
+            flushOutput();
+            resumeInput();
+        }
         else
         {
             if (sb.in_avail())
@@ -159,12 +218,176 @@ bool Socket::onOutput(StreamBuffer& sb)
     {
         log_warn("exception occured when processing request: " << e.what());
         close();
+        if (_inLoop)
+            _rpcServerImpl.releaseMultiplexedSocket(this);
         return false;
     }
 
     return true;
 }
 
+void Socket::startMultiplexed()
+{
+    _inLoop = true;
+
+    try
+    {
+        // requests may be left from the worker
+        readMultiplexed(buffer());
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("failed to read request from " << getPeerAddr() << ": " << e.what());
+        close();
+        _rpcServerImpl.releaseMultiplexedSocket(this);
+    }
+}
+
+void Socket::onMultiplexedInput(StreamBuffer& sb)
+{
+    try
+    {
+        sb.endRead();
+
+        if (sb.in_avail() == 0 || sb.device()->eof())
+        {
+            log_debug("client " << getPeerAddr() << " closed multiplexed connection");
+            close();
+            _rpcServerImpl.releaseMultiplexedSocket(this);
+            return;
+        }
+
+        readMultiplexed(sb);
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("failed to read request from " << getPeerAddr() << ": " << e.what());
+        close();
+        _rpcServerImpl.releaseMultiplexedSocket(this);
+    }
+}
+
+// Dispatches the buffered requests and reads more, unless the limits of
+// the connection are reached. The rest of the input is kept in the buffer
+// then and resumeInput continues, when calls are finished or replies sent.
+void Socket::readMultiplexed(StreamBuffer& sb)
+{
+    dispatchCalls(sb);
+
+    if (throttled())
+    {
+        if (!_throttled)
+            log_debug("stop reading from " << getPeerAddr() << "; " << _calls.size() << " calls running, "
+                << (_output.size() - _outputPos) << " bytes to send");
+        _throttled = true;
+    }
+    else
+    {
+        _throttled = false;
+        sb.beginRead();
+    }
+}
+
+bool Socket::throttled() const
+{
+    return _calls.size() >= _rpcServerImpl.maxCallsPerConnection()
+        || _output.size() - _outputPos > outputHighWater;
+}
+
+void Socket::resumeInput()
+{
+    if (!_throttled || throttled() || !isConnected())
+        return;
+
+    log_debug("resume reading from " << getPeerAddr());
+
+    try
+    {
+        readMultiplexed(buffer());
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("failed to read request from " << getPeerAddr() << ": " << e.what());
+        close();
+        _rpcServerImpl.releaseMultiplexedSocket(this);
+    }
+}
+
+void Socket::dispatchCalls(StreamBuffer& sb)
+{
+    while (sb.in_avail() > 0 && !throttled())
+    {
+        if (_responder.advance(sb))
+        {
+            Call* call = _responder.detachCall(*this);
+            _calls.push_back(call);
+            _rpcServerImpl.dispatch(call);
+        }
+    }
+}
+
+void Socket::finishCall(const Call& call)
+{
+    _calls.erase(std::find(_calls.begin(), _calls.end(), &call));
+
+    if (!isConnected())
+        return;
+
+    _output += call.reply();
+
+    try
+    {
+        flushOutput();
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("failed to send reply to " << getPeerAddr() << ": " << e.what());
+        close();
+        cancelCalls();
+        return;
+    }
+
+    resumeInput();
+}
+
+void Socket::cancelCalls()
+{
+    log_debug("cancel " << _calls.size() << " calls of closed connection");
+
+    for (auto call: _calls)
+        call->cancel();
+}
+
+// Passes the next chunk of queued replies to the stream buffer.
+void Socket::flushOutput()
+{
+    StreamBuffer& sb = buffer();
+
+    if (sb.writing())
+        return;
+
+    if (sb.out_avail() == 0 && _outputPos < _output.size())
+    {
+        std::size_t n = std::min(_output.size() - _outputPos, outputChunkSize);
+        sb.sputn(_output.data() + _outputPos, n);
+        _outputPos += n;
+
+        if (_outputPos == _output.size())
+        {
+            _output.clear();
+            _outputPos = 0;
+        }
+        else if (_outputPos >= 65536)
+        {
+            _output.erase(0, _outputPos);
+            _outputPos = 0;
+        }
+    }
+
+    if (sb.out_avail() > 0)
+        sb.beginWrite();
+}
+
 bool Socket::onAcceptSslCertificate(const SslCertificate& cert)
 {
     return !_rpcServerImpl.acceptSslCertificate.isConnected() || _rpcServerImpl.acceptSslCertificate(cert);
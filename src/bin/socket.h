@@ -36,6 +36,9 @@
 #include <cxxtools/method.h>
 #include <cxxtools/sslctx.h>
 #include "responder.h"
+#include <atomic>
+#include <string>
+#include <vector>
 
 namespace cxxtools
 {
@@ -61,6 +64,25 @@ class Socket : public net::TcpSocket, public Connectable
         bool onOutput(StreamBuffer& sb);
         bool onAcceptSslCertificate(const SslCertificate& cert);
 
+        // A multiplexed connection is run by the event loop. Requests are
+        // passed to the workers and the replies sent, when they are ready.
+        bool multiplexed() const        { return _responder.multiplexed(); }
+        void startMultiplexed();
+        void finishCall(const Call& call);
+        unsigned callsRunning() const   { return _calls.size(); }
+
+        // Cancels the calls running for a multiplexed connection, which is
+        // closed; procedures see it in RpcContext::cancelled.
+        void cancelCalls();
+
+        // Set, while a asynchronous procedure of a not multiplexed connection
+        // runs. The worker passes the socket on with releaseAsync. The
+        // procedure and the worker release it both; the last one passes it
+        // to the workers again, which send the reply with finishAsync.
+        bool deferred() const           { return _responder.deferred(); }
+        void releaseAsync();
+        void finishAsync();
+
         Signal<Socket&> inputReady;
 
         StreamBuffer& buffer()         { return _stream.buffer(); }
@@ -71,6 +93,14 @@ class Socket : public net::TcpSocket, public Connectable
         Connection timeoutConnection;
 
     private:
+        void onMultiplexedInput(StreamBuffer& sb);
+        void dispatchCalls(StreamBuffer& sb);
+        bool throttled() const;
+        void readMultiplexed(StreamBuffer& sb);
+        void resumeInput();
+        void flushOutput();
+        void beginAsync();
+
         RpcServerImpl& _rpcServerImpl;
         net::TcpServer& _tcpServer;
         SslCtx _sslCtx;
@@ -81,6 +111,16 @@ class Socket : public net::TcpSocket, public Connectable
         int _sslVerifyLevel;
         std::string _sslCa;
         bool _accepted;
+
+        bool _inLoop;   // set, when a multiplexed connection is passed to the event loop
+        bool _throttled;  // set, when reading stopped due to calls running or replies not sent
+
+        // replies of a multiplexed connection, which are not sent yet
+        std::string _output;
+        std::size_t _outputPos;
+        std::vector<Call*> _calls;  // dispatched calls of a multiplexed connection
+
+        std::atomic<unsigned> _asyncPending;
 };
 
 }
@@ -59,18 +59,27 @@ void Worker::run()
     log_debug(static_cast<void*>(this) << " server=" << static_cast<void*>(&_server));
     while (!_server.isTerminating() && _server._queue.numWaiting() < _server.minThreads())
     {
-        Socket* socket = _server._queue.get();
+        Job job = _server._queue.get();
 
         if (_server.isTerminating())
         {
             log_debug("server is terminating - quit thread");
-            _server._queue.put(socket);
+            _server._queue.put(job);
             break;
         }
 
         if (_server._queue.numWaiting() == 0)
             _server.noWaitingThreads();
 
+        if (job.call)
+        {
+            // a request of a multiplexed connection
+            job.call->execute(_server);
+            continue;
+        }
+
+        Socket* socket = job.socket;
+
         try
         {
             if (!socket->hasAccepted())
@@ -100,6 +109,11 @@ void Worker::run()
                     throw;
                 }
             }
+            else if (socket->deferred())
+            {
+                log_debug("send reply of asynchronous procedure to " << socket->getPeerAddr());
+                socket->finishAsync();
+            }
             else if (socket->isConnected())
             {
                 log_debug("process available input from " << socket->getPeerAddr());
@@ -116,14 +130,29 @@ void Worker::run()
             Connection inputConnection = socket->buffer().inputReady.connect(
                 socket->inputSlot);
 
-            while (socket->wait(10) && socket->isConnected())
+            while (!socket->multiplexed() && !socket->deferred()
+                && socket->wait(10) && socket->isConnected())
                 ;
 
-            if (socket->isConnected())
+            if (socket->deferred())
+            {
+                // the socket comes back, when the procedure has finished
+                inputConnection.close();
+                socket->releaseAsync();
+            }
+            else if (socket->isConnected())
             {
-                log_debug("timeout processing socket");
                 inputConnection.close();
-                _server.addIdleSocket(socket);
+                if (socket->multiplexed())
+                {
+                    log_debug("pass multiplexed connection to event loop");
+                    _server.addMultiplexedSocket(socket);
+                }
+                else
+                {
+                    log_debug("timeout processing socket");
+                    _server.addIdleSocket(socket);
+                }
             }
             else if (_server.isTerminating())
             {
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "cxxtools/composer.h"
+#include "cxxtools/utf8codec.h"
+
+namespace cxxtools
+{
+
+void BasicDirectComposer::setCategory(SerializationInfo::Category category)
+{
+    // a value with members reads as null like with operator >>=
+    if (category != SerializationInfo::Value && accept())
+    {
+        _si.setNull();
+        convert();
+    }
+}
+
+void BasicDirectComposer::setNull()
+{
+    if (accept())
+    {
+        _si.setNull();
+        convert();
+    }
+}
+
+void BasicDirectComposer::setValue(int_type value)
+{
+    if (accept())
+    {
+        _si.setValue(value);
+        convert();
+    }
+}
+
+void BasicDirectComposer::setValue(unsigned_type value)
+{
+    if (accept())
+    {
+        _si.setValue(value);
+        convert();
+    }
+}
+
+void BasicDirectComposer::setValue(long double value)
+{
+    if (accept())
+    {
+        _si.setValue(value);
+        convert();
+    }
+}
+
+void BasicDirectComposer::setValue(bool value)
+{
+    if (accept())
+    {
+        _si.setValue(value);
+        convert();
+    }
+}
+
+void BasicDirectComposer::setValue(char value)
+{
+    if (accept())
+    {
+        _si.setValue(value);
+        convert();
+    }
+}
+
+void BasicDirectComposer::setValue(std::string&& value)
+{
+    if (accept())
+    {
+        try
+        {
+            assign(std::move(value));
+        }
+        catch (const SerializationError& e)
+        {
+            fail(e);
+        }
+        catch (const std::exception&)
+        {
+            _error = std::current_exception();
+        }
+    }
+}
+
+void BasicDirectComposer::setUtf8(std::string&& value)
+{
+    if (!accept())
+        return;
+
+    // ASCII text needs no decoding
+    for (char ch: value)
+    {
+        if (ch & '\x80')
+        {
+            _si.setValue(Utf8Codec::decode(value));
+            convert();
+            return;
+        }
+    }
+
+    setValue(std::move(value));
+}
+
+void BasicDirectComposer::beginElement()
+{
+    if (++_depth == 1 && _array && !_error)
+        beginValue();
+}
+
+void BasicDirectComposer::finishElement()
+{
+    if (--_depth == 0 && _array && !_error)
+    {
+        finishValue();
+        ++_count;
+    }
+}
+
+void BasicDirectComposer::finish()
+{
+    if (_error)
+        std::rethrow_exception(_error);
+}
+
+void BasicDirectComposer::reset()
+{
+    _depth = 0;
+    _count = 0;
+    _error = nullptr;
+}
+
+void BasicDirectComposer::convert()
+{
+    try
+    {
+        assign();
+    }
+    catch (const SerializationError& e)
+    {
+        fail(e);
+    }
+    catch (const std::exception&)
+    {
+        _error = std::current_exception();
+    }
+}
+
+void BasicDirectComposer::fail(const SerializationError& e)
+{
+    if (_array)
+        _error = std::make_exception_ptr(SerializationError("Error in line " + std::to_string(_count + 1) + ": " + e.what()));
+    else
+        _error = std::current_exception();
+}
+
+} // namespace cxxtools
@@ -37,6 +37,12 @@ void Formatter::addValueStdString(const std::string& name, const std::string& ty
     addValueString(name, type, String::widen(value));
 }
 
+void Formatter::addValueStdString(const std::string& name, const std::string& type,
+                         const std::string& value)
+{
+    addValueStdString(name, type, std::string(value));
+}
+
 void Formatter::addValueChar(const std::string& name, const std::string& type,
                          char value)
 {
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <cxxtools/histogram.h>
+#include <cxxtools/serializationinfo.h>
+#include <algorithm>
+
+namespace cxxtools
+{
+
+Histogram::Histogram()
+    : _bounds(defaultBounds()),
+      _counters(Buckets + _bounds.size() + 1)
+{
+}
+
+Histogram::Histogram(const std::vector<Timespan>& bounds)
+    : _bounds(bounds),
+      _counters(Buckets + _bounds.size() + 1)
+{
+}
+
+void Histogram::add(Timespan value)
+{
+    unsigned n = std::lower_bound(_bounds.begin(), _bounds.end(), value) - _bounds.begin();
+    int64_t us = value.totalUSecs();
+
+    _counters.add(Buckets + n, 1);
+    _counters.add(Count, 1);
+    _counters.add(Sum, us);
+    _counters.max(Max, us);
+}
+
+Timespan Histogram::quantile(double q) const
+{
+    uint64_t total = count();
+    if (total == 0)
+        return Timespan(0);
+
+    double rank = q * total;
+    uint64_t cumulated = 0;
+    for (unsigned n = 0; n < buckets(); ++n)
+    {
+        uint64_t c = bucketCount(n);
+        if (c > 0 && cumulated + c >= rank)
+        {
+            // values above the last bound are estimated by the maximum
+            if (n == _bounds.size())
+                return max();
+
+            int64_t lower = n == 0 ? 0 : _bounds[n - 1].totalUSecs();
+            int64_t upper = _bounds[n].totalUSecs();
+            double f = (rank - cumulated) / c;
+            return Microseconds(std::min(lower + static_cast<int64_t>(f * (upper - lower)),
+                                         max().totalUSecs()));
+        }
+
+        cumulated += c;
+    }
+
+    return max();
+}
+
+void Histogram::clear()
+{
+    _counters.clear();
+}
+
+const std::vector<Timespan>& Histogram::defaultBounds()
+{
+    static const std::vector<Timespan> bounds = {
+        Microseconds(100), Microseconds(250), Microseconds(500),
+        Milliseconds(1), Milliseconds(2.5), Milliseconds(5),
+        Milliseconds(10), Milliseconds(25), Milliseconds(50),
+        Milliseconds(100), Milliseconds(250), Milliseconds(500),
+        Seconds(1), Seconds(2.5), Seconds(5), Seconds(10)
+    };
+
+    return bounds;
+}
+
+void operator<<= (SerializationInfo& si, const Histogram& histogram)
+{
+    si.addMember("count") <<= histogram.count();
+    si.addMember("sum") <<= histogram.sum().totalMSecs();
+    si.addMember("max") <<= histogram.max().totalMSecs();
+    si.addMember("p50") <<= histogram.quantile(0.5).totalMSecs();
+    si.addMember("p90") <<= histogram.quantile(0.9).totalMSecs();
+    si.addMember("p99") <<= histogram.quantile(0.99).totalMSecs();
+
+    SerializationInfo& b = si.addMember("buckets");
+    b.setCategory(SerializationInfo::Array);
+
+    uint64_t cumulated = 0;
+    for (unsigned n = 0; n + 1 < histogram.buckets(); ++n)
+    {
+        cumulated += histogram.bucketCount(n);
+        SerializationInfo& e = b.addMember();
+        e.addMember("le") <<= histogram.bound(n).totalMSecs();
+        e.addMember("count") <<= cumulated;
+    }
+
+    si.setTypeName("Histogram");
+}
+
+}
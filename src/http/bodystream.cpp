@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cxxtools/http/bodystream.h>
+#include <algorithm>
+#include <cstring>
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+BodyStreamBuf::BodyStreamBuf(BodyStreamBuf&& other)
+    : std::streambuf(other),
+      _data(std::move(other._data))
+{
+    // the pointers refer to the moved buffer
+    other.reset();
+}
+
+BodyStreamBuf& BodyStreamBuf::operator=(BodyStreamBuf&& other)
+{
+    if (this != &other)
+    {
+        std::streambuf::operator=(other);
+        _data = std::move(other._data);
+        other.reset();
+    }
+
+    return *this;
+}
+
+void BodyStreamBuf::reserve(std::size_t size)
+{
+    if (size <= _data.size())
+        return;
+
+    std::size_t p = pptr() - pbase();
+    std::size_t g = gptr() - eback();
+
+    _data.resize(std::max(size, std::max(_data.size() * 2, static_cast<std::size_t>(256))));
+
+    char* b = _data.data();
+    setp(b, b + _data.size());
+    pbump(static_cast<int>(p));
+    setg(b, b + g, b + p);
+}
+
+BodyStreamBuf::int_type BodyStreamBuf::overflow(int_type ch)
+{
+    if (traits_type::eq_int_type(ch, traits_type::eof()))
+        return traits_type::not_eof(ch);
+
+    reserve(size() + 1);
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+    return ch;
+}
+
+BodyStreamBuf::int_type BodyStreamBuf::underflow()
+{
+    // make data written after the last read available
+    if (gptr() < pptr())
+    {
+        setg(eback(), gptr(), pptr());
+        return traits_type::to_int_type(*gptr());
+    }
+
+    return traits_type::eof();
+}
+
+std::streamsize BodyStreamBuf::showmanyc()
+{
+    return gptr() < pptr() ? pptr() - gptr() : -1;
+}
+
+std::streamsize BodyStreamBuf::xsputn(const char* s, std::streamsize n)
+{
+    if (n <= 0)
+        return 0;
+
+    reserve(size() + n);
+
+    // pbump takes an int
+    std::streamsize count = n;
+    while (count > 0)
+    {
+        int c = static_cast<int>(std::min<std::streamsize>(count, 0x40000000));
+        std::memcpy(pptr(), s, c);
+        pbump(c);
+        s += c;
+        count -= c;
+    }
+
+    return n;
+}
+
+BodyStreamBuf::pos_type BodyStreamBuf::seekoff(off_type off, std::ios::seekdir dir, std::ios::openmode which)
+{
+    off_type size = this->size();
+    off_type cur = (which & std::ios::in) ? gptr() - eback() : size;
+    off_type pos = dir == std::ios::beg ? off
+                 : dir == std::ios::end ? size + off
+                 : cur + off;
+
+    if (pos < 0 || pos > size)
+        return pos_type(off_type(-1));
+
+    // the put position can only be moved by discarding the data behind it
+    if (which & std::ios::out)
+    {
+        if (pos != size)
+            return pos_type(off_type(-1));
+    }
+
+    if (which & std::ios::in)
+        setg(eback(), eback() + pos, pptr());
+
+    return pos_type(pos);
+}
+
+BodyStreamBuf::pos_type BodyStreamBuf::seekpos(pos_type pos, std::ios::openmode which)
+{
+    return seekoff(off_type(pos), std::ios::beg, which);
+}
+
+void BodyStreamBuf::assign(const char* data, std::size_t size)
+{
+    reset();
+    xsputn(data, size);
+}
+
+void BodyStreamBuf::reset()
+{
+    if (_data.size() > maxKeptCapacity)
+        std::vector<char>().swap(_data);
+
+    char* b = _data.data();
+    setp(b, b + _data.size());
+    setg(b, b, b);
+}
+
+} // namespace http
+
+} // namespace cxxtools
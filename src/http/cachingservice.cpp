@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cxxtools/http/cachingservice.h>
+#include <cxxtools/http/responder.h>
+#include "cachingserviceimpl.h"
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+CachingService::CachingService(Service& service, std::size_t maxBytes)
+    : _impl(new CachingServiceImpl(service, maxBytes))
+{
+}
+
+CachingService::~CachingService()
+{
+    delete _impl;
+}
+
+void CachingService::addKeyHeader(const std::string& header)
+{
+    _impl->addKeyHeader(header);
+}
+
+std::size_t CachingService::maxBytes() const
+{
+    return _impl->maxBytes();
+}
+
+void CachingService::maxBytes(std::size_t bytes)
+{
+    _impl->maxBytes(bytes);
+}
+
+Milliseconds CachingService::defaultTtl() const
+{
+    return _impl->defaultTtl();
+}
+
+void CachingService::defaultTtl(Milliseconds ttl)
+{
+    _impl->defaultTtl(ttl);
+}
+
+void CachingService::clear()
+{
+    _impl->clear();
+}
+
+std::size_t CachingService::entries() const
+{
+    return _impl->entries();
+}
+
+std::size_t CachingService::bytes() const
+{
+    return _impl->bytes();
+}
+
+uint64_t CachingService::hits() const
+{
+    return _impl->hits();
+}
+
+uint64_t CachingService::misses() const
+{
+    return _impl->misses();
+}
+
+Responder* CachingService::createResponder(const Request& /*request*/)
+{
+    return _impl->createResponder(*this);
+}
+
+void CachingService::releaseResponder(Responder* responder)
+{
+    _impl->releaseResponder(responder);
+}
+
+} // namespace http
+
+} // namespace cxxtools
@@ -0,0 +1,538 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "cachingserviceimpl.h"
+#include "socket.h"
+#include <cxxtools/http/service.h>
+#include <cxxtools/http/responder.h>
+#include <cxxtools/http/request.h>
+#include <cxxtools/http/reply.h>
+#include <cxxtools/clock.h>
+#include <cxxtools/log.h>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <strings.h>
+
+log_define("cxxtools.http.cachingservice")
+
+namespace cxxtools
+{
+namespace http
+{
+
+namespace
+{
+    // Calls the function for each comma separated token of a header value.
+    template <typename Fn>
+    void forEachToken(const char* value, Fn fn)
+    {
+        if (value == 0)
+            return;
+
+        const char* b = value;
+        while (*b)
+        {
+            while (*b == ' ' || *b == '\t' || *b == ',')
+                ++b;
+
+            const char* e = b;
+            while (*e && *e != ',')
+                ++e;
+
+            const char* t = e;
+            while (t > b && (t[-1] == ' ' || t[-1] == '\t'))
+                --t;
+
+            if (t > b)
+                fn(std::string(b, t));
+
+            b = e;
+        }
+    }
+
+    bool isDirective(const std::string& token, const char* name)
+    {
+        return ::strcasecmp(token.c_str(), name) == 0;
+    }
+
+    // Returns true and the number of seconds, when the token is name=seconds.
+    bool getSeconds(const std::string& token, const char* name, long& seconds)
+    {
+        std::size_t n = std::strlen(name);
+        if (token.size() <= n + 1
+            || ::strncasecmp(token.c_str(), name, n) != 0
+            || token[n] != '=')
+            return false;
+
+        std::string value = token.substr(n + 1);
+        if (value.size() >= 2 && value[0] == '"' && value[value.size() - 1] == '"')
+            value = value.substr(1, value.size() - 2);
+
+        char* end;
+        seconds = std::strtol(value.c_str(), &end, 10);
+        return *end == '\0' && seconds >= 0;
+    }
+
+    class CachingResponder : public Responder
+    {
+            CachingServiceImpl& _impl;
+            Responder* _responder;   // of the wrapped service
+            net::TcpSocket* _socket;
+            std::istream* _in;
+            std::string _key;
+            CachingServiceImpl::EntryPtr _entry;
+            CachingServiceImpl::FlightPtr _flight;
+            bool _leader;
+
+            void passOn(Request& request);
+            void endFlight(const Request& request, const Reply* reply);
+
+        public:
+            CachingResponder(Service& service, CachingServiceImpl& impl)
+                : Responder(service),
+                  _impl(impl),
+                  _responder(0),
+                  _socket(0),
+                  _in(0),
+                  _leader(false)
+                { }
+
+            void beginRequest(net::TcpSocket& socket, std::istream& in, Request& request);
+            std::size_t readBody(std::istream& in);
+            void reply(std::ostream& out, Request& request, Reply& reply);
+            void replyError(std::ostream& out, Request& request, Reply& reply, const std::exception& ex);
+
+            void releaseWrapped();
+    };
+
+    void CachingResponder::passOn(Request& request)
+    {
+        _responder = _impl.service().doCreateResponder(request);
+        _responder->beginRequest(*_socket, *_in, request);
+    }
+
+    void CachingResponder::endFlight(const Request& request, const Reply* reply)
+    {
+        if (_leader)
+        {
+            _leader = false;
+            _impl.finish(_key, _flight, request, reply);
+        }
+
+        _flight.reset();
+    }
+
+    void CachingResponder::beginRequest(net::TcpSocket& socket, std::istream& in, Request& request)
+    {
+        Responder::beginRequest(socket, in, request);
+        _socket = &socket;
+        _in = &in;
+
+        if (_impl.cacheable(request))
+        {
+            _key = _impl.key(request);
+            _entry = _impl.lookup(_key, _flight, _leader);
+
+            // a hit or a reply computed by another request
+            if (_entry || (_flight && !_leader))
+                return;
+        }
+
+        passOn(request);
+    }
+
+    std::size_t CachingResponder::readBody(std::istream& in)
+    {
+        return _responder ? _responder->readBody(in)
+                          : Responder::readBody(in);
+    }
+
+    void CachingResponder::reply(std::ostream& out, Request& request, Reply& reply)
+    {
+        if (!_responder && !_entry)
+        {
+            _entry = _impl.wait(_flight);
+            _flight.reset();
+
+            // the reply of the other request could not be cached
+            if (!_entry)
+            {
+                log_debug("compute uncacheable reply for " << _key);
+                passOn(request);
+            }
+        }
+
+        if (_entry)
+        {
+            CachingServiceImpl::send(*_entry, reply, out);
+            _entry.reset();
+            return;
+        }
+
+        try
+        {
+            _responder->reply(out, request, reply);
+        }
+        catch (const std::exception&)
+        {
+            endFlight(request, 0);
+            throw;
+        }
+
+        // the body of a detached reply is not complete yet
+        Socket* s = dynamic_cast<Socket*>(_socket);
+        endFlight(request, s && s->isDetached() ? 0 : &reply);
+    }
+
+    void CachingResponder::replyError(std::ostream& out, Request& request, Reply& reply, const std::exception& ex)
+    {
+        endFlight(request, 0);
+        _entry.reset();
+
+        if (_responder)
+            _responder->replyError(out, request, reply, ex);
+        else
+            Responder::replyError(out, request, reply, ex);
+    }
+
+    void CachingResponder::releaseWrapped()
+    {
+        if (_leader)
+        {
+            _leader = false;
+            _impl.finish(_key, _flight, Request(), 0);
+        }
+
+        _flight.reset();
+        _entry.reset();
+
+        if (_responder)
+        {
+            _responder->release();
+            _responder = 0;
+        }
+    }
+}
+
+CachingServiceImpl::CachingServiceImpl(Service& service, std::size_t maxBytes)
+    : _service(service),
+      _maxBytes(maxBytes),
+      _defaultTtl(0),
+      _bytes(0),
+      _hits(0),
+      _misses(0)
+{
+}
+
+Responder* CachingServiceImpl::createResponder(Service& cachingService)
+{
+    return new CachingResponder(cachingService, *this);
+}
+
+void CachingServiceImpl::releaseResponder(Responder* responder)
+{
+    CachingResponder* r = static_cast<CachingResponder*>(responder);
+    r->releaseWrapped();
+    delete r;
+}
+
+std::size_t CachingServiceImpl::maxBytes() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _maxBytes;
+}
+
+void CachingServiceImpl::maxBytes(std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _maxBytes = bytes;
+    evict();
+}
+
+void CachingServiceImpl::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+    _lru.clear();
+    _bytes = 0;
+}
+
+std::size_t CachingServiceImpl::entries() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _entries.size();
+}
+
+std::size_t CachingServiceImpl::bytes() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _bytes;
+}
+
+uint64_t CachingServiceImpl::hits() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _hits;
+}
+
+uint64_t CachingServiceImpl::misses() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _misses;
+}
+
+bool CachingServiceImpl::cacheable(const Request& request) const
+{
+    if (request.method() != "GET" && request.method() != "HEAD")
+        return false;
+
+    bool ret = true;
+    forEachToken(request.header().getHeader(MessageHeader::CacheControl),
+        [&ret](const std::string& token)
+        {
+            long seconds;
+            if (isDirective(token, "no-store")
+                || isDirective(token, "no-cache")
+                || (getSeconds(token, "max-age", seconds) && seconds == 0))
+                ret = false;
+        });
+
+    return ret;
+}
+
+std::string CachingServiceImpl::key(const Request& request) const
+{
+    std::string key = request.method();
+    key += ' ';
+    key += request.url();
+    if (!request.qparams().empty())
+    {
+        key += '?';
+        key += request.qparams();
+    }
+
+    for (std::vector<std::string>::const_iterator it = _keyHeaders.begin(); it != _keyHeaders.end(); ++it)
+    {
+        key += '\n';
+        const char* value = request.header().getHeader(it->c_str());
+        if (value)
+            key += value;
+    }
+
+    return key;
+}
+
+void CachingServiceImpl::erase(Entries::iterator it)
+{
+    _bytes -= (*it->second)->size;
+    _lru.erase(it->second);
+    _entries.erase(it);
+}
+
+void CachingServiceImpl::evict()
+{
+    while (_bytes > _maxBytes && !_lru.empty())
+    {
+        log_debug("drop " << _lru.back()->key);
+        erase(_entries.find(_lru.back()->key));
+    }
+}
+
+CachingServiceImpl::EntryPtr CachingServiceImpl::lookup(const std::string& key, FlightPtr& flight, bool& leader)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Entries::iterator it = _entries.find(key);
+    if (it != _entries.end())
+    {
+        if ((*it->second)->expires > Clock::getSystemTicks())
+        {
+            ++_hits;
+            _lru.splice(_lru.begin(), _lru, it->second);
+            return *it->second;
+        }
+
+        log_debug("entry " << key << " expired");
+        erase(it);
+    }
+
+    ++_misses;
+
+    Flights::iterator fit = _flights.find(key);
+    if (fit != _flights.end())
+    {
+        flight = fit->second;
+        leader = false;
+    }
+    else
+    {
+        flight = std::make_shared<Flight>();
+        _flights[key] = flight;
+        leader = true;
+    }
+
+    return EntryPtr();
+}
+
+CachingServiceImpl::EntryPtr CachingServiceImpl::wait(const FlightPtr& flight)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!flight->done)
+        _flightDone.wait(lock);
+    return flight->entry;
+}
+
+Timespan CachingServiceImpl::ttl(const Request& request, const Reply& reply) const
+{
+    switch (reply.httpReturnCode())
+    {
+        case 200: case 203: case 204: case 300: case 301:
+        case 404: case 405: case 410: case 414: case 501:
+            break;
+
+        default:
+            return Timespan(0);
+    }
+
+    if (reply.header().hasHeader("Set-Cookie"))
+        return Timespan(0);
+
+    bool store = true;
+    bool isPublic = false;
+    long maxAge = -1;
+    long sMaxAge = -1;
+    forEachToken(reply.header().getHeader(MessageHeader::CacheControl),
+        [&](const std::string& token)
+        {
+            long seconds;
+            if (isDirective(token, "no-store")
+                || isDirective(token, "no-cache")
+                || isDirective(token, "private"))
+                store = false;
+            else if (isDirective(token, "public"))
+                isPublic = true;
+            else if (getSeconds(token, "s-maxage", seconds))
+                sMaxAge = seconds;
+            else if (getSeconds(token, "max-age", seconds))
+                maxAge = seconds;
+        });
+
+    // replies to authorized requests are shared only when explicitly allowed
+    if (request.header().hasHeader(MessageHeader::Authorization)
+        && !isPublic && sMaxAge < 0)
+        store = false;
+
+    forEachToken(reply.header().getHeader("Vary"),
+        [&](const std::string& token)
+        {
+            bool found = false;
+            for (std::vector<std::string>::const_iterator it = _keyHeaders.begin(); it != _keyHeaders.end(); ++it)
+                if (::strcasecmp(it->c_str(), token.c_str()) == 0)
+                    found = true;
+            if (!found)
+                store = false;
+        });
+
+    if (!store)
+        return Timespan(0);
+
+    if (sMaxAge >= 0)
+        return Seconds(sMaxAge);
+
+    if (maxAge >= 0)
+        return Seconds(maxAge);
+
+    return _defaultTtl;
+}
+
+void CachingServiceImpl::finish(const std::string& key, const FlightPtr& flight, const Request& request, const Reply* reply)
+{
+    std::shared_ptr<Entry> entry;
+
+    Timespan t = reply ? ttl(request, *reply) : Timespan(0);
+    if (t > Timespan(0))
+    {
+        entry = std::make_shared<Entry>();
+        entry->key = key;
+        entry->body = reply->body();
+
+        const ReplyHeader& header = reply->header();
+        entry->header.httpReturn(header.httpReturnCode(), header.httpReturnText());
+        for (ReplyHeader::const_iterator it = header.begin(); it != header.end(); ++it)
+        {
+            // these are set per connection when the reply is sent
+            if (it.id() != MessageHeader::Connection
+                && it.id() != MessageHeader::ContentLength
+                && it.id() != MessageHeader::Date)
+                entry->header.addHeader(it->first, it->second);
+        }
+
+        entry->stored = Clock::getSystemTicks();
+        entry->expires = entry->stored + t;
+        entry->size = sizeof(Entry) + key.size() * 2 + entry->body.size() + entry->header.bytesUsed();
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (entry && entry->size <= _maxBytes)
+    {
+        log_debug("store " << key << "; " << entry->size << " bytes");
+
+        Entries::iterator it = _entries.find(key);
+        if (it != _entries.end())
+            erase(it);
+
+        _lru.push_front(entry);
+        _entries[key] = _lru.begin();
+        _bytes += entry->size;
+        evict();
+    }
+
+    Flights::iterator fit = _flights.find(key);
+    if (fit != _flights.end() && fit->second == flight)
+        _flights.erase(fit);
+
+    flight->done = true;
+    flight->entry = entry;
+    _flightDone.notify_all();
+}
+
+void CachingServiceImpl::send(const Entry& entry, Reply& reply, std::ostream& out)
+{
+    reply.header() = entry.header;
+
+    std::ostringstream age;
+    age << static_cast<long>((Clock::getSystemTicks() - entry.stored).totalSeconds());
+    reply.setHeader("Age", age.str().c_str());
+
+    out.write(entry.body.data(), entry.body.size());
+}
+
+}
+}
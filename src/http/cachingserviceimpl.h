@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CXXTOOLS_HTTP_CACHINGSERVICEIMPL_H
+#define CXXTOOLS_HTTP_CACHINGSERVICEIMPL_H
+
+#include <cxxtools/http/replyheader.h>
+#include <cxxtools/timespan.h>
+#include <condition_variable>
+#include <iosfwd>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+namespace cxxtools
+{
+namespace http
+{
+
+class Service;
+class Responder;
+class Request;
+class Reply;
+
+class CachingServiceImpl
+{
+    public:
+        // A cached reply. Entries are immutable and shared with the
+        // responders sending them, so that they may be dropped meanwhile.
+        struct Entry
+        {
+            std::string key;
+            ReplyHeader header;
+            std::string body;
+            Timespan stored;
+            Timespan expires;
+            std::size_t size;
+        };
+
+        typedef std::shared_ptr<const Entry> EntryPtr;
+
+        // A request for a missing entry, which is computed by the wrapped service.
+        struct Flight
+        {
+            bool done;
+            EntryPtr entry;
+
+            Flight()
+                : done(false)
+                { }
+        };
+
+        typedef std::shared_ptr<Flight> FlightPtr;
+
+    private:
+        typedef std::list<EntryPtr> Lru;    // most recently used first
+        typedef std::unordered_map<std::string, Lru::iterator> Entries;
+        typedef std::unordered_map<std::string, FlightPtr> Flights;
+
+        Service& _service;
+        std::vector<std::string> _keyHeaders;
+        std::size_t _maxBytes;
+        Milliseconds _defaultTtl;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _flightDone;
+        Lru _lru;
+        Entries _entries;
+        Flights _flights;
+        std::size_t _bytes;
+        uint64_t _hits;
+        uint64_t _misses;
+
+        void erase(Entries::iterator it);
+        void evict();
+        Timespan ttl(const Request& request, const Reply& reply) const;
+
+    public:
+        CachingServiceImpl(Service& service, std::size_t maxBytes);
+
+        Service& service()                          { return _service; }
+
+        void addKeyHeader(const std::string& header)
+            { _keyHeaders.push_back(header); }
+
+        std::size_t maxBytes() const;
+        void maxBytes(std::size_t bytes);
+
+        Milliseconds defaultTtl() const             { return _defaultTtl; }
+        void defaultTtl(Milliseconds ttl)           { _defaultTtl = ttl; }
+
+        void clear();
+        std::size_t entries() const;
+        std::size_t bytes() const;
+        uint64_t hits() const;
+        uint64_t misses() const;
+
+        /// Returns true, when the reply to the request may be taken from the cache.
+        bool cacheable(const Request& request) const;
+
+        std::string key(const Request& request) const;
+
+        /// Returns a fresh entry or a null pointer. On a miss a flight is
+        /// returned, which is either started by this request (leader is set)
+        /// or computed by another request already.
+        EntryPtr lookup(const std::string& key, FlightPtr& flight, bool& leader);
+
+        /// Waits for the flight of another request and returns its entry,
+        /// which is null, when the reply could not be cached.
+        EntryPtr wait(const FlightPtr& flight);
+
+        /// Ends a flight started by lookup and stores the reply when cacheable.
+        void finish(const std::string& key, const FlightPtr& flight, const Request& request, const Reply* reply);
+
+        static void send(const Entry& entry, Reply& reply, std::ostream& out);
+
+        Responder* createResponder(Service& cachingService);
+        void releaseResponder(Responder* responder);
+};
+
+}
+}
+
+#endif
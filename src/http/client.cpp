@@ -150,6 +150,11 @@ const Reply& Client::readBody()
     return reply();
 }
 
+void Client::readBody(std::ostream& out)
+{
+    _impl->readBody(out);
+}
+
 const Reply& Client::get(const std::string& url, const QueryParams& qparams, Milliseconds timeout, Milliseconds connectTimeout)
 {
     Request request(url);
@@ -181,6 +186,11 @@ void Client::endExecute()
     _impl->endExecute();
 }
 
+void Client::resumeBody()
+{
+    _impl->resumeBody();
+}
+
 void Client::setSelector(SelectorBase* selector)
 {
     getImpl()->setSelector(selector);
@@ -62,7 +62,8 @@ ClientImpl::ClientImpl(Client* client)
   _readHeader(true),
   _chunkedEncoding(false),
   _reconnectOnError(false),
-  _exceptionPending(false)
+  _exceptionPending(false),
+  _bodyPaused(false)
 {
     _stream.attachDevice(_socket);
     cxxtools::connect(_socket.connected, *this, &ClientImpl::onConnect);
@@ -217,12 +218,18 @@ const ReplyHeader& ClientImpl::execute(const Request& request, Timespan timeout,
 
 
 void ClientImpl::readBody()
+{
+    readBody(_reply.bodyStream());
+}
+
+
+void ClientImpl::readBody(std::ostream& out)
 {
     if (_chunkedEncoding)
     {
         log_debug("read body with chunked encoding");
 
-        _reply.bodyStream() << _chunkedIStream.rdbuf();
+        out << _chunkedIStream.rdbuf();
 
         if (!_chunkedIStream.eod())
         {
@@ -232,9 +239,9 @@ void ClientImpl::readBody()
     }
     else if (_bodyStream.icount() > 0)
     {
-        _reply.bodyStream() << _bodyStream.rdbuf();
+        out << _bodyStream.rdbuf();
 
-        if (_bodyStream.icount() > 0 || !_reply.bodyStream())
+        if (_bodyStream.icount() > 0 || !out)
         {
             _stream.setstate(std::ios::failbit);
             throw IOError("error reading HTTP reply body");
@@ -262,6 +269,7 @@ void ClientImpl::beginExecute(const Request& request)
     log_trace("beginExecute");
 
     _exceptionPending = false;
+    _bodyPaused = false;
     _request = &request;
     _reply.clear();
     if (_socket.isConnected())
@@ -302,6 +310,32 @@ void ClientImpl::endExecute()
 }
 
 
+void ClientImpl::resumeBody()
+{
+    if (!_bodyPaused)
+        return;
+
+    log_debug("resume reading body");
+
+    _bodyPaused = false;
+
+    try
+    {
+        processBodyAvailable(_stream.buffer());
+    }
+    catch (const std::exception&)
+    {
+        _exceptionPending = true;
+        Resetter<bool> exceptionPending(_exceptionPending, false);
+
+        _client->replyFinished(*_client);
+
+        if (_exceptionPending)
+            throw;
+    }
+}
+
+
 bool ClientImpl::wait(std::size_t msecs)
 {
     return _socket.wait(msecs);
@@ -318,13 +352,6 @@ void ClientImpl::sendRequest(const Request& request)
 {
     log_debug("send request " << request.url());
 
-    static const char* contentLength = "Content-Length";
-    static const char* connection = "Connection";
-    static const char* date = "Date";
-    static const char* host = "Host";
-    static const char* authorization = "Authorization";
-    static const char* userAgent = "User-Agent";
-
     _stream << request.method() << " /"
             << request.url();
 
@@ -341,23 +368,23 @@ void ClientImpl::sendRequest(const Request& request)
         _stream << it->first << ": " << it->second << "\r\n";
     }
 
-    if (!request.header().hasHeader(contentLength))
+    if (!request.header().hasHeader(MessageHeader::ContentLength))
     {
         _stream << "Content-Length: " << request.bodySize() << "\r\n";
     }
 
-    if (!request.header().hasHeader(connection))
+    if (!request.header().hasHeader(MessageHeader::Connection))
     {
         _stream << "Connection: keep-alive\r\n";
     }
 
-    if (!request.header().hasHeader(date))
+    if (!request.header().hasHeader(MessageHeader::Date))
     {
         char buffer[50];
         _stream << "Date: " << MessageHeader::htdateCurrent(buffer) << "\r\n";
     }
 
-    if (!request.header().hasHeader(host))
+    if (!request.header().hasHeader(MessageHeader::Host))
     {
         _stream << "Host: " << _addrInfo.host();
         unsigned short port = _addrInfo.port();
@@ -366,12 +393,12 @@ void ClientImpl::sendRequest(const Request& request)
         _stream << "\r\n";
     }
 
-    if (!request.header().hasHeader(userAgent))
+    if (!request.header().hasHeader(MessageHeader::UserAgent))
     {
         _stream << "User-Agent: " PACKAGE_STRING " http client\r\n";
     }
 
-    if (!_username.empty() && !request.header().hasHeader(authorization))
+    if (!_username.empty() && !request.header().hasHeader(MessageHeader::Authorization))
     {
         std::ostringstream d;
         BasicTextOStream<char, char> b(d, new Base64Codec());
@@ -624,67 +651,46 @@ void ClientImpl::processBodyAvailable(StreamBuffer& sb)
 
     if (_chunkedEncoding)
     {
-        if (_chunkedIStream.rdbuf()->in_avail() > 0)
+        if (_chunkedIStream.rdbuf()->in_avail() > 0 && !_chunkedIStream.eod())
         {
-            if (!_chunkedIStream.eod())
-            {
-                log_debug("read chunked encoding body");
-
-                while (_chunkedIStream.good()
-                    && _chunkedIStream.rdbuf()->in_avail() > 0
-                    && !_chunkedIStream.eod())
-                {
-                    log_debug("bodyAvailable");
-                    _client->bodyAvailable(*_client);
-                }
+            log_debug("read chunked encoding body");
 
-                log_debug("in_avail=" << _chunkedIStream.rdbuf()->in_avail() << " eod=" << _chunkedIStream.eod());
-                if (_chunkedIStream.eod())
-                {
-                    _parser.readHeader();
-                }
-            }
-
-            if (_chunkedIStream.eod() && sb.in_avail() > 0)
+            while (_chunkedIStream.good()
+                && _chunkedIStream.rdbuf()->in_avail() > 0
+                && !_chunkedIStream.eod())
             {
-                log_debug("read chunked encoding post headers");
-
-                _parser.advance(sb);
-                if (_parser.fail())
-                    throw std::runtime_error("http parser failed"); // TODO define exception class
-
-                if( _parser.end() )
+                log_debug("bodyAvailable");
+                if (_client->bodyAvailable(*_client) == 0)
                 {
-                    log_debug("reply finished");
-
-                    if (!_reply.header().keepAlive())
-                    {
-                        log_debug("close socket - no keep alive");
-                        _socket.close();
-                    }
-
-                    _client->replyFinished(*_client);
+                    log_debug("consumer is behind - stop reading");
+                    _bodyPaused = true;
+                    return;
                 }
             }
 
+            log_debug("in_avail=" << _chunkedIStream.rdbuf()->in_avail() << " eod=" << _chunkedIStream.eod());
+
             if (_chunkedIStream.fail())
                 throw IOError("error reading HTTP reply body");
         }
-        else if( _chunkedIStream.eod() )
-        {
-            if( _reply.header().hasHeader("Trailer") )
-                _parser.readHeader();
-            else
-                _client->replyFinished(*_client);
-        }
 
-        if (_socket.enabled())
+        if (_chunkedIStream.eod())
         {
-            if ((!_chunkedIStream.eod() || !_parser.end()))
+            // the chunked reader consumes the trailer up to the final empty line
+            log_debug("reply finished");
+
+            if (!_reply.header().keepAlive())
             {
-                log_debug("call beginRead");
-                sb.beginRead();
+                log_debug("close socket - no keep alive");
+                _socket.close();
             }
+
+            _client->replyFinished(*_client);
+        }
+        else if (_socket.enabled())
+        {
+            log_debug("call beginRead");
+            sb.beginRead();
         }
         else
         {
@@ -697,7 +703,13 @@ void ClientImpl::processBodyAvailable(StreamBuffer& sb)
 
         while (_stream.good() && _bodyStream.good() && _bodyStream.rdbuf()->in_avail() > 0)
         {
-            _client->bodyAvailable(*_client); // TODO: may throw exception
+            if (_client->bodyAvailable(*_client) == 0) // TODO: may throw exception
+            {
+                log_debug("consumer is behind - stop reading");
+                _bodyPaused = true;
+                return;
+            }
+
             log_debug("content-length(post)=" << _bodyStream.icount());
         }
 
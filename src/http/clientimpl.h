@@ -97,6 +97,7 @@ class ClientImpl : public RefCounted, public Connectable
         bool _chunkedEncoding;
         bool _reconnectOnError;
         bool _exceptionPending;
+        bool _bodyPaused;
 
         void sendRequest(const Request& request);
         void processHeaderAvailable(StreamBuffer& sb);
@@ -152,6 +153,10 @@ class ClientImpl : public RefCounted, public Connectable
         // This method blocks until the body is received.
         void readBody();
 
+        // Reads the http body after header read with execute and writes it
+        // to the passed stream instead of the reply.
+        void readBody(std::ostream& out);
+
         std::string body() const
         { return _reply.body(); }
 
@@ -171,6 +176,9 @@ class ClientImpl : public RefCounted, public Connectable
 
         void endExecute();
 
+        // Continues reading the body after bodyAvailable returned 0.
+        void resumeBody();
+
         void setSelector(SelectorBase* selector)
         {
             _socket.setSelector(selector);
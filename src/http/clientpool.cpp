@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <cxxtools/http/clientpool.h>
+#include <cxxtools/http/request.h>
+#include <cxxtools/net/addrinfo.h>
+#include <cxxtools/sslctx.h>
+#include "clientpoolimpl.h"
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+ClientPool::ClientPool()
+    : _impl(new ClientPoolImpl(*this))
+{
+}
+
+ClientPool::ClientPool(SelectorBase& selector)
+    : _impl(new ClientPoolImpl(*this, selector))
+{
+}
+
+ClientPool::~ClientPool()
+{
+    delete _impl;
+}
+
+unsigned ClientPool::maxConnectionsPerHost() const
+{
+    return _impl->maxConnectionsPerHost();
+}
+
+void ClientPool::maxConnectionsPerHost(unsigned n)
+{
+    _impl->maxConnectionsPerHost(n);
+}
+
+Milliseconds ClientPool::idleTimeout() const
+{
+    return _impl->idleTimeout();
+}
+
+void ClientPool::idleTimeout(Milliseconds ms)
+{
+    _impl->idleTimeout(ms);
+}
+
+unsigned ClientPool::beginExecute(const net::AddrInfo& addr, const Request& request)
+{
+    return _impl->beginExecute(addr, SslCtx(), request);
+}
+
+unsigned ClientPool::beginExecute(const net::AddrInfo& addr, const SslCtx& sslCtx, const Request& request)
+{
+    return _impl->beginExecute(addr, sslCtx, request);
+}
+
+unsigned ClientPool::beginExecute(const std::string& host, unsigned short port, const Request& request)
+{
+    return _impl->beginExecute(net::AddrInfo(host, port), SslCtx(), request);
+}
+
+const Reply& ClientPool::endExecute(unsigned id, Milliseconds timeout)
+{
+    return _impl->endExecute(id, timeout);
+}
+
+bool ClientPool::finished(unsigned id) const
+{
+    return _impl->finished(id);
+}
+
+const Reply& ClientPool::execute(const net::AddrInfo& addr, const Request& request, Milliseconds timeout)
+{
+    return endExecute(beginExecute(addr, request), timeout);
+}
+
+const Reply& ClientPool::get(const std::string& host, unsigned short port, const std::string& url, Milliseconds timeout)
+{
+    return execute(net::AddrInfo(host, port), Request(url), timeout);
+}
+
+void ClientPool::closeIdle()
+{
+    _impl->closeIdle();
+}
+
+SelectorBase& ClientPool::selector()
+{
+    return _impl->selector();
+}
+
+bool ClientPool::wait(Milliseconds msecs)
+{
+    return _impl->wait(msecs);
+}
+
+uint64_t ClientPool::connectionsOpened() const
+{
+    return _impl->connectionsOpened();
+}
+
+uint64_t ClientPool::connectionsReused() const
+{
+    return _impl->connectionsReused();
+}
+
+unsigned ClientPool::activeConnections() const
+{
+    return _impl->activeConnections();
+}
+
+unsigned ClientPool::idleConnections() const
+{
+    return _impl->idleConnections();
+}
+
+} // namespace http
+
+} // namespace cxxtools
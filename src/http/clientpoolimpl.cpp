@@ -0,0 +1,416 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "clientpoolimpl.h"
+#include <cxxtools/http/clientpool.h>
+#include <cxxtools/clock.h>
+#include <cxxtools/convert.h>
+#include <cxxtools/ioerror.h>
+#include <cxxtools/log.h>
+#include <algorithm>
+#include <stdexcept>
+
+log_define("cxxtools.http.clientpool")
+
+namespace cxxtools
+{
+namespace http
+{
+
+////////////////////////////////////////////////////////////////////////
+// ClientPoolImpl::Connection
+//
+ClientPoolImpl::Connection::Connection(ClientPoolImpl& pool, Host& host)
+    : _pool(pool),
+      _host(host),
+      _client(*pool._selector),
+      _callId(0),
+      _call(0),
+      _connected(false)
+{
+    _client.prepareConnect(host.addrInfo, host.sslCtx);
+    cxxtools::connect(_client.bodyAvailable, *this, &Connection::onBodyAvailable);
+    cxxtools::connect(_client.replyFinished, *this, &Connection::onReplyFinished);
+}
+
+void ClientPoolImpl::Connection::execute(unsigned callId, Call* call)
+{
+    _callId = callId;
+    _call = call;
+    call->connection = this;
+
+    if (_connected)
+    {
+        log_debug("reuse connection to " << _host.addrInfo.host() << ':' << _host.addrInfo.port() << " for request " << callId);
+        ++_pool._connectionsReused;
+    }
+    else
+    {
+        log_debug("open connection to " << _host.addrInfo.host() << ':' << _host.addrInfo.port() << " for request " << callId);
+        ++_pool._connectionsOpened;
+        _connected = true;
+    }
+
+    _client.beginExecute(call->request);
+}
+
+void ClientPoolImpl::Connection::cancel()
+{
+    _client.cancel();
+    _connected = false;
+    _callId = 0;
+    _call = 0;
+}
+
+void ClientPoolImpl::Connection::close()
+{
+    _client.close();
+    _connected = false;
+}
+
+std::size_t ClientPoolImpl::Connection::onBodyAvailable(Client& client)
+{
+    std::istream& in = client.in();
+    std::size_t count = 0;
+
+    char buffer[8192];
+    std::streamsize n;
+    while ((n = in.readsome(buffer, sizeof(buffer))) > 0)
+    {
+        if (_call)
+            _call->reply.bodyStream().write(buffer, n);
+        count += n;
+    }
+
+    return count;
+}
+
+void ClientPoolImpl::Connection::onReplyFinished(Client& client)
+{
+    Call* call = _call;
+    unsigned callId = _callId;
+    _call = 0;
+    _callId = 0;
+
+    try
+    {
+        client.endExecute();
+
+        if (!client.header().keepAlive())
+            _connected = false;
+
+        if (call)
+            call->reply.header() = client.header();
+    }
+    catch (const std::exception& e)
+    {
+        log_debug("request " << callId << " failed: " << e.what());
+
+        client.cancel();
+        _connected = false;
+
+        if (call)
+        {
+            call->failed = true;
+            call->error = e.what();
+        }
+    }
+
+    _idleSince = Clock::getSystemTicks();
+
+    // the connection may start the next waiting request right away
+    _pool.release(*this);
+
+    if (call)
+        _pool.finishCall(callId, call);
+}
+
+////////////////////////////////////////////////////////////////////////
+// ClientPoolImpl::Host
+//
+ClientPoolImpl::Host::~Host()
+{
+    for (std::vector<Connection*>::iterator it = connections.begin(); it != connections.end(); ++it)
+        delete *it;
+}
+
+////////////////////////////////////////////////////////////////////////
+// ClientPoolImpl
+//
+ClientPoolImpl::ClientPoolImpl(ClientPool& clientPool)
+    : _clientPool(clientPool),
+      _ownSelector(new Selector()),
+      _selector(_ownSelector.get())
+{
+    init();
+}
+
+ClientPoolImpl::ClientPoolImpl(ClientPool& clientPool, SelectorBase& selector)
+    : _clientPool(clientPool),
+      _selector(&selector)
+{
+    init();
+}
+
+void ClientPoolImpl::init()
+{
+    _nextCallId = 1;
+    _lastCall = 0;
+    _maxConnectionsPerHost = 8;
+    _connectionsOpened = 0;
+    _connectionsReused = 0;
+
+    _idleTimer.setSelector(_selector);
+    cxxtools::connect(_idleTimer.timeout, *this, &ClientPoolImpl::onIdleTimer);
+    idleTimeout(Seconds(10));
+}
+
+ClientPoolImpl::~ClientPoolImpl()
+{
+    for (Calls::iterator it = _calls.begin(); it != _calls.end(); ++it)
+        delete it->second;
+
+    delete _lastCall;
+
+    for (Hosts::iterator it = _hosts.begin(); it != _hosts.end(); ++it)
+        delete it->second;
+}
+
+void ClientPoolImpl::idleTimeout(Milliseconds ms)
+{
+    _idleTimeout = ms;
+
+    if (ms > Milliseconds(0))
+        _idleTimer.start(ms);
+    else
+        _idleTimer.stop();
+}
+
+ClientPoolImpl::Host& ClientPoolImpl::host(const net::AddrInfo& addrInfo, const SslCtx& sslCtx)
+{
+    std::string key = addrInfo.host() + ':' + convert<std::string>(addrInfo.port());
+    if (sslCtx.enabled())
+        key += ":ssl";
+
+    Hosts::iterator it = _hosts.find(key);
+    if (it == _hosts.end())
+        it = _hosts.insert(Hosts::value_type(key, new Host(addrInfo, sslCtx))).first;
+
+    return *it->second;
+}
+
+unsigned ClientPoolImpl::beginExecute(const net::AddrInfo& addrInfo, const SslCtx& sslCtx, const Request& request)
+{
+    unsigned id = _nextCallId++;
+    if (id == 0)
+        id = _nextCallId++;
+
+    Host& h = host(addrInfo, sslCtx);
+
+    Call* call = new Call();
+    call->request.header() = request.header();
+    call->request.body().write(request.bodyData(), request.bodySize());
+
+    _calls[id] = call;
+    h.waiting.push_back(id);
+
+    dispatch(h);
+
+    return id;
+}
+
+// Starts waiting requests on idle connections or on new connections as long
+// as the limit of connections to the host is not reached.
+void ClientPoolImpl::dispatch(Host& host)
+{
+    while (!host.waiting.empty())
+    {
+        Connection* connection;
+        if (!host.idle.empty())
+        {
+            connection = host.idle.back();
+            host.idle.pop_back();
+        }
+        else if (host.connections.size() < _maxConnectionsPerHost)
+        {
+            connection = new Connection(*this, host);
+            host.connections.push_back(connection);
+        }
+        else
+        {
+            log_debug(host.waiting.size() << " requests waiting for a connection to " << host.addrInfo.host() << ':' << host.addrInfo.port());
+            break;
+        }
+
+        unsigned id = host.waiting.front();
+        host.waiting.pop_front();
+        Call* call = _calls[id];
+
+        try
+        {
+            connection->execute(id, call);
+        }
+        catch (const std::exception& e)
+        {
+            log_debug("failed to start request " << id << ": " << e.what());
+            connection->cancel();
+            host.idle.push_back(connection);
+            call->failed = true;
+            call->error = e.what();
+            finishCall(id, call);
+        }
+    }
+}
+
+void ClientPoolImpl::release(Connection& connection)
+{
+    Host& h = connection.host();
+    h.idle.push_back(&connection);
+    dispatch(h);
+}
+
+void ClientPoolImpl::finishCall(unsigned callId, Call* call)
+{
+    log_debug("request " << callId << " finished");
+    call->finished = true;
+    call->connection = 0;
+    _clientPool.replyFinished(_clientPool, callId);
+}
+
+const Reply& ClientPoolImpl::endExecute(unsigned id, Milliseconds timeout)
+{
+    Calls::iterator it = _calls.find(id);
+    if (it == _calls.end())
+        throw std::logic_error("unknown http request id " + convert<std::string>(id));
+
+    Call* call = it->second;
+    while (!call->finished)
+    {
+        if (!_selector->wait(timeout))
+        {
+            cancel(id);
+            throw IOTimeout();
+        }
+    }
+
+    delete _lastCall;
+    _lastCall = call;
+    _calls.erase(id);
+
+    if (call->failed)
+        throw IOError(call->error);
+
+    return call->reply;
+}
+
+bool ClientPoolImpl::finished(unsigned id) const
+{
+    Calls::const_iterator it = _calls.find(id);
+    return it == _calls.end() || it->second->finished;
+}
+
+void ClientPoolImpl::cancel(unsigned id)
+{
+    Call* call = _calls[id];
+    _calls.erase(id);
+
+    if (call->connection)
+    {
+        Connection* connection = call->connection;
+        connection->cancel();
+        release(*connection);
+    }
+    else
+    {
+        for (Hosts::iterator it = _hosts.begin(); it != _hosts.end(); ++it)
+        {
+            std::deque<unsigned>& waiting = it->second->waiting;
+            std::deque<unsigned>::iterator w = std::find(waiting.begin(), waiting.end(), id);
+            if (w != waiting.end())
+            {
+                waiting.erase(w);
+                break;
+            }
+        }
+    }
+
+    delete call;
+}
+
+void ClientPoolImpl::closeIdle()
+{
+    for (Hosts::iterator it = _hosts.begin(); it != _hosts.end(); ++it)
+    {
+        std::vector<Connection*>& idle = it->second->idle;
+        for (std::vector<Connection*>::iterator c = idle.begin(); c != idle.end(); ++c)
+            (*c)->close();
+    }
+}
+
+void ClientPoolImpl::onIdleTimer()
+{
+    Timespan now = Clock::getSystemTicks();
+
+    for (Hosts::iterator it = _hosts.begin(); it != _hosts.end(); ++it)
+    {
+        std::vector<Connection*>& idle = it->second->idle;
+        for (std::vector<Connection*>::iterator c = idle.begin(); c != idle.end(); ++c)
+        {
+            if ((*c)->connected() && now - (*c)->idleSince() >= _idleTimeout)
+            {
+                log_debug("close idle connection to " << it->first);
+                (*c)->close();
+            }
+        }
+    }
+}
+
+unsigned ClientPoolImpl::activeConnections() const
+{
+    unsigned count = 0;
+    for (Hosts::const_iterator it = _hosts.begin(); it != _hosts.end(); ++it)
+        count += it->second->connections.size() - it->second->idle.size();
+    return count;
+}
+
+unsigned ClientPoolImpl::idleConnections() const
+{
+    unsigned count = 0;
+    for (Hosts::const_iterator it = _hosts.begin(); it != _hosts.end(); ++it)
+    {
+        const std::vector<Connection*>& idle = it->second->idle;
+        for (std::vector<Connection*>::const_iterator c = idle.begin(); c != idle.end(); ++c)
+            if ((*c)->connected())
+                ++count;
+    }
+    return count;
+}
+
+}
+}
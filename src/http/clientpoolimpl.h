@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_HTTP_CLIENTPOOLIMPL_H
+#define CXXTOOLS_HTTP_CLIENTPOOLIMPL_H
+
+#include <cxxtools/http/client.h>
+#include <cxxtools/http/request.h>
+#include <cxxtools/http/reply.h>
+#include <cxxtools/net/addrinfo.h>
+#include <cxxtools/sslctx.h>
+#include <cxxtools/selector.h>
+#include <cxxtools/timer.h>
+#include <cxxtools/connectable.h>
+#include <cxxtools/timespan.h>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace cxxtools
+{
+namespace http
+{
+
+class ClientPool;
+
+class ClientPoolImpl : public Connectable
+{
+        class Connection;
+        struct Host;
+
+        struct Call
+        {
+            Call()
+                : connection(0),
+                  finished(false),
+                  failed(false)
+                { }
+
+            Request request;
+            Reply reply;
+            Connection* connection;
+            bool finished;
+            bool failed;
+            std::string error;
+        };
+
+        // A keep alive connection to a host running one request at a time.
+        class Connection : public Connectable
+        {
+                ClientPoolImpl& _pool;
+                Host& _host;
+                Client _client;
+                unsigned _callId;
+                Call* _call;
+                bool _connected;
+                Timespan _idleSince;
+
+                std::size_t onBodyAvailable(Client& client);
+                void onReplyFinished(Client& client);
+
+            public:
+                Connection(ClientPoolImpl& pool, Host& host);
+
+                Host& host()                { return _host; }
+                bool connected() const      { return _connected; }
+                Timespan idleSince() const  { return _idleSince; }
+
+                void execute(unsigned callId, Call* call);
+                void cancel();
+                void close();
+        };
+
+        struct Host
+        {
+            Host(const net::AddrInfo& addrInfo_, const SslCtx& sslCtx_)
+                : addrInfo(addrInfo_),
+                  sslCtx(sslCtx_)
+                { }
+
+            ~Host();
+
+            net::AddrInfo addrInfo;
+            SslCtx sslCtx;
+            std::vector<Connection*> connections;
+            std::vector<Connection*> idle;  // most recently used last
+            std::deque<unsigned> waiting;   // calls waiting for a connection
+        };
+
+        typedef std::map<unsigned, Call*> Calls;
+        typedef std::map<std::string, Host*> Hosts;
+
+        ClientPool& _clientPool;
+        std::unique_ptr<Selector> _ownSelector;
+        SelectorBase* _selector;
+        Timer _idleTimer;
+
+        Hosts _hosts;
+        Calls _calls;
+        unsigned _nextCallId;
+        Call* _lastCall;                    // returned by the last endExecute
+
+        unsigned _maxConnectionsPerHost;
+        Milliseconds _idleTimeout;
+        uint64_t _connectionsOpened;
+        uint64_t _connectionsReused;
+
+        ClientPoolImpl(const ClientPoolImpl&) = delete;
+        ClientPoolImpl& operator=(const ClientPoolImpl&) = delete;
+
+        void init();
+        Host& host(const net::AddrInfo& addrInfo, const SslCtx& sslCtx);
+        void dispatch(Host& host);
+        void release(Connection& connection);
+        void finishCall(unsigned callId, Call* call);
+        void cancel(unsigned id);
+        void onIdleTimer();
+
+    public:
+        explicit ClientPoolImpl(ClientPool& clientPool);
+        ClientPoolImpl(ClientPool& clientPool, SelectorBase& selector);
+        ~ClientPoolImpl();
+
+        unsigned maxConnectionsPerHost() const      { return _maxConnectionsPerHost; }
+        void maxConnectionsPerHost(unsigned n)      { _maxConnectionsPerHost = n > 0 ? n : 1; }
+
+        Milliseconds idleTimeout() const            { return _idleTimeout; }
+        void idleTimeout(Milliseconds ms);
+
+        unsigned beginExecute(const net::AddrInfo& addrInfo, const SslCtx& sslCtx, const Request& request);
+        const Reply& endExecute(unsigned id, Milliseconds timeout);
+        bool finished(unsigned id) const;
+
+        void closeIdle();
+
+        SelectorBase& selector()                    { return *_selector; }
+        bool wait(Milliseconds timeout)             { return _selector->wait(timeout); }
+
+        uint64_t connectionsOpened() const          { return _connectionsOpened; }
+        uint64_t connectionsReused() const          { return _connectionsReused; }
+        unsigned activeConnections() const;
+        unsigned idleConnections() const;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "detachedconnection.h"
+#include "serverimpl.h"
+#include "socket.h"
+#include <cxxtools/log.h>
+#include <algorithm>
+
+log_define("cxxtools.http.detached")
+
+namespace cxxtools
+{
+namespace http
+{
+
+namespace
+{
+    // the stream buffer of the socket holds 8k; larger pieces would flush blocking
+    const std::size_t outputChunkSize = 8192;
+}
+
+DetachedConnection::DetachedConnection(ServerImpl& server, Socket& socket)
+    : _server(server),
+      _socket(socket),
+      _peerAddr(socket.getPeerAddr()),
+      _outputPos(0),
+      _flushPending(false),
+      _started(false),
+      _released(false)
+{
+}
+
+void DetachedConnection::start(StreamBuffer& sb)
+{
+    _loopThread = std::this_thread::get_id();
+    _started = true;
+
+    onStart(sb);
+    flush();
+}
+
+bool DetachedConnection::onOutput(StreamBuffer& sb)
+{
+    bool done;
+
+    try
+    {
+        sb.endWrite();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (sb.out_avail() > 0)
+        {
+            sb.beginWrite();
+            return true;
+        }
+
+        // the reply header is sent; the worker passes the socket to the event loop
+        if (!_started)
+            return true;
+
+        done = write(sb);
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("failed to write to client " << _peerAddr << ": " << e.what());
+        release(true);
+        return false;
+    }
+
+    if (done)
+    {
+        onEnd();
+        return false;
+    }
+
+    return true;
+}
+
+void DetachedConnection::flush()
+{
+    if (_released)
+        return;
+
+    bool done;
+
+    try
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _flushPending = false;
+        done = write(_socket.buffer());
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("failed to write to client " << _peerAddr << ": " << e.what());
+        release(true);
+        return;
+    }
+
+    if (done)
+        onEnd();
+}
+
+std::size_t DetachedConnection::outputPending() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _output.size() - _outputPos;
+}
+
+void DetachedConnection::output()
+{
+    if (inLoop())
+    {
+        flush();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_flushPending)
+            return;
+        _flushPending = true;
+    }
+
+    _server.detachedOutput(&_socket);
+}
+
+// Passes the next chunk of queued output to the stream buffer. Returns
+// true, when everything is sent and the connection ends.
+bool DetachedConnection::write(StreamBuffer& sb)
+{
+    if (sb.writing())
+        return false;
+
+    if (sb.out_avail() == 0 && _outputPos < _output.size())
+    {
+        std::size_t n = std::min(_output.size() - _outputPos, outputChunkSize);
+        sb.sputn(_output.data() + _outputPos, n);
+        _outputPos += n;
+
+        if (_outputPos == _output.size())
+        {
+            _output.clear();
+            _outputPos = 0;
+        }
+        else if (_outputPos >= 65536)
+        {
+            _output.erase(0, _outputPos);
+            _outputPos = 0;
+        }
+    }
+
+    if (sb.out_avail() > 0)
+    {
+        sb.beginWrite();
+        return false;
+    }
+
+    return ending();
+}
+
+void DetachedConnection::release(bool closeSocket)
+{
+    if (_released)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _released = true;
+    }
+
+    if (closeSocket)
+        _socket.close();
+
+    onRelease();
+
+    _server.detachedReleased(&_socket);
+}
+
+}
+}
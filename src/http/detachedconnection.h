@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_HTTP_DETACHEDCONNECTION_H
+#define CXXTOOLS_HTTP_DETACHEDCONNECTION_H
+
+#include <cxxtools/connectable.h>
+#include <mutex>
+#include <thread>
+#include <string>
+
+namespace cxxtools
+{
+
+class StreamBuffer;
+
+namespace http
+{
+
+class ServerImpl;
+class Socket;
+class Request;
+class Reply;
+
+/**
+ Base of connections, which are detached from the worker threads.
+
+ The reply header is sent by the worker, which processed the request.
+ After that the socket is passed to the event loop of the server, which
+ calls start() and runs all further I/O, so that an open connection holds
+ no thread.
+
+ Output is queued in a string and passed to the stream buffer of the socket
+ in chunks, so that writing never blocks the event loop. Output may be
+ queued from any thread; outside of the event loop the loop is woken.
+ */
+class DetachedConnection : public Connectable
+{
+        DetachedConnection(const DetachedConnection&) = delete;
+        DetachedConnection& operator=(const DetachedConnection&) = delete;
+
+    public:
+        DetachedConnection(ServerImpl& server, Socket& socket);
+        virtual ~DetachedConnection() { }
+
+        /// Called before the reply header is sent by the worker.
+        virtual void prepareReply(Request& /*request*/, Reply& /*reply*/) { }
+
+        /// Called, when the responder failed after detaching; the error reply is sent instead.
+        virtual void replyFailed() { }
+
+        // called in the thread of the event loop
+        void start(StreamBuffer& sb);
+        virtual void onInput(StreamBuffer& sb) = 0;
+        bool onOutput(StreamBuffer& sb);
+        virtual void flush();
+
+        /// Closes the connection, when the server terminates.
+        virtual void shutdown() = 0;
+
+        /// Returns the number of bytes queued and not sent yet.
+        std::size_t outputPending() const;
+
+        const std::string& peerAddr() const  { return _peerAddr; }
+
+    protected:
+        virtual void onStart(StreamBuffer& sb) = 0;
+
+        /// Returns true, when the connection ends after the queued output.
+        /// It is called with the mutex locked.
+        virtual bool ending() const = 0;
+
+        /// Called, when the output is sent completely and ending() returned true.
+        virtual void onEnd() = 0;
+
+        /// Called once, when the connection is released.
+        virtual void onRelease() = 0;
+
+        /// Sends the queued output or wakes the event loop to do so.
+        void output();
+
+        /// Ends the connection and passes the socket back to the server.
+        /// The socket is kept for further requests unless closeSocket is set.
+        virtual void release(bool closeSocket);
+
+        bool started() const   { return _started; }
+        bool released() const  { return _released; }
+        bool inLoop() const
+            { return std::this_thread::get_id() == _loopThread; }
+
+        ServerImpl& _server;
+        Socket& _socket;
+
+        // guards _output and the state of derived classes used by other threads
+        mutable std::mutex _mutex;
+        std::string _output;
+
+    private:
+        bool write(StreamBuffer& sb);
+
+        std::string _peerAddr;
+        std::size_t _outputPos;
+        bool _flushPending;
+        std::thread::id _loopThread;
+        bool _started;
+        bool _released;
+};
+
+}
+}
+
+#endif // CXXTOOLS_HTTP_DETACHEDCONNECTION_H
@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "detachedreplyimpl.h"
+#include "socket.h"
+#include <cxxtools/http/reply.h>
+#include <cxxtools/log.h>
+#include <cstdio>
+
+log_define("cxxtools.http.detachedreply")
+
+namespace cxxtools
+{
+namespace http
+{
+
+DetachedReplyImpl::DetachedReplyImpl(ServerImpl& server, Socket& socket, const Request& request)
+    : DetachedConnection(server, socket),
+      _reply(this),
+      _chunked(request.header().httpVersionMajor() == 1 && request.header().httpVersionMinor() >= 1),
+      _keepAlive(false),
+      _finishing(false)
+{
+    // the request object is not copyable; the body is not needed any more
+    _request.header() = request.header();
+    _request._pathParams = request._pathParams;
+}
+
+void DetachedReplyImpl::prepareReply(Request& request, Reply& reply)
+{
+    // the length of the body is not known
+    reply.removeHeader("Content-Length");
+
+    if (_chunked)
+        reply.setHeader("Transfer-Encoding", "chunked");
+    else
+        reply.setHeader("Connection", "close");
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _keepAlive = _chunked
+              && request.header().keepAlive()
+              && reply.header().keepAlive();
+
+    // the body written by the responder precedes data written meanwhile
+    std::string output;
+    output.swap(_output);
+    append(reply.bodyData(), reply.bodySize());
+    _output += output;
+
+    reply.bodyStream().reset();
+}
+
+void DetachedReplyImpl::replyFailed()
+{
+    finish();
+}
+
+void DetachedReplyImpl::onStart(StreamBuffer& sb)
+{
+    log_debug("reply " << _request.url() << " to client " << peerAddr() << " detached");
+
+    // The socket is read to notice, when the client goes away. A request
+    // sent meanwhile stays in the buffer until the reply is finished.
+    if (sb.in_avail() == 0)
+        sb.beginRead();
+}
+
+void DetachedReplyImpl::onInput(StreamBuffer& sb)
+{
+    try
+    {
+        sb.endRead();
+    }
+    catch (const std::exception& e)
+    {
+        log_debug("failed to read from client " << peerAddr() << ": " << e.what());
+        release(true);
+        return;
+    }
+
+    if (!started() || released())
+        return;
+
+    if (sb.in_avail() == 0 || sb.device()->eof())
+    {
+        log_debug("client " << peerAddr() << " closed connection");
+        release(true);
+        return;
+    }
+
+    // the next request is processed after this reply is finished
+    log_debug("client " << peerAddr() << " sent data while the reply is open");
+}
+
+void DetachedReplyImpl::shutdown()
+{
+    release(true);
+}
+
+void DetachedReplyImpl::write(const char* data, std::size_t size)
+{
+    if (size == 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_finishing || released())
+        {
+            log_debug("reply is finished; data discarded");
+            return;
+        }
+
+        append(data, size);
+    }
+
+    output();
+}
+
+void DetachedReplyImpl::sendEvent(const std::string& data, const std::string& event, const std::string& id)
+{
+    std::string msg;
+
+    if (!event.empty())
+    {
+        msg += "event: ";
+        msg += event;
+        msg += '\n';
+    }
+
+    if (!id.empty())
+    {
+        msg += "id: ";
+        msg += id;
+        msg += '\n';
+    }
+
+    std::string::size_type b = 0;
+    do
+    {
+        std::string::size_type e = data.find('\n', b);
+        if (e == std::string::npos)
+            e = data.size();
+
+        msg += "data: ";
+        msg.append(data, b, e - b);
+        msg += '\n';
+
+        b = e + 1;
+    } while (b <= data.size());
+
+    msg += '\n';
+
+    write(msg.data(), msg.size());
+}
+
+void DetachedReplyImpl::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_finishing || released())
+            return;
+
+        _finishing = true;
+        if (_chunked)
+            _output += "0\r\n\r\n";
+    }
+
+    output();
+}
+
+bool DetachedReplyImpl::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return !_finishing && !released();
+}
+
+void DetachedReplyImpl::onEnd()
+{
+    log_debug("detached reply to client " << peerAddr() << " finished");
+    release(!_keepAlive);
+}
+
+void DetachedReplyImpl::onRelease()
+{
+    try
+    {
+        _reply.closed(_reply);
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("handler of detached reply failed: " << e.what());
+    }
+}
+
+// Queues data as part of the body; the mutex must be locked.
+void DetachedReplyImpl::append(const char* data, std::size_t size)
+{
+    if (size == 0)
+        return;
+
+    if (_chunked)
+    {
+        char buffer[20];
+        std::snprintf(buffer, sizeof(buffer), "%lx\r\n", static_cast<unsigned long>(size));
+        _output += buffer;
+        _output.append(data, size);
+        _output += "\r\n";
+    }
+    else
+        _output.append(data, size);
+}
+
+}
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_HTTP_DETACHEDREPLYIMPL_H
+#define CXXTOOLS_HTTP_DETACHEDREPLYIMPL_H
+
+#include "detachedconnection.h"
+#include <cxxtools/http/detachedreply.h>
+#include <cxxtools/http/request.h>
+
+namespace cxxtools
+{
+namespace http
+{
+
+/**
+ A reply, which is continued by the event loop after the responder returned.
+
+ The body is sent in chunks to HTTP/1.1 clients and delimited by closing
+ the connection for HTTP/1.0 clients. While the reply is open, the socket is
+ read only to notice, when the client goes away.
+ */
+class DetachedReplyImpl : public DetachedConnection
+{
+    public:
+        DetachedReplyImpl(ServerImpl& server, Socket& socket, const Request& request);
+
+        DetachedReply& reply()               { return _reply; }
+
+        void prepareReply(Request& request, Reply& reply) override;
+        void replyFailed() override;
+
+        // called in the thread of the event loop
+        void onInput(StreamBuffer& sb) override;
+        void shutdown() override;
+
+        // interface of DetachedReply
+        const Request& request() const       { return _request; }
+        void write(const char* data, std::size_t size);
+        void sendEvent(const std::string& data, const std::string& event, const std::string& id);
+        void finish();
+        bool isOpen() const;
+
+    protected:
+        void onStart(StreamBuffer& sb) override;
+        bool ending() const override         { return _finishing; }
+        void onEnd() override;
+        void onRelease() override;
+
+    private:
+        void append(const char* data, std::size_t size);
+
+        Request _request;
+        DetachedReply _reply;
+        bool _chunked;
+        bool _keepAlive;
+        bool _finishing;
+};
+
+}
+}
+
+#endif // CXXTOOLS_HTTP_DETACHEDREPLYIMPL_H
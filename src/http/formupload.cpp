@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cxxtools/http/formupload.h>
+#include <cxxtools/http/request.h>
+#include <cxxtools/systemerror.h>
+#include <cxxtools/log.h>
+#include <stdexcept>
+#include <cstdlib>
+#include <errno.h>
+#include <strings.h>
+#include <unistd.h>
+
+log_define("cxxtools.http.formupload")
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+namespace
+{
+    // Returns the parameter of a header value like
+    // form-data; name="field"; filename="file.txt"
+    bool getParameter(const std::string& header, const std::string& param, std::string& value)
+    {
+        std::string::size_type pos = header.find(';');
+        while (pos != std::string::npos)
+        {
+            ++pos;
+            while (pos < header.size() && (header[pos] == ' ' || header[pos] == '\t'))
+                ++pos;
+
+            std::string::size_type eq = header.find('=', pos);
+            if (eq == std::string::npos)
+                break;
+
+            std::string key = header.substr(pos, eq - pos);
+            while (!key.empty() && (key[key.size() - 1] == ' ' || key[key.size() - 1] == '\t'))
+                key.erase(key.size() - 1);
+
+            std::string v;
+            pos = eq + 1;
+            if (pos < header.size() && header[pos] == '"')
+            {
+                for (++pos; pos < header.size() && header[pos] != '"'; ++pos)
+                {
+                    if (header[pos] == '\\' && pos + 1 < header.size())
+                        ++pos;
+                    v += header[pos];
+                }
+
+                pos = header.find(';', pos);
+            }
+            else
+            {
+                std::string::size_type end = header.find(';', pos);
+                v = header.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+                while (!v.empty() && (v[v.size() - 1] == ' ' || v[v.size() - 1] == '\t'))
+                    v.erase(v.size() - 1);
+                pos = end;
+            }
+
+            if (key.size() == param.size()
+                && strncasecmp(key.c_str(), param.c_str(), key.size()) == 0)
+            {
+                value = v;
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+FormUpload::FormUpload(const Request& request, std::size_t maxFieldSize)
+    : MultipartSink(request, *this),
+      _maxFieldSize(maxFieldSize),
+      _fd(-1)
+{
+    const char* tmpdir = std::getenv("TMPDIR");
+    _tmpdir = tmpdir && tmpdir[0] ? tmpdir : "/tmp";
+}
+
+FormUpload::~FormUpload()
+{
+    closeFile();
+
+    for (Parts::const_iterator it = _parts.begin(); it != _parts.end(); ++it)
+    {
+        if (!it->path.empty() && ::unlink(it->path.c_str()) != 0 && errno != ENOENT)
+            log_warn("failed to remove temporary file \"" << it->path << "\"; errno=" << errno);
+    }
+}
+
+const FormUpload::Part* FormUpload::part(const std::string& name) const
+{
+    for (Parts::const_iterator it = _parts.begin(); it != _parts.end(); ++it)
+        if (it->name == name)
+            return &*it;
+    return 0;
+}
+
+std::string FormUpload::value(const std::string& name, const std::string& def) const
+{
+    const Part* p = part(name);
+    return p ? p->value : def;
+}
+
+void FormUpload::onPartBegin(const MimeHeader& header)
+{
+    _parts.push_back(Part());
+    Part& p = _parts.back();
+    p.header = header;
+    p.contentType = header.getHeader("Content-Type", "text/plain");
+
+    std::string disposition = header.getHeader("Content-Disposition");
+    getParameter(disposition, "name", p.name);
+
+    if (getParameter(disposition, "filename", p.filename))
+    {
+        std::string path = _tmpdir + "/cxxtools-upload-XXXXXX";
+        _fd = ::mkstemp(&path[0]);
+        if (_fd < 0)
+            throw SystemError("mkstemp", "failed to create temporary file in \"" + _tmpdir + '"');
+        p.path = path;
+        log_debug("receive file \"" << p.filename << "\" of field \"" << p.name << "\" into \"" << path << '"');
+    }
+}
+
+void FormUpload::onPartData(const char* data, std::size_t size)
+{
+    Part& p = _parts.back();
+    p.size += size;
+
+    if (_fd < 0)
+    {
+        if (p.value.size() + size > _maxFieldSize)
+            throw std::runtime_error("form field \"" + p.name + "\" too large");
+        p.value.append(data, size);
+        return;
+    }
+
+    while (size > 0)
+    {
+        ssize_t n = ::write(_fd, data, size);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw SystemError("write", "failed to write temporary file \"" + p.path + '"');
+        }
+
+        data += n;
+        size -= n;
+    }
+}
+
+void FormUpload::onPartEnd()
+{
+    closeFile();
+}
+
+void FormUpload::closeFile()
+{
+    if (_fd >= 0)
+    {
+        ::close(_fd);
+        _fd = -1;
+    }
+}
+
+} // namespace http
+
+} // namespace cxxtools
@@ -0,0 +1,533 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "hpack.h"
+#include <cxxtools/log.h>
+#include <stdint.h>
+
+log_define("cxxtools.http.hpack")
+
+namespace cxxtools
+{
+namespace http
+{
+
+namespace
+{
+    const char* staticTable[HpackTable::staticTableSize][2] = {
+        { ":authority", "" },
+        { ":method", "GET" },
+        { ":method", "POST" },
+        { ":path", "/" },
+        { ":path", "/index.html" },
+        { ":scheme", "http" },
+        { ":scheme", "https" },
+        { ":status", "200" },
+        { ":status", "204" },
+        { ":status", "206" },
+        { ":status", "304" },
+        { ":status", "400" },
+        { ":status", "404" },
+        { ":status", "500" },
+        { "accept-charset", "" },
+        { "accept-encoding", "gzip, deflate" },
+        { "accept-language", "" },
+        { "accept-ranges", "" },
+        { "accept", "" },
+        { "access-control-allow-origin", "" },
+        { "age", "" },
+        { "allow", "" },
+        { "authorization", "" },
+        { "cache-control", "" },
+        { "content-disposition", "" },
+        { "content-encoding", "" },
+        { "content-language", "" },
+        { "content-length", "" },
+        { "content-location", "" },
+        { "content-range", "" },
+        { "content-type", "" },
+        { "cookie", "" },
+        { "date", "" },
+        { "etag", "" },
+        { "expect", "" },
+        { "expires", "" },
+        { "from", "" },
+        { "host", "" },
+        { "if-match", "" },
+        { "if-modified-since", "" },
+        { "if-none-match", "" },
+        { "if-range", "" },
+        { "if-unmodified-since", "" },
+        { "last-modified", "" },
+        { "link", "" },
+        { "location", "" },
+        { "max-forwards", "" },
+        { "proxy-authenticate", "" },
+        { "proxy-authorization", "" },
+        { "range", "" },
+        { "referer", "" },
+        { "refresh", "" },
+        { "retry-after", "" },
+        { "server", "" },
+        { "set-cookie", "" },
+        { "strict-transport-security", "" },
+        { "transfer-encoding", "" },
+        { "user-agent", "" },
+        { "vary", "" },
+        { "via", "" },
+        { "www-authenticate", "" }
+    };
+
+    const std::vector<HpackTable::Field>& staticFields()
+    {
+        static const std::vector<HpackTable::Field> fields = []() {
+            std::vector<HpackTable::Field> f;
+            for (std::size_t n = 0; n < HpackTable::staticTableSize; ++n)
+                f.push_back(HpackTable::Field(staticTable[n][0], staticTable[n][1]));
+            return f;
+        }();
+
+        return fields;
+    }
+
+    // Code lengths of the huffman code of RFC 7541 appendix B. The code is
+    // canonical, so the codes are assigned in order of length and symbol.
+    const unsigned char huffmanLengths[257] = {
+        13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+        28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+        6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+        5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+        13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+        7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+        15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+        6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+        20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+        24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+        22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+        21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+        26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+        19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+        20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+        26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+        30
+    };
+
+    const unsigned huffmanEos = 256;
+    const unsigned huffmanMaxLength = 30;
+
+    struct HuffmanCode
+    {
+        uint32_t code[257];
+        uint32_t first[huffmanMaxLength + 1];   // first code of each length
+        unsigned count[huffmanMaxLength + 1];   // number of codes of each length
+        unsigned offset[huffmanMaxLength + 1];  // index of first symbol of each length in symbols
+        uint16_t symbols[257];                  // symbols sorted by code
+
+        HuffmanCode()
+        {
+            for (unsigned l = 0; l <= huffmanMaxLength; ++l)
+                count[l] = 0;
+            for (unsigned s = 0; s < 257; ++s)
+                ++count[huffmanLengths[s]];
+
+            uint32_t c = 0;
+            unsigned o = 0;
+            for (unsigned l = 1; l <= huffmanMaxLength; ++l)
+            {
+                first[l] = c;
+                offset[l] = o;
+                c = (c + count[l]) << 1;
+                o += count[l];
+            }
+
+            unsigned next[huffmanMaxLength + 1];
+            for (unsigned l = 0; l <= huffmanMaxLength; ++l)
+                next[l] = 0;
+
+            for (unsigned s = 0; s < 257; ++s)
+            {
+                unsigned l = huffmanLengths[s];
+                code[s] = first[l] + next[l];
+                symbols[offset[l] + next[l]] = static_cast<uint16_t>(s);
+                ++next[l];
+            }
+        }
+    };
+
+    const HuffmanCode& huffmanCode()
+    {
+        static const HuffmanCode h;
+        return h;
+    }
+
+    void decodeString(std::string& out, const char*& p, const char* end)
+    {
+        if (p >= end)
+            throw HpackError("unexpected end of header block");
+
+        bool huffman = (*p & 0x80) != 0;
+        std::size_t size = hpack::decodeInteger(p, end, 7);
+        if (size > static_cast<std::size_t>(end - p))
+            throw HpackError("string literal exceeds header block");
+
+        out.clear();
+        if (huffman)
+            hpack::huffmanDecode(out, p, size);
+        else
+            out.assign(p, size);
+
+        p += size;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+// HpackTable
+//
+const std::size_t HpackTable::staticTableSize;
+
+const HpackTable::Field& HpackTable::get(std::size_t index) const
+{
+    if (index == 0)
+        throw HpackError("invalid header table index 0");
+
+    if (index <= staticTableSize)
+        return staticFields()[index - 1];
+
+    index -= staticTableSize + 1;
+    if (index >= _fields.size())
+        throw HpackError("header table index out of range");
+
+    return _fields[index];
+}
+
+void HpackTable::add(const std::string& name, const std::string& value)
+{
+    std::size_t entrySize = name.size() + value.size() + 32;
+    if (entrySize > _maxSize)
+    {
+        // an entry larger than the table empties the table
+        evict(0);
+        return;
+    }
+
+    evict(_maxSize - entrySize);
+    _fields.push_front(Field(name, value));
+    _size += entrySize;
+}
+
+std::size_t HpackTable::find(const std::string& name, const std::string& value, std::size_t& nameIndex) const
+{
+    nameIndex = 0;
+
+    const std::vector<Field>& s = staticFields();
+    for (std::size_t n = 0; n < s.size(); ++n)
+    {
+        if (s[n].first == name)
+        {
+            if (s[n].second == value)
+                return n + 1;
+            if (nameIndex == 0)
+                nameIndex = n + 1;
+        }
+    }
+
+    for (std::size_t n = 0; n < _fields.size(); ++n)
+    {
+        if (_fields[n].first == name)
+        {
+            if (_fields[n].second == value)
+                return n + staticTableSize + 1;
+            if (nameIndex == 0)
+                nameIndex = n + staticTableSize + 1;
+        }
+    }
+
+    return 0;
+}
+
+void HpackTable::maxSize(std::size_t n)
+{
+    _maxSize = n;
+    evict(n);
+}
+
+void HpackTable::evict(std::size_t maxSize)
+{
+    while (_size > maxSize)
+    {
+        const Field& f = _fields.back();
+        _size -= f.first.size() + f.second.size() + 32;
+        _fields.pop_back();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+// HpackDecoder
+//
+void HpackDecoder::decode(const char* data, std::size_t size, Fields& fields)
+{
+    const char* p = data;
+    const char* end = data + size;
+    bool fieldSeen = false;
+
+    while (p < end)
+    {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c & 0x80)
+        {
+            // indexed header field
+            fields.push_back(_table.get(hpack::decodeInteger(p, end, 7)));
+        }
+        else if ((c & 0xe0) == 0x20)
+        {
+            // dynamic table size update; allowed only at the start of a block
+            if (fieldSeen)
+                throw HpackError("table size update after header field");
+
+            std::size_t n = hpack::decodeInteger(p, end, 5);
+            if (n > _maxTableSize)
+                throw HpackError("table size update exceeds limit");
+
+            log_debug("table size update " << n);
+            _table.maxSize(n);
+            continue;
+        }
+        else
+        {
+            // literal header field with incremental indexing (01),
+            // without indexing (0000) or never indexed (0001)
+            bool indexing = (c & 0x40) != 0;
+            std::size_t index = hpack::decodeInteger(p, end, indexing ? 6 : 4);
+            if (index > 0)
+                _name = _table.get(index).first;
+            else
+                decodeString(_name, p, end);
+
+            decodeString(_value, p, end);
+
+            fields.push_back(HpackTable::Field(_name, _value));
+            if (indexing)
+                _table.add(_name, _value);
+        }
+
+        fieldSeen = true;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+// HpackEncoder
+//
+void HpackEncoder::beginBlock(std::string& out)
+{
+    if (_sizeUpdate)
+    {
+        hpack::encodeInteger(out, 5, 0x20, _table.maxSize());
+        _sizeUpdate = false;
+    }
+}
+
+void HpackEncoder::encode(std::string& out, const std::string& name, const std::string& value, bool index)
+{
+    std::size_t nameIndex;
+    std::size_t idx = _table.find(name, value, nameIndex);
+    if (idx > 0)
+    {
+        hpack::encodeInteger(out, 7, 0x80, idx);
+        return;
+    }
+
+    // large fields would just evict other entries
+    if (index && name.size() + value.size() + 32 > _table.maxSize() / 2)
+        index = false;
+
+    if (index)
+        hpack::encodeInteger(out, 6, 0x40, nameIndex);
+    else
+        hpack::encodeInteger(out, 4, 0x10, nameIndex);
+
+    if (nameIndex == 0)
+        hpack::encodeString(out, name);
+    hpack::encodeString(out, value);
+
+    if (index)
+        _table.add(name, value);
+}
+
+void HpackEncoder::maxTableSize(std::size_t n)
+{
+    // we do not need more than the default even if the peer allows it
+    if (n > 4096)
+        n = 4096;
+
+    if (n != _table.maxSize())
+    {
+        _table.maxSize(n);
+        _sizeUpdate = true;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+// primitives
+//
+namespace hpack
+{
+
+void encodeInteger(std::string& out, unsigned prefixBits, unsigned char flags, std::size_t value)
+{
+    std::size_t mask = (1u << prefixBits) - 1;
+    if (value < mask)
+    {
+        out += static_cast<char>(flags | value);
+        return;
+    }
+
+    out += static_cast<char>(flags | mask);
+    value -= mask;
+    while (value >= 0x80)
+    {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+
+    out += static_cast<char>(value);
+}
+
+std::size_t decodeInteger(const char*& p, const char* end, unsigned prefixBits)
+{
+    if (p >= end)
+        throw HpackError("unexpected end of header block");
+
+    std::size_t mask = (1u << prefixBits) - 1;
+    std::size_t value = static_cast<unsigned char>(*p++) & mask;
+    if (value < mask)
+        return value;
+
+    unsigned shift = 0;
+    while (true)
+    {
+        if (p >= end)
+            throw HpackError("unexpected end of header block");
+        if (shift > 28)
+            throw HpackError("integer too large");
+
+        unsigned char b = static_cast<unsigned char>(*p++);
+        value += static_cast<std::size_t>(b & 0x7f) << shift;
+        shift += 7;
+
+        if ((b & 0x80) == 0)
+            return value;
+    }
+}
+
+void encodeString(std::string& out, const std::string& s)
+{
+    std::size_t h = huffmanEncodedSize(s.data(), s.size());
+    if (h < s.size())
+    {
+        encodeInteger(out, 7, 0x80, h);
+        huffmanEncode(out, s.data(), s.size());
+    }
+    else
+    {
+        encodeInteger(out, 7, 0, s.size());
+        out.append(s);
+    }
+}
+
+void huffmanEncode(std::string& out, const char* s, std::size_t size)
+{
+    const HuffmanCode& h = huffmanCode();
+
+    uint64_t bits = 0;
+    unsigned n = 0;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        unsigned char ch = static_cast<unsigned char>(s[i]);
+        bits = (bits << huffmanLengths[ch]) | h.code[ch];
+        n += huffmanLengths[ch];
+        while (n >= 8)
+        {
+            n -= 8;
+            out += static_cast<char>(bits >> n);
+        }
+
+        bits &= (uint64_t(1) << n) - 1;
+    }
+
+    // pad with the most significant bits of EOS, which are all ones
+    if (n > 0)
+        out += static_cast<char>((bits << (8 - n)) | ((1u << (8 - n)) - 1));
+}
+
+std::size_t huffmanEncodedSize(const char* s, std::size_t size)
+{
+    std::size_t bits = 0;
+    for (std::size_t i = 0; i < size; ++i)
+        bits += huffmanLengths[static_cast<unsigned char>(s[i])];
+    return (bits + 7) / 8;
+}
+
+void huffmanDecode(std::string& out, const char* data, std::size_t size)
+{
+    const HuffmanCode& h = huffmanCode();
+
+    uint32_t code = 0;
+    unsigned len = 0;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        unsigned char b = static_cast<unsigned char>(data[i]);
+        for (int bit = 7; bit >= 0; --bit)
+        {
+            code = (code << 1) | ((b >> bit) & 1);
+            ++len;
+
+            if (code >= h.first[len] && code - h.first[len] < h.count[len])
+            {
+                unsigned sym = h.symbols[h.offset[len] + code - h.first[len]];
+                if (sym == huffmanEos)
+                    throw HpackError("EOS in huffman coded string");
+
+                out += static_cast<char>(sym);
+                code = 0;
+                len = 0;
+            }
+            else if (len >= huffmanMaxLength)
+                throw HpackError("invalid huffman code");
+        }
+    }
+
+    // padding must be shorter than a byte and consist of ones
+    if (len > 7 || code != (1u << len) - 1)
+        throw HpackError("invalid huffman padding");
+}
+
+}
+
+}
+}
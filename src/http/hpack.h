@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_HTTP_HPACK_H
+#define CXXTOOLS_HTTP_HPACK_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <stdexcept>
+
+namespace cxxtools
+{
+namespace http
+{
+
+/// Thrown when a header block can't be decoded; maps to the http/2 COMPRESSION_ERROR.
+class HpackError : public std::runtime_error
+{
+    public:
+        explicit HpackError(const std::string& msg)
+            : std::runtime_error(msg)
+            { }
+};
+
+/**
+ The header table of HPACK (RFC 7541).
+
+ Indexes start with the 61 entries of the static table followed by the
+ entries of the dynamic table, newest first.
+ */
+class HpackTable
+{
+    public:
+        typedef std::pair<std::string, std::string> Field;
+
+        static const std::size_t staticTableSize = 61;
+
+        explicit HpackTable(std::size_t maxSize = 4096)
+            : _size(0),
+              _maxSize(maxSize)
+            { }
+
+        /// Returns the field at the 1 based index; throws HpackError when out of range.
+        const Field& get(std::size_t index) const;
+
+        /// Inserts a field into the dynamic table and evicts old entries when needed.
+        void add(const std::string& name, const std::string& value);
+
+        /// Searches name and value and returns the index or 0 if not found.
+        /// When only the name is found, its index is returned in nameIndex.
+        std::size_t find(const std::string& name, const std::string& value, std::size_t& nameIndex) const;
+
+        std::size_t maxSize() const    { return _maxSize; }
+        void maxSize(std::size_t n);
+
+        /// Returns the size of the dynamic table as defined by HPACK.
+        std::size_t size() const       { return _size; }
+
+        /// Returns the number of entries in the dynamic table.
+        std::size_t count() const      { return _fields.size(); }
+
+    private:
+        void evict(std::size_t maxSize);
+
+        std::deque<Field> _fields;
+        std::size_t _size;
+        std::size_t _maxSize;
+};
+
+class HpackDecoder
+{
+    public:
+        typedef std::vector<HpackTable::Field> Fields;
+
+        explicit HpackDecoder(std::size_t maxTableSize = 4096)
+            : _table(maxTableSize),
+              _maxTableSize(maxTableSize)
+            { }
+
+        /// Decodes a complete header block and appends the fields.
+        void decode(const char* data, std::size_t size, Fields& fields);
+
+        /// Sets the upper limit for table size updates sent by the encoder.
+        void maxTableSize(std::size_t n)  { _maxTableSize = n; }
+
+        const HpackTable& table() const   { return _table; }
+
+    private:
+        HpackTable _table;
+        std::size_t _maxTableSize;
+        std::string _name;
+        std::string _value;
+};
+
+class HpackEncoder
+{
+    public:
+        explicit HpackEncoder(std::size_t maxTableSize = 4096)
+            : _table(maxTableSize),
+              _sizeUpdate(false)
+            { }
+
+        /// Starts a new header block; must be called before the fields are encoded.
+        void beginBlock(std::string& out);
+
+        /// Appends a field to the header block. When `index` is false, the
+        /// field is not added to the dynamic table and marked as never indexed.
+        void encode(std::string& out, const std::string& name, const std::string& value, bool index = true);
+
+        /// Sets the table size allowed by the decoder (SETTINGS_HEADER_TABLE_SIZE).
+        void maxTableSize(std::size_t n);
+
+        const HpackTable& table() const   { return _table; }
+
+    private:
+        HpackTable _table;
+        bool _sizeUpdate;
+};
+
+namespace hpack
+{
+    /// Appends an integer with the given prefix size; `flags` holds the bits above the prefix.
+    void encodeInteger(std::string& out, unsigned prefixBits, unsigned char flags, std::size_t value);
+
+    /// Reads an integer with the given prefix size and advances p.
+    std::size_t decodeInteger(const char*& p, const char* end, unsigned prefixBits);
+
+    /// Appends a string literal; huffman coding is used when it is shorter.
+    void encodeString(std::string& out, const std::string& s);
+
+    void huffmanEncode(std::string& out, const char* s, std::size_t size);
+    std::size_t huffmanEncodedSize(const char* s, std::size_t size);
+    void huffmanDecode(std::string& out, const char* data, std::size_t size);
+}
+
+}
+}
+
+#endif // CXXTOOLS_HTTP_HPACK_H
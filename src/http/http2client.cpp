@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <cxxtools/http/http2client.h>
+#include <cxxtools/http/request.h>
+#include <cxxtools/net/addrinfo.h>
+#include "http2clientimpl.h"
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+Http2Client::Http2Client()
+    : _impl(new Http2ClientImpl(*this))
+{
+}
+
+Http2Client::Http2Client(SelectorBase& selector)
+    : _impl(new Http2ClientImpl(*this))
+{
+    setSelector(selector);
+}
+
+Http2Client::Http2Client(const std::string& host, unsigned short port)
+    : _impl(new Http2ClientImpl(*this))
+{
+    prepareConnect(host, port);
+}
+
+Http2Client::Http2Client(SelectorBase& selector, const std::string& host, unsigned short port)
+    : _impl(new Http2ClientImpl(*this))
+{
+    setSelector(selector);
+    prepareConnect(host, port);
+}
+
+Http2Client::~Http2Client()
+{
+    delete _impl;
+}
+
+void Http2Client::prepareConnect(const net::AddrInfo& addr)
+{
+    _impl->prepareConnect(addr);
+}
+
+void Http2Client::prepareConnect(const std::string& host, unsigned short port)
+{
+    _impl->prepareConnect(net::AddrInfo(host, port));
+}
+
+void Http2Client::connect()
+{
+    _impl->connect();
+}
+
+void Http2Client::close()
+{
+    _impl->close();
+}
+
+void Http2Client::upgrade(bool sw)
+{
+    _impl->upgrade(sw);
+}
+
+bool Http2Client::upgrade() const
+{
+    return _impl->upgrade();
+}
+
+const Reply& Http2Client::execute(const Request& request, Milliseconds timeout)
+{
+    return _impl->endExecute(_impl->beginExecute(request), timeout);
+}
+
+const Reply& Http2Client::get(const std::string& url, Milliseconds timeout)
+{
+    Request request(url);
+    request.method("GET");
+    return execute(request, timeout);
+}
+
+unsigned Http2Client::beginExecute(const Request& request)
+{
+    return _impl->beginExecute(request);
+}
+
+const Reply& Http2Client::endExecute(unsigned id, Milliseconds timeout)
+{
+    return _impl->endExecute(id, timeout);
+}
+
+bool Http2Client::finished(unsigned id) const
+{
+    return _impl->finished(id);
+}
+
+void Http2Client::setSelector(SelectorBase* selector)
+{
+    _impl->setSelector(selector);
+}
+
+SelectorBase* Http2Client::selector()
+{
+    return _impl->selector();
+}
+
+bool Http2Client::wait(Milliseconds msecs)
+{
+    return _impl->wait(msecs);
+}
+
+} // namespace http
+
+} // namespace cxxtools
@@ -0,0 +1,585 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "http2clientimpl.h"
+#include <cxxtools/http/http2client.h>
+#include <cxxtools/http/request.h>
+#include <cxxtools/base64codec.h>
+#include <cxxtools/ioerror.h>
+#include <cxxtools/convert.h>
+#include <cxxtools/log.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include "config.h"
+
+log_define("cxxtools.http.http2client.impl")
+
+namespace cxxtools
+{
+namespace http
+{
+
+namespace
+{
+    std::string lowercase(const std::string& s)
+    {
+        std::string ret(s);
+        for (std::string::iterator it = ret.begin(); it != ret.end(); ++it)
+            *it = std::tolower(static_cast<unsigned char>(*it));
+        return ret;
+    }
+
+    bool connectionSpecific(const std::string& name)
+    {
+        return name == "connection"
+            || name == "keep-alive"
+            || name == "proxy-connection"
+            || name == "transfer-encoding"
+            || name == "upgrade";
+    }
+
+    std::string base64url(const std::string& data)
+    {
+        std::string ret = Base64Codec::encode(data.data(), data.size());
+        ret.erase(std::remove(ret.begin(), ret.end(), '='), ret.end());
+        for (std::string::iterator it = ret.begin(); it != ret.end(); ++it)
+        {
+            if (*it == '+')
+                *it = '-';
+            else if (*it == '/')
+                *it = '_';
+        }
+        return ret;
+    }
+}
+
+Http2ClientImpl::Http2ClientImpl(Http2Client& client)
+    : _client(client),
+      _stream(8192, true),
+      _nextCallId(1),
+      _lastCall(0),
+      _upgrade(false),
+      _upgradePending(false),
+      _upgradeCall(0)
+{
+    _stream.attachDevice(_socket);
+    cxxtools::connect(_stream.buffer().inputReady, *this, &Http2ClientImpl::onInput);
+    cxxtools::connect(_stream.buffer().outputReady, *this, &Http2ClientImpl::onOutput);
+}
+
+Http2ClientImpl::~Http2ClientImpl()
+{
+    for (Calls::iterator it = _calls.begin(); it != _calls.end(); ++it)
+        delete it->second;
+    delete _lastCall;
+}
+
+void Http2ClientImpl::prepareConnect(const net::AddrInfo& addrInfo)
+{
+    if (addrInfo != _addrInfo)
+    {
+        _addrInfo = addrInfo;
+        close();
+    }
+}
+
+void Http2ClientImpl::connect()
+{
+    // streams of a previous connection are lost; queued requests are sent
+    // on the new connection
+    std::vector<unsigned> lost;
+    for (std::map<unsigned, unsigned>::const_iterator it = _streams.begin(); it != _streams.end(); ++it)
+        if (it->second)
+            lost.push_back(it->second);
+    _streams.clear();
+
+    for (std::vector<unsigned>::const_iterator it = lost.begin(); it != lost.end(); ++it)
+    {
+        Call* call = _calls[*it];
+        call->failed = true;
+        call->error = "connection closed";
+        finishCall(*it, call);
+    }
+
+    _socket.close();
+    _stream.clear();
+    _stream.buffer().discard();
+
+    log_debug("connect to " << _addrInfo.host() << ':' << _addrInfo.port());
+    _socket.connect(_addrInfo);
+
+    _connection.reset(new Http2Connection(*this, _stream, false));
+    _stream.buffer().beginRead();
+
+    if (_upgrade)
+    {
+        _upgradePending = true;
+        sendUpgradeRequest();
+    }
+    else
+    {
+        _upgradePending = false;
+        _connection->start();
+        sendQueued();
+    }
+
+    flushOutput();
+}
+
+void Http2ClientImpl::close()
+{
+    failAll("connection closed");
+    _socket.close();
+    _connection.reset();
+    _upgradePending = false;
+}
+
+unsigned Http2ClientImpl::beginExecute(const Request& request)
+{
+    unsigned id = _nextCallId++;
+    if (id == 0)
+        id = _nextCallId++;
+
+    Call* call = new Call();
+    setFields(call, request);
+    call->body = request.bodyStr();
+
+    _calls[id] = call;
+    _queue.push_back(id);
+
+    try
+    {
+        if (!_socket.isConnected() || !_connection)
+            connect();
+        else
+            sendQueued();
+    }
+    catch (...)
+    {
+        cancel(id);
+        throw;
+    }
+
+    return id;
+}
+
+const Reply& Http2ClientImpl::endExecute(unsigned id, Milliseconds timeout)
+{
+    Calls::iterator it = _calls.find(id);
+    if (it == _calls.end())
+        throw std::logic_error("unknown http/2 request id " + convert<std::string>(id));
+
+    Call* call = it->second;
+    while (!call->finished)
+    {
+        if (!_socket.wait(timeout))
+        {
+            cancel(id);
+            throw IOTimeout();
+        }
+    }
+
+    delete _lastCall;
+    _lastCall = call;
+    _calls.erase(id);
+
+    if (call->failed)
+        throw IOError(call->error);
+
+    return call->reply;
+}
+
+bool Http2ClientImpl::finished(unsigned id) const
+{
+    Calls::const_iterator it = _calls.find(id);
+    return it == _calls.end() || it->second->finished;
+}
+
+void Http2ClientImpl::cancel(unsigned id)
+{
+    Call* call = _calls[id];
+    _calls.erase(id);
+
+    std::deque<unsigned>::iterator q = std::find(_queue.begin(), _queue.end(), id);
+    if (q != _queue.end())
+        _queue.erase(q);
+
+    if (call->streamId != 0 && _streams.erase(call->streamId) && _connection)
+    {
+        _connection->resetStream(call->streamId, Http2Connection::Cancel);
+        flushOutput();
+    }
+
+    if (_upgradeCall == id)
+        _upgradeCall = 0;
+
+    delete call;
+}
+
+void Http2ClientImpl::setFields(Call* call, const Request& request)
+{
+    std::string authority;
+    const char* host = request.header().getHeader(MessageHeader::Host);
+    if (host)
+        authority = host;
+    else
+    {
+        authority = _addrInfo.host();
+        if (_addrInfo.port() != 80)
+            authority += ':' + convert<std::string>(_addrInfo.port());
+    }
+
+    std::string path = '/' + request.url();
+    if (!request.qparams().empty() && request.method() == "GET")
+        path += '?' + request.qparams();
+
+    Http2Connection::Fields& fields = call->fields;
+    fields.push_back(HpackTable::Field(":method", request.method()));
+    fields.push_back(HpackTable::Field(":scheme", "http"));
+    fields.push_back(HpackTable::Field(":authority", authority));
+    fields.push_back(HpackTable::Field(":path", path));
+
+    for (RequestHeader::const_iterator it = request.header().begin(); it != request.header().end(); ++it)
+    {
+        std::string name = lowercase(it->first);
+        if (name != "host" && !connectionSpecific(name))
+            fields.push_back(HpackTable::Field(name, it->second));
+    }
+
+    if (!request.header().hasHeader(MessageHeader::ContentLength) && request.bodySize() > 0)
+        fields.push_back(HpackTable::Field("content-length", convert<std::string>(request.bodySize())));
+
+    if (!request.header().hasHeader(MessageHeader::UserAgent))
+        fields.push_back(HpackTable::Field("user-agent", PACKAGE_STRING " http client"));
+}
+
+void Http2ClientImpl::sendUpgradeRequest()
+{
+    // The first request is sent in HTTP/1.1 and answered on stream 1. A
+    // request with a body would not be upgraded, so we use a HEAD request
+    // then and discard its reply.
+    _upgradeCall = 0;
+    Http2Connection::Fields head;
+    const Http2Connection::Fields* fields = &head;
+
+    if (!_queue.empty() && _calls[_queue.front()]->body.empty())
+    {
+        _upgradeCall = _queue.front();
+        _queue.pop_front();
+        fields = &_calls[_upgradeCall]->fields;
+    }
+    else
+    {
+        Call c;
+        Request request;
+        request.method("HEAD");
+        setFields(&c, request);
+        head.swap(c.fields);
+    }
+
+    std::string method, path, authority;
+    for (Http2Connection::Fields::const_iterator it = fields->begin(); it != fields->end(); ++it)
+    {
+        if (it->first == ":method")
+            method = it->second;
+        else if (it->first == ":path")
+            path = it->second;
+        else if (it->first == ":authority")
+            authority = it->second;
+    }
+
+    log_debug("send upgrade request " << method << ' ' << path);
+
+    _stream << method << ' ' << path << " HTTP/1.1\r\n"
+            << "Host: " << authority << "\r\n";
+
+    for (Http2Connection::Fields::const_iterator it = fields->begin(); it != fields->end(); ++it)
+        if (it->first[0] != ':')
+            _stream << it->first << ": " << it->second << "\r\n";
+
+    _stream << "Connection: Upgrade, HTTP2-Settings\r\n"
+               "Upgrade: h2c\r\n"
+               "HTTP2-Settings: " << base64url(_connection->settingsPayload()) << "\r\n"
+               "\r\n";
+}
+
+bool Http2ClientImpl::processUpgradeReply(StreamBuffer& sb)
+{
+    static const char end[] = "\r\n\r\n";
+
+    const char* b = sb.inputBegin();
+    const char* e = b + sb.in_avail();
+    const char* p = std::search(b, e, end, end + 4);
+    if (p == e)
+    {
+        if (static_cast<std::size_t>(sb.in_avail()) >= sb.inputCapacity())
+            throw IOError("invalid reply to h2c upgrade");
+        return false;
+    }
+
+    bool switched = e - b >= 12 && std::memcmp(b, "HTTP/1.1 101", 12) == 0;
+    sb.inputConsume(p + 4 - b);
+
+    if (!switched)
+        throw IOError("server refused h2c upgrade");
+
+    log_debug("switched to http/2");
+
+    _upgradePending = false;
+    _connection->upgrade();
+
+    _streams[1] = _upgradeCall;
+    if (_upgradeCall)
+        _calls[_upgradeCall]->streamId = 1;
+
+    sendQueued();
+
+    return true;
+}
+
+void Http2ClientImpl::sendQueued()
+{
+    if (!_connection || _upgradePending)
+        return;
+
+    while (!_queue.empty()
+        && !_connection->goingAway()
+        && _connection->openStreams() < _connection->peerMaxConcurrentStreams())
+    {
+        unsigned id = _queue.front();
+        _queue.pop_front();
+        sendCall(id, _calls[id]);
+    }
+
+    flushOutput();
+}
+
+void Http2ClientImpl::sendCall(unsigned callId, Call* call)
+{
+    unsigned streamId = _connection->newStreamId();
+    log_debug("send request " << callId << " on stream " << streamId);
+
+    call->streamId = streamId;
+    _streams[streamId] = callId;
+
+    bool hasBody = !call->body.empty();
+    _connection->sendHeaders(streamId, call->fields, !hasBody);
+    if (hasBody)
+    {
+        _connection->sendData(streamId, call->body.data(), call->body.size(), true);
+        std::string().swap(call->body);
+    }
+}
+
+void Http2ClientImpl::flushOutput()
+{
+    if (_socket.isConnected() && _stream.buffer().out_avail())
+        _stream.buffer().beginWrite();
+}
+
+void Http2ClientImpl::onHeaders(unsigned streamId, Http2Connection::Fields& fields, bool endStream)
+{
+    std::map<unsigned, unsigned>::iterator s = _streams.find(streamId);
+    if (s == _streams.end())
+        return;
+
+    Call* call = s->second ? _calls[s->second] : 0;
+    if (call && !call->headersReceived)
+    {
+        unsigned status = 0;
+        for (Http2Connection::Fields::const_iterator it = fields.begin(); it != fields.end(); ++it)
+            if (it->first == ":status")
+                status = convert<unsigned>(it->second);
+
+        // informational replies are skipped
+        if (status >= 100 && status < 200 && !endStream)
+            return;
+
+        ReplyHeader& header = call->reply.header();
+        header.httpVersion(2, 0);
+        header.httpReturn(status, std::string());
+        for (Http2Connection::Fields::const_iterator it = fields.begin(); it != fields.end(); ++it)
+            if (it->first[0] != ':')
+                header.addHeader(it->first.data(), it->first.size(), it->second.data(), it->second.size());
+
+        call->headersReceived = true;
+    }
+
+    if (endStream)
+        finish(streamId);
+}
+
+void Http2ClientImpl::onData(unsigned streamId, const char* data, std::size_t size, bool endStream)
+{
+    std::map<unsigned, unsigned>::iterator s = _streams.find(streamId);
+    if (s == _streams.end())
+        return;
+
+    if (s->second)
+        _calls[s->second]->reply.bodyStream().write(data, size);
+
+    if (endStream)
+        finish(streamId);
+}
+
+void Http2ClientImpl::onReset(unsigned streamId, unsigned errorCode)
+{
+    std::map<unsigned, unsigned>::iterator s = _streams.find(streamId);
+    if (s == _streams.end())
+        return;
+
+    unsigned callId = s->second;
+    _streams.erase(s);
+    if (callId == 0)
+        return;
+
+    Call* call = _calls[callId];
+    if (errorCode == Http2Connection::RefusedStream && _connection->goingAway())
+    {
+        // the server did not process the request, so it is sent again on a new connection
+        log_debug("request " << callId << " refused; retry");
+        call->streamId = 0;
+        call->reply.clear();
+        call->headersReceived = false;
+        _queue.push_front(callId);
+        return;
+    }
+
+    call->failed = true;
+    call->error = "http/2 stream reset by server; error code " + convert<std::string>(errorCode);
+    finishCall(callId, call);
+}
+
+void Http2ClientImpl::finish(unsigned streamId)
+{
+    unsigned callId = _streams[streamId];
+    _streams.erase(streamId);
+
+    if (callId)
+        finishCall(callId, _calls[callId]);
+}
+
+void Http2ClientImpl::finishCall(unsigned callId, Call* call)
+{
+    log_debug("request " << callId << " finished");
+    call->finished = true;
+    _client.replyFinished(_client, callId);
+}
+
+void Http2ClientImpl::failAll(const std::string& error)
+{
+    _streams.clear();
+    _queue.clear();
+
+    std::vector<unsigned> ids;
+    for (Calls::const_iterator it = _calls.begin(); it != _calls.end(); ++it)
+        if (!it->second->finished)
+            ids.push_back(it->first);
+
+    for (std::vector<unsigned>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+    {
+        Call* call = _calls[*it];
+        call->failed = true;
+        call->error = error;
+        finishCall(*it, call);
+    }
+}
+
+void Http2ClientImpl::onInput(StreamBuffer& sb)
+{
+    try
+    {
+        sb.endRead();
+
+        if (sb.in_avail() == 0 || sb.device()->eof())
+            throw IOError("connection closed by server");
+
+        if (_upgradePending && !processUpgradeReply(sb))
+        {
+            sb.beginRead();
+            return;
+        }
+
+        std::size_t n = sb.in_avail();
+        _connection->process(sb.inputBegin(), n);
+        sb.inputConsume(n);
+
+        if (_connection->failed())
+        {
+            flushOutput();
+            throw IOError("http/2 connection error");
+        }
+
+        if (_connection->goingAway() && _connection->openStreams() == 0)
+        {
+            log_debug("connection finished by server");
+            if (_queue.empty())
+            {
+                _socket.close();
+                _connection.reset();
+            }
+            else
+                connect();
+            return;
+        }
+
+        sendQueued();
+        sb.beginRead();
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("http/2 client error: " << e.what());
+        _socket.close();
+        _connection.reset();
+        _upgradePending = false;
+        failAll(e.what());
+    }
+}
+
+void Http2ClientImpl::onOutput(StreamBuffer& sb)
+{
+    try
+    {
+        sb.endWrite();
+        if (sb.out_avail())
+            sb.beginWrite();
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("http/2 client error: " << e.what());
+        _socket.close();
+        _connection.reset();
+        _upgradePending = false;
+        failAll(e.what());
+    }
+}
+
+}
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_HTTP_HTTP2CLIENTIMPL_H
+#define CXXTOOLS_HTTP_HTTP2CLIENTIMPL_H
+
+#include "http2connection.h"
+#include <cxxtools/http/reply.h>
+#include <cxxtools/net/addrinfo.h>
+#include <cxxtools/net/tcpsocket.h>
+#include <cxxtools/iostream.h>
+#include <cxxtools/connectable.h>
+#include <cxxtools/timespan.h>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cxxtools
+{
+namespace http
+{
+
+class Http2Client;
+class Request;
+
+class Http2ClientImpl : public Connectable, private Http2Connection::Handler
+{
+        struct Call
+        {
+            Call()
+                : streamId(0),
+                  headersReceived(false),
+                  finished(false),
+                  failed(false)
+                { }
+
+            Http2Connection::Fields fields;
+            std::string body;
+            Reply reply;
+            unsigned streamId;
+            bool headersReceived;
+            bool finished;
+            bool failed;
+            std::string error;
+        };
+
+        typedef std::map<unsigned, Call*> Calls;
+
+        Http2Client& _client;
+        net::AddrInfo _addrInfo;
+        net::TcpSocket _socket;
+        IOStream _stream;
+        std::unique_ptr<Http2Connection> _connection;
+
+        Calls _calls;                       // by call id
+        std::map<unsigned, unsigned> _streams;  // stream id to call id
+        std::deque<unsigned> _queue;        // calls waiting for a free stream
+        unsigned _nextCallId;
+        Call* _lastCall;                    // returned by the last endExecute
+
+        bool _upgrade;
+        bool _upgradePending;               // waiting for "101 Switching Protocols"
+        unsigned _upgradeCall;
+
+        Http2ClientImpl(const Http2ClientImpl&) = delete;
+        Http2ClientImpl& operator=(const Http2ClientImpl&) = delete;
+
+        void onHeaders(unsigned streamId, Http2Connection::Fields& fields, bool endStream);
+        void onData(unsigned streamId, const char* data, std::size_t size, bool endStream);
+        void onReset(unsigned streamId, unsigned errorCode);
+
+        void onInput(StreamBuffer& sb);
+        void onOutput(StreamBuffer& sb);
+
+        void setFields(Call* call, const Request& request);
+        void sendUpgradeRequest();
+        bool processUpgradeReply(StreamBuffer& sb);
+        void sendQueued();
+        void sendCall(unsigned callId, Call* call);
+        void flushOutput();
+        void finish(unsigned streamId);
+        void finishCall(unsigned callId, Call* call);
+        void failAll(const std::string& error);
+        void cancel(unsigned id);
+
+    public:
+        explicit Http2ClientImpl(Http2Client& client);
+        ~Http2ClientImpl();
+
+        void prepareConnect(const net::AddrInfo& addrInfo);
+        void connect();
+        void close();
+
+        void upgrade(bool sw)       { _upgrade = sw; }
+        bool upgrade() const        { return _upgrade; }
+
+        unsigned beginExecute(const Request& request);
+        const Reply& endExecute(unsigned id, Milliseconds timeout);
+        bool finished(unsigned id) const;
+
+        void setSelector(SelectorBase* selector)
+            { _socket.setSelector(selector); }
+        SelectorBase* selector()
+            { return _socket.selector(); }
+
+        bool wait(Milliseconds timeout)
+            { return _socket.wait(timeout); }
+};
+
+}
+}
+
+#endif // CXXTOOLS_HTTP_HTTP2CLIENTIMPL_H
@@ -0,0 +1,868 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "http2connection.h"
+#include <cxxtools/log.h>
+#include <ostream>
+#include <cstring>
+#include <vector>
+
+log_define("cxxtools.http.http2")
+
+namespace cxxtools
+{
+namespace http
+{
+
+namespace
+{
+    // we allow the peer to send this much on all streams before waiting for a WINDOW_UPDATE
+    const long connectionWindowSize = 1 << 20;
+
+    const long maxWindowSize = 0x7fffffff;
+    const std::size_t maxHeaderBlockSize = 65536;
+
+    unsigned get16(const char* p)
+    {
+        const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+        return (static_cast<unsigned>(u[0]) << 8) | u[1];
+    }
+
+    unsigned get32(const char* p)
+    {
+        const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+        return (static_cast<unsigned>(u[0]) << 24) | (static_cast<unsigned>(u[1]) << 16)
+             | (static_cast<unsigned>(u[2]) << 8) | u[3];
+    }
+
+    void put16(std::string& out, unsigned v)
+    {
+        out += static_cast<char>(v >> 8);
+        out += static_cast<char>(v);
+    }
+
+    void put32(std::string& out, unsigned v)
+    {
+        out += static_cast<char>(v >> 24);
+        out += static_cast<char>(v >> 16);
+        out += static_cast<char>(v >> 8);
+        out += static_cast<char>(v);
+    }
+
+    void put32(std::ostream& out, unsigned v)
+    {
+        char b[4] = {
+            static_cast<char>(v >> 24), static_cast<char>(v >> 16),
+            static_cast<char>(v >> 8), static_cast<char>(v) };
+        out.write(b, 4);
+    }
+
+    // values, which should not go into the header table
+    bool indexHeader(const std::string& name)
+    {
+        return name != ":path"
+            && name != "content-length"
+            && name != "date"
+            && name != "authorization"
+            && name != "set-cookie";
+    }
+
+    // strips the padding of DATA and HEADERS frames
+    void stripPadding(unsigned flags, const char*& payload, std::size_t& length)
+    {
+        if ((flags & Http2Connection::FlagPadded) == 0)
+            return;
+
+        if (length < 1)
+            throw Http2Error(Http2Connection::ProtocolError, "missing pad length");
+
+        std::size_t padding = static_cast<unsigned char>(payload[0]);
+        ++payload;
+        --length;
+        if (padding > length)
+            throw Http2Error(Http2Connection::ProtocolError, "padding exceeds frame");
+
+        length -= padding;
+    }
+}
+
+const char Http2Connection::preface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+const std::size_t Http2Connection::prefaceSize;
+const unsigned Http2Connection::defaultWindowSize;
+const unsigned Http2Connection::defaultMaxFrameSize;
+const unsigned Http2Connection::maxConcurrentStreams;
+
+Http2Connection::Http2Connection(Handler& handler, std::ostream& out, bool server)
+    : _handler(handler),
+      _out(out),
+      _server(server),
+      _prefaceReceived(!server),
+      _settingsReceived(false),
+      _goingAway(false),
+      _failed(false),
+      _goAwaySent(false),
+      _lastRemoteStreamId(0),
+      _nextStreamId(server ? 2 : 1),
+      _continuationStream(0),
+      _continuationEndStream(false),
+      _peerMaxStreams(maxConcurrentStreams),
+      _peerInitialWindow(defaultWindowSize),
+      _peerMaxFrameSize(defaultMaxFrameSize),
+      _sendWindow(defaultWindowSize),
+      _recvWindow(connectionWindowSize),
+      _unacked(0)
+{
+}
+
+void Http2Connection::start()
+{
+    if (!_server)
+        _out.write(preface, prefaceSize);
+
+    std::string settings = settingsPayload();
+    writeFrameHeader(settings.size(), Settings, 0, 0);
+    _out << settings;
+
+    writeWindowUpdate(0, connectionWindowSize - defaultWindowSize);
+}
+
+void Http2Connection::upgrade(const std::string& settings)
+{
+    if (_server)
+    {
+        applySettings(settings.data(), settings.size());
+        _lastRemoteStreamId = 1;
+        Stream& s = _streams.insert(Streams::value_type(1, Stream(_peerInitialWindow, defaultWindowSize))).first->second;
+        s.remoteClosed = true;
+    }
+    else
+    {
+        _nextStreamId = 3;
+        Stream& s = _streams.insert(Streams::value_type(1, Stream(_peerInitialWindow, defaultWindowSize))).first->second;
+        s.localClosed = true;
+    }
+
+    start();
+}
+
+std::string Http2Connection::settingsPayload() const
+{
+    std::string s;
+    if (_server)
+    {
+        put16(s, SettingsMaxConcurrentStreams);
+        put32(s, maxConcurrentStreams);
+    }
+    else
+    {
+        put16(s, SettingsEnablePush);
+        put32(s, 0);
+    }
+
+    return s;
+}
+
+void Http2Connection::process(const char* data, std::size_t size)
+{
+    if (_failed)
+        return;
+
+    try
+    {
+        if (_input.empty())
+        {
+            std::size_t n = parse(data, size);
+            _input.assign(data + n, size - n);
+        }
+        else
+        {
+            _input.append(data, size);
+            std::size_t n = parse(_input.data(), _input.size());
+            _input.erase(0, n);
+        }
+    }
+    catch (const Http2Error& e)
+    {
+        log_warn("http/2 connection error " << e.code() << ": " << e.what());
+        goAway(e.code(), e.what());
+        _failed = true;
+        _input.clear();
+    }
+}
+
+unsigned Http2Connection::newStreamId()
+{
+    unsigned id = _nextStreamId;
+    _nextStreamId += 2;
+    _streams.insert(Streams::value_type(id, Stream(_peerInitialWindow, defaultWindowSize)));
+    return id;
+}
+
+std::size_t Http2Connection::parse(const char* data, std::size_t size)
+{
+    std::size_t pos = 0;
+
+    if (!_prefaceReceived)
+    {
+        std::size_t n = size < prefaceSize ? size : prefaceSize;
+        if (std::memcmp(data, preface, n) != 0)
+            throw Http2Error(ProtocolError, "invalid connection preface");
+
+        if (n < prefaceSize)
+            return 0;
+
+        log_debug("connection preface received");
+        _prefaceReceived = true;
+        pos = prefaceSize;
+    }
+
+    while (size - pos >= 9)
+    {
+        const unsigned char* h = reinterpret_cast<const unsigned char*>(data + pos);
+        std::size_t length = (static_cast<std::size_t>(h[0]) << 16) | (h[1] << 8) | h[2];
+        unsigned type = h[3];
+        unsigned flags = h[4];
+        unsigned streamId = get32(data + pos + 5) & 0x7fffffff;
+
+        if (length > defaultMaxFrameSize)
+            throw Http2Error(FrameSizeError, "frame exceeds maximum frame size");
+
+        if (size - pos - 9 < length)
+            break;
+
+        processFrame(type, flags, streamId, data + pos + 9, length);
+        pos += 9 + length;
+    }
+
+    return pos;
+}
+
+void Http2Connection::processFrame(unsigned type, unsigned flags, unsigned streamId, const char* payload, std::size_t length)
+{
+    log_debug("frame type " << type << " flags " << flags << " stream " << streamId << " length " << length);
+
+    if (!_settingsReceived && type != Settings)
+        throw Http2Error(ProtocolError, "first frame must be SETTINGS");
+
+    if (_continuationStream != 0 && type != Continuation)
+        throw Http2Error(ProtocolError, "CONTINUATION frame expected");
+
+    switch (type)
+    {
+        case Data:          processData(flags, streamId, payload, length); break;
+        case Headers:       processHeaders(flags, streamId, payload, length); break;
+        case Continuation:  processContinuation(flags, streamId, payload, length); break;
+        case Settings:      processSettings(flags, streamId, payload, length); break;
+        case Ping:          processPing(flags, streamId, payload, length); break;
+        case GoAway:        processGoAway(streamId, payload, length); break;
+        case WindowUpdate:  processWindowUpdate(streamId, payload, length); break;
+        case RstStream:     processRstStream(streamId, payload, length); break;
+
+        case Priority:
+            if (streamId == 0)
+                throw Http2Error(ProtocolError, "PRIORITY on stream 0");
+            if (length != 5)
+                streamError(streamId, FrameSizeError);
+            break;
+
+        case PushPromise:
+            throw Http2Error(ProtocolError, "server push is not enabled");
+
+        default:
+            log_debug("ignore frame of unknown type " << type);
+    }
+}
+
+void Http2Connection::processData(unsigned flags, unsigned streamId, const char* payload, std::size_t length)
+{
+    if (streamId == 0)
+        throw Http2Error(ProtocolError, "DATA on stream 0");
+
+    // the connection window includes the padding
+    if (static_cast<long>(length) > _recvWindow)
+        throw Http2Error(FlowControlError, "connection flow control window exceeded");
+
+    _recvWindow -= length;
+    _unacked += length;
+    if (_unacked >= connectionWindowSize / 2)
+    {
+        writeWindowUpdate(0, _unacked);
+        _recvWindow += _unacked;
+        _unacked = 0;
+    }
+
+    stripPadding(flags, payload, length);
+
+    Streams::iterator it = _streams.find(streamId);
+    if (it == _streams.end())
+    {
+        if (isIdle(streamId))
+            throw Http2Error(ProtocolError, "DATA on idle stream");
+
+        log_debug("ignore DATA on closed stream " << streamId);
+        return;
+    }
+
+    Stream& s = it->second;
+    if (s.remoteClosed)
+    {
+        streamError(streamId, StreamClosed);
+        return;
+    }
+
+    bool endStream = (flags & FlagEndStream) != 0;
+    if (static_cast<long>(length) > s.recvWindow)
+    {
+        streamError(streamId, FlowControlError);
+        return;
+    }
+
+    s.recvWindow -= length;
+    s.unacked += length;
+    if (endStream)
+        s.remoteClosed = true;
+    else if (s.unacked >= defaultWindowSize / 2)
+    {
+        writeWindowUpdate(streamId, s.unacked);
+        s.recvWindow += s.unacked;
+        s.unacked = 0;
+    }
+
+    _handler.onData(streamId, payload, length, endStream);
+
+    if (endStream)
+        release(streamId);
+}
+
+void Http2Connection::processHeaders(unsigned flags, unsigned streamId, const char* payload, std::size_t length)
+{
+    if (streamId == 0)
+        throw Http2Error(ProtocolError, "HEADERS on stream 0");
+
+    stripPadding(flags, payload, length);
+
+    if (flags & FlagPriority)
+    {
+        if (length < 5)
+            throw Http2Error(FrameSizeError, "HEADERS too short for priority");
+        payload += 5;
+        length -= 5;
+    }
+
+    _headerBlock.assign(payload, length);
+    _continuationEndStream = (flags & FlagEndStream) != 0;
+
+    if (flags & FlagEndHeaders)
+        processHeaderBlock(streamId);
+    else
+        _continuationStream = streamId;
+}
+
+void Http2Connection::processContinuation(unsigned flags, unsigned streamId, const char* payload, std::size_t length)
+{
+    if (_continuationStream == 0 || streamId != _continuationStream)
+        throw Http2Error(ProtocolError, "unexpected CONTINUATION frame");
+
+    if (_headerBlock.size() + length > maxHeaderBlockSize)
+        throw Http2Error(EnhanceYourCalm, "header block too large");
+
+    _headerBlock.append(payload, length);
+
+    if (flags & FlagEndHeaders)
+    {
+        _continuationStream = 0;
+        processHeaderBlock(streamId);
+    }
+}
+
+void Http2Connection::processHeaderBlock(unsigned streamId)
+{
+    // the block must be decoded even when the stream is refused to keep the
+    // header table in sync
+    _fields.clear();
+    try
+    {
+        _decoder.decode(_headerBlock.data(), _headerBlock.size(), _fields);
+    }
+    catch (const HpackError& e)
+    {
+        throw Http2Error(CompressionError, e.what());
+    }
+
+    bool endStream = _continuationEndStream;
+
+    Streams::iterator it = _streams.find(streamId);
+    if (it == _streams.end())
+    {
+        if (!isIdle(streamId))
+        {
+            log_debug("ignore HEADERS on closed stream " << streamId);
+            return;
+        }
+
+        if (!_server || !isRemote(streamId))
+            throw Http2Error(ProtocolError, "HEADERS on idle stream");
+
+        _lastRemoteStreamId = streamId;
+
+        if (_goingAway)
+        {
+            log_debug("ignore new stream " << streamId << " after GOAWAY");
+            return;
+        }
+
+        if (_streams.size() >= maxConcurrentStreams)
+        {
+            log_info("refuse stream " << streamId << "; too many concurrent streams");
+            resetStream(streamId, RefusedStream);
+            return;
+        }
+
+        it = _streams.insert(Streams::value_type(streamId, Stream(_peerInitialWindow, defaultWindowSize))).first;
+    }
+    else if (it->second.remoteClosed)
+    {
+        streamError(streamId, StreamClosed);
+        return;
+    }
+
+    if (endStream)
+        it->second.remoteClosed = true;
+
+    _handler.onHeaders(streamId, _fields, endStream);
+
+    if (endStream)
+        release(streamId);
+}
+
+void Http2Connection::processSettings(unsigned flags, unsigned streamId, const char* payload, std::size_t length)
+{
+    if (streamId != 0)
+        throw Http2Error(ProtocolError, "SETTINGS on stream other than 0");
+
+    if (flags & FlagAck)
+    {
+        if (length != 0)
+            throw Http2Error(FrameSizeError, "SETTINGS ACK with payload");
+        log_debug("settings acknowledged");
+        return;
+    }
+
+    if (length % 6 != 0)
+        throw Http2Error(FrameSizeError, "invalid SETTINGS length");
+
+    applySettings(payload, length);
+    _settingsReceived = true;
+
+    writeFrameHeader(0, Settings, FlagAck, 0);
+
+    // the window of the streams may have grown
+    flush();
+}
+
+void Http2Connection::applySettings(const char* payload, std::size_t length)
+{
+    if (length % 6 != 0)
+        throw Http2Error(ProtocolError, "invalid settings");
+
+    for (std::size_t n = 0; n < length; n += 6)
+    {
+        unsigned id = get16(payload + n);
+        unsigned value = get32(payload + n + 2);
+
+        log_debug("setting " << id << '=' << value);
+
+        switch (id)
+        {
+            case SettingsHeaderTableSize:
+                _encoder.maxTableSize(value);
+                break;
+
+            case SettingsEnablePush:
+                if (value > 1)
+                    throw Http2Error(ProtocolError, "invalid value for SETTINGS_ENABLE_PUSH");
+                break;
+
+            case SettingsMaxConcurrentStreams:
+                _peerMaxStreams = value;
+                break;
+
+            case SettingsInitialWindowSize:
+            {
+                if (value > static_cast<unsigned>(maxWindowSize))
+                    throw Http2Error(FlowControlError, "invalid initial window size");
+
+                long delta = static_cast<long>(value) - _peerInitialWindow;
+                for (Streams::iterator it = _streams.begin(); it != _streams.end(); ++it)
+                {
+                    it->second.sendWindow += delta;
+                    if (it->second.sendWindow > maxWindowSize)
+                        throw Http2Error(FlowControlError, "stream window exceeds maximum");
+                }
+
+                _peerInitialWindow = value;
+                break;
+            }
+
+            case SettingsMaxFrameSize:
+                if (value < defaultMaxFrameSize || value > 16777215)
+                    throw Http2Error(ProtocolError, "invalid maximum frame size");
+                _peerMaxFrameSize = value;
+                break;
+
+            default:
+                // SETTINGS_MAX_HEADER_LIST_SIZE is advisory and unknown settings are ignored
+                break;
+        }
+    }
+}
+
+void Http2Connection::processPing(unsigned flags, unsigned streamId, const char* payload, std::size_t length)
+{
+    if (streamId != 0)
+        throw Http2Error(ProtocolError, "PING on stream other than 0");
+
+    if (length != 8)
+        throw Http2Error(FrameSizeError, "invalid PING length");
+
+    if ((flags & FlagAck) == 0)
+    {
+        writeFrameHeader(8, Ping, FlagAck, 0);
+        _out.write(payload, 8);
+    }
+}
+
+void Http2Connection::processGoAway(unsigned streamId, const char* payload, std::size_t length)
+{
+    if (streamId != 0)
+        throw Http2Error(ProtocolError, "GOAWAY on stream other than 0");
+
+    if (length < 8)
+        throw Http2Error(FrameSizeError, "GOAWAY too short");
+
+    unsigned lastStreamId = get32(payload) & 0x7fffffff;
+    unsigned code = get32(payload + 4);
+
+    log_info("GOAWAY received; last stream " << lastStreamId << " error code " << code
+        << ' ' << std::string(payload + 8, length - 8));
+
+    _goingAway = true;
+
+    // streams, which were not processed by the peer, may be retried by the application
+    std::vector<unsigned> refused;
+    for (Streams::iterator it = _streams.begin(); it != _streams.end(); ++it)
+        if (!isRemote(it->first) && it->first > lastStreamId)
+            refused.push_back(it->first);
+
+    for (std::vector<unsigned>::const_iterator it = refused.begin(); it != refused.end(); ++it)
+    {
+        _streams.erase(*it);
+        _handler.onReset(*it, RefusedStream);
+    }
+}
+
+void Http2Connection::processWindowUpdate(unsigned streamId, const char* payload, std::size_t length)
+{
+    if (length != 4)
+        throw Http2Error(FrameSizeError, "invalid WINDOW_UPDATE length");
+
+    long increment = get32(payload) & 0x7fffffff;
+
+    if (streamId == 0)
+    {
+        if (increment == 0)
+            throw Http2Error(ProtocolError, "WINDOW_UPDATE with increment 0");
+
+        if (_sendWindow + increment > maxWindowSize)
+            throw Http2Error(FlowControlError, "connection window exceeds maximum");
+
+        _sendWindow += increment;
+        flush();
+        return;
+    }
+
+    Streams::iterator it = _streams.find(streamId);
+    if (it == _streams.end())
+    {
+        if (isIdle(streamId))
+            throw Http2Error(ProtocolError, "WINDOW_UPDATE on idle stream");
+        return;
+    }
+
+    if (increment == 0)
+    {
+        streamError(streamId, ProtocolError);
+        return;
+    }
+
+    if (it->second.sendWindow + increment > maxWindowSize)
+    {
+        streamError(streamId, FlowControlError);
+        return;
+    }
+
+    it->second.sendWindow += increment;
+    flush(it);
+}
+
+void Http2Connection::processRstStream(unsigned streamId, const char* payload, std::size_t length)
+{
+    if (streamId == 0)
+        throw Http2Error(ProtocolError, "RST_STREAM on stream 0");
+
+    if (length != 4)
+        throw Http2Error(FrameSizeError, "invalid RST_STREAM length");
+
+    if (isIdle(streamId))
+        throw Http2Error(ProtocolError, "RST_STREAM on idle stream");
+
+    Streams::iterator it = _streams.find(streamId);
+    if (it == _streams.end())
+        return;
+
+    unsigned code = get32(payload);
+    log_debug("stream " << streamId << " reset by peer; error code " << code);
+
+    _streams.erase(it);
+    _handler.onReset(streamId, code);
+}
+
+void Http2Connection::sendHeaders(unsigned streamId, const Fields& fields, bool endStream)
+{
+    Streams::iterator it = _streams.find(streamId);
+    if (it == _streams.end())
+    {
+        log_debug("stream " << streamId << " is closed; headers not sent");
+        return;
+    }
+
+    std::string block;
+    _encoder.beginBlock(block);
+    for (Fields::const_iterator f = fields.begin(); f != fields.end(); ++f)
+        _encoder.encode(block, f->first, f->second, indexHeader(f->first));
+
+    // the block is split into a HEADERS and CONTINUATION frames
+    std::size_t pos = 0;
+    unsigned type = Headers;
+    do
+    {
+        std::size_t n = block.size() - pos;
+        if (n > _peerMaxFrameSize)
+            n = _peerMaxFrameSize;
+
+        unsigned flags = 0;
+        if (pos + n == block.size())
+            flags |= FlagEndHeaders;
+        if (type == Headers && endStream)
+            flags |= FlagEndStream;
+
+        writeFrameHeader(n, type, flags, streamId);
+        _out.write(block.data() + pos, n);
+
+        pos += n;
+        type = Continuation;
+    } while (pos < block.size());
+
+    if (endStream)
+        closeLocal(it);
+}
+
+void Http2Connection::sendData(unsigned streamId, const char* data, std::size_t size, bool endStream)
+{
+    Streams::iterator it = _streams.find(streamId);
+    if (it == _streams.end())
+    {
+        log_debug("stream " << streamId << " is closed; data not sent");
+        return;
+    }
+
+    Stream& s = it->second;
+    if (s.offset < s.pending.size())
+    {
+        s.pending.append(data, size);
+        s.endPending = endStream;
+        flush(it);
+        return;
+    }
+
+    // nothing queued, so we send directly as far as the window allows
+    std::size_t n = writeData(streamId, s, data, size, endStream);
+    if (n == size)
+    {
+        if (endStream)
+            closeLocal(it);
+        return;
+    }
+
+    s.pending.assign(data + n, size - n);
+    s.offset = 0;
+    s.endPending = endStream;
+}
+
+void Http2Connection::resetStream(unsigned streamId, unsigned errorCode)
+{
+    log_debug("reset stream " << streamId << " error code " << errorCode);
+
+    writeFrameHeader(4, RstStream, 0, streamId);
+    put32(_out, errorCode);
+
+    _streams.erase(streamId);
+}
+
+void Http2Connection::goAway(unsigned errorCode, const std::string& msg)
+{
+    if (_goAwaySent)
+        return;
+
+    writeFrameHeader(8 + msg.size(), GoAway, 0, 0);
+    put32(_out, _lastRemoteStreamId);
+    put32(_out, errorCode);
+    _out << msg;
+
+    _goAwaySent = true;
+    _goingAway = true;
+}
+
+bool Http2Connection::hasPending(unsigned streamId) const
+{
+    Streams::const_iterator it = _streams.find(streamId);
+    return it != _streams.end() && it->second.offset < it->second.pending.size();
+}
+
+void Http2Connection::streamError(unsigned streamId, unsigned errorCode)
+{
+    bool known = _streams.find(streamId) != _streams.end();
+
+    resetStream(streamId, errorCode);
+
+    if (known)
+        _handler.onReset(streamId, errorCode);
+}
+
+bool Http2Connection::isIdle(unsigned streamId) const
+{
+    return isRemote(streamId) ? streamId > _lastRemoteStreamId
+                              : streamId >= _nextStreamId;
+}
+
+void Http2Connection::release(unsigned streamId)
+{
+    Streams::iterator it = _streams.find(streamId);
+    if (it != _streams.end() && it->second.remoteClosed && it->second.localClosed)
+        _streams.erase(it);
+}
+
+void Http2Connection::closeLocal(Streams::iterator it)
+{
+    it->second.localClosed = true;
+    if (it->second.remoteClosed)
+        _streams.erase(it);
+}
+
+void Http2Connection::flush()
+{
+    for (Streams::iterator it = _streams.begin(); it != _streams.end() && _sendWindow > 0; )
+    {
+        Streams::iterator cur = it++;
+        flush(cur);
+    }
+}
+
+void Http2Connection::flush(Streams::iterator it)
+{
+    Stream& s = it->second;
+    if (s.offset >= s.pending.size())
+        return;
+
+    s.offset += writeData(it->first, s, s.pending.data() + s.offset, s.pending.size() - s.offset, s.endPending);
+
+    if (s.offset >= s.pending.size())
+    {
+        s.pending.clear();
+        s.offset = 0;
+        if (s.endPending)
+            closeLocal(it);
+    }
+}
+
+std::size_t Http2Connection::writeData(unsigned streamId, Stream& s, const char* data, std::size_t size, bool endStream)
+{
+    std::size_t written = 0;
+    while (true)
+    {
+        long window = _sendWindow < s.sendWindow ? _sendWindow : s.sendWindow;
+        std::size_t n = size - written;
+        if (window <= 0)
+            n = 0;
+        else if (n > static_cast<std::size_t>(window))
+            n = window;
+        if (n > _peerMaxFrameSize)
+            n = _peerMaxFrameSize;
+
+        bool last = endStream && written + n == size;
+        if (n == 0 && !last)
+            break;
+
+        writeFrameHeader(n, Data, last ? FlagEndStream : 0, streamId);
+        _out.write(data + written, n);
+
+        written += n;
+        _sendWindow -= n;
+        s.sendWindow -= n;
+
+        if (written == size)
+            break;
+    }
+
+    return written;
+}
+
+void Http2Connection::writeFrameHeader(std::size_t length, unsigned type, unsigned flags, unsigned streamId)
+{
+    char h[9] = {
+        static_cast<char>(length >> 16),
+        static_cast<char>(length >> 8),
+        static_cast<char>(length),
+        static_cast<char>(type),
+        static_cast<char>(flags),
+        static_cast<char>(streamId >> 24),
+        static_cast<char>(streamId >> 16),
+        static_cast<char>(streamId >> 8),
+        static_cast<char>(streamId) };
+    _out.write(h, 9);
+}
+
+void Http2Connection::writeWindowUpdate(unsigned streamId, unsigned increment)
+{
+    writeFrameHeader(4, WindowUpdate, 0, streamId);
+    put32(_out, increment);
+}
+
+}
+}
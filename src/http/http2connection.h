@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_HTTP_HTTP2CONNECTION_H
+#define CXXTOOLS_HTTP_HTTP2CONNECTION_H
+
+#include "hpack.h"
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <stdexcept>
+
+namespace cxxtools
+{
+namespace http
+{
+
+/// A http/2 connection or stream error with its error code.
+class Http2Error : public std::runtime_error
+{
+        unsigned _code;
+
+    public:
+        Http2Error(unsigned code, const std::string& msg)
+            : std::runtime_error(msg),
+              _code(code)
+            { }
+
+        unsigned code() const  { return _code; }
+};
+
+/**
+ Protocol engine of a http/2 connection (RFC 7540) without tls.
+
+ The class does no I/O itself. Received data is passed to process(), which
+ parses the frames and reports headers and data of the streams to the
+ Handler. Frames are written to the output stream passed to the constructor.
+ It handles the connection preface, settings, ping, flow control and the
+ stream states; the semantics of the messages are left to the handler.
+ */
+class Http2Connection
+{
+    public:
+        enum FrameType
+        {
+            Data = 0,
+            Headers = 1,
+            Priority = 2,
+            RstStream = 3,
+            Settings = 4,
+            PushPromise = 5,
+            Ping = 6,
+            GoAway = 7,
+            WindowUpdate = 8,
+            Continuation = 9
+        };
+
+        enum Flag
+        {
+            FlagEndStream = 0x1,
+            FlagAck = 0x1,
+            FlagEndHeaders = 0x4,
+            FlagPadded = 0x8,
+            FlagPriority = 0x20
+        };
+
+        enum Setting
+        {
+            SettingsHeaderTableSize = 1,
+            SettingsEnablePush = 2,
+            SettingsMaxConcurrentStreams = 3,
+            SettingsInitialWindowSize = 4,
+            SettingsMaxFrameSize = 5,
+            SettingsMaxHeaderListSize = 6
+        };
+
+        enum ErrorCode
+        {
+            NoError = 0x0,
+            ProtocolError = 0x1,
+            InternalError = 0x2,
+            FlowControlError = 0x3,
+            SettingsTimeout = 0x4,
+            StreamClosed = 0x5,
+            FrameSizeError = 0x6,
+            RefusedStream = 0x7,
+            Cancel = 0x8,
+            CompressionError = 0x9,
+            ConnectError = 0xa,
+            EnhanceYourCalm = 0xb,
+            InadequateSecurity = 0xc,
+            Http11Required = 0xd
+        };
+
+        typedef HpackDecoder::Fields Fields;
+
+        class Handler
+        {
+            public:
+                virtual ~Handler() { }
+
+                /// A header block was received. Trailers are passed here as well.
+                virtual void onHeaders(unsigned streamId, Fields& fields, bool endStream) = 0;
+
+                /// Data was received; the last call of a stream has endStream set.
+                virtual void onData(unsigned streamId, const char* data, std::size_t size, bool endStream) = 0;
+
+                /// The stream was reset by the peer or refused by a GOAWAY.
+                virtual void onReset(unsigned streamId, unsigned errorCode) = 0;
+        };
+
+        /// The client connection preface.
+        static const char preface[];
+        static const std::size_t prefaceSize = 24;
+
+        static const unsigned defaultWindowSize = 65535;
+        static const unsigned defaultMaxFrameSize = 16384;
+        static const unsigned maxConcurrentStreams = 100;
+
+        Http2Connection(Handler& handler, std::ostream& out, bool server);
+
+        /// Sends the preface of the client or the settings of the server.
+        void start();
+
+        /// Starts the connection after a HTTP/1.1 upgrade. The server passes
+        /// the decoded HTTP2-Settings header of the request.
+        /// Stream 1 is created for the request, which was sent in HTTP/1.1.
+        void upgrade(const std::string& settings = std::string());
+
+        /// Returns the payload of our settings frame for the HTTP2-Settings header.
+        std::string settingsPayload() const;
+
+        /// Processes received data; incomplete frames are kept until the rest arrives.
+        void process(const char* data, std::size_t size);
+
+        /// Returns the id for a new stream initiated by us.
+        unsigned newStreamId();
+
+        /// Sends a header block; the pseudo headers must come first.
+        void sendHeaders(unsigned streamId, const Fields& fields, bool endStream);
+
+        /// Sends data as far as the flow control windows allow. The rest is
+        /// sent when the peer opens the window.
+        void sendData(unsigned streamId, const char* data, std::size_t size, bool endStream);
+
+        void resetStream(unsigned streamId, unsigned errorCode);
+
+        void goAway(unsigned errorCode, const std::string& msg = std::string());
+
+        /// Returns true when a GOAWAY was sent or received.
+        bool goingAway() const          { return _goingAway; }
+
+        /// Returns true after a connection error.
+        bool failed() const             { return _failed; }
+
+        /// Returns the number of streams which are not closed.
+        unsigned openStreams() const    { return _streams.size(); }
+
+        /// Returns true when the stream has data to send, which is blocked by flow control.
+        bool hasPending(unsigned streamId) const;
+
+        /// Returns the maximum number of concurrent streams the peer accepts.
+        unsigned peerMaxConcurrentStreams() const  { return _peerMaxStreams; }
+
+    private:
+        struct Stream
+        {
+            Stream(long sendWindow, long recvWindow)
+                : remoteClosed(false),
+                  localClosed(false),
+                  sendWindow(sendWindow),
+                  recvWindow(recvWindow),
+                  unacked(0),
+                  offset(0),
+                  endPending(false)
+                { }
+
+            bool remoteClosed;
+            bool localClosed;
+            long sendWindow;
+            long recvWindow;
+            unsigned unacked;       // received bytes not yet acknowledged by WINDOW_UPDATE
+            std::string pending;    // data waiting for the flow control window
+            std::size_t offset;
+            bool endPending;
+        };
+
+        typedef std::map<unsigned, Stream> Streams;
+
+        std::size_t parse(const char* data, std::size_t size);
+        void processFrame(unsigned type, unsigned flags, unsigned streamId, const char* payload, std::size_t length);
+        void processData(unsigned flags, unsigned streamId, const char* payload, std::size_t length);
+        void processHeaders(unsigned flags, unsigned streamId, const char* payload, std::size_t length);
+        void processContinuation(unsigned flags, unsigned streamId, const char* payload, std::size_t length);
+        void processHeaderBlock(unsigned streamId);
+        void processSettings(unsigned flags, unsigned streamId, const char* payload, std::size_t length);
+        void processPing(unsigned flags, unsigned streamId, const char* payload, std::size_t length);
+        void processGoAway(unsigned streamId, const char* payload, std::size_t length);
+        void processWindowUpdate(unsigned streamId, const char* payload, std::size_t length);
+        void processRstStream(unsigned streamId, const char* payload, std::size_t length);
+
+        void applySettings(const char* payload, std::size_t length);
+        void streamError(unsigned streamId, unsigned errorCode);
+        bool isIdle(unsigned streamId) const;
+        bool isRemote(unsigned streamId) const  { return (streamId & 1) == (_server ? 1u : 0u); }
+        void release(unsigned streamId);
+        void closeLocal(Streams::iterator it);
+        void flush();
+        void flush(Streams::iterator it);
+        std::size_t writeData(unsigned streamId, Stream& s, const char* data, std::size_t size, bool endStream);
+
+        void writeFrameHeader(std::size_t length, unsigned type, unsigned flags, unsigned streamId);
+        void writeWindowUpdate(unsigned streamId, unsigned increment);
+
+        Handler& _handler;
+        std::ostream& _out;
+        bool _server;
+
+        HpackDecoder _decoder;
+        HpackEncoder _encoder;
+        Streams _streams;
+
+        std::string _input;             // incomplete frame
+        bool _prefaceReceived;
+        bool _settingsReceived;
+        bool _goingAway;
+        bool _failed;
+        bool _goAwaySent;
+
+        unsigned _lastRemoteStreamId;
+        unsigned _nextStreamId;
+
+        // header block spanning CONTINUATION frames
+        unsigned _continuationStream;
+        bool _continuationEndStream;
+        std::string _headerBlock;
+        Fields _fields;
+
+        // peer settings
+        unsigned _peerMaxStreams;
+        long _peerInitialWindow;
+        unsigned _peerMaxFrameSize;
+
+        long _sendWindow;
+        long _recvWindow;
+        unsigned _unacked;
+};
+
+}
+}
+
+#endif // CXXTOOLS_HTTP_HTTP2CONNECTION_H
@@ -0,0 +1,545 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "http2session.h"
+#include "serverimpl.h"
+#include "socket.h"
+#include <cxxtools/http/responder.h>
+#include <cxxtools/http/routemetrics.h>
+#include <cxxtools/clock.h>
+#include <cxxtools/convert.h>
+#include <cxxtools/log.h>
+#include <cctype>
+#include <istream>
+#include "config.h"
+
+log_define("cxxtools.http.http2session")
+
+namespace cxxtools
+{
+namespace http
+{
+
+namespace
+{
+    int hexValue(char ch)
+    {
+        return ch >= '0' && ch <= '9' ? ch - '0'
+             : ch >= 'a' && ch <= 'f' ? ch - 'a' + 10
+             : ch >= 'A' && ch <= 'F' ? ch - 'A' + 10
+             : -1;
+    }
+
+    // Sets url and query parameters from the :path pseudo header. The url
+    // is decoded and passed without leading slash like the http/1 parser does.
+    bool setPath(RequestHeader& header, const std::string& path)
+    {
+        std::string::size_type q = path.find('?');
+        std::string::size_type b = path.size() > 0 && path[0] == '/' ? 1 : 0;
+        std::string::size_type e = q == std::string::npos ? path.size() : q;
+
+        std::string url;
+        url.reserve(e - b);
+        for (std::string::size_type n = b; n < e; ++n)
+        {
+            char ch = path[n];
+            if (ch == '+')
+                url += ' ';
+            else if (ch == '%')
+            {
+                int h = n + 2 < e ? hexValue(path[n + 1]) : -1;
+                int l = n + 2 < e ? hexValue(path[n + 2]) : -1;
+                if (h < 0 || l < 0 || (h == 0 && l == 0))
+                    return false;
+                url += static_cast<char>((h << 4) | l);
+                n += 2;
+            }
+            else
+                url += ch;
+        }
+
+        header.url(url);
+        if (q != std::string::npos)
+            header.qparams(path.substr(q + 1));
+
+        return true;
+    }
+
+    // header fields, which are specific to a http/1 connection
+    bool connectionSpecific(const std::string& name)
+    {
+        return name == "connection"
+            || name == "keep-alive"
+            || name == "proxy-connection"
+            || name == "transfer-encoding"
+            || name == "upgrade";
+    }
+}
+
+Http2Session::Http2Session(ServerImpl& server, Socket& socket)
+    : DetachedConnection(server, socket),
+      _outputBuffer(_output),
+      _out(&_outputBuffer),
+      _connection(*this, _out, true),
+      _jobs(0),
+      _closing(false)
+{
+    cxxtools::connect(_timer.timeout, *this, &Http2Session::onTimeout);
+}
+
+Http2Session::~Http2Session()
+{
+    // jobs, which were not run, when the server terminated
+    for (Calls::iterator it = _calls.begin(); it != _calls.end(); ++it)
+        delete it->second;
+}
+
+void Http2Session::open()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _connection.start();
+}
+
+void Http2Session::upgrade(const std::string& settings, const Request& request)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    try
+    {
+        _connection.upgrade(settings);
+    }
+    catch (const Http2Error& e)
+    {
+        log_warn("upgrade to http/2 failed: " << e.what());
+        _connection.goAway(e.code(), e.what());
+        return;
+    }
+
+    Call* call = new Call();
+    _calls[1] = call;
+    call->request.header() = request.header();
+    call->request.header().removeHeader("Upgrade");
+    call->request.header().removeHeader("HTTP2-Settings");
+    call->request.header().removeHeader("Connection");
+    dispatch(1, call);
+}
+
+void Http2Session::onStart(StreamBuffer& sb)
+{
+    _socket.selector()->add(_timer);
+
+    // frames received together with the preface or the upgraded request
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (sb.in_avail() > 0)
+    {
+        std::size_t n = sb.in_avail();
+        _connection.process(sb.inputBegin(), n);
+        sb.inputConsume(n);
+    }
+
+    if (!_connection.failed())
+        sb.beginRead();
+}
+
+void Http2Session::onInput(StreamBuffer& sb)
+{
+    bool eof;
+    try
+    {
+        sb.endRead();
+        eof = sb.in_avail() == 0 || sb.device()->eof();
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("failed to read from http/2 client " << peerAddr() << ": " << e.what());
+        release(true);
+        return;
+    }
+
+    // the event loop has not taken over the connection yet
+    if (!started())
+        return;
+
+    bool failed;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::size_t n = sb.in_avail();
+        if (n > 0)
+        {
+            _connection.process(sb.inputBegin(), n);
+            sb.inputConsume(n);
+        }
+        failed = _connection.failed();
+    }
+
+    if (eof)
+    {
+        log_debug("http/2 client " << peerAddr() << " closed connection");
+        release(true);
+        return;
+    }
+
+    flush();
+
+    if (!released() && !failed)
+        sb.beginRead();
+}
+
+void Http2Session::flush()
+{
+    bool closing;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        closing = _closing;
+    }
+
+    if (!closing)
+        DetachedConnection::flush();
+
+    if (released())
+        return;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_closing)
+    {
+        if (_jobs > 0)
+            return;
+
+        lock.unlock();
+        DetachedConnection::release(true);
+        return;
+    }
+
+    _timer.start(_connection.openStreams() == 0 ? _server.keepAliveTimeout()
+                                                : _server.readTimeout());
+}
+
+void Http2Session::shutdown()
+{
+    if (released())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _connection.goAway(Http2Connection::NoError);
+    }
+
+    // the workers are stopped; jobs, which did not run, are dropped
+    DetachedConnection::flush();
+    DetachedConnection::release(true);
+}
+
+void Http2Session::onEnd()
+{
+    log_debug("http/2 connection to client " << peerAddr() << " finished");
+    release(true);
+}
+
+void Http2Session::onRelease()
+{
+    _timer.stop();
+}
+
+void Http2Session::release(bool closeSocket)
+{
+    {
+        // the socket must not be deleted while workers answer streams; the
+        // output of the last job wakes the event loop, which releases it
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_jobs > 0)
+        {
+            _closing = true;
+            return;
+        }
+    }
+
+    DetachedConnection::release(closeSocket);
+}
+
+void Http2Session::onTimeout()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_jobs > 0)
+            return;
+
+        log_debug("timeout on http/2 connection to client " << peerAddr());
+        _connection.goAway(Http2Connection::NoError);
+    }
+
+    DetachedConnection::flush();
+    release(true);
+}
+
+void Http2Session::onHeaders(unsigned streamId, Http2Connection::Fields& fields, bool endStream)
+{
+    Calls::iterator it = _calls.find(streamId);
+    if (it != _calls.end())
+    {
+        // trailers are not passed to the responder
+        if (!endStream)
+        {
+            _connection.resetStream(streamId, Http2Connection::ProtocolError);
+            releaseCall(streamId);
+        }
+        else
+            dispatch(streamId, it->second);
+
+        return;
+    }
+
+    Call* call = new Call();
+    _calls[streamId] = call;
+
+    if (!setRequest(call->request, fields))
+    {
+        log_warn("malformed request on stream " << streamId << " from client " << peerAddr());
+        _connection.resetStream(streamId, Http2Connection::ProtocolError);
+        releaseCall(streamId);
+        return;
+    }
+
+    if (endStream)
+        dispatch(streamId, call);
+}
+
+void Http2Session::onData(unsigned streamId, const char* data, std::size_t size, bool endStream)
+{
+    Calls::iterator it = _calls.find(streamId);
+    if (it == _calls.end())
+        return;
+
+    Call* call = it->second;
+    call->body.append(data, size);
+
+    if (endStream)
+        dispatch(streamId, call);
+}
+
+void Http2Session::onReset(unsigned streamId, unsigned errorCode)
+{
+    log_debug("stream " << streamId << " reset; error code " << errorCode);
+
+    // the reply of a running job is discarded by the connection
+    Calls::iterator it = _calls.find(streamId);
+    if (it != _calls.end() && !it->second->dispatched)
+        releaseCall(streamId);
+}
+
+bool Http2Session::setRequest(Request& request, const Http2Connection::Fields& fields)
+{
+    RequestHeader& header = request.header();
+    header.httpVersion(2, 0);
+
+    std::string path;
+    std::string cookie;
+    bool regular = false;
+
+    for (Http2Connection::Fields::const_iterator it = fields.begin(); it != fields.end(); ++it)
+    {
+        const std::string& name = it->first;
+        const std::string& value = it->second;
+
+        if (!name.empty() && name[0] == ':')
+        {
+            // pseudo headers must precede the regular fields
+            if (regular)
+                return false;
+
+            if (name == ":method")
+                header.method(value);
+            else if (name == ":path")
+                path = value;
+            else if (name == ":authority")
+                header.setHeader("Host", value.c_str());
+            else if (name != ":scheme")
+                return false;
+        }
+        else
+        {
+            regular = true;
+
+            for (std::string::const_iterator c = name.begin(); c != name.end(); ++c)
+                if (std::isupper(static_cast<unsigned char>(*c)))
+                    return false;
+
+            if (connectionSpecific(name) || (name == "te" && value != "trailers"))
+                return false;
+
+            // cookies may be split into multiple fields
+            if (name == "cookie")
+            {
+                if (!cookie.empty())
+                    cookie += "; ";
+                cookie += value;
+            }
+            else
+                header.addHeader(name.data(), name.size(), value.data(), value.size());
+        }
+    }
+
+    if (header.method().empty() || path.empty())
+        return false;
+
+    if (!cookie.empty())
+        header.setHeader("Cookie", cookie.c_str());
+
+    return setPath(header, path);
+}
+
+// Passes a complete request to a worker thread. Called with the mutex locked.
+void Http2Session::dispatch(unsigned streamId, Call* call)
+{
+    log_info("request " << call->request.method() << ' ' << call->request.header().query()
+        << " on stream " << streamId << " from client " << peerAddr());
+
+    call->dispatched = true;
+    if (_server.queueJob([this, streamId, call] () { processCall(streamId, call); }, 1) == 0)
+    {
+        // the server is terminating
+        _connection.resetStream(streamId, Http2Connection::RefusedStream);
+        releaseCall(streamId);
+        return;
+    }
+
+    ++_jobs;
+}
+
+// Runs the responder in a worker thread and sends the reply.
+void Http2Session::processCall(unsigned streamId, Call* call)
+{
+    RouteMetrics* metrics;
+    Responder* responder = _server.getResponder(call->request, metrics);
+    metrics->requestStarted();
+    Timespan start = Clock::getSystemTicks();
+
+    try
+    {
+        BodyBuffer bodyBuffer;
+        std::istream bodyStream(&bodyBuffer);
+        responder->beginRequest(_socket, bodyStream, call->request);
+
+        bodyBuffer.set(call->body.data(), call->body.size());
+        while (bodyBuffer.in_avail() > 0)
+        {
+            if (responder->readBody(bodyStream) == 0)
+                break;
+        }
+
+        responder->reply(call->reply.bodyStream(), call->request, call->reply);
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("responder reported error: " << e.what());
+        call->reply.clear();
+        responder->replyError(call->reply.bodyStream(), call->request, call->reply, e);
+    }
+
+    responder->release();
+
+    const Reply& reply = call->reply;
+    metrics->requestFinished(reply.httpReturnCode(), Clock::getSystemTicks() - start);
+
+    log_info("request " << call->request.method() << ' ' << call->request.header().query()
+        << " on stream " << streamId << " ready, returncode " << reply.httpReturnCode()
+        << ' ' << reply.httpReturnText());
+
+    Http2Connection::Fields fields;
+    replyFields(call, fields);
+
+    // the connection may be released by the event loop as soon as the
+    // last job is done
+    ServerImpl& server = _server;
+    Socket& socket = _socket;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (reply.bodySize() == 0 || call->request.method() == "HEAD")
+        {
+            _connection.sendHeaders(streamId, fields, true);
+        }
+        else
+        {
+            _connection.sendHeaders(streamId, fields, false);
+            _connection.sendData(streamId, reply.bodyData(), reply.bodySize(), true);
+        }
+
+        _calls.erase(streamId);
+        --_jobs;
+    }
+
+    delete call;
+
+    server.detachedOutput(&socket);
+}
+
+void Http2Session::replyFields(const Call* call, Http2Connection::Fields& fields)
+{
+    const Reply& reply = call->reply;
+
+    fields.push_back(HpackTable::Field(":status", convert<std::string>(reply.httpReturnCode())));
+
+    for (ReplyHeader::const_iterator it = reply.header().begin(); it != reply.header().end(); ++it)
+    {
+        std::string name = it->first;
+        for (std::string::iterator c = name.begin(); c != name.end(); ++c)
+            *c = std::tolower(static_cast<unsigned char>(*c));
+
+        if (!connectionSpecific(name))
+            fields.push_back(HpackTable::Field(name, it->second));
+    }
+
+    if (!reply.header().hasHeader(MessageHeader::ContentLength))
+        fields.push_back(HpackTable::Field("content-length", convert<std::string>(reply.bodySize())));
+
+    if (!reply.header().hasHeader(MessageHeader::Server))
+        fields.push_back(HpackTable::Field("server", "cxxtools-Http-Server " PACKAGE_VERSION));
+
+    if (!reply.header().hasHeader(MessageHeader::Date))
+    {
+        char buffer[50];
+        fields.push_back(HpackTable::Field("date", MessageHeader::htdateCurrent(buffer)));
+    }
+}
+
+void Http2Session::releaseCall(unsigned streamId)
+{
+    Calls::iterator it = _calls.find(streamId);
+    if (it == _calls.end())
+        return;
+
+    delete it->second;
+    _calls.erase(it);
+}
+
+}
+}
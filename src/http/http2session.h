@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_HTTP_HTTP2SESSION_H
+#define CXXTOOLS_HTTP_HTTP2SESSION_H
+
+#include "http2connection.h"
+#include "detachedconnection.h"
+#include <cxxtools/http/request.h>
+#include <cxxtools/http/reply.h>
+#include <cxxtools/timer.h>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <map>
+
+namespace cxxtools
+{
+namespace http
+{
+
+/**
+ Server side of a http/2 connection.
+
+ The connection is detached from the worker, which detected the preface or
+ upgrade, and runs in the event loop of the server. Each stream is passed
+ as a job to a worker thread, when its request is complete. The worker
+ runs the responder of the matching service and sends the reply on the
+ same stream, so the streams of a connection are answered concurrently.
+ */
+class Http2Session : public DetachedConnection, private Http2Connection::Handler
+{
+        // streambuf for passing the request body to Responder::readBody
+        class BodyBuffer : public std::streambuf
+        {
+            public:
+                void set(const char* data, std::size_t size)
+                {
+                    char* p = const_cast<char*>(data);
+                    setg(p, p, p + size);
+                }
+        };
+
+        // appends the frames of the connection to the queued output
+        class OutputBuffer : public std::streambuf
+        {
+                std::string& _output;
+
+            public:
+                explicit OutputBuffer(std::string& output)
+                    : _output(output)
+                    { }
+
+            protected:
+                std::streamsize xsputn(const char* s, std::streamsize n)
+                {
+                    _output.append(s, n);
+                    return n;
+                }
+
+                int_type overflow(int_type ch)
+                {
+                    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+                        _output += traits_type::to_char_type(ch);
+                    return traits_type::not_eof(ch);
+                }
+        };
+
+        struct Call
+        {
+            Call()
+                : dispatched(false)
+                { }
+
+            Request request;
+            Reply reply;
+            std::string body;
+            bool dispatched;    // passed to a worker thread
+        };
+
+        typedef std::map<unsigned, Call*> Calls;
+
+    public:
+        Http2Session(ServerImpl& server, Socket& socket);
+        ~Http2Session();
+
+        /// Sends the server settings after the client preface was detected.
+        void open();
+
+        /// Starts the connection after the HTTP/1.1 request was upgraded and
+        /// answers the request on stream 1.
+        void upgrade(const std::string& settings, const Request& request);
+
+        // called in the thread of the event loop
+        void onInput(StreamBuffer& sb) override;
+        void flush() override;
+        void shutdown() override;
+
+    protected:
+        void onStart(StreamBuffer& sb) override;
+        bool ending() const override
+            { return _connection.failed() || (_connection.goingAway() && _connection.openStreams() == 0); }
+        void onEnd() override;
+        void onRelease() override;
+        void release(bool closeSocket) override;
+
+    private:
+        void onHeaders(unsigned streamId, Http2Connection::Fields& fields, bool endStream);
+        void onData(unsigned streamId, const char* data, std::size_t size, bool endStream);
+        void onReset(unsigned streamId, unsigned errorCode);
+
+        bool setRequest(Request& request, const Http2Connection::Fields& fields);
+        void dispatch(unsigned streamId, Call* call);
+        void processCall(unsigned streamId, Call* call);
+        void replyFields(const Call* call, Http2Connection::Fields& fields);
+        void releaseCall(unsigned streamId);
+        void onTimeout();
+
+        OutputBuffer _outputBuffer;
+        std::ostream _out;
+
+        // guarded by the mutex of the base class
+        Http2Connection _connection;
+        Calls _calls;
+        unsigned _jobs;         // streams answered by worker threads
+        bool _closing;          // released, when the last job is done
+
+        Timer _timer;
+};
+
+}
+}
+
+#endif // CXXTOOLS_HTTP_HTTP2SESSION_H
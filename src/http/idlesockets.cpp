@@ -0,0 +1,429 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "idlesockets.h"
+#include "serverimpl.h"
+#include "socket.h"
+
+#include <cxxtools/clock.h>
+#include <cxxtools/systemerror.h>
+#include <cxxtools/log.h>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+log_define("cxxtools.http.idlesockets")
+
+namespace cxxtools
+{
+namespace http
+{
+namespace
+{
+    // number of events taken from one call of epoll_wait
+    const unsigned maxEvents = 256;
+
+#ifndef HAVE_PIPE2
+    void setFlags(int fd)
+    {
+        if (::fcntl(fd, F_SETFD, ::fcntl(fd, F_GETFD) | FD_CLOEXEC) < 0
+         || ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK) < 0)
+            throwSystemError("fcntl");
+    }
+#endif
+}
+
+IdleSockets::IdleSockets(ServerImpl& server)
+    : _server(server),
+      _stop(false)
+{
+#ifdef HAVE_PIPE2
+    if (::pipe2(_wakePipe, O_CLOEXEC|O_NONBLOCK))
+        throwSystemError("pipe2");
+#else
+    if (::pipe(_wakePipe))
+        throwSystemError("pipe");
+
+    setFlags(_wakePipe[0]);
+    setFlags(_wakePipe[1]);
+#endif
+
+#ifdef HAVE_SYS_EPOLL_H
+    _epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (_epollFd < 0)
+    {
+        ::close(_wakePipe[0]);
+        ::close(_wakePipe[1]);
+        throwSystemError("epoll_create1");
+    }
+
+    // the wake pipe is marked with a null pointer
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = 0;
+    ::epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakePipe[0], &ev);
+
+    _events.resize(maxEvents);
+#else
+    pollfd pfd;
+    pfd.fd = _wakePipe[0];
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    _pollfds.push_back(pfd);
+#endif
+}
+
+IdleSockets::~IdleSockets()
+{
+    stop();
+
+#ifdef HAVE_SYS_EPOLL_H
+    ::close(_epollFd);
+#endif
+    ::close(_wakePipe[0]);
+    ::close(_wakePipe[1]);
+}
+
+void IdleSockets::start()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = false;
+    _thread = std::thread(&IdleSockets::run, this);
+}
+
+void IdleSockets::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+
+    if (_thread.joinable())
+    {
+        wake();
+        _thread.join();
+    }
+
+    log_debug("delete " << _sockets.size() << " idle connections");
+
+    for (std::vector<Entry>::iterator it = _sockets.begin(); it != _sockets.end(); ++it)
+        delete it->socket;
+    _sockets.clear();
+
+#ifndef HAVE_SYS_EPOLL_H
+    _pollfds.resize(1);
+#endif
+
+    for (std::vector<Socket*>::iterator it = _pending.begin(); it != _pending.end(); ++it)
+        delete *it;
+    _pending.clear();
+}
+
+void IdleSockets::park(Socket* socket)
+{
+    bool first = false;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_stop)
+        {
+            // the thread is woken once for all connections parked meanwhile
+            first = _pending.empty();
+            _pending.push_back(socket);
+            socket = 0;
+        }
+    }
+
+    if (socket)
+    {
+        log_debug("idle connections stopped; delete " << static_cast<void*>(socket));
+        delete socket;
+    }
+    else if (first)
+        wake();
+}
+
+void IdleSockets::wake()
+{
+    char ch = 'A';
+    if (::write(_wakePipe[1], &ch, 1) < 0 && errno != EAGAIN)
+        log_error("failed to wake idle connection thread; errno=" << errno);
+}
+
+void IdleSockets::run()
+{
+    log_debug("idle connection thread started");
+
+    SocketQueue::Sockets ready;
+
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_stop)
+                break;
+
+            _incoming.swap(_pending);
+        }
+
+        try
+        {
+            for (std::vector<Socket*>::iterator it = _incoming.begin(); it != _incoming.end(); ++it)
+                add(*it, ready);
+            _incoming.clear();
+
+            Timespan now = Clock::getSystemTicks();
+            expire(now);
+
+            if (!ready.empty())
+                _server.admit(ready);
+
+            wait(timeout(now), ready);
+
+            if (!ready.empty())
+            {
+                log_debug(ready.size() << " idle connections received input");
+                _server.admit(ready);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            log_error("error in idle connection thread: " << e.what());
+        }
+    }
+
+    log_debug("idle connection thread stopped");
+}
+
+void IdleSockets::add(Socket* socket, SocketQueue::Sockets& ready)
+{
+    if (socket->buffer().in_avail() > 0)
+    {
+        ready.push_back(socket);
+        return;
+    }
+
+#ifdef HAVE_SYS_EPOLL_H
+    // The socket stays registered, while it is used by a worker, so it is
+    // just enabled again when it is parked next time.
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.ptr = socket;
+
+    int op = socket->_idleRegistered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    int ret = ::epoll_ctl(_epollFd, op, socket->getFd(), &ev);
+    if (ret < 0 && (errno == EEXIST || errno == ENOENT))
+    {
+        op = op == EPOLL_CTL_ADD ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+        ret = ::epoll_ctl(_epollFd, op, socket->getFd(), &ev);
+    }
+
+    if (ret < 0)
+    {
+        log_warn("failed to watch idle connection; errno=" << errno << "; delete " << static_cast<void*>(socket));
+        delete socket;
+        return;
+    }
+
+    socket->_idleRegistered = true;
+#else
+    pollfd pfd;
+    pfd.fd = socket->getFd();
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    _pollfds.push_back(pfd);
+#endif
+
+    log_debug("park idle connection " << static_cast<void*>(socket));
+
+    _sockets.push_back(Entry(socket->deadline(), socket));
+    socket->_idleIndex = _sockets.size() - 1;
+    siftUp(_sockets.size() - 1);
+}
+
+void IdleSockets::remove(Socket* socket)
+{
+    unsigned n = socket->_idleIndex;
+    unsigned last = _sockets.size() - 1;
+
+    if (n != last)
+        move(last, n);
+
+    _sockets.pop_back();
+#ifndef HAVE_SYS_EPOLL_H
+    _pollfds.pop_back();
+#endif
+
+    // the last entry took the place of the removed one
+    if (n != last)
+    {
+        Socket* moved = _sockets[n].socket;
+        siftUp(n);
+        siftDown(moved->_idleIndex);
+    }
+}
+
+void IdleSockets::expire(Timespan now)
+{
+    while (!_sockets.empty() && _sockets.front().deadline <= now)
+    {
+        Socket* socket = _sockets.front().socket;
+        remove(socket);
+        log_debug("keep alive timeout; delete " << static_cast<void*>(socket));
+        delete socket;
+    }
+}
+
+int IdleSockets::timeout(Timespan now) const
+{
+    if (_sockets.empty())
+        return -1;
+
+    // rounded up, so that the thread does not wake before the deadline
+    Timespan t = _sockets.front().deadline - now;
+    return t <= Timespan(0) ? 0 : static_cast<int>((t.totalUSecs() + 999) / 1000);
+}
+
+void IdleSockets::wait(int timeout, SocketQueue::Sockets& ready)
+{
+    bool woken = false;
+
+#ifdef HAVE_SYS_EPOLL_H
+    int n = ::epoll_wait(_epollFd, &_events[0], _events.size(), timeout);
+    if (n < 0)
+    {
+        if (errno == EINTR)
+            return;
+        throwSystemError("epoll_wait");
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        Socket* socket = static_cast<Socket*>(_events[i].data.ptr);
+        if (socket == 0)
+        {
+            woken = true;
+        }
+        else
+        {
+            // EPOLLONESHOT disabled the socket already
+            remove(socket);
+            ready.push_back(socket);
+        }
+    }
+#else
+    int n = ::poll(&_pollfds[0], _pollfds.size(), timeout);
+    if (n < 0)
+    {
+        if (errno == EINTR)
+            return;
+        throwSystemError("poll");
+    }
+
+    woken = _pollfds[0].revents != 0;
+
+    unsigned first = ready.size();
+    for (unsigned i = 1; i < _pollfds.size(); ++i)
+        if (_pollfds[i].revents)
+            ready.push_back(_sockets[i - 1].socket);
+
+    for (unsigned i = first; i < ready.size(); ++i)
+        remove(ready[i]);
+#endif
+
+    if (woken)
+    {
+        char buffer[64];
+        while (::read(_wakePipe[0], buffer, sizeof(buffer)) > 0)
+            ;
+    }
+}
+
+void IdleSockets::move(unsigned from, unsigned to)
+{
+    _sockets[to] = _sockets[from];
+    _sockets[to].socket->_idleIndex = to;
+#ifndef HAVE_SYS_EPOLL_H
+    _pollfds[to + 1] = _pollfds[from + 1];
+#endif
+}
+
+void IdleSockets::siftUp(unsigned n)
+{
+    Entry entry = _sockets[n];
+#ifndef HAVE_SYS_EPOLL_H
+    pollfd pfd = _pollfds[n + 1];
+#endif
+
+    while (n > 0)
+    {
+        unsigned parent = (n - 1) / 2;
+        if (_sockets[parent].deadline <= entry.deadline)
+            break;
+        move(parent, n);
+        n = parent;
+    }
+
+    _sockets[n] = entry;
+    entry.socket->_idleIndex = n;
+#ifndef HAVE_SYS_EPOLL_H
+    _pollfds[n + 1] = pfd;
+#endif
+}
+
+void IdleSockets::siftDown(unsigned n)
+{
+    Entry entry = _sockets[n];
+#ifndef HAVE_SYS_EPOLL_H
+    pollfd pfd = _pollfds[n + 1];
+#endif
+
+    while (true)
+    {
+        unsigned child = 2 * n + 1;
+        if (child >= _sockets.size())
+            break;
+        if (child + 1 < _sockets.size() && _sockets[child + 1].deadline < _sockets[child].deadline)
+            ++child;
+        if (entry.deadline <= _sockets[child].deadline)
+            break;
+        move(child, n);
+        n = child;
+    }
+
+    _sockets[n] = entry;
+    entry.socket->_idleIndex = n;
+#ifndef HAVE_SYS_EPOLL_H
+    _pollfds[n + 1] = pfd;
+#endif
+}
+
+}
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_HTTP_IDLESOCKETS_H
+#define CXXTOOLS_HTTP_IDLESOCKETS_H
+
+#include "socketqueue.h"
+#include <cxxtools/timespan.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+namespace cxxtools
+{
+namespace http
+{
+
+class ServerImpl;
+class Socket;
+
+/**
+ Keeps idle keep alive connections until a request arrives or they time out.
+
+ The connections are watched by a thread of its own using epoll where
+ available, so that they do not occupy the event loop of the application.
+ Worker threads park connections without waiting for that thread. The
+ connections are kept in a heap ordered by timeout, which needs no memory
+ allocation per connection. Connections with input are admitted to the
+ queue of the server in batches.
+ */
+class IdleSockets
+{
+        IdleSockets(const IdleSockets&) = delete;
+        IdleSockets& operator=(const IdleSockets&) = delete;
+
+        struct Entry
+        {
+            Timespan deadline;
+            Socket* socket;
+
+            Entry(Timespan deadline_, Socket* socket_)
+                : deadline(deadline_),
+                  socket(socket_)
+                { }
+        };
+
+    public:
+        explicit IdleSockets(ServerImpl& server);
+        ~IdleSockets();
+
+        /// Starts the thread watching the connections.
+        void start();
+
+        /// Stops the thread and deletes the parked connections.
+        void stop();
+
+        /// Passes an idle connection. The connection is deleted, when the
+        /// thread is stopped.
+        void park(Socket* socket);
+
+    private:
+        void run();
+        void wake();
+        void add(Socket* socket, SocketQueue::Sockets& ready);
+        void remove(Socket* socket);
+        void expire(Timespan now);
+        int timeout(Timespan now) const;
+        void wait(int timeout, SocketQueue::Sockets& ready);
+
+        void move(unsigned from, unsigned to);
+        void siftUp(unsigned n);
+        void siftDown(unsigned n);
+
+        ServerImpl& _server;
+        std::thread _thread;
+
+        std::mutex _mutex;
+        std::vector<Socket*> _pending;
+        std::vector<Socket*> _incoming;
+        bool _stop;
+
+        int _wakePipe[2];
+        std::vector<Entry> _sockets;    // heap ordered by deadline
+
+#ifdef HAVE_SYS_EPOLL_H
+        int _epollFd;
+        std::vector<epoll_event> _events;
+#else
+        std::vector<pollfd> _pollfds;   // wake pipe followed by the sockets in heap order
+#endif
+};
+
+}
+}
+
+#endif // CXXTOOLS_HTTP_IDLESOCKETS_H
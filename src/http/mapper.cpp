@@ -43,7 +43,9 @@ void Mapper::addService(const std::string& url, Service& service)
     log_debug("add service for url <" << url << '>');
 
     WriteLockType serviceLock(_serviceMutex);
+    _router.add(Router::Exact, url, _services.size());
     _services.push_back(ServicesType::value_type(url, &service));
+    _services.back().first.metrics = routeMetrics(url);
 }
 
 void Mapper::addService(Regex&& url, Service& service)
@@ -51,7 +53,29 @@ void Mapper::addService(Regex&& url, Service& service)
     log_debug("add service for regex");
 
     WriteLockType serviceLock(_serviceMutex);
+    _regexServices.push_back(_services.size());
     _services.push_back(ServicesType::value_type(std::move(url), &service));
+    _services.back().first.metrics = routeMetrics(_services.back().first.regex.pattern());
+}
+
+void Mapper::addPrefixService(const std::string& prefix, Service& service)
+{
+    log_debug("add service for url prefix <" << prefix << '>');
+
+    WriteLockType serviceLock(_serviceMutex);
+    _router.add(Router::Prefix, prefix, _services.size());
+    _services.push_back(ServicesType::value_type(Key(prefix, Router::Prefix), &service));
+    _services.back().first.metrics = routeMetrics(prefix + '*');
+}
+
+void Mapper::addPatternService(const std::string& pattern, Service& service)
+{
+    log_debug("add service for url pattern <" << pattern << '>');
+
+    WriteLockType serviceLock(_serviceMutex);
+    _router.add(Router::Pattern, pattern, _services.size());
+    _services.push_back(ServicesType::value_type(Key(pattern, Router::Pattern), &service));
+    _services.back().first.metrics = routeMetrics(pattern);
 }
 
 void Mapper::removeService(Service& service)
@@ -71,34 +95,110 @@ void Mapper::removeService(Service& service)
             ++n;
         }
     }
+
+    rebuildRouter();
+}
+
+void Mapper::rebuildRouter()
+{
+    _router.clear();
+    _regexServices.clear();
+
+    for (ServicesType::size_type n = 0; n < _services.size(); ++n)
+    {
+        const Key& key = _services[n].first;
+        if (key.isRegex())
+            _regexServices.push_back(n);
+        else
+            _router.add(key.kind, key.url, n);
+    }
 }
 
-Responder* Mapper::getResponder(const Request& request)
+RouteMetrics* Mapper::routeMetrics(const std::string& route)
+{
+    std::unique_ptr<RouteMetrics>& metrics = _routeMetrics[route];
+    if (!metrics)
+        metrics.reset(new RouteMetrics(route));
+    return metrics.get();
+}
+
+std::vector<const RouteMetrics*> Mapper::routeMetrics()
+{
+    ReadLockType serviceLock(_serviceMutex);
+
+    std::vector<const RouteMetrics*> ret;
+    ret.reserve(_routeMetrics.size() + 1);
+    for (auto& it: _routeMetrics)
+        ret.push_back(it.second.get());
+    ret.push_back(&_unmatched);
+    return ret;
+}
+
+Responder* Mapper::getResponder(Request& request, RouteMetrics*& metrics)
 {
     log_debug("get responder for url <" << request.url() << '>');
 
     ReadLockType serviceLock(_serviceMutex);
 
-    for (ServicesType::const_iterator it = _services.begin();
-         it != _services.end(); ++it)
+    const std::string& url = request.url();
+
+    // the matches are kept per thread, so that the buffers are reused
+    static thread_local Router::Matches matches;
+    matches.clear();
+    _router.match(url, matches);
+
+    // process router matches and regular expressions in order of registration;
+    // regular expressions are only evaluated when no earlier match succeeded
+    std::vector<Router::Match>::const_iterator mit = matches.matches.begin();
+    std::vector<unsigned>::const_iterator rit = _regexServices.begin();
+
+    while (mit != matches.matches.end() || rit != _regexServices.end())
     {
-        if (it->first.match(request.url()))
+        unsigned idx;
+        const Router::Match* match = 0;
+
+        if (rit != _regexServices.end()
+            && (mit == matches.matches.end() || *rit < mit->index))
+        {
+            idx = *rit++;
+            if (!_services[idx].first.regex.match(url))
+                continue;
+        }
+        else
         {
-            if (!it->second->checkAuth(request))
-            {
-                return _noAuthService.createResponder(request, it->second->realm(), it->second->authContent());
-            }
-
-            Responder* resp = it->second->doCreateResponder(request);
-            if (resp)
-            {
-                log_debug("got responder");
-                return resp;
-            }
+            idx = mit->index;
+            match = &*mit;
+            ++mit;
+        }
+
+        Request::PathParams& pathParams = request._pathParams;
+        pathParams.resize(match ? match->paramCount : 0);
+        for (std::size_t n = 0; n < pathParams.size(); ++n)
+        {
+            const Router::Param& p = Router::param(matches, *match, n);
+            pathParams[n].first = *p.name;
+            pathParams[n].second.assign(url, p.offset, p.size);
+        }
+
+        Service* service = _services[idx].second;
+        metrics = _services[idx].first.metrics;
+        if (!service->checkAuth(request))
+        {
+            return _noAuthService.createResponder(request, service->realm(), service->authContent());
+        }
+
+        Responder* resp = service->doCreateResponder(request);
+        if (resp)
+        {
+            log_debug("got responder");
+            return resp;
         }
     }
 
+    request._pathParams.clear();
+
     log_debug("use default responder");
+    metrics = &_unmatched;
     return _defaultService.createResponder(request);
 }
 
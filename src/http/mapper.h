@@ -31,8 +31,11 @@
 
 #include "notfoundservice.h"
 #include "notauthenticatedservice.h"
+#include "router.h"
 #include <map>
+#include <memory>
 #include <cxxtools/regex.h>
+#include <cxxtools/http/routemetrics.h>
 
 #if __cplusplus >= 201703L
 #include <shared_mutex>
@@ -50,29 +53,50 @@ class Mapper
     public:
         void addService(const std::string& url, Service& service);
         void addService(Regex&& url, Service& service);
+        void addPrefixService(const std::string& prefix, Service& service);
+        void addPatternService(const std::string& pattern, Service& service);
         void removeService(Service& service);
 
-        Responder* getResponder(const Request& request);
-        Responder* getDefaultResponder(const Request& request)
-            { return _defaultService.createResponder(request); }
+        Mapper()
+            : _unmatched(std::string())
+            { }
+
+        /// Returns the responder for the request and the metrics of the matching route.
+        Responder* getResponder(Request& request, RouteMetrics*& metrics);
+        Responder* getDefaultResponder(const Request& request, RouteMetrics*& metrics)
+            { metrics = &_unmatched; return _defaultService.createResponder(request); }
+
+        /// Returns the metrics of all routes ever added.
+        std::vector<const RouteMetrics*> routeMetrics();
 
     private:
         struct Key
         {
           Regex regex;
           std::string url;
-          Key() { }
+          Router::Kind kind;
+          RouteMetrics* metrics;
+          Key()
+            : metrics(0)
+          { }
           Key(Regex&& regex_)
-            : regex(std::move(regex_))
+            : regex(std::move(regex_)),
+              kind(Router::Exact),
+              metrics(0)
           { }
-          Key(const std::string& url_)
-            : url(url_)
+          Key(const std::string& url_, Router::Kind kind_ = Router::Exact)
+            : url(url_),
+              kind(kind_),
+              metrics(0)
           { }
-          bool match(const std::string& u) const
-          { return regex.empty() ? url == u
-                                 : regex.match(u); }
+          bool isRegex() const
+          { return !regex.empty(); }
         };
         typedef std::vector<std::pair<Key, Service*> > ServicesType;
+
+        void rebuildRouter();
+        RouteMetrics* routeMetrics(const std::string& route);
+
 #if __cplusplus >= 201703L
         typedef std::shared_mutex MutexType;
         typedef std::shared_lock<std::shared_mutex> ReadLockType;
@@ -85,8 +109,15 @@ class Mapper
         MutexType _serviceMutex;
 
         ServicesType _services;
+        Router _router;                     // non regex services
+        std::vector<unsigned> _regexServices;  // indexes of regex services in _services
         NotFoundService _defaultService;
         NotAuthenticatedService _noAuthService;
+
+        // metrics are never removed, so that the pointers in _services and
+        // in running requests stay valid
+        std::map<std::string, std::unique_ptr<RouteMetrics>> _routeMetrics;
+        RouteMetrics _unmatched;
 };
 }
 }
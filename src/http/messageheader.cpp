@@ -45,6 +45,11 @@ namespace http
 namespace
 {
 
+inline char toLower(char ch)
+{
+    return ch >= 'A' && ch <= 'Z' ? ch - 'A' + 'a' : ch;
+}
+
 int compareIgnoreCase(const char* s1, const char* s2)
 {
     const char* it1 = s1;
@@ -68,20 +73,142 @@ int compareIgnoreCase(const char* s1, const char* s2)
                 : *it2 ? -1 : 0;
 }
 
-} 
+// case insensitive FNV-1a
+unsigned hashIgnoreCase(const char* s)
+{
+    unsigned h = 2166136261u;
+    for ( ; *s; ++s)
+    {
+        h ^= static_cast<unsigned char>(toLower(*s));
+        h *= 16777619u;
+    }
 
+    return h;
+}
 
-const char* MessageHeader::getHeader(const char* key) const
+struct WellKnownHeader
 {
-    for (const_iterator it = begin(); it != end(); ++it)
+    const char* name;
+    MessageHeader::HeaderId id;
+    unsigned hash;
+};
+
+class WellKnownHeaders
+{
+        WellKnownHeader _headers[MessageHeader::numWellKnownHeaders];
+
+        // open addressing table of indexes into _headers; 0 is a free slot
+        static const unsigned tableSize = 64;
+        unsigned char _table[tableSize];
+
+    public:
+        WellKnownHeaders()
+        {
+            static const char* names[] = {
+                0,
+                "Accept",
+                "Accept-Encoding",
+                "Authorization",
+                "Cache-Control",
+                "Connection",
+                "Content-Encoding",
+                "Content-Length",
+                "Content-Type",
+                "Cookie",
+                "Date",
+                "Host",
+                "Server",
+                "Transfer-Encoding",
+                "Upgrade",
+                "User-Agent"
+            };
+
+            std::fill(_table, _table + tableSize, 0);
+
+            for (unsigned n = 1; n < MessageHeader::numWellKnownHeaders; ++n)
+            {
+                _headers[n].name = names[n];
+                _headers[n].id = static_cast<MessageHeader::HeaderId>(n);
+                _headers[n].hash = hashIgnoreCase(names[n]);
+
+                unsigned slot = _headers[n].hash % tableSize;
+                while (_table[slot])
+                    slot = (slot + 1) % tableSize;
+                _table[slot] = n;
+            }
+        }
+
+        MessageHeader::HeaderId find(const char* key, unsigned hash) const
+        {
+            for (unsigned slot = hash % tableSize; _table[slot]; slot = (slot + 1) % tableSize)
+            {
+                const WellKnownHeader& h = _headers[_table[slot]];
+                if (h.hash == hash && compareIgnoreCase(key, h.name) == 0)
+                    return h.id;
+            }
+
+            return MessageHeader::Unknown;
+        }
+};
+
+const WellKnownHeaders& wellKnownHeaders()
+{
+    static const WellKnownHeaders headers;
+    return headers;
+}
+
+}
+
+unsigned MessageHeader::_defaultMaxSize = 65536;
+
+MessageHeader::HeaderId MessageHeader::headerId(const char* key)
+{
+    return wellKnownHeaders().find(key, hashIgnoreCase(key));
+}
+
+const MessageHeader::Entry* MessageHeader::findEntry(const char* key) const
+{
+    unsigned hash = hashIgnoreCase(key);
+
+    HeaderId id = wellKnownHeaders().find(key, hash);
+    if (id != Unknown)
+        return _wellKnown[id] ? &_entries[_wellKnown[id] - 1] : 0;
+
+    const char* data = _rawdata.data();
+    for (Entries::const_iterator it = _entries.begin(); it != _entries.end(); ++it)
     {
-        if (compareIgnoreCase(key, it->first) == 0)
-            return it->second;
+        if (it->hash == hash && compareIgnoreCase(key, data + it->key) == 0)
+            return &*it;
     }
 
     return 0;
 }
 
+const char* MessageHeader::getHeader(const char* key) const
+{
+    const Entry* e = findEntry(key);
+    return e ? _rawdata.data() + e->value : 0;
+}
+
+const char* MessageHeader::getHeader(HeaderId id) const
+{
+    if (id == Unknown || id >= numWellKnownHeaders || _wellKnown[id] == 0)
+        return 0;
+
+    return _rawdata.data() + _entries[_wellKnown[id] - 1].value;
+}
+
+void MessageHeader::reindex()
+{
+    std::fill(_wellKnown, _wellKnown + numWellKnownHeaders, 0u);
+    for (Entries::size_type n = _entries.size(); n > 0; --n)
+    {
+        HeaderId id = _entries[n - 1].id;
+        if (id != Unknown)
+            _wellKnown[id] = n;
+    }
+}
+
 bool MessageHeader::isHeaderValue(const char* key, const char* value) const
 {
     const char* h = getHeader(key);
@@ -90,10 +217,19 @@ bool MessageHeader::isHeaderValue(const char* key, const char* value) const
     return compareIgnoreCase(h, value) == 0;
 }
 
+bool MessageHeader::isHeaderValue(HeaderId id, const char* value) const
+{
+    const char* h = getHeader(id);
+    if (h == 0)
+        return false;
+    return compareIgnoreCase(h, value) == 0;
+}
+
 void MessageHeader::clear()
 {
-    _rawdata[0] = _rawdata[1] = '\0';
-    _endOffset = 0;
+    _rawdata.clear();
+    _entries.clear();
+    std::fill(_wellKnown, _wellKnown + numWellKnownHeaders, 0u);
     _httpVersionMajor = 1;
     _httpVersionMinor = 1;
 }
@@ -108,20 +244,34 @@ void MessageHeader::setHeader(const char* key, const char* value, bool replace)
     if (replace)
         removeHeader(key);
 
-    char* p = eptr();
+    addHeader(key, strlen(key), value, strlen(value));
+}
 
-    size_t lk = strlen(key);     // length of key
-    size_t lv = strlen(value);   // length of value
+void MessageHeader::addHeader(const char* key, std::size_t lk, const char* value, std::size_t lv)
+{
+    if (lk == 0)
+        throw std::runtime_error("empty key not allowed in messageheader");
 
-    if (p - _rawdata + lk + lv + 2 > MAXHEADERSIZE)
+    if (_rawdata.size() + lk + lv + 2 > _maxSize)
         throw std::runtime_error("message header too big");
 
-    std::strcpy(p, key);   // copy key
-    p += lk + 1;
-    std::strcpy(p, value); // copy value
-    p[lv + 1] = '\0';      // put new message end marker in place
+    Entry e;
+    e.key = _rawdata.size();
+    e.value = e.key + lk + 1;
+
+    _rawdata.insert(_rawdata.end(), key, key + lk);
+    _rawdata.push_back('\0');
+    _rawdata.insert(_rawdata.end(), value, value + lv);
+    _rawdata.push_back('\0');
 
-    _endOffset = (p + lv + 1) - _rawdata;
+    const char* k = _rawdata.data() + e.key;
+    e.hash = hashIgnoreCase(k);
+    e.id = wellKnownHeaders().find(k, e.hash);
+
+    if (e.id != Unknown && _wellKnown[e.id] == 0)
+        _wellKnown[e.id] = _entries.size() + 1;
+
+    _entries.push_back(e);
 }
 
 void MessageHeader::removeHeader(const char* key)
@@ -129,39 +279,49 @@ void MessageHeader::removeHeader(const char* key)
     if (!*key)
         throw std::runtime_error("empty key not allowed in messageheader");
 
-    char* p = eptr();
+    unsigned hash = hashIgnoreCase(key);
+
+    HeaderId id = wellKnownHeaders().find(key, hash);
+    if (id != Unknown && _wellKnown[id] == 0)
+        return;
 
-    const_iterator it = begin();
-    while (it != end())
+    bool removed = false;
+    Entries::size_type n = _wellKnown[id] ? _wellKnown[id] - 1 : 0;
+    while (n < _entries.size())
     {
-        if (compareIgnoreCase(key, it->first) == 0)
+        Entry& e = _entries[n];
+        if (e.hash == hash && compareIgnoreCase(key, _rawdata.data() + e.key) == 0)
         {
-            unsigned slen = it->second - it->first + std::strlen(it->second) + 1;
+            unsigned begin = e.key;
+            unsigned slen = (n + 1 < _entries.size() ? _entries[n + 1].key : _rawdata.size()) - begin;
 
-            std::memmove(
-                const_cast<char*>(it->first),
-                it->first + slen,
-                p - it->first + slen);
+            _rawdata.erase(_rawdata.begin() + begin, _rawdata.begin() + begin + slen);
+            _entries.erase(_entries.begin() + n);
 
-            p -= slen;
+            for (Entries::iterator it = _entries.begin() + n; it != _entries.end(); ++it)
+            {
+                it->key -= slen;
+                it->value -= slen;
+            }
 
-            it.fixup();
+            removed = true;
         }
         else
-            ++it;
+            ++n;
     }
 
-    _endOffset = p - _rawdata;
+    if (removed)
+        reindex();
 }
 
 bool MessageHeader::chunkedTransferEncoding() const
 {
-    return isHeaderValue("Transfer-Encoding", "chunked");
+    return isHeaderValue(TransferEncoding, "chunked");
 }
 
 std::size_t MessageHeader::contentLength() const
 {
-    const char* s = getHeader("Content-Length");
+    const char* s = getHeader(ContentLength);
     if (s == 0)
         return 0;
 
@@ -174,7 +334,7 @@ std::size_t MessageHeader::contentLength() const
 
 bool MessageHeader::keepAlive() const
 {
-    const char* ch = getHeader("Connection");
+    const char* ch = getHeader(Connection);
 
     if (ch == 0)
         return httpVersionMajor() == 1
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <cxxtools/http/metricsservice.h>
+#include <cxxtools/http/responder.h>
+#include <cxxtools/http/request.h>
+#include <cxxtools/http/reply.h>
+#include <cxxtools/http/routemetrics.h>
+#include <cxxtools/http/server.h>
+#include <cxxtools/histogram.h>
+#include <cxxtools/jsonserializer.h>
+#include <cxxtools/query_params.h>
+#include <cxxtools/serializationinfo.h>
+#include <cstring>
+#include <ostream>
+
+namespace cxxtools
+{
+namespace http
+{
+
+namespace
+{
+    // Writes the label value quoted with the escapes of the Prometheus text format.
+    void printLabel(std::ostream& out, const char* name, const std::string& value)
+    {
+        out << name << "=\"";
+        for (char ch: value)
+        {
+            if (ch == '\\')
+                out << "\\\\";
+            else if (ch == '"')
+                out << "\\\"";
+            else if (ch == '\n')
+                out << "\\n";
+            else
+                out << ch;
+        }
+        out << '"';
+    }
+
+    void printHistogram(std::ostream& out, const char* name, const std::string* route, const Histogram& histogram)
+    {
+        uint64_t count = 0;
+        for (unsigned n = 0; n < histogram.buckets(); ++n)
+        {
+            count += histogram.bucketCount(n);
+            out << name << "_bucket{";
+            if (route)
+            {
+                printLabel(out, "route", *route);
+                out << ',';
+            }
+            out << "le=\"";
+            if (n + 1 < histogram.buckets())
+                out << histogram.bound(n).totalSeconds();
+            else
+                out << "+Inf";
+            out << "\"} " << count << '\n';
+        }
+
+        out << name << "_sum";
+        if (route)
+        {
+            out << '{';
+            printLabel(out, "route", *route);
+            out << '}';
+        }
+        out << ' ' << histogram.sum().totalSeconds() << '\n';
+
+        out << name << "_count";
+        if (route)
+        {
+            out << '{';
+            printLabel(out, "route", *route);
+            out << '}';
+        }
+        out << ' ' << histogram.count() << '\n';
+    }
+
+    class MetricsResponder : public Responder
+    {
+            const Server& _server;
+
+            void printPrometheus(std::ostream& out, const std::vector<const RouteMetrics*>& routes);
+            void printJson(std::ostream& out, const std::vector<const RouteMetrics*>& routes);
+
+        public:
+            MetricsResponder(Service& service, const Server& server)
+                : Responder(service),
+                  _server(server)
+                { }
+
+            void reply(std::ostream& out, Request& request, Reply& reply);
+    };
+
+    void MetricsResponder::printPrometheus(std::ostream& out, const std::vector<const RouteMetrics*>& routes)
+    {
+        out.precision(9);
+
+        out << "# HELP http_requests_total Number of finished http requests.\n"
+               "# TYPE http_requests_total counter\n";
+        for (auto route: routes)
+        {
+            for (unsigned code = RouteMetrics::MinReturnCode; code <= RouteMetrics::MaxReturnCode; ++code)
+            {
+                uint64_t count = route->returnCodeCount(code);
+                if (count == 0)
+                    continue;
+
+                out << "http_requests_total{";
+                printLabel(out, "route", route->route());
+                out << ",code=\"" << code << "\"} " << count << '\n';
+            }
+        }
+
+        out << "# HELP http_requests_in_flight Number of http requests currently processed.\n"
+               "# TYPE http_requests_in_flight gauge\n";
+        for (auto route: routes)
+        {
+            out << "http_requests_in_flight{";
+            printLabel(out, "route", route->route());
+            out << "} " << route->inFlight() << '\n';
+        }
+
+        out << "# HELP http_request_duration_seconds Time from receiving the request header until the reply is ready.\n"
+               "# TYPE http_request_duration_seconds histogram\n";
+        for (auto route: routes)
+            printHistogram(out, "http_request_duration_seconds", &route->route(), route->latency());
+
+        out << "# HELP http_queue_time_seconds Time requests waited for a worker thread.\n"
+               "# TYPE http_queue_time_seconds histogram\n";
+        printHistogram(out, "http_queue_time_seconds", 0, _server.queueTimes());
+
+        out << "# HELP http_rejected_requests_total Number of requests rejected because of overload.\n"
+               "# TYPE http_rejected_requests_total counter\n"
+               "http_rejected_requests_total " << _server.rejectedRequests() << '\n';
+    }
+
+    void MetricsResponder::printJson(std::ostream& out, const std::vector<const RouteMetrics*>& routes)
+    {
+        SerializationInfo si;
+
+        SerializationInfo& r = si.addMember("routes");
+        r.setCategory(SerializationInfo::Array);
+        for (auto route: routes)
+            r.addMember() <<= *route;
+
+        si.addMember("queueTimes") <<= _server.queueTimes();
+        si.addMember("rejectedRequests") <<= _server.rejectedRequests();
+
+        JsonSerializer serializer(out);
+        serializer.serialize(si);
+        serializer.finish();
+    }
+
+    void MetricsResponder::reply(std::ostream& out, Request& request, Reply& reply)
+    {
+        std::vector<const RouteMetrics*> routes = _server.routeMetrics();
+
+        const char* accept = request.getHeader("Accept");
+        if (QueryParams(request.qparams()).param("format", std::string()) == "json"
+            || (accept && std::strstr(accept, "application/json")))
+        {
+            reply.setHeader("Content-Type", "application/json");
+            printJson(out, routes);
+        }
+        else
+        {
+            reply.setHeader("Content-Type", "text/plain; version=0.0.4");
+            printPrometheus(out, routes);
+        }
+
+        reply.setHeader("Cache-Control", "no-store");
+    }
+}
+
+Responder* MetricsService::createResponder(const Request&)
+{
+    return new MetricsResponder(*this, _server);
+}
+
+void MetricsService::releaseResponder(Responder* responder)
+{
+    delete responder;
+}
+
+}
+}
@@ -111,12 +111,12 @@ namespace http {
 
     void HeaderParser::MessageHeaderEvent::onKey(const std::string& key)
     {
-        strncpy(_key, key.c_str(), MessageHeader::MAXHEADERSIZE - 1);
+        _key = key;
     }
 
     void HeaderParser::MessageHeaderEvent::onValue(const std::string& value)
     {
-        _header.addHeader(_key, value.c_str());
+        _header.addHeader(_key.c_str(), value.c_str());
     }
 
     std::size_t HeaderParser::advance(std::streambuf& sb)
@@ -590,11 +590,13 @@ namespace http {
     {
         if (ch == '\r')
         {
+            token.clear();
             state = &HeaderParser::state_hfieldbody_cr;
             return;
         }
         else if (ch == '\n')
         {
+            token.clear();
             state = &HeaderParser::state_hfieldbody_crlf;
             return;
         }
@@ -59,7 +59,7 @@ class HeaderParser
         class MessageHeaderEvent : public Event
         {
                 MessageHeader& _header;
-                char _key[MessageHeader::MAXHEADERSIZE];
+                std::string _key;
 
             public:
                 explicit MessageHeaderEvent(MessageHeader& header)
@@ -151,6 +151,12 @@ class HeaderParser
             state = (client ? &HeaderParser::state_cl_protocol0 : &HeaderParser::state_cmd0);
         }
 
+        /// sets the parser to end state after the header was parsed elsewhere
+        void finish()
+        {
+          state = &HeaderParser::state_end;
+        }
+
         /// returns parser to header reading state
         void readHeader()
         {
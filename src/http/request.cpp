@@ -39,7 +39,7 @@ Request::Auth Request::auth() const
 {
     Auth ret;
 
-    const char* sp = getHeader("Authorization");
+    const char* sp = _header.getHeader(MessageHeader::Authorization);
     if (!sp)
         return ret;
 
@@ -58,6 +58,19 @@ Request::Auth Request::auth() const
     return ret;
 }
 
+const std::string& Request::pathParam(const std::string& name) const
+{
+    static const std::string empty;
+
+    for (PathParams::const_iterator it = _pathParams.begin(); it != _pathParams.end(); ++it)
+    {
+        if (it->first == name)
+            return it->second;
+    }
+
+    return empty;
+}
+
 }
 
 }
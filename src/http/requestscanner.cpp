@@ -0,0 +1,318 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "requestscanner.h"
+#include <cxxtools/http/requestheader.h>
+#include <cxxtools/log.h>
+#include <cstring>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+log_define("cxxtools.http.requestscanner")
+
+namespace cxxtools
+{
+namespace http
+{
+
+namespace
+{
+    // Returns a pointer to the first occurrence of ch in [p, e) or e if not found.
+    inline const char* findChar(const char* p, const char* e, char ch)
+    {
+#if defined(__SSE2__) && defined(__GNUC__)
+        const __m128i pattern = _mm_set1_epi8(ch);
+        while (e - p >= 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, pattern));
+            if (mask)
+                return p + __builtin_ctz(mask);
+            p += 16;
+        }
+#else
+        static const uint64_t ones = 0x0101010101010101ull;
+        static const uint64_t highs = 0x8080808080808080ull;
+        const uint64_t pattern = ones * static_cast<unsigned char>(ch);
+        while (e - p >= 8)
+        {
+            uint64_t w;
+            std::memcpy(&w, p, 8);
+            w ^= pattern;
+            if ((w - ones) & ~w & highs)
+                break;   // the byte loop below finds the exact position
+            p += 8;
+        }
+#endif
+
+        while (p < e && *p != ch)
+            ++p;
+
+        return p;
+    }
+
+    // tchar of RFC 7230
+    inline bool isTokenChar(char ch)
+    {
+        static const char s[] = "!#$%&'*+-.^_`|~";
+        return (ch >= 'a' && ch <= 'z')
+            || (ch >= 'A' && ch <= 'Z')
+            || (ch >= '0' && ch <= '9')
+            || (ch != '\0' && std::strchr(s, ch) != 0);
+    }
+
+    inline bool isFieldNameChar(char ch)
+    {
+        return ch > 32 && ch < 127;
+    }
+
+    inline bool isHexDigit(char ch)
+    {
+        return (ch >= '0' && ch <= '9')
+            || (ch >= 'A' && ch <= 'F')
+            || (ch >= 'a' && ch <= 'f');
+    }
+
+    inline unsigned valueOfHexDigit(char ch)
+    {
+        return ch >= '0' && ch <= '9' ? ch - '0'
+             : ch >= 'a' && ch <= 'f' ? ch - 'a' + 10
+             : ch - 'A' + 10;
+    }
+
+    inline bool equalsIgnoreCase(const char* b, const char* e, const char* s)
+    {
+        for ( ; b != e && *s; ++b, ++s)
+        {
+            char ch = *b >= 'a' && *b <= 'z' ? *b - 'a' + 'A' : *b;
+            if (ch != *s)
+                return false;
+        }
+
+        return b == e && *s == '\0';
+    }
+}
+
+void RequestScanner::reset()
+{
+    _lineBegin = 0;
+    _searched = 0;
+    _fields.clear();
+    _urlEncoded = false;
+}
+
+RequestScanner::Result RequestScanner::scan(const char* data, std::size_t size)
+{
+    if (_lineBegin == 0)
+        reset();
+
+    const char* e = data + size;
+
+    while (true)
+    {
+        const char* nl = findChar(data + _searched, e, '\n');
+        if (nl == e)
+        {
+            // the lines before are not scanned again
+            _searched = size;
+            return Incomplete;
+        }
+
+        const char* p = data + _lineBegin;
+        const char* le = nl;
+        if (le > p && le[-1] == '\r')
+            --le;
+
+        bool first = _lineBegin == 0;
+
+        if (le == p)
+        {
+            _lineBegin = _searched = 0;
+
+            if (first)
+                return Error;
+
+            _headerSize = nl + 1 - data;
+            return Complete;
+        }
+
+        Result r = first ? scanRequestLine(data, p, le)
+                         : scanField(data, p, le);
+        if (r == Error)
+        {
+            _lineBegin = _searched = 0;
+            return Error;
+        }
+
+        _lineBegin = _searched = nl + 1 - data;
+    }
+}
+
+RequestScanner::Result RequestScanner::scanRequestLine(const char* data, const char* b, const char* e)
+{
+    // method
+    const char* p = findChar(b, e, ' ');
+    if (p == b || p == e)
+        return Error;
+
+    for (const char* m = b; m != p; ++m)
+        if (!isTokenChar(*m))
+            return Error;
+
+    _method = Token(b - data, p - b);
+
+    while (p != e && *p == ' ')
+        ++p;
+
+    // url; only the origin form is handled here
+    if (p == e || *p != '/')
+        return Error;
+
+    const char* u = ++p;
+    p = findChar(p, e, ' ');
+    if (p == e)
+        return Error;
+
+    const char* q = findChar(u, p, '?');
+
+    for (const char* c = u; c != q; ++c)
+    {
+        if (*c <= ' ' || *c >= 127)
+            return Error;
+        else if (*c == '+')
+            _urlEncoded = true;
+        else if (*c == '%')
+        {
+            if (q - c < 3 || !isHexDigit(c[1]) || !isHexDigit(c[2])
+                || (c[1] == '0' && c[2] == '0'))
+                return Error;
+            _urlEncoded = true;
+            c += 2;
+        }
+    }
+
+    _url = Token(u - data, q - u);
+    _qparams = q == p ? Token() : Token(q + 1 - data, p - q - 1);
+
+    while (p != e && *p == ' ')
+        ++p;
+
+    // protocol
+    const char* v = findChar(p, e, '/');
+    if (v == e || !equalsIgnoreCase(p, v, "HTTP"))
+        return Error;
+
+    ++v;
+    if (e - v < 3 || v[0] != '1' || v[1] != '.' || (v[2] != '0' && v[2] != '1'))
+        return Error;
+
+    for (const char* t = v + 3; t != e; ++t)
+        if (*t != ' ' && *t != '\t')
+            return Error;
+
+    _versionMajor = 1;
+    _versionMinor = v[2] - '0';
+
+    return Complete;
+}
+
+RequestScanner::Result RequestScanner::scanField(const char* data, const char* b, const char* e)
+{
+    const char* colon = findChar(b, e, ':');
+    if (colon == e)
+        return Error;
+
+    const char* ke = colon;
+    while (ke != b && (ke[-1] == ' ' || ke[-1] == '\t'))
+        --ke;
+
+    if (ke == b)
+        return Error;
+
+    for (const char* k = b; k != ke; ++k)
+        if (!isFieldNameChar(*k))
+            return Error;
+
+    const char* v = colon + 1;
+    while (v != e && (*v == ' ' || *v == '\t'))
+        ++v;
+
+    // embedded CRs are left to the HeaderParser
+    if (findChar(v, e, '\r') != e)
+        return Error;
+
+    Field f;
+    f.key = Token(b - data, ke - b);
+    f.value = Token(v - data, e - v);
+    _fields.push_back(f);
+
+    return Complete;
+}
+
+void RequestScanner::apply(const char* data, RequestHeader& header) const
+{
+    header.method(_method.begin(data), _method.size);
+
+    if (_urlEncoded)
+    {
+        _decoded.clear();
+        for (const char* c = _url.begin(data); c != _url.end(data); ++c)
+        {
+            if (*c == '+')
+                _decoded += ' ';
+            else if (*c == '%')
+            {
+                _decoded += static_cast<char>((valueOfHexDigit(c[1]) << 4) | valueOfHexDigit(c[2]));
+                c += 2;
+            }
+            else
+                _decoded += *c;
+        }
+
+        header.url(_decoded.data(), _decoded.size());
+    }
+    else
+    {
+        header.url(_url.begin(data), _url.size);
+    }
+
+    header.qparams(_qparams.begin(data), _qparams.size);
+    header.httpVersion(_versionMajor, _versionMinor);
+
+    for (Fields::const_iterator it = _fields.begin(); it != _fields.end(); ++it)
+        header.addHeader(it->key.begin(data), it->key.size, it->value.begin(data), it->value.size);
+
+    log_debug("request " << header.method() << ' ' << header.url() << " with " << _fields.size() << " header fields scanned");
+}
+
+}
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_HTTP_REQUESTSCANNER_H
+#define CXXTOOLS_HTTP_REQUESTSCANNER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cxxtools
+{
+namespace http
+{
+
+class RequestHeader;
+
+/**
+ Buffer oriented parser for http request headers.
+
+ Unlike the HeaderParser, which runs a state machine per character, the
+ scanner searches whole buffers for line ends and delimiters a machine word
+ (or SSE2 register) at a time. The request line and the header fields are
+ recorded as offsets into the passed buffer, so no data is copied while
+ scanning.
+
+ The scanner accepts only well formed requests. When it reports `Error`,
+ the request may still be valid http (e.g. folded header lines) and the
+ caller should fall back to the HeaderParser.
+ */
+class RequestScanner
+{
+    public:
+        struct Token
+        {
+            unsigned offset;
+            unsigned size;
+
+            Token()
+                : offset(0), size(0)
+                { }
+
+            Token(unsigned offset_, unsigned size_)
+                : offset(offset_), size(size_)
+                { }
+
+            const char* begin(const char* data) const  { return data + offset; }
+            const char* end(const char* data) const    { return data + offset + size; }
+            bool empty() const                          { return size == 0; }
+        };
+
+        struct Field
+        {
+            Token key;
+            Token value;
+        };
+
+        typedef std::vector<Field> Fields;
+
+        enum Result
+        {
+            Incomplete,
+            Complete,
+            Error
+        };
+
+        RequestScanner()
+            : _lineBegin(0),
+              _searched(0),
+              _headerSize(0),
+              _versionMajor(1),
+              _versionMinor(1),
+              _urlEncoded(false)
+            { }
+
+        /// Scans the request header in the buffer.
+        /// When `Incomplete` was returned, the next call continues after the
+        /// lines already scanned. Since the offsets refer to the start of the
+        /// buffer, the same data, possibly extended, must be passed again.
+        Result scan(const char* data, std::size_t size);
+
+        /// Discards an incomplete scan, so that the next call to scan starts
+        /// with a new request.
+        void reset();
+
+        /// Returns the number of bytes the complete header occupies in the buffer.
+        std::size_t headerSize() const     { return _headerSize; }
+
+        const Token& method() const        { return _method; }
+        const Token& url() const           { return _url; }
+        const Token& qparams() const       { return _qparams; }
+        unsigned versionMajor() const      { return _versionMajor; }
+        unsigned versionMinor() const      { return _versionMinor; }
+
+        /// Returns true, when the url contains %-escapes or '+' and needs decoding.
+        bool urlEncoded() const            { return _urlEncoded; }
+
+        const Fields& fields() const       { return _fields; }
+
+        /// Copies the scanned request into the request header.
+        /// The data must be the same buffer passed to scan.
+        void apply(const char* data, RequestHeader& header) const;
+
+    private:
+        Result scanRequestLine(const char* data, const char* b, const char* e);
+        Result scanField(const char* data, const char* b, const char* e);
+
+        std::size_t _lineBegin;  // offset of the first line not scanned yet
+        std::size_t _searched;   // bytes searched for the end of that line
+        std::size_t _headerSize;
+        Token _method;
+        Token _url;
+        Token _qparams;
+        unsigned _versionMajor;
+        unsigned _versionMinor;
+        bool _urlEncoded;
+        Fields _fields;
+        mutable std::string _decoded;
+};
+
+}
+}
+
+#endif // CXXTOOLS_HTTP_REQUESTSCANNER_H
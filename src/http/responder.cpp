@@ -29,14 +29,17 @@
 #include <cxxtools/http/responder.h>
 #include <cxxtools/http/reply.h>
 #include <cxxtools/http/request.h>
+#include "socket.h"
+#include <stdexcept>
 
 namespace cxxtools
 {
 namespace http
 {
 
-void Responder::beginRequest(net::TcpSocket& /*socket*/, std::istream& /*in*/, Request& request)
+void Responder::beginRequest(net::TcpSocket& socket, std::istream& /*in*/, Request& request)
 {
+    _socket = &socket;
     _request = &request;
 }
 
@@ -54,6 +57,20 @@ std::size_t Responder::readBody(std::istream& in)
     return ret;
 }
 
+DetachedReply& Responder::detach()
+{
+    Socket* socket = dynamic_cast<Socket*>(_socket);
+    if (socket == 0)
+        throw std::logic_error("reply can't be detached outside of http::Server");
+    return socket->detachReply();
+}
+
+unsigned Responder::queueJob(const std::function<void()>& job, unsigned count)
+{
+    Socket* socket = dynamic_cast<Socket*>(_socket);
+    return socket ? socket->queueJob(job, count) : 0;
+}
+
 void Responder::replyError(std::ostream& out, Request& /*request*/, Reply& reply, const std::exception& ex)
 {
     reply.httpReturn(500, "internal server error");
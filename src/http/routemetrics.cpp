@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <cxxtools/http/routemetrics.h>
+#include <cxxtools/serializationinfo.h>
+#include <cxxtools/convert.h>
+#include <algorithm>
+
+namespace cxxtools
+{
+namespace http
+{
+
+namespace
+{
+    const unsigned commonReturnCodes[] = {
+        200, 201, 204, 206, 301, 302, 303, 304, 307, 308,
+        400, 401, 403, 404, 405, 409, 413, 429, 500, 502, 503, 504
+    };
+
+    const unsigned numCommonReturnCodes = sizeof(commonReturnCodes) / sizeof(commonReturnCodes[0]);
+
+    // maps return codes to 1 + the index in commonReturnCodes or 0
+    class CommonReturnCodes
+    {
+            unsigned char _index[RouteMetrics::MaxReturnCode - RouteMetrics::MinReturnCode + 1];
+
+        public:
+            CommonReturnCodes()
+            {
+                std::fill(_index, _index + sizeof(_index), 0);
+                for (unsigned n = 0; n < numCommonReturnCodes; ++n)
+                    _index[commonReturnCodes[n] - RouteMetrics::MinReturnCode] = n + 1;
+            }
+
+            unsigned operator[] (unsigned httpReturnCode) const
+                { return _index[httpReturnCode - RouteMetrics::MinReturnCode]; }
+    };
+
+    const CommonReturnCodes& commonIndex()
+    {
+        static const CommonReturnCodes index;
+        return index;
+    }
+}
+
+RouteMetrics::RouteMetrics(const std::string& route)
+    : _route(route),
+      _counters(ReturnCodes + numCommonReturnCodes)
+{
+    for (auto& count: _returnCodes)
+        count.store(0, std::memory_order_relaxed);
+}
+
+void RouteMetrics::requestFinished(unsigned httpReturnCode, Timespan duration)
+{
+    _counters.add(InFlight, -1);
+
+    if (httpReturnCode >= MinReturnCode && httpReturnCode <= MaxReturnCode)
+    {
+        unsigned n = commonIndex()[httpReturnCode];
+        if (n > 0)
+            _counters.add(ReturnCodes + n - 1, 1);
+        else
+            _returnCodes[httpReturnCode - MinReturnCode].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    _latency.add(duration);
+}
+
+uint64_t RouteMetrics::returnCodeCount(unsigned httpReturnCode) const
+{
+    if (httpReturnCode < MinReturnCode || httpReturnCode > MaxReturnCode)
+        return 0;
+
+    unsigned n = commonIndex()[httpReturnCode];
+    return n > 0 ? _counters.sum(ReturnCodes + n - 1)
+                 : _returnCodes[httpReturnCode - MinReturnCode].load(std::memory_order_relaxed);
+}
+
+void operator<<= (SerializationInfo& si, const RouteMetrics& metrics)
+{
+    si.addMember("route") <<= metrics.route();
+    si.addMember("requests") <<= metrics.requests();
+    si.addMember("inFlight") <<= metrics.inFlight();
+
+    SerializationInfo& codes = si.addMember("returnCodes");
+    codes.setCategory(SerializationInfo::Object);
+    for (unsigned code = RouteMetrics::MinReturnCode; code <= RouteMetrics::MaxReturnCode; ++code)
+    {
+        uint64_t count = metrics.returnCodeCount(code);
+        if (count > 0)
+            codes.addMember(convert<std::string>(code)) <<= count;
+    }
+
+    si.addMember("latency") <<= metrics.latency();
+}
+
+}
+}
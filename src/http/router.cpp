@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "router.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace cxxtools
+{
+namespace http
+{
+
+struct Router::ParamEdge
+{
+    std::string name;
+    ParamType type;
+    std::unique_ptr<Node> node;
+};
+
+struct Router::Node
+{
+    std::string label;
+    std::vector<std::unique_ptr<Node>> children;   // first characters of labels are distinct
+    std::vector<ParamEdge> params;
+    std::vector<unsigned> exact;
+    std::vector<unsigned> prefix;
+
+    Node* findChild(char ch) const
+    {
+        for (std::vector<std::unique_ptr<Node>>::const_iterator it = children.begin(); it != children.end(); ++it)
+            if ((*it)->label[0] == ch)
+                return it->get();
+        return 0;
+    }
+};
+
+namespace
+{
+    bool lessIndex(const Router::Match& a, const Router::Match& b)
+    {
+        return a.index < b.index;
+    }
+}
+
+Router::Router()
+    : _root(new Node())
+{ }
+
+Router::~Router()
+{ }
+
+void Router::clear()
+{
+    _root.reset(new Node());
+}
+
+Router::Node* Router::insertLiteral(Node* node, const char* s, std::size_t len)
+{
+    while (len > 0)
+    {
+        std::vector<std::unique_ptr<Node>>::iterator it;
+        for (it = node->children.begin(); it != node->children.end(); ++it)
+            if ((*it)->label[0] == *s)
+                break;
+
+        if (it == node->children.end())
+        {
+            Node* child = new Node();
+            child->label.assign(s, len);
+            node->children.emplace_back(child);
+            return child;
+        }
+
+        Node* child = it->get();
+        std::size_t common = 0;
+        while (common < len && common < child->label.size() && child->label[common] == s[common])
+            ++common;
+
+        if (common < child->label.size())
+        {
+            // split the edge
+            Node* middle = new Node();
+            middle->label = child->label.substr(0, common);
+            child->label.erase(0, common);
+            middle->children.emplace_back(it->release());
+            it->reset(middle);
+            child = middle;
+        }
+
+        node = child;
+        s += common;
+        len -= common;
+    }
+
+    return node;
+}
+
+void Router::add(Kind kind, const std::string& key, unsigned index)
+{
+    if (kind != Pattern)
+    {
+        Node* node = insertLiteral(_root.get(), key.data(), key.size());
+        (kind == Exact ? node->exact : node->prefix).push_back(index);
+        return;
+    }
+
+    Node* node = _root.get();
+    std::string::size_type pos = 0;
+    while (pos < key.size())
+    {
+        std::string::size_type p = key.find('{', pos);
+        if (p == std::string::npos)
+            p = key.size();
+
+        node = insertLiteral(node, key.data() + pos, p - pos);
+        if (p == key.size())
+            break;
+
+        std::string::size_type pe = key.find('}', p);
+        if (pe == std::string::npos)
+            throw std::invalid_argument("missing '}' in url pattern \"" + key + '"');
+
+        std::string name = key.substr(p + 1, pe - p - 1);
+        ParamType type = Segment;
+        std::string::size_type c = name.find(':');
+        if (c != std::string::npos)
+        {
+            std::string t = name.substr(c + 1);
+            name.erase(c);
+            if (t == "int")
+                type = Int;
+            else if (t == "path")
+                type = Path;
+            else if (t != "string")
+                throw std::invalid_argument("unknown parameter type \"" + t + "\" in url pattern \"" + key + '"');
+        }
+
+        if (name.empty())
+            throw std::invalid_argument("empty parameter name in url pattern \"" + key + '"');
+
+        pos = pe + 1;
+        if (pos < key.size() && (key[pos] != '/' || type == Path))
+            throw std::invalid_argument("parameter must be followed by '/' in url pattern \"" + key + '"');
+
+        std::vector<ParamEdge>::iterator it;
+        for (it = node->params.begin(); it != node->params.end(); ++it)
+            if (it->name == name && it->type == type)
+                break;
+
+        if (it == node->params.end())
+        {
+            ParamEdge edge;
+            edge.name = name;
+            edge.type = type;
+            edge.node.reset(new Node());
+            node->params.push_back(std::move(edge));
+            it = node->params.end() - 1;
+        }
+
+        node = it->node.get();
+    }
+
+    node->exact.push_back(index);
+}
+
+void Router::match(const std::string& url, Matches& matches) const
+{
+    std::size_t n = matches.matches.size();
+    match(_root.get(), url.data(), url.data(), url.data() + url.size(), matches);
+    std::sort(matches.matches.begin() + n, matches.matches.end(), lessIndex);
+}
+
+void Router::addMatch(unsigned index, Matches& matches) const
+{
+    Match m;
+    m.index = index;
+    m.params = matches.params.size();
+    m.paramCount = matches.path.size();
+    matches.params.insert(matches.params.end(), matches.path.begin(), matches.path.end());
+    matches.matches.push_back(m);
+}
+
+void Router::match(const Node* node, const char* url, const char* b, const char* e,
+                   Matches& matches) const
+{
+    for (std::vector<unsigned>::const_iterator it = node->prefix.begin(); it != node->prefix.end(); ++it)
+        addMatch(*it, matches);
+
+    if (b == e)
+    {
+        for (std::vector<unsigned>::const_iterator it = node->exact.begin(); it != node->exact.end(); ++it)
+            addMatch(*it, matches);
+
+        return;
+    }
+
+    const Node* child = node->findChild(*b);
+    if (child
+        && static_cast<std::size_t>(e - b) >= child->label.size()
+        && child->label.compare(0, child->label.size(), b, child->label.size()) == 0)
+    {
+        match(child, url, b + child->label.size(), e, matches);
+    }
+
+    for (std::vector<ParamEdge>::const_iterator it = node->params.begin(); it != node->params.end(); ++it)
+    {
+        const char* se = it->type == Path ? e : std::find(b, e, '/');
+        if (se == b)
+            continue;
+
+        if (it->type == Int)
+        {
+            const char* d = b;
+            while (d != se && *d >= '0' && *d <= '9')
+                ++d;
+            if (d != se)
+                continue;
+        }
+
+        Param p;
+        p.name = &it->name;
+        p.offset = b - url;
+        p.size = se - b;
+        matches.path.push_back(p);
+        match(it->node.get(), url, se, e, matches);
+        matches.path.pop_back();
+    }
+}
+
+}
+}
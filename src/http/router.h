@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_HTTP_ROUTER_H
+#define CXXTOOLS_HTTP_ROUTER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace cxxtools
+{
+namespace http
+{
+
+/**
+ Radix tree of url routes.
+
+ Exact urls, url prefixes and patterns with typed path parameters are stored
+ in a compressed prefix tree. Each route has an index, which is the position
+ of the registration in the mapper, so the mapper can process matches in
+ registration order.
+
+ Patterns use `{name}` for a path segment, `{name:int}` for a segment of
+ decimal digits and `{name:path}` for the remaining url including slashes.
+ */
+class Router
+{
+    public:
+        enum Kind
+        {
+            Exact,
+            Prefix,
+            Pattern
+        };
+
+        struct Param
+        {
+            const std::string* name;
+            unsigned offset;   // offset of value in url
+            unsigned size;
+        };
+
+        typedef std::vector<Param> Params;
+
+        struct Match
+        {
+            unsigned index;
+            unsigned params;       // offset of the first parameter in Matches::params
+            unsigned paramCount;
+        };
+
+        /// The routes matching a url. The parameters of all matches are
+        /// kept in one vector, so that a reused object does not allocate.
+        struct Matches
+        {
+            std::vector<Match> matches;
+            Params params;
+            Params path;   // parameters of the route currently searched
+
+            void clear()
+            {
+                matches.clear();
+                params.clear();
+                path.clear();
+            }
+        };
+
+        Router();
+        ~Router();
+
+        /// Adds a route; throws std::invalid_argument on malformed patterns.
+        void add(Kind kind, const std::string& key, unsigned index);
+
+        void clear();
+
+        /// Appends all routes matching the url sorted by index to matches.
+        void match(const std::string& url, Matches& matches) const;
+
+        /// Returns the nth parameter of a match.
+        static const Param& param(const Matches& matches, const Match& m, unsigned n)
+            { return matches.params[m.params + n]; }
+
+    private:
+        struct Node;
+        struct ParamEdge;
+
+        enum ParamType
+        {
+            Segment,
+            Int,
+            Path
+        };
+
+        Node* insertLiteral(Node* node, const char* s, std::size_t len);
+        void match(const Node* node, const char* url, const char* b, const char* e,
+                   Matches& matches) const;
+        void addMatch(unsigned index, Matches& matches) const;
+
+        std::unique_ptr<Node> _root;
+};
+
+}
+}
+
+#endif // CXXTOOLS_HTTP_ROUTER_H
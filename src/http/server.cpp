@@ -75,6 +75,16 @@ void Server::addService(Regex&& url, Service& service)
     _impl->addService(std::move(url), service);
 }
 
+void Server::addPrefixService(const std::string& prefix, Service& service)
+{
+    _impl->addPrefixService(prefix, service);
+}
+
+void Server::addPatternService(const std::string& pattern, Service& service)
+{
+    _impl->addPatternService(pattern, service);
+}
+
 void Server::removeService(Service& service)
 {
     _impl->removeService(service);
@@ -130,6 +140,81 @@ void Server::maxThreads(unsigned m)
     _impl->maxThreads(m);
 }
 
+unsigned Server::maxPipelinedRequests() const
+{
+    return _impl->maxPipelinedRequests();
+}
+
+void Server::maxPipelinedRequests(unsigned n)
+{
+    _impl->maxPipelinedRequests(n);
+}
+
+bool Server::http2() const
+{
+    return _impl->http2();
+}
+
+void Server::http2(bool sw)
+{
+    _impl->http2(sw);
+}
+
+unsigned Server::maxQueueSize() const
+{
+    return _impl->maxQueueSize();
+}
+
+void Server::maxQueueSize(unsigned n)
+{
+    _impl->maxQueueSize(n);
+}
+
+Milliseconds Server::queueTimeout() const
+{
+    return _impl->queueTimeout();
+}
+
+void Server::queueTimeout(Milliseconds ms)
+{
+    _impl->queueTimeout(ms);
+}
+
+Milliseconds Server::queueTarget() const
+{
+    return _impl->queueTarget();
+}
+
+void Server::queueTarget(Milliseconds ms)
+{
+    _impl->queueTarget(ms);
+}
+
+Seconds Server::retryAfter() const
+{
+    return _impl->retryAfter();
+}
+
+void Server::retryAfter(Seconds s)
+{
+    _impl->retryAfter(s);
+}
+
+const Histogram& Server::queueTimes() const
+{
+    return _impl->queueTimes();
+}
+
+uint64_t Server::rejectedRequests() const
+{
+    return _impl->rejectedRequests();
+}
+
+std::vector<const RouteMetrics*> Server::routeMetrics() const
+{
+    return _impl->routeMetrics();
+}
+
 Delegate<bool, const SslCertificate&>& Server::acceptSslCertificate()
 {
     return _impl->acceptSslCertificate;
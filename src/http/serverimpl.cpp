@@ -29,43 +29,25 @@
 #include "serverimpl.h"
 #include "worker.h"
 #include "socket.h"
+#include "detachedconnection.h"
 
 #include <cxxtools/eventloop.h>
 #include <cxxtools/log.h>
 #include <cxxtools/net/tcpserver.h>
 
+#include <algorithm>
+
 log_define("cxxtools.http.server.impl")
 
 namespace cxxtools
 {
 namespace http
 {
-
-class IdleSocketEvent : public BasicEvent<IdleSocketEvent>
+namespace
 {
-        Socket* _socket;
-
-    public:
-        explicit IdleSocketEvent(Socket* socket)
-            : _socket(socket)
-            { }
-
-        Socket* socket() const   { return _socket; }
-
-};
-
-class KeepAliveTimeoutEvent : public BasicEvent<KeepAliveTimeoutEvent>
-{
-        Socket* _socket;
-
-    public:
-        explicit KeepAliveTimeoutEvent(Socket* socket)
-            : _socket(socket)
-            { }
-
-        Socket* socket() const   { return _socket; }
-
-};
+    // number of request/reply pairs kept for reuse after connections are closed
+    const unsigned maxPooledMessages = 64;
+}
 
 class ServerStartEvent : public BasicEvent<ServerStartEvent>
 {
@@ -96,12 +78,38 @@ class ThreadTerminatedEvent : public BasicEvent<ThreadTerminatedEvent>
         Worker* worker() const   { return _worker; }
 };
 
-class ActiveSocketEvent : public BasicEvent<ActiveSocketEvent>
+class DetachedSocketEvent : public BasicEvent<DetachedSocketEvent>
 {
         Socket* _socket;
 
     public:
-        explicit ActiveSocketEvent(Socket* socket)
+        explicit DetachedSocketEvent(Socket* socket)
+            : _socket(socket)
+            { }
+
+        Socket* socket() const   { return _socket; }
+
+};
+
+class DetachedOutputEvent : public BasicEvent<DetachedOutputEvent>
+{
+        Socket* _socket;
+
+    public:
+        explicit DetachedOutputEvent(Socket* socket)
+            : _socket(socket)
+            { }
+
+        Socket* socket() const   { return _socket; }
+
+};
+
+class DetachedReleasedEvent : public BasicEvent<DetachedReleasedEvent>
+{
+        Socket* _socket;
+
+    public:
+        explicit DetachedReleasedEvent(Socket* socket)
             : _socket(socket)
             { }
 
@@ -112,15 +120,15 @@ class ActiveSocketEvent : public BasicEvent<ActiveSocketEvent>
 
 ServerImpl::ServerImpl(EventLoopBase& eventLoop, Signal<Server::Runmode>& runmodeChanged)
     : ServerImplBase(eventLoop, runmodeChanged),
-      inputSlot(slot(*this, &ServerImpl::onInput)),
-      timeoutSlot(slot(*this, &ServerImpl::onTimeout))
+      _queue(*this),
+      _idleSockets(*this)
 {
-    _eventLoop.event.subscribe(slot(*this, &ServerImpl::onIdleSocket));
-    _eventLoop.event.subscribe(slot(*this, &ServerImpl::onActiveSocket));
-    _eventLoop.event.subscribe(slot(*this, &ServerImpl::onKeepAliveTimeout));
     _eventLoop.event.subscribe(slot(*this, &ServerImpl::onNoWaitingThreads));
     _eventLoop.event.subscribe(slot(*this, &ServerImpl::onThreadTerminated));
     _eventLoop.event.subscribe(slot(*this, &ServerImpl::onServerStart));
+    _eventLoop.event.subscribe(slot(*this, &ServerImpl::onDetachedSocket));
+    _eventLoop.event.subscribe(slot(*this, &ServerImpl::onDetachedOutput));
+    _eventLoop.event.subscribe(slot(*this, &ServerImpl::onDetachedReleased));
 
     connect(_eventLoop.exited, *this, &ServerImpl::terminate);
 
@@ -140,6 +148,12 @@ ServerImpl::~ServerImpl()
             log_fatal("exception in http-server termination occured: " << e.what());
         }
     }
+
+    // idle connections return their messages to the pool
+    _idleSockets.stop();
+
+    for (auto messages: _messagePool)
+        delete messages;
 }
 
 void ServerImpl::listen(const std::string& ip, unsigned short int port, const SslCtx& sslCtx)
@@ -168,6 +182,8 @@ void ServerImpl::start()
     log_trace("start server");
     runmode(Server::Starting);
 
+    _idleSockets.start();
+
     std::lock_guard<std::mutex> lock(_threadMutex);
     while (_threads.size() < minThreads())
     {
@@ -190,6 +206,8 @@ void ServerImpl::terminate()
 
     try
     {
+        _idleSockets.stop();
+
         log_debug("wake " << _listener.size() << " listeners");
         for (ServerImpl::ListenerType::iterator it = _listener.begin(); it != _listener.end(); ++it)
             (*it)->terminateAccept();
@@ -221,9 +239,13 @@ void ServerImpl::terminate()
         while (!_queue.empty())
             delete _queue.get();
 
-        for (std::set<Socket*>::iterator it = _idleSockets.begin(); it != _idleSockets.end(); ++it)
+        log_debug("close " << _detachedSockets.size() << " detached connections");
+        for (std::set<Socket*>::iterator it = _detachedSockets.begin(); it != _detachedSockets.end(); ++it)
+        {
+            (*it)->detached()->shutdown();
             delete *it;
-        _idleSockets.clear();
+        }
+        _detachedSockets.clear();
 
         runmode(Server::Stopped);
     }
@@ -233,6 +255,18 @@ void ServerImpl::terminate()
     }
 }
 
+unsigned ServerImpl::queueJob(const SocketQueue::Job& job, unsigned count)
+{
+    if (isTerminating())
+        return 0;
+
+    count = std::min(count, minThreads());
+    for (unsigned n = 0; n < count; ++n)
+        _queue.put(job);
+
+    return count;
+}
+
 void ServerImpl::noWaitingThreads()
 {
     std::lock_guard<std::mutex> lock(_threadMutex);
@@ -262,7 +296,22 @@ void ServerImpl::addIdleSocket(Socket* socket)
 
     if (runmode() == Server::Running)
     {
-        _eventLoop.commitEvent(IdleSocketEvent(socket));
+        _idleSockets.park(socket);
+    }
+    else
+    {
+        log_debug("server not running; delete " << static_cast<void*>(socket));
+        delete socket;
+    }
+}
+
+void ServerImpl::addDetachedSocket(Socket* socket)
+{
+    log_debug("add detached socket " << static_cast<void*>(socket));
+
+    if (runmode() == Server::Running)
+    {
+        _eventLoop.commitEvent(DetachedSocketEvent(socket));
     }
     else
     {
@@ -271,21 +320,119 @@ void ServerImpl::addIdleSocket(Socket* socket)
     }
 }
 
-void ServerImpl::onIdleSocket(const IdleSocketEvent& event)
+void ServerImpl::onDetachedSocket(const DetachedSocketEvent& event)
 {
     Socket* socket = event.socket();
 
-    log_debug("add idle socket " << static_cast<void*>(socket) << " to selector");
+    log_debug("add detached socket " << static_cast<void*>(socket) << " to selector");
 
-    _idleSockets.insert(socket);
+    _detachedSockets.insert(socket);
     socket->setSelector(&_eventLoop);
-    socket->inputConnection = socket->inputReady.connect(inputSlot);
-    socket->timeoutConnection = socket->timeout.connect(timeoutSlot);
+    socket->inputConnection = socket->buffer().inputReady.connect(socket->inputSlot);
+    socket->startDetached();
+}
+
+void ServerImpl::detachedOutput(Socket* socket)
+{
+    _eventLoop.commitEvent(DetachedOutputEvent(socket));
+}
+
+void ServerImpl::onDetachedOutput(const DetachedOutputEvent& event)
+{
+    // the connection may be closed and deleted meanwhile
+    if (_detachedSockets.find(event.socket()) != _detachedSockets.end())
+        event.socket()->detached()->flush();
+}
+
+void ServerImpl::detachedReleased(Socket* socket)
+{
+    if (runmode() == Server::Running)
+        _eventLoop.commitEvent(DetachedReleasedEvent(socket));
+}
+
+ConnectionMessages* ServerImpl::acquireMessages()
+{
+    {
+        std::lock_guard<std::mutex> lock(_messagePoolMutex);
+        if (!_messagePool.empty())
+        {
+            ConnectionMessages* messages = _messagePool.back();
+            _messagePool.pop_back();
+            return messages;
+        }
+    }
+
+    return new ConnectionMessages();
 }
 
-void ServerImpl::onActiveSocket(const ActiveSocketEvent& event)
+void ServerImpl::releaseMessages(ConnectionMessages* messages)
 {
-    _queue.put(event.socket());
+    messages->request.clear();
+    messages->reply.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(_messagePoolMutex);
+        if (_messagePool.size() < maxPooledMessages)
+        {
+            _messagePool.push_back(messages);
+            return;
+        }
+    }
+
+    delete messages;
+}
+
+void ServerImpl::onDetachedReleased(const DetachedReleasedEvent& event)
+{
+    Socket* socket = event.socket();
+    if (!_detachedSockets.erase(socket))
+        return;
+
+    if (socket->isConnected())
+    {
+        log_debug("detached connection finished; keep " << static_cast<void*>(socket) << " alive");
+        socket->inputConnection.close();
+        socket->resumeKeepAlive();
+        socket->removeSelector();
+
+        if (socket->buffer().in_avail() > 0)
+            admit(socket);
+        else
+            _idleSockets.park(socket);
+    }
+    else
+    {
+        log_debug("detached connection closed; delete " << static_cast<void*>(socket));
+        delete socket;
+    }
+}
+
+void ServerImpl::admit(Socket* socket)
+{
+    SocketQueue::Sockets expired;
+    if (!_queue.admit(socket, expired))
+        expired.push_back(socket);
+
+    reject(expired);
+}
+
+void ServerImpl::admit(SocketQueue::Sockets& sockets)
+{
+    SocketQueue::Sockets expired;
+    _queue.admit(sockets, expired);
+    reject(expired);
+}
+
+void ServerImpl::reject(SocketQueue::Sockets& sockets)
+{
+    for (SocketQueue::Sockets::iterator it = sockets.begin(); it != sockets.end(); ++it)
+    {
+        requestRejected();
+        (*it)->rejectRequest(retryAfter());
+        delete *it;
+    }
+
+    sockets.clear();
 }
 
 void ServerImpl::onNoWaitingThreads(const NoWaitingThreadsEvent& /*event*/)
@@ -345,40 +492,6 @@ void ServerImpl::onServerStart(const ServerStartEvent& event)
     }
 }
 
-void ServerImpl::onInput(Socket& socket)
-{
-    socket.removeSelector();
-    log_debug("search socket " << static_cast<void*>(&socket) << " in idle sockets");
-    _idleSockets.erase(&socket);
-
-    if (socket.isConnected())
-    {
-        socket.inputConnection.close();
-        socket.timeoutConnection.close();
-        _eventLoop.commitEvent(ActiveSocketEvent(&socket));
-    }
-    else
-    {
-        log_debug("onInput; delete " << static_cast<void*>(&socket));
-        delete &socket;
-    }
-}
-
-void ServerImpl::onTimeout(Socket& socket)
-{
-    log_debug("timeout; socket " << static_cast<void*>(&socket));
-
-    _eventLoop.commitEvent(KeepAliveTimeoutEvent(&socket));
-}
-
-void ServerImpl::onKeepAliveTimeout(const KeepAliveTimeoutEvent& event)
-{
-    Socket* socket = event.socket();
-    _idleSockets.erase(socket);
-    log_debug("onKeepAliveTimeout; delete " << static_cast<void*>(&socket));
-    delete socket;
-}
-
 
 }
 }
@@ -30,7 +30,8 @@
 #define CXXTOOLS_HTTP_SERVERIMPL_H
 
 #include "serverimplbase.h"
-#include <cxxtools/queue.h>
+#include "socketqueue.h"
+#include "idlesockets.h"
 #include <cxxtools/event.h>
 #include <cxxtools/http/server.h>
 
@@ -56,12 +57,13 @@ namespace http
 class Worker;
 class ServerImpl;
 class Socket;
-class IdleSocketEvent;
-class KeepAliveTimeoutEvent;
+struct ConnectionMessages;
 class ServerStartEvent;
 class NoWaitingThreadsEvent;
 class ThreadTerminatedEvent;
-class ActiveSocketEvent;
+class DetachedSocketEvent;
+class DetachedOutputEvent;
+class DetachedReleasedEvent;
 
 class ServerImpl : public ServerImplBase, public Connectable
 {
@@ -78,34 +80,56 @@ class ServerImpl : public ServerImplBase, public Connectable
         // override from ServerImplBase
         void terminate();
 
+        /// Wakes the event loop to send data queued for a detached connection by another thread.
+        void detachedOutput(Socket* socket);
+
+        /// Takes back a released detached connection in the next event loop iteration.
+        /// The socket is kept as idle socket when it is still connected, deleted otherwise.
+        void detachedReleased(Socket* socket);
+
+        /// Returns request and reply objects for a new connection; they
+        /// are taken from closed connections when available.
+        ConnectionMessages* acquireMessages();
+        void releaseMessages(ConnectionMessages* messages);
+
+        /// Passes sockets with requests to the worker threads.
+        void admit(SocketQueue::Sockets& sockets);
+
+        /// Queues a job for up to count worker threads, but not for more
+        /// than the minimum number of threads. Returns the number queued.
+        unsigned queueJob(const SocketQueue::Job& job, unsigned count);
+
     private:
         void noWaitingThreads();
-        void onInput(Socket& _socket);
-        void onTimeout(Socket& _socket);
 
+        void admit(Socket* socket);
+        void reject(SocketQueue::Sockets& sockets);
         void addIdleSocket(Socket* socket);
-        void onIdleSocket(const IdleSocketEvent& event);
-        void onActiveSocket(const ActiveSocketEvent& event);
-        void onKeepAliveTimeout(const KeepAliveTimeoutEvent& event);
+        void addDetachedSocket(Socket* socket);
         void onNoWaitingThreads(const NoWaitingThreadsEvent& event);
         void onThreadTerminated(const ThreadTerminatedEvent& event);
         void onServerStart(const ServerStartEvent& event);
+        void onDetachedSocket(const DetachedSocketEvent& event);
+        void onDetachedOutput(const DetachedOutputEvent& event);
+        void onDetachedReleased(const DetachedReleasedEvent& event);
         void start();
 
         friend class Worker;
 
         ////////////////////////////////////////////////////
 
-        MethodSlot<void, ServerImpl, Socket&> inputSlot;
-        MethodSlot<void, ServerImpl, Socket&> timeoutSlot;
-
-        Queue<Socket*> _queue;
-        std::set<Socket*> _idleSockets;
+        SocketQueue _queue;
+        IdleSockets _idleSockets;
+        std::set<Socket*> _detachedSockets;     // owned by the event loop
 
         ////////////////////////////////////////////////////
         typedef std::vector<std::unique_ptr<net::TcpServer>> ListenerType;
         ListenerType _listener;
 
+        ////////////////////////////////////////////////////
+        std::vector<ConnectionMessages*> _messagePool;
+        std::mutex _messagePoolMutex;
+
         ////////////////////////////////////////////////////
         typedef std::set<Worker*> Threads;
         Threads _threads;
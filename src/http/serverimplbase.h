@@ -31,7 +31,9 @@
 
 #include <cxxtools/http/server.h>
 #include <cxxtools/timespan.h>
+#include <cxxtools/histogram.h>
 #include "mapper.h"
+#include <atomic>
 
 namespace cxxtools
 {
@@ -55,6 +57,13 @@ class ServerImplBase
               _keepAliveTimeout(Seconds(30)),
               _minThreads(5),
               _maxThreads(200),
+              _maxPipelinedRequests(16),
+              _http2(true),
+              _maxQueueSize(0),
+              _queueTimeout(0),
+              _queueTarget(0),
+              _retryAfter(Seconds(1)),
+              _rejectedRequests(0),
               _runmodeChanged(runmodeChanged),
               _runmode(Server::Stopped)
         { }
@@ -67,13 +76,20 @@ class ServerImplBase
         { _mapper.addService(url, service); }
         void addService(Regex&& url, Service& service)
         { _mapper.addService(std::move(url), service); }
+        void addPrefixService(const std::string& prefix, Service& service)
+        { _mapper.addPrefixService(prefix, service); }
+        void addPatternService(const std::string& pattern, Service& service)
+        { _mapper.addPatternService(pattern, service); }
         void removeService(Service& service)
         { _mapper.removeService(service); }
 
-        Responder* getResponder(const Request& request)
-            { return _mapper.getResponder(request); }
-        Responder* getDefaultResponder(const Request& request)
-            { return _mapper.getDefaultResponder(request); }
+        Responder* getResponder(Request& request, RouteMetrics*& metrics)
+            { return _mapper.getResponder(request, metrics); }
+        Responder* getDefaultResponder(const Request& request, RouteMetrics*& metrics)
+            { return _mapper.getDefaultResponder(request, metrics); }
+
+        std::vector<const RouteMetrics*> routeMetrics()
+            { return _mapper.routeMetrics(); }
 
         Milliseconds readTimeout() const       { return _readTimeout; }
         Milliseconds writeTimeout() const      { return _writeTimeout; }
@@ -89,6 +105,30 @@ class ServerImplBase
         unsigned maxThreads() const           { return _maxThreads; }
         void maxThreads(unsigned m)           { _maxThreads = m; }
 
+        unsigned maxPipelinedRequests() const { return _maxPipelinedRequests; }
+        void maxPipelinedRequests(unsigned n) { _maxPipelinedRequests = n; }
+
+        bool http2() const                    { return _http2; }
+        void http2(bool sw)                   { _http2 = sw; }
+
+        unsigned maxQueueSize() const         { return _maxQueueSize; }
+        void maxQueueSize(unsigned n)         { _maxQueueSize = n; }
+
+        Milliseconds queueTimeout() const     { return _queueTimeout; }
+        void queueTimeout(Milliseconds ms)    { _queueTimeout = ms; }
+
+        Milliseconds queueTarget() const      { return _queueTarget; }
+        void queueTarget(Milliseconds ms)     { _queueTarget = ms; }
+
+        Seconds retryAfter() const            { return _retryAfter; }
+        void retryAfter(Seconds s)            { _retryAfter = s; }
+
+        Histogram& queueTimes()               { return _queueTimes; }
+        const Histogram& queueTimes() const   { return _queueTimes; }
+
+        uint64_t rejectedRequests() const     { return _rejectedRequests; }
+        void requestRejected()                { ++_rejectedRequests; }
+
         virtual void terminate()              { }
         Server::Runmode runmode() const
         { return _runmode; }
@@ -111,6 +151,15 @@ class ServerImplBase
 
         unsigned _minThreads;
         unsigned _maxThreads;
+        unsigned _maxPipelinedRequests;
+        bool _http2;
+
+        unsigned _maxQueueSize;
+        Milliseconds _queueTimeout;
+        Milliseconds _queueTarget;
+        Seconds _retryAfter;
+        Histogram _queueTimes;
+        std::atomic<uint64_t> _rejectedRequests;
 
         Signal<Server::Runmode>& _runmodeChanged;
         Server::Runmode _runmode;
@@ -28,8 +28,15 @@
 
 #include "socket.h"
 #include "serverimpl.h"
+#include "http2session.h"
+#include "websocketimpl.h"
+#include "detachedreplyimpl.h"
+#include <cxxtools/base64codec.h>
+#include <cxxtools/clock.h>
+#include <cxxtools/http/routemetrics.h>
 #include <cxxtools/log.h>
 #include <cassert>
+#include <cstring>
 #include "config.h"
 
 log_define("cxxtools.http.socket")
@@ -60,13 +67,23 @@ Socket::Socket(ServerImpl& server, net::TcpServer& tcpServer, const SslCtx& sslC
       _tcpServer(tcpServer),
       _sslCtx(sslCtx),
       _server(server),
+      _messages(server.acquireMessages()),
+      _request(_messages->request),
+      _reply(_messages->reply),
       _parseEvent(_request),
       _parser(_parseEvent, false),
       _responder(0),
+      _routeMetrics(0),
+      _bodyStream(_stream.rdbuf()),
+      _pipelined(0),
+      _replied(false),
+      _http2(0),
+      _detached(0),
+      _idleIndex(0),
+      _idleRegistered(false),
       _accepted(false)
 {
     _stream.attachDevice(*this);
-    cxxtools::connect(IODevice::inputReady, *this, &Socket::onIODeviceInput);
     cxxtools::connect(_stream.buffer().outputReady, *this, &Socket::onOutput);
     cxxtools::connect(_timer.timeout, *this, &Socket::onTimeout);
     cxxtools::connect(acceptSslCertificate, *this, &Socket::onAcceptSslCertificate);
@@ -79,13 +96,23 @@ Socket::Socket(Socket& socket)
       _tcpServer(socket._tcpServer),
       _sslCtx(socket._sslCtx),
       _server(socket._server),
+      _messages(_server.acquireMessages()),
+      _request(_messages->request),
+      _reply(_messages->reply),
       _parseEvent(_request),
       _parser(_parseEvent, false),
       _responder(0),
+      _routeMetrics(0),
+      _bodyStream(_stream.rdbuf()),
+      _pipelined(0),
+      _replied(false),
+      _http2(0),
+      _detached(0),
+      _idleIndex(0),
+      _idleRegistered(false),
       _accepted(false)
 {
     _stream.attachDevice(*this);
-    cxxtools::connect(IODevice::inputReady, *this, &Socket::onIODeviceInput);
     cxxtools::connect(_stream.buffer().outputReady, *this, &Socket::onOutput);
     cxxtools::connect(_timer.timeout, *this, &Socket::onTimeout);
     cxxtools::connect(acceptSslCertificate, *this, &Socket::onAcceptSslCertificate);
@@ -93,8 +120,15 @@ Socket::Socket(Socket& socket)
 
 Socket::~Socket()
 {
+    delete _detached;
+
     if (_responder)
         _responder->release();
+
+    if (_routeMetrics)
+        _routeMetrics->requestAborted();
+
+    _server.releaseMessages(_messages);
 }
 
 void Socket::accept()
@@ -137,17 +171,25 @@ void Socket::removeSelector()
     _timer.setSelector(0);
 }
 
-void Socket::onIODeviceInput(IODevice& /*iodevice*/)
+Timespan Socket::deadline() const
 {
-    log_debug("onIODeviceInput");
-    inputReady(*this);
+    return _timer.active() ? _timer.finished()
+                           : Clock::getSystemTicks() + _server.keepAliveTimeout();
 }
 
 void Socket::onInput(StreamBuffer& sb)
 {
     log_debug("onInput");
 
-    sb.endRead();
+    if (_detached)
+    {
+        _detached->onInput(sb);
+        return;
+    }
+
+    // input may be left from a detached reply
+    if (sb.reading())
+        sb.endRead();
 
     if (sb.in_avail() == 0 || sb.device()->eof())
     {
@@ -156,13 +198,121 @@ void Socket::onInput(StreamBuffer& sb)
     }
 
     _timer.start(_server.readTimeout());
+    processInput(sb);
+}
+
+void Socket::rejectRequest(Seconds retryAfter)
+{
+    log_warn("server overloaded; reject request from client " << getPeerAddr());
+
+    try
+    {
+        // the available input is read, so that closing does not reset
+        // the connection before the client reads the reply
+        if (buffer().reading())
+            buffer().endRead();
+
+        if (!_http2)
+        {
+            static const char body[] = "service unavailable";
+            char date[50];
+            _stream << "HTTP/1.1 503 Service Unavailable\r\n"
+                       "Content-Type: text/plain\r\n"
+                       "Content-Length: " << (sizeof(body) - 1) << "\r\n"
+                       "Retry-After: " << static_cast<long>(retryAfter.totalSeconds() + 0.5) << "\r\n"
+                       "Connection: close\r\n"
+                       "Date: " << MessageHeader::htdateCurrent(date) << "\r\n"
+                       "\r\n"
+                    << body
+                    << std::flush;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        log_debug("failed to send 503 reply: " << e.what());
+    }
+
+    close();
+}
+
+void Socket::processInput(StreamBuffer& sb)
+{
+    // Requests, which are already in the input buffer are answered without
+    // returning to the selector. The replies are collected in the output
+    // buffer and sent together.
+    while (!_http2 && readRequest(sb))
+    {
+        _timer.stop();
+        doReply();
+
+        if (!pipelineNext(sb))
+        {
+            _pipelined = 0;
+            onOutput(sb);
+            return;
+        }
+    }
+
+    // the event loop runs a http/2 connection from now on
+    if (_http2)
+        _timer.stop();
+}
+
+bool Socket::readRequest(StreamBuffer& sb)
+{
     if ( _responder == 0 )
     {
-        _parser.advance(sb);
+        if (_parser.begin() && http2Enabled())
+        {
+            // a client with prior knowledge starts with the http/2 connection preface
+            std::size_t n = std::min(static_cast<std::size_t>(sb.in_avail()), Http2Connection::prefaceSize);
+            if (n > 0 && std::memcmp(sb.inputBegin(), Http2Connection::preface, n) == 0)
+            {
+                if (n < Http2Connection::prefaceSize)
+                {
+                    waitInput(sb);
+                    return false;
+                }
+
+                log_info("http/2 connection from client " << getPeerAddr());
+                _http2 = new Http2Session(_server, *this);
+                _detached = _http2;
+                _http2->open();
+                return false;
+            }
+        }
+
+        if (_parser.begin())
+        {
+            RequestScanner::Result r = _scanner.scan(sb.inputBegin(), sb.in_avail());
+            if (r == RequestScanner::Complete)
+            {
+                _scanner.apply(sb.inputBegin(), _request.header());
+                sb.inputConsume(_scanner.headerSize());
+                _parser.finish();
+            }
+            else if (r == RequestScanner::Incomplete
+                && static_cast<std::size_t>(sb.in_avail()) < sb.inputCapacity())
+            {
+                // keep the partial header in the buffer and scan again when more data arrives
+                waitInput(sb);
+                return false;
+            }
+            else
+            {
+                _scanner.reset();
+                _parser.advance(sb);
+            }
+        }
+        else
+        {
+            _parser.advance(sb);
+        }
 
         if (_parser.fail())
         {
-            _responder = _server.getDefaultResponder(_request);
+            _responder = _server.getDefaultResponder(_request, _routeMetrics);
+            startMetrics();
             _responder->replyError(_reply.bodyStream(), _request, _reply,
                 std::runtime_error("invalid http header"));
             _responder->release();
@@ -171,14 +321,19 @@ void Socket::onInput(StreamBuffer& sb)
             sendReply();
 
             onOutput(sb);
-            return;
+            return false;
         }
 
         if (_parser.end())
         {
             log_info("request " << _request.method() << ' ' << _request.header().query()
                 << " from client " << getPeerAddr());
-            _responder = _server.getResponder(_request);
+
+            if (http2Enabled() && isUpgradeH2c() && upgradeHttp2())
+                return false;
+
+            _responder = _server.getResponder(_request, _routeMetrics);
+            startMetrics();
             try
             {
                 _responder->beginRequest(*this, _stream, _request);
@@ -192,22 +347,23 @@ void Socket::onInput(StreamBuffer& sb)
                 sendReply();
 
                 onOutput(sb);
-                return;
+                return false;
             }
 
             _contentLength = _request.header().contentLength();
             log_debug("content length of request is " << _contentLength);
             if (_contentLength == 0)
-            {
-                _timer.stop();
-                doReply();
-                return;
-            }
+                return true;
 
+            // the body must not be read beyond the content length since
+            // the input buffer may hold the next pipelined request already
+            _bodyStream.clear();
+            _bodyStream.icount(_contentLength);
         }
         else
         {
-            sb.beginRead();
+            waitInput(sb);
+            return false;
         }
     }
 
@@ -217,7 +373,7 @@ void Socket::onInput(StreamBuffer& sb)
         {
             try
             {
-                std::size_t s = _responder->readBody(_stream);
+                std::size_t s = _responder->readBody(_bodyStream);
                 assert(s > 0);
                 _contentLength -= s;
             }
@@ -230,23 +386,161 @@ void Socket::onInput(StreamBuffer& sb)
                 sendReply();
 
                 onOutput(sb);
-                return;
+                return false;
             }
         }
 
         if (_contentLength <= 0)
-        {
-            _timer.stop();
-            doReply();
-        }
-        else
-        {
-            sb.beginRead();
-        }
+            return true;
+
+        waitInput(sb);
     }
+
+    return false;
 }
 
-bool Socket::doReply()
+void Socket::waitInput(StreamBuffer& sb)
+{
+    sb.beginRead();
+
+    // replies to pipelined requests must not wait for the next request
+    if (sb.out_avail())
+    {
+        _pipelined = 0;
+        sb.beginWrite();
+    }
+}
+
+bool Socket::pipelineNext(StreamBuffer& sb)
+{
+    if (sb.in_avail() == 0
+        || _detached
+        || !_request.header().keepAlive()
+        || !_reply.header().keepAlive()
+        || ++_pipelined >= _server.maxPipelinedRequests())
+        return false;
+
+    log_debug("process pipelined request");
+    _request.clear();
+    _reply.clear();
+    _parser.reset(false);
+    _scanner.reset();
+    _replied = false;
+
+    return true;
+}
+
+bool Socket::http2Enabled() const
+{
+    return _server.http2() && !_sslCtx.enabled();
+}
+
+bool Socket::isUpgradeH2c() const
+{
+    const RequestHeader& header = _request.header();
+    const char* upgrade = header.getHeader(MessageHeader::Upgrade);
+
+    // requests with a body are answered in HTTP/1.1
+    return upgrade != 0
+        && std::strcmp(upgrade, "h2c") == 0
+        && header.hasHeader("HTTP2-Settings")
+        && header.contentLength() == 0
+        && !header.chunkedTransferEncoding();
+}
+
+bool Socket::upgradeHttp2()
+{
+    // HTTP2-Settings is base64url encoded without padding
+    std::string settings = _request.header().getHeader("HTTP2-Settings");
+    for (std::string::iterator it = settings.begin(); it != settings.end(); ++it)
+    {
+        if (*it == '-')
+            *it = '+';
+        else if (*it == '_')
+            *it = '/';
+    }
+    settings.append((4 - settings.size() % 4) % 4, '=');
+    settings = Base64Codec::decode(settings);
+
+    // with invalid settings the request is answered without upgrade
+    if (settings.size() % 6 != 0)
+    {
+        log_warn("invalid HTTP2-Settings from client " << getPeerAddr());
+        return false;
+    }
+
+    log_info("upgrade connection from client " << getPeerAddr() << " to http/2");
+
+    _stream << "HTTP/1.1 101 Switching Protocols\r\n"
+               "Connection: Upgrade\r\n"
+               "Upgrade: h2c\r\n"
+               "\r\n";
+
+    // the request is answered on stream 1 after the server settings
+    _http2 = new Http2Session(_server, *this);
+    _detached = _http2;
+    _http2->upgrade(settings, _request);
+
+    _request.clear();
+    _reply.clear();
+
+    return true;
+}
+
+void Socket::upgradeWebSocket(WebSocketService& service, const std::string& protocol, unsigned deflateBits)
+{
+    if (_http2)
+        throw std::runtime_error("websocket upgrade is not supported on http/2 connections");
+    if (_detached)
+        throw std::logic_error("connection is already detached");
+
+    log_info("upgrade connection from client " << getPeerAddr() << " to websocket");
+    _detached = new WebSocketImpl(_server, *this, service, _request, protocol, deflateBits);
+}
+
+DetachedReply& Socket::detachReply()
+{
+    if (_http2)
+        throw std::runtime_error("detached replies are not supported on http/2 connections");
+    if (_detached)
+        throw std::logic_error("connection is already detached");
+
+    log_debug("detach reply to client " << getPeerAddr());
+    DetachedReplyImpl* impl = new DetachedReplyImpl(_server, *this, _request);
+    _detached = impl;
+    return impl->reply();
+}
+
+unsigned Socket::queueJob(const std::function<void()>& job, unsigned count)
+{
+    return _server.queueJob(job, count);
+}
+
+void Socket::startDetached()
+{
+    _detached->start(buffer());
+}
+
+void Socket::resumeKeepAlive()
+{
+    delete _detached;
+    _detached = 0;
+
+    _request.clear();
+    _reply.clear();
+    _parser.reset(false);
+    _scanner.reset();
+    _replied = false;
+
+    // a request received meanwhile is processed by a worker
+    if (buffer().in_avail() == 0)
+    {
+        _timer.start(_server.keepAliveTimeout());
+        buffer().beginRead();
+    }
+}
+
+void Socket::doReply()
 {
     log_trace("http::Socket::doReply");
     try
@@ -258,20 +552,24 @@ bool Socket::doReply()
         log_warn("responder reported error: " << e.what());
         _reply.clear();
         _responder->replyError(_reply.bodyStream(), _request, _reply, e);
+
+        if (_detached)
+            _detached->replyFailed();
     }
 
     _responder->release();
     _responder = 0;
 
     sendReply();
-
-    return onOutput(_stream.buffer());
 }
 
 bool Socket::onOutput(StreamBuffer& sb)
 {
     log_trace("onOutput");
 
+    if (_detached)
+        return _detached->onOutput(sb);
+
     log_debug("send data to " << getPeerAddr());
 
     try
@@ -281,7 +579,14 @@ bool Socket::onOutput(StreamBuffer& sb)
         if ( sb.out_avail() )
         {
             sb.beginWrite();
-            _timer.start(_server.writeTimeout());
+            if (_replied)
+                _timer.start(_server.writeTimeout());
+        }
+        else if (!_replied)
+        {
+            // replies to pipelined requests are sent while the next
+            // request is still read
+            log_debug("pipelined replies sent");
         }
         else
         {
@@ -295,8 +600,13 @@ bool Socket::onOutput(StreamBuffer& sb)
                 _request.clear();
                 _reply.clear();
                 _parser.reset(false);
+                _scanner.reset();
+                _replied = false;
                 if (sb.in_avail())
-                    onInput(sb);
+                {
+                    _timer.start(_server.readTimeout());
+                    processInput(sb);
+                }
                 else
                     _stream.buffer().beginRead();
             }
@@ -325,17 +635,27 @@ void Socket::onTimeout()
     timeout(*this);
 }
 
-void Socket::sendReply()
+void Socket::startMetrics()
 {
-    const char* contentLength = "Content-Length";
-    const char* server = "Server";
-    const char* connection = "Connection";
-    const char* date = "Date";
+    _routeMetrics->requestStarted();
+    _requestStart = Clock::getSystemTicks();
+}
 
+void Socket::sendReply()
+{
     log_info("request " << _request.method() << ' ' << _request.header().query()
         << " ready, returncode " << _reply.httpReturnCode() << ' '
         << _reply.httpReturnText());
 
+    if (_routeMetrics)
+    {
+        _routeMetrics->requestFinished(_reply.httpReturnCode(), Clock::getSystemTicks() - _requestStart);
+        _routeMetrics = 0;
+    }
+
+    if (_detached)
+        _detached->prepareReply(_request, _reply);
+
     _stream << "HTTP/"
         << _reply.header().httpVersionMajor() << '.'
         << _reply.header().httpVersionMinor() << ' '
@@ -348,24 +668,28 @@ void Socket::sendReply()
         _stream << it->first << ": " << it->second << "\r\n";
     }
 
-    if (!_reply.header().hasHeader(contentLength))
+    // informational replies like 101 Switching Protocols have no body and
+    // detached replies frame their body themselves
+    if (!_reply.header().hasHeader(MessageHeader::ContentLength)
+        && _reply.httpReturnCode() >= 200
+        && !_detached)
     {
         _stream << "Content-Length: " << _reply.bodySize() << "\r\n";
     }
 
-    if (!_reply.header().hasHeader(server))
+    if (!_reply.header().hasHeader(MessageHeader::Server))
     {
         _stream << "Server: cxxtools-Http-Server " PACKAGE_VERSION "\r\n";
     }
 
-    if (!_reply.header().hasHeader(connection))
+    if (!_reply.header().hasHeader(MessageHeader::Connection))
     {
         _stream << "Connection: "
                 << (_request.header().keepAlive() ? "keep-alive" : "close")
                 << "\r\n";
     }
 
-    if (!_reply.header().hasHeader(date))
+    if (!_reply.header().hasHeader(MessageHeader::Date))
     {
         char buffer[50];
         _stream << "Date: " << MessageHeader::htdateCurrent(buffer) << "\r\n";
@@ -375,6 +699,8 @@ void Socket::sendReply()
 
     _reply.sendBody(_stream);
 
+    _replied = true;
+
 }
 
 bool Socket::onAcceptSslCertificate(const SslCertificate& cert)
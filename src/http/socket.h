@@ -34,11 +34,14 @@
 #include <cxxtools/http/reply.h>
 #include <cxxtools/sslctx.h>
 #include <cxxtools/iostream.h>
+#include <cxxtools/limitstream.h>
 #include <cxxtools/timer.h>
 #include <cxxtools/connectable.h>
 #include <cxxtools/signal.h>
 #include <cxxtools/method.h>
 #include "parser.h"
+#include "requestscanner.h"
+#include <functional>
 
 namespace cxxtools {
 
@@ -46,9 +49,29 @@ namespace http {
 
 class ServerImpl;
 class Responder;
+class Http2Session;
+class DetachedConnection;
+class DetachedReply;
+class WebSocketService;
+class RouteMetrics;
+class IdleSockets;
+
+/**
+ The request and reply objects of a connection.
+
+ They are kept by the server, when the connection is closed, and passed to
+ the next connection, so that their buffers are not allocated again.
+ */
+struct ConnectionMessages
+{
+    Request request;
+    Reply reply;
+};
 
 class Socket : public net::TcpSocket, public Connectable
 {
+        friend class IdleSockets;
+
         class ParseEvent : public HeaderParser::MessageHeaderEvent
         {
                 Request& _request;
@@ -76,21 +99,41 @@ class Socket : public net::TcpSocket, public Connectable
         void setSelector(SelectorBase* s);
         void removeSelector();
 
-        void onIODeviceInput(IODevice& iodevice);
         void onInput(StreamBuffer& sb);
         bool onOutput(StreamBuffer& sb);
         void onTimeout();
         bool onAcceptSslCertificate(const SslCertificate& cert);
 
-        bool doReply();
+        /// Answers the pending request with 503 Service Unavailable and closes the connection.
+        void rejectRequest(Seconds retryAfter);
+
+        void processInput(StreamBuffer& sb);
+        void doReply();
+        void startMetrics();
         void sendReply();
         bool isReady() const
         { return _parser.end() && _contentLength == 0; }
 
+        /// Switches the connection to the websocket protocol after the handshake reply.
+        void upgradeWebSocket(WebSocketService& service, const std::string& protocol, unsigned deflateBits);
+
+        /// Passes the current reply to the event loop after the header is sent.
+        DetachedReply& detachReply();
+
+        /// Lets up to count worker threads run job; see Responder::queueJob.
+        unsigned queueJob(const std::function<void()>& job, unsigned count);
+
+        bool isDetached() const          { return _detached != 0; }
+        bool isHttp2() const             { return _http2 != 0; }
+        DetachedConnection* detached()   { return _detached; }
+        void startDetached();
+
+        /// Returns to http after a detached reply is finished.
+        void resumeKeepAlive();
+
         const Request& request() const { return _request; }
         const Reply& reply() const     { return _reply; }
 
-        Signal<Socket&> inputReady;
         Signal<Socket&> timeout;
 
         StreamBuffer& buffer()         { return _stream.buffer(); }
@@ -98,22 +141,44 @@ class Socket : public net::TcpSocket, public Connectable
         MethodSlot<void, Socket, StreamBuffer&> inputSlot;
 
         Connection inputConnection;
-        Connection timeoutConnection;
+
+        /// Returns the time, when the connection is closed, while no input arrives.
+        Timespan deadline() const;
 
     private:
+        bool readRequest(StreamBuffer& sb);
+        void waitInput(StreamBuffer& sb);
+        bool pipelineNext(StreamBuffer& sb);
+        bool http2Enabled() const;
+        bool isUpgradeH2c() const;
+        bool upgradeHttp2();
+
         net::TcpServer& _tcpServer;
         SslCtx _sslCtx;
         ServerImpl& _server;
 
+        ConnectionMessages* _messages;
+        Request& _request;
+        Reply& _reply;
+
         ParseEvent _parseEvent;
         HeaderParser _parser;
-        Request _request;
-        Reply _reply;
+        RequestScanner _scanner;
 
         Timer _timer;
         int _contentLength;
         Responder* _responder;
+        RouteMetrics* _routeMetrics;    // set while a request is processed
+        Timespan _requestStart;
         IOStream _stream;
+        LimitIStream _bodyStream;
+        unsigned _pipelined;    // replies collected in the output buffer
+        bool _replied;          // reply to current request is generated
+        Http2Session* _http2;   // set when the connection switched to http/2; owned as _detached
+        DetachedConnection* _detached;  // set when the connection is passed to the event loop
+
+        unsigned _idleIndex;    // position in the idle connections, while parked
+        bool _idleRegistered;   // file descriptor is known to the idle connections
 
         int _sslVerifyLevel;
         std::string _sslCa;
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "socketqueue.h"
+#include "serverimplbase.h"
+#include <cxxtools/scopedincrement.h>
+
+namespace cxxtools
+{
+namespace http
+{
+
+namespace
+{
+    // the queue is overloaded, when it did not run empty for this interval
+    const std::chrono::milliseconds codelInterval(100);
+
+    std::chrono::microseconds toDuration(Milliseconds ms)
+    {
+        return std::chrono::microseconds(ms.totalUSecs());
+    }
+}
+
+SocketQueue::SocketQueue(ServerImplBase& server)
+    : _server(server),
+      _lastEmpty(Clock::now()),
+      _numWaiting(0)
+{
+}
+
+void SocketQueue::put(Socket* socket)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _control.push_back(socket);
+    _notEmpty.notify_one();
+}
+
+void SocketQueue::put(const Job& job)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _jobs.push_back(job);
+    _notEmpty.notify_one();
+}
+
+bool SocketQueue::admit(Socket* socket, Sockets& expired)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Clock::time_point now = Clock::now();
+    expire(now, expired);
+
+    unsigned maxSize = _server.maxQueueSize();
+    if (maxSize > 0 && _requests.size() >= maxSize)
+        return false;
+
+    if (_requests.empty())
+        _lastEmpty = now;
+
+    _requests.push_back(Entry(socket, now));
+    _notEmpty.notify_one();
+    return true;
+}
+
+void SocketQueue::admit(Sockets& sockets, Sockets& expired)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Clock::time_point now = Clock::now();
+    expire(now, expired);
+
+    unsigned maxSize = _server.maxQueueSize();
+    for (Sockets::iterator it = sockets.begin(); it != sockets.end(); ++it)
+    {
+        if (maxSize > 0 && _requests.size() >= maxSize)
+        {
+            expired.push_back(*it);
+            continue;
+        }
+
+        if (_requests.empty())
+            _lastEmpty = now;
+
+        _requests.push_back(Entry(*it, now));
+    }
+
+    if (sockets.size() > 1)
+        _notEmpty.notify_all();
+    else
+        _notEmpty.notify_one();
+
+    sockets.clear();
+}
+
+Socket* SocketQueue::get(Sockets& expired, Job& job)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    {
+        ScopedIncrement<unsigned> inc(_numWaiting);
+        while (_control.empty() && _jobs.empty() && _requests.empty())
+            _notEmpty.wait(lock);
+    }
+
+    Socket* socket = 0;
+    if (!_control.empty())
+    {
+        socket = _control.front();
+        _control.pop_front();
+    }
+    else if (!_jobs.empty())
+    {
+        job = std::move(_jobs.front());
+        _jobs.pop_front();
+    }
+    else
+    {
+        Clock::time_point now = Clock::now();
+        expire(now, expired);
+
+        if (!_requests.empty())
+        {
+            // an overloaded queue serves the newest request, which is most
+            // likely to be answered before the client gives up
+            bool lifo = overloaded(now);
+            Entry entry = lifo ? _requests.back() : _requests.front();
+            if (lifo)
+                _requests.pop_back();
+            else
+                _requests.pop_front();
+
+            socket = entry.socket;
+            _server.queueTimes().add(Microseconds(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - entry.queued).count()));
+        }
+
+        if (_requests.empty())
+            _lastEmpty = now;
+    }
+
+    if (!_control.empty() || !_jobs.empty() || !_requests.empty())
+        _notEmpty.notify_one();
+
+    return socket;
+}
+
+Socket* SocketQueue::get()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    _jobs.clear();
+
+    ScopedIncrement<unsigned> inc(_numWaiting);
+    while (_control.empty() && _requests.empty())
+        _notEmpty.wait(lock);
+
+    Socket* socket;
+    if (!_control.empty())
+    {
+        socket = _control.front();
+        _control.pop_front();
+    }
+    else
+    {
+        socket = _requests.front().socket;
+        _requests.pop_front();
+    }
+
+    return socket;
+}
+
+unsigned SocketQueue::requests() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _requests.size();
+}
+
+bool SocketQueue::empty() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _control.empty() && _requests.empty();
+}
+
+unsigned SocketQueue::numWaiting() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numWaiting;
+}
+
+bool SocketQueue::overloaded(Clock::time_point now) const
+{
+    return _server.queueTarget() > Milliseconds(0)
+        && !_requests.empty()
+        && now - _lastEmpty > codelInterval;
+}
+
+// Moves requests, which waited too long, to expired. The requests are
+// ordered by age, so the oldest are at the front.
+void SocketQueue::expire(Clock::time_point now, Sockets& expired)
+{
+    Milliseconds timeout = _server.queueTimeout();
+    if (overloaded(now) && (timeout <= Milliseconds(0) || _server.queueTarget() < timeout))
+        timeout = _server.queueTarget();
+
+    if (timeout <= Milliseconds(0))
+        return;
+
+    Clock::time_point limit = now - toDuration(timeout);
+    while (!_requests.empty() && _requests.front().queued < limit)
+    {
+        expired.push_back(_requests.front().socket);
+        _requests.pop_front();
+    }
+}
+
+}
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_HTTP_SOCKETQUEUE_H
+#define CXXTOOLS_HTTP_SOCKETQUEUE_H
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+namespace cxxtools
+{
+namespace http
+{
+
+class ServerImplBase;
+class Socket;
+
+/**
+ Queue of sockets waiting for a worker thread.
+
+ Listening sockets and control entries are put unconditionally and are
+ taken first. Sockets with a request are admitted according to the queue
+ settings of the server: the size of the queue is limited, requests, which
+ waited too long, expire and an overloaded queue is served last in, first
+ out with the target of controlled delay as limit.
+
+ Sockets, which are refused or expired, are returned to the caller, which
+ answers them with 503 Service Unavailable.
+
+ Jobs are passed by responders, which let idle threads help with a request.
+ They are taken after the control entries and before the requests.
+ */
+class SocketQueue
+{
+        SocketQueue(const SocketQueue&) = delete;
+        SocketQueue& operator=(const SocketQueue&) = delete;
+
+        typedef std::chrono::steady_clock Clock;
+
+        struct Entry
+        {
+            Socket* socket;
+            Clock::time_point queued;
+
+            Entry(Socket* socket_, Clock::time_point queued_)
+                : socket(socket_),
+                  queued(queued_)
+                { }
+        };
+
+    public:
+        typedef std::vector<Socket*> Sockets;
+        typedef std::function<void()> Job;
+
+        explicit SocketQueue(ServerImplBase& server);
+
+        /// Adds a listening socket or a control entry.
+        void put(Socket* socket);
+
+        /// Adds a job for a worker thread.
+        void put(const Job& job);
+
+        /// Adds a socket with a request. Returns false, when the queue is full.
+        bool admit(Socket* socket, Sockets& expired);
+
+        /// Adds sockets with requests and wakes the waiting threads at once.
+        /// Sockets, which do not fit into the queue, are moved to expired.
+        /// The list of sockets is cleared.
+        void admit(Sockets& sockets, Sockets& expired);
+
+        /// Returns the next socket and blocks while the queue is empty.
+        /// Returns a null pointer, when a job was taken into job or when
+        /// only expired requests were found.
+        Socket* get(Sockets& expired, Job& job);
+
+        /// Returns the next socket without checking expiry. Jobs are dropped.
+        Socket* get();
+
+        /// Returns the number of requests waiting.
+        unsigned requests() const;
+
+        bool empty() const;
+        unsigned numWaiting() const;
+
+    private:
+        bool overloaded(Clock::time_point now) const;
+        void expire(Clock::time_point now, Sockets& expired);
+
+        ServerImplBase& _server;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _notEmpty;
+        std::deque<Socket*> _control;
+        std::deque<Job> _jobs;
+        std::deque<Entry> _requests;
+        Clock::time_point _lastEmpty;
+        unsigned _numWaiting;
+};
+
+}
+}
+
+#endif // CXXTOOLS_HTTP_SOCKETQUEUE_H
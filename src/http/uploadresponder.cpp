@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cxxtools/http/uploadresponder.h>
+#include <cxxtools/http/request.h>
+#include <cxxtools/http/reply.h>
+#include <cxxtools/log.h>
+#include <stdexcept>
+
+log_define("cxxtools.http.uploadresponder")
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+namespace
+{
+    class BodyTooLarge : public std::runtime_error
+    {
+        public:
+            BodyTooLarge()
+                : std::runtime_error("request body too large")
+                { }
+    };
+}
+
+////////////////////////////////////////////////////////////////////////
+// MultipartSink
+//
+MultipartSink::MultipartSink(const Request& request, MimeMultipartParser::Handler& handler)
+    : _parser(handler, request.header().getHeader("Content-Type"))
+{
+}
+
+////////////////////////////////////////////////////////////////////////
+// UploadResponder
+//
+UploadResponder::UploadResponder(Service& service, std::uint64_t maxBodySize)
+    : Responder(service),
+      _maxBodySize(maxBodySize),
+      _received(0),
+      _sink(0),
+      _sinkFailed(false)
+{
+}
+
+UploadResponder::~UploadResponder()
+{
+    delete _sink;
+}
+
+void UploadResponder::releaseSink()
+{
+    delete _sink;
+    _sink = 0;
+}
+
+void UploadResponder::beginRequest(net::TcpSocket& socket, std::istream& in, Request& request)
+{
+    Responder::beginRequest(socket, in, request);
+
+    releaseSink();
+    _received = 0;
+    _sinkFailed = false;
+
+    if (_maxBodySize > 0 && request.header().contentLength() > _maxBodySize)
+    {
+        log_info("request body of " << request.header().contentLength() << " bytes exceeds limit of " << _maxBodySize);
+        throw BodyTooLarge();
+    }
+
+    try
+    {
+        _sink = createSink(request);
+    }
+    catch (const std::exception&)
+    {
+        _sinkFailed = true;
+        throw;
+    }
+}
+
+std::size_t UploadResponder::readBody(std::istream& in)
+{
+    char buffer[8192];
+    std::streamsize n = in.readsome(buffer, sizeof(buffer));
+    if (n <= 0)
+        return 0;
+
+    _received += n;
+    if (_maxBodySize > 0 && _received > _maxBodySize)
+    {
+        log_info("request body exceeds limit of " << _maxBodySize);
+        throw BodyTooLarge();
+    }
+
+    try
+    {
+        _sink->write(buffer, n);
+    }
+    catch (const std::exception&)
+    {
+        _sinkFailed = true;
+        throw;
+    }
+
+    return n;
+}
+
+void UploadResponder::reply(std::ostream& out, Request& request, Reply& reply)
+{
+    try
+    {
+        _sink->finish();
+    }
+    catch (const std::exception&)
+    {
+        _sinkFailed = true;
+        throw;
+    }
+
+    log_debug("upload of " << _received << " bytes finished");
+    uploaded(out, request, reply, *_sink);
+    releaseSink();
+}
+
+void UploadResponder::replyError(std::ostream& out, Request& request, Reply& reply, const std::exception& ex)
+{
+    if (dynamic_cast<const BodyTooLarge*>(&ex))
+    {
+        reply.httpReturn(413, "Payload Too Large");
+        reply.setHeader("Content-Type", "text/plain");
+        reply.setHeader("Connection", "close");
+        out << ex.what();
+    }
+    else if (_sinkFailed)
+    {
+        log_warn("invalid request body: " << ex.what());
+        reply.httpReturn(400, "Bad Request");
+        reply.setHeader("Content-Type", "text/plain");
+        reply.setHeader("Connection", "close");
+        out << ex.what();
+    }
+    else
+    {
+        Responder::replyError(out, request, reply, ex);
+    }
+
+    releaseSink();
+}
+
+} // namespace http
+
+} // namespace cxxtools
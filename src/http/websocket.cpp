@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+
+#include <cxxtools/http/websocket.h>
+#include "websocketimpl.h"
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+const Request& WebSocket::request() const
+{
+    return _impl->request();
+}
+
+const std::string& WebSocket::protocol() const
+{
+    return _impl->protocol();
+}
+
+std::string WebSocket::peerAddr() const
+{
+    return _impl->peerAddr();
+}
+
+bool WebSocket::compressed() const
+{
+    return _impl->compressed();
+}
+
+void WebSocket::sendText(const std::string& message)
+{
+    _impl->send(WebSocketConnection::Text, message.data(), message.size());
+}
+
+void WebSocket::sendBinary(const std::string& data)
+{
+    _impl->send(WebSocketConnection::Binary, data.data(), data.size());
+}
+
+void WebSocket::sendBinary(const char* data, std::size_t size)
+{
+    _impl->send(WebSocketConnection::Binary, data, size);
+}
+
+void WebSocket::ping(const std::string& payload)
+{
+    _impl->ping(payload);
+}
+
+void WebSocket::close(unsigned short code, const std::string& reason)
+{
+    _impl->close(code, reason);
+}
+
+bool WebSocket::isOpen() const
+{
+    return _impl->isOpen();
+}
+
+std::size_t WebSocket::outputPending() const
+{
+    return _impl->outputPending();
+}
+
+} // namespace http
+
+} // namespace cxxtools
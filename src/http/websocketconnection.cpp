@@ -0,0 +1,573 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "websocketconnection.h"
+#include <cxxtools/log.h>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include "config.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+log_define("cxxtools.http.websocket")
+
+namespace cxxtools
+{
+namespace http
+{
+
+namespace
+{
+    // smaller messages are not worth compressing
+    const std::size_t minDeflateSize = 64;
+
+    bool validUtf8(const char* data, std::size_t size)
+    {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+        const unsigned char* e = p + size;
+        while (p < e)
+        {
+            unsigned char ch = *p++;
+            if (ch < 0x80)
+                continue;
+
+            unsigned n;
+            unsigned long cp;
+            if (ch >= 0xc2 && ch <= 0xdf)
+            {
+                n = 1;
+                cp = ch & 0x1f;
+            }
+            else if (ch >= 0xe0 && ch <= 0xef)
+            {
+                n = 2;
+                cp = ch & 0x0f;
+            }
+            else if (ch >= 0xf0 && ch <= 0xf4)
+            {
+                n = 3;
+                cp = ch & 0x07;
+            }
+            else
+                return false;
+
+            if (static_cast<std::size_t>(e - p) < n)
+                return false;
+
+            for (unsigned i = 0; i < n; ++i)
+            {
+                if ((p[i] & 0xc0) != 0x80)
+                    return false;
+                cp = (cp << 6) | (p[i] & 0x3f);
+            }
+            p += n;
+
+            // overlong encodings, surrogates and code points beyond unicode
+            if ((n == 2 && (cp < 0x800 || (cp >= 0xd800 && cp <= 0xdfff)))
+                || (n == 3 && (cp < 0x10000 || cp > 0x10ffff)))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool validCloseCode(unsigned code)
+    {
+        return (code >= 1000 && code <= 1003)
+            || (code >= 1007 && code <= 1011)
+            || (code >= 3000 && code <= 4999);
+    }
+}
+
+WebSocketConnection::WebSocketConnection(Handler& handler, std::string& out, std::size_t maxMessageSize)
+    : _handler(handler),
+      _out(out),
+      _maxMessageSize(maxMessageSize),
+      _headerSize(0),
+      _inPayload(false),
+      _opcode(0),
+      _fin(false),
+      _maskOffset(0),
+      _remaining(0),
+      _messageOpcode(0),
+      _messageCompressed(false),
+      _closeReceived(false),
+      _failed(false),
+      _closeCode(NoStatus),
+      _closeSent(false),
+      _deflateBits(0),
+      _deflater(0),
+      _inflater(0)
+{
+}
+
+WebSocketConnection::~WebSocketConnection()
+{
+#ifdef HAVE_ZLIB
+    if (_deflater)
+    {
+        deflateEnd(_deflater);
+        delete _deflater;
+    }
+
+    if (_inflater)
+    {
+        inflateEnd(_inflater);
+        delete _inflater;
+    }
+#endif
+}
+
+void WebSocketConnection::deflate(unsigned windowBits)
+{
+#ifdef HAVE_ZLIB
+    _deflateBits = windowBits;
+#endif
+}
+
+void WebSocketConnection::process(const char* data, std::size_t size)
+{
+    try
+    {
+        while (!_closeReceived && !_failed)
+        {
+            if (!_inPayload)
+            {
+                if (size == 0)
+                    break;
+
+                std::size_t n = processHeader(data, size);
+                data += n;
+                size -= n;
+
+                if (!_inPayload)
+                    break;
+            }
+
+            if (_remaining > 0)
+            {
+                if (size == 0)
+                    break;
+
+                std::size_t n = static_cast<std::size_t>(std::min(static_cast<unsigned long long>(size), _remaining));
+                std::string& target = (_opcode & 0x8) ? _control : _message;
+                std::size_t offset = target.size();
+                target.append(data, n);
+                for (std::size_t i = offset; i < target.size(); ++i)
+                    target[i] ^= _mask[_maskOffset++ & 3];
+
+                data += n;
+                size -= n;
+                _remaining -= n;
+            }
+
+            if (_remaining == 0)
+            {
+                _inPayload = false;
+                processFrame();
+            }
+        }
+    }
+    catch (const WebSocketError& e)
+    {
+        log_warn("websocket error " << e.code() << ": " << e.what());
+        _failed = true;
+        _closeCode = e.code();
+        _handler.onClose(e.code(), e.what());
+    }
+}
+
+std::size_t WebSocketConnection::processHeader(const char* data, std::size_t size)
+{
+    std::size_t consumed = 0;
+    while (consumed < size && _headerSize < 2)
+        _header[_headerSize++] = static_cast<unsigned char>(data[consumed++]);
+
+    if (_headerSize < 2)
+        return consumed;
+
+    if (!(_header[1] & 0x80))
+        throw WebSocketError(ProtocolError, "frame from client is not masked");
+
+    unsigned len7 = _header[1] & 0x7f;
+    std::size_t headerSize = 2 + (len7 == 126 ? 2 : len7 == 127 ? 8 : 0) + 4;
+
+    std::size_t n = std::min(size - consumed, headerSize - _headerSize);
+    std::memcpy(_header + _headerSize, data + consumed, n);
+    _headerSize += n;
+    consumed += n;
+
+    if (_headerSize < headerSize)
+        return consumed;
+
+    _headerSize = 0;
+
+    _fin = (_header[0] & 0x80) != 0;
+    bool rsv1 = (_header[0] & 0x40) != 0;
+    _opcode = _header[0] & 0x0f;
+
+    if (_header[0] & 0x30)
+        throw WebSocketError(ProtocolError, "reserved bits set");
+
+    const unsigned char* p = _header + 2;
+    unsigned long long length = len7;
+    if (len7 == 126)
+    {
+        length = (static_cast<unsigned>(p[0]) << 8) | p[1];
+        p += 2;
+    }
+    else if (len7 == 127)
+    {
+        length = 0;
+        for (unsigned i = 0; i < 8; ++i)
+            length = (length << 8) | p[i];
+        p += 8;
+
+        if (length >> 63)
+            throw WebSocketError(ProtocolError, "invalid frame length");
+    }
+
+    std::memcpy(_mask, p, 4);
+    _maskOffset = 0;
+
+    log_debug("frame opcode " << static_cast<unsigned>(_opcode) << " fin " << _fin << " rsv1 " << rsv1 << " length " << length);
+
+    if (_opcode & 0x8)
+    {
+        if (_opcode != Close && _opcode != Ping && _opcode != Pong)
+            throw WebSocketError(ProtocolError, "unknown opcode");
+        if (!_fin)
+            throw WebSocketError(ProtocolError, "fragmented control frame");
+        if (length > 125)
+            throw WebSocketError(ProtocolError, "control frame too large");
+        if (rsv1)
+            throw WebSocketError(ProtocolError, "reserved bits set");
+
+        _control.clear();
+    }
+    else
+    {
+        if (_opcode == Continuation)
+        {
+            if (_messageOpcode == 0)
+                throw WebSocketError(ProtocolError, "unexpected continuation frame");
+            if (rsv1)
+                throw WebSocketError(ProtocolError, "reserved bits set");
+        }
+        else if (_opcode == Text || _opcode == Binary)
+        {
+            if (_messageOpcode != 0)
+                throw WebSocketError(ProtocolError, "continuation frame expected");
+            if (rsv1 && !deflate())
+                throw WebSocketError(ProtocolError, "reserved bits set");
+
+            _messageOpcode = _opcode;
+            _messageCompressed = rsv1;
+            _message.clear();
+        }
+        else
+            throw WebSocketError(ProtocolError, "unknown opcode");
+
+        if (length > _maxMessageSize - _message.size())
+            throw WebSocketError(MessageTooBig, "message too big");
+    }
+
+    _remaining = length;
+    _inPayload = true;
+
+    return consumed;
+}
+
+void WebSocketConnection::processFrame()
+{
+    switch (_opcode)
+    {
+        case Close:
+            processClose();
+            break;
+
+        case Ping:
+            _handler.onPing(_control);
+            break;
+
+        case Pong:
+            _handler.onPong(_control);
+            break;
+
+        default:
+            if (!_fin)
+                break;
+
+            bool binary = _messageOpcode == Binary;
+            if (_messageCompressed)
+                inflateMessage();
+
+            _messageOpcode = 0;
+
+            if (!binary && !validUtf8(_message.data(), _message.size()))
+                throw WebSocketError(InvalidPayload, "invalid utf-8 in text message");
+
+            _handler.onMessage(binary, _message);
+
+            // do not keep the buffer of a large message on an idle connection
+            if (_message.capacity() > 65536)
+                std::string().swap(_message);
+            else
+                _message.clear();
+    }
+}
+
+void WebSocketConnection::processClose()
+{
+    unsigned short code = NoStatus;
+    std::string reason;
+
+    if (_control.size() == 1)
+        throw WebSocketError(ProtocolError, "invalid close frame");
+
+    if (_control.size() >= 2)
+    {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(_control.data());
+        code = static_cast<unsigned short>((p[0] << 8) | p[1]);
+        if (!validCloseCode(code))
+            throw WebSocketError(ProtocolError, "invalid close code");
+
+        reason = _control.substr(2);
+        if (!validUtf8(reason.data(), reason.size()))
+            throw WebSocketError(InvalidPayload, "invalid utf-8 in close reason");
+    }
+
+    log_debug("close frame received; code " << code);
+
+    _closeReceived = true;
+    _closeCode = code;
+    _handler.onClose(code, reason);
+}
+
+bool WebSocketConnection::send(Opcode opcode, const char* data, std::size_t size)
+{
+    if (_closeSent)
+        return false;
+
+    unsigned char first = 0x80 | opcode;
+
+    if (deflate() && size >= minDeflateSize && (opcode == Text || opcode == Binary))
+    {
+        std::string compressed;
+        if (deflateMessage(data, size, compressed))
+        {
+            writeFrame(first | 0x40, compressed.data(), compressed.size());
+            return true;
+        }
+    }
+
+    writeFrame(first, data, size);
+    return true;
+}
+
+bool WebSocketConnection::ping(const std::string& payload)
+{
+    if (payload.size() > 125)
+        throw std::invalid_argument("websocket ping payload exceeds 125 bytes");
+
+    if (_closeSent)
+        return false;
+
+    writeFrame(0x80 | Ping, payload.data(), payload.size());
+    return true;
+}
+
+bool WebSocketConnection::pong(const std::string& payload)
+{
+    if (_closeSent)
+        return false;
+
+    writeFrame(0x80 | Pong, payload.data(), payload.size());
+    return true;
+}
+
+void WebSocketConnection::close(unsigned short code, const std::string& reason)
+{
+    if (_closeSent)
+        return;
+
+    log_debug("send close frame; code " << code);
+
+    std::string payload;
+    if (code != NoStatus)
+    {
+        payload += static_cast<char>(code >> 8);
+        payload += static_cast<char>(code);
+        payload.append(reason, 0, 123);
+    }
+
+    writeFrame(0x80 | Close, payload.data(), payload.size());
+    _closeSent = true;
+}
+
+void WebSocketConnection::writeFrame(unsigned char first, const char* data, std::size_t size)
+{
+    _out += static_cast<char>(first);
+
+    if (size < 126)
+    {
+        _out += static_cast<char>(size);
+    }
+    else if (size <= 0xffff)
+    {
+        _out += static_cast<char>(126);
+        _out += static_cast<char>(size >> 8);
+        _out += static_cast<char>(size);
+    }
+    else
+    {
+        _out += static_cast<char>(127);
+        unsigned long long s = size;
+        for (int i = 7; i >= 0; --i)
+            _out += static_cast<char>(s >> (i * 8));
+    }
+
+    _out.append(data, size);
+}
+
+void WebSocketConnection::inflateMessage()
+{
+#ifdef HAVE_ZLIB
+    if (!_inflater)
+    {
+        _inflater = new z_stream();
+        if (inflateInit2(_inflater, -15) != Z_OK)
+        {
+            delete _inflater;
+            _inflater = 0;
+            throw WebSocketError(InternalError, "failed to initialize zlib");
+        }
+    }
+
+    // the sender removed the tail of the flushed deflate block
+    _message.append("\x00\x00\xff\xff", 4);
+
+    _inflater->next_in = reinterpret_cast<Bytef*>(&_message[0]);
+    _inflater->avail_in = static_cast<uInt>(_message.size());
+
+    std::string result(std::max(_message.size() * 3, static_cast<std::size_t>(256)), '\0');
+    std::size_t out = 0;
+    while (true)
+    {
+        if (out == result.size())
+        {
+            if (out > _maxMessageSize)
+                break;
+            result.resize(result.size() * 2);
+        }
+
+        _inflater->next_out = reinterpret_cast<Bytef*>(&result[out]);
+        _inflater->avail_out = static_cast<uInt>(result.size() - out);
+
+        int ret = ::inflate(_inflater, Z_SYNC_FLUSH);
+        out = result.size() - _inflater->avail_out;
+
+        if (ret == Z_STREAM_END)
+            break;
+
+        if (ret != Z_OK && ret != Z_BUF_ERROR)
+        {
+            inflateReset(_inflater);
+            throw WebSocketError(InvalidPayload, "invalid compressed message");
+        }
+
+        if (_inflater->avail_in == 0 && _inflater->avail_out > 0)
+            break;
+    }
+
+    // we negotiated client_no_context_takeover
+    inflateReset(_inflater);
+
+    if (out > _maxMessageSize)
+        throw WebSocketError(MessageTooBig, "message too big");
+
+    result.resize(out);
+    _message.swap(result);
+#endif
+}
+
+bool WebSocketConnection::deflateMessage(const char* data, std::size_t size, std::string& result)
+{
+#ifdef HAVE_ZLIB
+    if (!_deflater)
+    {
+        _deflater = new z_stream();
+        if (deflateInit2(_deflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                -static_cast<int>(_deflateBits), 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            log_error("failed to initialize zlib; send messages uncompressed");
+            delete _deflater;
+            _deflater = 0;
+            _deflateBits = 0;
+            return false;
+        }
+    }
+
+    _deflater->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    _deflater->avail_in = static_cast<uInt>(size);
+
+    result.resize(size / 2 + 64);
+    std::size_t out = 0;
+    int ret;
+    do
+    {
+        if (out == result.size())
+            result.resize(result.size() * 2);
+
+        _deflater->next_out = reinterpret_cast<Bytef*>(&result[out]);
+        _deflater->avail_out = static_cast<uInt>(result.size() - out);
+
+        ret = ::deflate(_deflater, Z_SYNC_FLUSH);
+        out = result.size() - _deflater->avail_out;
+    } while (ret == Z_OK && _deflater->avail_out == 0);
+
+    // we negotiated server_no_context_takeover
+    deflateReset(_deflater);
+
+    if (ret != Z_OK || out < 4)
+        return false;
+
+    // the flushed block ends with 00 00 ff ff, which is not sent
+    result.resize(out - 4);
+    return true;
+#else
+    return false;
+#endif
+}
+
+}
+}
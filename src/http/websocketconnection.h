@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_HTTP_WEBSOCKETCONNECTION_H
+#define CXXTOOLS_HTTP_WEBSOCKETCONNECTION_H
+
+#include <string>
+#include <stdexcept>
+
+struct z_stream_s;
+
+namespace cxxtools
+{
+namespace http
+{
+
+/// A websocket protocol error with the status code sent in the close frame.
+class WebSocketError : public std::runtime_error
+{
+        unsigned short _code;
+
+    public:
+        WebSocketError(unsigned short code, const std::string& msg)
+            : std::runtime_error(msg),
+              _code(code)
+            { }
+
+        unsigned short code() const  { return _code; }
+};
+
+/**
+ Protocol engine of the server side of a websocket connection (RFC 6455).
+
+ The class does no I/O itself. Received data is passed to process(), which
+ unmasks the frames, reassembles fragmented messages and reports messages
+ and control frames to the Handler. Frames to send are appended to the
+ output string passed to the constructor.
+
+ Receiving and sending use separate state, so that process() and the send
+ methods may be called by different threads as long as each side is
+ serialized.
+
+ When permessage-deflate (RFC 7692) is enabled, both sides reset the
+ compression context after each message, so that an idle connection does
+ not keep a compression window.
+ */
+class WebSocketConnection
+{
+        WebSocketConnection(const WebSocketConnection&) = delete;
+        WebSocketConnection& operator=(const WebSocketConnection&) = delete;
+
+    public:
+        enum Opcode
+        {
+            Continuation = 0x0,
+            Text = 0x1,
+            Binary = 0x2,
+            Close = 0x8,
+            Ping = 0x9,
+            Pong = 0xa
+        };
+
+        enum CloseCode
+        {
+            NormalClosure = 1000,
+            GoingAway = 1001,
+            ProtocolError = 1002,
+            UnsupportedData = 1003,
+            NoStatus = 1005,
+            AbnormalClosure = 1006,
+            InvalidPayload = 1007,
+            PolicyViolation = 1008,
+            MessageTooBig = 1009,
+            InternalError = 1011
+        };
+
+        class Handler
+        {
+            public:
+                /// A complete message is received; the handler may take the content.
+                virtual void onMessage(bool binary, std::string& message) = 0;
+                virtual void onPing(const std::string& payload) = 0;
+                virtual void onPong(const std::string& payload) = 0;
+
+                /// The peer sent a close frame or violated the protocol.
+                virtual void onClose(unsigned short code, const std::string& reason) = 0;
+
+            protected:
+                ~Handler() { }
+        };
+
+        WebSocketConnection(Handler& handler, std::string& out, std::size_t maxMessageSize);
+        ~WebSocketConnection();
+
+        /// Enables permessage-deflate with the window size used for sending.
+        void deflate(unsigned windowBits);
+        bool deflate() const        { return _deflateBits != 0; }
+
+        void process(const char* data, std::size_t size);
+
+        /// Sends a message as a single frame. Returns false when the close frame is sent already.
+        bool send(Opcode opcode, const char* data, std::size_t size);
+        bool ping(const std::string& payload);
+        bool pong(const std::string& payload);
+
+        /// Sends a close frame; NoStatus sends a close frame without status code.
+        void close(unsigned short code, const std::string& reason = std::string());
+
+        bool closeSent() const      { return _closeSent; }
+        bool closeReceived() const  { return _closeReceived; }
+        bool failed() const         { return _failed; }
+
+        /// Returns the status code of the close frame received or the error.
+        unsigned short closeCode() const { return _closeCode; }
+
+        /// Returns true, when the tcp connection should be closed after sending the output.
+        bool finished() const       { return _closeSent && (_closeReceived || _failed); }
+
+    private:
+        std::size_t processHeader(const char* data, std::size_t size);
+        void processFrame();
+        void processClose();
+        void writeFrame(unsigned char first, const char* data, std::size_t size);
+        void inflateMessage();
+        bool deflateMessage(const char* data, std::size_t size, std::string& result);
+
+        Handler& _handler;
+        std::string& _out;
+        std::size_t _maxMessageSize;
+
+        // receiving
+        unsigned char _header[14];
+        std::size_t _headerSize;
+        bool _inPayload;
+        unsigned char _opcode;
+        bool _fin;
+        unsigned char _mask[4];
+        unsigned _maskOffset;
+        unsigned long long _remaining;
+
+        unsigned char _messageOpcode;   // opcode of the message in progress or 0
+        bool _messageCompressed;
+        std::string _message;
+        std::string _control;
+        bool _closeReceived;
+        bool _failed;
+        unsigned short _closeCode;
+
+        // sending
+        bool _closeSent;
+
+        unsigned _deflateBits;
+        z_stream_s* _deflater;
+        z_stream_s* _inflater;
+};
+
+}
+}
+
+#endif // CXXTOOLS_HTTP_WEBSOCKETCONNECTION_H
@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "websocketimpl.h"
+#include "serverimpl.h"
+#include "socket.h"
+#include <cxxtools/http/websocketservice.h>
+#include <cxxtools/log.h>
+
+log_define("cxxtools.http.websocket")
+
+namespace cxxtools
+{
+namespace http
+{
+
+WebSocketImpl::WebSocketImpl(ServerImpl& server, Socket& socket, WebSocketService& service,
+        const Request& request, const std::string& protocol, unsigned deflateBits)
+    : DetachedConnection(server, socket),
+      _service(service),
+      _protocol(protocol),
+      _webSocket(this),
+      _connection(*this, _output, service.maxMessageSize()),
+      _closing(false),
+      _closeCode(WebSocketConnection::AbnormalClosure)
+{
+    // the request object is not copyable; the body of a handshake is empty
+    _request.header() = request.header();
+    _request._pathParams = request._pathParams;
+
+    if (deflateBits)
+        _connection.deflate(deflateBits);
+
+    cxxtools::connect(_timer.timeout, *this, &WebSocketImpl::onTimeout);
+}
+
+void WebSocketImpl::onStart(StreamBuffer& sb)
+{
+    _socket.selector()->add(_timer);
+
+    log_info("websocket connection " << _request.url() << " from client " << peerAddr()
+        << (compressed() ? " with permessage-deflate" : ""));
+
+    try
+    {
+        _service.connected(_webSocket);
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("websocket handler failed: " << e.what());
+        std::lock_guard<std::mutex> lock(_mutex);
+        _connection.close(WebSocketConnection::InternalError);
+    }
+
+    // frames received together with the handshake
+    if (sb.in_avail() > 0)
+    {
+        std::size_t n = sb.in_avail();
+        _connection.process(sb.inputBegin(), n);
+        sb.inputConsume(n);
+    }
+
+    if (!_connection.closeReceived() && !_connection.failed())
+        sb.beginRead();
+}
+
+void WebSocketImpl::onInput(StreamBuffer& sb)
+{
+    bool eof;
+    try
+    {
+        sb.endRead();
+        eof = sb.in_avail() == 0 || sb.device()->eof();
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("failed to read from websocket client " << peerAddr() << ": " << e.what());
+        finish(WebSocketConnection::AbnormalClosure);
+        return;
+    }
+
+    // the event loop has not taken over the connection yet
+    if (!started())
+        return;
+
+    std::size_t n = sb.in_avail();
+    if (n > 0)
+    {
+        _connection.process(sb.inputBegin(), n);
+        sb.inputConsume(n);
+    }
+
+    if (eof)
+    {
+        log_debug("websocket client " << peerAddr() << " closed connection");
+        finish(_connection.closeReceived() ? _connection.closeCode()
+                                           : static_cast<unsigned short>(WebSocketConnection::AbnormalClosure));
+        return;
+    }
+
+    flush();
+
+    if (!released() && !_connection.closeReceived() && !_connection.failed())
+        sb.beginRead();
+}
+
+void WebSocketImpl::flush()
+{
+    DetachedConnection::flush();
+
+    if (released())
+        return;
+
+    // wait for the close frame of the peer only until the write timeout
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_connection.closeSent() && !_closing)
+    {
+        _closing = true;
+        _timer.after(_server.writeTimeout());
+    }
+}
+
+void WebSocketImpl::shutdown()
+{
+    if (released())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _connection.close(WebSocketConnection::GoingAway);
+    }
+
+    DetachedConnection::flush();
+    finish(WebSocketConnection::GoingAway);
+}
+
+void WebSocketImpl::send(WebSocketConnection::Opcode opcode, const char* data, std::size_t size)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_connection.send(opcode, data, size))
+        {
+            log_debug("websocket is closing; message discarded");
+            return;
+        }
+    }
+
+    output();
+}
+
+void WebSocketImpl::ping(const std::string& payload)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_connection.ping(payload))
+            return;
+    }
+
+    output();
+}
+
+void WebSocketImpl::close(unsigned short code, const std::string& reason)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_connection.closeSent())
+            return;
+        _connection.close(code, reason);
+    }
+
+    output();
+}
+
+bool WebSocketImpl::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return !released() && !_connection.closeSent();
+}
+
+void WebSocketImpl::onMessage(bool binary, std::string& message)
+{
+    try
+    {
+        if (binary)
+            _webSocket.binaryReceived(_webSocket, message);
+        else
+            _webSocket.textReceived(_webSocket, message);
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("websocket handler failed: " << e.what());
+        std::lock_guard<std::mutex> lock(_mutex);
+        _connection.close(WebSocketConnection::InternalError);
+    }
+}
+
+void WebSocketImpl::onPing(const std::string& payload)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _connection.pong(payload);
+}
+
+void WebSocketImpl::onPong(const std::string& payload)
+{
+    try
+    {
+        _webSocket.pongReceived(_webSocket, payload);
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("websocket handler failed: " << e.what());
+    }
+}
+
+void WebSocketImpl::onClose(unsigned short code, const std::string& /*reason*/)
+{
+    // answer the close frame of the peer or report the protocol error
+    std::lock_guard<std::mutex> lock(_mutex);
+    _connection.close(code);
+}
+
+void WebSocketImpl::finish(unsigned short code)
+{
+    if (released())
+        return;
+
+    _closeCode = code;
+    release(true);
+}
+
+void WebSocketImpl::onEnd()
+{
+    finish(_connection.closeCode());
+}
+
+void WebSocketImpl::onRelease()
+{
+    _timer.stop();
+
+    log_info("websocket connection from client " << peerAddr() << " closed with code " << _closeCode);
+
+    try
+    {
+        _webSocket.closed(_webSocket, _closeCode);
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("websocket handler failed: " << e.what());
+    }
+}
+
+void WebSocketImpl::onTimeout()
+{
+    log_warn("websocket client " << peerAddr() << " did not finish closing handshake");
+    finish(WebSocketConnection::AbnormalClosure);
+}
+
+}
+}
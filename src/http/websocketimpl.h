@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef CXXTOOLS_HTTP_WEBSOCKETIMPL_H
+#define CXXTOOLS_HTTP_WEBSOCKETIMPL_H
+
+#include "websocketconnection.h"
+#include "detachedconnection.h"
+#include <cxxtools/http/websocket.h>
+#include <cxxtools/http/request.h>
+#include <cxxtools/timer.h>
+#include <string>
+
+namespace cxxtools
+{
+namespace http
+{
+
+class WebSocketService;
+
+/**
+ Server side of an upgraded websocket connection.
+
+ The handshake reply is sent by the worker, which processed the request.
+ After that the event loop of the server runs the connection.
+ */
+class WebSocketImpl : public DetachedConnection, private WebSocketConnection::Handler
+{
+    public:
+        WebSocketImpl(ServerImpl& server, Socket& socket, WebSocketService& service,
+            const Request& request, const std::string& protocol, unsigned deflateBits);
+
+        WebSocket& webSocket()               { return _webSocket; }
+
+        // called in the thread of the event loop
+        void onInput(StreamBuffer& sb) override;
+        void flush() override;
+        void shutdown() override;
+
+        // interface of WebSocket
+        const Request& request() const       { return _request; }
+        const std::string& protocol() const  { return _protocol; }
+        bool compressed() const              { return _connection.deflate(); }
+        void send(WebSocketConnection::Opcode opcode, const char* data, std::size_t size);
+        void ping(const std::string& payload);
+        void close(unsigned short code, const std::string& reason);
+        bool isOpen() const;
+
+    protected:
+        void onStart(StreamBuffer& sb) override;
+        bool ending() const override         { return _connection.finished(); }
+        void onEnd() override;
+        void onRelease() override;
+
+    private:
+        void onMessage(bool binary, std::string& message);
+        void onPing(const std::string& payload);
+        void onPong(const std::string& payload);
+        void onClose(unsigned short code, const std::string& reason);
+
+        void finish(unsigned short code);
+        void onTimeout();
+
+        WebSocketService& _service;
+        Request _request;
+        std::string _protocol;
+        WebSocket _webSocket;
+
+        // the sending side is guarded by the mutex of the base class
+        WebSocketConnection _connection;
+
+        Timer _timer;
+        bool _closing;
+        unsigned short _closeCode;
+};
+
+}
+}
+
+#endif // CXXTOOLS_HTTP_WEBSOCKETIMPL_H
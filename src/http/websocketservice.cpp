@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+
+#include <cxxtools/http/websocketservice.h>
+#include <cxxtools/http/responder.h>
+#include <cxxtools/http/request.h>
+#include <cxxtools/http/reply.h>
+#include <cxxtools/base64codec.h>
+#include <cxxtools/convert.h>
+#include <cxxtools/log.h>
+#include "socket.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <strings.h>
+#include <stdint.h>
+#include "config.h"
+
+log_define("cxxtools.http.websocket")
+
+namespace cxxtools
+{
+
+namespace http
+{
+
+namespace
+{
+    const char webSocketGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+    uint32_t rol(uint32_t v, unsigned n)
+    {
+        return (v << n) | (v >> (32 - n));
+    }
+
+    // SHA-1 is needed for Sec-WebSocket-Accept only
+    std::string sha1(const std::string& data)
+    {
+        uint32_t h[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+
+        std::string msg = data;
+        msg += '\x80';
+        while (msg.size() % 64 != 56)
+            msg += '\0';
+
+        uint64_t bits = static_cast<uint64_t>(data.size()) * 8;
+        for (int i = 7; i >= 0; --i)
+            msg += static_cast<char>(bits >> (i * 8));
+
+        for (std::size_t offset = 0; offset < msg.size(); offset += 64)
+        {
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(msg.data() + offset);
+
+            uint32_t w[80];
+            for (unsigned i = 0; i < 16; ++i)
+                w[i] = (static_cast<uint32_t>(p[i * 4]) << 24) | (static_cast<uint32_t>(p[i * 4 + 1]) << 16)
+                     | (static_cast<uint32_t>(p[i * 4 + 2]) << 8) | p[i * 4 + 3];
+            for (unsigned i = 16; i < 80; ++i)
+                w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+            uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+            for (unsigned i = 0; i < 80; ++i)
+            {
+                uint32_t f, k;
+                if (i < 20)
+                {
+                    f = (b & c) | (~b & d);
+                    k = 0x5a827999;
+                }
+                else if (i < 40)
+                {
+                    f = b ^ c ^ d;
+                    k = 0x6ed9eba1;
+                }
+                else if (i < 60)
+                {
+                    f = (b & c) | (b & d) | (c & d);
+                    k = 0x8f1bbcdc;
+                }
+                else
+                {
+                    f = b ^ c ^ d;
+                    k = 0xca62c1d6;
+                }
+
+                uint32_t t = rol(a, 5) + f + e + k + w[i];
+                e = d;
+                d = c;
+                c = rol(b, 30);
+                b = a;
+                a = t;
+            }
+
+            h[0] += a;
+            h[1] += b;
+            h[2] += c;
+            h[3] += d;
+            h[4] += e;
+        }
+
+        std::string result;
+        for (unsigned i = 0; i < 5; ++i)
+            for (int s = 24; s >= 0; s -= 8)
+                result += static_cast<char>(h[i] >> s);
+
+        return result;
+    }
+
+    std::string trim(const std::string& s)
+    {
+        std::string::size_type b = s.find_first_not_of(" \t");
+        if (b == std::string::npos)
+            return std::string();
+        std::string::size_type e = s.find_last_not_of(" \t");
+        return s.substr(b, e - b + 1);
+    }
+
+    std::vector<std::string> splitList(const char* value, char sep)
+    {
+        std::vector<std::string> result;
+        if (value == 0)
+            return result;
+
+        const char* b = value;
+        while (true)
+        {
+            const char* e = std::strchr(b, sep);
+            std::string token = trim(e ? std::string(b, e) : std::string(b));
+            if (!token.empty())
+                result.push_back(token);
+            if (e == 0)
+                break;
+            b = e + 1;
+        }
+
+        return result;
+    }
+
+    bool hasToken(const char* value, const char* token)
+    {
+        std::vector<std::string> tokens = splitList(value, ',');
+        for (std::vector<std::string>::const_iterator it = tokens.begin(); it != tokens.end(); ++it)
+            if (::strcasecmp(it->c_str(), token) == 0)
+                return true;
+        return false;
+    }
+
+#ifdef HAVE_ZLIB
+    // Returns the value of a window bits parameter or 0 when it is invalid.
+    unsigned windowBits(const std::string& value)
+    {
+        if (value.empty() || value.size() > 2 || value.find_first_not_of("0123456789") != std::string::npos)
+            return 0;
+        unsigned bits = std::atoi(value.c_str());
+        return bits >= 8 && bits <= 15 ? bits : 0;
+    }
+
+    // Accepts the first valid permessage-deflate offer. Both sides reset the
+    // compression context after each message. Returns the window bits for
+    // sending or 0 when no offer is accepted.
+    unsigned negotiateDeflate(const char* extensions, std::string& response)
+    {
+        std::vector<std::string> offers = splitList(extensions, ',');
+        for (std::vector<std::string>::const_iterator it = offers.begin(); it != offers.end(); ++it)
+        {
+            std::vector<std::string> params = splitList(it->c_str(), ';');
+            if (params.empty() || params[0] != "permessage-deflate")
+                continue;
+
+            bool valid = true;
+            unsigned serverBits = 0;
+            for (std::size_t i = 1; valid && i < params.size(); ++i)
+            {
+                std::string name = params[i];
+                std::string value;
+                std::string::size_type eq = name.find('=');
+                if (eq != std::string::npos)
+                {
+                    value = trim(name.substr(eq + 1));
+                    name = trim(name.substr(0, eq));
+                    if (value.size() >= 2 && value[0] == '"' && value[value.size() - 1] == '"')
+                        value = value.substr(1, value.size() - 2);
+                }
+
+                if (name == "server_no_context_takeover" || name == "client_no_context_takeover")
+                    valid = value.empty();
+                else if (name == "server_max_window_bits")
+                {
+                    // zlib does not support a raw deflate window of 8 bits
+                    serverBits = windowBits(value);
+                    valid = serverBits >= 9;
+                }
+                else if (name == "client_max_window_bits")
+                    valid = value.empty() || windowBits(value) >= 8;
+                else
+                    valid = false;
+            }
+
+            if (!valid)
+                continue;
+
+            response = "permessage-deflate; server_no_context_takeover; client_no_context_takeover";
+            if (serverBits)
+            {
+                response += "; server_max_window_bits=" + convert<std::string>(serverBits);
+            }
+            else
+                serverBits = 15;
+
+            return serverBits;
+        }
+
+        return 0;
+    }
+#endif
+
+    class WebSocketResponder : public Responder
+    {
+            WebSocketService& _service;
+            Socket* _socket;
+
+        public:
+            explicit WebSocketResponder(WebSocketService& service)
+                : Responder(service),
+                  _service(service),
+                  _socket(0)
+                { }
+
+            void beginRequest(net::TcpSocket& socket, std::istream& in, Request& request);
+            void reply(std::ostream& out, Request& request, Reply& reply);
+    };
+
+    void WebSocketResponder::beginRequest(net::TcpSocket& socket, std::istream& in, Request& request)
+    {
+        _socket = dynamic_cast<Socket*>(&socket);
+        Responder::beginRequest(socket, in, request);
+    }
+
+    void WebSocketResponder::reply(std::ostream& out, Request& request, Reply& reply)
+    {
+        const RequestHeader& header = request.header();
+
+        if (request.method() != "GET")
+        {
+            reply.httpReturn(405, "Method Not Allowed");
+            reply.setHeader("Allow", "GET");
+            out << "websocket handshake requires GET";
+            return;
+        }
+
+        if (!hasToken(header.getHeader(MessageHeader::Upgrade), "websocket")
+            || !hasToken(header.getHeader(MessageHeader::Connection), "upgrade"))
+        {
+            reply.httpReturn(426, "Upgrade Required");
+            reply.setHeader("Upgrade", "websocket");
+            reply.setHeader("Sec-WebSocket-Version", "13");
+            out << "websocket upgrade required";
+            return;
+        }
+
+        if (!header.isHeaderValue("Sec-WebSocket-Version", "13"))
+        {
+            reply.httpReturn(426, "Upgrade Required");
+            reply.setHeader("Sec-WebSocket-Version", "13");
+            out << "unsupported websocket version";
+            return;
+        }
+
+        const char* key = header.getHeader("Sec-WebSocket-Key");
+        std::string nonce;
+        if (key)
+        {
+            try
+            {
+                nonce = Base64Codec::decode(key, std::strlen(key));
+            }
+            catch (const std::exception&)
+            {
+            }
+        }
+
+        if (nonce.size() != 16 || _socket == 0
+            || header.httpVersionMajor() != 1 || header.httpVersionMinor() < 1)
+        {
+            reply.httpReturn(400, "Bad Request");
+            out << "invalid websocket handshake";
+            return;
+        }
+
+        std::string protocol;
+        std::vector<std::string> offered = splitList(header.getHeader("Sec-WebSocket-Protocol"), ',');
+        for (std::vector<std::string>::const_iterator it = offered.begin(); protocol.empty() && it != offered.end(); ++it)
+            if (std::find(_service.protocols().begin(), _service.protocols().end(), *it) != _service.protocols().end())
+                protocol = *it;
+
+        unsigned deflateBits = 0;
+        std::string extensions;
+#ifdef HAVE_ZLIB
+        if (_service.deflate())
+            deflateBits = negotiateDeflate(header.getHeader("Sec-WebSocket-Extensions"), extensions);
+#endif
+
+        std::string accept = sha1(std::string(key) + webSocketGuid);
+
+        reply.httpReturn(101, "Switching Protocols");
+        reply.setHeader("Upgrade", "websocket");
+        reply.setHeader("Connection", "Upgrade");
+        reply.setHeader("Sec-WebSocket-Accept", Base64Codec::encode(accept.data(), accept.size()).c_str());
+        if (!protocol.empty())
+            reply.setHeader("Sec-WebSocket-Protocol", protocol.c_str());
+        if (!extensions.empty())
+            reply.setHeader("Sec-WebSocket-Extensions", extensions.c_str());
+
+        _socket->upgradeWebSocket(_service, protocol, deflateBits);
+    }
+}
+
+Responder* WebSocketService::createResponder(const Request&)
+{
+    return new WebSocketResponder(*this);
+}
+
+void WebSocketService::releaseResponder(Responder* responder)
+{
+    delete responder;
+}
+
+} // namespace http
+
+} // namespace cxxtools
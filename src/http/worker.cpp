@@ -50,9 +50,15 @@ Worker::Worker(ServerImpl& server)
 void Worker::run()
 {
     log_info("new thread running");
+    SocketQueue::Sockets expired;
+
     while (!_server.isTerminating() && _server._queue.numWaiting() < _server.minThreads())
     {
-        Socket* socket = _server._queue.get();
+        SocketQueue::Job job;
+        Socket* socket = _server._queue.get(expired, job);
+
+        // requests, which waited too long, are answered with 503
+        _server.reject(expired);
 
         if (_server.isTerminating())
         {
@@ -61,9 +67,26 @@ void Worker::run()
             break;
         }
 
+        if (socket == 0 && !job)
+            continue;
+
         if (_server._queue.numWaiting() == 0)
             _server.noWaitingThreads();
 
+        if (job)
+        {
+            try
+            {
+                job();
+            }
+            catch (const std::exception& e)
+            {
+                log_warn("job failed: " << e.what());
+            }
+
+            continue;
+        }
+
         try
         {
             if (!socket->hasAccepted())
@@ -86,6 +109,14 @@ void Worker::run()
                     _server._queue.put(new Socket(*socket));
 
                     socket->postAccept();
+
+                    // A new connection does not overtake waiting requests;
+                    // its request is queued by the idle connections.
+                    if (_server._queue.requests() > 0)
+                    {
+                        _server.addIdleSocket(socket);
+                        continue;
+                    }
                 }
                 catch (const std::exception&)
                 {
@@ -108,14 +139,20 @@ void Worker::run()
 
             Connection inputConnection = socket->buffer().inputReady.connect(socket->inputSlot);
 
-            while (socket->wait(10) && socket->isConnected())
+            // Wait for further requests on the socket unless other requests
+            // are waiting for a thread; they are served first. A http/2
+            // connection is passed to the event loop at once.
+            while (!socket->isHttp2() && _server._queue.requests() == 0 && socket->wait(10) && socket->isConnected())
                 ;
 
             if (socket->isConnected())
             {
                 log_debug("timeout processing socket");
                 inputConnection.close();
-                _server.addIdleSocket(socket);
+                if (socket->isDetached())
+                    _server.addDetachedSocket(socket);
+                else
+                    _server.addIdleSocket(socket);
             }
             else if (_server.isTerminating())
             {
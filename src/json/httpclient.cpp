@@ -197,6 +197,22 @@ void HttpClient::cancel()
         _impl->cancel();
 }
 
+void HttpClient::cancelCall(const IRemoteProcedure& proc)
+{
+    if (_impl)
+        _impl->cancelCall(proc);
+}
+
+void HttpClient::beginBatch()
+{
+    getImpl()->beginBatch();
+}
+
+void HttpClient::endBatch()
+{
+    getImpl()->endBatch();
+}
+
 void HttpClient::wait(Milliseconds msecs)
 {
     _impl->wait(msecs);
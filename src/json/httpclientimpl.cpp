@@ -34,9 +34,11 @@
 #include "cxxtools/ioerror.h"
 #include "cxxtools/clock.h"
 #include "cxxtools/resetter.h"
+#include "cxxtools/rpccontext.h"
 #include "cxxtools/log.h"
 
 #include <stdexcept>
+#include <vector>
 #include <strings.h>
 
 log_define("cxxtools.json.httpclient.impl")
@@ -53,7 +55,8 @@ HttpClientImpl::HttpClientImpl()
   _connectTimeout(Selectable::WaitInfinite),
   _proc(0),
   _exceptionPending(false),
-  _count(0)
+  _count(0),
+  _batching(false)
 {
     _request.method("POST");
     cxxtools::connect(_client.headerReceived, *this, &HttpClientImpl::onReplyHeader);
@@ -66,7 +69,15 @@ void HttpClientImpl::beginCall(IComposer& r, IRemoteProcedure& method, IDecompos
     if (_client.selector() == 0)
         throw std::logic_error("cannot run async rpc request without a selector");
 
-    if (_proc)
+    if (_batching)
+    {
+        _request.body() << (_scanner.calls().empty() ? '[' : ',');
+        formatRequest(method.name(), argv, argc);
+        _scanner.addCall(method, r, _count);
+        return;
+    }
+
+    if (activeProcedure())
         throw std::logic_error("asynchronous request already running");
 
     _proc = &method;
@@ -79,19 +90,42 @@ void HttpClientImpl::beginCall(IComposer& r, IRemoteProcedure& method, IDecompos
     }
     catch (const std::exception& )
     {
-        IRemoteProcedure* proc = _proc;
-        cancel();
+        failCalls();
+    }
 
-        _exceptionPending = true;
-        Resetter<bool> exceptionPending(_exceptionPending, false);
+    _scanner.begin(_deserializer, r);
+}
+
+void HttpClientImpl::beginBatch()
+{
+    if (_batching || activeProcedure())
+        throw std::logic_error("asynchronous request already running");
 
-        proc->onFinished();
+    _batching = true;
+    beginRequest();
+    _scanner.beginBatch(_deserializer);
+}
 
-        if (_exceptionPending)
-            throw;
-    }
+void HttpClientImpl::endBatch()
+{
+    if (!_batching)
+        throw std::logic_error("no batch started");
 
-    _scanner.begin(_deserializer, r);
+    _batching = false;
+
+    if (_scanner.calls().empty())
+        return;
+
+    _request.body() << ']';
+
+    try
+    {
+        _client.beginExecute(_request);
+    }
+    catch (const std::exception& )
+    {
+        failCalls();
+    }
 }
 
 
@@ -110,6 +144,9 @@ void HttpClientImpl::endCall()
 
 void HttpClientImpl::call(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc)
 {
+    if (_batching || !_scanner.calls().empty())
+        throw std::logic_error("asynchronous request already running");
+
     _proc = &method;
 
     prepareRequest(method.name(), argv, argc);
@@ -137,23 +174,68 @@ void HttpClientImpl::call(IComposer& r, IRemoteProcedure& method, IDecomposer**
 
 const IRemoteProcedure* HttpClientImpl::activeProcedure() const
 {
-    return _proc;
+    if (_proc)
+        return _proc;
+
+    const Scanner::Calls& calls = _scanner.calls();
+    for (Scanner::Calls::const_iterator it = calls.begin(); it != calls.end(); ++it)
+        if (it->proc)
+            return it->proc;
+
+    return 0;
 }
 
 void HttpClientImpl::cancel()
 {
     _client.cancel();
     _proc = 0;
+    _scanner.calls().clear();
+    _batching = false;
+}
+
+void HttpClientImpl::cancelCall(const IRemoteProcedure& proc)
+{
+    if (_proc == &proc)
+    {
+        cancel();
+        return;
+    }
+
+    for (Scanner::Calls::iterator it = _finishing.begin(); it != _finishing.end(); ++it)
+        if (it->proc == &proc)
+            it->proc = 0;
+
+    bool running = false;
+    Scanner::Calls& calls = _scanner.calls();
+    for (Scanner::Calls::iterator it = calls.begin(); it != calls.end(); ++it)
+    {
+        if (it->proc == &proc)
+            it->proc = 0;
+        else if (it->proc)
+            running = true;
+    }
+
+    if (!running && !_batching && !calls.empty())
+        cancel();
 }
 
 // private members
 
 void HttpClientImpl::prepareRequest(const String& name, IDecomposer** argv, unsigned argc)
+{
+    beginRequest();
+    formatRequest(name, argv, argc);
+}
+
+void HttpClientImpl::beginRequest()
 {
     _request.clear();
     _request.setHeader("Content-Type", "application/json");
     _request.method("POST");
+}
 
+void HttpClientImpl::formatRequest(const String& name, IDecomposer** argv, unsigned argc)
+{
     JsonFormatter formatter;
 
     formatter.begin(_request.body());
@@ -164,6 +246,11 @@ void HttpClientImpl::prepareRequest(const String& name, IDecomposer** argv, unsi
     formatter.addValueString("method", std::string(), String(name));
     formatter.addValueInt("id", "int", ++_count);
 
+    // a call made in a procedure passes on the time left of its deadline
+    RpcContext* context = RpcContext::current();
+    if (context && context->hasDeadline())
+        formatter.addValueInt("timeout", "int", static_cast<Formatter::int_type>(context->remaining().totalMSecs()));
+
     formatter.beginArray("params", std::string());
 
     for(unsigned n = 0; n < argc; ++n)
@@ -194,6 +281,12 @@ std::size_t HttpClientImpl::onReplyBody(http::Client& client)
         if (_deserializer.advance(ch))
         {
             log_debug("scanner finished");
+            if (!_proc)
+            {
+                _scanner.finalizeBatch();
+                break;
+            }
+
             try
             {
                 _scanner.finalizeReply();
@@ -231,20 +324,13 @@ void HttpClientImpl::onReplyFinished(http::Client& /*client*/)
     }
     catch (const std::exception& e)
     {
-        if (!_proc)
-            throw;
-
-        _exceptionPending = true;
-        Resetter<bool> exceptionPending(_exceptionPending, false);
+        failCalls();
+        return;
+    }
 
-        IRemoteProcedure* proc = _proc;
-        _proc = 0;
-        proc->onFinished();
-        if (_exceptionPending)
-        {
-            _exceptionPending = false;
-            throw;
-        }
+    if (!_proc)
+    {
+        finishBatch();
         return;
     }
 
@@ -253,6 +339,59 @@ void HttpClientImpl::onReplyFinished(http::Client& /*client*/)
     proc->onFinished();
 }
 
+// Cancels the running calls after an error and passes the error to the
+// procedures. Must be called in a catch block; the error is rethrown, when
+// no procedure took it.
+void HttpClientImpl::failCalls()
+{
+    std::vector<IRemoteProcedure*> procs;
+    if (_proc)
+        procs.push_back(_proc);
+
+    Scanner::Calls& calls = _scanner.calls();
+    for (Scanner::Calls::iterator it = calls.begin(); it != calls.end(); ++it)
+        if (it->proc)
+            procs.push_back(it->proc);
+
+    cancel();
+
+    if (procs.empty())
+        throw;
+
+    bool pending = false;
+    Resetter<bool> exceptionPending(_exceptionPending, false);
+    for (unsigned n = 0; n < procs.size(); ++n)
+    {
+        _exceptionPending = true;
+        procs[n]->onFinished();
+        if (_exceptionPending)
+            pending = true;
+    }
+
+    if (pending)
+        throw;
+}
+
+// Passes the replies of a batch to the procedures. The calls are moved out
+// of the scanner first, so that the callbacks may start new calls.
+void HttpClientImpl::finishBatch()
+{
+    _finishing.clear();
+    _finishing.swap(_scanner.calls());
+
+    for (unsigned n = 0; n < _finishing.size(); ++n)
+    {
+        IRemoteProcedure* proc = _finishing[n].proc;
+        if (proc)
+        {
+            _finishing[n].proc = 0;
+            proc->onFinished();
+        }
+    }
+
+    _finishing.clear();
+}
+
 void HttpClientImpl::wait(Timespan timeout)
 {
     if (!_client.selector())
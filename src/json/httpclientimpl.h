@@ -116,11 +116,25 @@ namespace json
 
             void cancel();
 
+            void cancelCall(const IRemoteProcedure& proc);
+
+            void beginBatch();
+
+            void endBatch();
+
             void wait(Timespan msecs);
 
         private:
             void prepareRequest(const String& name, IDecomposer** argv, unsigned argc);
 
+            void beginRequest();
+
+            void formatRequest(const String& name, IDecomposer** argv, unsigned argc);
+
+            void failCalls();
+
+            void finishBatch();
+
             void onReplyHeader(http::Client& client);
 
             std::size_t onReplyBody(http::Client& client);
@@ -145,6 +159,8 @@ namespace json
             IRemoteProcedure* _proc;
             bool _exceptionPending;
             Formatter::int_type _count;
+            bool _batching;     // calls are collected for a batch
+            Scanner::Calls _finishing;
     };
 
 }
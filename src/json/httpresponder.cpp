@@ -48,9 +48,10 @@ HttpResponder::~HttpResponder()
 {
 }
 
-void HttpResponder::beginRequest(net::TcpSocket& /*socket*/, std::istream& /*in*/, http::Request& /*request*/)
+void HttpResponder::beginRequest(net::TcpSocket& socket, std::istream& in, http::Request& request)
 {
     log_debug("begin request");
+    http::Responder::beginRequest(socket, in, request);
     _responder.begin();
 }
 
@@ -74,7 +75,20 @@ std::size_t HttpResponder::readBody(std::istream& is)
 void HttpResponder::reply(std::ostream& os, http::Request& /*request*/, http::Reply& reply)
 {
     reply.setHeader("Content-Type", "application/json");
-    _responder.finalize(os);
+
+    // Idle worker threads of the server help executing the elements of a
+    // batch. This thread executes elements itself, so the batch finishes,
+    // when no thread is idle.
+    std::shared_ptr<Batch> batch = _responder.batch();
+    if (batch)
+    {
+        unsigned helpers = queueJob([batch] () { batch->execute(); }, batch->size() - 1);
+        log_debug("dispatch batch to " << helpers << " helpers");
+    }
+
+    // notifications get no reply
+    if (!_responder.finalize(os))
+        reply.httpReturn(204, "No Content");
 }
 
 }
@@ -33,6 +33,7 @@
 #include <cxxtools/remoteexception.h>
 #include <cxxtools/log.h>
 #include <memory>
+#include <sstream>
 
 log_define("cxxtools.json.responder")
 
@@ -54,122 +55,285 @@ Responder::Responder(ServiceRegistry& serviceRegistry)
 
 Responder::~Responder()
 {
+    _serviceRegistry.releaseProcedure(std::move(_proc));
 }
 
 void Responder::begin()
 {
+    _serviceRegistry.releaseProcedure(std::move(_proc));
     _deserializer.begin();
+    _batch.reset();
     _failed = false;
 }
 
-void Responder::finalize(std::ostream& out)
+std::shared_ptr<Batch> Responder::batch()
 {
-    log_trace("finalize");
+    if (!_batch && !_failed
+        && _deserializer.si().category() == SerializationInfo::Array
+        && _deserializer.si().memberCount() > 1)
+    {
+        _batch = std::make_shared<Batch>(_serviceRegistry, _deserializer.si(), _received);
+    }
+
+    return _batch;
+}
+
+bool Responder::beginAsync(const std::function<void()>& done)
+{
+    if (_failed || batch())
+        return false;
+
+    SerializationInfo* request = &_deserializer.si();
+    if (request->category() == SerializationInfo::Array)
+    {
+        if (request->memberCount() != 1)
+            return false;
+        request = &*request->begin();
+    }
+
+    SerializationInfo* method = request->findMember("method");
+    if (!method)
+        return false;
 
     std::string methodName;
     std::unique_ptr<ServiceProcedure> proc;
 
-    JsonFormatter formatter;
+    try
+    {
+        *method >>= methodName;
+        if (!_serviceRegistry.isAsync(methodName))
+            return false;
 
-    formatter.begin(out);
+        // finalize replies the error of a expired call
+        if (RpcContext(deadline(*request, _received)).expired())
+            return false;
 
-    formatter.beginObject(std::string(), std::string());
-    formatter.addValueString("jsonrpc", "string", L"2.0");
+        proc = _serviceRegistry.getProcedure(methodName);
+        passParams(proc->beginCall(methodName), *request);
+    }
+    catch (const std::exception&)
+    {
+        // finalize runs the request again and replies the error
+        _serviceRegistry.releaseProcedure(std::move(proc));
+        return false;
+    }
+
+    log_debug("run asynchronous procedure " << methodName);
+
+    _proc = std::move(proc);
+
+    RpcContext context(deadline(*request, _received));
+    RpcContext::Scope scope(context);
+    _proc->executeAsync(done);
+    return true;
+}
+
+bool Responder::finalize(std::ostream& out)
+{
+    log_trace("finalize");
 
     if (_failed)
     {
+        JsonFormatter formatter;
+
+        formatter.begin(out);
+
+        formatter.beginObject(std::string(), std::string());
+        formatter.addValueString("jsonrpc", "string", L"2.0");
+        formatter.addNull("id", std::string());
+
         formatter.beginObject("error", std::string());
         formatter.addValueInt("code", "int", _errorCode);
-        formatter.addValueStdString("error", std::string(), std::move(_errorMessage));
+        formatter.addValueStdString("message", std::string(), std::move(_errorMessage));
+        formatter.finishObject();
+
+        formatter.finishObject();
+        return true;
+    }
+    else if (batch())
+    {
+        log_debug("batch with " << _batch->size() << " requests");
+        _batch->execute();
+        _batch->wait();
+        return _batch->format(out);
+    }
+    else if (_deserializer.si().category() == SerializationInfo::Array
+            && _deserializer.si().memberCount() == 1)
+    {
+        std::ostringstream reply;
+        if (!execute(_serviceRegistry, *_deserializer.si().begin(), reply, _received, std::move(_proc)))
+            return false;
+        out << '[' << reply.str() << ']';
+        return true;
     }
     else
     {
+        // an empty batch is handled as an invalid request here
+        return execute(_serviceRegistry, _deserializer.si(), out, _received, std::move(_proc));
+    }
+}
 
-        try
+void Responder::passParams(IComposers* args, SerializationInfo& request)
+{
+    // params may be omited in request
+    SerializationInfo* paramsPtr = request.findMember("params");
+    if (paramsPtr)
+    {
+        for (SerializationInfo::Iterator it = paramsPtr->begin(); it != paramsPtr->end(); ++it)
         {
-            _deserializer.si().getMember("method") >>= methodName;
+            auto composer = args->get();
+            if (!composer)
+                throw RemoteException("too many parameters", InvalidParams);
+            composer->fixup(*it);
+        }
+    }
 
-            log_debug("method = " << methodName);
-            proc = _serviceRegistry.getProcedure(methodName);
-            if( ! proc )
-                throw RemoteException("Method \"" + methodName + "\" not found", MethodNotFound);
+    if (args->needMore())
+        throw RemoteException("missing parameters", InvalidParams);
+}
 
-            // compose arguments
-            IComposers* args = proc->beginCall(methodName);
+RpcContext::Clock::time_point Responder::deadline(const SerializationInfo& request,
+    RpcContext::Clock::time_point received)
+{
+    const SerializationInfo* timeout = request.findMember("timeout");
+    if (!timeout)
+        return RpcContext::Clock::time_point::max();
 
-            // process args
-            SerializationInfo* paramsPtr = _deserializer.si().findMember("params");
+    unsigned long ms;
+    *timeout >>= ms;
+    return received + std::chrono::milliseconds(ms);
+}
 
-            // params may be omited in request
-            SerializationInfo emptyParams;
+IDecomposer* Responder::call(ServiceRegistry& serviceRegistry, SerializationInfo& request,
+    std::string& methodName, RpcContext::Clock::time_point received, std::unique_ptr<ServiceProcedure>& proc)
+{
+    request.getMember("method") >>= methodName;
 
-            SerializationInfo& params = paramsPtr ? *paramsPtr : emptyParams;
+    log_debug("method = " << methodName);
 
-            SerializationInfo::Iterator it = params.begin();
-            if (args)
-            {
-                while (it != params.end())
-                {
-                    auto composer = args->get();
-                    if (!composer)
-                        throw RemoteException("too many parameters", InvalidParams);
-                    composer->fixup(*it);
-                    ++it;
-                }
-            }
+    RpcContext context(deadline(request, received));
 
-            if (args->needMore())
-                throw RemoteException("missing parameters", InvalidParams);
+    if (!proc)
+    {
+        // skip calls, which waited too long
+        if (context.expired())
+        {
+            log_info("deadline of " << methodName << " exceeded before start");
+            throw RemoteException("deadline exceeded", RpcContext::Cancelled);
+        }
 
-            IDecomposer::formatEach(_deserializer.si().getMember("id"), formatter);
+        proc = serviceRegistry.getProcedure(methodName);
+        if( ! proc )
+            throw RemoteException("Method \"" + methodName + "\" not found", MethodNotFound);
 
-            IDecomposer* result;
-            result = proc->endCall();
+        passParams(proc->beginCall(methodName), request);
+    }
 
-            formatter.beginValue("result");
-            result->format(formatter);
-            formatter.finishValue();
-        }
-        catch (const RemoteException& e)
-        {
-            log_debug("method \"" << methodName << "\" exited with RemoteException: " << e.what());
+    RpcContext::Scope scope(context);
+    return proc->endCall();
+}
 
-            formatter.beginObject("error", std::string());
+void Responder::notify(ServiceRegistry& serviceRegistry, SerializationInfo& request,
+    RpcContext::Clock::time_point received, std::unique_ptr<ServiceProcedure> proc)
+{
+    std::string methodName;
 
-            formatter.addValueInt("code", "int", static_cast<Formatter::int_type>(e.rc()));
-            formatter.addValueStdString("message", std::string(), e.what());
-            formatter.finishObject();
-        }
-        catch (const SerializationError& e)
-        {
-            log_debug("serialization error");
+    try
+    {
+        call(serviceRegistry, request, methodName, received, proc);
+    }
+    catch (const std::exception& e)
+    {
+        log_debug("notification \"" << methodName << "\" failed: " << e.what());
+    }
 
-            formatter.beginObject("error", std::string());
+    serviceRegistry.releaseProcedure(std::move(proc));
+}
 
-            formatter.addValueInt("code", "int", InvalidRequest);
-            formatter.addValueStdString("message", std::string(), e.what());
-            formatter.finishObject();
-        }
-        catch (const std::exception& e)
-        {
-            log_debug("method \"" << methodName << "\" exited with exception: " << e.what());
+bool Responder::execute(ServiceRegistry& serviceRegistry, SerializationInfo& request, std::ostream& out,
+    RpcContext::Clock::time_point received, std::unique_ptr<ServiceProcedure> proc)
+{
+    const SerializationInfo* id = request.findMember("id");
+    if (!id && request.findMember("method"))
+    {
+        log_debug("notification");
+        notify(serviceRegistry, request, received, std::move(proc));
+        return false;
+    }
+
+    std::string methodName;
 
-            formatter.beginObject("error", std::string());
+    JsonFormatter formatter;
 
-            formatter.addValueInt("code", "int", ApplicationError);
-            formatter.addValueStdString("message", std::string(), e.what());
-            formatter.finishObject();
-        }
+    formatter.begin(out);
+
+    formatter.beginObject(std::string(), std::string());
+    formatter.addValueString("jsonrpc", "string", L"2.0");
+
+    // the id comes first, so that error replies of batch elements can be
+    // assigned to their request; invalid requests without id get null
+    if (id)
+        IDecomposer::formatEach(*id, formatter);
+    else
+        formatter.addNull("id", std::string());
+
+    try
+    {
+        if (!id)
+            throw RemoteException("id missing", InvalidRequest);
+
+        IDecomposer* result = call(serviceRegistry, request, methodName, received, proc);
+
+        formatter.beginValue("result");
+        result->format(formatter);
+        formatter.finishValue();
+    }
+    catch (const RemoteException& e)
+    {
+        log_debug("method \"" << methodName << "\" exited with RemoteException: " << e.what());
+
+        formatter.beginObject("error", std::string());
+
+        formatter.addValueInt("code", "int", static_cast<Formatter::int_type>(e.rc()));
+        formatter.addValueStdString("message", std::string(), e.what());
+        formatter.finishObject();
+    }
+    catch (const SerializationError& e)
+    {
+        log_debug("serialization error");
+
+        formatter.beginObject("error", std::string());
+
+        formatter.addValueInt("code", "int", InvalidRequest);
+        formatter.addValueStdString("message", std::string(), e.what());
+        formatter.finishObject();
+    }
+    catch (const std::exception& e)
+    {
+        log_debug("method \"" << methodName << "\" exited with exception: " << e.what());
+
+        formatter.beginObject("error", std::string());
+
+        formatter.addValueInt("code", "int", ApplicationError);
+        formatter.addValueStdString("message", std::string(), e.what());
+        formatter.finishObject();
     }
 
     formatter.finishObject();
+
+    serviceRegistry.releaseProcedure(std::move(proc));
+    return true;
 }
 
 bool Responder::advance(char ch)
 {
     try
     {
-        return _deserializer.advance(ch) != 0;
+        if (_deserializer.advance(ch) == 0)
+            return false;
+
+        _received = RpcContext::Clock::now();
+        return true;
     }
     catch (const JsonParserError& e)
     {
@@ -180,5 +344,60 @@ bool Responder::advance(char ch)
     }
 }
 
+Batch::Batch(ServiceRegistry& serviceRegistry, SerializationInfo& requests,
+             RpcContext::Clock::time_point received)
+    : _serviceRegistry(serviceRegistry),
+      _received(received),
+      _replies(requests.memberCount()),
+      _next(0),
+      _finished(0)
+{
+    _requests.swap(requests);
+}
+
+bool Batch::executeNext()
+{
+    unsigned n = _next++;
+    if (n >= _replies.size())
+        return false;
+
+    std::ostringstream out;
+    if (Responder::execute(_serviceRegistry, *(_requests.begin() + n), out, _received))
+        _replies[n] = out.str();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (++_finished == _replies.size())
+        _allFinished.notify_all();
+
+    return true;
+}
+
+void Batch::wait()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_finished < _replies.size())
+        _allFinished.wait(lock);
+}
+
+bool Batch::format(std::ostream& out) const
+{
+    bool first = true;
+    for (unsigned n = 0; n < _replies.size(); ++n)
+    {
+        // notifications have no reply
+        if (_replies[n].empty())
+            continue;
+
+        out << (first ? '[' : ',') << _replies[n];
+        first = false;
+    }
+
+    if (first)
+        return false;
+
+    out << ']';
+    return true;
+}
+
 }
 }
@@ -34,15 +34,26 @@
 #include <cxxtools/iostream.h>
 #include <cxxtools/jsonparser.h>
 #include <cxxtools/jsonformatter.h>
+#include <cxxtools/rpccontext.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace cxxtools
 {
 
 class ServiceRegistry;
+class ServiceProcedure;
+class IComposers;
 
 namespace json
 {
 class Socket;
+class Batch;
 
 class Responder
 {
@@ -61,18 +72,101 @@ class Responder
 
         void begin();
         bool advance(char ch);
-        void finalize(std::ostream& out);
+
+        /// Returns the batch, when the request is a batch request with more
+        /// than one element. Other threads may help executing it, while
+        /// finalize runs.
+        std::shared_ptr<Batch> batch();
+
+        /// Starts the procedure of a single request, when it replies
+        /// asynchronously, and returns true then. When the procedure calls
+        /// done, finalize writes the reply.
+        bool beginAsync(const std::function<void()>& done);
+
+        /// Writes the reply. Returns false, when the request consists of
+        /// notifications only, which get no reply.
+        bool finalize(std::ostream& out);
         bool failed() const
         { return _failed; }
 
+        /// Executes a single request and writes the reply object to out.
+        /// A procedure passed here ran asynchronously already. The deadline
+        /// of the request counts from `received`. A notification, which is
+        /// a request without id, gets no reply and false is returned.
+        static bool execute(ServiceRegistry& serviceRegistry, SerializationInfo& request, std::ostream& out,
+            RpcContext::Clock::time_point received,
+            std::unique_ptr<ServiceProcedure> proc = std::unique_ptr<ServiceProcedure>());
+
     private:
+        // Runs the procedure of the request and returns its result.
+        static IDecomposer* call(ServiceRegistry& serviceRegistry, SerializationInfo& request,
+            std::string& methodName, RpcContext::Clock::time_point received,
+            std::unique_ptr<ServiceProcedure>& proc);
+
+        static void notify(ServiceRegistry& serviceRegistry, SerializationInfo& request,
+            RpcContext::Clock::time_point received, std::unique_ptr<ServiceProcedure> proc);
+
+        static void passParams(IComposers* args, SerializationInfo& request);
+
+        // The client passes the time left for the call in ms in the member
+        // "timeout" of the request.
+        static RpcContext::Clock::time_point deadline(const SerializationInfo& request,
+            RpcContext::Clock::time_point received);
+
         ServiceRegistry& _serviceRegistry;
         JsonDeserializer _deserializer;
+        std::shared_ptr<Batch> _batch;
+        std::unique_ptr<ServiceProcedure> _proc;
+        RpcContext::Clock::time_point _received;
 
         bool _failed;
         int _errorCode;
         std::string _errorMessage;
 };
+
+// The elements of a batch request.
+//
+// Threads take the elements one by one and execute them until none is left.
+// The thread, which received the batch, executes elements itself, so that
+// the batch finishes even when no other thread helps.
+class Batch
+{
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+
+    public:
+        Batch(ServiceRegistry& serviceRegistry, SerializationInfo& requests,
+              RpcContext::Clock::time_point received);
+
+        unsigned size() const
+        { return _replies.size(); }
+
+        // Executes the next element, which is not yet started.
+        // Returns false, when no element is left.
+        bool executeNext();
+
+        void execute()
+        { while (executeNext()) ; }
+
+        // Waits until all elements are finished.
+        void wait();
+
+        // Writes the replies as a json array. Returns false and writes
+        // nothing, when all elements are notifications.
+        bool format(std::ostream& out) const;
+
+    private:
+        ServiceRegistry& _serviceRegistry;
+        SerializationInfo _requests;
+        RpcContext::Clock::time_point _received;
+        std::vector<std::string> _replies;
+
+        std::atomic<unsigned> _next;
+        unsigned _finished;
+        std::mutex _mutex;
+        std::condition_variable _allFinished;
+};
+
 }
 }
 #endif // CXXTOOLS_JSON_RESPONDER_H
@@ -174,6 +174,22 @@ void RpcClient::cancel()
         _impl->cancel();
 }
 
+void RpcClient::cancelCall(const IRemoteProcedure& proc)
+{
+    if (_impl)
+        _impl->cancelCall(proc);
+}
+
+void RpcClient::beginBatch()
+{
+    getImpl()->beginBatch();
+}
+
+void RpcClient::endBatch()
+{
+    getImpl()->endBatch();
+}
+
 void RpcClient::wait(Milliseconds msecs)
 {
     _impl->wait(msecs);
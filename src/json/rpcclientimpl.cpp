@@ -33,7 +33,9 @@
 #include <cxxtools/ioerror.h>
 #include <cxxtools/clock.h>
 #include <cxxtools/resetter.h>
+#include <cxxtools/rpccontext.h>
 #include <stdexcept>
+#include <vector>
 
 log_define("cxxtools.json.rpcclient.impl")
 
@@ -47,6 +49,7 @@ RpcClientImpl::RpcClientImpl()
       _exceptionPending(false),
       _proc(0),
       _count(0),
+      _batching(false),
       _timeout(Selectable::WaitInfinite),
       _connectTimeoutSet(false),
       _connectTimeout(Selectable::WaitInfinite)
@@ -76,7 +79,15 @@ void RpcClientImpl::beginCall(IComposer& r, IRemoteProcedure& method, IDecompose
     if (_socket.selector() == 0)
         throw std::logic_error("cannot run async rpc request without a selector");
 
-    if (_proc)
+    if (_batching)
+    {
+        _stream << (_scanner.calls().empty() ? '[' : ',');
+        prepareRequest(method.name(), argv, argc);
+        _scanner.addCall(method, r, _count);
+        return;
+    }
+
+    if (activeProcedure())
         throw std::logic_error("asynchronous request already running");
 
     _proc = &method;
@@ -85,39 +96,45 @@ void RpcClientImpl::beginCall(IComposer& r, IRemoteProcedure& method, IDecompose
 
     try
     {
-        if (_socket.isConnected())
-        {
-            try
-            {
-                _stream.buffer().beginWrite();
-            }
-            catch (const IOError&)
-            {
-                log_debug("write failed, connection is not active any more");
-                _socket.beginConnect(_addrInfo);
-            }
-        }
-        else
-        {
-            log_debug("not yet connected - do it now");
-            _socket.beginConnect(_addrInfo);
-        }
+        beginSend();
     }
     catch (const std::exception& )
     {
-        IRemoteProcedure* proc = _proc;
-        cancel();
+        failCalls();
+    }
 
-        _exceptionPending = true;
-        Resetter<bool> exceptionPending(_exceptionPending, false);
+    _scanner.begin(_deserializer, r);
+}
 
-        proc->onFinished();
+void RpcClientImpl::beginBatch()
+{
+    if (_batching || activeProcedure())
+        throw std::logic_error("asynchronous request already running");
 
-        if (_exceptionPending)
-            throw;
-    }
+    _batching = true;
+    _scanner.beginBatch(_deserializer);
+}
 
-    _scanner.begin(_deserializer, r);
+void RpcClientImpl::endBatch()
+{
+    if (!_batching)
+        throw std::logic_error("no batch started");
+
+    _batching = false;
+
+    if (_scanner.calls().empty())
+        return;
+
+    _stream << ']';
+
+    try
+    {
+        beginSend();
+    }
+    catch (const std::exception& )
+    {
+        failCalls();
+    }
 }
 
 void RpcClientImpl::endCall()
@@ -133,6 +150,9 @@ void RpcClientImpl::endCall()
 
 void RpcClientImpl::call(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc)
 {
+    if (_batching || !_scanner.calls().empty())
+        throw std::logic_error("asynchronous request already running");
+
     try
     {
         _proc = &method;
@@ -209,15 +229,57 @@ void RpcClientImpl::call(IComposer& r, IRemoteProcedure& method, IDecomposer** a
     }
 }
 
+const IRemoteProcedure* RpcClientImpl::activeProcedure() const
+{
+    if (_proc)
+        return _proc;
+
+    const Scanner::Calls& calls = _scanner.calls();
+    for (Scanner::Calls::const_iterator it = calls.begin(); it != calls.end(); ++it)
+        if (it->proc)
+            return it->proc;
+
+    return 0;
+}
+
 void RpcClientImpl::cancel()
 {
     _socket.close();
     _stream.clear();
     _stream.buffer().discard();
     _proc = 0;
+    _scanner.calls().clear();
+    _batching = false;
     _exceptionPending = false;
 }
 
+void RpcClientImpl::cancelCall(const IRemoteProcedure& proc)
+{
+    if (_proc == &proc)
+    {
+        cancel();
+        return;
+    }
+
+    for (Scanner::Calls::iterator it = _finishing.begin(); it != _finishing.end(); ++it)
+        if (it->proc == &proc)
+            it->proc = 0;
+
+    bool running = false;
+    Scanner::Calls& calls = _scanner.calls();
+    for (Scanner::Calls::iterator it = calls.begin(); it != calls.end(); ++it)
+    {
+        if (it->proc == &proc)
+            it->proc = 0;
+        else if (it->proc)
+            running = true;
+    }
+
+    // the reply of a batch is not needed any more, when all calls are cancelled
+    if (!running && !_batching && !calls.empty())
+        cancel();
+}
+
 void RpcClientImpl::wait(Timespan timeout)
 {
     if (_socket.selector() == 0)
@@ -255,6 +317,11 @@ void RpcClientImpl::prepareRequest(const String& name, IDecomposer** argv, unsig
     formatter.addValueString("method", std::string(), String(_prefix) + name);
     formatter.addValueInt("id", "int", ++_count);
 
+    // a call made in a procedure passes on the time left of its deadline
+    RpcContext* context = RpcContext::current();
+    if (context && context->hasDeadline())
+        formatter.addValueInt("timeout", "int", static_cast<Formatter::int_type>(context->remaining().totalMSecs()));
+
     formatter.beginArray("params", std::string());
 
     for(unsigned n = 0; n < argc; ++n)
@@ -269,6 +336,82 @@ void RpcClientImpl::prepareRequest(const String& name, IDecomposer** argv, unsig
     formatter.finish();
 }
 
+void RpcClientImpl::beginSend()
+{
+    if (_socket.isConnected())
+    {
+        try
+        {
+            _stream.buffer().beginWrite();
+        }
+        catch (const IOError&)
+        {
+            log_debug("write failed, connection is not active any more");
+            _socket.beginConnect(_addrInfo);
+        }
+    }
+    else
+    {
+        log_debug("not yet connected - do it now");
+        _socket.beginConnect(_addrInfo);
+    }
+}
+
+// Cancels the running calls after an error and passes the error to the
+// procedures. Must be called in a catch block; the error is rethrown, when
+// no procedure took it.
+void RpcClientImpl::failCalls()
+{
+    std::vector<IRemoteProcedure*> procs;
+    if (_proc)
+        procs.push_back(_proc);
+
+    Scanner::Calls& calls = _scanner.calls();
+    for (Scanner::Calls::iterator it = calls.begin(); it != calls.end(); ++it)
+        if (it->proc)
+            procs.push_back(it->proc);
+
+    cancel();
+
+    if (procs.empty())
+        throw;
+
+    bool pending = false;
+    Resetter<bool> exceptionPending(_exceptionPending, false);
+    for (unsigned n = 0; n < procs.size(); ++n)
+    {
+        _exceptionPending = true;
+        procs[n]->onFinished();
+        if (_exceptionPending)
+            pending = true;
+    }
+
+    if (pending)
+        throw;
+}
+
+// Passes the replies of a batch to the procedures. The calls are moved out
+// of the scanner first, so that the callbacks may start new calls.
+void RpcClientImpl::finishBatch()
+{
+    _scanner.finalizeBatch();
+
+    _finishing.clear();
+    _finishing.swap(_scanner.calls());
+
+    for (unsigned n = 0; n < _finishing.size(); ++n)
+    {
+        IRemoteProcedure* proc = _finishing[n].proc;
+        if (proc)
+        {
+            _finishing[n].proc = 0;
+            proc->onFinished();
+        }
+    }
+
+    _finishing.clear();
+}
+
 void RpcClientImpl::onConnect(net::TcpSocket& socket)
 {
     try
@@ -288,19 +431,7 @@ void RpcClientImpl::onConnect(net::TcpSocket& socket)
     }
     catch (const std::exception& )
     {
-        IRemoteProcedure* proc = _proc;
-        cancel();
-
-        if (!proc)
-            throw;
-
-        _exceptionPending = true;
-        Resetter<bool> exceptionPending(_exceptionPending, false);
-
-        proc->onFinished();
-
-        if (_exceptionPending)
-            throw;
+        failCalls();
     }
 }
 
@@ -317,19 +448,7 @@ void RpcClientImpl::onSslConnect(net::TcpSocket& socket)
     }
     catch (const std::exception& )
     {
-        IRemoteProcedure* proc = _proc;
-        cancel();
-
-        if (!proc)
-            throw;
-
-        _exceptionPending = true;
-        Resetter<bool> exceptionPending(_exceptionPending, false);
-
-        proc->onFinished();
-
-        if (_exceptionPending)
-            throw;
+        failCalls();
     }
 }
 
@@ -346,19 +465,7 @@ void RpcClientImpl::onOutput(StreamBuffer& sb)
     }
     catch (const std::exception&)
     {
-        IRemoteProcedure* proc = _proc;
-        cancel();
-
-        if (!proc)
-            throw;
-
-        _exceptionPending = true;
-        Resetter<bool> exceptionPending(_exceptionPending, false);
-
-        proc->onFinished();
-
-        if (_exceptionPending)
-            throw;
+        failCalls();
     }
 }
 
@@ -377,6 +484,12 @@ void RpcClientImpl::onInput(StreamBuffer& sb)
             char ch = StreamBuffer::traits_type::to_char_type(_stream.buffer().sbumpc());
             if (_deserializer.advance(ch))
             {
+                if (!_proc)
+                {
+                    finishBatch();
+                    return;
+                }
+
                 _scanner.finalizeReply();
                 IRemoteProcedure* proc = _proc;
                 _proc = 0;
@@ -395,19 +508,7 @@ void RpcClientImpl::onInput(StreamBuffer& sb)
     }
     catch (const std::exception&)
     {
-        IRemoteProcedure* proc = _proc;
-        cancel();
-
-        if (!proc)
-            throw;
-
-        _exceptionPending = true;
-        Resetter<bool> exceptionPending(_exceptionPending, false);
-
-        proc->onFinished();
-
-        if (_exceptionPending)
-            throw;
+        failCalls();
     }
 }
 
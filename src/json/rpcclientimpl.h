@@ -90,11 +90,16 @@ class RpcClientImpl : public RefCounted, public Connectable
         Timespan connectTimeout() const  { return _connectTimeout; }
         void connectTimeout(Timespan t)  { _connectTimeout = t; _connectTimeoutSet = true; }
 
-        const IRemoteProcedure* activeProcedure() const
-        { return _proc; }
+        const IRemoteProcedure* activeProcedure() const;
 
         void cancel();
 
+        void cancelCall(const IRemoteProcedure& proc);
+
+        void beginBatch();
+
+        void endBatch();
+
         void wait(Timespan msecs);
 
         const std::string& prefix() const
@@ -105,6 +110,9 @@ class RpcClientImpl : public RefCounted, public Connectable
 
     private:
         void prepareRequest(const String& name, IDecomposer** argv, unsigned argc);
+        void beginSend();
+        void failCalls();
+        void finishBatch();
         void onConnect(net::TcpSocket& socket);
         void onSslConnect(net::TcpSocket& socket);
         void onOutput(StreamBuffer& sb);
@@ -126,6 +134,8 @@ class RpcClientImpl : public RefCounted, public Connectable
         bool _exceptionPending;
         IRemoteProcedure* _proc;
         Formatter::int_type _count;
+        bool _batching;     // calls are collected for a batch
+        Scanner::Calls _finishing;
 
         Timespan _timeout;
         bool _connectTimeoutSet;  // indicates if connectTimeout is explicitely set
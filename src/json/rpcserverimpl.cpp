@@ -27,13 +27,17 @@
  */
 
 #include "rpcserverimpl.h"
+#include "responder.h"
 #include "socket.h"
 #include "worker.h"
 
+#include <cxxtools/asyncdone.h>
 #include <cxxtools/eventloop.h>
 #include <cxxtools/net/tcpserver.h>
 #include <cxxtools/log.h>
 
+#include <algorithm>
+
 log_define("cxxtools.json.rpcserver.impl")
 
 namespace cxxtools
@@ -195,8 +199,10 @@ void RpcServerImpl::terminate()
 
         _listener.clear();
 
+        cancelAsync();
+
         while (!_queue.empty())
-            delete _queue.get();
+            delete _queue.get().socket;
 
         for (IdleSocket::iterator it = _idleSocket.begin(); it != _idleSocket.end(); ++it)
             delete *it;
@@ -213,7 +219,7 @@ void RpcServerImpl::terminate()
 
 void RpcServerImpl::noWaitingThreads()
 {
-    if (runmode() == RpcServer::Running)
+    if (isRunning())
         _eventLoop.commitEvent(NoWaitingThreadsEvent());
 }
 
@@ -234,11 +240,57 @@ void RpcServerImpl::threadTerminated(Worker* worker)
     }
 }
 
+void RpcServerImpl::addAsync(Socket* socket, const std::shared_ptr<AsyncDone>& done)
+{
+    std::lock_guard<std::mutex> lock(_asyncMutex);
+    _asyncSockets[socket] = done;
+}
+
+// Deletes the connections, which wait for a asynchronous procedure.
+// A procedure, which replies meanwhile, finishes before cancel returns and
+// does not find its connection in the server any more.
+void RpcServerImpl::cancelAsync()
+{
+    std::map<Socket*, std::shared_ptr<AsyncDone>> sockets;
+
+    {
+        std::lock_guard<std::mutex> lock(_asyncMutex);
+        sockets.swap(_asyncSockets);
+    }
+
+    log_debug("cancel " << sockets.size() << " asynchronous procedures");
+
+    for (auto& it: sockets)
+    {
+        it.second->cancel();
+        delete it.first;
+    }
+}
+
+void RpcServerImpl::resume(Socket* socket)
+{
+    std::lock_guard<std::mutex> lock(_asyncMutex);
+
+    // terminate deletes the socket, when it is not found
+    if (_asyncSockets.erase(socket) == 0)
+        return;
+
+    if (isRunning())
+    {
+        _queue.put(socket);
+    }
+    else
+    {
+        log_debug("server not running; delete " << static_cast<void*>(socket));
+        delete socket;
+    }
+}
+
 void RpcServerImpl::addIdleSocket(Socket* socket)
 {
     log_debug("add idle socket " << static_cast<void*>(socket));
 
-    if (runmode() == RpcServer::Running)
+    if (isRunning())
     {
         _eventLoop.commitEvent(IdleSocketEvent(socket));
     }
@@ -249,6 +301,16 @@ void RpcServerImpl::addIdleSocket(Socket* socket)
     }
 }
 
+void RpcServerImpl::dispatch(const std::shared_ptr<Batch>& batch)
+{
+    // The receiving thread executes elements itself. The helpers are
+    // limited to the threads, which the server keeps ready.
+    unsigned helpers = std::min(batch->size() - 1, minThreads());
+    log_debug("dispatch batch to " << helpers << " helpers");
+    for (unsigned n = 0; n < helpers; ++n)
+        _queue.put(Job(batch));
+}
+
 void RpcServerImpl::onIdleSocket(const IdleSocketEvent& event)
 {
     Socket* socket = event.socket();
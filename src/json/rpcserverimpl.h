@@ -39,6 +39,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <set>
+#include <map>
 #include <vector>
 #include <memory>
 
@@ -48,6 +49,7 @@ namespace cxxtools
 class EventLoopBase;
 class ServiceProcedure;
 class SslCtx;
+class AsyncDone;
 
 namespace net
 {
@@ -64,6 +66,24 @@ namespace json
     class NoWaitingThreadsEvent;
     class ThreadTerminatedEvent;
     class ActiveSocketEvent;
+    class Batch;
+
+    // A job for the worker threads: either a socket with input or a batch
+    // request, which the workers help to execute.
+    struct Job
+    {
+        Socket* socket;
+        std::shared_ptr<Batch> batch;
+
+        Job(Socket* socket_ = 0)
+            : socket(socket_)
+            { }
+
+        explicit Job(const std::shared_ptr<Batch>& batch_)
+            : socket(0),
+              batch(batch_)
+            { }
+    };
 
     class RpcServerImpl : public Connectable
     {
@@ -111,6 +131,15 @@ namespace json
             void onInput(Socket& _socket);
 
             void addIdleSocket(Socket* socket);
+
+            // Asynchronous procedures, which did not reply yet, are tracked,
+            // so that terminate cancels them.
+            void addAsync(Socket* socket, const std::shared_ptr<AsyncDone>& done);
+            void cancelAsync();
+
+            // passes a socket to the workers, when its asynchronous procedure finished
+            void resume(Socket* socket);
+            void dispatch(const std::shared_ptr<Batch>& batch);
             void onIdleSocket(const IdleSocketEvent& event);
             void onActiveSocket(const ActiveSocketEvent& event);
             void onNoWaitingThreads(const NoWaitingThreadsEvent& event);
@@ -130,11 +159,14 @@ namespace json
             unsigned _maxThreads;
 
             std::vector<std::unique_ptr<net::TcpServer>> _listener;
-            Queue<Socket*> _queue;
+            Queue<Job> _queue;
 
             typedef std::set<Socket*> IdleSocket;
             IdleSocket _idleSocket;
 
+            std::mutex _asyncMutex;
+            std::map<Socket*, std::shared_ptr<AsyncDone>> _asyncSockets;
+
             std::mutex _threadMutex;
             std::condition_variable _threadTerminated;
             typedef std::set<Worker*> Threads;
@@ -144,6 +176,10 @@ namespace json
 
             bool isTerminating() const
             { return runmode() == RpcServer::Terminating; }
+
+            // the workers run already, while the server is starting
+            bool isRunning() const
+            { return runmode() == RpcServer::Starting || runmode() == RpcServer::Running; }
     };
 }
 }
@@ -32,6 +32,9 @@
 #include <cxxtools/deserializer.h>
 #include <cxxtools/jsondeserializer.h>
 #include <cxxtools/composer.h>
+#include <cxxtools/remoteprocedure.h>
+#include <cxxtools/serializationerror.h>
+#include <map>
 
 log_define("cxxtools.json.scanner")
 
@@ -50,7 +53,98 @@ void Scanner::begin(JsonDeserializer& handler, IComposer& composer)
 
 void Scanner::finalizeReply()
 {
-    const SerializationInfo* s = _deserializer->si().findMember("error");
+    finalizeReply(_deserializer->si(), *_composer);
+}
+
+void Scanner::beginBatch(JsonDeserializer& handler)
+{
+    _deserializer = &handler;
+    _deserializer->begin();
+    _composer = 0;
+    _calls.clear();
+}
+
+void Scanner::addCall(IRemoteProcedure& proc, IComposer& composer, Formatter::int_type id)
+{
+    Call call;
+    call.proc = &proc;
+    call.composer = &composer;
+    call.id = id;
+    _calls.push_back(call);
+}
+
+void Scanner::finalizeBatch()
+{
+    SerializationInfo& reply = _deserializer->si();
+
+    if (reply.category() != SerializationInfo::Array)
+    {
+        // A single reply to a batch is an error, e.g. from a server, which
+        // does not support batches. It applies to all calls.
+        std::string msg = "invalid batch reply";
+        int rc = 0;
+        const SerializationInfo* s = reply.findMember("error");
+        if (s && s->category() == SerializationInfo::Object)
+        {
+            s->getMember("code", rc);
+            s->getMember("message", msg);
+        }
+
+        log_debug("batch failed: " << msg);
+
+        for (Calls::iterator it = _calls.begin(); it != _calls.end(); ++it)
+            if (it->proc)
+                it->proc->setFault(rc, msg);
+
+        return;
+    }
+
+    // replies may come in any order
+    std::map<Formatter::int_type, SerializationInfo*> replies;
+    for (SerializationInfo::Iterator it = reply.begin(); it != reply.end(); ++it)
+    {
+        try
+        {
+            Formatter::int_type id;
+            if (it->getMember("id", id))
+                replies[id] = &*it;
+        }
+        catch (const SerializationError&)
+        {
+            // not an id of ours
+        }
+    }
+
+    for (Calls::iterator it = _calls.begin(); it != _calls.end(); ++it)
+    {
+        if (!it->proc)
+            continue;
+
+        auto r = replies.find(it->id);
+        if (r == replies.end())
+        {
+            it->proc->setFault(0, "no reply for batch element");
+            continue;
+        }
+
+        try
+        {
+            finalizeReply(*r->second, *it->composer);
+        }
+        catch (const RemoteException& e)
+        {
+            it->proc->setFault(e.rc(), e.text());
+        }
+        catch (const std::exception& e)
+        {
+            it->proc->setFault(0, e.what());
+        }
+    }
+}
+
+void Scanner::finalizeReply(SerializationInfo& reply, IComposer& composer)
+{
+    const SerializationInfo* s = reply.findMember("error");
 
     if (s && !s->isNull())
     {
@@ -74,8 +168,7 @@ void Scanner::finalizeReply()
         }
     }
 
-    _composer->fixup(
-    _deserializer->si().getMember("result"));
+    composer.fixup(reply.getMember("result"));
 }
 
 }
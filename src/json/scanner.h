@@ -31,18 +31,33 @@
 
 #include <cxxtools/composer.h>
 #include <cxxtools/jsonparser.h>
+#include <cxxtools/formatter.h>
 #include <string>
+#include <vector>
 
 namespace cxxtools
 {
     class JsonDeserializer;
     class IComposer;
+    class IRemoteProcedure;
+    class SerializationInfo;
 
     namespace json
     {
         class Scanner
         {
             public:
+                // A call of a batch request. The procedure is null, when the
+                // call was cancelled.
+                struct Call
+                {
+                    IRemoteProcedure* proc;
+                    IComposer* composer;
+                    Formatter::int_type id;
+                };
+
+                typedef std::vector<Call> Calls;
+
                 Scanner()
                     : _deserializer(0),
                       _composer(0)
@@ -55,9 +70,26 @@ namespace cxxtools
 
                 void finalizeReply();
 
+                void beginBatch(JsonDeserializer& handler);
+
+                void addCall(IRemoteProcedure& proc, IComposer& composer, Formatter::int_type id);
+
+                Calls& calls()
+                { return _calls; }
+
+                const Calls& calls() const
+                { return _calls; }
+
+                // Sets the result or the fault of each call of the batch.
+                // Calls without a reply get a fault.
+                void finalizeBatch();
+
             private:
+                static void finalizeReply(SerializationInfo& reply, IComposer& composer);
+
                 JsonDeserializer* _deserializer;
                 IComposer* _composer;
+                Calls _calls;
         };
     }
 }
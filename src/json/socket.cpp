@@ -28,6 +28,7 @@
 
 #include "socket.h"
 #include "rpcserverimpl.h"
+#include <cxxtools/asyncdone.h>
 #include <cxxtools/log.h>
 
 log_define("cxxtools.json.socket")
@@ -43,7 +44,9 @@ Socket::Socket(RpcServerImpl& rpcServerImpl, net::TcpServer& tcpServer, const Ss
       _tcpServer(tcpServer),
       _sslCtx(sslCtx),
       _responder(rpcServerImpl._serviceRegistry),
-      _accepted(false)
+      _accepted(false),
+      _deferred(false),
+      _asyncPending(0)
 {
     _stream.attachDevice(*this);
     cxxtools::connect(IODevice::inputReady, *this, &Socket::onIODeviceInput);
@@ -60,7 +63,9 @@ Socket::Socket(Socket& socket)
       _tcpServer(socket._tcpServer),
       _sslCtx(socket._sslCtx),
       _responder(_rpcServerImpl._serviceRegistry),
-      _accepted(false)
+      _accepted(false),
+      _deferred(false),
+      _asyncPending(0)
 {
     _stream.attachDevice(*this);
     cxxtools::connect(IODevice::inputReady, *this, &Socket::onIODeviceInput);
@@ -128,6 +133,22 @@ void Socket::onInput(StreamBuffer& sb)
     {
         if (_responder.advance(sb.sbumpc()))
         {
+            // The socket comes back with the last release, which is the one
+            // of the worker at the earliest, so the server knows the
+            // procedure in time.
+            _asyncPending = 2;
+            auto done = std::make_shared<AsyncDone>([this] () { releaseAsync(); });
+            if (_responder.beginAsync([done] () { (*done)(); }))
+            {
+                _rpcServerImpl.addAsync(this, done);
+                _deferred = true;
+                return;
+            }
+
+            std::shared_ptr<Batch> batch = _responder.batch();
+            if (batch)
+                _rpcServerImpl.dispatch(batch);
+
             _responder.finalize(_stream);
             buffer().beginWrite();
             onOutput(sb);
@@ -139,6 +160,20 @@ void Socket::onInput(StreamBuffer& sb)
 
 }
 
+void Socket::releaseAsync()
+{
+    if (--_asyncPending == 0)
+        _rpcServerImpl.resume(this);
+}
+
+void Socket::finishAsync()
+{
+    _deferred = false;
+    _responder.finalize(_stream);
+    buffer().beginWrite();
+    onOutput(buffer());
+}
+
 bool Socket::onOutput(StreamBuffer& sb)
 {
     log_trace("onOutput");
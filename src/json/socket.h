@@ -36,6 +36,7 @@
 #include <cxxtools/method.h>
 #include <cxxtools/sslctx.h>
 #include "responder.h"
+#include <atomic>
 
 namespace cxxtools
 {
@@ -61,6 +62,14 @@ class Socket : public net::TcpSocket, public Connectable
         bool onOutput(StreamBuffer& sb);
         bool onAcceptSslCertificate(const SslCertificate& cert);
 
+        // Set, while a asynchronous procedure runs. The worker passes the
+        // socket on with releaseAsync. The procedure and the worker release
+        // it both; the last one passes it to the workers again, which send
+        // the reply with finishAsync.
+        bool deferred() const          { return _deferred; }
+        void releaseAsync();
+        void finishAsync();
+
         Signal<Socket&> inputReady;
 
         StreamBuffer& buffer()         { return _stream.buffer(); }
@@ -81,6 +90,9 @@ class Socket : public net::TcpSocket, public Connectable
         int _sslVerifyLevel;
         std::string _sslCa;
         bool _accepted;
+
+        bool _deferred;
+        std::atomic<unsigned> _asyncPending;
 };
 
 }
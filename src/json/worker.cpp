@@ -28,6 +28,7 @@
 
 #include "worker.h"
 #include "rpcserverimpl.h"
+#include "responder.h"
 #include "socket.h"
 #include <cxxtools/net/tcpserver.h>
 #include <cxxtools/log.h>
@@ -59,18 +60,27 @@ void Worker::run()
     log_debug(static_cast<void*>(this) << " server=" << static_cast<void*>(&_server));
     while (!_server.isTerminating() && _server._queue.numWaiting() < _server.minThreads())
     {
-        Socket* socket = _server._queue.get();
+        Job job = _server._queue.get();
 
         if (_server.isTerminating())
         {
             log_debug("server is terminating - quit thread");
-            _server._queue.put(socket);
+            _server._queue.put(job);
             break;
         }
 
         if (_server._queue.numWaiting() == 0)
             _server.noWaitingThreads();
 
+        if (job.batch)
+        {
+            log_debug("help executing batch");
+            job.batch->execute();
+            continue;
+        }
+
+        Socket* socket = job.socket;
+
         try
         {
             if (!socket->hasAccepted())
@@ -100,6 +110,11 @@ void Worker::run()
                     throw;
                 }
             }
+            else if (socket->deferred())
+            {
+                log_debug("send reply of asynchronous procedure to " << socket->getPeerAddr());
+                socket->finishAsync();
+            }
             else if (socket->isConnected())
             {
                 log_debug("process available input from " << socket->getPeerAddr());
@@ -116,10 +131,16 @@ void Worker::run()
             Connection inputConnection = socket->buffer().inputReady.connect(
                 socket->inputSlot);
 
-            while (socket->wait(10) && socket->isConnected())
+            while (!socket->deferred() && socket->wait(10) && socket->isConnected())
                 ;
 
-            if (socket->isConnected())
+            if (socket->deferred())
+            {
+                // the socket comes back, when the procedure has finished
+                inputConnection.close();
+                socket->releaseAsync();
+            }
+            else if (socket->isConnected())
             {
                 log_debug("timeout processing socket");
                 inputConnection.close();
@@ -124,6 +124,12 @@ void JsonFormatter::addValueString(const std::string& name, const std::string& t
 
 void JsonFormatter::addValueStdString(const std::string& name, const std::string& type,
                       std::string&& value)
+{
+    addValueStdString(name, type, static_cast<const std::string&>(value));
+}
+
+void JsonFormatter::addValueStdString(const std::string& name, const std::string& type,
+                      const std::string& value)
 {
     log_trace("addValueStdString name=\"" << name << "\", type=\"" << type << "\", \" value=\"" << value << '"');
 
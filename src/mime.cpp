@@ -585,6 +585,145 @@ void MimeMultipart::partsFromBody(const std::string& body, std::string::size_typ
     }
 }
 
+////////////////////////////////////////////////////////////////////////
+// MimeMultipartParser
+//
+MimeMultipartParser::MimeMultipartParser(Handler& handler, const std::string& contentType)
+    : _handler(handler),
+      _state(state_preamble)
+{
+    std::string b = boundary(contentType);
+    if (b.empty())
+        throw std::runtime_error("data is no mime multipart");
+
+    _delimiter = "\r\n--";
+    _delimiter += b;
+
+    // the first boundary may start at the very beginning of the body
+    _buffer = "\r\n";
+}
+
+std::string MimeMultipartParser::boundary(const std::string& contentType)
+{
+    return getTypeBoundary(contentType).boundary;
+}
+
+void MimeMultipartParser::parse(const char* data, std::size_t size)
+{
+    if (_state == state_epilogue)
+        return;
+
+    _buffer.append(data, size);
+    while (process())
+        ;
+}
+
+void MimeMultipartParser::finish()
+{
+    if (_state != state_epilogue)
+        throw std::runtime_error("incomplete mime multipart body");
+}
+
+// processes the buffered data and returns true, when more can be processed
+bool MimeMultipartParser::process()
+{
+    switch (_state)
+    {
+        case state_preamble:
+        {
+            std::string::size_type pos = _buffer.find(_delimiter);
+            if (pos == std::string::npos)
+            {
+                // keep what may be the start of the delimiter
+                if (_buffer.size() >= _delimiter.size())
+                    _buffer.erase(0, _buffer.size() - _delimiter.size() + 1);
+                return false;
+            }
+
+            _buffer.erase(0, pos + _delimiter.size());
+            _state = state_boundary;
+            return true;
+        }
+
+        case state_boundary:
+        {
+            // skip transport padding after the boundary
+            std::string::size_type pos = _buffer.find_first_not_of(" \t");
+            if (pos == std::string::npos || _buffer.size() - pos < 2)
+                return false;
+
+            if (_buffer[pos] == '-' && _buffer[pos + 1] == '-')
+            {
+                log_debug("end boundary found");
+                _buffer.clear();
+                _state = state_epilogue;
+                return false;
+            }
+
+            if (_buffer[pos] != '\r' || _buffer[pos + 1] != '\n')
+                throw std::runtime_error("boundary not delimited by CRLF");
+
+            _buffer.erase(0, pos + 2);
+            _state = state_header;
+            return true;
+        }
+
+        case state_header:
+        {
+            std::string::size_type end;
+            if (_buffer.compare(0, 2, "\r\n") == 0)
+                end = 2;
+            else if ((end = _buffer.find("\r\n\r\n")) != std::string::npos)
+                end += 4;
+            else
+            {
+                if (_buffer.size() > maxHeaderSize)
+                    throw std::runtime_error("mime part header too large");
+                return false;
+            }
+
+            _header = MimeHeader();
+            HeaderParser headerParser(_header);
+            for (std::string::size_type n = 0; n < end; ++n)
+                headerParser.parse(_buffer[n]);
+
+            _buffer.erase(0, end);
+            _state = state_body;
+            _handler.onPartBegin(_header);
+            return true;
+        }
+
+        case state_body:
+        {
+            std::string::size_type pos = _buffer.find(_delimiter);
+            if (pos == std::string::npos)
+            {
+                // pass all data, which can't be the start of the delimiter
+                if (_buffer.size() >= _delimiter.size())
+                {
+                    std::string::size_type count = _buffer.size() - _delimiter.size() + 1;
+                    _handler.onPartData(_buffer.data(), count);
+                    _buffer.erase(0, count);
+                }
+                return false;
+            }
+
+            if (pos > 0)
+                _handler.onPartData(_buffer.data(), pos);
+            _handler.onPartEnd();
+
+            _buffer.erase(0, pos + _delimiter.size());
+            _state = state_boundary;
+            return true;
+        }
+
+        case state_epilogue:
+            break;
+    }
+
+    return false;
+}
+
 std::string MimeMultipart::stringParts(const std::vector<MimeEntity>& parts, std::vector<std::string>& sparts)
 {
     for (MimeMultipart::PartsType::const_iterator pit = parts.begin(); pit != parts.end(); ++pit)
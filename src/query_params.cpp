@@ -32,8 +32,10 @@
 #include "cxxtools/utf8codec.h"
 #include "cxxtools/log.h"
 
+#include <algorithm>
 #include <iterator>
 #include <iostream>
+#include <cstring>
 #include <stdlib.h>
 
 log_define("cxxtools.queryparams")
@@ -260,6 +262,62 @@ namespace
 
   }
 
+  int hexValue(char ch)
+  {
+    return ch >= '0' && ch <= '9' ? ch - '0'
+         : ch >= 'a' && ch <= 'f' ? ch - 'a' + 10
+         : ch >= 'A' && ch <= 'F' ? ch - 'A' + 10
+         : -1;
+  }
+
+  bool needsDecoding(char ch)
+  {
+    return ch == '%' || ch == '+';
+  }
+
+  // Decodes like UrlParser: '%' takes up to 2 hex digits and stays as it
+  // is without any.
+  void decode(const char* b, const char* e, std::string& out)
+  {
+    if (std::find_if(b, e, needsDecoding) == e)
+    {
+      out.append(b, e);
+      return;
+    }
+
+    while (b != e)
+    {
+      char ch = *b++;
+      if (ch == '+')
+        out += ' ';
+      else if (ch != '%')
+        out += ch;
+      else
+      {
+        unsigned v = 0;
+        unsigned cnt = 0;
+        for (int h; cnt < 2 && b != e && (h = hexValue(*b)) >= 0; ++b, ++cnt)
+          v = (v << 4) + h;
+
+        out += cnt == 0 ? '%' : static_cast<char>(v);
+      }
+    }
+  }
+
+  // FNV-1a
+  std::size_t hashName(const char* name, std::string::size_type size)
+  {
+    std::size_t h = 2166136261u;
+    for (std::string::size_type n = 0; n < size; ++n)
+      h = (h ^ static_cast<unsigned char>(name[n])) * 16777619u;
+    return h;
+  }
+
+  bool equals(const std::string& s, const char* name, std::string::size_type size)
+  {
+    return s.size() == size && (size == 0 || std::memcmp(s.data(), name, size) == 0);
+  }
+
   void appendUrl(std::string& url, char ch)
   {
     static const char hex[] = "0123456789ABCDEF";
@@ -320,8 +378,154 @@ void QueryParams::parse_url(std::istream& url_stream)
   p.finish();
 }
 
+void QueryParams::parse_url_lazy(std::string url)
+{
+  // parameters added before stay in front of the new ones
+  if (!empty())
+  {
+    parse_url(url);
+    return;
+  }
+
+  _query.swap(url);
+
+  const char* data = _query.data();
+  std::string::size_type size = _query.size();
+
+  _spans.reserve(std::count(data, data + size, '&') + 1);
+
+  for (std::string::size_type pos = 0; pos < size; )
+  {
+    const char* amp = static_cast<const char*>(std::memchr(data + pos, '&', size - pos));
+    std::string::size_type end = amp ? amp - data : size;
+
+    if (end > pos)
+    {
+      _spans.push_back(Span());
+      Span& span = _spans.back();
+
+      // unnamed parameters have no '='
+      const char* eq = static_cast<const char*>(std::memchr(data + pos, '=', end - pos));
+      if (eq)
+      {
+        decode(data + pos, eq, span.name);
+        span.value = eq - data + 1;
+      }
+      else
+        span.value = pos;
+
+      span.valueSize = end - span.value;
+      span.hash = hashName(span.name.data(), span.name.size());
+      span.next = 0;
+      span.escaped = std::find_if(data + span.value, data + end, needsDecoding) != data + end;
+      span.decoded = false;
+    }
+
+    pos = end + 1;
+  }
+
+  if (_spans.empty())
+  {
+    _query.clear();
+    return;
+  }
+
+  size_type buckets = 1;
+  while (buckets < _spans.size())
+    buckets <<= 1;
+  _buckets.assign(buckets, 0);
+
+  // inserted from the back, so that the parameters with the same name are
+  // found in order
+  for (size_type n = _spans.size(); n > 0; --n)
+  {
+    size_type& first = _buckets[_spans[n - 1].hash & (buckets - 1)];
+    _spans[n - 1].next = first;
+    first = n;
+  }
+}
+
+const std::string& QueryParams::valueAt(size_type n) const
+{
+  if (_spans.empty())
+    return _values[n].value;
+
+  const Span& span = _spans[n];
+  if (!span.decoded)
+  {
+    const char* value = _query.data() + span.value;
+    span.decodedValue.clear();
+    decode(value, value + span.valueSize, span.decodedValue);
+    span.decoded = true;
+  }
+
+  return span.decodedValue;
+}
+
+void QueryParams::valueAt(size_type n, const char*& value, std::string::size_type& valueSize) const
+{
+  if (_spans.empty() || _spans[n].escaped)
+  {
+    const std::string& v = valueAt(n);
+    value = v.data();
+    valueSize = v.size();
+  }
+  else
+  {
+    value = _query.data() + _spans[n].value;
+    valueSize = _spans[n].valueSize;
+  }
+}
+
+QueryParams::size_type QueryParams::find(const char* name, std::string::size_type nameSize, size_type n) const
+{
+  if (_spans.empty())
+  {
+    for (size_type nn = 0; nn < _values.size(); ++nn)
+    {
+      if (equals(_values[nn].name, name, nameSize))
+      {
+        if (n == 0)
+          return nn;
+        --n;
+      }
+    }
+
+    return _values.size();
+  }
+
+  std::size_t h = hashName(name, nameSize);
+  for (size_type nn = _buckets[h & (_buckets.size() - 1)]; nn > 0; nn = _spans[nn - 1].next)
+  {
+    const Span& span = _spans[nn - 1];
+    if (span.hash == h && equals(span.name, name, nameSize))
+    {
+      if (n == 0)
+        return nn - 1;
+      --n;
+    }
+  }
+
+  return _spans.size();
+}
+
+void QueryParams::decodeAll()
+{
+  values_type values;
+  values.reserve(_spans.size());
+  for (size_type n = 0; n < _spans.size(); ++n)
+    values.push_back(value_type(_spans[n].name, valueAt(n)));
+
+  _values.swap(values);
+  _query.clear();
+  _spans.clear();
+  _buckets.clear();
+}
+
 QueryParams& QueryParams::remove(const std::string& name)
 {
+  materialize();
+
   for (size_type nn = 0; nn < _values.size(); )
   {
     if (_values[nn].name == name)
@@ -336,15 +540,9 @@ QueryParams& QueryParams::remove(const std::string& name)
 /// get nth named parameter.
 const std::string& QueryParams::param(const std::string& name, size_type n) const
 {
-  for (size_type nn = 0; nn < _values.size(); ++nn)
-  {
-    if (_values[nn].name == name)
-    {
-      if (n == 0)
-        return _values[nn].value;
-      --n;
-    }
-  }
+  size_type idx = find(name.data(), name.size(), n);
+  if (idx < count())
+    return valueAt(idx);
 
   static std::string emptyValue;
   return emptyValue;
@@ -353,17 +551,8 @@ const std::string& QueryParams::param(const std::string& name, size_type n) cons
 /// get nth named parameter with default value.
 std::string QueryParams::param(const std::string& name, size_type n, const std::string& def) const
 {
-  for (size_type nn = 0; nn < _values.size(); ++nn)
-  {
-    if (_values[nn].name == name)
-    {
-      if (n == 0)
-        return _values[nn].value;
-      --n;
-    }
-  }
-
-  return def;
+  size_type idx = find(name.data(), name.size(), n);
+  return idx < count() ? valueAt(idx) : def;
 }
 
 /// get number of parameters with the given name
@@ -371,9 +560,19 @@ QueryParams::size_type QueryParams::paramcount(const std::string& name) const
 {
   size_type count = 0;
 
-  for (size_type nn = 0; nn < _values.size(); ++nn)
-    if (_values[nn].name == name)
-      ++count;
+  if (_spans.empty())
+  {
+    for (size_type nn = 0; nn < _values.size(); ++nn)
+      if (_values[nn].name == name)
+        ++count;
+  }
+  else
+  {
+    std::size_t h = hashName(name.data(), name.size());
+    for (size_type nn = _buckets[h & (_buckets.size() - 1)]; nn > 0; nn = _spans[nn - 1].next)
+      if (_spans[nn - 1].hash == h && _spans[nn - 1].name == name)
+        ++count;
+  }
 
   return count;
 }
@@ -381,29 +580,25 @@ QueryParams::size_type QueryParams::paramcount(const std::string& name) const
 /// checks if the named parameter exists
 bool QueryParams::has(const std::string& name) const
 {
-  for (size_type nn = 0; nn < _values.size(); ++nn)
-    if (_values[nn].name == name)
-      return true;
-
-  return false;
+  return find(name.data(), name.size(), 0) < count();
 }
 
 /// get parameters as url
 std::string QueryParams::getUrl() const
 {
   std::string url;
-  for (size_type nn = 0; nn < _values.size(); ++nn)
+  for (size_type nn = 0; nn < count(); ++nn)
   {
     if (nn > 0)
       url += '&';
 
-    if (!_values[nn].name.empty())
+    if (!nameAt(nn).empty())
     {
-      appendUrl(url, _values[nn].name);
+      appendUrl(url, nameAt(nn));
       url += '=';
     }
 
-    appendUrl(url, _values[nn].value);
+    appendUrl(url, valueAt(nn));
   }
 
   return url;
@@ -411,8 +606,10 @@ std::string QueryParams::getUrl() const
 
 void operator<<= (cxxtools::SerializationInfo& si, const QueryParams& q)
 {
-    for (QueryParams::values_type::const_iterator it = q._values.begin(); it != q._values.end(); ++it)
+    for (QueryParams::size_type qn = 0; qn < q.count(); ++qn)
     {
+        const std::string& name = q.nameAt(qn);
+
         enum {
             state_0,
             state_key,
@@ -422,11 +619,11 @@ void operator<<= (cxxtools::SerializationInfo& si, const QueryParams& q)
         std::string nodename;
 
         cxxtools::SerializationInfo* current = &si;
-        log_debug("parse query param name <" << it->name << '>');
+        log_debug("parse query param name <" << name << '>');
 
-        for (unsigned n = 0; n < it->name.size(); ++n)
+        for (unsigned n = 0; n < name.size(); ++n)
         {
-            char ch = it->name[n];
+            char ch = name[n];
             switch (state)
             {
                 case state_0:
@@ -458,7 +655,7 @@ void operator<<= (cxxtools::SerializationInfo& si, const QueryParams& q)
                     }
                     else
                     {
-                        log_warn("invalid query param name <" << it->name.substr(0, n) << " *** " << it->name.substr(n) << "> (1)");
+                        log_warn("invalid query param name <" << name.substr(0, n) << " *** " << name.substr(n) << "> (1)");
                         SerializationError::doThrow("'[' expected in query parameters");
                     }
                     break;
@@ -466,8 +663,9 @@ void operator<<= (cxxtools::SerializationInfo& si, const QueryParams& q)
         }
 
         auto& m = current->addMember(nodename);
-        if (!it->value.empty())
-            m <<= Utf8Codec::decode(it->value);
+        const std::string& value = q.valueAt(qn);
+        if (!value.empty())
+            m <<= Utf8Codec::decode(value);
     }
 }
 
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cxxtools/rpccontext.h>
+#include <cxxtools/remoteexception.h>
+
+namespace cxxtools
+{
+
+namespace
+{
+    thread_local RpcContext* currentContext = 0;
+}
+
+const int RpcContext::Cancelled;
+
+RpcContext::RpcContext(Milliseconds timeout)
+    : _deadline(Clock::time_point::max()),
+      _cancelled(false)
+{
+    if (timeout >= Milliseconds(0))
+        _deadline = Clock::now() + std::chrono::milliseconds(static_cast<int64_t>(timeout.totalMSecs()));
+}
+
+Milliseconds RpcContext::remaining() const
+{
+    if (!hasDeadline())
+        return RemoteClient::WaitInfinite;
+
+    auto now = Clock::now();
+    if (now >= _deadline)
+        return Milliseconds(0);
+
+    // rounded up, so that a deadline, which is not reached, is not sent as 0
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(_deadline - now + std::chrono::microseconds(999));
+    return Milliseconds(ms.count());
+}
+
+void RpcContext::check() const
+{
+    if (_cancelled)
+        throw RemoteException("call cancelled", Cancelled);
+    if (expired())
+        throw RemoteException("deadline exceeded", Cancelled);
+}
+
+RpcContext* RpcContext::current()
+{
+    return currentContext;
+}
+
+RpcContext::Scope::Scope(RpcContext& context)
+    : _previous(currentContext)
+{
+    currentContext = &context;
+}
+
+RpcContext::Scope::~Scope()
+{
+    currentContext = _previous;
+}
+
+}
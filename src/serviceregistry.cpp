@@ -27,20 +27,56 @@
  */
 
 #include <cxxtools/serviceregistry.h>
+#include <algorithm>
 
 namespace cxxtools
 {
 
+std::unique_ptr<ServiceProcedure> ServiceProcedurePool::get()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_free.empty())
+        {
+            std::unique_ptr<ServiceProcedure> proc = std::move(_free.back());
+            _free.pop_back();
+            return proc;
+        }
+    }
+
+    std::unique_ptr<ServiceProcedure> proc(_procedure->clone());
+    proc->_pool = this;
+    return proc;
+}
+
+void ServiceProcedurePool::release(std::unique_ptr<ServiceProcedure>&& proc)
+{
+    if (!proc || !proc->_pool)
+        return;
+
+    ServiceProcedurePool* pool = proc->_pool;
+    std::lock_guard<std::mutex> lock(pool->_mutex);
+    pool->_free.push_back(std::move(proc));
+}
+
+
 std::unique_ptr<ServiceProcedure> ServiceRegistry::getProcedure(const std::string& name) const
 {
     ProcedureMap::const_iterator it = _procedures.find(name);
     if (it != _procedures.end())
-        return std::unique_ptr<ServiceProcedure>(it->second->clone());
+        return it->second->get();
     if (_defaultProcedure)
-        return std::unique_ptr<ServiceProcedure>(_defaultProcedure->clone());
+        return _defaultProcedure->get();
     return nullptr;
 }
 
+bool ServiceRegistry::isAsync(const std::string& name) const
+{
+    ProcedureMap::const_iterator it = _procedures.find(name);
+    if (it != _procedures.end())
+        return it->second->async();
+    return _defaultProcedure && _defaultProcedure->async();
+}
 
 std::vector<std::string> ServiceRegistry::getProcedureNames() const
 {
@@ -51,13 +87,16 @@ std::vector<std::string> ServiceRegistry::getProcedureNames() const
         procs.push_back(it->first);
     }
 
+    std::sort(procs.begin(), procs.end());
+
     return procs;
 }
 
 
 void ServiceRegistry::registerProcedure(const std::string& name, const ServiceProcedure& proc)
 {
-    _procedures.emplace(name, proc.clone());
+    if (_procedures.find(name) == _procedures.end())
+        _procedures.emplace(name, std::unique_ptr<ServiceProcedurePool>(new ServiceProcedurePool(proc)));
 }
 
 }
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <cxxtools/shardedcounters.h>
+#include <algorithm>
+
+namespace cxxtools
+{
+
+namespace
+{
+    const unsigned cacheLine = 64;
+    const unsigned cellsPerLine = cacheLine / sizeof(std::atomic<int64_t>);
+}
+
+const unsigned ShardedCounters::Shards;
+
+ShardedCounters::ShardedCounters(unsigned counters)
+    : _size(counters),
+      _stride((counters + cellsPerLine - 1) / cellsPerLine * cellsPerLine),
+      _first(0),
+      _cells(new std::atomic<int64_t>[Shards * _stride + cellsPerLine - 1])
+{
+    // start the first shard at a cache line boundary
+    while (reinterpret_cast<uintptr_t>(&_cells[_first]) % cacheLine != 0)
+        ++_first;
+
+    clear();
+}
+
+void ShardedCounters::max(unsigned counter, int64_t value)
+{
+    std::atomic<int64_t>& c = local(counter);
+    int64_t m = c.load(std::memory_order_relaxed);
+    while (value > m && !c.compare_exchange_weak(m, value, std::memory_order_relaxed))
+        ;
+}
+
+int64_t ShardedCounters::sum(unsigned counter) const
+{
+    int64_t s = 0;
+    for (unsigned n = 0; n < Shards; ++n)
+        s += cell(n, counter).load(std::memory_order_relaxed);
+    return s;
+}
+
+int64_t ShardedCounters::max(unsigned counter) const
+{
+    int64_t m = cell(0, counter).load(std::memory_order_relaxed);
+    for (unsigned n = 1; n < Shards; ++n)
+        m = std::max(m, cell(n, counter).load(std::memory_order_relaxed));
+    return m;
+}
+
+void ShardedCounters::clear()
+{
+    for (unsigned n = 0; n < Shards; ++n)
+        for (unsigned c = 0; c < _size; ++c)
+            cell(n, c).store(0, std::memory_order_relaxed);
+}
+
+unsigned ShardedCounters::shard()
+{
+    static std::atomic<unsigned> next(0);
+    static thread_local unsigned s = next.fetch_add(1, std::memory_order_relaxed) % Shards;
+    return s;
+}
+
+}
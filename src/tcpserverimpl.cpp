@@ -84,10 +84,12 @@ TcpServerImpl::TcpServerImpl(TcpServer& server)
     if (::pipe(_wakePipe))
         throwSystemError("pipe");
 
-    if (::fcntl(_wakePipe[0], O_CLOEXEC|O_NONBLOCK))
-        throwSystemError("fcntl(wakePipe)");
-    if (::fcntl(_wakePipe[1], O_CLOEXEC|O_NONBLOCK))
-        throwSystemError("fcntl(wakePipe)");
+    for (unsigned n = 0; n < 2; ++n)
+    {
+        if (::fcntl(_wakePipe[n], F_SETFD, FD_CLOEXEC) < 0
+          || ::fcntl(_wakePipe[n], F_SETFL, ::fcntl(_wakePipe[n], F_GETFL) | O_NONBLOCK) < 0)
+            throwSystemError("fcntl(wakePipe)");
+    }
 #endif
 
     log_debug("wake pipe read fd=" << _wakePipe[0] << " write fd=" << _wakePipe[1]);
@@ -68,6 +68,7 @@ void XmlRpcResponder::beginRequest(net::TcpSocket& /*socket*/, std::istream& is,
     _state = OnBegin;
     _ts.attach( is );
     _args = 0;
+    _service->releaseProcedure(std::move(_proc));
 }
 
 
@@ -181,6 +182,8 @@ void XmlRpcResponder::reply(std::ostream& os, http::Request& request, http::Repl
         _writer.writeEndElement(); // params
         _writer.writeEndElement(); // methodResponse
         _writer.flush();
+
+        _service->releaseProcedure(std::move(_proc));
     }
     catch (const RemoteException& fault)
     {
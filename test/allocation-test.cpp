@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include "cxxtools/http/server.h"
+#include "cxxtools/http/request.h"
+#include "cxxtools/http/reply.h"
+#include "cxxtools/http/responder.h"
+#include "cxxtools/http/service.h"
+#include "cxxtools/eventloop.h"
+#include "cxxtools/serviceregistry.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Counts the heap allocations of the thread handling the requests while
+// counting is enabled. The test replaces the global operator new and runs
+// in its own executable, so that the other tests keep the normal allocator.
+namespace
+{
+    std::atomic<bool> counting(false);
+    std::atomic<unsigned long> allocations(0);
+
+    // set in the thread, which handles the requests
+    thread_local bool countThread = false;
+
+    // result of the last call of the service registry test
+    int result;
+}
+
+void* operator new(std::size_t size)
+{
+    if (countThread && counting.load(std::memory_order_relaxed))
+        allocations.fetch_add(1, std::memory_order_relaxed);
+
+    void* p = std::malloc(size ? size : 1);
+    if (p == 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    class HelloResponder : public cxxtools::http::Responder
+    {
+        public:
+            explicit HelloResponder(cxxtools::http::Service& service)
+                : cxxtools::http::Responder(service)
+                { }
+
+            void reply(std::ostream& out, cxxtools::http::Request&, cxxtools::http::Reply& reply)
+            {
+                // the server has a single worker, which handles all requests
+                countThread = true;
+
+                reply.setHeader("Content-Type", "text/plain");
+                // longer than the small string buffer of std::string
+                for (unsigned n = 0; n < 20; ++n)
+                    out << "0123456789";
+                out << "hello";
+            }
+    };
+
+    // Runs the event loop in a separate thread while the object lives.
+    class LoopThread
+    {
+            cxxtools::EventLoop& _loop;
+            std::thread _thread;
+
+        public:
+            explicit LoopThread(cxxtools::EventLoop& loop)
+                : _loop(loop),
+                  _thread([&loop] { loop.run(); })
+                { }
+
+            ~LoopThread()
+            {
+                _loop.exit();
+                _thread.join();
+            }
+    };
+
+    // A minimal client on plain sockets, which does not allocate itself.
+    class RawClient
+    {
+            int _fd;
+            char _buffer[4096];
+
+        public:
+            RawClient()
+                : _fd(-1)
+                { }
+
+            ~RawClient()
+            {
+                if (_fd >= 0)
+                    ::close(_fd);
+            }
+
+            bool connect(unsigned short port)
+            {
+                _fd = ::socket(AF_INET, SOCK_STREAM, 0);
+                sockaddr_in addr;
+                std::memset(&addr, 0, sizeof(addr));
+                addr.sin_family = AF_INET;
+                addr.sin_port = htons(port);
+                addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                int on = 1;
+                ::setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                return ::connect(_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+            }
+
+            // Sends a request and returns the reply or an empty string on errors.
+            std::size_t get(const char* request, const char*& reply)
+            {
+                std::size_t len = std::strlen(request);
+                if (::write(_fd, request, len) != static_cast<ssize_t>(len))
+                    return 0;
+
+                std::size_t n = 0;
+                while (n < sizeof(_buffer))
+                {
+                    ssize_t r = ::read(_fd, _buffer + n, sizeof(_buffer) - n);
+                    if (r <= 0)
+                        return 0;
+                    n += r;
+
+                    // the body "hello" ends the reply
+                    if (n >= 5 && std::memcmp(_buffer + n - 5, "hello", 5) == 0)
+                        break;
+                }
+
+                reply = _buffer;
+                return n;
+            }
+    };
+}
+
+class AllocationTest : public cxxtools::unit::TestSuite
+{
+    private:
+        cxxtools::EventLoop _loop;
+        cxxtools::http::CachedService<HelloResponder> _service;
+        unsigned short _port;
+
+    public:
+        AllocationTest()
+        : cxxtools::unit::TestSuite("allocation"),
+          _port(8002)
+        {
+            registerMethod("KeepAliveRequest", *this, &AllocationTest::KeepAliveRequest);
+            registerMethod("ServiceRegistryCall", *this, &AllocationTest::ServiceRegistryCall);
+
+            char* PORT = getenv("UTEST_PORT");
+            if (PORT)
+            {
+                std::istringstream s(PORT);
+                s >> _port;
+            }
+        }
+
+        ////////////////////////////////////////////////////////////
+        // KeepAliveRequest
+        //
+        void KeepAliveRequest()
+        {
+            cxxtools::http::Server server(_loop, "127.0.0.1", _port);
+            server.minThreads(1);
+            server.maxThreads(1);
+            server.addService("hello/allocation/test", _service);
+
+            LoopThread loopThread(_loop);
+
+            RawClient client;
+            CXXTOOLS_UNIT_ASSERT(client.connect(_port));
+
+            const char* request = "GET /hello/allocation/test?first=1&second=2&third=3 HTTP/1.1\r\nHost: localhost\r\nUser-Agent: test\r\nAccept: */*\r\n\r\n";
+            const char* reply;
+
+            // the first requests may allocate buffers, which are kept
+            for (unsigned n = 0; n < 10; ++n)
+                CXXTOOLS_UNIT_ASSERT(client.get(request, reply) > 0);
+
+            allocations = 0;
+            counting = true;
+
+            unsigned failed = 0;
+            for (unsigned n = 0; n < 1000; ++n)
+                if (client.get(request, reply) == 0)
+                    ++failed;
+
+            counting = false;
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(failed, 0u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(allocations.load(), 0u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // ServiceRegistryCall
+        //
+        void ServiceRegistryCall()
+        {
+            cxxtools::ServiceRegistry registry;
+            registry.registerFunction("add", add);
+            registry.registerFunction("sub", sub);
+
+            std::string name = "add";
+            cxxtools::SerializationInfo a;
+            cxxtools::SerializationInfo b;
+            a <<= 2;
+            b <<= 3;
+
+            // the first call creates the procedure, which is kept
+            CXXTOOLS_UNIT_ASSERT_EQUALS(call(registry, name, a, b), 5);
+
+            allocations = 0;
+            countThread = true;
+            counting = true;
+
+            int sum = 0;
+            for (unsigned n = 0; n < 1000; ++n)
+                sum += call(registry, name, a, b);
+
+            counting = false;
+            countThread = false;
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(sum, 5000);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(allocations.load(), 0u);
+        }
+
+        // calls a procedure like the rpc servers do
+        static int call(cxxtools::ServiceRegistry& registry, const std::string& name,
+                        cxxtools::SerializationInfo& a, cxxtools::SerializationInfo& b)
+        {
+            std::unique_ptr<cxxtools::ServiceProcedure> proc = registry.getProcedure(name);
+            cxxtools::IComposers* args = proc->beginCall(name);
+            args->get()->fixup(a);
+            args->get()->fixup(b);
+            CXXTOOLS_UNIT_ASSERT(!args->needMore());
+            proc->endCall();
+            registry.releaseProcedure(std::move(proc));
+            return result;
+        }
+
+        static int add(int a, int b)
+        {
+            return result = a + b;
+        }
+
+        static int sub(int a, int b)
+        {
+            return result = a - b;
+        }
+};
+
+cxxtools::unit::RegisterTest<AllocationTest> register_AllocationTest;
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/*
+ Measures the throughput of a single bin rpc connection.
+
+ The benchmark starts a bin rpc server and calls a function over one client
+ connection, while keeping a fixed number of calls outstanding. With more
+ than one outstanding call the client multiplexes the calls on the
+ connection and the server runs them on its worker threads. The function
+ sleeps for a configurable time to simulate work done by the server.
+ */
+
+#include <cxxtools/bin/rpcserver.h>
+#include <cxxtools/bin/rpcclient.h>
+#include <cxxtools/remoteprocedure.h>
+#include <cxxtools/eventloop.h>
+#include <cxxtools/arg.h>
+#include <cxxtools/log.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    int work(int us)
+    {
+        if (us > 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(us));
+        return us;
+    }
+
+    class Caller : public cxxtools::Connectable
+    {
+            cxxtools::RemoteProcedure<int, int> _work;
+            int _us;
+            Clock::time_point _end;
+            unsigned& _running;
+            unsigned long& _calls;
+            unsigned long& _errors;
+            cxxtools::EventLoop& _loop;
+
+            void onFinished(cxxtools::RemoteResult<int>& result)
+            {
+                ++_calls;
+                if (result.failed() || result.get() != _us)
+                    ++_errors;
+
+                if (Clock::now() < _end)
+                    _work.begin(_us);
+                else if (--_running == 0)
+                    _loop.exit();
+            }
+
+        public:
+            Caller(cxxtools::RemoteClient& client, int us, Clock::time_point end,
+                   unsigned& running, unsigned long& calls, unsigned long& errors,
+                   cxxtools::EventLoop& loop)
+                : _work(client, "work"),
+                  _us(us),
+                  _end(end),
+                  _running(running),
+                  _calls(calls),
+                  _errors(errors),
+                  _loop(loop)
+            {
+                cxxtools::connect(_work.finished, *this, &Caller::onFinished);
+            }
+
+            void begin()
+            {
+                ++_running;
+                _work.begin(_us);
+            }
+    };
+
+    void measure(unsigned short port, unsigned outstanding, int us, double duration)
+    {
+        cxxtools::EventLoop loop;
+        cxxtools::bin::RpcClient client(loop, "127.0.0.1", port);
+
+        Clock::time_point start = Clock::now();
+        Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(duration));
+
+        unsigned running = 0;
+        unsigned long calls = 0;
+        unsigned long errors = 0;
+
+        std::vector<std::unique_ptr<Caller>> callers;
+        for (unsigned n = 0; n < outstanding; ++n)
+        {
+            callers.emplace_back(new Caller(client, us, end, running, calls, errors, loop));
+            callers.back()->begin();
+        }
+
+        loop.run();
+
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::cout << outstanding << " outstanding calls: "
+                  << calls << " calls in " << elapsed << " s, "
+                  << calls / elapsed << " calls/s"
+                  << "  errors " << errors << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        log_init(argc, argv);
+
+        cxxtools::Arg<unsigned short> port(argc, argv, 'p', 7006);
+        cxxtools::Arg<unsigned> threads(argc, argv, 't', 8);
+        cxxtools::Arg<unsigned> outstanding(argc, argv, 'n', 0);
+        cxxtools::Arg<int> us(argc, argv, 'w', 100);
+        cxxtools::Arg<double> duration(argc, argv, 'd', 5);
+
+        if (argc > 1)
+        {
+            std::cerr << "usage: " << argv[0] << " {options}\n"
+                         "options:\n"
+                         "  -p port      port of the server (7006)\n"
+                         "  -t threads   worker threads of the server (8)\n"
+                         "  -n number    outstanding calls (1, 16 and 256)\n"
+                         "  -w us        time spent in the server function in microseconds (100)\n"
+                         "  -d seconds   duration of each measurement (5)\n";
+            return 1;
+        }
+
+        cxxtools::EventLoop loop;
+        cxxtools::bin::RpcServer server(loop, "127.0.0.1", port);
+        server.registerFunction("work", work);
+        server.minThreads(threads);
+        server.maxThreads(threads);
+
+        std::thread loopThread([&loop] () { loop.run(); });
+
+        if (outstanding > 0)
+            measure(port, outstanding, us, duration);
+        else
+        {
+            measure(port, 1, us, duration);
+            measure(port, 16, us, duration);
+            measure(port, 256, us, duration);
+        }
+
+        loop.exit();
+        loopThread.join();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -29,16 +29,26 @@
 #include "cxxtools/unit/registertest.h"
 #include "cxxtools/bin/rpcclient.h"
 #include "cxxtools/bin/rpcserver.h"
+#include "cxxtools/bin/remotestream.h"
 #include "cxxtools/remoteexception.h"
 #include "cxxtools/remoteprocedure.h"
 #include "cxxtools/remoteprocedureva.h"
+#include "cxxtools/rpccontext.h"
 #include "cxxtools/eventloop.h"
 #include "cxxtools/log.h"
 #include "cxxtools/ioerror.h"
 #include "cxxtools/net/uri.h"
 #include "cxxtools/net/addrinfo.h"
+#include "cxxtools/net/tcpserver.h"
+#include "cxxtools/net/tcpstream.h"
+#include "cxxtools/bin/bin.h"
 #include <stdlib.h>
 #include <sstream>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
 
 #include "color.h"
 
@@ -50,6 +60,109 @@ namespace
     typedef std::multiset<int> IntMultiset;
     typedef std::map<int, int> IntMap;
     typedef std::multimap<int, int> IntMultimap;
+
+    // a struct with an optional member
+    struct Options
+    {
+        std::string name;
+    };
+
+    void operator>>=(const cxxtools::SerializationInfo& si, Options& options)
+    {
+        const cxxtools::SerializationInfo* name = si.findMember("name");
+        if (name)
+            *name >>= options.name;
+    }
+
+    void operator<<=(cxxtools::SerializationInfo& si, const Options& options)
+    {
+        si.setTypeName("options");
+        if (!options.name.empty())
+            si.addMember("name") <<= options.name;
+    }
+
+    // A server, which reads requests like servers before the protocol
+    // extensions. It knows just the procedure "answer" without parameters
+    // and closes the connection on any other first byte of a request.
+    class OldServer
+    {
+            cxxtools::net::TcpServer _server;
+            std::thread _thread;
+            std::atomic<int> _requests;
+            std::atomic<bool> _failed;
+
+            void run()
+            {
+                try
+                {
+                    while (true)
+                    {
+                        cxxtools::net::TcpStream conn(_server);
+                        serve(conn);
+                    }
+                }
+                catch (const std::exception&)
+                {
+                    // terminated
+                }
+            }
+
+            void serve(std::iostream& conn)
+            {
+                typedef std::char_traits<char> traits;
+
+                int ch;
+                while ((ch = conn.get()) != traits::eof())
+                {
+                    std::string domain;
+                    std::string method;
+
+                    if (ch == traits::to_int_type('\xc3'))
+                        std::getline(conn, domain, '\0');
+                    else if (ch != traits::to_int_type('\xc0'))
+                    {
+                        log_warn("unknown request byte " << ch);
+                        _failed = true;
+                        return;
+                    }
+
+                    std::getline(conn, method, '\0');
+                    if (conn.get() != traits::to_int_type('\xff'))
+                    {
+                        _failed = true;
+                        return;
+                    }
+
+                    ++_requests;
+
+                    if (domain.empty() && method == "answer")
+                        conn << '\xc1' << cxxtools::bin::Bin(42) << '\xff';
+                    else
+                        conn << '\xc2' << '\0' << '\0' << '\0' << '\0'
+                             << "unknown method \"" << method << '"' << '\0' << '\xff';
+
+                    conn.flush();
+                }
+            }
+
+        public:
+            explicit OldServer(unsigned short port)
+                : _server("127.0.0.1", port),
+                  _requests(0),
+                  _failed(false)
+            {
+                _thread = std::thread([this] () { run(); });
+            }
+
+            ~OldServer()
+            {
+                _server.terminateAccept();
+                _thread.join();
+            }
+
+            int requests() const  { return _requests; }
+            bool failed() const   { return _failed; }
+    };
 }
 
 class BinRpcTest : public cxxtools::unit::TestSuite
@@ -58,9 +171,21 @@ class BinRpcTest : public cxxtools::unit::TestSuite
         cxxtools::EventLoop _loop;
         cxxtools::bin::RpcServer* _server;
         unsigned _count;
+        std::vector<int> _finished;
+        unsigned _expected;
         std::string _listen;
         unsigned short _port;
 
+        // threads, which set the reply of asynchronous procedures
+        std::mutex _replyMutex;
+        std::vector<std::thread> _replyThreads;
+        std::atomic<int> _streamed;
+        std::atomic<bool> _streamStopped;
+        std::atomic<int> _started;
+        std::atomic<int> _cancelled;
+        std::atomic<int> _running;
+        std::atomic<int> _maxRunning;
+
     public:
         BinRpcTest()
         : cxxtools::unit::TestSuite("binrpc"),
@@ -75,6 +200,7 @@ class BinRpcTest : public cxxtools::unit::TestSuite
             registerMethod("Array", *this, &BinRpcTest::Array);
             registerMethod("EmptyArray", *this, &BinRpcTest::EmptyArray);
             registerMethod("Struct", *this, &BinRpcTest::Struct);
+            registerMethod("OptionalMember", *this, &BinRpcTest::OptionalMember);
             registerMethod("Set", *this, &BinRpcTest::Set);
             registerMethod("Multiset", *this, &BinRpcTest::Multiset);
             registerMethod("Map", *this, &BinRpcTest::Map);
@@ -96,6 +222,26 @@ class BinRpcTest : public cxxtools::unit::TestSuite
             registerMethod("Lambda", *this, &BinRpcTest::Lambda);
             registerMethod("TooManyArguments", *this, &BinRpcTest::TooManyArguments);
             registerMethod("MissingArguments", *this, &BinRpcTest::MissingArguments);
+            registerMethod("InvalidArgument", *this, &BinRpcTest::InvalidArgument);
+            registerMethod("Multiplexed", *this, &BinRpcTest::Multiplexed);
+            registerMethod("MultiplexedOrder", *this, &BinRpcTest::MultiplexedOrder);
+            registerMethod("MultiplexedFault", *this, &BinRpcTest::MultiplexedFault);
+            registerMethod("MultiplexedCancel", *this, &BinRpcTest::MultiplexedCancel);
+            registerMethod("MultiplexedLimit", *this, &BinRpcTest::MultiplexedLimit);
+            registerMethod("Async", *this, &BinRpcTest::Async);
+            registerMethod("AsyncFault", *this, &BinRpcTest::AsyncFault);
+            registerMethod("AsyncNoReply", *this, &BinRpcTest::AsyncNoReply);
+            registerMethod("AsyncMultiplexed", *this, &BinRpcTest::AsyncMultiplexed);
+            registerMethod("AsyncTerminate", *this, &BinRpcTest::AsyncTerminate);
+            registerMethod("Stream", *this, &BinRpcTest::Stream);
+            registerMethod("StreamFault", *this, &BinRpcTest::StreamFault);
+            registerMethod("StreamCancel", *this, &BinRpcTest::StreamCancel);
+            registerMethod("StreamMultiplexed", *this, &BinRpcTest::StreamMultiplexed);
+            registerMethod("Deadline", *this, &BinRpcTest::Deadline);
+            registerMethod("DeadlineExceeded", *this, &BinRpcTest::DeadlineExceeded);
+            registerMethod("DeadlineNested", *this, &BinRpcTest::DeadlineNested);
+            registerMethod("DeadlineDisconnect", *this, &BinRpcTest::DeadlineDisconnect);
+            registerMethod("DeadlineOldServer", *this, &BinRpcTest::DeadlineOldServer);
 
             char* PORT = getenv("UTEST_PORT");
             if (PORT)
@@ -126,6 +272,10 @@ class BinRpcTest : public cxxtools::unit::TestSuite
 
         void tearDown()
         {
+            for (auto& t: _replyThreads)
+                t.join();
+            _replyThreads.clear();
+
             delete _server;
         }
 
@@ -388,6 +538,33 @@ class BinRpcTest : public cxxtools::unit::TestSuite
             return color;
         }
 
+        ////////////////////////////////////////////////////////////
+        // OptionalMember
+        //
+        void OptionalMember()
+        {
+            _server->registerMethod("optionName", *this, &BinRpcTest::optionName);
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<std::string, Options> optionName(client, "optionName");
+
+            Options options;
+            options.name = "foo";
+            optionName.begin(options);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(optionName.end(2000), "foo");
+
+            // the second call gets the procedure of the first from the pool;
+            // the missing member must not keep the value of the first call
+            options.name.clear();
+            optionName.begin(options);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(optionName.end(2000), "");
+        }
+
+        std::string optionName(const Options& options)
+        {
+            return options.name;
+        }
+
         ////////////////////////////////////////////////////////////
         // Set
         //
@@ -888,6 +1065,755 @@ class BinRpcTest : public cxxtools::unit::TestSuite
             multiply.begin(2);
             CXXTOOLS_UNIT_ASSERT_THROW_MSG(_loop.run(), cxxtools::RemoteException, "more arguments");
         }
+
+        void InvalidArgument()
+        {
+            _server->registerMethod("multiply", *this, &BinRpcTest::multiplyInt);
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int, std::string, std::string> multiply(client, "multiply");
+
+            multiply.begin("x", "5");
+            CXXTOOLS_UNIT_ASSERT_THROW_MSG(multiply.end(2000), cxxtools::RemoteException, "failed to read argument");
+
+            // the rest of the request is read and the connection is usable
+            multiply.begin("7", "6");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(multiply.end(2000), 42);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // concurrent calls on one connection
+        //
+        void Multiplexed()
+        {
+            _server->registerMethod("multiply", *this, &BinRpcTest::multiplyDouble);
+
+            typedef cxxtools::RemoteProcedure<double, double, double> Multiply;
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            std::vector<Multiply> procs;
+            procs.reserve(16);
+
+            for (unsigned i = 0; i < 16; ++i)
+            {
+                procs.push_back(Multiply(client, "multiply"));
+                procs.back().begin(i, i);
+            }
+
+            for (unsigned i = 0; i < 16; ++i)
+            {
+                CXXTOOLS_UNIT_ASSERT_EQUALS(procs[i].end(2000), i*i);
+            }
+        }
+
+        void MultiplexedOrder()
+        {
+            _server->registerMethod("sleep", *this, &BinRpcTest::sleepAndReturn);
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int, int> first(client, "sleep");
+            cxxtools::RemoteProcedure<int, int> slow(client, "sleep");
+            cxxtools::RemoteProcedure<int, int> fast(client, "sleep");
+            connect(first.finished, *this, &BinRpcTest::onSleepFinished);
+            connect(slow.finished, *this, &BinRpcTest::onSleepFinished);
+            connect(fast.finished, *this, &BinRpcTest::onSleepFinished);
+
+            _finished.clear();
+            _expected = 3;
+
+            first.begin(0);
+            slow.begin(300);
+            fast.begin(1);
+
+            _loop.run();
+
+            // the fast call overtakes the slow one
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_finished.size(), 3u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_finished[0], 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_finished[1], 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_finished[2], 300);
+        }
+
+        void MultiplexedFault()
+        {
+            _server->registerMethod("sleep", *this, &BinRpcTest::sleepAndReturn);
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int, int> first(client, "sleep");
+            cxxtools::RemoteProcedure<int, int> fault(client, "sleep");
+            cxxtools::RemoteProcedure<int, int> last(client, "sleep");
+            connect(first.finished, *this, &BinRpcTest::onSleepFinished);
+            connect(fault.finished, *this, &BinRpcTest::onSleepFinished);
+            connect(last.finished, *this, &BinRpcTest::onSleepFinished);
+
+            _finished.clear();
+            _expected = 3;
+
+            first.begin(0);
+            fault.begin(-7);
+            last.begin(50);
+
+            _loop.run();
+
+            // the error is reported to its call only
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_finished.size(), 3u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_finished[0], 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_finished[1], -7);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_finished[2], 50);
+            CXXTOOLS_UNIT_ASSERT(fault.failed());
+            CXXTOOLS_UNIT_ASSERT(!last.failed());
+        }
+
+        void MultiplexedCancel()
+        {
+            _server->registerMethod("sleep", *this, &BinRpcTest::sleepAndReturn);
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int, int> first(client, "sleep");
+            cxxtools::RemoteProcedure<int, int> second(client, "sleep");
+
+            first.begin(0);
+            second.begin(0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(first.end(2000), 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(second.end(2000), 0);
+
+            first.begin(100);
+
+            {
+                // the reply of a cancelled call is skipped
+                cxxtools::RemoteProcedure<int, int> cancelled(client, "sleep");
+                cancelled.begin(20);
+            }
+
+            second.begin(50);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(first.end(2000), 100);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(second.end(2000), 50);
+        }
+
+        void MultiplexedLimit()
+        {
+            _server->registerMethod("sleep", *this, &BinRpcTest::sleepCounted);
+            _server->maxCallsPerConnection(2);
+
+            typedef cxxtools::RemoteProcedure<int, int> Sleep;
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+
+            // make the connection multiplexed
+            {
+                Sleep first(client, "sleep");
+                Sleep second(client, "sleep");
+                first.begin(0);
+                second.begin(0);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(first.end(2000), 0);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(second.end(2000), 0);
+            }
+
+            _running = 0;
+            _maxRunning = 0;
+
+            std::vector<Sleep> procs;
+            procs.reserve(8);
+            for (int i = 0; i < 8; ++i)
+            {
+                procs.push_back(Sleep(client, "sleep"));
+                procs.back().begin(50 + i);
+            }
+
+            // the server reads the further requests, when calls are finished
+            for (int i = 0; i < 8; ++i)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(procs[i].end(2000), 50 + i);
+
+            CXXTOOLS_UNIT_ASSERT(_maxRunning <= 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_maxRunning.load(), 2);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // asynchronous procedures
+        //
+        void Async()
+        {
+            _server->registerAsyncMethod("sleep", *this, &BinRpcTest::sleepAsync);
+
+            // one thread accepts connections, one runs the calls
+            _server->maxThreads(2);
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int, int> sleep(client, "sleep");
+
+            for (int i = 0; i < 3; ++i)
+            {
+                sleep.begin(10 * i);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(sleep.end(2000), 10 * i);
+            }
+        }
+
+        void AsyncFault()
+        {
+            _server->registerAsyncMethod("sleep", *this, &BinRpcTest::sleepAsync);
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int, int> sleep(client, "sleep");
+
+            sleep.begin(-7);
+            try
+            {
+                sleep.end(2000);
+                CXXTOOLS_UNIT_ASSERT_MSG(false, "cxxtools::RemoteException exception expected");
+            }
+            catch (const cxxtools::RemoteException& e)
+            {
+                CXXTOOLS_UNIT_ASSERT_EQUALS(e.rc(), -7);
+            }
+
+            // the connection is usable after the error
+            sleep.begin(1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(sleep.end(2000), 1);
+        }
+
+        void AsyncNoReply()
+        {
+            std::function<void (cxxtools::AsyncReply<int>, int)> noReply =
+                [] (cxxtools::AsyncReply<int>, int) { };
+            _server->registerAsyncFunction("noReply", noReply);
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int, int> proc(client, "noReply");
+
+            proc.begin(1);
+            CXXTOOLS_UNIT_ASSERT_THROW(proc.end(2000), cxxtools::RemoteException);
+        }
+
+        void AsyncMultiplexed()
+        {
+            _server->registerAsyncMethod("sleep", *this, &BinRpcTest::sleepAsync);
+            _server->maxThreads(2);
+
+            typedef cxxtools::RemoteProcedure<int, int> Sleep;
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            std::vector<Sleep> procs;
+            procs.reserve(16);
+
+            auto start = std::chrono::steady_clock::now();
+
+            // more calls than threads wait at the same time
+            for (int i = 0; i < 16; ++i)
+            {
+                procs.push_back(Sleep(client, "sleep"));
+                procs.back().begin(200 + i);
+            }
+
+            for (int i = 0; i < 16; ++i)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(procs[i].end(2000), 200 + i);
+
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            CXXTOOLS_UNIT_ASSERT(elapsed < std::chrono::milliseconds(1000));
+        }
+
+        void AsyncTerminate()
+        {
+            // the procedure keeps its reply and sends it, when the server is gone
+            std::mutex mutex;
+            std::vector<cxxtools::AsyncReply<int>> pending;
+            std::function<void (cxxtools::AsyncReply<int>, int)> keep =
+                [this, &mutex, &pending] (cxxtools::AsyncReply<int> reply, int) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    pending.push_back(reply);
+                    _loop.exit();
+                };
+            _server->registerAsyncFunction("keep", keep);
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int, int> proc(client, "keep");
+            proc.begin(1);
+
+            _loop.run();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pending.size(), 1u);
+
+            delete _server;
+            _server = 0;
+
+            pending.front().reply(5);
+            pending.clear();
+
+            CXXTOOLS_UNIT_ASSERT_THROW(proc.end(2000), std::exception);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Stream
+        //
+        void Stream()
+        {
+            _server->registerStreamMethod("count", *this, &BinRpcTest::count);
+            _server->registerMethod("multiply", *this, &BinRpcTest::multiplyInt);
+
+            std::thread loopThread([this] () { _loop.run(); });
+
+            try
+            {
+                cxxtools::bin::RpcClient client(_listen, _port);
+                cxxtools::bin::RemoteStream<int, int> numbers(client, "count");
+
+                numbers.begin(10000);
+                int value;
+                int expected = 0;
+                while (numbers.next(value))
+                {
+                    CXXTOOLS_UNIT_ASSERT_EQUALS(value, expected);
+                    ++expected;
+                }
+
+                CXXTOOLS_UNIT_ASSERT_EQUALS(expected, 10000);
+                CXXTOOLS_UNIT_ASSERT(!numbers.running());
+
+                // the connection is usable after the stream
+                cxxtools::RemoteProcedure<int, int, int> multiply(client, "multiply");
+                CXXTOOLS_UNIT_ASSERT_EQUALS(multiply(2, 3), 6);
+
+                numbers.begin(0);
+                CXXTOOLS_UNIT_ASSERT(!numbers.next(value));
+
+                int sum = 0;
+                numbers.begin(5);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(numbers.forEach([&sum] (int v) { sum += v; }), 5u);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(sum, 10);
+            }
+            catch (...)
+            {
+                _loop.exit();
+                loopThread.join();
+                throw;
+            }
+
+            _loop.exit();
+            loopThread.join();
+        }
+
+        void StreamFault()
+        {
+            _server->registerStreamMethod("count", *this, &BinRpcTest::count);
+
+            std::thread loopThread([this] () { _loop.run(); });
+
+            try
+            {
+                cxxtools::bin::RpcClient client(_listen, _port);
+                cxxtools::bin::RemoteStream<int, int> numbers(client, "count");
+
+                // negative counts fail after 3 elements
+                numbers.begin(-42);
+                int value;
+                for (int i = 0; i < 3; ++i)
+                {
+                    CXXTOOLS_UNIT_ASSERT(numbers.next(value));
+                    CXXTOOLS_UNIT_ASSERT_EQUALS(value, i);
+                }
+
+                try
+                {
+                    numbers.next(value);
+                    CXXTOOLS_UNIT_ASSERT_MSG(false, "cxxtools::RemoteException exception expected");
+                }
+                catch (const cxxtools::RemoteException& e)
+                {
+                    CXXTOOLS_UNIT_ASSERT_EQUALS(e.rc(), 42);
+                }
+
+                CXXTOOLS_UNIT_ASSERT(!numbers.running());
+
+                numbers.begin(2);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(numbers.forEach([] (int) { }), 2u);
+            }
+            catch (...)
+            {
+                _loop.exit();
+                loopThread.join();
+                throw;
+            }
+
+            _loop.exit();
+            loopThread.join();
+        }
+
+        void StreamCancel()
+        {
+            _server->registerStreamMethod("count", *this, &BinRpcTest::count);
+
+            std::thread loopThread([this] () { _loop.run(); });
+
+            try
+            {
+                _streamed = 0;
+                _streamStopped = false;
+
+                {
+                    cxxtools::bin::RpcClient client(_listen, _port);
+                    cxxtools::bin::RemoteStream<int, int> numbers(client, "count");
+
+                    numbers.begin(100000000);
+                    int value;
+                    for (int i = 0; i < 10; ++i)
+                        CXXTOOLS_UNIT_ASSERT(numbers.next(value));
+
+                    // the server stops, when the socket buffers are full,
+                    // and waits for the client to read the elements
+                    int streamed = -1;
+                    for (int i = 0; i < 40 && streamed != _streamed; ++i)
+                    {
+                        streamed = _streamed;
+                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    }
+
+                    CXXTOOLS_UNIT_ASSERT_EQUALS(_streamed.load(), streamed);
+                    CXXTOOLS_UNIT_ASSERT(streamed < 10000000);
+                }
+
+                // dropping the stream stops the procedure
+                for (int i = 0; i < 200 && !_streamStopped; ++i)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+                CXXTOOLS_UNIT_ASSERT(_streamStopped.load());
+                CXXTOOLS_UNIT_ASSERT(_streamed < 100000000);
+            }
+            catch (...)
+            {
+                _loop.exit();
+                loopThread.join();
+                throw;
+            }
+
+            _loop.exit();
+            loopThread.join();
+        }
+
+        void StreamMultiplexed()
+        {
+            _server->registerStreamMethod("count", *this, &BinRpcTest::count);
+            _server->registerMethod("multiply", *this, &BinRpcTest::multiplyInt);
+
+            typedef cxxtools::RemoteProcedure<int, int, int> Multiply;
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            Multiply first(client, "multiply");
+            Multiply second(client, "multiply");
+
+            // concurrent calls make the connection multiplexed
+            first.begin(2, 3);
+            second.begin(4, 5);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(first.end(2000), 6);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(second.end(2000), 20);
+
+            // the stream is read synchronously on a new plain connection
+            client.timeout(2000);
+            cxxtools::bin::RemoteStream<int, int> numbers(client, "count");
+            numbers.begin(3);
+
+            int value;
+            int expected = 0;
+            while (numbers.next(value))
+            {
+                CXXTOOLS_UNIT_ASSERT_EQUALS(value, expected);
+                ++expected;
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(expected, 3);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Deadline
+        //
+        void Deadline()
+        {
+            _server->registerMethod("remaining", *this, &BinRpcTest::remaining);
+            _server->registerMethod("waitCancelled", *this, &BinRpcTest::waitCancelled);
+            _cancelled = 0;
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int> remaining(client, "remaining");
+            cxxtools::RemoteProcedure<int, int> waitCancelled(client, "waitCancelled");
+
+            // without deadline nothing is sent
+            remaining.begin();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(remaining.end(2000), -1);
+
+            {
+                cxxtools::RpcContext context(cxxtools::Milliseconds(5000));
+                cxxtools::RpcContext::Scope scope(context);
+                remaining.begin();
+            }
+
+            int r = remaining.end(2000);
+            CXXTOOLS_UNIT_ASSERT(r > 0);
+            CXXTOOLS_UNIT_ASSERT(r <= 5000);
+
+            // the procedure sees, when the deadline passes
+            {
+                cxxtools::RpcContext context(cxxtools::Milliseconds(200));
+                cxxtools::RpcContext::Scope scope(context);
+                waitCancelled.begin(2000);
+            }
+
+            int elapsed = waitCancelled.end(2000);
+            CXXTOOLS_UNIT_ASSERT(elapsed >= 150);
+            CXXTOOLS_UNIT_ASSERT(elapsed < 1500);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_cancelled.load(), 1);
+        }
+
+        void DeadlineExceeded()
+        {
+            _server->registerMethod("waitCancelled", *this, &BinRpcTest::waitCancelled);
+            _started = 0;
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int, int> waitCancelled(client, "waitCancelled");
+
+            {
+                cxxtools::RpcContext context(cxxtools::Milliseconds(0));
+                cxxtools::RpcContext::Scope scope(context);
+                waitCancelled.begin(10);
+            }
+
+            try
+            {
+                waitCancelled.end(2000);
+                CXXTOOLS_UNIT_ASSERT_MSG(false, "cxxtools::RemoteException exception expected");
+            }
+            catch (const cxxtools::RemoteException& e)
+            {
+                CXXTOOLS_UNIT_ASSERT_EQUALS(e.rc(), cxxtools::RpcContext::Cancelled);
+            }
+
+            // the expired call is not run
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_started.load(), 0);
+
+            waitCancelled.begin(0);
+            waitCancelled.end(2000);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_started.load(), 1);
+        }
+
+        void DeadlineNested()
+        {
+            _server->registerMethod("remaining", *this, &BinRpcTest::remaining);
+            _server->registerMethod("nestedRemaining", *this, &BinRpcTest::nestedRemaining);
+
+            // the nested call needs a thread of its own
+            _server->maxThreads(4);
+
+            cxxtools::bin::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int> nestedRemaining(client, "nestedRemaining");
+
+            nestedRemaining.begin();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(nestedRemaining.end(2000), -1);
+
+            {
+                cxxtools::RpcContext context(cxxtools::Milliseconds(1000));
+                cxxtools::RpcContext::Scope scope(context);
+                nestedRemaining.begin();
+            }
+
+            int r = nestedRemaining.end(2000);
+            CXXTOOLS_UNIT_ASSERT(r > 0);
+            CXXTOOLS_UNIT_ASSERT(r <= 1000);
+        }
+
+        void DeadlineDisconnect()
+        {
+            _server->registerMethod("waitCancelled", *this, &BinRpcTest::waitCancelled);
+            _server->maxThreads(4);
+
+            {
+                cxxtools::bin::RpcClient client(_loop, _listen, _port);
+                cxxtools::RemoteProcedure<int, int> wait1(client, "waitCancelled");
+                cxxtools::RemoteProcedure<int, int> wait2(client, "waitCancelled");
+
+                // two calls at a time make the connection multiplexed
+                wait1.begin(0);
+                wait2.begin(0);
+                wait1.end(2000);
+                wait2.end(2000);
+
+                _started = 0;
+                _cancelled = 0;
+
+                wait1.begin(5000);
+                wait2.begin(5000);
+
+                for (int i = 0; i < 200 && _started < 2; ++i)
+                    _loop.wait(10);
+
+                CXXTOOLS_UNIT_ASSERT_EQUALS(_started.load(), 2);
+            }
+
+            // the server cancels the running calls of the closed connection
+            for (int i = 0; i < 200 && _cancelled < 2; ++i)
+                _loop.wait(10);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_cancelled.load(), 2);
+        }
+
+        void DeadlineOldServer()
+        {
+            OldServer server(_port + 1);
+
+            {
+                cxxtools::bin::RpcClient client("127.0.0.1", _port + 1);
+                cxxtools::RemoteProcedure<int> answer(client, "answer");
+
+                cxxtools::RpcContext context(cxxtools::Milliseconds(5000));
+                cxxtools::RpcContext::Scope scope(context);
+
+                // the server is asked once, then the requests are sent without deadline
+                CXXTOOLS_UNIT_ASSERT_EQUALS(answer(), 42);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(answer(), 42);
+                CXXTOOLS_UNIT_ASSERT(!server.failed());
+                CXXTOOLS_UNIT_ASSERT_EQUALS(server.requests(), 3);
+            }
+
+            {
+                cxxtools::bin::RpcClient client(_loop, "127.0.0.1", _port + 1);
+                cxxtools::RemoteProcedure<int> answer1(client, "answer");
+                cxxtools::RemoteProcedure<int> answer2(client, "answer");
+                cxxtools::RemoteProcedure<int> answer3(client, "answer");
+
+                answer1.begin();
+
+                // asks for deadlines together with tagged requests
+                {
+                    cxxtools::RpcContext context(cxxtools::Milliseconds(5000));
+                    cxxtools::RpcContext::Scope scope(context);
+                    answer2.begin();
+                }
+
+                CXXTOOLS_UNIT_ASSERT_EQUALS(answer1.end(2000), 42);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(answer2.end(2000), 42);
+
+                {
+                    cxxtools::RpcContext context(cxxtools::Milliseconds(5000));
+                    cxxtools::RpcContext::Scope scope(context);
+                    answer3.begin();
+                }
+
+                CXXTOOLS_UNIT_ASSERT_EQUALS(answer3.end(2000), 42);
+                CXXTOOLS_UNIT_ASSERT(!server.failed());
+                CXXTOOLS_UNIT_ASSERT_EQUALS(server.requests(), 3 + 5);
+            }
+        }
+
+        // returns the time left of the deadline of the call or -1
+        int remaining()
+        {
+            cxxtools::RpcContext* context = cxxtools::RpcContext::current();
+            if (context == 0 || !context->hasDeadline())
+                return -1;
+            return static_cast<int>(context->remaining().totalMSecs());
+        }
+
+        int nestedRemaining()
+        {
+            cxxtools::bin::RpcClient client(_listen, _port);
+            cxxtools::RemoteProcedure<int> remaining(client, "remaining");
+            return remaining();
+        }
+
+        // waits at most ms milliseconds for the call to be cancelled and
+        // returns the time waited
+        int waitCancelled(int ms)
+        {
+            ++_started;
+
+            cxxtools::RpcContext* context = cxxtools::RpcContext::current();
+            auto start = std::chrono::steady_clock::now();
+            auto elapsed = std::chrono::milliseconds(0);
+            while (!context->cancelled() && elapsed < std::chrono::milliseconds(ms))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            }
+
+            if (context->cancelled())
+                ++_cancelled;
+
+            return static_cast<int>(elapsed.count());
+        }
+
+        // writes the numbers 0 to n-1; a negative n fails with rc -n after 3 numbers
+        void count(cxxtools::StreamWriter<int>& out, int n)
+        {
+            try
+            {
+                if (n < 0)
+                {
+                    for (int i = 0; i < 3; ++i)
+                        out << i;
+                    throw cxxtools::RemoteException("count failed", -n);
+                }
+
+                for (int i = 0; i < n; ++i)
+                {
+                    out << i;
+                    ++_streamed;
+                }
+            }
+            catch (...)
+            {
+                _streamStopped = true;
+                throw;
+            }
+
+            _streamStopped = true;
+        }
+
+        // replies from another thread after the passed time
+        void sleepAsync(cxxtools::AsyncReply<int> reply, int ms)
+        {
+            if (ms < 0)
+            {
+                reply.fail("negative sleep time", ms);
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(_replyMutex);
+            _replyThreads.emplace_back([reply, ms] () mutable {
+                std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+                reply.reply(ms);
+            });
+        }
+
+        int sleepAndReturn(int ms)
+        {
+            if (ms < 0)
+                throw cxxtools::RemoteException("negative sleep time", ms);
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+            return ms;
+        }
+
+        int sleepCounted(int ms)
+        {
+            int running = ++_running;
+            int m = _maxRunning;
+            while (running > m && !_maxRunning.compare_exchange_weak(m, running))
+                ;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+            --_running;
+            return ms;
+        }
+
+        void onSleepFinished(cxxtools::RemoteResult<int>& r)
+        {
+            try
+            {
+                _finished.push_back(r.get());
+            }
+            catch (const cxxtools::RemoteException& e)
+            {
+                _finished.push_back(e.rc());
+            }
+
+            if (_finished.size() >= _expected)
+                _loop.exit();
+        }
 };
 
 cxxtools::unit::RegisterTest<BinRpcTest> register_BinRpcTest;
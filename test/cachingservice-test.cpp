@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include "cxxtools/http/server.h"
+#include "cxxtools/http/cachingservice.h"
+#include "cxxtools/http/clientpool.h"
+#include "cxxtools/http/request.h"
+#include "cxxtools/http/reply.h"
+#include "cxxtools/http/responder.h"
+#include "cxxtools/http/service.h"
+#include "cxxtools/net/addrinfo.h"
+#include "cxxtools/eventloop.h"
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Replies with the url and the number of calls. The cache control
+    // header depends on the url.
+    class CountingService : public cxxtools::http::Service
+    {
+            class CountingResponder : public cxxtools::http::Responder
+            {
+                    CountingService& _service;
+
+                public:
+                    explicit CountingResponder(CountingService& service)
+                        : cxxtools::http::Responder(service),
+                          _service(service)
+                        { }
+
+                    void reply(std::ostream& out, cxxtools::http::Request& request, cxxtools::http::Reply& reply)
+                    {
+                        unsigned n = ++_service.calls;
+                        const std::string& url = request.url();
+
+                        if (url == "/nostore")
+                            reply.setHeader("Cache-Control", "no-store");
+                        else if (url != "/plain")
+                            reply.setHeader("Cache-Control", "public, max-age=60");
+
+                        if (url == "/slow")
+                            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+                        out << url << ' ' << n;
+                        if (url.compare(0, 5, "/big/") == 0)
+                            out << std::string(1000, 'x');
+                    }
+            };
+
+        public:
+            std::atomic<unsigned> calls;
+
+            CountingService()
+                : calls(0)
+                { }
+
+        protected:
+            cxxtools::http::Responder* createResponder(const cxxtools::http::Request&)
+                { return new CountingResponder(*this); }
+
+            void releaseResponder(cxxtools::http::Responder* resp)
+                { delete resp; }
+    };
+}
+
+class CachingServiceTest : public cxxtools::unit::TestSuite
+{
+    private:
+        cxxtools::EventLoop _loop;
+        cxxtools::http::Server* _server;
+        CountingService _service;
+        cxxtools::http::CachingService* _cache;
+        std::string _listen;
+        unsigned short _port;
+
+    public:
+        CachingServiceTest()
+        : cxxtools::unit::TestSuite("cachingservice"),
+          _port(8002)
+        {
+            registerMethod("Hit", *this, &CachingServiceTest::Hit);
+            registerMethod("NoStore", *this, &CachingServiceTest::NoStore);
+            registerMethod("DefaultTtl", *this, &CachingServiceTest::DefaultTtl);
+            registerMethod("KeyHeader", *this, &CachingServiceTest::KeyHeader);
+            registerMethod("SingleFlight", *this, &CachingServiceTest::SingleFlight);
+            registerMethod("MemoryLimit", *this, &CachingServiceTest::MemoryLimit);
+
+            char* PORT = getenv("UTEST_PORT");
+            if (PORT)
+            {
+                std::istringstream s(PORT);
+                s >> _port;
+            }
+
+            char* LISTEN = getenv("UTEST_LISTEN");
+            if (LISTEN)
+                _listen = LISTEN;
+        }
+
+        void setUp()
+        {
+            _service.calls = 0;
+            _cache = new cxxtools::http::CachingService(_service);
+            _server = new cxxtools::http::Server(_loop, _listen, _port);
+            _server->minThreads(1);
+            _server->maxThreads(8);
+            _server->addPrefixService("", *_cache);
+        }
+
+        void tearDown()
+        {
+            delete _server;
+            delete _cache;
+        }
+
+        cxxtools::net::AddrInfo addr() const
+        {
+            return cxxtools::net::AddrInfo(_listen.empty() ? "127.0.0.1" : _listen, _port);
+        }
+
+        std::string get(cxxtools::http::ClientPool& pool, const cxxtools::http::Request& request)
+        {
+            const cxxtools::http::Reply& reply = pool.execute(addr(), request, cxxtools::Seconds(5));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reply.httpReturnCode(), 200);
+            return reply.body();
+        }
+
+        std::string get(cxxtools::http::ClientPool& pool, const std::string& url)
+        {
+            return get(pool, cxxtools::http::Request(url));
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Hit
+        //
+        void Hit()
+        {
+            cxxtools::http::ClientPool pool(_loop);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/max"), "/max 1");
+            const cxxtools::http::Reply& reply = pool.execute(addr(), cxxtools::http::Request("/max"), cxxtools::Seconds(5));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reply.body(), "/max 1");
+            CXXTOOLS_UNIT_ASSERT(reply.hasHeader("Age"));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(reply.getHeader("Cache-Control")), "public, max-age=60");
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/max?a=1"), "/max 2");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/max?a=1"), "/max 2");
+
+            // the client may ask to bypass the cache
+            cxxtools::http::Request request("/max");
+            request.setHeader("Cache-Control", "no-cache");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, request), "/max 3");
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_service.calls, 3u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_cache->hits(), 2u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_cache->misses(), 2u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_cache->entries(), 2u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // NoStore
+        //
+        void NoStore()
+        {
+            cxxtools::http::ClientPool pool(_loop);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/nostore"), "/nostore 1");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/nostore"), "/nostore 2");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/plain"), "/plain 3");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/plain"), "/plain 4");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_cache->entries(), 0u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // DefaultTtl
+        //
+        void DefaultTtl()
+        {
+            _cache->defaultTtl(cxxtools::Milliseconds(100));
+            cxxtools::http::ClientPool pool(_loop);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/plain"), "/plain 1");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/plain"), "/plain 1");
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(150));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/plain"), "/plain 2");
+        }
+
+        ////////////////////////////////////////////////////////////
+        // KeyHeader
+        //
+        void KeyHeader()
+        {
+            _cache->addKeyHeader("Accept-Language");
+            cxxtools::http::ClientPool pool(_loop);
+
+            cxxtools::http::Request de("/max");
+            de.setHeader("Accept-Language", "de");
+            cxxtools::http::Request en("/max");
+            en.setHeader("Accept-Language", "en");
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, de), "/max 1");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, en), "/max 2");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, de), "/max 1");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, en), "/max 2");
+        }
+
+        ////////////////////////////////////////////////////////////
+        // SingleFlight
+        //
+        void SingleFlight()
+        {
+            cxxtools::http::ClientPool pool(_loop);
+
+            std::vector<unsigned> ids;
+            for (unsigned n = 0; n < 4; ++n)
+                ids.push_back(pool.beginExecute(addr(), cxxtools::http::Request("/slow")));
+
+            for (unsigned n = 0; n < ids.size(); ++n)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(pool.endExecute(ids[n], cxxtools::Seconds(5)).body(), "/slow 1");
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_service.calls, 1u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // MemoryLimit
+        //
+        void MemoryLimit()
+        {
+            _cache->maxBytes(4000);
+            cxxtools::http::ClientPool pool(_loop);
+
+            for (unsigned n = 0; n < 5; ++n)
+            {
+                std::ostringstream url;
+                url << "/big/" << n;
+                get(pool, url.str());
+            }
+
+            CXXTOOLS_UNIT_ASSERT(_cache->bytes() <= 4000);
+            CXXTOOLS_UNIT_ASSERT(_cache->entries() < 5);
+
+            // the least recently used entry is dropped
+            get(pool, "/big/0");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_service.calls, 6u);
+            get(pool, "/big/4");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_service.calls, 6u);
+        }
+};
+
+cxxtools::unit::RegisterTest<CachingServiceTest> register_CachingServiceTest;
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include "cxxtools/http/server.h"
+#include "cxxtools/http/clientpool.h"
+#include "cxxtools/http/request.h"
+#include "cxxtools/http/reply.h"
+#include "cxxtools/http/responder.h"
+#include "cxxtools/http/service.h"
+#include "cxxtools/net/addrinfo.h"
+#include "cxxtools/eventloop.h"
+#include "cxxtools/ioerror.h"
+#include "cxxtools/clock.h"
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Replies with the url after a short delay and records the maximum
+    // number of requests processed concurrently.
+    class SlowService : public cxxtools::http::Service
+    {
+            class SlowResponder : public cxxtools::http::Responder
+            {
+                    SlowService& _service;
+
+                public:
+                    explicit SlowResponder(SlowService& service)
+                        : cxxtools::http::Responder(service),
+                          _service(service)
+                        { }
+
+                    void reply(std::ostream& out, cxxtools::http::Request& request, cxxtools::http::Reply&)
+                    {
+                        unsigned running = ++_service._running;
+                        unsigned max = _service._maxRunning;
+                        while (running > max && !_service._maxRunning.compare_exchange_weak(max, running))
+                            ;
+
+                        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                        out << request.url();
+                        --_service._running;
+                    }
+            };
+
+            std::atomic<unsigned> _running;
+            std::atomic<unsigned> _maxRunning;
+
+        public:
+            SlowService()
+                : _running(0),
+                  _maxRunning(0)
+                { }
+
+            unsigned maxRunning() const
+                { return _maxRunning; }
+
+        protected:
+            cxxtools::http::Responder* createResponder(const cxxtools::http::Request&)
+                { return new SlowResponder(*this); }
+
+            void releaseResponder(cxxtools::http::Responder* resp)
+                { delete resp; }
+    };
+}
+
+class ClientPoolTest : public cxxtools::unit::TestSuite
+{
+    private:
+        cxxtools::EventLoop _loop;
+        cxxtools::http::Server* _server;
+        SlowService _service;
+        std::string _listen;
+        unsigned short _port;
+
+    public:
+        ClientPoolTest()
+        : cxxtools::unit::TestSuite("clientpool"),
+          _port(8002)
+        {
+            registerMethod("Reuse", *this, &ClientPoolTest::Reuse);
+            registerMethod("Concurrent", *this, &ClientPoolTest::Concurrent);
+            registerMethod("IdleTimeout", *this, &ClientPoolTest::IdleTimeout);
+            registerMethod("ConnectFailed", *this, &ClientPoolTest::ConnectFailed);
+
+            char* PORT = getenv("UTEST_PORT");
+            if (PORT)
+            {
+                std::istringstream s(PORT);
+                s >> _port;
+            }
+
+            char* LISTEN = getenv("UTEST_LISTEN");
+            if (LISTEN)
+                _listen = LISTEN;
+
+            _loop.setIdleTimeout(2000);
+            connect(_loop.timeout, *this, &ClientPoolTest::failTest);
+            connect(_loop.timeout, _loop, &cxxtools::EventLoop::exit);
+        }
+
+        void failTest()
+        {
+            throw cxxtools::unit::Assertion("test timed out", CXXTOOLS_SOURCEINFO);
+        }
+
+        void setUp()
+        {
+            _server = new cxxtools::http::Server(_loop, _listen, _port);
+            _server->minThreads(1);
+            _server->maxThreads(8);
+            _server->addPrefixService("", _service);
+        }
+
+        void tearDown()
+        {
+            delete _server;
+        }
+
+        cxxtools::net::AddrInfo addr() const
+        {
+            return cxxtools::net::AddrInfo(_listen.empty() ? "127.0.0.1" : _listen, _port);
+        }
+
+        // Runs the event loop for the passed time.
+        void runLoop(cxxtools::Milliseconds ms)
+        {
+            cxxtools::Timespan end = cxxtools::Clock::getSystemTicks() + ms;
+            while (cxxtools::Clock::getSystemTicks() < end)
+                _loop.wait(10);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Reuse
+        //
+        void Reuse()
+        {
+            cxxtools::http::ClientPool pool(_loop);
+
+            for (unsigned n = 0; n < 5; ++n)
+            {
+                const cxxtools::http::Reply& reply = pool.execute(addr(), cxxtools::http::Request("/a"), cxxtools::Seconds(2));
+                CXXTOOLS_UNIT_ASSERT_EQUALS(reply.httpReturnCode(), 200);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(reply.body(), "/a");
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.connectionsOpened(), 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.connectionsReused(), 4);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.idleConnections(), 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.activeConnections(), 0);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Concurrent
+        //
+        void Concurrent()
+        {
+            cxxtools::http::ClientPool pool(_loop);
+            pool.maxConnectionsPerHost(3);
+
+            std::vector<unsigned> ids;
+            for (unsigned n = 0; n < 12; ++n)
+            {
+                std::ostringstream url;
+                url << "/r" << n;
+                ids.push_back(pool.beginExecute(addr(), cxxtools::http::Request(url.str())));
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.activeConnections(), 3);
+
+            for (unsigned n = 0; n < ids.size(); ++n)
+            {
+                std::ostringstream url;
+                url << "/r" << n;
+                CXXTOOLS_UNIT_ASSERT_EQUALS(pool.endExecute(ids[n], cxxtools::Seconds(2)).body(), url.str());
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.connectionsOpened(), 3);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.connectionsReused(), 9);
+            CXXTOOLS_UNIT_ASSERT(_service.maxRunning() > 1);
+            CXXTOOLS_UNIT_ASSERT(_service.maxRunning() <= 3);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // IdleTimeout
+        //
+        void IdleTimeout()
+        {
+            cxxtools::http::ClientPool pool(_loop);
+            pool.idleTimeout(cxxtools::Milliseconds(50));
+
+            pool.get(_listen.empty() ? "127.0.0.1" : _listen, _port, "/a", cxxtools::Seconds(2));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.idleConnections(), 1);
+
+            runLoop(cxxtools::Milliseconds(200));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.idleConnections(), 0);
+
+            pool.get(_listen.empty() ? "127.0.0.1" : _listen, _port, "/a", cxxtools::Seconds(2));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.connectionsOpened(), 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.connectionsReused(), 0);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // ConnectFailed
+        //
+        void ConnectFailed()
+        {
+            cxxtools::http::ClientPool pool(_loop);
+
+            // no server listens on the next port
+            cxxtools::net::AddrInfo other(_listen.empty() ? "127.0.0.1" : _listen, _port + 1);
+            unsigned id = pool.beginExecute(other, cxxtools::http::Request("/a"));
+            CXXTOOLS_UNIT_ASSERT_THROW(pool.endExecute(id, cxxtools::Seconds(2)), cxxtools::IOError);
+
+            // the pool is still usable
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.execute(addr(), cxxtools::http::Request("/b"), cxxtools::Seconds(2)).body(), "/b");
+        }
+};
+
+cxxtools::unit::RegisterTest<ClientPoolTest> register_ClientPoolTest;
@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ Measures, what formatting and parsing of rpc values cost per value.
+
+ Formatting compares the SerializationInfo based BasicDecomposer with the
+ Decomposer, which passes simple types to the formatter directly.
+
+ Parsing runs the bin parser in four ways: skipping the value, which is
+ the least work any parser has to do, building the SerializationInfo,
+ building it and converting it to the value with a BasicComposer, and
+ passing the value to the Composer directly like the rpc server does with
+ simple arguments. Types, which are read through a SerializationInfo, show
+ no direct time.
+ */
+
+#include <cxxtools/bin/formatter.h>
+#include <cxxtools/bin/deserializer.h>
+#include <cxxtools/composer.h>
+#include <cxxtools/decomposer.h>
+#include <cxxtools/arg.h>
+#include <cxxtools/log.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    struct TestObject
+    {
+        int intValue;
+        std::string stringValue;
+        double doubleValue;
+        bool boolValue;
+    };
+
+    void operator>>= (const cxxtools::SerializationInfo& si, TestObject& obj)
+    {
+        si.getMember("intValue") >>= obj.intValue;
+        si.getMember("stringValue") >>= obj.stringValue;
+        si.getMember("doubleValue") >>= obj.doubleValue;
+        si.getMember("boolValue") >>= obj.boolValue;
+    }
+
+    void operator<<= (cxxtools::SerializationInfo& si, const TestObject& obj)
+    {
+        si.addMember("intValue") <<= obj.intValue;
+        si.addMember("stringValue") <<= obj.stringValue;
+        si.addMember("doubleValue") <<= obj.doubleValue;
+        si.addMember("boolValue") <<= obj.boolValue;
+        si.setTypeName("TestObject");
+    }
+
+    // A stream buffer on a fixed memory area, which is rewound for each
+    // iteration, so that the measurement does not include allocations.
+    class MemBuf : public std::streambuf
+    {
+            std::vector<char> _data;
+
+        public:
+            explicit MemBuf(std::size_t size = 0)
+                : _data(size)
+                { }
+
+            explicit MemBuf(const std::string& data)
+                : _data(data.begin(), data.end())
+                { }
+
+            void rewind()
+            {
+                setg(_data.data(), _data.data(), _data.data() + _data.size());
+                setp(_data.data(), _data.data() + _data.size());
+            }
+
+            std::string written() const
+            { return std::string(pbase(), pptr()); }
+    };
+
+    double nsPerValue(Clock::duration d, unsigned n)
+    {
+        return std::chrono::duration<double, std::nano>(d).count() / n;
+    }
+
+    template <typename T>
+    std::string format(const T& value)
+    {
+        MemBuf out(65536);
+        out.rewind();
+
+        cxxtools::bin::Formatter formatter;
+        formatter.begin(out);
+
+        cxxtools::Decomposer<T> decomposer;
+        decomposer.begin(value);
+        decomposer.format(formatter);
+        formatter.finish();
+
+        return out.written();
+    }
+
+    template <typename D, typename T>
+    Clock::duration benchFormat(const T& value, unsigned n)
+    {
+        MemBuf out(65536);
+        cxxtools::bin::Formatter formatter;
+        D decomposer;
+
+        Clock::time_point start = Clock::now();
+
+        for (unsigned i = 0; i < n; ++i)
+        {
+            out.rewind();
+            formatter.begin(out);
+            decomposer.begin(value);
+            decomposer.format(formatter);
+            formatter.finish();
+        }
+
+        return Clock::now() - start;
+    }
+
+    enum class Parse
+    {
+        skip,
+        si,
+        compose,
+        direct
+    };
+
+    template <typename T>
+    Clock::duration benchParse(const std::string& data, Parse mode, unsigned n)
+    {
+        MemBuf in(data);
+        cxxtools::bin::Deserializer deserializer;
+        cxxtools::BasicComposer<T> composer;
+        cxxtools::Composer<T> directComposer;
+        T value;
+
+        composer.begin(value);
+        directComposer.begin(value);
+
+        // types, which are read through a SerializationInfo
+        if (mode == Parse::direct && !directComposer.direct())
+            return Clock::duration::zero();
+
+        Clock::time_point start = Clock::now();
+
+        for (unsigned i = 0; i < n; ++i)
+        {
+            in.rewind();
+
+            cxxtools::IDirectComposer* direct = 0;
+            if (mode == Parse::direct)
+            {
+                direct = directComposer.direct();
+                deserializer.begin(*direct);
+            }
+            else
+            {
+                deserializer.begin();
+                if (mode == Parse::skip)
+                    deserializer.skip();
+            }
+
+            if (!deserializer.advance(in))
+                throw std::runtime_error("incomplete value");
+
+            if (direct)
+                direct->finish();
+            else if (mode == Parse::compose)
+                composer.fixup(deserializer.si());
+        }
+
+        return Clock::now() - start;
+    }
+
+    template <typename T>
+    void bench(const char* name, const T& value, unsigned n)
+    {
+        std::string data = format(value);
+
+        double siFormat = nsPerValue(benchFormat<cxxtools::BasicDecomposer<T>>(value, n), n);
+        double directFormat = nsPerValue(benchFormat<cxxtools::Decomposer<T>>(value, n), n);
+
+        double skip = nsPerValue(benchParse<T>(data, Parse::skip, n), n);
+        double si = nsPerValue(benchParse<T>(data, Parse::si, n), n);
+        double compose = nsPerValue(benchParse<T>(data, Parse::compose, n), n);
+
+        std::cout << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(8) << data.size()
+                  << std::setw(12) << siFormat
+                  << std::setw(12) << directFormat
+                  << std::setw(12) << skip
+                  << std::setw(12) << si
+                  << std::setw(12) << compose;
+
+        Clock::duration direct = benchParse<T>(data, Parse::direct, n);
+        if (direct == Clock::duration::zero())
+            std::cout << std::setw(12) << '-';
+        else
+            std::cout << std::setw(12) << nsPerValue(direct, n);
+
+        std::cout << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        log_init(argc, argv);
+
+        cxxtools::Arg<unsigned> n(argc, argv, 'n', 1000000);
+        cxxtools::Arg<unsigned> size(argc, argv, 's', 100);
+
+        std::cout << "measure " << n.getValue() << " iterations per value; vectors have " << size.getValue() << " elements\n\n"
+                     "options:\n"
+                     "   -n <number>       number of iterations\n"
+                     "   -s <number>       number of elements of the vectors\n\n"
+                     "all times in ns per value\n\n"
+                     "type             bytes   format si    direct  parse skip          si  si+compose      direct\n";
+
+        std::vector<int> ints;
+        std::vector<std::string> strings;
+        std::vector<TestObject> objects;
+        for (unsigned i = 0; i < size; ++i)
+        {
+            ints.push_back(i * 1000);
+            strings.push_back(std::string(i % 32, 'x'));
+            objects.push_back(TestObject{ static_cast<int>(i), std::string(i % 32, 'y'), i * 0.25, (i & 1) != 0 });
+        }
+
+        bench("int", 4711, n);
+        bench("string", std::string("Hello World"), n);
+        bench("TestObject", objects.front(), n);
+        bench("vector<int>", ints, n / size + 1);
+        bench("vector<string>", strings, n / size + 1);
+        bench("vector<object>", objects, n / size + 1);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
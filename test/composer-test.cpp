@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "cxxtools/composer.h"
+#include "cxxtools/decomposer.h"
+#include "cxxtools/bin/formatter.h"
+#include "cxxtools/bin/deserializer.h"
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include <limits>
+#include <map>
+#include <sstream>
+
+namespace
+{
+    template <typename S>
+    std::string format(const S& value)
+    {
+        std::ostringstream out;
+        cxxtools::bin::Formatter formatter;
+        formatter.begin(*out.rdbuf());
+
+        cxxtools::Decomposer<S> decomposer;
+        decomposer.begin(value);
+        decomposer.format(formatter);
+        formatter.finish();
+
+        return out.str();
+    }
+
+    template <typename T>
+    void composeDirect(const std::string& data, T& value)
+    {
+        cxxtools::Composer<T> composer;
+        composer.begin(value);
+        cxxtools::IDirectComposer* direct = composer.direct();
+        CXXTOOLS_UNIT_ASSERT(direct != 0);
+
+        cxxtools::bin::Deserializer deserializer;
+        deserializer.begin(*direct);
+        std::stringbuf in(data);
+        CXXTOOLS_UNIT_ASSERT(deserializer.advance(in));
+        direct->finish();
+    }
+
+    template <typename T>
+    void composeSi(const std::string& data, T& value)
+    {
+        cxxtools::BasicComposer<T> composer;
+        composer.begin(value);
+
+        cxxtools::bin::Deserializer deserializer;
+        deserializer.begin();
+        std::stringbuf in(data);
+        CXXTOOLS_UNIT_ASSERT(deserializer.advance(in));
+        composer.fixup(deserializer.si());
+    }
+
+    // the simple types are parsed without a SerializationInfo; the result
+    // must be the same as with it
+    template <typename T, typename S>
+    T checkDirect(const S& source)
+    {
+        std::string data = format(source);
+
+        T direct = T();
+        composeDirect(data, direct);
+
+        T indirect = T();
+        composeSi(data, indirect);
+
+        CXXTOOLS_UNIT_ASSERT(direct == indirect);
+        return direct;
+    }
+
+    template <typename T, typename S>
+    std::string checkFails(const S& source)
+    {
+        std::string data = format(source);
+        std::string direct;
+        std::string indirect;
+
+        try
+        {
+            T value = T();
+            composeDirect(data, value);
+        }
+        catch (const std::exception& e)
+        {
+            direct = e.what();
+        }
+
+        try
+        {
+            T value = T();
+            composeSi(data, value);
+        }
+        catch (const std::exception& e)
+        {
+            indirect = e.what();
+        }
+
+        // the messages may differ in the type names
+        CXXTOOLS_UNIT_ASSERT(!direct.empty());
+        CXXTOOLS_UNIT_ASSERT(!indirect.empty());
+        return direct;
+    }
+}
+
+class ComposerTest : public cxxtools::unit::TestSuite
+{
+    public:
+        ComposerTest()
+        : cxxtools::unit::TestSuite("composer")
+        {
+            registerMethod("directInt", *this, &ComposerTest::directInt);
+            registerMethod("directFloat", *this, &ComposerTest::directFloat);
+            registerMethod("directString", *this, &ComposerTest::directString);
+            registerMethod("directArray", *this, &ComposerTest::directArray);
+            registerMethod("directStructure", *this, &ComposerTest::directStructure);
+            registerMethod("directErrors", *this, &ComposerTest::directErrors);
+            registerMethod("reuse", *this, &ComposerTest::reuse);
+        }
+
+        void directInt()
+        {
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<int>(42), 42);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<int>(-300000), -300000);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<short>(-17), -17);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<long long>(std::numeric_limits<long long>::min()), std::numeric_limits<long long>::min());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<unsigned long long>(std::numeric_limits<unsigned long long>::max()), std::numeric_limits<unsigned long long>::max());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<int>(std::string("4711")), 4711);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<int>(true), 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<bool>(true), true);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<bool>(0), false);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<int>(cxxtools::SerializationInfo()), 0);
+        }
+
+        void directFloat()
+        {
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<double>(-3.25), -3.25);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<double>(1e300), 1e300);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<float>(1.5f), 1.5f);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<long double>(0.125), 0.125);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<double>(std::numeric_limits<double>::infinity()), std::numeric_limits<double>::infinity());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<double>(17), 17);
+        }
+
+        void directString()
+        {
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<std::string>(std::string()), "");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<std::string>(std::string("Hello World")), "Hello World");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<std::string>(std::string("W\xe4rme")), "W\xe4rme");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<std::string>(cxxtools::String(L"W\xe4rme")), "W\xe4rme");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<std::string>(42), "42");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<std::string>(cxxtools::SerializationInfo()), "");
+            CXXTOOLS_UNIT_ASSERT(checkDirect<cxxtools::String>(std::string("abc")) == cxxtools::String(L"abc"));
+            CXXTOOLS_UNIT_ASSERT(checkDirect<cxxtools::String>(cxxtools::String(L"\x20ac 5")) == cxxtools::String(L"\x20ac 5"));
+        }
+
+        void directArray()
+        {
+            CXXTOOLS_UNIT_ASSERT(checkDirect<std::vector<int>>(std::vector<int>()).empty());
+            CXXTOOLS_UNIT_ASSERT(checkDirect<std::vector<int>>(std::vector<int>{ 1, -2, 300000 }) == (std::vector<int>{ 1, -2, 300000 }));
+            CXXTOOLS_UNIT_ASSERT(checkDirect<std::vector<int>>(std::vector<std::string>{ "5", "6" }) == (std::vector<int>{ 5, 6 }));
+            CXXTOOLS_UNIT_ASSERT(checkDirect<std::vector<bool>>(std::vector<bool>{ true, false }) == (std::vector<bool>{ true, false }));
+            CXXTOOLS_UNIT_ASSERT(checkDirect<std::vector<double>>(std::vector<double>{ 0.5, -1e10 }) == (std::vector<double>{ 0.5, -1e10 }));
+            CXXTOOLS_UNIT_ASSERT(checkDirect<std::vector<std::string>>(std::vector<std::string>{ "a", "", "W\xe4rme" }) == (std::vector<std::string>{ "a", "", "W\xe4rme" }));
+            CXXTOOLS_UNIT_ASSERT(checkDirect<std::vector<cxxtools::String>>(std::vector<cxxtools::String>{ L"\x20ac" }) == (std::vector<cxxtools::String>{ L"\x20ac" }));
+        }
+
+        // values, which do not match the structure of the target, are read
+        // like operator >>= does
+        void directStructure()
+        {
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<int>(std::vector<int>{ 1, 2 }), 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checkDirect<std::string>(std::vector<std::string>{ "a" }), "");
+            CXXTOOLS_UNIT_ASSERT(checkDirect<std::vector<int>>(5).empty());
+            CXXTOOLS_UNIT_ASSERT(checkDirect<std::vector<int>>(std::vector<std::vector<int>>{ { 1 }, { 2, 3 } }) == (std::vector<int>{ 0, 0 }));
+            CXXTOOLS_UNIT_ASSERT(checkDirect<std::vector<int>>(std::map<std::string, int>{ { "a", 1 }, { "b", 2 } }) == (std::vector<int>{ 0, 0 }));
+        }
+
+        void directErrors()
+        {
+            checkFails<int>(std::string("foo"));
+            checkFails<short>(70000);
+            checkFails<unsigned>(-1);
+            checkFails<int>(cxxtools::String(L"\x20ac"));
+            checkFails<double>(std::string("1.5x"));
+
+            std::string msg = checkFails<std::vector<int>>(std::vector<std::string>{ "1", "x", "y" });
+            CXXTOOLS_UNIT_ASSERT_EQUALS(msg.substr(0, 15), "Error in line 2");
+        }
+
+        void reuse()
+        {
+            std::vector<std::string> values{ "foo", "bar" };
+            composeDirect(format(std::vector<std::string>{ "baz" }), values);
+            CXXTOOLS_UNIT_ASSERT(values == (std::vector<std::string>{ "baz" }));
+
+            // an error in one value does not stay in the composer
+            cxxtools::Composer<int> composer;
+            int value = 0;
+            composer.begin(value);
+
+            cxxtools::bin::Deserializer deserializer;
+            cxxtools::IDirectComposer* direct = composer.direct();
+            deserializer.begin(*direct);
+            std::stringbuf in(format(std::string("foo")));
+            CXXTOOLS_UNIT_ASSERT(deserializer.advance(in));
+            CXXTOOLS_UNIT_ASSERT_THROW(direct->finish(), cxxtools::SerializationError);
+
+            direct = composer.direct();
+            deserializer.begin(*direct);
+            std::stringbuf in2(format(7));
+            CXXTOOLS_UNIT_ASSERT(deserializer.advance(in2));
+            direct->finish();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value, 7);
+        }
+};
+
+cxxtools::unit::RegisterTest<ComposerTest> register_ComposerTest;
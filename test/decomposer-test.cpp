@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "cxxtools/decomposer.h"
+#include "cxxtools/jsonformatter.h"
+#include "cxxtools/bin/formatter.h"
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include <limits>
+#include <sstream>
+
+namespace
+{
+    // formats the decomposer once with the json and once with the bin formatter
+    std::string format(cxxtools::IDecomposer& decomposer)
+    {
+        std::ostringstream json;
+        cxxtools::JsonFormatter jsonFormatter(json);
+        jsonFormatter.beginObject(std::string(), std::string());
+        decomposer.format(jsonFormatter);
+        jsonFormatter.finishObject();
+        jsonFormatter.finish();
+
+        std::ostringstream bin;
+        cxxtools::bin::Formatter binFormatter;
+        binFormatter.begin(*bin.rdbuf());
+        decomposer.format(binFormatter);
+        binFormatter.finish();
+
+        return json.str() + '|' + bin.str();
+    }
+
+    // the simple types are formatted without a SerializationInfo; the
+    // result must be the same as with it
+    template <typename T>
+    void checkDirect(const T& value)
+    {
+        cxxtools::Decomposer<T> direct;
+        direct.begin(value);
+        direct.setName("v");
+
+        cxxtools::SerializationInfo si;
+        si <<= value;
+        cxxtools::Decomposer<cxxtools::SerializationInfo> indirect;
+        indirect.begin(si);
+        indirect.setName("v");
+
+        CXXTOOLS_UNIT_ASSERT_EQUALS(format(direct), format(indirect));
+    }
+
+    // a formatter, which knows just the rvalue variant of addValueStdString
+    class StdStringFormatter : public cxxtools::Formatter
+    {
+        public:
+            std::string stdStrings;
+            unsigned strings = 0;
+
+            void addValueString(const std::string&, const std::string&, cxxtools::String&&) override
+            { ++strings; }
+
+            void addValueStdString(const std::string&, const std::string&, std::string&& value) override
+            { stdStrings += value; }
+
+            void beginArray(const std::string&, const std::string&) override { }
+            void finishArray() override { }
+            void beginObject(const std::string&, const std::string&) override { }
+            void beginMember(const std::string&) override { }
+            void finishMember() override { }
+            void finishObject() override { }
+            void finish() override { }
+    };
+}
+
+class DecomposerTest : public cxxtools::unit::TestSuite
+{
+    public:
+        DecomposerTest()
+        : cxxtools::unit::TestSuite("decomposer")
+        {
+            registerMethod("directInt", *this, &DecomposerTest::directInt);
+            registerMethod("directFloat", *this, &DecomposerTest::directFloat);
+            registerMethod("directString", *this, &DecomposerTest::directString);
+            registerMethod("directArray", *this, &DecomposerTest::directArray);
+            registerMethod("rvalueOverride", *this, &DecomposerTest::rvalueOverride);
+            registerMethod("reuse", *this, &DecomposerTest::reuse);
+        }
+
+        void directInt()
+        {
+            checkDirect(true);
+            checkDirect(false);
+            checkDirect(static_cast<short>(-17));
+            checkDirect(42);
+            checkDirect(std::numeric_limits<int>::min());
+            checkDirect(std::numeric_limits<long long>::min());
+            checkDirect(std::numeric_limits<long long>::max());
+            checkDirect(static_cast<unsigned short>(65535));
+            checkDirect(300u);
+            checkDirect(std::numeric_limits<unsigned long>::max());
+            checkDirect(std::numeric_limits<unsigned long long>::max());
+        }
+
+        void directFloat()
+        {
+            checkDirect(1.5f);
+            checkDirect(-3.25);
+            checkDirect(1e300);
+            checkDirect(std::numeric_limits<double>::infinity());
+            checkDirect(static_cast<long double>(0.125));
+        }
+
+        void directString()
+        {
+            checkDirect(std::string());
+            checkDirect(std::string("Hello \"World\"\n"));
+            checkDirect(cxxtools::String(L"W\xe4rme"));
+        }
+
+        void directArray()
+        {
+            checkDirect(std::vector<int>());
+            checkDirect(std::vector<int>{ 1, -2, 300000 });
+            checkDirect(std::vector<bool>{ true, false });
+            checkDirect(std::vector<double>{ 0.5, -1e10 });
+            checkDirect(std::vector<std::string>{ "a", "", "b\tc" });
+
+            // vectors of other types still use the SerializationInfo
+            checkDirect(std::vector<std::vector<int>>{ { 1 }, { 2, 3 } });
+        }
+
+        void rvalueOverride()
+        {
+            StdStringFormatter formatter;
+
+            cxxtools::Decomposer<std::string> value;
+            value.begin(std::string("foo"));
+            value.format(formatter);
+
+            cxxtools::Decomposer<std::vector<std::string>> values;
+            values.begin(std::vector<std::string>{ "bar", "baz" });
+            values.format(formatter);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(formatter.stdStrings, "foobarbaz");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(formatter.strings, 0u);
+        }
+
+        void reuse()
+        {
+            cxxtools::Decomposer<std::vector<std::string>> decomposer;
+            decomposer.begin(std::vector<std::string>{ "foo", "bar" });
+            decomposer.setName("v");
+            format(decomposer);
+
+            decomposer.begin(std::vector<std::string>{ "baz" });
+            CXXTOOLS_UNIT_ASSERT_EQUALS(format(decomposer).substr(0, 14), "{\"v\":[\"baz\"]}|");
+        }
+};
+
+cxxtools::unit::RegisterTest<DecomposerTest> register_DecomposerTest;
@@ -0,0 +1,436 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include "cxxtools/http/server.h"
+#include "cxxtools/http/service.h"
+#include "cxxtools/http/responder.h"
+#include "cxxtools/http/request.h"
+#include "cxxtools/http/reply.h"
+#include "cxxtools/http/detachedreply.h"
+#include "cxxtools/net/tcpsocket.h"
+#include "cxxtools/eventloop.h"
+#include "cxxtools/connectable.h"
+#include "cxxtools/log.h"
+#include <poll.h>
+#include <stdlib.h>
+#include <sstream>
+#include <set>
+#include <thread>
+
+log_define("cxxtools.test.detachedreply")
+
+namespace
+{
+    // Keeps the open event streams.
+    class EventService : public cxxtools::http::Service, public cxxtools::Connectable
+    {
+            class EventResponder : public cxxtools::http::Responder
+            {
+                    EventService& _service;
+
+                public:
+                    explicit EventResponder(EventService& service)
+                        : cxxtools::http::Responder(service),
+                          _service(service)
+                        { }
+
+                    void reply(std::ostream& out, cxxtools::http::Request&, cxxtools::http::Reply& reply)
+                    {
+                        reply.setHeader("Content-Type", "text/event-stream");
+                        reply.setHeader("Cache-Control", "no-cache");
+                        out << "retry: 1000\n\n";
+
+                        cxxtools::http::DetachedReply& events = detach();
+                        _service.subscribers.insert(&events);
+                        cxxtools::connect(events.closed, _service, &EventService::onClosed);
+                    }
+            };
+
+        public:
+            std::set<cxxtools::http::DetachedReply*> subscribers;
+            unsigned closed;
+
+            EventService()
+                : closed(0)
+                { }
+
+            void onClosed(cxxtools::http::DetachedReply& events)
+            {
+                subscribers.erase(&events);
+                ++closed;
+            }
+
+        protected:
+            cxxtools::http::Responder* createResponder(const cxxtools::http::Request&)
+                { return new EventResponder(*this); }
+
+            void releaseResponder(cxxtools::http::Responder* resp)
+                { delete resp; }
+    };
+}
+
+class DetachedReplyTest : public cxxtools::unit::TestSuite
+{
+    private:
+        cxxtools::EventLoop _loop;
+        cxxtools::http::Server* _server;
+        EventService* _service;
+        std::string _listen;
+        unsigned short _port;
+        std::string _input;
+
+    public:
+        DetachedReplyTest()
+        : cxxtools::unit::TestSuite("detachedreply"),
+          _port(8002)
+        {
+            registerMethod("EventStream", *this, &DetachedReplyTest::EventStream);
+            registerMethod("KeepAlive", *this, &DetachedReplyTest::KeepAlive);
+            registerMethod("Pipelined", *this, &DetachedReplyTest::Pipelined);
+            registerMethod("Http10", *this, &DetachedReplyTest::Http10);
+            registerMethod("ClientGone", *this, &DetachedReplyTest::ClientGone);
+            registerMethod("ManySubscribers", *this, &DetachedReplyTest::ManySubscribers);
+
+            char* PORT = getenv("UTEST_PORT");
+            if (PORT)
+            {
+                std::istringstream s(PORT);
+                s >> _port;
+            }
+
+            char* LISTEN = getenv("UTEST_LISTEN");
+            if (LISTEN)
+                _listen = LISTEN;
+        }
+
+        void setUp()
+        {
+            _server = new cxxtools::http::Server(_loop, _listen, _port);
+            _server->minThreads(1);
+            _service = new EventService();
+            // the server strips the leading slash of the url
+            _server->addService("events", *_service);
+
+            // start the server without running the loop
+            _loop.processEvents();
+        }
+
+        void tearDown()
+        {
+            delete _server;
+            delete _service;
+        }
+
+        // Runs the event loop once.
+        void pump()
+        {
+            _loop.wait(10);
+            _loop.processEvents();
+        }
+
+        // Runs the event loop until the client socket has data.
+        void waitInput(cxxtools::net::TcpSocket& socket)
+        {
+            struct pollfd fds;
+            fds.fd = socket.getFd();
+            fds.events = POLLIN;
+            for (unsigned n = 0; ::poll(&fds, 1, 0) == 0; ++n)
+            {
+                if (n >= 500)
+                    throw cxxtools::unit::Assertion("no data received", CXXTOOLS_SOURCEINFO);
+                pump();
+            }
+        }
+
+        void waitSubscribers(std::size_t count)
+        {
+            for (unsigned n = 0; _service->subscribers.size() < count; ++n)
+            {
+                if (n >= 500)
+                    throw cxxtools::unit::Assertion("subscribers missing", CXXTOOLS_SOURCEINFO);
+                pump();
+            }
+        }
+
+        void waitClosedSignals(unsigned count)
+        {
+            for (unsigned n = 0; _service->closed < count; ++n)
+            {
+                if (n >= 500)
+                    throw cxxtools::unit::Assertion("closed not signaled", CXXTOOLS_SOURCEINFO);
+                pump();
+            }
+        }
+
+        void receive(cxxtools::net::TcpSocket& socket, std::size_t size)
+        {
+            while (_input.size() < size)
+            {
+                waitInput(socket);
+                char buffer[8192];
+                std::size_t n = socket.read(buffer, sizeof(buffer));
+                if (n == 0)
+                    throw cxxtools::unit::Assertion("connection closed", CXXTOOLS_SOURCEINFO);
+                _input.append(buffer, n);
+            }
+        }
+
+        // Returns true, when the server closed the connection.
+        bool waitClosed(cxxtools::net::TcpSocket& socket)
+        {
+            waitInput(socket);
+            char ch;
+            return socket.read(&ch, 1) == 0;
+        }
+
+        void subscribe(cxxtools::net::TcpSocket& socket, const char* version = "1.1")
+        {
+            socket.connect(_listen, _port);
+            socket.setTimeout(cxxtools::Seconds(5));
+
+            std::string request = std::string("GET /events HTTP/") + version + "\r\n"
+                "Host: localhost\r\n"
+                "\r\n";
+            socket.write(request.data(), request.size());
+        }
+
+        std::string readLine(cxxtools::net::TcpSocket& socket)
+        {
+            std::string::size_type e;
+            while ((e = _input.find("\r\n")) == std::string::npos)
+                receive(socket, _input.size() + 1);
+
+            std::string line = _input.substr(0, e);
+            _input.erase(0, e + 2);
+            return line;
+        }
+
+        std::string readHeader(cxxtools::net::TcpSocket& socket)
+        {
+            std::string::size_type e;
+            while ((e = _input.find("\r\n\r\n")) == std::string::npos)
+                receive(socket, _input.size() + 1);
+
+            std::string header = _input.substr(0, e + 4);
+            _input.erase(0, e + 4);
+            return header;
+        }
+
+        std::string readChunk(cxxtools::net::TcpSocket& socket)
+        {
+            std::istringstream s(readLine(socket));
+            std::size_t size = 0;
+            s >> std::hex >> size;
+
+            receive(socket, size + 2);
+            std::string chunk = _input.substr(0, size);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_input.substr(size, 2), "\r\n");
+            _input.erase(0, size + 2);
+            return chunk;
+        }
+
+        ////////////////////////////////////////////////////////////
+        // EventStream
+        //
+        void EventStream()
+        {
+            cxxtools::net::TcpSocket socket;
+            subscribe(socket);
+
+            std::string header = readHeader(socket);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(header.compare(0, 13, "HTTP/1.1 200 "), 0);
+            CXXTOOLS_UNIT_ASSERT(header.find("Transfer-Encoding: chunked\r\n") != std::string::npos);
+            CXXTOOLS_UNIT_ASSERT(header.find("Content-Type: text/event-stream\r\n") != std::string::npos);
+            CXXTOOLS_UNIT_ASSERT(header.find("Content-Length") == std::string::npos);
+
+            // the body written by the responder
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readChunk(socket), "retry: 1000\n\n");
+
+            waitSubscribers(1);
+            cxxtools::http::DetachedReply& events = **_service->subscribers.begin();
+            CXXTOOLS_UNIT_ASSERT(events.isOpen());
+
+            events.sendEvent("hello");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readChunk(socket), "data: hello\n\n");
+
+            events.sendEvent("two\nlines", "update", "42");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readChunk(socket), "event: update\nid: 42\ndata: two\ndata: lines\n\n");
+
+            // events may be sent by any thread
+            std::thread thread([&events] () { events.sendEvent("from thread"); });
+            thread.join();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readChunk(socket), "data: from thread\n\n");
+
+            events.finish();
+            // the last chunk is empty
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readChunk(socket), "");
+            waitClosedSignals(1);
+            CXXTOOLS_UNIT_ASSERT(_service->subscribers.empty());
+        }
+
+        ////////////////////////////////////////////////////////////
+        // KeepAlive
+        //
+        void KeepAlive()
+        {
+            cxxtools::net::TcpSocket socket;
+            subscribe(socket);
+
+            readHeader(socket);
+            readChunk(socket);
+            waitSubscribers(1);
+            (*_service->subscribers.begin())->finish();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readChunk(socket), "");
+
+            // the connection is used for the next request
+            std::string request =
+                "GET /events HTTP/1.1\r\n"
+                "Host: localhost\r\n"
+                "\r\n";
+            socket.write(request.data(), request.size());
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readHeader(socket).compare(0, 13, "HTTP/1.1 200 "), 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readChunk(socket), "retry: 1000\n\n");
+
+            waitSubscribers(1);
+            (*_service->subscribers.begin())->sendEvent("again");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readChunk(socket), "data: again\n\n");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_service->closed, 1u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Pipelined
+        //
+        void Pipelined()
+        {
+            cxxtools::net::TcpSocket socket;
+            subscribe(socket);
+
+            readHeader(socket);
+            readChunk(socket);
+            waitSubscribers(1);
+            cxxtools::http::DetachedReply* events = *_service->subscribers.begin();
+
+            // the next request is answered after the open reply is finished
+            std::string request =
+                "GET /events HTTP/1.1\r\n"
+                "Host: localhost\r\n"
+                "\r\n";
+            socket.write(request.data(), request.size());
+            for (unsigned n = 0; n < 10; ++n)
+                pump();
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_service->subscribers.size(), 1u);
+            events->sendEvent("first");
+            events->finish();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readChunk(socket), "data: first\n\n");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readChunk(socket), "");
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readHeader(socket).compare(0, 13, "HTTP/1.1 200 "), 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readChunk(socket), "retry: 1000\n\n");
+            waitSubscribers(1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_service->closed, 1u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Http10
+        //
+        void Http10()
+        {
+            cxxtools::net::TcpSocket socket;
+            subscribe(socket, "1.0");
+
+            std::string header = readHeader(socket);
+            CXXTOOLS_UNIT_ASSERT(header.find("Transfer-Encoding") == std::string::npos);
+            CXXTOOLS_UNIT_ASSERT(header.find("Connection: close\r\n") != std::string::npos);
+
+            // the body is delimited by closing the connection
+            receive(socket, 13);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_input, "retry: 1000\n\n");
+            _input.clear();
+
+            waitSubscribers(1);
+            cxxtools::http::DetachedReply& events = **_service->subscribers.begin();
+            events.sendEvent("plain");
+            events.finish();
+
+            receive(socket, 13);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_input, "data: plain\n\n");
+            CXXTOOLS_UNIT_ASSERT(waitClosed(socket));
+            waitClosedSignals(1);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // ClientGone
+        //
+        void ClientGone()
+        {
+            {
+                cxxtools::net::TcpSocket socket;
+                subscribe(socket);
+                readHeader(socket);
+                waitSubscribers(1);
+            }
+
+            waitClosedSignals(1);
+            CXXTOOLS_UNIT_ASSERT(_service->subscribers.empty());
+        }
+
+        ////////////////////////////////////////////////////////////
+        // ManySubscribers
+        //
+        void ManySubscribers()
+        {
+            // open event streams hold no worker thread
+            _server->maxThreads(2);
+
+            const unsigned count = 200;
+            std::vector<cxxtools::net::TcpSocket> sockets(count);
+            for (unsigned n = 0; n < count; ++n)
+                subscribe(sockets[n]);
+
+            waitSubscribers(count);
+
+            for (std::set<cxxtools::http::DetachedReply*>::iterator it = _service->subscribers.begin();
+                    it != _service->subscribers.end(); ++it)
+                (*it)->sendEvent("broadcast");
+
+            for (unsigned n = 0; n < count; ++n)
+            {
+                _input.clear();
+                readHeader(sockets[n]);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(readChunk(sockets[n]), "retry: 1000\n\n");
+                CXXTOOLS_UNIT_ASSERT_EQUALS(readChunk(sockets[n]), "data: broadcast\n\n");
+            }
+        }
+};
+
+cxxtools::unit::RegisterTest<DetachedReplyTest> register_DetachedReplyTest;
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "cxxtools/histogram.h"
+#include "cxxtools/serializationinfo.h"
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include <thread>
+#include <vector>
+
+class HistogramTest : public cxxtools::unit::TestSuite
+{
+    public:
+        HistogramTest()
+        : cxxtools::unit::TestSuite("histogram")
+        {
+            registerMethod("count", *this, &HistogramTest::count);
+            registerMethod("quantile", *this, &HistogramTest::quantile);
+            registerMethod("overflow", *this, &HistogramTest::overflow);
+            registerMethod("serialize", *this, &HistogramTest::serialize);
+            registerMethod("threads", *this, &HistogramTest::threads);
+        }
+
+        void count()
+        {
+            cxxtools::Histogram h;
+            h.add(cxxtools::Microseconds(50));
+            h.add(cxxtools::Milliseconds(1));
+            h.add(cxxtools::Milliseconds(3));
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.count(), 3u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.sum(), cxxtools::Microseconds(4050));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.max(), cxxtools::Milliseconds(3));
+
+            // the upper bound is included in the bucket
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.bucketCount(0), 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.bound(3), cxxtools::Milliseconds(1));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.bucketCount(3), 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.bucketCount(5), 1u);
+
+            h.clear();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.count(), 0u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.bucketCount(0), 0u);
+        }
+
+        void quantile()
+        {
+            std::vector<cxxtools::Timespan> bounds;
+            bounds.push_back(cxxtools::Milliseconds(10));
+            bounds.push_back(cxxtools::Milliseconds(20));
+            cxxtools::Histogram h(bounds);
+
+            for (unsigned n = 0; n < 90; ++n)
+                h.add(cxxtools::Milliseconds(5));
+            for (unsigned n = 0; n < 10; ++n)
+                h.add(cxxtools::Milliseconds(15));
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.quantile(0), cxxtools::Timespan(0));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.quantile(0.45), cxxtools::Milliseconds(5));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.quantile(0.95), cxxtools::Milliseconds(15));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.quantile(1), cxxtools::Milliseconds(15));
+        }
+
+        void overflow()
+        {
+            std::vector<cxxtools::Timespan> bounds;
+            bounds.push_back(cxxtools::Milliseconds(10));
+            cxxtools::Histogram h(bounds);
+
+            h.add(cxxtools::Milliseconds(1));
+            h.add(cxxtools::Seconds(2));
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.buckets(), 2u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.bucketCount(1), 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.quantile(0.99), cxxtools::Seconds(2));
+        }
+
+        void serialize()
+        {
+            std::vector<cxxtools::Timespan> bounds;
+            bounds.push_back(cxxtools::Milliseconds(10));
+            bounds.push_back(cxxtools::Milliseconds(20));
+            cxxtools::Histogram h(bounds);
+            h.add(cxxtools::Milliseconds(5));
+            h.add(cxxtools::Milliseconds(15));
+
+            cxxtools::SerializationInfo si;
+            si <<= h;
+
+            uint64_t count = 0;
+            si.getMember("count") >>= count;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(count, 2u);
+
+            const cxxtools::SerializationInfo& b = si.getMember("buckets");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(b.memberCount(), 2u);
+
+            double le = 0;
+            b.getMember(1).getMember("le") >>= le;
+            b.getMember(1).getMember("count") >>= count;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(le, 20.0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(count, 2u);
+        }
+
+        void threads()
+        {
+            std::vector<cxxtools::Timespan> bounds;
+            bounds.push_back(cxxtools::Milliseconds(10));
+            cxxtools::Histogram h(bounds);
+
+            // more threads than shards, so that some share a shard
+            const unsigned numThreads = cxxtools::ShardedCounters::Shards + 4;
+            const unsigned values = 10000;
+
+            std::vector<std::thread> threads;
+            for (unsigned t = 0; t < numThreads; ++t)
+                threads.emplace_back([&h, t, values] () {
+                    for (unsigned n = 0; n < values; ++n)
+                        h.add(cxxtools::Milliseconds(n % 2 ? 1 : 20 + t));
+                });
+
+            for (auto& thread: threads)
+                thread.join();
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.count(), numThreads * values);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.bucketCount(0), numThreads * values / 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.bucketCount(1), numThreads * values / 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.max(), cxxtools::Milliseconds(20 + numThreads - 1));
+
+            cxxtools::Timespan sum;
+            for (unsigned t = 0; t < numThreads; ++t)
+                sum += (values / 2) * (cxxtools::Milliseconds(1) + cxxtools::Milliseconds(20 + t));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.sum(), sum);
+
+            h.clear();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.count(), 0u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(h.max(), cxxtools::Timespan(0));
+        }
+};
+
+cxxtools::unit::RegisterTest<HistogramTest> register_HistogramTest;
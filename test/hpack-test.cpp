@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "http/hpack.h"
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+
+namespace
+{
+    std::string fromHex(const char* hex)
+    {
+        std::string ret;
+        unsigned n = 0;
+        unsigned v = 0;
+        for (const char* p = hex; *p; ++p)
+        {
+            if (*p == ' ')
+                continue;
+            v = (v << 4) | (*p <= '9' ? *p - '0' : *p - 'a' + 10);
+            if (++n % 2 == 0)
+            {
+                ret += static_cast<char>(v);
+                v = 0;
+            }
+        }
+        return ret;
+    }
+
+    typedef cxxtools::http::HpackDecoder::Fields Fields;
+    typedef cxxtools::http::HpackTable::Field Field;
+}
+
+class HpackTest : public cxxtools::unit::TestSuite
+{
+    public:
+        HpackTest()
+            : cxxtools::unit::TestSuite("hpack")
+        {
+            registerMethod("integer", *this, &HpackTest::integer);
+            registerMethod("huffman", *this, &HpackTest::huffman);
+            registerMethod("huffmanInvalid", *this, &HpackTest::huffmanInvalid);
+            registerMethod("decodeRequests", *this, &HpackTest::decodeRequests);
+            registerMethod("encodeRequests", *this, &HpackTest::encodeRequests);
+            registerMethod("eviction", *this, &HpackTest::eviction);
+            registerMethod("invalidIndex", *this, &HpackTest::invalidIndex);
+        }
+
+        // RFC 7541 C.1
+        void integer()
+        {
+            std::string out;
+            cxxtools::http::hpack::encodeInteger(out, 5, 0, 10);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(out, fromHex("0a"));
+
+            out.clear();
+            cxxtools::http::hpack::encodeInteger(out, 5, 0, 1337);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(out, fromHex("1f9a0a"));
+
+            out.clear();
+            cxxtools::http::hpack::encodeInteger(out, 8, 0, 42);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(out, fromHex("2a"));
+
+            std::string in = fromHex("1f9a0a");
+            const char* p = in.data();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::http::hpack::decodeInteger(p, in.data() + in.size(), 5), 1337u);
+            CXXTOOLS_UNIT_ASSERT(p == in.data() + in.size());
+
+            in = fromHex("1f9a");
+            p = in.data();
+            CXXTOOLS_UNIT_ASSERT_THROW(cxxtools::http::hpack::decodeInteger(p, in.data() + in.size(), 5), cxxtools::http::HpackError);
+        }
+
+        void huffman()
+        {
+            std::string out;
+            cxxtools::http::hpack::huffmanEncode(out, "www.example.com", 15);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(out, fromHex("f1e3 c2e5 f23a 6ba0 ab90 f4ff"));
+
+            std::string s;
+            cxxtools::http::hpack::huffmanDecode(s, out.data(), out.size());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(s, "www.example.com");
+
+            std::string all;
+            for (unsigned n = 0; n < 256; ++n)
+                all += static_cast<char>(n);
+
+            out.clear();
+            cxxtools::http::hpack::huffmanEncode(out, all.data(), all.size());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(out.size(), cxxtools::http::hpack::huffmanEncodedSize(all.data(), all.size()));
+
+            s.clear();
+            cxxtools::http::hpack::huffmanDecode(s, out.data(), out.size());
+            CXXTOOLS_UNIT_ASSERT(s == all);
+        }
+
+        void huffmanInvalid()
+        {
+            std::string s;
+
+            // padding longer than 7 bits
+            std::string in = fromHex("f1e3 c2e5 f23a 6ba0 ab90 f4ff ff");
+            CXXTOOLS_UNIT_ASSERT_THROW(cxxtools::http::hpack::huffmanDecode(s, in.data(), in.size()), cxxtools::http::HpackError);
+
+            // padding not consisting of ones
+            in = fromHex("f1e3 c2e5 f23a 6ba0 ab90 f4fe");
+            s.clear();
+            CXXTOOLS_UNIT_ASSERT_THROW(cxxtools::http::hpack::huffmanDecode(s, in.data(), in.size()), cxxtools::http::HpackError);
+
+            // EOS
+            in = fromHex("ffff fffc");
+            s.clear();
+            CXXTOOLS_UNIT_ASSERT_THROW(cxxtools::http::hpack::huffmanDecode(s, in.data(), in.size()), cxxtools::http::HpackError);
+        }
+
+        // RFC 7541 C.4
+        void decodeRequests()
+        {
+            cxxtools::http::HpackDecoder decoder;
+            Fields fields;
+
+            std::string block = fromHex("8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff");
+            decoder.decode(block.data(), block.size(), fields);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(fields.size(), 4u);
+            CXXTOOLS_UNIT_ASSERT(fields[0] == Field(":method", "GET"));
+            CXXTOOLS_UNIT_ASSERT(fields[1] == Field(":scheme", "http"));
+            CXXTOOLS_UNIT_ASSERT(fields[2] == Field(":path", "/"));
+            CXXTOOLS_UNIT_ASSERT(fields[3] == Field(":authority", "www.example.com"));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(decoder.table().size(), 57u);
+
+            fields.clear();
+            block = fromHex("8286 84be 5886 a8eb 1064 9cbf");
+            decoder.decode(block.data(), block.size(), fields);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(fields.size(), 5u);
+            CXXTOOLS_UNIT_ASSERT(fields[3] == Field(":authority", "www.example.com"));
+            CXXTOOLS_UNIT_ASSERT(fields[4] == Field("cache-control", "no-cache"));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(decoder.table().size(), 110u);
+
+            fields.clear();
+            block = fromHex("8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf");
+            decoder.decode(block.data(), block.size(), fields);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(fields.size(), 5u);
+            CXXTOOLS_UNIT_ASSERT(fields[1] == Field(":scheme", "https"));
+            CXXTOOLS_UNIT_ASSERT(fields[2] == Field(":path", "/index.html"));
+            CXXTOOLS_UNIT_ASSERT(fields[4] == Field("custom-key", "custom-value"));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(decoder.table().size(), 164u);
+        }
+
+        // the encoder produces the same blocks as in RFC 7541 C.4
+        void encodeRequests()
+        {
+            cxxtools::http::HpackEncoder encoder;
+
+            std::string block;
+            encoder.beginBlock(block);
+            encoder.encode(block, ":method", "GET");
+            encoder.encode(block, ":scheme", "http");
+            encoder.encode(block, ":path", "/");
+            encoder.encode(block, ":authority", "www.example.com");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(block, fromHex("8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff"));
+
+            block.clear();
+            encoder.beginBlock(block);
+            encoder.encode(block, ":method", "GET");
+            encoder.encode(block, ":scheme", "http");
+            encoder.encode(block, ":path", "/");
+            encoder.encode(block, ":authority", "www.example.com");
+            encoder.encode(block, "cache-control", "no-cache");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(block, fromHex("8286 84be 5886 a8eb 1064 9cbf"));
+
+            block.clear();
+            encoder.beginBlock(block);
+            encoder.encode(block, ":method", "GET");
+            encoder.encode(block, ":scheme", "https");
+            encoder.encode(block, ":path", "/index.html");
+            encoder.encode(block, ":authority", "www.example.com");
+            encoder.encode(block, "custom-key", "custom-value");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(block, fromHex("8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf"));
+        }
+
+        // RFC 7541 C.6 with a table size of 256
+        void eviction()
+        {
+            cxxtools::http::HpackDecoder decoder(256);
+            Fields fields;
+
+            std::string block = fromHex("4882 6402 5885 aec3 771a 4b61 96d0 7abe 9410 54d4 44a8 2005 9504 0b81 66e0 82a6 2d1b ff6e 919d 29ad 1718 63c7 8f0b 97c8 e9ae 82ae 43d3");
+            decoder.decode(block.data(), block.size(), fields);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(fields.size(), 4u);
+            CXXTOOLS_UNIT_ASSERT(fields[0] == Field(":status", "302"));
+            CXXTOOLS_UNIT_ASSERT(fields[1] == Field("cache-control", "private"));
+            CXXTOOLS_UNIT_ASSERT(fields[2] == Field("date", "Mon, 21 Oct 2013 20:13:21 GMT"));
+            CXXTOOLS_UNIT_ASSERT(fields[3] == Field("location", "https://www.example.com"));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(decoder.table().size(), 222u);
+
+            // ":status: 307" evicts ":status: 302"
+            fields.clear();
+            block = fromHex("4883 640e ffc1 c0bf");
+            decoder.decode(block.data(), block.size(), fields);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(fields.size(), 4u);
+            CXXTOOLS_UNIT_ASSERT(fields[0] == Field(":status", "307"));
+            CXXTOOLS_UNIT_ASSERT(fields[1] == Field("cache-control", "private"));
+            CXXTOOLS_UNIT_ASSERT(fields[3] == Field("location", "https://www.example.com"));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(decoder.table().size(), 222u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(decoder.table().count(), 4u);
+        }
+
+        void invalidIndex()
+        {
+            cxxtools::http::HpackDecoder decoder;
+            Fields fields;
+
+            std::string block = fromHex("be");
+            CXXTOOLS_UNIT_ASSERT_THROW(decoder.decode(block.data(), block.size(), fields), cxxtools::http::HpackError);
+
+            block = fromHex("80");
+            CXXTOOLS_UNIT_ASSERT_THROW(decoder.decode(block.data(), block.size(), fields), cxxtools::http::HpackError);
+
+            // table size update above the limit
+            block = fromHex("3fe2 1f");
+            CXXTOOLS_UNIT_ASSERT_THROW(decoder.decode(block.data(), block.size(), fields), cxxtools::http::HpackError);
+        }
+};
+
+cxxtools::unit::RegisterTest<HpackTest> register_HpackTest;
@@ -0,0 +1,932 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include "cxxtools/http/server.h"
+#include "cxxtools/http/client.h"
+#include "cxxtools/http/http2client.h"
+#include "cxxtools/http/detachedreply.h"
+#include "cxxtools/http/request.h"
+#include "cxxtools/http/reply.h"
+#include "cxxtools/http/responder.h"
+#include "cxxtools/http/service.h"
+#include "cxxtools/net/tcpsocket.h"
+#include "cxxtools/iostream.h"
+#include "cxxtools/eventloop.h"
+#include "cxxtools/regex.h"
+#include "cxxtools/log.h"
+#include "cxxtools/histogram.h"
+#include "cxxtools/clock.h"
+#include <poll.h>
+#include <stdlib.h>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+log_define("cxxtools.test.http")
+
+namespace
+{
+    // Replies with the name of the service and the path parameters.
+    class EchoResponder : public cxxtools::http::Responder
+    {
+            std::string _name;
+
+        public:
+            EchoResponder(cxxtools::http::Service& service, const std::string& name)
+                : cxxtools::http::Responder(service),
+                  _name(name)
+                { }
+
+            void reply(std::ostream& out, cxxtools::http::Request& request, cxxtools::http::Reply& /*reply*/)
+            {
+                out << _name;
+                for (cxxtools::http::Request::PathParams::const_iterator it = request.pathParams().begin();
+                     it != request.pathParams().end(); ++it)
+                    out << ' ' << it->first << '=' << it->second;
+                if (request.bodySize() > 0)
+                    out << ' ' << request.bodyStr();
+            }
+    };
+
+    class EchoService : public cxxtools::http::Service
+    {
+            std::string _name;
+
+        public:
+            explicit EchoService(const std::string& name)
+                : _name(name)
+                { }
+
+        protected:
+            cxxtools::http::Responder* createResponder(const cxxtools::http::Request&)
+                { return new EchoResponder(*this, _name); }
+
+            void releaseResponder(cxxtools::http::Responder* resp)
+                { delete resp; }
+    };
+
+    // Sends the passed number of chunks of 1000 bytes with chunked encoding.
+    class ChunkedResponder : public cxxtools::http::Responder
+    {
+        public:
+            explicit ChunkedResponder(cxxtools::http::Service& service)
+                : cxxtools::http::Responder(service)
+                { }
+
+            void reply(std::ostream&, cxxtools::http::Request& request, cxxtools::http::Reply&)
+            {
+                unsigned count = 0;
+                std::istringstream(request.pathParam("count")) >> count;
+
+                cxxtools::http::DetachedReply& detached = detach();
+                for (unsigned n = 0; n < count; ++n)
+                    detached.write(std::string(1000, static_cast<char>('a' + n % 26)));
+                detached.finish();
+            }
+    };
+
+    class ChunkedService : public cxxtools::http::Service
+    {
+        protected:
+            cxxtools::http::Responder* createResponder(const cxxtools::http::Request&)
+                { return new ChunkedResponder(*this); }
+
+            void releaseResponder(cxxtools::http::Responder* resp)
+                { delete resp; }
+    };
+}
+
+namespace
+{
+    // Holds requests until released.
+    class BlockingService : public cxxtools::http::Service
+    {
+            class BlockingResponder : public cxxtools::http::Responder
+            {
+                    BlockingService& _service;
+
+                public:
+                    explicit BlockingResponder(BlockingService& service)
+                        : cxxtools::http::Responder(service),
+                          _service(service)
+                        { }
+
+                    void reply(std::ostream& out, cxxtools::http::Request&, cxxtools::http::Reply&)
+                    {
+                        std::unique_lock<std::mutex> lock(_service._mutex);
+                        ++_service._entered;
+                        while (!_service._released)
+                            _service._cond.wait(lock);
+                        out << "done";
+                    }
+            };
+
+            std::mutex _mutex;
+            std::condition_variable _cond;
+            unsigned _entered;
+            bool _released;
+
+        public:
+            BlockingService()
+                : _entered(0),
+                  _released(false)
+                { }
+
+            unsigned entered()
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                return _entered;
+            }
+
+            void release()
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _released = true;
+                _cond.notify_all();
+            }
+
+            void reset()
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _entered = 0;
+                _released = false;
+            }
+
+        protected:
+            cxxtools::http::Responder* createResponder(const cxxtools::http::Request&)
+                { return new BlockingResponder(*this); }
+
+            void releaseResponder(cxxtools::http::Responder* resp)
+                { delete resp; }
+    };
+}
+
+class HttpTest : public cxxtools::unit::TestSuite
+{
+    private:
+        cxxtools::EventLoop _loop;
+        cxxtools::http::Server* _server;
+        BlockingService _blocking;
+        std::string _listen;
+        unsigned short _port;
+        std::string _body;
+        bool _done;
+        unsigned _finished;
+        unsigned _bodyCalls;
+        bool _pauseBody;
+
+    public:
+        HttpTest()
+        : cxxtools::unit::TestSuite("http"),
+          _port(8002)
+        {
+            registerMethod("ExactUrl", *this, &HttpTest::ExactUrl);
+            registerMethod("PrefixUrl", *this, &HttpTest::PrefixUrl);
+            registerMethod("PatternUrl", *this, &HttpTest::PatternUrl);
+            registerMethod("RegistrationOrder", *this, &HttpTest::RegistrationOrder);
+            registerMethod("RemoveService", *this, &HttpTest::RemoveService);
+            registerMethod("Pipelined", *this, &HttpTest::Pipelined);
+            registerMethod("PipelinedLoad", *this, &HttpTest::PipelinedLoad);
+            registerMethod("Http2", *this, &HttpTest::Http2);
+            registerMethod("Http2Upgrade", *this, &HttpTest::Http2Upgrade);
+            registerMethod("Http2Concurrent", *this, &HttpTest::Http2Concurrent);
+            registerMethod("Http2LargeBody", *this, &HttpTest::Http2LargeBody);
+            registerMethod("Http2SlowStream", *this, &HttpTest::Http2SlowStream);
+            registerMethod("StreamBody", *this, &HttpTest::StreamBody);
+            registerMethod("StreamBodyAsync", *this, &HttpTest::StreamBodyAsync);
+            registerMethod("QueueLimit", *this, &HttpTest::QueueLimit);
+            registerMethod("QueueTimeout", *this, &HttpTest::QueueTimeout);
+            registerMethod("KeepAliveTimeout", *this, &HttpTest::KeepAliveTimeout);
+
+            char* PORT = getenv("UTEST_PORT");
+            if (PORT)
+            {
+                std::istringstream s(PORT);
+                s >> _port;
+            }
+
+            char* LISTEN = getenv("UTEST_LISTEN");
+            if (LISTEN)
+                _listen = LISTEN;
+
+            _loop.setIdleTimeout(2000);
+            connect(_loop.timeout, *this, &HttpTest::failTest);
+            connect(_loop.timeout, _loop, &cxxtools::EventLoop::exit);
+        }
+
+        void failTest()
+        {
+            throw cxxtools::unit::Assertion("test timed out", CXXTOOLS_SOURCEINFO);
+        }
+
+        void setUp()
+        {
+            _server = new cxxtools::http::Server(_loop, _listen, _port);
+            _server->minThreads(1);
+        }
+
+        void tearDown()
+        {
+            _blocking.release();
+            delete _server;
+            _blocking.reset();
+        }
+
+        std::size_t onBodyAvailable(cxxtools::http::Client& client)
+        {
+            std::streambuf* sb = client.in().rdbuf();
+            std::size_t n = 0;
+            while (sb->in_avail() > 0)
+            {
+                _body += std::streambuf::traits_type::to_char_type(sb->sbumpc());
+                ++n;
+            }
+            return n;
+        }
+
+        void onReplyFinished(cxxtools::http::Client& client)
+        {
+            client.endExecute();
+            _done = true;
+        }
+
+        // Executes a request with the event loop and returns the reply body.
+        // The loop is not exited since the server terminates on loop exit.
+        std::string get(const std::string& url, unsigned* returnCode = 0)
+        {
+            cxxtools::http::Client client(_loop, _listen, _port);
+            cxxtools::http::Request request(url);
+            connect(client.bodyAvailable, *this, &HttpTest::onBodyAvailable);
+            connect(client.replyFinished, *this, &HttpTest::onReplyFinished);
+
+            _body.clear();
+            _done = false;
+            client.beginExecute(request);
+            while (!_done)
+            {
+                if (!_loop.wait(2000))
+                    failTest();
+                _loop.processEvents();
+            }
+
+            if (returnCode)
+                *returnCode = client.header().httpReturnCode();
+
+            return _body;
+        }
+
+        void onHttp2ReplyFinished(cxxtools::http::Http2Client&, unsigned)
+        {
+            ++_finished;
+        }
+
+        // Runs the event loop until the passed number of http/2 replies are finished.
+        void waitHttp2(cxxtools::http::Http2Client& client, unsigned count)
+        {
+            _finished = 0;
+            connect(client.replyFinished, *this, &HttpTest::onHttp2ReplyFinished);
+            while (_finished < count)
+            {
+                if (!_loop.wait(2000))
+                    failTest();
+                _loop.processEvents();
+            }
+            disconnect(client.replyFinished, *this, &HttpTest::onHttp2ReplyFinished);
+        }
+
+        std::string http2Get(cxxtools::http::Http2Client& client, const std::string& url, unsigned* returnCode = 0)
+        {
+            unsigned id = client.beginExecute(cxxtools::http::Request(url));
+            waitHttp2(client, 1);
+            const cxxtools::http::Reply& reply = client.endExecute(id);
+            if (returnCode)
+                *returnCode = reply.httpReturnCode();
+            return reply.body();
+        }
+
+        // Reads a reply from a raw connection and returns the body.
+        static std::string readReply(std::istream& in)
+        {
+            std::string line;
+            std::getline(in, line);
+            if (line.compare(0, 13, "HTTP/1.1 200 ") != 0)
+                throw std::runtime_error("unexpected reply <" + line + '>');
+
+            unsigned contentLength = 0;
+            while (std::getline(in, line) && line != "\r")
+            {
+                if (line.compare(0, 16, "Content-Length: ") == 0)
+                {
+                    std::istringstream s(line.substr(16));
+                    s >> contentLength;
+                }
+            }
+
+            std::string body(contentLength, '\0');
+            if (!in.read(&body[0], contentLength))
+                throw std::runtime_error("incomplete reply");
+            return body;
+        }
+
+        // Runs the event loop until the client socket has data.
+        void waitInput(cxxtools::net::TcpSocket& socket)
+        {
+            struct pollfd fds;
+            fds.fd = socket.getFd();
+            fds.events = POLLIN;
+            for (unsigned n = 0; ::poll(&fds, 1, 0) == 0; ++n)
+            {
+                if (n >= 500)
+                    failTest();
+                _loop.wait(10);
+                _loop.processEvents();
+            }
+        }
+
+        // Runs the event loop for the passed time.
+        void runLoop(cxxtools::Milliseconds ms)
+        {
+            cxxtools::Timespan end = cxxtools::Clock::getSystemTicks() + ms;
+            while (cxxtools::Clock::getSystemTicks() < end)
+            {
+                _loop.wait(10);
+                _loop.processEvents();
+            }
+        }
+
+        // Runs the event loop until the blocking service holds count requests.
+        void waitBlocked(unsigned count)
+        {
+            for (unsigned n = 0; _blocking.entered() < count; ++n)
+            {
+                if (n >= 500)
+                    failTest();
+                _loop.wait(10);
+                _loop.processEvents();
+            }
+        }
+
+        // Opens a connection, which the server keeps as idle connection.
+        void openIdle(cxxtools::net::TcpSocket& socket, cxxtools::IOStream& stream)
+        {
+            socket.connect(_listen, _port);
+            socket.setTimeout(cxxtools::Seconds(5));
+            stream.attachDevice(socket);
+            stream << "GET /fast HTTP/1.1\r\n"
+                      "Host: localhost\r\n"
+                      "\r\n" << std::flush;
+            waitInput(socket);
+            readReply(stream);
+
+            // let the worker park the connection
+            runLoop(cxxtools::Milliseconds(50));
+        }
+
+        static void requestBlocking(cxxtools::IOStream& stream)
+        {
+            stream << "GET /slow HTTP/1.1\r\n"
+                      "Host: localhost\r\n"
+                      "\r\n" << std::flush;
+        }
+
+        ////////////////////////////////////////////////////////////
+        // ExactUrl
+        //
+        void ExactUrl()
+        {
+            EchoService foo("foo");
+            EchoService bar("bar");
+            _server->addService("/foo", foo);
+            _server->addService("/foo/bar", bar);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get("/foo"), "foo");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get("/foo/bar"), "bar");
+
+            unsigned returnCode;
+            get("/fo", &returnCode);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(returnCode, 404u);
+            get("/foo/", &returnCode);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(returnCode, 404u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // PrefixUrl
+        //
+        void PrefixUrl()
+        {
+            EchoService files("files");
+            EchoService api("api");
+            _server->addPrefixService("/static/", files);
+            _server->addPrefixService("/api", api);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get("/static/css/site.css"), "files");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get("/api"), "api");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get("/api/v1/users"), "api");
+
+            unsigned returnCode;
+            get("/static", &returnCode);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(returnCode, 404u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // PatternUrl
+        //
+        void PatternUrl()
+        {
+            EchoService user("user");
+            EchoService order("order");
+            EchoService file("file");
+            EchoService named("named");
+            _server->addPatternService("/users/{id:int}", user);
+            _server->addPatternService("/users/{id:int}/orders/{order}", order);
+            _server->addPatternService("/files/{name:path}", file);
+            _server->addPatternService("/users/{name}", named);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get("/users/42"), "user id=42");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get("/users/42/orders/A-17"), "order id=42 order=A-17");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get("/files/a/b/c.txt"), "file name=a/b/c.txt");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get("/users/tommi"), "named name=tommi");
+
+            unsigned returnCode;
+            get("/users/42/orders", &returnCode);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(returnCode, 404u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // RegistrationOrder
+        //
+        void RegistrationOrder()
+        {
+            EchoService first("first");
+            EchoService regex("regex");
+            EchoService exact("exact");
+            _server->addPrefixService("/a/", first);
+            _server->addService(cxxtools::Regex("^/[ab]/x$"), regex);
+            _server->addService("/b/x", exact);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get("/a/x"), "first");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get("/b/x"), "regex");
+        }
+
+        ////////////////////////////////////////////////////////////
+        // RemoveService
+        //
+        void RemoveService()
+        {
+            EchoService foo("foo");
+            EchoService bar("bar");
+            _server->addPrefixService("/x", foo);
+            _server->addPrefixService("/x", bar);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get("/x"), "foo");
+
+            _server->removeService(foo);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get("/x"), "bar");
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Pipelined
+        //
+        void Pipelined()
+        {
+            EchoService a("a");
+            EchoService b("b");
+            EchoService user("user");
+            // the server strips the leading slash of urls sent by other clients
+            _server->addService("a", a);
+            _server->addService("b", b);
+            _server->addPatternService("users/{id:int}", user);
+
+            // start the server without running the loop
+            _loop.processEvents();
+
+            cxxtools::net::TcpSocket socket(_listen, _port);
+            socket.setTimeout(cxxtools::Seconds(5));
+            cxxtools::IOStream stream(socket);
+
+            // send all requests in one go before reading any reply
+            stream << "GET /a HTTP/1.1\r\n"
+                      "Host: localhost\r\n"
+                      "\r\n"
+                      "POST /b HTTP/1.1\r\n"
+                      "Host: localhost\r\n"
+                      "Content-Length: 5\r\n"
+                      "\r\n"
+                      "hello"
+                      "GET /users/7 HTTP/1.1\r\n"
+                      "Host: localhost\r\n"
+                      "\r\n"
+                   << std::flush;
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readReply(stream), "a");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readReply(stream), "b hello");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readReply(stream), "user id=7");
+        }
+
+        ////////////////////////////////////////////////////////////
+        // PipelinedLoad
+        //
+        void PipelinedLoad()
+        {
+            EchoService n("n");
+            _server->addPatternService("n/{n:int}", n);
+            _server->maxPipelinedRequests(4);
+
+            // start the server without running the loop
+            _loop.processEvents();
+
+            cxxtools::net::TcpSocket socket(_listen, _port);
+            socket.setTimeout(cxxtools::Seconds(5));
+            cxxtools::IOStream stream(socket);
+
+            const unsigned depth = 32;
+            unsigned sent = 0;
+            unsigned received = 0;
+            while (received < 2000)
+            {
+                while (sent < received + depth)
+                    stream << "GET /n/" << sent++ << " HTTP/1.1\r\n"
+                              "Host: localhost\r\n"
+                              "\r\n";
+                stream.flush();
+
+                while (received < sent)
+                {
+                    std::ostringstream expected;
+                    expected << "n n=" << received++;
+                    CXXTOOLS_UNIT_ASSERT_EQUALS(readReply(stream), expected.str());
+                }
+            }
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Http2
+        //
+        void Http2()
+        {
+            EchoService foo("foo");
+            EchoService user("user");
+            _server->addService("/foo", foo);
+            _server->addPatternService("/users/{id:int}", user);
+
+            cxxtools::http::Http2Client client(_loop, _listen, _port);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(http2Get(client, "/foo"), "foo");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(http2Get(client, "/users/42"), "user id=42");
+
+            unsigned returnCode;
+            http2Get(client, "/fo", &returnCode);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(returnCode, 404u);
+
+            cxxtools::http::Request request("/foo");
+            request.method("POST");
+            request.body() << "hello";
+            unsigned id = client.beginExecute(request);
+            waitHttp2(client, 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(client.endExecute(id).body(), "foo hello");
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Http2Upgrade
+        //
+        void Http2Upgrade()
+        {
+            EchoService foo("foo");
+            EchoService bar("bar");
+            _server->addService("/foo", foo);
+            _server->addService("/bar", bar);
+
+            cxxtools::http::Http2Client client(_loop, _listen, _port);
+            client.upgrade(true);
+
+            // the first request is answered on stream 1 of the upgraded connection
+            CXXTOOLS_UNIT_ASSERT_EQUALS(http2Get(client, "/foo"), "foo");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(http2Get(client, "/bar"), "bar");
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Http2Concurrent
+        //
+        void Http2Concurrent()
+        {
+            EchoService n("n");
+            _server->addPatternService("/n/{n:int}", n);
+
+            cxxtools::http::Http2Client client(_loop, _listen, _port);
+
+            // more requests than concurrent streams allowed by the server
+            const unsigned count = 250;
+            std::vector<unsigned> ids;
+            for (unsigned i = 0; i < count; ++i)
+            {
+                std::ostringstream url;
+                url << "/n/" << i;
+                ids.push_back(client.beginExecute(cxxtools::http::Request(url.str())));
+            }
+
+            waitHttp2(client, count);
+
+            for (unsigned i = 0; i < count; ++i)
+            {
+                std::ostringstream expected;
+                expected << "n n=" << i;
+                CXXTOOLS_UNIT_ASSERT_EQUALS(client.endExecute(ids[i]).body(), expected.str());
+            }
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Http2LargeBody
+        //
+        void Http2LargeBody()
+        {
+            EchoService echo("echo");
+            _server->addService("/echo", echo);
+
+            cxxtools::http::Http2Client client(_loop, _listen, _port);
+
+            // request and reply exceed the initial flow control window
+            std::string body;
+            for (unsigned i = 0; body.size() < 300000; ++i)
+                body += static_cast<char>('a' + i % 26);
+
+            cxxtools::http::Request request("/echo");
+            request.method("POST");
+            request.body() << body;
+            unsigned a = client.beginExecute(request);
+            unsigned b = client.beginExecute(request);
+
+            waitHttp2(client, 2);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(client.endExecute(a).body(), "echo " + body);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(client.endExecute(b).body(), "echo " + body);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Http2SlowStream
+        //
+        void Http2SlowStream()
+        {
+            EchoService fast("fast");
+            _server->addService("/fast", fast);
+            _server->addService("/slow", _blocking);
+            // one thread accepts connections, two answer the streams
+            _server->minThreads(3);
+
+            cxxtools::http::Http2Client client(_loop, _listen, _port);
+
+            unsigned slowId = client.beginExecute(cxxtools::http::Request("/slow"));
+            waitBlocked(1);
+            unsigned fastId = client.beginExecute(cxxtools::http::Request("/fast"));
+
+            // the second stream on the connection is answered, while the first is blocked
+            waitHttp2(client, 1);
+            CXXTOOLS_UNIT_ASSERT(client.finished(fastId));
+            CXXTOOLS_UNIT_ASSERT(!client.finished(slowId));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(client.endExecute(fastId).body(), "fast");
+
+            _blocking.release();
+            waitHttp2(client, 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(client.endExecute(slowId).body(), "done");
+        }
+
+        ////////////////////////////////////////////////////////////
+        // StreamBody
+        //
+        void StreamBody()
+        {
+            EchoService echo("echo");
+            _server->addService("/echo", echo);
+
+            // start the server without running the loop
+            _loop.processEvents();
+
+            std::string body;
+            for (unsigned i = 0; body.size() < 300000; ++i)
+                body += static_cast<char>('a' + i % 26);
+
+            cxxtools::http::Request request("/echo");
+            request.method("POST");
+            request.body() << body;
+
+            {
+                // the body is written to the stream and not kept in the reply
+                cxxtools::http::Client client(_listen, _port);
+                client.execute(request, cxxtools::Seconds(2));
+                std::ostringstream out;
+                client.readBody(out);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(out.str(), "echo " + body);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(client.reply().bodySize(), 0);
+            }
+
+            {
+                // the body is pulled from the stream of the client
+                cxxtools::http::Client client(_listen, _port);
+                client.execute(request, cxxtools::Seconds(2));
+                std::string received((std::istreambuf_iterator<char>(client.in())), std::istreambuf_iterator<char>());
+                CXXTOOLS_UNIT_ASSERT_EQUALS(received, "echo " + body);
+            }
+        }
+
+        std::size_t onStreamBodyAvailable(cxxtools::http::Client& client)
+        {
+            ++_bodyCalls;
+            if (_pauseBody)
+            {
+                _pauseBody = false;
+                return 0;
+            }
+
+            return onBodyAvailable(client);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // StreamBodyAsync
+        //
+        void StreamBodyAsync()
+        {
+            ChunkedService chunked;
+            _server->addPatternService("/chunked/{count:int}", chunked);
+
+            cxxtools::http::Client client(_loop, _listen, _port);
+            cxxtools::http::Request request("/chunked/200");
+            connect(client.bodyAvailable, *this, &HttpTest::onStreamBodyAvailable);
+            connect(client.replyFinished, *this, &HttpTest::onReplyFinished);
+
+            _body.clear();
+            _done = false;
+            _bodyCalls = 0;
+            _pauseBody = true;
+            client.beginExecute(request);
+
+            // the consumer is behind, so the client stops reading
+            while (_bodyCalls == 0)
+            {
+                if (!_loop.wait(2000))
+                    failTest();
+            }
+
+            runLoop(cxxtools::Milliseconds(100));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_bodyCalls, 1);
+            CXXTOOLS_UNIT_ASSERT(!_done);
+
+            client.resumeBody();
+            while (!_done)
+            {
+                if (!_loop.wait(2000))
+                    failTest();
+            }
+
+            CXXTOOLS_UNIT_ASSERT(client.header().chunkedTransferEncoding());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_body.size(), 200000);
+            for (unsigned n = 0; n < 200; ++n)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(_body.substr(n * 1000, 1000), std::string(1000, static_cast<char>('a' + n % 26)));
+        }
+
+        ////////////////////////////////////////////////////////////
+        // QueueLimit
+        //
+        void QueueLimit()
+        {
+            EchoService fast("fast");
+            _server->addService("fast", fast);
+            _server->addService("slow", _blocking);
+            // one thread accepts connections, the other processes requests
+            _server->maxThreads(2);
+            _server->maxQueueSize(1);
+            _server->retryAfter(cxxtools::Seconds(3));
+
+            // start the server without running the loop
+            _loop.processEvents();
+
+            cxxtools::net::TcpSocket s1, s2, s3;
+            cxxtools::IOStream c1, c2, c3;
+            openIdle(s1, c1);
+            openIdle(s2, c2);
+            openIdle(s3, c3);
+
+            // the first request occupies the worker, the second waits in the queue
+            requestBlocking(c1);
+            waitBlocked(1);
+            requestBlocking(c2);
+            runLoop(cxxtools::Milliseconds(100));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_blocking.entered(), 1u);
+
+            // the third request exceeds the queue
+            requestBlocking(c3);
+            waitInput(s3);
+            std::string reply((std::istreambuf_iterator<char>(c3)), std::istreambuf_iterator<char>());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reply.compare(0, 13, "HTTP/1.1 503 "), 0);
+            CXXTOOLS_UNIT_ASSERT(reply.find("Retry-After: 3\r\n") != std::string::npos);
+            CXXTOOLS_UNIT_ASSERT(reply.find("Connection: close\r\n") != std::string::npos);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_server->rejectedRequests(), 1u);
+
+            _blocking.release();
+            waitInput(s1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readReply(c1), "done");
+            waitInput(s2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readReply(c2), "done");
+
+            CXXTOOLS_UNIT_ASSERT(_server->queueTimes().count() >= 2);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // QueueTimeout
+        //
+        void QueueTimeout()
+        {
+            EchoService fast("fast");
+            _server->addService("fast", fast);
+            _server->addService("slow", _blocking);
+            _server->maxThreads(2);
+            _server->queueTimeout(cxxtools::Milliseconds(50));
+
+            // start the server without running the loop
+            _loop.processEvents();
+
+            cxxtools::net::TcpSocket s1, s2;
+            cxxtools::IOStream c1, c2;
+            openIdle(s1, c1);
+            openIdle(s2, c2);
+
+            requestBlocking(c1);
+            waitBlocked(1);
+            requestBlocking(c2);
+            runLoop(cxxtools::Milliseconds(100));
+
+            // the second request waited too long, when the worker gets free
+            _blocking.release();
+            waitInput(s1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readReply(c1), "done");
+
+            waitInput(s2);
+            std::string line;
+            std::getline(c2, line);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(line.compare(0, 13, "HTTP/1.1 503 "), 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_server->rejectedRequests(), 1u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // KeepAliveTimeout
+        //
+        void KeepAliveTimeout()
+        {
+            EchoService fast("fast");
+            _server->addService("fast", fast);
+            _server->keepAliveTimeout(cxxtools::Milliseconds(100));
+
+            // start the server without running the loop
+            _loop.processEvents();
+
+            cxxtools::net::TcpSocket s1, s2;
+            cxxtools::IOStream c1, c2;
+            openIdle(s1, c1);
+            openIdle(s2, c2);
+
+            // a connection, which is used again, is kept open
+            for (unsigned n = 0; n < 4; ++n)
+            {
+                c2 << "GET /fast HTTP/1.1\r\n"
+                      "Host: localhost\r\n"
+                      "\r\n" << std::flush;
+                waitInput(s2);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(readReply(c2), "fast");
+                runLoop(cxxtools::Milliseconds(50));
+            }
+
+            // the other connection was idle too long and is closed by the server
+            waitInput(s1);
+            CXXTOOLS_UNIT_ASSERT(c1.peek() == std::char_traits<char>::eof());
+        }
+};
+
+cxxtools::unit::RegisterTest<HttpTest> register_HttpTest;
@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/*
+ Measures the cost of many idle keep alive connections.
+
+ The benchmark opens a large number of connections to a http server and
+ sends one request on each, so that they are parked as idle connections.
+ Then a small part of the connections sends a request each second. The
+ latency of these requests is measured from the time they were scheduled
+ and the cpu time used by the process is reported.
+
+ Each connection uses two file descriptors in this process, so the number of
+ connections is limited by the open file limit. The client sockets are bound
+ to different loopback addresses, so that the local ports do not run out.
+ */
+
+#include <cxxtools/http/server.h>
+#include <cxxtools/http/service.h>
+#include <cxxtools/http/responder.h>
+#include <cxxtools/http/request.h>
+#include <cxxtools/http/reply.h>
+#include <cxxtools/eventloop.h>
+#include <cxxtools/histogram.h>
+#include <cxxtools/arg.h>
+#include <cxxtools/log.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    class HelloResponder : public cxxtools::http::Responder
+    {
+        public:
+            explicit HelloResponder(cxxtools::http::Service& service)
+                : cxxtools::http::Responder(service)
+                { }
+
+            void reply(std::ostream& out, cxxtools::http::Request&, cxxtools::http::Reply&)
+                { out << "hello"; }
+    };
+
+    class HelloService : public cxxtools::http::Service
+    {
+        protected:
+            cxxtools::http::Responder* createResponder(const cxxtools::http::Request&)
+                { return new HelloResponder(*this); }
+
+            void releaseResponder(cxxtools::http::Responder* resp)
+                { delete resp; }
+    };
+
+    const char request[] = "GET /hello HTTP/1.1\r\n"
+                           "Host: localhost\r\n"
+                           "\r\n";
+
+    int connect(unsigned short port, unsigned n)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+            throw std::runtime_error(std::string("socket failed: ") + std::strerror(errno));
+
+        // 20000 connections per source address keep clear of the local port range
+        sockaddr_in local;
+        std::memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 1 + n / 20000);
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error(std::string("bind failed: ") + std::strerror(errno));
+        }
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error(std::string("connect failed: ") + std::strerror(errno));
+        }
+
+        return fd;
+    }
+
+    // Sends a request and reads the reply, which ends with the body "hello".
+    bool get(int fd)
+    {
+        if (::write(fd, request, sizeof(request) - 1) != sizeof(request) - 1)
+            return false;
+
+        char buffer[1024];
+        std::size_t n = 0;
+        while (n < sizeof(buffer))
+        {
+            ssize_t r = ::read(fd, buffer + n, sizeof(buffer) - n);
+            if (r <= 0)
+                return false;
+            n += r;
+            if (n >= 5 && std::memcmp(buffer + n - 5, "hello", 5) == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    double cpuSeconds()
+    {
+        rusage usage;
+        ::getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+             + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    }
+
+    // Raises the open file limit as far as allowed and returns the number
+    // of connections, which fit into it.
+    unsigned maxConnections()
+    {
+        rlimit limit;
+        ::getrlimit(RLIMIT_NOFILE, &limit);
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+        return limit.rlim_cur > 200 ? (limit.rlim_cur - 100) / 2 : 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        log_init(argc, argv);
+
+        cxxtools::Arg<unsigned short> port(argc, argv, 'p', 8004);
+        cxxtools::Arg<unsigned> threads(argc, argv, 't', 4);
+        cxxtools::Arg<unsigned> connections(argc, argv, 'c', 50000);
+        cxxtools::Arg<double> active(argc, argv, 'a', 1);
+        cxxtools::Arg<double> duration(argc, argv, 'd', 10);
+
+        if (argc > 1)
+        {
+            std::cerr << "usage: " << argv[0] << " {options}\n"
+                         "options:\n"
+                         "  -p port      port of the server (8004)\n"
+                         "  -t threads   worker threads of the server (4)\n"
+                         "  -c number    idle connections (50000)\n"
+                         "  -a percent   connections sending a request per second (1)\n"
+                         "  -d seconds   duration of the measurement (10)\n";
+            return 1;
+        }
+
+        unsigned numConnections = connections;
+        unsigned limit = maxConnections();
+        if (numConnections > limit)
+        {
+            std::cerr << "open file limit allows " << limit << " connections only" << std::endl;
+            numConnections = limit;
+        }
+
+        cxxtools::EventLoop loop;
+        cxxtools::http::Server server(loop, "127.0.0.1", port);
+        HelloService service;
+        server.addService("hello", service);
+        server.minThreads(threads);
+        server.maxThreads(threads);
+        server.keepAliveTimeout(cxxtools::Seconds(3600));
+
+        std::thread loopThread([&loop] () { loop.run(); });
+
+        std::vector<int> fds;
+        fds.reserve(numConnections);
+
+        Clock::time_point t0 = Clock::now();
+        for (unsigned n = 0; n < numConnections; ++n)
+        {
+            int fd = connect(port, n);
+            fds.push_back(fd);
+            if (!get(fd))
+                throw std::runtime_error("initial request failed");
+        }
+
+        std::cout << numConnections << " connections opened in "
+                  << std::chrono::duration<double>(Clock::now() - t0).count() << " s" << std::endl;
+
+        // let the workers park the connections
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+        double rate = numConnections * active / 100;
+        Clock::duration interval = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1 / rate));
+        Clock::time_point start = Clock::now();
+        Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(duration));
+
+        std::mt19937 random;
+        std::uniform_int_distribution<unsigned> pick(0, numConnections - 1);
+        cxxtools::Histogram latency;
+        unsigned long errors = 0;
+
+        double cpu0 = cpuSeconds();
+        for (Clock::time_point scheduled = start; scheduled < end; scheduled += interval)
+        {
+            std::this_thread::sleep_until(scheduled);
+            if (!get(fds[pick(random)]))
+                ++errors;
+
+            latency.add(cxxtools::Microseconds(std::chrono::duration_cast<std::chrono::microseconds>(
+                Clock::now() - scheduled).count()));
+        }
+
+        double cpu = cpuSeconds() - cpu0;
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::cout << latency.count() << " requests at " << rate << " requests/s\n"
+                  << "  latency p50 " << latency.quantile(0.5).totalMSecs() << " ms"
+                  << "  p99 " << latency.quantile(0.99).totalMSecs() << " ms"
+                  << "  max " << latency.max().totalMSecs() << " ms\n"
+                  << "  cpu " << cpu / elapsed * 100 << "% of one core\n"
+                  << "  errors " << errors << std::endl;
+
+        for (unsigned n = 0; n < fds.size(); ++n)
+            ::close(fds[n]);
+
+        loop.exit();
+        loopThread.join();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
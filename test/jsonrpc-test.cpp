@@ -31,13 +31,19 @@
 #include "cxxtools/json/rpcserver.h"
 #include "cxxtools/remoteexception.h"
 #include "cxxtools/remoteprocedure.h"
+#include "cxxtools/rpccontext.h"
 #include "cxxtools/eventloop.h"
 #include "cxxtools/log.h"
 #include "cxxtools/ioerror.h"
 #include "cxxtools/net/uri.h"
 #include "cxxtools/net/addrinfo.h"
 #include <stdlib.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 log_define("cxxtools.test.jsonrpc")
 
@@ -83,6 +89,10 @@ class JsonRpcTest : public cxxtools::unit::TestSuite
         std::string _listen;
         unsigned short _port;
 
+        // threads, which set the reply of asynchronous procedures
+        std::mutex _replyMutex;
+        std::vector<std::thread> _replyThreads;
+
     public:
         JsonRpcTest()
         : cxxtools::unit::TestSuite("jsonrpc"),
@@ -111,6 +121,15 @@ class JsonRpcTest : public cxxtools::unit::TestSuite
             registerMethod("PrepareConnect", *this, &JsonRpcTest::PrepareConnect);
             registerMethod("Connect", *this, &JsonRpcTest::Connect);
             registerMethod("Multiple", *this, &JsonRpcTest::Multiple);
+            registerMethod("Batch", *this, &JsonRpcTest::Batch);
+            registerMethod("BatchFault", *this, &JsonRpcTest::BatchFault);
+            registerMethod("BatchParallel", *this, &JsonRpcTest::BatchParallel);
+            registerMethod("Async", *this, &JsonRpcTest::Async);
+            registerMethod("AsyncFault", *this, &JsonRpcTest::AsyncFault);
+            registerMethod("AsyncParallel", *this, &JsonRpcTest::AsyncParallel);
+            registerMethod("AsyncBatch", *this, &JsonRpcTest::AsyncBatch);
+            registerMethod("Stream", *this, &JsonRpcTest::Stream);
+            registerMethod("Deadline", *this, &JsonRpcTest::Deadline);
 
             char* PORT = getenv("UTEST_PORT");
             if (PORT)
@@ -141,6 +160,10 @@ class JsonRpcTest : public cxxtools::unit::TestSuite
 
         void tearDown()
         {
+            for (auto& t: _replyThreads)
+                t.join();
+            _replyThreads.clear();
+
             delete _server;
         }
 
@@ -803,6 +826,284 @@ class JsonRpcTest : public cxxtools::unit::TestSuite
 
         }
 
+        ////////////////////////////////////////////////////////////
+        // Batch
+        //
+        void Batch()
+        {
+            _server->registerMethod("multiply", *this, &JsonRpcTest::multiplyInt);
+
+            typedef cxxtools::RemoteProcedure<int, int, int> Multiply;
+
+            cxxtools::json::RpcClient client(_loop, _listen, _port);
+            std::vector<Multiply> procs;
+            procs.reserve(16);
+
+            client.beginBatch();
+            for (int i = 0; i < 16; ++i)
+            {
+                procs.push_back(Multiply(client, "multiply"));
+                procs.back().begin(i, i);
+            }
+            client.endBatch();
+
+            for (int i = 0; i < 16; ++i)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(procs[i].end(2000), i*i);
+
+            // the connection is kept for further calls
+            procs[0].begin(3, 4);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(procs[0].end(2000), 12);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // BatchFault
+        //
+        void BatchFault()
+        {
+            _server->registerMethod("multiply", *this, &JsonRpcTest::multiplyInt);
+            _server->registerMethod("fault", *this, &JsonRpcTest::throwFault);
+
+            cxxtools::json::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int, int, int> multiply(client, "multiply");
+            cxxtools::RemoteProcedure<bool> fault(client, "fault");
+            cxxtools::RemoteProcedure<bool> unknown(client, "unknown");
+
+            client.beginBatch();
+            fault.begin();
+            multiply.begin(5, 6);
+            unknown.begin();
+            client.endBatch();
+
+            try
+            {
+                fault.end(2000);
+                CXXTOOLS_UNIT_ASSERT_MSG(false, "cxxtools::RemoteException exception expected");
+            }
+            catch (const cxxtools::RemoteException& e)
+            {
+                CXXTOOLS_UNIT_ASSERT_EQUALS(e.rc(), 7);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(e.text(), "Fault");
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(multiply.end(2000), 30);
+            CXXTOOLS_UNIT_ASSERT(unknown.failed());
+            CXXTOOLS_UNIT_ASSERT_THROW(unknown.end(2000), cxxtools::RemoteException);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // BatchParallel
+        //
+        void BatchParallel()
+        {
+            _server->registerMethod("sleep", *this, &JsonRpcTest::sleep);
+            _server->minThreads(4);
+
+            typedef cxxtools::RemoteProcedure<int, int> Sleep;
+
+            cxxtools::json::RpcClient client(_loop, _listen, _port);
+            std::vector<Sleep> procs;
+            procs.reserve(4);
+
+            auto start = std::chrono::steady_clock::now();
+
+            client.beginBatch();
+            for (int i = 0; i < 4; ++i)
+            {
+                procs.push_back(Sleep(client, "sleep"));
+                procs.back().begin(200);
+            }
+            client.endBatch();
+
+            for (int i = 0; i < 4; ++i)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(procs[i].end(2000), 200);
+
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            CXXTOOLS_UNIT_ASSERT(elapsed < std::chrono::milliseconds(600));
+        }
+
+        int sleep(int ms)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+            return ms;
+        }
+
+        ////////////////////////////////////////////////////////////
+        // asynchronous procedures
+        //
+        void Async()
+        {
+            _server->registerAsyncMethod("sleep", *this, &JsonRpcTest::sleepAsync);
+
+            cxxtools::json::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int, int> sleep(client, "sleep");
+
+            for (int i = 0; i < 3; ++i)
+            {
+                sleep.begin(10 * i);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(sleep.end(2000), 10 * i);
+            }
+        }
+
+        void AsyncFault()
+        {
+            _server->registerAsyncMethod("sleep", *this, &JsonRpcTest::sleepAsync);
+
+            cxxtools::json::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int, int> sleep(client, "sleep");
+
+            sleep.begin(-7);
+            try
+            {
+                sleep.end(2000);
+                CXXTOOLS_UNIT_ASSERT_MSG(false, "cxxtools::RemoteException exception expected");
+            }
+            catch (const cxxtools::RemoteException& e)
+            {
+                CXXTOOLS_UNIT_ASSERT_EQUALS(e.rc(), -7);
+            }
+
+            sleep.begin(1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(sleep.end(2000), 1);
+        }
+
+        void AsyncParallel()
+        {
+            _server->registerAsyncMethod("sleep", *this, &JsonRpcTest::sleepAsync);
+
+            // one thread accepts connections, one runs the calls
+            _server->maxThreads(2);
+
+            typedef cxxtools::RemoteProcedure<int, int> Sleep;
+
+            std::vector<std::unique_ptr<cxxtools::json::RpcClient>> clients;
+            std::vector<Sleep> procs;
+            procs.reserve(8);
+
+            auto start = std::chrono::steady_clock::now();
+
+            for (int i = 0; i < 8; ++i)
+            {
+                clients.emplace_back(new cxxtools::json::RpcClient(_loop, _listen, _port));
+                procs.push_back(Sleep(*clients.back(), "sleep"));
+                procs.back().begin(200);
+            }
+
+            for (int i = 0; i < 8; ++i)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(procs[i].end(2000), 200);
+
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            CXXTOOLS_UNIT_ASSERT(elapsed < std::chrono::milliseconds(800));
+        }
+
+        void AsyncBatch()
+        {
+            // batch elements wait for asynchronous procedures
+            _server->registerAsyncMethod("sleep", *this, &JsonRpcTest::sleepAsync);
+
+            typedef cxxtools::RemoteProcedure<int, int> Sleep;
+
+            cxxtools::json::RpcClient client(_loop, _listen, _port);
+            Sleep first(client, "sleep");
+            Sleep second(client, "sleep");
+
+            client.beginBatch();
+            first.begin(10);
+            second.begin(20);
+            client.endBatch();
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(first.end(2000), 10);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(second.end(2000), 20);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Stream
+        //
+        void Stream()
+        {
+            _server->registerStreamMethod("count", *this, &JsonRpcTest::count);
+
+            // json rpc has no streams; the elements are replied as array
+            cxxtools::json::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<std::vector<int>, int> count(client, "count");
+
+            count.begin(4);
+            const std::vector<int>& result = count.end(2000);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(result.size(), 4u);
+            for (unsigned i = 0; i < result.size(); ++i)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(result[i], static_cast<int>(i));
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Deadline
+        //
+        void Deadline()
+        {
+            _server->registerMethod("remaining", *this, &JsonRpcTest::remaining);
+
+            cxxtools::json::RpcClient client(_loop, _listen, _port);
+            cxxtools::RemoteProcedure<int> remaining(client, "remaining");
+
+            remaining.begin();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(remaining.end(2000), -1);
+
+            {
+                cxxtools::RpcContext context(cxxtools::Milliseconds(5000));
+                cxxtools::RpcContext::Scope scope(context);
+                remaining.begin();
+            }
+
+            int r = remaining.end(2000);
+            CXXTOOLS_UNIT_ASSERT(r > 0);
+            CXXTOOLS_UNIT_ASSERT(r <= 5000);
+
+            // a expired call is not run
+            {
+                cxxtools::RpcContext context(cxxtools::Milliseconds(0));
+                cxxtools::RpcContext::Scope scope(context);
+                remaining.begin();
+            }
+
+            try
+            {
+                remaining.end(2000);
+                CXXTOOLS_UNIT_ASSERT_MSG(false, "cxxtools::RemoteException exception expected");
+            }
+            catch (const cxxtools::RemoteException& e)
+            {
+                CXXTOOLS_UNIT_ASSERT_EQUALS(e.rc(), cxxtools::RpcContext::Cancelled);
+            }
+        }
+
+        int remaining()
+        {
+            cxxtools::RpcContext* context = cxxtools::RpcContext::current();
+            if (context == 0 || !context->hasDeadline())
+                return -1;
+            return static_cast<int>(context->remaining().totalMSecs());
+        }
+
+        void count(cxxtools::StreamWriter<int>& out, int n)
+        {
+            for (int i = 0; i < n; ++i)
+                out << i;
+        }
+
+        // replies from another thread after the passed time
+        void sleepAsync(cxxtools::AsyncReply<int> reply, int ms)
+        {
+            if (ms < 0)
+            {
+                reply.fail("negative sleep time", ms);
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(_replyMutex);
+            _replyThreads.emplace_back([reply, ms] () mutable {
+                std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+                reply.reply(ms);
+            });
+        }
+
 };
 
 cxxtools::unit::RegisterTest<JsonRpcTest> register_JsonRpcTest;
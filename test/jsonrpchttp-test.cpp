@@ -32,6 +32,8 @@
 #include "cxxtools/remoteexception.h"
 #include "cxxtools/remoteprocedure.h"
 #include "cxxtools/http/server.h"
+#include "cxxtools/http/client.h"
+#include "cxxtools/http/request.h"
 #include "cxxtools/eventloop.h"
 #include "cxxtools/log.h"
 #include "cxxtools/ioerror.h"
@@ -112,6 +114,8 @@ class JsonRpcHttpTest : public cxxtools::unit::TestSuite
             registerMethod("PrepareConnect", *this, &JsonRpcHttpTest::PrepareConnect);
             registerMethod("Connect", *this, &JsonRpcHttpTest::Connect);
             registerMethod("Multiple", *this, &JsonRpcHttpTest::Multiple);
+            registerMethod("Batch", *this, &JsonRpcHttpTest::Batch);
+            registerMethod("Notification", *this, &JsonRpcHttpTest::Notification);
 
             char* PORT = getenv("UTEST_PORT");
             if (PORT)
@@ -835,6 +839,83 @@ class JsonRpcHttpTest : public cxxtools::unit::TestSuite
 
         }
 
+        ////////////////////////////////////////////////////////////
+        // Batch
+        //
+        void Batch()
+        {
+            cxxtools::json::HttpService service;
+            service.registerMethod("multiply", *this, &JsonRpcHttpTest::multiplyInt);
+            service.registerMethod("fault", *this, &JsonRpcHttpTest::throwFault);
+            _server->addService("/rpc", service);
+
+            typedef cxxtools::RemoteProcedure<int, int, int> Multiply;
+
+            cxxtools::json::HttpClient client(_loop, _listen, _port, "/rpc");
+            cxxtools::RemoteProcedure<bool> fault(client, "fault");
+            std::vector<Multiply> procs;
+            procs.reserve(16);
+
+            client.beginBatch();
+            for (int i = 0; i < 16; ++i)
+            {
+                procs.push_back(Multiply(client, "multiply"));
+                procs.back().begin(i, i);
+            }
+            fault.begin();
+            client.endBatch();
+
+            for (int i = 0; i < 16; ++i)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(procs[i].end(2000), i*i);
+
+            CXXTOOLS_UNIT_ASSERT(fault.failed());
+            CXXTOOLS_UNIT_ASSERT_THROW(fault.end(2000), cxxtools::RemoteException);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Notification
+        //
+        std::string post(cxxtools::http::Client& client, const std::string& body)
+        {
+            cxxtools::http::Request request("/rpc");
+            request.method("POST");
+            request.setHeader("Content-Type", "application/json");
+            request.body() << body;
+            client.execute(request, cxxtools::Seconds(2));
+            return client.readBody().body();
+        }
+
+        void Notification()
+        {
+            cxxtools::json::HttpService service;
+            service.registerMethod("multiply", *this, &JsonRpcHttpTest::multiplyInt);
+            _server->addService("/rpc", service);
+
+            // start the server without running the loop
+            _loop.processEvents();
+
+            cxxtools::http::Client client(_listen, _port);
+
+            // notifications are executed but not answered
+            CXXTOOLS_UNIT_ASSERT_EQUALS(post(client, "{\"jsonrpc\":\"2.0\",\"method\":\"multiply\",\"params\":[2,3]}"), "");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(client.reply().httpReturnCode(), 204u);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(post(client,
+                "[{\"jsonrpc\":\"2.0\",\"method\":\"multiply\",\"params\":[2,3]},"
+                " {\"jsonrpc\":\"2.0\",\"method\":\"multiply\",\"params\":[4,5]}]"), "");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(client.reply().httpReturnCode(), 204u);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(post(client,
+                "[{\"jsonrpc\":\"2.0\",\"method\":\"multiply\",\"params\":[2,3]},"
+                " {\"jsonrpc\":\"2.0\",\"method\":\"multiply\",\"params\":[4,5],\"id\":7}]"),
+                "[{\"jsonrpc\":\"2.0\",\"id\":7,\"result\":20}]");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(client.reply().httpReturnCode(), 200u);
+
+            // requests, which are invalid, are answered with id null
+            CXXTOOLS_UNIT_ASSERT_EQUALS(post(client, "[]"),
+                "{\"jsonrpc\":\"2.0\",\"id\":null,\"error\":{\"code\":-32600,\"message\":\"id missing\"}}");
+        }
+
 };
 
 cxxtools::unit::RegisterTest<JsonRpcHttpTest> register_JsonRpcHttpTest;
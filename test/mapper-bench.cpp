@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ Measures the service lookup of http::Mapper for a REST like api with about
+ 300 endpoints. The same api is registered once with regular expressions and
+ once with exact urls and url patterns, which are resolved using the radix
+ tree router.
+ */
+
+#include "http/mapper.h"
+#include <cxxtools/http/request.h>
+#include <cxxtools/http/responder.h>
+#include <cxxtools/http/service.h>
+#include <cxxtools/regex.h>
+#include <cxxtools/arg.h>
+#include <cxxtools/clock.h>
+#include <cxxtools/log.h>
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+
+namespace
+{
+    const char* resources[] = {
+        "users", "groups", "roles", "permissions", "sessions", "tokens",
+        "orders", "invoices", "payments", "refunds", "customers", "addresses",
+        "products", "categories", "prices", "discounts", "carts", "wishlists",
+        "shipments", "carriers", "warehouses", "stock", "suppliers", "reviews",
+        "comments", "attachments", "notifications", "webhooks", "reports", "jobs"
+    };
+
+    const unsigned numResources = sizeof(resources) / sizeof(resources[0]);
+
+    // url patterns per resource; "*" is replaced by the resource name
+    const char* routes[] = {
+        "/api/v1/*",
+        "/api/v1/*/search",
+        "/api/v1/*/count",
+        "/api/v1/*/{id:int}",
+        "/api/v1/*/{id:int}/history",
+        "/api/v1/*/{id:int}/owner",
+        "/api/v1/*/{id:int}/tags/{tag}",
+        "/api/v2/*",
+        "/api/v2/*/{id:int}",
+        "/admin/*/{id:int}/audit"
+    };
+
+    const unsigned numRoutes = sizeof(routes) / sizeof(routes[0]);
+
+    // sample urls per resource; the last one does not match any route
+    const char* urls[] = {
+        "/api/v1/*",
+        "/api/v1/*/count",
+        "/api/v1/*/4711",
+        "/api/v1/*/4711/history",
+        "/api/v1/*/17/tags/important",
+        "/api/v2/*/123456",
+        "/admin/*/99/audit",
+        "/api/v1/*/abc"
+    };
+
+    const unsigned numUrls = sizeof(urls) / sizeof(urls[0]);
+
+    class NullResponder : public cxxtools::http::Responder
+    {
+        public:
+            explicit NullResponder(cxxtools::http::Service& service)
+                : cxxtools::http::Responder(service)
+                { }
+
+            void reply(std::ostream&, cxxtools::http::Request&, cxxtools::http::Reply&)
+                { }
+    };
+
+    // Returns always the same responder, so that the measurement is not
+    // dominated by memory allocation.
+    class NullService : public cxxtools::http::Service
+    {
+            NullResponder _responder;
+
+        public:
+            NullService()
+                : _responder(*this)
+                { }
+
+        protected:
+            cxxtools::http::Responder* createResponder(const cxxtools::http::Request&)
+                { return &_responder; }
+
+            void releaseResponder(cxxtools::http::Responder*)
+                { }
+    };
+
+    std::string replaceResource(const char* s, const char* resource)
+    {
+        std::string ret(s);
+        std::string::size_type p = ret.find('*');
+        if (p != std::string::npos)
+            ret.replace(p, 1, resource);
+        return ret;
+    }
+
+    bool isLiteral(const std::string& pattern)
+    {
+        return pattern.find('{') == std::string::npos;
+    }
+
+    // translates a url pattern into an equivalent regular expression
+    std::string toRegex(const std::string& pattern)
+    {
+        std::string ret = "^";
+        for (std::string::size_type p = 0; p < pattern.size(); ++p)
+        {
+            if (pattern[p] == '{')
+            {
+                std::string::size_type e = pattern.find('}', p);
+                ret += pattern.compare(p, e - p, "{id:int") == 0 ? "[0-9]+" : "[^/]+";
+                p = e;
+            }
+            else
+                ret += pattern[p];
+        }
+        ret += '$';
+        return ret;
+    }
+
+    unsigned long lookup(cxxtools::http::Mapper& mapper, const std::vector<std::string>& urls, unsigned long rounds)
+    {
+        cxxtools::http::Request request;
+        cxxtools::http::RouteMetrics* metrics;
+        unsigned long found = 0;
+        for (unsigned long l = 0; l < rounds; ++l)
+        {
+            for (unsigned n = 0; n < urls.size(); ++n)
+            {
+                request.url(urls[n]);
+                cxxtools::http::Responder* resp = mapper.getResponder(request, metrics);
+                if (dynamic_cast<NullResponder*>(resp))
+                    ++found;
+                resp->release();
+            }
+        }
+
+        return found;
+    }
+
+    void report(const char* name, unsigned long count, unsigned long found, cxxtools::Timespan t)
+    {
+        double secs = t.totalMSecs() / 1e3;
+        std::cout << name << ": " << count << " lookups (" << found << " found) in "
+                  << secs << " s => " << static_cast<unsigned long>(count / secs)
+                  << " lookups/s" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        log_init(argc, argv);
+
+        cxxtools::Arg<unsigned long> loops(argc, argv, 'n', 30000);
+
+        std::vector<NullService> services(numResources * numRoutes);
+        cxxtools::http::Mapper regexMapper;
+        cxxtools::http::Mapper routerMapper;
+
+        for (unsigned r = 0; r < numResources; ++r)
+        {
+            for (unsigned n = 0; n < numRoutes; ++n)
+            {
+                std::string pattern = replaceResource(routes[n], resources[r]);
+                NullService& service = services[r * numRoutes + n];
+
+                regexMapper.addService(cxxtools::Regex(toRegex(pattern)), service);
+
+                if (isLiteral(pattern))
+                    routerMapper.addService(pattern, service);
+                else
+                    routerMapper.addPatternService(pattern, service);
+            }
+        }
+
+        std::vector<std::string> sample;
+        for (unsigned r = 0; r < numResources; ++r)
+            for (unsigned n = 0; n < numUrls; ++n)
+                sample.push_back(replaceResource(urls[n], resources[r]));
+
+        std::cout << services.size() << " endpoints, " << sample.size() << " urls" << std::endl;
+
+        unsigned long rounds = loops / sample.size() + 1;
+        cxxtools::Clock clock;
+
+        clock.start();
+        unsigned long found = lookup(regexMapper, sample, rounds);
+        report("regex", rounds * sample.size(), found, clock.stop());
+
+        clock.start();
+        found = lookup(routerMapper, sample, rounds);
+        report("router", rounds * sample.size(), found, clock.stop());
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
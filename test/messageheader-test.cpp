@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "cxxtools/http/messageheader.h"
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include <string>
+#include <stdexcept>
+
+class MessageHeaderTest : public cxxtools::unit::TestSuite
+{
+    public:
+        MessageHeaderTest()
+        : cxxtools::unit::TestSuite("messageheader")
+        {
+            registerMethod("getHeader", *this, &MessageHeaderTest::getHeader);
+            registerMethod("wellKnown", *this, &MessageHeaderTest::wellKnown);
+            registerMethod("replaceHeader", *this, &MessageHeaderTest::replaceHeader);
+            registerMethod("removeHeader", *this, &MessageHeaderTest::removeHeader);
+            registerMethod("iterate", *this, &MessageHeaderTest::iterate);
+            registerMethod("bigHeader", *this, &MessageHeaderTest::bigHeader);
+            registerMethod("maxSize", *this, &MessageHeaderTest::maxSize);
+            registerMethod("wellKnownIndex", *this, &MessageHeaderTest::wellKnownIndex);
+            registerMethod("rawIterator", *this, &MessageHeaderTest::rawIterator);
+        }
+
+        void getHeader()
+        {
+            cxxtools::http::MessageHeader header;
+            header.addHeader("X-Foo", "foo");
+            header.addHeader("X-Bar", "bar");
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader("X-Foo")), "foo");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader("x-foo")), "foo");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader("X-BAR")), "bar");
+            CXXTOOLS_UNIT_ASSERT(header.getHeader("X-Baz") == 0);
+            CXXTOOLS_UNIT_ASSERT(!header.hasHeader("X-Fo"));
+            CXXTOOLS_UNIT_ASSERT(header.isHeaderValue("x-bar", "BAR"));
+        }
+
+        void wellKnown()
+        {
+            cxxtools::http::MessageHeader header;
+            header.addHeader("content-length", "42");
+            header.addHeader("CONNECTION", "close");
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::http::MessageHeader::headerId("Content-Type"),
+                cxxtools::http::MessageHeader::ContentType);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::http::MessageHeader::headerId("X-Foo"),
+                cxxtools::http::MessageHeader::Unknown);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader(cxxtools::http::MessageHeader::ContentLength)), "42");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(header.contentLength(), 42u);
+            CXXTOOLS_UNIT_ASSERT(!header.keepAlive());
+            CXXTOOLS_UNIT_ASSERT(!header.hasHeader(cxxtools::http::MessageHeader::Host));
+        }
+
+        void replaceHeader()
+        {
+            cxxtools::http::MessageHeader header;
+            header.addHeader("Set-Cookie", "a=1");
+            header.addHeader("Set-Cookie", "b=2");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(header.size(), 2u);
+
+            header.setHeader("set-cookie", "c=3");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(header.size(), 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader("Set-Cookie")), "c=3");
+        }
+
+        void removeHeader()
+        {
+            cxxtools::http::MessageHeader header;
+            header.addHeader("A", "1");
+            header.addHeader("B", "2");
+            header.addHeader("C", "3");
+
+            header.removeHeader("b");
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(header.size(), 2u);
+            CXXTOOLS_UNIT_ASSERT(!header.hasHeader("B"));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader("A")), "1");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader("C")), "3");
+        }
+
+        void iterate()
+        {
+            cxxtools::http::MessageHeader header;
+            header.addHeader("A", "1");
+            header.addHeader("Content-Type", "text/plain");
+            header.addHeader("C", "3");
+
+            std::string s;
+            for (cxxtools::http::MessageHeader::const_iterator it = header.begin(); it != header.end(); ++it)
+                s += std::string(it->first) + '=' + it->second + ';';
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(s, "A=1;Content-Type=text/plain;C=3;");
+
+            header.clear();
+            CXXTOOLS_UNIT_ASSERT(header.begin() == header.end());
+        }
+
+        void bigHeader()
+        {
+            cxxtools::http::MessageHeader header;
+            std::string cookie(3 * cxxtools::http::MessageHeader::MAXHEADERSIZE, 'x');
+            header.addHeader("Host", "localhost");
+            header.addHeader("Cookie", cookie.c_str());
+            header.addHeader("Accept", "*/*");
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader("Cookie")), cookie);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader("Host")), "localhost");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader("Accept")), "*/*");
+        }
+
+        void maxSize()
+        {
+            cxxtools::http::MessageHeader header;
+            header.maxSize(32);
+            header.addHeader("A", "1");
+            CXXTOOLS_UNIT_ASSERT_THROW(header.addHeader("B", std::string(64, 'x').c_str()), std::runtime_error);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(header.size(), 1u);
+        }
+
+        void wellKnownIndex()
+        {
+            cxxtools::http::MessageHeader header;
+            header.addHeader("X-A", "1");
+            header.addHeader("content-type", "text/plain");
+            header.addHeader("Host", "a");
+            header.addHeader("Host", "b");
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader(cxxtools::http::MessageHeader::ContentType)), "text/plain");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader("HOST")), "a");
+            CXXTOOLS_UNIT_ASSERT(header.getHeader(cxxtools::http::MessageHeader::Date) == 0);
+
+            header.removeHeader("X-A");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader(cxxtools::http::MessageHeader::Host)), "a");
+
+            header.setHeader("Host", "c");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(header.size(), 2u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader(cxxtools::http::MessageHeader::Host)), "c");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(header.getHeader("Content-Type")), "text/plain");
+
+            header.clear();
+            CXXTOOLS_UNIT_ASSERT(!header.hasHeader(cxxtools::http::MessageHeader::Host));
+            CXXTOOLS_UNIT_ASSERT(!header.hasHeader("Content-Type"));
+        }
+
+        void rawIterator()
+        {
+            static const char raw[] = "A\0" "1\0" "Host\0" "localhost\0";
+
+            std::string s;
+            cxxtools::http::MessageHeader::const_iterator it(raw);
+            for ( ; it != cxxtools::http::MessageHeader::const_iterator(); ++it)
+                s += std::string(it->first) + '=' + it->second + ';';
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(s, "A=1;Host=localhost;");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::http::MessageHeader::const_iterator(raw + 4).id(), cxxtools::http::MessageHeader::Host);
+        }
+};
+
+cxxtools::unit::RegisterTest<MessageHeaderTest> register_MessageHeaderTest;
@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include "cxxtools/http/server.h"
+#include "cxxtools/http/clientpool.h"
+#include "cxxtools/http/metricsservice.h"
+#include "cxxtools/http/request.h"
+#include "cxxtools/http/reply.h"
+#include "cxxtools/http/responder.h"
+#include "cxxtools/http/routemetrics.h"
+#include "cxxtools/http/service.h"
+#include "cxxtools/net/addrinfo.h"
+#include "cxxtools/eventloop.h"
+#include "cxxtools/jsondeserializer.h"
+#include "cxxtools/serializationinfo.h"
+#include <stdlib.h>
+#include <sstream>
+
+namespace
+{
+    class HelloService : public cxxtools::http::Service
+    {
+            class HelloResponder : public cxxtools::http::Responder
+            {
+                public:
+                    explicit HelloResponder(cxxtools::http::Service& service)
+                        : cxxtools::http::Responder(service)
+                        { }
+
+                    void reply(std::ostream& out, cxxtools::http::Request&, cxxtools::http::Reply&)
+                        { out << "hello"; }
+            };
+
+        protected:
+            cxxtools::http::Responder* createResponder(const cxxtools::http::Request&)
+                { return new HelloResponder(*this); }
+
+            void releaseResponder(cxxtools::http::Responder* resp)
+                { delete resp; }
+    };
+}
+
+class MetricsServiceTest : public cxxtools::unit::TestSuite
+{
+    private:
+        cxxtools::EventLoop _loop;
+        cxxtools::http::Server* _server;
+        HelloService _service;
+        cxxtools::http::MetricsService* _metricsService;
+        std::string _listen;
+        unsigned short _port;
+
+    public:
+        MetricsServiceTest()
+        : cxxtools::unit::TestSuite("metricsservice"),
+          _port(8002)
+        {
+            registerMethod("RouteMetrics", *this, &MetricsServiceTest::RouteMetrics);
+            registerMethod("Prometheus", *this, &MetricsServiceTest::Prometheus);
+            registerMethod("Json", *this, &MetricsServiceTest::Json);
+
+            char* PORT = getenv("UTEST_PORT");
+            if (PORT)
+            {
+                std::istringstream s(PORT);
+                s >> _port;
+            }
+
+            char* LISTEN = getenv("UTEST_LISTEN");
+            if (LISTEN)
+                _listen = LISTEN;
+        }
+
+        void setUp()
+        {
+            _server = new cxxtools::http::Server(_loop, _listen, _port);
+            _metricsService = new cxxtools::http::MetricsService(*_server);
+            _server->minThreads(1);
+            _server->addService("/hello", _service);
+            _server->addPatternService("/users/{id}", _service);
+            _server->addService("/metrics", *_metricsService);
+        }
+
+        void tearDown()
+        {
+            delete _server;
+            delete _metricsService;
+        }
+
+        cxxtools::net::AddrInfo addr() const
+        {
+            return cxxtools::net::AddrInfo(_listen.empty() ? "127.0.0.1" : _listen, _port);
+        }
+
+        unsigned get(cxxtools::http::ClientPool& pool, const std::string& url)
+        {
+            return pool.execute(addr(), cxxtools::http::Request(url), cxxtools::Seconds(5)).httpReturnCode();
+        }
+
+        const cxxtools::http::RouteMetrics* route(const std::string& name)
+        {
+            std::vector<const cxxtools::http::RouteMetrics*> routes = _server->routeMetrics();
+            for (auto r: routes)
+                if (r->route() == name)
+                    return r;
+            return 0;
+        }
+
+        // Runs some requests, which are found in the metrics afterwards.
+        void sendRequests(cxxtools::http::ClientPool& pool)
+        {
+            for (unsigned n = 0; n < 3; ++n)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/hello"), 200u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/users/1"), 200u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/users/2"), 200u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/missing"), 404u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // RouteMetrics
+        //
+        void RouteMetrics()
+        {
+            cxxtools::http::ClientPool pool(_loop);
+            sendRequests(pool);
+
+            const cxxtools::http::RouteMetrics* hello = route("/hello");
+            CXXTOOLS_UNIT_ASSERT(hello != 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(hello->requests(), 3u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(hello->returnCodeCount(200), 3u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(hello->inFlight(), 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(hello->latency().count(), 3u);
+
+            const cxxtools::http::RouteMetrics* users = route("/users/{id}");
+            CXXTOOLS_UNIT_ASSERT(users != 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(users->requests(), 2u);
+
+            // requests without a service are counted in the unnamed route
+            const cxxtools::http::RouteMetrics* unmatched = route("");
+            CXXTOOLS_UNIT_ASSERT(unmatched != 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(unmatched->returnCodeCount(404), 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(unmatched->returnCodeCount(200), 0u);
+
+            // the metrics are kept when the service is removed
+            _server->removeService(_service);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(get(pool, "/hello"), 404u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(hello->requests(), 3u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(unmatched->returnCodeCount(404), 2u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Prometheus
+        //
+        void Prometheus()
+        {
+            cxxtools::http::ClientPool pool(_loop);
+            sendRequests(pool);
+
+            const cxxtools::http::Reply& reply = pool.execute(addr(), cxxtools::http::Request("/metrics"), cxxtools::Seconds(5));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reply.httpReturnCode(), 200u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(reply.getHeader("Content-Type")), "text/plain; version=0.0.4");
+
+            std::string body = reply.body();
+            CXXTOOLS_UNIT_ASSERT(body.find("# TYPE http_requests_total counter\n") != std::string::npos);
+            CXXTOOLS_UNIT_ASSERT(body.find("\nhttp_requests_total{route=\"/hello\",code=\"200\"} 3\n") != std::string::npos);
+            CXXTOOLS_UNIT_ASSERT(body.find("\nhttp_requests_total{route=\"\",code=\"404\"} 1\n") != std::string::npos);
+            CXXTOOLS_UNIT_ASSERT(body.find("\nhttp_request_duration_seconds_count{route=\"/users/{id}\"} 2\n") != std::string::npos);
+            CXXTOOLS_UNIT_ASSERT(body.find("\nhttp_request_duration_seconds_bucket{route=\"/hello\",le=\"+Inf\"} 3\n") != std::string::npos);
+
+            // the metrics request itself is in flight while the metrics are rendered
+            CXXTOOLS_UNIT_ASSERT(body.find("\nhttp_requests_in_flight{route=\"/metrics\"} 1\n") != std::string::npos);
+            CXXTOOLS_UNIT_ASSERT(body.find("\nhttp_rejected_requests_total 0\n") != std::string::npos);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Json
+        //
+        void Json()
+        {
+            cxxtools::http::ClientPool pool(_loop);
+            sendRequests(pool);
+
+            const cxxtools::http::Reply& reply = pool.execute(addr(), cxxtools::http::Request("/metrics?format=json"), cxxtools::Seconds(5));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reply.httpReturnCode(), 200u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(reply.getHeader("Content-Type")), "application/json");
+
+            std::istringstream in(reply.body());
+            cxxtools::JsonDeserializer deserializer(in);
+            cxxtools::SerializationInfo si;
+            deserializer.deserialize(si);
+
+            const cxxtools::SerializationInfo& routes = si.getMember("routes");
+            const cxxtools::SerializationInfo* hello = 0;
+            for (unsigned n = 0; n < routes.memberCount(); ++n)
+            {
+                std::string name;
+                routes.getMember(n).getMember("route", name);
+                if (name == "/hello")
+                    hello = &routes.getMember(n);
+            }
+
+            CXXTOOLS_UNIT_ASSERT(hello != 0);
+
+            unsigned long requests = 0;
+            hello->getMember("requests", requests);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(requests, 3u);
+
+            unsigned long ok = 0;
+            hello->getMember("returnCodes").getMember("200", ok);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(ok, 3u);
+
+            unsigned long count = 0;
+            hello->getMember("latency").getMember("count", count);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(count, 3u);
+        }
+};
+
+cxxtools::unit::RegisterTest<MetricsServiceTest> register_MetricsServiceTest;
@@ -31,6 +31,50 @@
 #include "cxxtools/mime.h"
 #include "cxxtools/serializationinfo.h"
 #include <sstream>
+#include <vector>
+
+namespace
+{
+    struct CollectParts : public cxxtools::MimeMultipartParser::Handler
+    {
+        std::vector<std::string> headers;
+        std::vector<std::string> bodies;
+        unsigned ended;
+
+        CollectParts()
+            : ended(0)
+            { }
+
+        void onPartBegin(const cxxtools::MimeHeader& header)
+        {
+            headers.push_back(header.getHeader("Content-Disposition"));
+            bodies.push_back(std::string());
+        }
+
+        void onPartData(const char* data, std::size_t size)
+            { bodies.back().append(data, size); }
+
+        void onPartEnd()
+            { ++ended; }
+    };
+
+    const char multipartBody[] =
+        "preamble\r\n"
+        "--abc\r\n"
+        "Content-Disposition: form-data; name=\"a\"\r\n"
+        "\r\n"
+        "hello\r\n--ab\r\n"
+        "--abc  \r\n"
+        "\r\n"
+        "\r\n"
+        "--abc\r\n"
+        "Content-Disposition: form-data; name=\"c\"\r\n"
+        "Content-Type: text/plain\r\n"
+        "\r\n"
+        "world\r\n"
+        "--abc--\r\n"
+        "epilogue";
+}
 
 class MimeTest : public cxxtools::unit::TestSuite
 {
@@ -45,6 +89,9 @@ class MimeTest : public cxxtools::unit::TestSuite
             registerMethod("outputMessage", *this, &MimeTest::outputMessage);
             registerMethod("serializeMultipartMessage", *this, &MimeTest::serializeMultipartMessage);
             registerMethod("serializeMultipartToEntity", *this, &MimeTest::serializeMultipartToEntity);
+            registerMethod("parseMultipartIncremental", *this, &MimeTest::parseMultipartIncremental);
+            registerMethod("parseMultipartBytewise", *this, &MimeTest::parseMultipartBytewise);
+            registerMethod("parseMultipartIncomplete", *this, &MimeTest::parseMultipartIncomplete);
         }
 
         void parseMessage()
@@ -154,6 +201,49 @@ class MimeTest : public cxxtools::unit::TestSuite
             CXXTOOLS_UNIT_ASSERT_EQUALS(mp2.size(), 2u);
         }
 
+        static void checkParts(const CollectParts& parts)
+        {
+            CXXTOOLS_UNIT_ASSERT_EQUALS(parts.bodies.size(), 3u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(parts.ended, 3u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(parts.headers[0], "form-data; name=\"a\"");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(parts.bodies[0], "hello\r\n--ab");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(parts.headers[1], "");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(parts.bodies[1], "");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(parts.headers[2], "form-data; name=\"c\"");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(parts.bodies[2], "world");
+        }
+
+        void parseMultipartIncremental()
+        {
+            CollectParts parts;
+            cxxtools::MimeMultipartParser parser(parts, "multipart/form-data; boundary=abc");
+            parser.parse(multipartBody, sizeof(multipartBody) - 1);
+            CXXTOOLS_UNIT_ASSERT(parser.end());
+            parser.finish();
+            checkParts(parts);
+        }
+
+        void parseMultipartBytewise()
+        {
+            CollectParts parts;
+            cxxtools::MimeMultipartParser parser(parts, "multipart/form-data; boundary=\"abc\"");
+            for (const char* p = multipartBody; *p; ++p)
+                parser.parse(p, 1);
+            parser.finish();
+            checkParts(parts);
+        }
+
+        void parseMultipartIncomplete()
+        {
+            CollectParts parts;
+            cxxtools::MimeMultipartParser parser(parts, "multipart/form-data; boundary=abc");
+            parser.parse(multipartBody, 60);
+            CXXTOOLS_UNIT_ASSERT(!parser.end());
+            CXXTOOLS_UNIT_ASSERT_THROW(parser.finish(), std::runtime_error);
+
+            CXXTOOLS_UNIT_ASSERT_THROW(cxxtools::MimeMultipartParser(parts, "text/plain"), std::runtime_error);
+        }
+
 };
 
 cxxtools::unit::RegisterTest<MimeTest> register_MimeTest;
@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/*
+ Offers more requests to a http server than its worker threads can process
+ and measures the latency seen by the clients.
+
+ The server runs a service, which takes a fixed time per request, with a
+ fixed number of threads. The clients send requests at a fixed rate on many
+ keep alive connections. The latency is measured from the time, the request
+ was scheduled, so that a client, which falls behind, sees the delay. After
+ a 503 reply the client reconnects; the time to connect is not counted.
+ With more connections than the listen backlog of the server (64) the
+ reconnects may wait for tcp retransmits, which shows up in the tail.
+
+ The run is done without and with admission control. Without it the queue
+ grows as long as the overload lasts. With a queue limit and controlled
+ delay the latency of answered requests stays bounded and excess requests
+ are rejected quickly with 503.
+ */
+
+#include <cxxtools/http/server.h>
+#include <cxxtools/http/service.h>
+#include <cxxtools/http/responder.h>
+#include <cxxtools/http/request.h>
+#include <cxxtools/http/reply.h>
+#include <cxxtools/net/tcpsocket.h>
+#include <cxxtools/eventloop.h>
+#include <cxxtools/histogram.h>
+#include <cxxtools/iostream.h>
+#include <cxxtools/arg.h>
+#include <cxxtools/log.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    class SlowResponder : public cxxtools::http::Responder
+    {
+            std::chrono::microseconds _serviceTime;
+
+        public:
+            SlowResponder(cxxtools::http::Service& service, std::chrono::microseconds serviceTime)
+                : cxxtools::http::Responder(service),
+                  _serviceTime(serviceTime)
+                { }
+
+            void reply(std::ostream& out, cxxtools::http::Request&, cxxtools::http::Reply&)
+            {
+                std::this_thread::sleep_for(_serviceTime);
+                out << "ok";
+            }
+    };
+
+    class SlowService : public cxxtools::http::Service
+    {
+            std::chrono::microseconds _serviceTime;
+
+        public:
+            explicit SlowService(std::chrono::microseconds serviceTime)
+                : _serviceTime(serviceTime)
+                { }
+
+        protected:
+            cxxtools::http::Responder* createResponder(const cxxtools::http::Request&)
+                { return new SlowResponder(*this, _serviceTime); }
+
+            void releaseResponder(cxxtools::http::Responder* resp)
+                { delete resp; }
+    };
+
+    struct Result
+    {
+        cxxtools::Histogram ok;
+        cxxtools::Histogram rejected;
+        std::atomic<unsigned long> errors;
+
+        Result()
+            : errors(0)
+            { }
+    };
+
+    // Reads a reply and returns the status code.
+    unsigned readReply(std::istream& in)
+    {
+        std::string line;
+        if (!std::getline(in, line) || line.size() < 12)
+            return 0;
+
+        unsigned code = 0;
+        std::istringstream(line.substr(9, 3)) >> code;
+
+        unsigned contentLength = 0;
+        while (std::getline(in, line) && line != "\r")
+        {
+            if (line.compare(0, 16, "Content-Length: ") == 0)
+                std::istringstream(line.substr(16)) >> contentLength;
+        }
+
+        std::string body(contentLength, '\0');
+        if (contentLength > 0)
+            in.read(&body[0], contentLength);
+        return in ? code : 0;
+    }
+
+    void client(unsigned short port, Clock::time_point start, Clock::duration interval,
+                Clock::time_point end, Result& result)
+    {
+        std::unique_ptr<cxxtools::net::TcpSocket> socket;
+        std::unique_ptr<cxxtools::IOStream> stream;
+
+        for (Clock::time_point scheduled = start; scheduled < end; scheduled += interval)
+        {
+            std::this_thread::sleep_until(scheduled);
+            Clock::time_point sent = scheduled;
+
+            try
+            {
+                if (!stream)
+                {
+                    socket.reset(new cxxtools::net::TcpSocket("127.0.0.1", port));
+                    socket->setTimeout(cxxtools::Seconds(60));
+                    stream.reset(new cxxtools::IOStream(*socket));
+
+                    // the time to reconnect is not the latency of the server
+                    sent = Clock::now();
+                }
+
+                *stream << "GET /slow HTTP/1.1\r\n"
+                           "Host: localhost\r\n"
+                           "\r\n" << std::flush;
+
+                unsigned code = readReply(*stream);
+
+                cxxtools::Microseconds latency(std::chrono::duration_cast<std::chrono::microseconds>(
+                    Clock::now() - sent).count());
+
+                if (code == 200)
+                    result.ok.add(latency);
+                else if (code == 503)
+                {
+                    result.rejected.add(latency);
+
+                    // the server closes the connection after rejecting
+                    stream.reset();
+                    socket.reset();
+                }
+                else
+                    throw std::runtime_error("unexpected reply");
+            }
+            catch (const std::exception&)
+            {
+                ++result.errors;
+                stream.reset();
+                socket.reset();
+            }
+        }
+    }
+
+    void report(const char* name, const cxxtools::Histogram& h)
+    {
+        std::cout << "  " << name << ": " << h.count()
+                  << "  p50 " << h.quantile(0.5).totalMSecs() << " ms"
+                  << "  p99 " << h.quantile(0.99).totalMSecs() << " ms"
+                  << "  max " << h.max().totalMSecs() << " ms" << std::endl;
+    }
+
+    void run(const char* name, unsigned short port, unsigned threads, unsigned connections,
+             double rate, double duration, unsigned maxQueueSize, unsigned queueTarget,
+             std::chrono::microseconds serviceTime)
+    {
+        cxxtools::EventLoop loop;
+        cxxtools::http::Server server(loop, "127.0.0.1", port);
+        SlowService service(serviceTime);
+        server.addService("slow", service);
+        server.minThreads(threads);
+        server.maxThreads(threads);
+        server.maxQueueSize(maxQueueSize);
+        server.queueTarget(cxxtools::Milliseconds(queueTarget));
+
+        std::thread loopThread([&loop] () { loop.run(); });
+
+        Result result;
+        Clock::duration interval = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(connections / rate));
+        Clock::time_point start = Clock::now() + std::chrono::milliseconds(200);
+        Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(duration));
+
+        std::vector<std::thread> clients;
+        for (unsigned n = 0; n < connections; ++n)
+        {
+            // spread the requests of the connections over the interval
+            Clock::time_point s = start + interval * n / connections;
+            clients.emplace_back(client, port, s, interval, end, std::ref(result));
+        }
+
+        for (unsigned n = 0; n < clients.size(); ++n)
+            clients[n].join();
+
+        std::cout << name << ':' << std::endl;
+        report("ok      ", result.ok);
+        report("rejected", result.rejected);
+        report("queued  ", server.queueTimes());
+        std::cout << "  errors: " << result.errors << std::endl;
+
+        loop.exit();
+        loopThread.join();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        log_init(argc, argv);
+
+        cxxtools::Arg<unsigned short> port(argc, argv, 'p', 8003);
+        cxxtools::Arg<unsigned> threads(argc, argv, 't', 4);
+        cxxtools::Arg<unsigned> connections(argc, argv, 'c', 50);
+        cxxtools::Arg<double> serviceTime(argc, argv, 's', 5);
+        cxxtools::Arg<double> load(argc, argv, 'l', 2);
+        cxxtools::Arg<double> duration(argc, argv, 'd', 5);
+        cxxtools::Arg<unsigned> maxQueueSize(argc, argv, 'q', 64);
+        cxxtools::Arg<unsigned> queueTarget(argc, argv, 'T', 10);
+
+        if (argc > 1)
+        {
+            std::cerr << "usage: " << argv[0] << " {options}\n"
+                         "options:\n"
+                         "  -p port      port of the server (8003)\n"
+                         "  -t threads   worker threads of the server (4)\n"
+                         "  -c number    client connections (50)\n"
+                         "  -s ms        service time per request (5)\n"
+                         "  -l factor    offered load relative to the capacity (2)\n"
+                         "  -d seconds   duration of each run (5)\n"
+                         "  -q number    queue limit with admission control (64)\n"
+                         "  -T ms        queue target with admission control (10)\n";
+            return 1;
+        }
+
+        std::chrono::microseconds st(static_cast<long>(serviceTime * 1000));
+        double capacity = threads * 1e6 / st.count();
+        double rate = capacity * load;
+
+        std::cout << "capacity " << capacity << " requests/s; offered " << rate
+                  << " requests/s on " << connections.getValue() << " connections" << std::endl;
+
+        run("without admission control", port, threads, connections, rate, duration, 0, 0, st);
+        run("with admission control", port, threads, connections, rate, duration, maxQueueSize, queueTarget, st);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
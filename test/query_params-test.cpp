@@ -55,8 +55,12 @@ class QueryParamsTest : public cxxtools::unit::TestSuite
             registerMethod("testGetUrl", *this, &QueryParamsTest::testGetUrl);
             registerMethod("testGetNames", *this, &QueryParamsTest::testGetNames);
             registerMethod("testDeserialization", *this, &QueryParamsTest::testDeserialization);
+            registerMethod("testLazy", *this, &QueryParamsTest::testLazy);
+            registerMethod("testLazyRepeated", *this, &QueryParamsTest::testLazyRepeated);
+            registerMethod("testLazyModify", *this, &QueryParamsTest::testLazyModify);
 #if __cplusplus >= 201703L
             registerMethod("testOptional", *this, &QueryParamsTest::testOptional);
+            registerMethod("testParamView", *this, &QueryParamsTest::testParamView);
 #endif
         }
 
@@ -231,9 +235,123 @@ class QueryParamsTest : public cxxtools::unit::TestSuite
             CXXTOOLS_UNIT_ASSERT_EQUALS(names[2], "");
         }
 
+        void testLazy()
+        {
+            // lazy parsing decodes like the parser
+            static const char* urls[] = {
+                "p2=value2&value3&p1=value1",
+                "p1=value+with%20spaces&m%a4kitalo=tommi+",
+                "%%=%%%",
+                "&&a=%4g&=x&b=c=d&%&+&",
+                "a%3Db=%26"
+            };
+
+            for (unsigned n = 0; n < sizeof(urls) / sizeof(urls[0]); ++n)
+            {
+                cxxtools::QueryParams eager;
+                eager.parse_url(urls[n]);
+
+                cxxtools::QueryParams lazy;
+                lazy.parse_url_lazy(urls[n]);
+
+                CXXTOOLS_UNIT_ASSERT_EQUALS(lazy.getUrl(), eager.getUrl());
+
+                std::vector<std::string> names;
+                eager.getNames(std::back_inserter(names));
+                for (unsigned i = 0; i < names.size(); ++i)
+                {
+                    CXXTOOLS_UNIT_ASSERT(lazy.has(names[i]));
+                    CXXTOOLS_UNIT_ASSERT_EQUALS(lazy.paramcount(names[i]), eager.paramcount(names[i]));
+                    CXXTOOLS_UNIT_ASSERT_EQUALS(lazy.param(names[i]), eager.param(names[i]));
+                }
+            }
+
+            cxxtools::QueryParams q;
+            q.parse_url_lazy("p1=value+with%20spaces&m%a4kitalo=tommi+&value3");
+            CXXTOOLS_UNIT_ASSERT(!q.has("p3"));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q["p1"], "value with spaces");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q["m\xa4kitalo"], "tommi ");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q[0], "value3");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q.paramcount(), 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q.param("p3", "def"), "def");
+        }
+
+        void testLazyRepeated()
+        {
+            std::string url;
+            for (unsigned n = 0; n < 100; ++n)
+            {
+                url += "a=";
+                url += std::to_string(n);
+                url += "&b";
+                url += std::to_string(n % 10);
+                url += "=x&";
+            }
+
+            cxxtools::QueryParams q;
+            q.parse_url_lazy(url);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q.paramcount("a"), 100u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q.paramcount("b3"), 10u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q.param("a", 0), "0");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q.param("a", 57), "57");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q.param("a", 100, "none"), "none");
+
+            unsigned count = 0;
+            for (cxxtools::QueryParams::const_iterator it = q.begin("a"); it != q.end(); ++it)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(*it, std::to_string(count++));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(count, 100u);
+        }
+
+        void testLazyModify()
+        {
+            cxxtools::QueryParams q;
+            q.parse_url_lazy("a=1&b=2&a=3");
+
+            q.add("c", "4");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q.getUrl(), "a=1&b=2&a=3&c=4");
+
+            q.set("a", "5");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q.getUrl(), "b=2&c=4&a=5");
+
+            // parameters parsed into non empty parameters are appended
+            q.parse_url_lazy("d=6");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q.getUrl(), "b=2&c=4&a=5&d=6");
+
+            cxxtools::QueryParams q2;
+            q2.parse_url_lazy("x=%41");
+            cxxtools::QueryParams q3(q2);
+            q.add(q3);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q.param("x"), "A");
+
+            q2.clear();
+            CXXTOOLS_UNIT_ASSERT(q2.empty());
+            CXXTOOLS_UNIT_ASSERT(!q2.has("x"));
+        }
+
         void testDeserialization();
 #if __cplusplus >= 201703L
         void testOptional();
+
+        void testParamView()
+        {
+            std::string url = "a=plain&b=with+space&a=second&c=";
+
+            cxxtools::QueryParams q;
+            q.parse_url_lazy(url);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q.param_view("a"), "plain");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q.param_view("a", 1), "second");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(q.param_view("b"), "with space");
+            CXXTOOLS_UNIT_ASSERT(q.param_view("c").empty());
+            CXXTOOLS_UNIT_ASSERT(q.param_view("d").empty());
+            CXXTOOLS_UNIT_ASSERT(q.has("c"));
+
+            // eagerly parsed parameters are viewed too
+            cxxtools::QueryParams e;
+            e.parse_url(url);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(e.param_view("a", 1), "second");
+        }
 #endif
 };
 
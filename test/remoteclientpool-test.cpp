@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include "cxxtools/remoteclientpool.h"
+#include "cxxtools/bin/rpcclient.h"
+#include "cxxtools/bin/rpcserver.h"
+#include "cxxtools/remoteprocedure.h"
+#include "cxxtools/eventloop.h"
+#include "cxxtools/ioerror.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Counts connects and closes instead of talking to a server.
+    struct FakeClient
+    {
+        static std::atomic<unsigned> instances;
+        static std::atomic<unsigned> connects;
+        static bool failConnect;
+
+        std::string endpoint;
+
+        explicit FakeClient(const std::string& endpoint_)
+            : endpoint(endpoint_)
+            { ++instances; }
+
+        ~FakeClient()
+            { --instances; }
+
+        void connect()
+        {
+            ++connects;
+            if (failConnect)
+                throw cxxtools::IOError("connection refused");
+        }
+    };
+
+    std::atomic<unsigned> FakeClient::instances(0);
+    std::atomic<unsigned> FakeClient::connects(0);
+    bool FakeClient::failConnect = false;
+
+    struct FakeCreator
+    {
+        FakeClient* operator() (const std::string& endpoint)
+        { return new FakeClient(endpoint); }
+    };
+
+    typedef cxxtools::RemoteClientPool<FakeClient, FakeCreator> FakePool;
+
+    int add(int a, int b)
+    {
+        return a + b;
+    }
+}
+
+class RemoteClientPoolTest : public cxxtools::unit::TestSuite
+{
+    public:
+        RemoteClientPoolTest()
+            : cxxtools::unit::TestSuite("remoteclientpool")
+        {
+            registerMethod("Reuse", *this, &RemoteClientPoolTest::Reuse);
+            registerMethod("Endpoints", *this, &RemoteClientPoolTest::Endpoints);
+            registerMethod("Invalidate", *this, &RemoteClientPoolTest::Invalidate);
+            registerMethod("MaxConnections", *this, &RemoteClientPoolTest::MaxConnections);
+            registerMethod("IdleTimeout", *this, &RemoteClientPoolTest::IdleTimeout);
+            registerMethod("HealthCheck", *this, &RemoteClientPoolTest::HealthCheck);
+            registerMethod("Backoff", *this, &RemoteClientPoolTest::Backoff);
+            registerMethod("Concurrent", *this, &RemoteClientPoolTest::Concurrent);
+            registerMethod("BinRpc", *this, &RemoteClientPoolTest::BinRpc);
+        }
+
+        void setUp()
+        {
+            FakeClient::instances = 0;
+            FakeClient::connects = 0;
+            FakeClient::failConnect = false;
+        }
+
+        void Reuse()
+        {
+            FakePool pool;
+
+            {
+                FakePool::Ptr c = pool.get("a");
+                CXXTOOLS_UNIT_ASSERT_EQUALS(c->endpoint, "a");
+                CXXTOOLS_UNIT_ASSERT_EQUALS(pool.activeConnections(), 1u);
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.activeConnections(), 0u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.idleConnections(), 1u);
+
+            for (unsigned n = 0; n < 10; ++n)
+                pool.get("a");
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::connects.load(), 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.requests(), 11u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.hits(), 10u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.connectionsOpened(), 1u);
+            CXXTOOLS_UNIT_ASSERT(pool.hitRate() > 0.9);
+        }
+
+        void Endpoints()
+        {
+            FakePool pool;
+
+            FakePool::Ptr a = pool.get("a");
+            FakePool::Ptr b = pool.get("b");
+            FakePool::Ptr a2 = pool.get("a");
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(a->endpoint, "a");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(b->endpoint, "b");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(a2->endpoint, "a");
+            CXXTOOLS_UNIT_ASSERT(a.get() != a2.get());
+
+            a.release();
+            b.release();
+            FakePool::Ptr b2 = pool.get("b");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(b2->endpoint, "b");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.connectionsOpened(), 3u);
+        }
+
+        void Invalidate()
+        {
+            FakePool pool;
+
+            {
+                FakePool::Ptr c = pool.get("a");
+                c.invalidate();
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::instances.load(), 0u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.idleConnections(), 0u);
+
+            pool.get("a");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::connects.load(), 2u);
+        }
+
+        void MaxConnections()
+        {
+            FakePool pool;
+            pool.maxConnectionsPerEndpoint(2);
+
+            FakePool::Ptr c1 = pool.get("a");
+            FakePool::Ptr c2 = pool.get("a");
+
+            CXXTOOLS_UNIT_ASSERT_THROW(pool.get("a", 50), cxxtools::IOTimeout);
+
+            // another endpoint is not limited by the connections to "a"
+            pool.get("b", 50);
+
+            std::thread t([&c1] () {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                c1.release();
+            });
+
+            FakePool::Ptr c3 = pool.get("a");
+            t.join();
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::connects.load(), 3u);
+            CXXTOOLS_UNIT_ASSERT(pool.waitTime() >= cxxtools::Milliseconds(90));
+        }
+
+        void IdleTimeout()
+        {
+            FakePool pool;
+            pool.idleTimeout(20);
+
+            pool.get("a");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::instances.load(), 1u);
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(40));
+
+            pool.get("b");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::instances.load(), 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.idleConnections(), 1u);
+
+            pool.closeIdle();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::instances.load(), 0u);
+        }
+
+        void HealthCheck()
+        {
+            FakePool pool;
+            bool healthy = true;
+            unsigned checks = 0;
+            pool.healthCheck([&] (FakeClient&) { ++checks; return healthy; });
+            pool.healthCheckInterval(0);
+
+            pool.get("a");
+            pool.get("a");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checks, 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::connects.load(), 1u);
+
+            healthy = false;
+            pool.get("a");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checks, 2u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::connects.load(), 2u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.healthCheckFailures(), 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::instances.load(), 1u);
+
+            // recently used clients are not checked
+            pool.healthCheckInterval(10000);
+            pool.get("a");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(checks, 2u);
+        }
+
+        void Backoff()
+        {
+            FakePool pool;
+            pool.minBackoff(50);
+            pool.maxBackoff(100);
+
+            FakeClient::failConnect = true;
+            CXXTOOLS_UNIT_ASSERT_THROW(pool.get("a"), cxxtools::IOError);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::connects.load(), 1u);
+
+            // the endpoint is not tried again within the backoff
+            CXXTOOLS_UNIT_ASSERT_THROW(pool.get("a"), cxxtools::IOError);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::connects.load(), 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.connectFailures(), 1u);
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(60));
+            CXXTOOLS_UNIT_ASSERT_THROW(pool.get("a"), cxxtools::IOError);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::connects.load(), 2u);
+
+            // the second backoff is doubled
+            std::this_thread::sleep_for(std::chrono::milliseconds(60));
+            CXXTOOLS_UNIT_ASSERT_THROW(pool.get("a"), cxxtools::IOError);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::connects.load(), 2u);
+
+            FakeClient::failConnect = false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(60));
+            pool.get("a");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::connects.load(), 3u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(FakeClient::instances.load(), 1u);
+        }
+
+        void Concurrent()
+        {
+            FakePool pool;
+            pool.maxConnectionsPerEndpoint(3);
+
+            std::atomic<unsigned> lent(0);
+            std::atomic<unsigned> maxLent(0);
+            std::vector<std::thread> threads;
+
+            for (unsigned t = 0; t < 8; ++t)
+                threads.emplace_back([&] () {
+                    for (unsigned n = 0; n < 200; ++n)
+                    {
+                        FakePool::Ptr c = pool.get("a");
+                        unsigned l = ++lent;
+                        unsigned m = maxLent;
+                        while (l > m && !maxLent.compare_exchange_weak(m, l))
+                            ;
+                        std::this_thread::yield();
+                        --lent;
+                    }
+                });
+
+            for (auto& t : threads)
+                t.join();
+
+            CXXTOOLS_UNIT_ASSERT(maxLent.load() <= 3u);
+            CXXTOOLS_UNIT_ASSERT(FakeClient::connects.load() <= 3u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.requests(), 1600u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pool.activeConnections(), 0u);
+        }
+
+        void BinRpc()
+        {
+            cxxtools::EventLoop loop;
+            cxxtools::bin::RpcServer server(loop, "127.0.0.1", 7010);
+            server.registerFunction("add", add);
+
+            std::thread loopThread([&loop] () { loop.run(); });
+
+            try
+            {
+                cxxtools::RemoteClientPool<cxxtools::bin::RpcClient> pool;
+                pool.maxConnectionsPerEndpoint(2);
+
+                std::vector<std::thread> threads;
+                std::atomic<unsigned> errors(0);
+                for (unsigned t = 0; t < 4; ++t)
+                    threads.emplace_back([&pool, &errors, t] () {
+                        for (int n = 0; n < 20; ++n)
+                        {
+                            try
+                            {
+                                auto client = pool.get("bin://127.0.0.1:7010/");
+                                cxxtools::RemoteProcedure<int, int, int> addProc(*client, "add");
+                                if (addProc(n, t) != n + static_cast<int>(t))
+                                    ++errors;
+                            }
+                            catch (const std::exception&)
+                            {
+                                ++errors;
+                            }
+                        }
+                    });
+
+                for (auto& t : threads)
+                    t.join();
+
+                CXXTOOLS_UNIT_ASSERT_EQUALS(errors.load(), 0u);
+                CXXTOOLS_UNIT_ASSERT(pool.connectionsOpened() <= 2u);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(pool.hits() + pool.connectionsOpened(), 80u);
+            }
+            catch (...)
+            {
+                loop.exit();
+                loopThread.join();
+                throw;
+            }
+
+            loop.exit();
+            loopThread.join();
+        }
+};
+
+cxxtools::unit::RegisterTest<RemoteClientPoolTest> register_RemoteClientPoolTest;
@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "http/requestscanner.h"
+#include "http/parser.h"
+#include "cxxtools/http/requestheader.h"
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include <sstream>
+
+namespace
+{
+    class ParseEvent : public cxxtools::http::HeaderParser::MessageHeaderEvent
+    {
+            cxxtools::http::RequestHeader& _header;
+
+        public:
+            explicit ParseEvent(cxxtools::http::RequestHeader& header)
+                : cxxtools::http::HeaderParser::MessageHeaderEvent(header),
+                  _header(header)
+                { }
+
+            void onMethod(const std::string& method)  { _header.method(method); }
+            void onUrl(const std::string& url)        { _header.url(url); }
+            void onUrlParam(const std::string& q)     { _header.qparams(q); }
+    };
+
+    std::string dump(const cxxtools::http::RequestHeader& header)
+    {
+        std::ostringstream s;
+        s << header.method() << ' ' << header.url() << '?' << header.qparams()
+          << ' ' << header.httpVersionMajor() << '.' << header.httpVersionMinor() << '\n';
+        for (cxxtools::http::RequestHeader::const_iterator it = header.begin(); it != header.end(); ++it)
+            s << it->first << ": " << it->second << '\n';
+        return s.str();
+    }
+
+    // the request parsed with the HeaderParser, which the scanner must match
+    std::string parse(const std::string& data)
+    {
+        cxxtools::http::RequestHeader header;
+        ParseEvent ev(header);
+        cxxtools::http::HeaderParser parser(ev, false);
+        for (std::string::const_iterator it = data.begin(); it != data.end(); ++it)
+            if (parser.parse(*it))
+                break;
+
+        if (parser.fail())
+            throw std::runtime_error("HeaderParser failed");
+
+        return dump(header);
+    }
+
+    std::string scanned(const cxxtools::http::RequestScanner& scanner, const std::string& data)
+    {
+        cxxtools::http::RequestHeader header;
+        scanner.apply(data.data(), header);
+        return dump(header);
+    }
+
+    const char request[] =
+        "GET /api/orders?customer=4711 HTTP/1.1\r\n"
+        "Host: api.example.com:8080\r\n"
+        "User-Agent: curl/8.5.0\r\n"
+        "Accept: */*\r\n"
+        "\r\n";
+}
+
+class RequestScannerTest : public cxxtools::unit::TestSuite
+{
+    public:
+        RequestScannerTest()
+        : cxxtools::unit::TestSuite("requestscanner")
+        {
+            registerMethod("complete", *this, &RequestScannerTest::complete);
+            registerMethod("incomplete", *this, &RequestScannerTest::incomplete);
+            registerMethod("splitAtEveryByte", *this, &RequestScannerTest::splitAtEveryByte);
+            registerMethod("fallback", *this, &RequestScannerTest::fallback);
+            registerMethod("foldedHeader", *this, &RequestScannerTest::foldedHeader);
+            registerMethod("emptyValue", *this, &RequestScannerTest::emptyValue);
+            registerMethod("methodToken", *this, &RequestScannerTest::methodToken);
+            registerMethod("urlEncoded", *this, &RequestScannerTest::urlEncoded);
+        }
+
+        void complete()
+        {
+            std::string data = std::string(request) + "body";
+            cxxtools::http::RequestScanner scanner;
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), data.size()), cxxtools::http::RequestScanner::Complete);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.headerSize(), data.size() - 4);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.fields().size(), 3u);
+            CXXTOOLS_UNIT_ASSERT(!scanner.urlEncoded());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanned(scanner, data), parse(data));
+        }
+
+        void incomplete()
+        {
+            std::string data(request);
+            cxxtools::http::RequestScanner scanner;
+
+            for (std::size_t n = 0; n < data.size(); ++n)
+            {
+                scanner.reset();
+                CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), n), cxxtools::http::RequestScanner::Incomplete);
+            }
+
+            // a new request after a discarded one
+            scanner.reset();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), data.size()), cxxtools::http::RequestScanner::Complete);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanned(scanner, data), parse(data));
+        }
+
+        void splitAtEveryByte()
+        {
+            std::string data(request);
+            cxxtools::http::RequestScanner scanner;
+
+            // the data arrives in two parts, split at any offset
+            for (std::size_t n = 0; n < data.size(); ++n)
+            {
+                CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), n), cxxtools::http::RequestScanner::Incomplete);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), data.size()), cxxtools::http::RequestScanner::Complete);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(scanned(scanner, data), parse(data));
+            }
+
+            // the data arrives byte by byte
+            for (std::size_t n = 0; n < data.size(); ++n)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), n), cxxtools::http::RequestScanner::Incomplete);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), data.size()), cxxtools::http::RequestScanner::Complete);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.fields().size(), 3u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanned(scanner, data), parse(data));
+        }
+
+        void fallback()
+        {
+            static const char* requests[] = {
+                "\r\n",
+                "GET http://example.com/ HTTP/1.1\r\n\r\n",
+                "GET / HTTP/2.0\r\n\r\n",
+                "GET / FTP/1.1\r\n\r\n",
+                "GET /\r\n\r\n",
+                "GET / HTTP/1.1\r\nNoColon\r\n\r\n",
+                "GET / HTTP/1.1\r\n: value\r\n\r\n",
+                "GET / HTTP/1.1\r\nX-A: a\rb\r\n\r\n"
+            };
+
+            cxxtools::http::RequestScanner scanner;
+            for (unsigned n = 0; n < sizeof(requests) / sizeof(requests[0]); ++n)
+            {
+                std::string data(requests[n]);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), data.size()), cxxtools::http::RequestScanner::Error);
+            }
+
+            // the scanner starts over after an error
+            std::string data(request);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), data.size()), cxxtools::http::RequestScanner::Complete);
+        }
+
+        void foldedHeader()
+        {
+            std::string data =
+                "GET / HTTP/1.1\r\n"
+                "X-Folded: a\r\n"
+                " b\r\n"
+                "\r\n";
+
+            // folded lines are left to the HeaderParser
+            cxxtools::http::RequestScanner scanner;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), data.size()), cxxtools::http::RequestScanner::Error);
+        }
+
+        void emptyValue()
+        {
+            std::string data =
+                "GET / HTTP/1.1\r\n"
+                "X-Empty:\r\n"
+                "X-Blank: \t\r\n"
+                "Host: localhost\r\n"
+                "\r\n";
+
+            cxxtools::http::RequestScanner scanner;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), data.size()), cxxtools::http::RequestScanner::Complete);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.fields().size(), 3u);
+            CXXTOOLS_UNIT_ASSERT(scanner.fields()[0].value.empty());
+            CXXTOOLS_UNIT_ASSERT(scanner.fields()[1].value.empty());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanned(scanner, data), parse(data));
+        }
+
+        void methodToken()
+        {
+            cxxtools::http::RequestScanner scanner;
+
+            std::string data = "M-SEARCH /upnp HTTP/1.1\r\n\r\n";
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), data.size()), cxxtools::http::RequestScanner::Complete);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(std::string(scanner.method().begin(data.data()), scanner.method().size), "M-SEARCH");
+
+            data = "X_1.2~ / HTTP/1.0\r\n\r\n";
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), data.size()), cxxtools::http::RequestScanner::Complete);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.versionMinor(), 0u);
+
+            static const char* bad[] = { "GE(T", "GET:", "G/T", "GE\"T", "{GET}", "G@T" };
+            for (unsigned n = 0; n < sizeof(bad) / sizeof(bad[0]); ++n)
+            {
+                data = std::string(bad[n]) + " / HTTP/1.1\r\n\r\n";
+                CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), data.size()), cxxtools::http::RequestScanner::Error);
+            }
+        }
+
+        void urlEncoded()
+        {
+            cxxtools::http::RequestScanner scanner;
+
+            std::string data = "GET /a%20b+c%2Fd?x=%20+ HTTP/1.1\r\n\r\n";
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), data.size()), cxxtools::http::RequestScanner::Complete);
+            CXXTOOLS_UNIT_ASSERT(scanner.urlEncoded());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(scanned(scanner, data), parse(data));
+
+            // a decoded zero byte and incomplete escapes are left to the HeaderParser
+            static const char* bad[] = { "/a%00b", "/a%0", "/a%", "/a%zz" };
+            for (unsigned n = 0; n < sizeof(bad) / sizeof(bad[0]); ++n)
+            {
+                data = "GET " + std::string(bad[n]) + " HTTP/1.1\r\n\r\n";
+                CXXTOOLS_UNIT_ASSERT_EQUALS(scanner.scan(data.data(), data.size()), cxxtools::http::RequestScanner::Error);
+            }
+        }
+};
+
+cxxtools::unit::RegisterTest<RequestScannerTest> register_RequestScannerTest;
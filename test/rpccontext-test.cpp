@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "cxxtools/rpccontext.h"
+#include "cxxtools/remoteexception.h"
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include <thread>
+
+class RpcContextTest : public cxxtools::unit::TestSuite
+{
+    public:
+        RpcContextTest()
+        : cxxtools::unit::TestSuite("rpccontext")
+        {
+            registerMethod("noDeadline", *this, &RpcContextTest::noDeadline);
+            registerMethod("deadline", *this, &RpcContextTest::deadline);
+            registerMethod("cancel", *this, &RpcContextTest::cancel);
+            registerMethod("scope", *this, &RpcContextTest::scope);
+        }
+
+        void noDeadline()
+        {
+            cxxtools::RpcContext context;
+            CXXTOOLS_UNIT_ASSERT(!context.hasDeadline());
+            CXXTOOLS_UNIT_ASSERT(!context.expired());
+            CXXTOOLS_UNIT_ASSERT(!context.cancelled());
+            CXXTOOLS_UNIT_ASSERT(context.remaining() < cxxtools::Milliseconds(0));
+
+            cxxtools::RpcContext negative(cxxtools::Milliseconds(-1));
+            CXXTOOLS_UNIT_ASSERT(!negative.hasDeadline());
+        }
+
+        void deadline()
+        {
+            cxxtools::RpcContext context(cxxtools::Milliseconds(50));
+            CXXTOOLS_UNIT_ASSERT(context.hasDeadline());
+            CXXTOOLS_UNIT_ASSERT(!context.expired());
+            CXXTOOLS_UNIT_ASSERT(context.remaining() > cxxtools::Milliseconds(0));
+            CXXTOOLS_UNIT_ASSERT(context.remaining() <= cxxtools::Milliseconds(50));
+            context.check();
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(60));
+
+            CXXTOOLS_UNIT_ASSERT(context.expired());
+            CXXTOOLS_UNIT_ASSERT(context.cancelled());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(context.remaining(), cxxtools::Milliseconds(0));
+            CXXTOOLS_UNIT_ASSERT_THROW(context.check(), cxxtools::RemoteException);
+        }
+
+        void cancel()
+        {
+            cxxtools::RpcContext context;
+            context.cancel();
+            CXXTOOLS_UNIT_ASSERT(context.cancelled());
+            CXXTOOLS_UNIT_ASSERT(!context.expired());
+
+            try
+            {
+                context.check();
+                CXXTOOLS_UNIT_ASSERT_MSG(false, "cxxtools::RemoteException exception expected");
+            }
+            catch (const cxxtools::RemoteException& e)
+            {
+                CXXTOOLS_UNIT_ASSERT_EQUALS(e.rc(), cxxtools::RpcContext::Cancelled);
+            }
+        }
+
+        void scope()
+        {
+            CXXTOOLS_UNIT_ASSERT(cxxtools::RpcContext::current() == 0);
+
+            cxxtools::RpcContext outer;
+            {
+                cxxtools::RpcContext::Scope outerScope(outer);
+                CXXTOOLS_UNIT_ASSERT(cxxtools::RpcContext::current() == &outer);
+
+                cxxtools::RpcContext inner;
+                {
+                    cxxtools::RpcContext::Scope innerScope(inner);
+                    CXXTOOLS_UNIT_ASSERT(cxxtools::RpcContext::current() == &inner);
+
+                    // other threads do not see the context
+                    cxxtools::RpcContext* other = &inner;
+                    std::thread([&other] () { other = cxxtools::RpcContext::current(); }).join();
+                    CXXTOOLS_UNIT_ASSERT(other == 0);
+                }
+
+                CXXTOOLS_UNIT_ASSERT(cxxtools::RpcContext::current() == &outer);
+            }
+
+            CXXTOOLS_UNIT_ASSERT(cxxtools::RpcContext::current() == 0);
+        }
+};
+
+cxxtools::unit::RegisterTest<RpcContextTest> register_RpcContextTest;
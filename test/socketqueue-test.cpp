@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include "cxxtools/eventloop.h"
+#include "http/socketqueue.h"
+#include "http/serverimplbase.h"
+#include <thread>
+
+namespace
+{
+    class TestServer : public cxxtools::http::ServerImplBase
+    {
+        public:
+            TestServer(cxxtools::EventLoopBase& loop, cxxtools::Signal<cxxtools::http::Server::Runmode>& runmodeChanged)
+                : cxxtools::http::ServerImplBase(loop, runmodeChanged)
+                { }
+
+            void listen(const std::string&, unsigned short int, const cxxtools::SslCtx&) override
+                { }
+    };
+
+    // the queue does not touch the sockets
+    cxxtools::http::Socket* socket(uintptr_t n)
+        { return reinterpret_cast<cxxtools::http::Socket*>(n); }
+
+    void sleepMs(unsigned ms)
+        { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+}
+
+class SocketQueueTest : public cxxtools::unit::TestSuite
+{
+        cxxtools::EventLoop _loop;
+        cxxtools::Signal<cxxtools::http::Server::Runmode> _runmodeChanged;
+
+    public:
+        SocketQueueTest()
+        : cxxtools::unit::TestSuite("socketqueue")
+        {
+            registerMethod("ControlFirst", *this, &SocketQueueTest::ControlFirst);
+            registerMethod("Limit", *this, &SocketQueueTest::Limit);
+            registerMethod("Batch", *this, &SocketQueueTest::Batch);
+            registerMethod("Timeout", *this, &SocketQueueTest::Timeout);
+            registerMethod("Lifo", *this, &SocketQueueTest::Lifo);
+            registerMethod("Target", *this, &SocketQueueTest::Target);
+            registerMethod("Jobs", *this, &SocketQueueTest::Jobs);
+        }
+
+        void ControlFirst()
+        {
+            TestServer server(_loop, _runmodeChanged);
+            cxxtools::http::SocketQueue queue(server);
+            cxxtools::http::SocketQueue::Sockets expired;
+            cxxtools::http::SocketQueue::Job job;
+
+            CXXTOOLS_UNIT_ASSERT(queue.admit(socket(1), expired));
+            queue.put(socket(2));
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.get(expired, job), socket(2));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.get(expired, job), socket(1));
+            CXXTOOLS_UNIT_ASSERT(queue.empty());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(server.queueTimes().count(), 1u);
+        }
+
+        void Limit()
+        {
+            TestServer server(_loop, _runmodeChanged);
+            server.maxQueueSize(2);
+            cxxtools::http::SocketQueue queue(server);
+            cxxtools::http::SocketQueue::Sockets expired;
+            cxxtools::http::SocketQueue::Job job;
+
+            CXXTOOLS_UNIT_ASSERT(queue.admit(socket(1), expired));
+            CXXTOOLS_UNIT_ASSERT(queue.admit(socket(2), expired));
+            CXXTOOLS_UNIT_ASSERT(!queue.admit(socket(3), expired));
+
+            // listening sockets are not limited
+            queue.put(socket(4));
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.get(expired, job), socket(4));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.get(expired, job), socket(1));
+            CXXTOOLS_UNIT_ASSERT(queue.admit(socket(3), expired));
+            CXXTOOLS_UNIT_ASSERT(expired.empty());
+        }
+
+        void Batch()
+        {
+            TestServer server(_loop, _runmodeChanged);
+            server.maxQueueSize(2);
+            cxxtools::http::SocketQueue queue(server);
+            cxxtools::http::SocketQueue::Sockets sockets;
+            cxxtools::http::SocketQueue::Sockets expired;
+            cxxtools::http::SocketQueue::Job job;
+
+            sockets.push_back(socket(1));
+            sockets.push_back(socket(2));
+            sockets.push_back(socket(3));
+            queue.admit(sockets, expired);
+
+            CXXTOOLS_UNIT_ASSERT(sockets.empty());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(expired.size(), 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(expired[0], socket(3));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.requests(), 2u);
+            expired.clear();
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.get(expired, job), socket(1));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.get(expired, job), socket(2));
+            CXXTOOLS_UNIT_ASSERT(queue.empty());
+        }
+
+        void Timeout()
+        {
+            TestServer server(_loop, _runmodeChanged);
+            server.queueTimeout(cxxtools::Milliseconds(20));
+            cxxtools::http::SocketQueue queue(server);
+            cxxtools::http::SocketQueue::Sockets expired;
+            cxxtools::http::SocketQueue::Job job;
+
+            queue.admit(socket(1), expired);
+            sleepMs(40);
+            queue.admit(socket(2), expired);
+
+            // expired requests are returned when the next request is admitted
+            CXXTOOLS_UNIT_ASSERT_EQUALS(expired.size(), 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(expired[0], socket(1));
+            expired.clear();
+
+            sleepMs(40);
+            CXXTOOLS_UNIT_ASSERT(queue.get(expired, job) == 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(expired.size(), 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(expired[0], socket(2));
+        }
+
+        void Lifo()
+        {
+            TestServer server(_loop, _runmodeChanged);
+            server.queueTarget(cxxtools::Milliseconds(500));
+            cxxtools::http::SocketQueue queue(server);
+            cxxtools::http::SocketQueue::Sockets expired;
+            cxxtools::http::SocketQueue::Job job;
+
+            queue.admit(socket(1), expired);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.get(expired, job), socket(1));
+
+            // the queue did not run empty for more than 100 ms
+            queue.admit(socket(2), expired);
+            queue.admit(socket(3), expired);
+            sleepMs(150);
+            queue.admit(socket(4), expired);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.get(expired, job), socket(4));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.get(expired, job), socket(3));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.get(expired, job), socket(2));
+            CXXTOOLS_UNIT_ASSERT(expired.empty());
+        }
+
+        void Target()
+        {
+            TestServer server(_loop, _runmodeChanged);
+            server.queueTarget(cxxtools::Milliseconds(50));
+            cxxtools::http::SocketQueue queue(server);
+            cxxtools::http::SocketQueue::Sockets expired;
+            cxxtools::http::SocketQueue::Job job;
+
+            queue.admit(socket(1), expired);
+            sleepMs(150);
+            queue.admit(socket(2), expired);
+
+            // in overload requests waiting longer than the target are dropped
+            CXXTOOLS_UNIT_ASSERT_EQUALS(expired.size(), 1u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(expired[0], socket(1));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.get(expired, job), socket(2));
+        }
+
+        void Jobs()
+        {
+            TestServer server(_loop, _runmodeChanged);
+            cxxtools::http::SocketQueue queue(server);
+            cxxtools::http::SocketQueue::Sockets expired;
+            cxxtools::http::SocketQueue::Job job;
+            int n = 0;
+
+            CXXTOOLS_UNIT_ASSERT(queue.admit(socket(1), expired));
+            queue.put([&n] () { ++n; });
+            queue.put(socket(2));
+
+            // jobs are taken after control entries and before requests
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.get(expired, job), socket(2));
+            CXXTOOLS_UNIT_ASSERT(!job);
+            CXXTOOLS_UNIT_ASSERT(queue.get(expired, job) == 0);
+            CXXTOOLS_UNIT_ASSERT(static_cast<bool>(job));
+            job();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(n, 1);
+
+            job = cxxtools::http::SocketQueue::Job();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.get(expired, job), socket(1));
+            CXXTOOLS_UNIT_ASSERT(!job);
+
+            // jobs left are dropped, when the server terminates
+            queue.put([&n] () { ++n; });
+            queue.put(socket(3));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(queue.get(), socket(3));
+            CXXTOOLS_UNIT_ASSERT(queue.empty());
+        }
+};
+
+cxxtools::unit::RegisterTest<SocketQueueTest> register_SocketQueueTest;
@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include "cxxtools/http/server.h"
+#include "cxxtools/http/clientpool.h"
+#include "cxxtools/http/request.h"
+#include "cxxtools/http/reply.h"
+#include "cxxtools/http/uploadresponder.h"
+#include "cxxtools/http/formupload.h"
+#include "cxxtools/http/service.h"
+#include "cxxtools/net/addrinfo.h"
+#include "cxxtools/eventloop.h"
+#include "cxxtools/fileinfo.h"
+#include <stdlib.h>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace
+{
+    std::string fileData()
+    {
+        std::string data;
+        for (unsigned n = 0; n < 300000; ++n)
+            data += static_cast<char>(n * 7 % 251);
+        return data;
+    }
+
+    // Replies with the fields and files of a form upload.
+    class FormService : public cxxtools::http::Service
+    {
+            class FormResponder : public cxxtools::http::UploadResponder
+            {
+                    FormService& _service;
+
+                public:
+                    FormResponder(FormService& service, std::uint64_t maxBodySize)
+                        : cxxtools::http::UploadResponder(service, maxBodySize),
+                          _service(service)
+                        { }
+
+                protected:
+                    cxxtools::http::BodySink* createSink(cxxtools::http::Request& request)
+                        { return new cxxtools::http::FormUpload(request); }
+
+                    void uploaded(std::ostream& out, cxxtools::http::Request&, cxxtools::http::Reply&, cxxtools::http::BodySink& sink)
+                    {
+                        const cxxtools::http::FormUpload& form = static_cast<const cxxtools::http::FormUpload&>(sink);
+                        for (cxxtools::http::FormUpload::Parts::const_iterator it = form.parts().begin(); it != form.parts().end(); ++it)
+                        {
+                            out << it->name << '=';
+                            if (it->isFile())
+                            {
+                                _service.lastPath = it->path;
+                                std::ifstream in(it->path.c_str());
+                                std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                                out << it->filename << ':' << it->size << ':' << (content == fileData() ? "ok" : "differs");
+                            }
+                            else
+                                out << it->value;
+                            out << ';';
+                        }
+                    }
+            };
+
+        public:
+            std::uint64_t maxBodySize;
+            std::string lastPath;
+
+            FormService()
+                : maxBodySize(0)
+                { }
+
+        protected:
+            cxxtools::http::Responder* createResponder(const cxxtools::http::Request&)
+                { return new FormResponder(*this, maxBodySize); }
+
+            void releaseResponder(cxxtools::http::Responder* resp)
+                { delete resp; }
+    };
+}
+
+class UploadTest : public cxxtools::unit::TestSuite
+{
+    private:
+        cxxtools::EventLoop _loop;
+        cxxtools::http::Server* _server;
+        FormService _service;
+        std::string _listen;
+        unsigned short _port;
+
+    public:
+        UploadTest()
+        : cxxtools::unit::TestSuite("upload"),
+          _port(8002)
+        {
+            registerMethod("FormUpload", *this, &UploadTest::FormUpload);
+            registerMethod("TooLarge", *this, &UploadTest::TooLarge);
+            registerMethod("BadMultipart", *this, &UploadTest::BadMultipart);
+
+            char* PORT = getenv("UTEST_PORT");
+            if (PORT)
+            {
+                std::istringstream s(PORT);
+                s >> _port;
+            }
+
+            char* LISTEN = getenv("UTEST_LISTEN");
+            if (LISTEN)
+                _listen = LISTEN;
+        }
+
+        void setUp()
+        {
+            _service.maxBodySize = 0;
+            _service.lastPath.clear();
+            _server = new cxxtools::http::Server(_loop, _listen, _port);
+            _server->addService("/upload", _service);
+        }
+
+        void tearDown()
+        {
+            delete _server;
+        }
+
+        cxxtools::net::AddrInfo addr() const
+        {
+            return cxxtools::net::AddrInfo(_listen.empty() ? "127.0.0.1" : _listen, _port);
+        }
+
+        static cxxtools::http::Request formRequest(const std::string& body)
+        {
+            cxxtools::http::Request request("/upload");
+            request.method("POST");
+            request.setHeader("Content-Type", "multipart/form-data; boundary=\"x-boundary\"");
+            request.body() << body;
+            return request;
+        }
+
+        static std::string formBody()
+        {
+            return "--x-boundary\r\n"
+                   "Content-Disposition: form-data; name=\"title\"\r\n"
+                   "\r\n"
+                   "my file\r\n"
+                   "--x-boundary\r\n"
+                   "Content-Disposition: form-data; name=\"data\"; filename=\"data.bin\"\r\n"
+                   "Content-Type: application/octet-stream\r\n"
+                   "\r\n"
+                 + fileData() + "\r\n"
+                   "--x-boundary--\r\n";
+        }
+
+        ////////////////////////////////////////////////////////////
+        // FormUpload
+        //
+        void FormUpload()
+        {
+            cxxtools::http::ClientPool pool(_loop);
+
+            const cxxtools::http::Reply& reply = pool.execute(addr(), formRequest(formBody()), cxxtools::Seconds(5));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reply.httpReturnCode(), 200);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reply.body(), "title=my file;data=data.bin:300000:ok;");
+
+            // the temporary file is removed after the reply
+            CXXTOOLS_UNIT_ASSERT(!_service.lastPath.empty());
+            CXXTOOLS_UNIT_ASSERT(!cxxtools::FileInfo::exists(_service.lastPath));
+        }
+
+        ////////////////////////////////////////////////////////////
+        // TooLarge
+        //
+        void TooLarge()
+        {
+            _service.maxBodySize = 50;
+            cxxtools::http::ClientPool pool(_loop);
+
+            std::string body = "--x-boundary\r\n"
+                               "Content-Disposition: form-data; name=\"title\"\r\n"
+                               "\r\n"
+                               "my file\r\n"
+                               "--x-boundary--\r\n";
+            const cxxtools::http::Reply& reply = pool.execute(addr(), formRequest(body), cxxtools::Seconds(5));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reply.httpReturnCode(), 413);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // BadMultipart
+        //
+        void BadMultipart()
+        {
+            cxxtools::http::ClientPool pool(_loop);
+
+            std::string body = formBody();
+            body.resize(body.size() - 4);
+            const cxxtools::http::Reply& reply = pool.execute(addr(), formRequest(body), cxxtools::Seconds(5));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reply.httpReturnCode(), 400);
+        }
+};
+
+cxxtools::unit::RegisterTest<UploadTest> register_UploadTest;
@@ -0,0 +1,440 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include "cxxtools/http/server.h"
+#include "cxxtools/http/websocketservice.h"
+#include "cxxtools/net/tcpsocket.h"
+#include "cxxtools/eventloop.h"
+#include "cxxtools/log.h"
+#include <poll.h>
+#include <stdlib.h>
+#include <sstream>
+
+log_define("cxxtools.test.websocket")
+
+class WebSocketTest : public cxxtools::unit::TestSuite
+{
+    private:
+        cxxtools::EventLoop _loop;
+        cxxtools::http::Server* _server;
+        cxxtools::http::WebSocketService* _service;
+        std::string _listen;
+        unsigned short _port;
+        std::string _input;
+        unsigned short _closeCode;
+        unsigned _closed;
+
+    public:
+        WebSocketTest()
+        : cxxtools::unit::TestSuite("websocket"),
+          _port(8002)
+        {
+            registerMethod("Handshake", *this, &WebSocketTest::Handshake);
+            registerMethod("NoUpgrade", *this, &WebSocketTest::NoUpgrade);
+            registerMethod("Echo", *this, &WebSocketTest::Echo);
+            registerMethod("Fragmented", *this, &WebSocketTest::Fragmented);
+            registerMethod("ProtocolError", *this, &WebSocketTest::ProtocolError);
+            registerMethod("MessageTooBig", *this, &WebSocketTest::MessageTooBig);
+            registerMethod("ServerClose", *this, &WebSocketTest::ServerClose);
+            registerMethod("ClientClose", *this, &WebSocketTest::ClientClose);
+            registerMethod("Deflate", *this, &WebSocketTest::Deflate);
+
+            char* PORT = getenv("UTEST_PORT");
+            if (PORT)
+            {
+                std::istringstream s(PORT);
+                s >> _port;
+            }
+
+            char* LISTEN = getenv("UTEST_LISTEN");
+            if (LISTEN)
+                _listen = LISTEN;
+        }
+
+        void setUp()
+        {
+            _server = new cxxtools::http::Server(_loop, _listen, _port);
+            _server->minThreads(1);
+            _service = new cxxtools::http::WebSocketService();
+            // the server strips the leading slash of the url
+            _server->addService("ws", *_service);
+            cxxtools::connect(_service->connected, *this, &WebSocketTest::onConnected);
+            _closeCode = 0;
+            _closed = 0;
+
+            // start the server without running the loop
+            _loop.processEvents();
+        }
+
+        void tearDown()
+        {
+            delete _server;
+            delete _service;
+        }
+
+        void onConnected(cxxtools::http::WebSocket& ws)
+        {
+            cxxtools::connect(ws.textReceived, *this, &WebSocketTest::onText);
+            cxxtools::connect(ws.binaryReceived, *this, &WebSocketTest::onBinary);
+            cxxtools::connect(ws.closed, *this, &WebSocketTest::onClosed);
+        }
+
+        void onText(cxxtools::http::WebSocket& ws, const std::string& msg)
+        {
+            if (msg == "close")
+                ws.close(4000, "requested");
+            else
+                ws.sendText("echo: " + msg);
+        }
+
+        void onBinary(cxxtools::http::WebSocket& ws, const std::string& msg)
+        {
+            ws.sendBinary(msg);
+        }
+
+        void onClosed(cxxtools::http::WebSocket&, unsigned short code)
+        {
+            _closeCode = code;
+            ++_closed;
+        }
+
+        // Runs the event loop until the client socket has data.
+        void waitInput(cxxtools::net::TcpSocket& socket)
+        {
+            struct pollfd fds;
+            fds.fd = socket.getFd();
+            fds.events = POLLIN;
+            for (unsigned n = 0; ::poll(&fds, 1, 0) == 0; ++n)
+            {
+                if (n >= 500)
+                    throw cxxtools::unit::Assertion("no data received", CXXTOOLS_SOURCEINFO);
+                _loop.wait(10);
+                _loop.processEvents();
+            }
+        }
+
+        void receive(cxxtools::net::TcpSocket& socket, std::size_t size)
+        {
+            while (_input.size() < size)
+            {
+                waitInput(socket);
+                char buffer[8192];
+                std::size_t n = socket.read(buffer, sizeof(buffer));
+                if (n == 0)
+                    throw cxxtools::unit::Assertion("connection closed", CXXTOOLS_SOURCEINFO);
+                _input.append(buffer, n);
+            }
+        }
+
+        void connect(cxxtools::net::TcpSocket& socket, const std::string& extensions = std::string())
+        {
+            _input.clear();
+            socket.connect(_listen, _port);
+            socket.setTimeout(cxxtools::Seconds(5));
+
+            std::string request =
+                "GET /ws HTTP/1.1\r\n"
+                "Host: localhost\r\n"
+                "Upgrade: websocket\r\n"
+                "Connection: Upgrade\r\n"
+                "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                "Sec-WebSocket-Version: 13\r\n";
+            if (!extensions.empty())
+                request += "Sec-WebSocket-Extensions: " + extensions + "\r\n";
+            request += "\r\n";
+            socket.write(request.data(), request.size());
+        }
+
+        // Reads the reply header of the handshake.
+        std::string readHeader(cxxtools::net::TcpSocket& socket)
+        {
+            std::string::size_type e;
+            while ((e = _input.find("\r\n\r\n")) == std::string::npos)
+                receive(socket, _input.size() + 1);
+
+            std::string header = _input.substr(0, e + 4);
+            _input.erase(0, e + 4);
+            return header;
+        }
+
+        static std::string frame(unsigned char first, const std::string& payload)
+        {
+            // the example mask of RFC 6455
+            const char mask[] = { '\x37', '\xfa', '\x21', '\x3d' };
+            std::string f;
+            f += static_cast<char>(first);
+            if (payload.size() < 126)
+                f += static_cast<char>(0x80 | payload.size());
+            else
+            {
+                f += static_cast<char>(0x80 | 126);
+                f += static_cast<char>(payload.size() >> 8);
+                f += static_cast<char>(payload.size());
+            }
+            f.append(mask, 4);
+            for (std::size_t i = 0; i < payload.size(); ++i)
+                f += static_cast<char>(payload[i] ^ mask[i % 4]);
+            return f;
+        }
+
+        static void send(cxxtools::net::TcpSocket& socket, const std::string& data)
+        {
+            socket.write(data.data(), data.size());
+        }
+
+        // Reads a frame sent by the server and returns the first byte.
+        unsigned readFrame(cxxtools::net::TcpSocket& socket, std::string& payload)
+        {
+            receive(socket, 2);
+            unsigned first = static_cast<unsigned char>(_input[0]);
+            std::size_t size = static_cast<unsigned char>(_input[1]);
+            std::size_t offset = 2;
+            if (size == 126)
+            {
+                receive(socket, 4);
+                size = (static_cast<unsigned char>(_input[2]) << 8) | static_cast<unsigned char>(_input[3]);
+                offset = 4;
+            }
+
+            receive(socket, offset + size);
+            payload = _input.substr(offset, size);
+            _input.erase(0, offset + size);
+            return first;
+        }
+
+        static unsigned closeCode(const std::string& payload)
+        {
+            return (static_cast<unsigned char>(payload[0]) << 8) | static_cast<unsigned char>(payload[1]);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Handshake
+        //
+        void Handshake()
+        {
+            cxxtools::net::TcpSocket socket;
+            connect(socket);
+
+            std::string header = readHeader(socket);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(header.compare(0, 13, "HTTP/1.1 101 "), 0);
+            // accept key of the example in RFC 6455
+            CXXTOOLS_UNIT_ASSERT(header.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") != std::string::npos);
+            CXXTOOLS_UNIT_ASSERT(header.find("Upgrade: websocket\r\n") != std::string::npos);
+            CXXTOOLS_UNIT_ASSERT(header.find("Content-Length") == std::string::npos);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // NoUpgrade
+        //
+        void NoUpgrade()
+        {
+            cxxtools::net::TcpSocket socket(_listen, _port);
+            socket.setTimeout(cxxtools::Seconds(5));
+            _input.clear();
+
+            send(socket, "GET /ws HTTP/1.1\r\n"
+                         "Host: localhost\r\n"
+                         "\r\n");
+
+            std::string header = readHeader(socket);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(header.compare(0, 13, "HTTP/1.1 426 "), 0);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Echo
+        //
+        void Echo()
+        {
+            cxxtools::net::TcpSocket socket;
+            connect(socket);
+            readHeader(socket);
+
+            std::string payload;
+            send(socket, frame(0x81, "hello"));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readFrame(socket, payload), 0x81u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(payload, "echo: hello");
+
+            std::string data(300, '\0');
+            for (unsigned i = 0; i < data.size(); ++i)
+                data[i] = static_cast<char>(i);
+            send(socket, frame(0x82, data));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readFrame(socket, payload), 0x82u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(payload, data);
+
+            // ping is answered with a pong carrying the same data
+            send(socket, frame(0x89, "ping"));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readFrame(socket, payload), 0x8au);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(payload, "ping");
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Fragmented
+        //
+        void Fragmented()
+        {
+            cxxtools::net::TcpSocket socket;
+            connect(socket);
+            readHeader(socket);
+
+            // control frames may be sent between the fragments of a message
+            send(socket, frame(0x01, "frag") + frame(0x89, "p") + frame(0x00, "men") + frame(0x80, "ted"));
+
+            std::string payload;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readFrame(socket, payload), 0x8au);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readFrame(socket, payload), 0x81u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(payload, "echo: fragmented");
+        }
+
+        ////////////////////////////////////////////////////////////
+        // ProtocolError
+        //
+        void ProtocolError()
+        {
+            cxxtools::net::TcpSocket socket;
+            connect(socket);
+            readHeader(socket);
+
+            // continuation frame without a message
+            send(socket, frame(0x80, "x"));
+
+            std::string payload;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readFrame(socket, payload), 0x88u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(closeCode(payload), 1002u);
+
+            while (_closed == 0)
+            {
+                _loop.wait(10);
+                _loop.processEvents();
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_closeCode, 1002u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // MessageTooBig
+        //
+        void MessageTooBig()
+        {
+            _service->maxMessageSize(100);
+
+            cxxtools::net::TcpSocket socket;
+            connect(socket);
+            readHeader(socket);
+
+            send(socket, frame(0x01, std::string(60, 'a')) + frame(0x80, std::string(60, 'b')));
+
+            std::string payload;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readFrame(socket, payload), 0x88u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(closeCode(payload), 1009u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // ServerClose
+        //
+        void ServerClose()
+        {
+            cxxtools::net::TcpSocket socket;
+            connect(socket);
+            readHeader(socket);
+
+            send(socket, frame(0x81, "close"));
+
+            std::string payload;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readFrame(socket, payload), 0x88u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(closeCode(payload), 4000u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(payload.substr(2), "requested");
+
+            // messages after the close frame are discarded
+            send(socket, frame(0x81, "late") + frame(0x88, payload.substr(0, 2)));
+
+            while (_closed == 0)
+            {
+                _loop.wait(10);
+                _loop.processEvents();
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_closeCode, 4000u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // ClientClose
+        //
+        void ClientClose()
+        {
+            cxxtools::net::TcpSocket socket;
+            connect(socket);
+            readHeader(socket);
+
+            send(socket, frame(0x88, std::string("\x03\xe8", 2)));
+
+            std::string payload;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readFrame(socket, payload), 0x88u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(closeCode(payload), 1000u);
+
+            while (_closed == 0)
+            {
+                _loop.wait(10);
+                _loop.processEvents();
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(_closeCode, 1000u);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Deflate
+        //
+        void Deflate()
+        {
+            cxxtools::net::TcpSocket socket;
+            connect(socket, "permessage-deflate; client_max_window_bits");
+
+            std::string header = readHeader(socket);
+            if (header.find("Sec-WebSocket-Extensions: permessage-deflate") == std::string::npos)
+            {
+                log_warn("permessage-deflate not supported");
+                return;
+            }
+
+            // the compressed "Hello" of RFC 7692
+            send(socket, frame(0xc1, std::string("\xf2\x48\xcd\xc9\xc9\x07\x00", 7)));
+
+            std::string payload;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readFrame(socket, payload), 0x81u);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(payload, "echo: Hello");
+
+            // larger messages are sent compressed
+            send(socket, frame(0x81, std::string(1000, 'a')));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(readFrame(socket, payload), 0xc1u);
+            CXXTOOLS_UNIT_ASSERT(payload.size() < 100);
+        }
+};
+
+cxxtools::unit::RegisterTest<WebSocketTest> register_WebSocketTest;
@@ -0,0 +1,995 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/*
+ * httpbench is a http load generator similar to wrk.
+ *
+ * It runs a number of connections on some threads, each thread with its own
+ * event loop. The latencies are collected in a cxxtools::Histogram. With a
+ * fixed request rate the latency is measured from the time, when the request
+ * should have been sent, so that a stalled server does not hide its latency
+ * by delaying the requests (coordinated omission).
+ *
+ * With --depth a http/1.1 connection sends that many requests before it
+ * reads the replies (pipelining). With --http2 the requests run as
+ * concurrent streams instead.
+ */
+
+#include <cxxtools/arg.h>
+#include <cxxtools/clock.h>
+#include <cxxtools/eventloop.h>
+#include <cxxtools/histogram.h>
+#include <cxxtools/http/client.h>
+#include <cxxtools/http/http2client.h>
+#include <cxxtools/http/request.h>
+#include <cxxtools/iostream.h>
+#include <cxxtools/json.h>
+#include <cxxtools/log.h>
+#include <cxxtools/net/addrinfo.h>
+#include <cxxtools/net/tcpsocket.h>
+#include <cxxtools/net/uri.h>
+#include <cxxtools/serializationinfo.h>
+#include <cxxtools/timer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+log_define("cxxtools.httpbench")
+
+namespace
+{
+
+struct Usage { };
+
+// timers need a interval, so the shortest possible is used to run a slot
+// from the event loop
+const cxxtools::Milliseconds immediately = cxxtools::Microseconds(1);
+
+std::string formatTime(cxxtools::Timespan ts)
+{
+    std::ostringstream s;
+    s << std::fixed << std::setprecision(2);
+    double us = ts.totalUSecs();
+    if (us < 1000)
+        s << us << "us";
+    else if (us < 1000000)
+        s << us / 1000 << "ms";
+    else
+        s << us / 1000000 << "s";
+    return s.str();
+}
+
+std::string formatBytes(double bytes)
+{
+    static const char* units[] = { "B", "KB", "MB", "GB", "TB" };
+    unsigned u = 0;
+    while (bytes >= 1024 && u < 4)
+    {
+        bytes /= 1024;
+        ++u;
+    }
+
+    std::ostringstream s;
+    s << std::fixed << std::setprecision(2) << bytes << units[u];
+    return s.str();
+}
+
+// Bounds growing by 2% from 10us to 100s, so that quantiles are precise to
+// about 1% like a hdr histogram with 2 significant digits.
+std::vector<cxxtools::Timespan> latencyBounds()
+{
+    std::vector<cxxtools::Timespan> bounds;
+    for (double us = 10; us < 100e6; us *= 1.02)
+    {
+        cxxtools::Timespan b = cxxtools::Microseconds(static_cast<int64_t>(us));
+        if (bounds.empty() || bounds.back() < b)
+            bounds.push_back(b);
+    }
+    return bounds;
+}
+
+struct Settings
+{
+    std::string host;
+    unsigned short port;
+    std::string url;
+    std::string method;
+    std::string body;
+    std::string contentType;
+
+    unsigned connections;
+    unsigned threads;
+    unsigned depth;
+    double rate;
+    cxxtools::Timespan duration;
+    unsigned long maxRequests;
+    bool http2;
+
+    unsigned slots() const
+    { return connections * depth; }
+};
+
+class Statistics
+{
+        std::atomic<unsigned long> _started;
+        unsigned long _maxRequests;
+
+    public:
+        explicit Statistics(unsigned long maxRequests)
+            : _started(0),
+              _maxRequests(maxRequests),
+              latency(latencyBounds()),
+              errors(0),
+              non2xx(0),
+              bytes(0)
+            { }
+
+        // Returns false, when the maximum number of requests is reached.
+        bool takeRequest()
+        { return _maxRequests == 0 || _started++ < _maxRequests; }
+
+        cxxtools::Histogram latency;
+        std::atomic<unsigned long> errors;
+        std::atomic<unsigned long> non2xx;
+        std::atomic<unsigned long> bytes;
+};
+
+class BenchThread;
+
+class Connection : public cxxtools::Connectable
+{
+    protected:
+        // A slot runs one request at a time. A http/1 connection has one
+        // slot or `depth` pipelined slots, a http/2 connection runs `depth`
+        // slots as concurrent streams.
+        class Slot : public cxxtools::Connectable
+        {
+                Connection& _connection;
+
+            public:
+                Slot(Connection& connection, cxxtools::SelectorBase& selector)
+                    : _connection(connection),
+                      timer(&selector)
+                {
+                    cxxtools::connect(timer.timeout, *this, &Slot::onTimeout);
+                }
+
+                void onTimeout()
+                {
+                    timer.stop();
+                    _connection.start(*this);
+                }
+
+                cxxtools::Timespan due;     // intended start of the next request
+                cxxtools::Timespan started; // start of the running request
+                cxxtools::Timer timer;
+        };
+
+        BenchThread& _thread;
+        const Settings& _settings;
+        Statistics& _statistics;
+        cxxtools::http::Request _request;
+        std::vector<std::unique_ptr<Slot>> _slots;
+
+        void start(Slot& slot);
+        void finished(Slot& slot, unsigned httpReturnCode, std::size_t bytes);
+        void failed(Slot& slot, const std::exception& e);
+        void next(Slot& slot);
+
+        virtual void send(Slot& slot) = 0;
+
+    public:
+        Connection(BenchThread& thread, const Settings& settings, Statistics& statistics);
+        virtual ~Connection() { }
+
+        // Schedules the first request of each slot; `index` counts the
+        // slots of all connections to spread the first requests in rate mode.
+        void begin(cxxtools::Timespan startTime, unsigned& index);
+};
+
+class Http1Connection : public Connection
+{
+        cxxtools::http::Client _client;
+        char _buffer[8192];
+        std::size_t _bytes;
+
+        std::size_t onBodyAvailable(cxxtools::http::Client& client)
+        {
+            std::streambuf* sb = client.in().rdbuf();
+            std::size_t count = 0;
+            std::streamsize n;
+            while ((n = sb->in_avail()) > 0)
+                count += sb->sgetn(_buffer, std::min<std::streamsize>(n, sizeof(_buffer)));
+            _bytes += count;
+            return count;
+        }
+
+        void onReplyFinished(cxxtools::http::Client& client)
+        {
+            Slot& slot = *_slots.front();
+            try
+            {
+                client.endExecute();
+                finished(slot, client.header().httpReturnCode(), _bytes);
+            }
+            catch (const std::exception& e)
+            {
+                client.close();
+                failed(slot, e);
+            }
+        }
+
+        void send(Slot&)
+        {
+            _bytes = 0;
+            _client.beginExecute(_request);
+        }
+
+    public:
+        Http1Connection(BenchThread& thread, cxxtools::SelectorBase& selector,
+                const Settings& settings, Statistics& statistics)
+            : Connection(thread, settings, statistics),
+              _client(selector, settings.host, settings.port),
+              _bytes(0)
+        {
+            _slots.emplace_back(new Slot(*this, selector));
+            cxxtools::connect(_client.bodyAvailable, *this, &Http1Connection::onBodyAvailable);
+            cxxtools::connect(_client.replyFinished, *this, &Http1Connection::onReplyFinished);
+        }
+};
+
+// Parses http/1.1 replies as far as needed to find their end.
+class ReplyParser
+{
+        enum class State
+        {
+            status,
+            header,
+            body,
+            chunkSize,
+            chunk,
+            chunkEnd,
+            trailer
+        };
+
+        State _state;
+        std::string _line;
+        bool _noBody;       // replies to HEAD requests
+        unsigned _code;
+        bool _chunked;
+        bool _close;
+        std::size_t _remaining;
+        std::size_t _bytes;
+        char _buffer[8192];
+
+        // Reads a line without the line end; returns false, when the input
+        // ends before.
+        bool readLine(std::streambuf& sb)
+        {
+            while (sb.in_avail() > 0)
+            {
+                char ch = std::streambuf::traits_type::to_char_type(sb.sbumpc());
+                if (ch == '\n')
+                {
+                    if (!_line.empty() && _line.back() == '\r')
+                        _line.pop_back();
+                    return true;
+                }
+                _line += ch;
+            }
+            return false;
+        }
+
+        void header()
+        {
+            std::string::size_type colon = _line.find(':');
+            if (colon == std::string::npos)
+                throw std::runtime_error("invalid reply header \"" + _line + '"');
+
+            std::string name = _line.substr(0, colon);
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            std::string::size_type begin = _line.find_first_not_of(' ', colon + 1);
+            std::string value = begin == std::string::npos ? std::string() : _line.substr(begin);
+            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+
+            if (name == "content-length")
+                _remaining = std::strtoul(value.c_str(), 0, 10);
+            else if (name == "transfer-encoding")
+                _chunked = value == "chunked";
+            else if (name == "connection")
+                _close = value == "close";
+        }
+
+        // Called after the empty line, which ends the header; returns true,
+        // when the reply has no body.
+        bool endHeader()
+        {
+            if (_noBody || _code < 200 || _code == 204 || _code == 304)
+                return true;
+
+            if (_chunked)
+            {
+                _state = State::chunkSize;
+                return false;
+            }
+
+            _state = State::body;
+            return _remaining == 0;
+        }
+
+        void skip(std::streambuf& sb)
+        {
+            std::streamsize n = std::min<std::streamsize>(sb.in_avail(), std::min(_remaining, sizeof(_buffer)));
+            n = sb.sgetn(_buffer, n);
+            _remaining -= n;
+            _bytes += n;
+        }
+
+    public:
+        explicit ReplyParser(bool noBody)
+            : _state(State::status),
+              _noBody(noBody),
+              _code(0),
+              _chunked(false),
+              _close(false),
+              _remaining(0),
+              _bytes(0)
+            { }
+
+        void reset()
+        {
+            _state = State::status;
+            _line.clear();
+        }
+
+        // Returns true, when a reply is complete.
+        bool advance(std::streambuf& sb)
+        {
+            while (sb.in_avail() > 0)
+            {
+                switch (_state)
+                {
+                    case State::status:
+                        if (!readLine(sb))
+                            return false;
+                        if (_line.compare(0, 5, "HTTP/") != 0 || _line.size() < 12)
+                            throw std::runtime_error("invalid reply \"" + _line + '"');
+                        _code = std::strtoul(_line.c_str() + 9, 0, 10);
+                        _chunked = false;
+                        _close = false;
+                        _remaining = 0;
+                        _bytes = 0;
+                        _line.clear();
+                        _state = State::header;
+                        break;
+
+                    case State::header:
+                        if (!readLine(sb))
+                            return false;
+                        if (_line.empty())
+                        {
+                            if (endHeader())
+                            {
+                                _state = State::status;
+                                return true;
+                            }
+                        }
+                        else
+                            header();
+                        _line.clear();
+                        break;
+
+                    case State::body:
+                        skip(sb);
+                        if (_remaining == 0)
+                        {
+                            _state = State::status;
+                            return true;
+                        }
+                        break;
+
+                    case State::chunkSize:
+                        if (!readLine(sb))
+                            return false;
+                        _remaining = std::strtoul(_line.c_str(), 0, 16);
+                        _line.clear();
+                        _state = _remaining == 0 ? State::trailer : State::chunk;
+                        break;
+
+                    case State::chunk:
+                        skip(sb);
+                        if (_remaining == 0)
+                            _state = State::chunkEnd;
+                        break;
+
+                    case State::chunkEnd:
+                        if (!readLine(sb))
+                            return false;
+                        _line.clear();
+                        _state = State::chunkSize;
+                        break;
+
+                    case State::trailer:
+                        if (!readLine(sb))
+                            return false;
+                        if (_line.empty())
+                        {
+                            _state = State::status;
+                            return true;
+                        }
+                        _line.clear();
+                        break;
+                }
+            }
+
+            return false;
+        }
+
+        unsigned code() const       { return _code; }
+        std::size_t bytes() const   { return _bytes; }
+        bool close() const          { return _close; }
+};
+
+// Sends up to `depth` requests on a keep-alive connection before it reads
+// the replies, which arrive in the order of the requests. http::Client runs
+// one request at a time, so the requests are written and the replies read
+// here.
+class PipelinedConnection : public Connection
+{
+        cxxtools::net::AddrInfo _addrInfo;
+        cxxtools::net::TcpSocket _socket;
+        cxxtools::IOStream _stream;
+        std::string _requestData;
+        std::deque<Slot*> _sent;    // slots, which wait for their reply
+        ReplyParser _parser;
+
+        void connect()
+        {
+            log_debug("connect to " << _settings.host << ':' << _settings.port);
+            _socket.beginConnect(_addrInfo);
+        }
+
+        void onConnect(cxxtools::net::TcpSocket& socket)
+        {
+            try
+            {
+                socket.endConnect();
+                _stream.buffer().beginWrite();
+                _stream.buffer().beginRead();
+            }
+            catch (const std::exception& e)
+            {
+                fail(e);
+            }
+        }
+
+        void onOutput(cxxtools::StreamBuffer& sb)
+        {
+            try
+            {
+                sb.endWrite();
+                if (sb.out_avail() > 0)
+                    sb.beginWrite();
+            }
+            catch (const std::exception& e)
+            {
+                fail(e);
+            }
+        }
+
+        void onInput(cxxtools::StreamBuffer& sb)
+        {
+            try
+            {
+                sb.endRead();
+                if (sb.device()->eof())
+                    throw std::runtime_error("connection closed by server");
+
+                while (sb.in_avail() > 0 && _parser.advance(sb))
+                {
+                    Slot& slot = *_sent.front();
+                    _sent.pop_front();
+                    bool close = _parser.close();
+                    finished(slot, _parser.code(), _parser.bytes());
+
+                    if (close)
+                    {
+                        reconnect();
+                        return;
+                    }
+                }
+
+                if (!sb.reading())
+                    sb.beginRead();
+            }
+            catch (const std::exception& e)
+            {
+                fail(e);
+            }
+        }
+
+        // The server closes the connection after the reply; the requests,
+        // which it did not answer, are sent again on a new connection.
+        void reconnect()
+        {
+            log_debug("server closed connection; send " << _sent.size() << " requests again");
+            discard();
+            for (std::size_t n = 0; n < _sent.size(); ++n)
+                _stream << _requestData;
+            if (!_sent.empty())
+                connect();
+        }
+
+        void discard()
+        {
+            _socket.close();
+            _stream.clear();
+            _stream.buffer().discard();
+            _parser.reset();
+        }
+
+        void fail(const std::exception& e)
+        {
+            discard();
+
+            std::deque<Slot*> sent;
+            sent.swap(_sent);
+            for (auto slot: sent)
+                failed(*slot, e);
+        }
+
+        void send(Slot& slot)
+        {
+            _stream << _requestData;
+            _sent.push_back(&slot);
+
+            if (_socket.isConnected())
+                _stream.buffer().beginWrite();
+            else if (_sent.size() == 1)
+                connect();
+        }
+
+    public:
+        PipelinedConnection(BenchThread& thread, cxxtools::SelectorBase& selector,
+                const Settings& settings, Statistics& statistics)
+            : Connection(thread, settings, statistics),
+              _addrInfo(settings.host, settings.port),
+              _stream(_socket, 8192, true),
+              _parser(settings.method == "HEAD")
+        {
+            _socket.setSelector(&selector);
+
+            std::ostringstream request;
+            request << settings.method << " /" << settings.url << " HTTP/1.1\r\n"
+                       "Host: " << settings.host << ':' << settings.port << "\r\n";
+            if (!settings.body.empty())
+                request << "Content-Type: " << settings.contentType << "\r\n"
+                           "Content-Length: " << settings.body.size() << "\r\n";
+            request << "\r\n" << settings.body;
+            _requestData = request.str();
+
+            for (unsigned n = 0; n < settings.depth; ++n)
+                _slots.emplace_back(new Slot(*this, selector));
+
+            cxxtools::connect(_socket.connected, *this, &PipelinedConnection::onConnect);
+            cxxtools::connect(_stream.buffer().outputReady, *this, &PipelinedConnection::onOutput);
+            cxxtools::connect(_stream.buffer().inputReady, *this, &PipelinedConnection::onInput);
+        }
+};
+
+class Http2Connection : public Connection
+{
+        cxxtools::http::Http2Client _client;
+        std::map<unsigned, Slot*> _running;
+
+        void onReplyFinished(cxxtools::http::Http2Client&, unsigned id)
+        {
+            auto it = _running.find(id);
+            if (it == _running.end())
+                return;
+
+            Slot& slot = *it->second;
+            _running.erase(it);
+
+            try
+            {
+                const cxxtools::http::Reply& reply = _client.endExecute(id);
+                finished(slot, reply.httpReturnCode(), reply.bodySize());
+            }
+            catch (const std::exception& e)
+            {
+                failed(slot, e);
+            }
+        }
+
+        void send(Slot& slot)
+        {
+            unsigned id = _client.beginExecute(_request);
+            _running[id] = &slot;
+
+            // the request may have failed already while it was started
+            if (_client.finished(id))
+                onReplyFinished(_client, id);
+        }
+
+    public:
+        Http2Connection(BenchThread& thread, cxxtools::SelectorBase& selector,
+                const Settings& settings, Statistics& statistics)
+            : Connection(thread, settings, statistics),
+              _client(selector, settings.host, settings.port)
+        {
+            for (unsigned n = 0; n < settings.depth; ++n)
+                _slots.emplace_back(new Slot(*this, selector));
+            cxxtools::connect(_client.replyFinished, *this, &Http2Connection::onReplyFinished);
+        }
+};
+
+class BenchThread
+{
+        cxxtools::EventLoop _loop;
+        cxxtools::Timer _deadline;
+        std::vector<std::unique_ptr<Connection>> _connections;
+        unsigned _active;
+        std::thread _thread;
+
+    public:
+        BenchThread(const Settings& settings, Statistics& statistics, unsigned connections)
+            : _deadline(&_loop),
+              _active(0)
+        {
+            for (unsigned n = 0; n < connections; ++n)
+            {
+                if (settings.http2)
+                    _connections.emplace_back(new Http2Connection(*this, _loop, settings, statistics));
+                else if (settings.depth > 1)
+                    _connections.emplace_back(new PipelinedConnection(*this, _loop, settings, statistics));
+                else
+                    _connections.emplace_back(new Http1Connection(*this, _loop, settings, statistics));
+            }
+
+            if (settings.duration > cxxtools::Timespan(0))
+            {
+                cxxtools::connect(_deadline.timeout, _loop, &cxxtools::EventLoop::exit);
+                _deadline.after(cxxtools::Milliseconds(settings.duration));
+            }
+        }
+
+        void run(cxxtools::Timespan startTime, unsigned& index)
+        {
+            for (auto& connection: _connections)
+                connection->begin(startTime, index);
+            _thread = std::thread(&cxxtools::EventLoop::run, &_loop);
+        }
+
+        void join()
+        { _thread.join(); }
+
+        void slotStarted()
+        { ++_active; }
+
+        // Called when a slot sends no more requests since the maximum number
+        // of requests is reached.
+        void slotStopped()
+        {
+            if (--_active == 0)
+                _loop.exit();
+        }
+};
+
+Connection::Connection(BenchThread& thread, const Settings& settings, Statistics& statistics)
+    : _thread(thread),
+      _settings(settings),
+      _statistics(statistics),
+      _request(settings.url)
+{
+    _request.method(settings.method);
+    if (!settings.body.empty())
+    {
+        _request.body() << settings.body;
+        _request.setHeader("Content-Type", settings.contentType.c_str());
+    }
+}
+
+void Connection::begin(cxxtools::Timespan startTime, unsigned& index)
+{
+    for (auto& slot: _slots)
+    {
+        _thread.slotStarted();
+        if (_settings.rate > 0)
+        {
+            slot->due = startTime + cxxtools::Microseconds(static_cast<int64_t>(1e6 * index / _settings.rate));
+            slot->timer.after(cxxtools::Milliseconds(slot->due - startTime) + immediately);
+        }
+        else
+            slot->timer.after(immediately);
+        ++index;
+    }
+}
+
+void Connection::start(Slot& slot)
+{
+    if (!_statistics.takeRequest())
+    {
+        _thread.slotStopped();
+        return;
+    }
+
+    slot.started = _settings.rate > 0 ? slot.due : cxxtools::Clock::getSystemTicks();
+
+    try
+    {
+        send(slot);
+    }
+    catch (const std::exception& e)
+    {
+        failed(slot, e);
+    }
+}
+
+void Connection::finished(Slot& slot, unsigned httpReturnCode, std::size_t bytes)
+{
+    _statistics.latency.add(cxxtools::Clock::getSystemTicks() - slot.started);
+    _statistics.bytes += bytes;
+    if (httpReturnCode < 200 || httpReturnCode >= 300)
+        ++_statistics.non2xx;
+    next(slot);
+}
+
+void Connection::failed(Slot& slot, const std::exception& e)
+{
+    log_debug("request failed: " << e.what());
+    ++_statistics.errors;
+
+    // without a rate the next request is started from the event loop, so
+    // that a unreachable server does not result in a endless recursion
+    if (_settings.rate <= 0)
+        slot.timer.after(immediately);
+    else
+        next(slot);
+}
+
+void Connection::next(Slot& slot)
+{
+    if (_settings.rate <= 0)
+    {
+        start(slot);
+        return;
+    }
+
+    // each slot sends its share of the requested rate; when the request
+    // took longer than the interval, the next one is sent immediately and
+    // its latency includes the time it waited
+    slot.due += cxxtools::Microseconds(static_cast<int64_t>(1e6 * _settings.slots() / _settings.rate));
+    cxxtools::Timespan now = cxxtools::Clock::getSystemTicks();
+    if (slot.due <= now)
+        start(slot);
+    else
+        slot.timer.after(cxxtools::Milliseconds(slot.due - now));
+}
+
+void printHdr(std::ostream& out, const cxxtools::Histogram& histogram)
+{
+    out << "\n  Detailed Percentile spectrum:\n"
+           "       Value   Percentile   TotalCount 1/(1-Percentile)\n\n";
+
+    uint64_t total = histogram.count();
+    uint64_t count = 0;
+    for (unsigned n = 0; n < histogram.buckets(); ++n)
+    {
+        uint64_t c = histogram.bucketCount(n);
+        if (c == 0)
+            continue;
+
+        count += c;
+        double percentile = static_cast<double>(count) / total;
+        cxxtools::Timespan value = n + 1 < histogram.buckets() ? histogram.bound(n) : histogram.max();
+
+        out << std::fixed
+            << std::setw(12) << std::setprecision(3) << value.totalMSecs()
+            << std::setw(13) << std::setprecision(6) << percentile
+            << std::setw(13) << count;
+        if (count < total)
+            out << std::setw(15) << std::setprecision(2) << 1 / (1 - percentile);
+        out << '\n';
+    }
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        log_init(argc, argv);
+
+        cxxtools::Arg<unsigned> connections(argc, argv, 'c', 10);
+        cxxtools::Arg<unsigned> threads(argc, argv, 't', 2);
+        cxxtools::Arg<double> duration(argc, argv, 'd', 10);
+        cxxtools::Arg<unsigned long> maxRequests(argc, argv, 'n', 0);
+        cxxtools::Arg<double> rate(argc, argv, 'R', 0);
+        cxxtools::Arg<unsigned> depth(argc, argv, "--depth", 1);
+        cxxtools::Arg<bool> http2(argc, argv, '2');
+        http2.set(argc, argv, "--http2");
+        cxxtools::Arg<std::string> method(argc, argv, 'm', "GET");
+        cxxtools::Arg<std::string> body(argc, argv, 'b');
+        cxxtools::Arg<std::string> contentType(argc, argv, "--content-type", "application/octet-stream");
+        cxxtools::Arg<bool> hdr(argc, argv, "--latency");
+        cxxtools::Arg<std::string> jsonFile(argc, argv, 'j');
+
+        if (argc != 2 || connections == 0 || threads == 0 || depth == 0)
+            throw Usage();
+
+        cxxtools::net::Uri uri(argv[1]);
+        if (uri.protocol() != "http")
+        {
+            std::cerr << "only http urls are supported" << std::endl;
+            return 1;
+        }
+
+        Settings settings;
+        settings.host = uri.host();
+        settings.port = uri.port();
+        settings.url = uri.path();
+        if (!settings.url.empty() && settings.url[0] == '/')
+            settings.url.erase(0, 1);
+        if (!uri.query().empty())
+            settings.url += '?' + uri.query();
+        settings.method = method;
+        settings.body = body;
+        settings.contentType = contentType;
+        settings.connections = connections;
+        settings.threads = std::min(threads.getValue(), connections.getValue());
+        settings.depth = depth;
+        settings.rate = rate;
+        settings.duration = maxRequests > 0 ? cxxtools::Timespan(0)
+                                             : cxxtools::Seconds(duration.getValue());
+        settings.maxRequests = maxRequests;
+        settings.http2 = http2;
+
+        std::cout << "Running " << (maxRequests > 0 ? std::to_string(maxRequests) + " requests"
+                                                    : formatTime(settings.duration) + " test")
+                  << " @ " << argv[1] << "\n"
+                     "  " << settings.threads << " threads and " << settings.connections << " connections";
+        if (settings.http2)
+            std::cout << " (http/2, " << settings.depth << " streams each)";
+        else if (settings.depth > 1)
+            std::cout << " (" << settings.depth << " pipelined requests each)";
+        if (settings.rate > 0)
+            std::cout << ", " << settings.rate << " requests/s";
+        std::cout << std::endl;
+
+        Statistics statistics(maxRequests);
+        std::vector<std::unique_ptr<BenchThread>> benchThreads;
+        for (unsigned t = 0; t < settings.threads; ++t)
+        {
+            unsigned n = settings.connections / settings.threads
+                       + (t < settings.connections % settings.threads ? 1 : 0);
+            benchThreads.emplace_back(new BenchThread(settings, statistics, n));
+        }
+
+        cxxtools::Timespan startTime = cxxtools::Clock::getSystemTicks();
+        unsigned index = 0;
+        for (auto& t: benchThreads)
+            t->run(startTime, index);
+        for (auto& t: benchThreads)
+            t->join();
+        cxxtools::Timespan elapsed = cxxtools::Clock::getSystemTicks() - startTime;
+
+        const cxxtools::Histogram& latency = statistics.latency;
+        uint64_t requests = latency.count();
+        double seconds = elapsed.totalSeconds();
+
+        std::cout << "  Latency   avg " << formatTime(requests ? latency.sum() / requests : cxxtools::Timespan(0))
+                  << "  max " << formatTime(latency.max()) << "\n"
+                     "  Latency Distribution\n";
+        static const double quantiles[] = { 0.5, 0.75, 0.9, 0.99, 0.999, 0.9999 };
+        for (double q: quantiles)
+        {
+            std::ostringstream p;
+            p << q * 100 << '%';
+            std::cout << std::setw(9) << p.str() << "  " << formatTime(latency.quantile(q)) << '\n';
+        }
+
+        if (hdr)
+            printHdr(std::cout, latency);
+
+        std::cout << "  " << requests << " requests in " << formatTime(elapsed)
+                  << ", " << formatBytes(statistics.bytes) << " read\n";
+        if (statistics.errors > 0)
+            std::cout << "  Errors: " << statistics.errors << '\n';
+        if (statistics.non2xx > 0)
+            std::cout << "  Non-2xx responses: " << statistics.non2xx << '\n';
+        std::cout << "Requests/sec: " << std::fixed << std::setprecision(2) << requests / seconds << "\n"
+                     "Transfer/sec: " << formatBytes(statistics.bytes / seconds) << std::endl;
+
+        if (jsonFile.isSet())
+        {
+            cxxtools::SerializationInfo si;
+            si.addMember("url") <<= std::string(argv[1]);
+            si.addMember("threads") <<= settings.threads;
+            si.addMember("connections") <<= settings.connections;
+            si.addMember("depth") <<= settings.depth;
+            si.addMember("http2") <<= settings.http2;
+            si.addMember("rate") <<= settings.rate;
+            si.addMember("duration") <<= seconds;
+            si.addMember("requests") <<= requests;
+            si.addMember("errors") <<= statistics.errors.load();
+            si.addMember("non2xx") <<= statistics.non2xx.load();
+            si.addMember("bytes") <<= statistics.bytes.load();
+            si.addMember("requestsPerSecond") <<= requests / seconds;
+            si.addMember("bytesPerSecond") <<= statistics.bytes / seconds;
+            si.addMember("latency") <<= latency;
+
+            std::ofstream out(jsonFile.getValue());
+            out << cxxtools::Json(si).beautify(true) << std::endl;
+            if (!out)
+            {
+                std::cerr << "failed to write " << jsonFile.getValue() << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const Usage&)
+    {
+        std::cerr << "usage: " << argv[0] << " [options] url\n"
+                     "options:\n"
+                     "    -c number           number of connections (default: 10)\n"
+                     "    -t number           number of threads (default: 2)\n"
+                     "    -d seconds          duration of the test (default: 10)\n"
+                     "    -n number           run the number of requests instead of a fixed duration\n"
+                     "    -R rate             send a fixed number of requests per second; latencies\n"
+                     "                        are measured from the intended send time\n"
+                     "    -2, --http2         use http/2 (h2c with prior knowledge)\n"
+                     "    --depth number      concurrent requests per connection; pipelined with\n"
+                     "                        http/1.1, concurrent streams with http/2 (default: 1)\n"
+                     "    -m method           request method (default: GET)\n"
+                     "    -b body             request body\n"
+                     "    --content-type type content type of the body\n"
+                     "    --latency           print the detailed latency distribution\n"
+                     "    -j file             write the results as json to file\n";
+        return -1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -81,16 +81,20 @@ print <<EOF;
 
         IComposers* beginCall(const std::string&) override
         {
+            // a pooled procedure starts each call with fresh values
+            _rv = RV();
 EOF
 for (my $i = 1; $i <= $N; ++$i)
 {
 print <<EOF;
+            _v$i = V$i();
             _a$i.begin(_v$i);
 EOF
 }
 my $vars = join (', ', map { "_v$_" } (1..$N));
 print <<EOF;
 
+            _composers.begin();
             return &_composers;
         }
 
@@ -186,16 +190,20 @@ print <<EOF;
 
         IComposers* beginCall(const std::string&) override
         {
+            // a pooled procedure starts each call with fresh values
+            _rv = RV();
 EOF
 for (my $i = 1; $i <= $nn; ++$i)
 {
 print <<EOF;
+            _v$i = V$i();
             _a$i.begin(_v$i);
 EOF
 }
 my $vars = join (', ', map { "std::move(_v$_)" } (1..$nn));
 print <<EOF;
 
+            _composers.begin();
             return &_composers;
         }
 
@@ -269,6 +277,7 @@ class BasicServiceProcedure<R,
 
         IComposers* beginCall(const std::string&) override
         {
+            _rv = RV();
             return &_composers;
         }
 